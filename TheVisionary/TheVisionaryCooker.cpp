@@ -0,0 +1,59 @@
+﻿/**
+ * @file TheVisionaryCooker.cpp
+ * @brief Punto de entrada de consola del cocinador de assets de The Visionary Engine.
+ *
+ * Uso: TheVisionaryCooker <sourceDir> <outputDir> [-j N] [--force] [--cache archivo]
+ *
+ * Ejemplo (desde el directorio del ejecutable del motor):
+ *   TheVisionaryCooker ModelsFBX Cooked\ModelsFBX
+ */
+
+#include "AssetCooker.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void
+PrintUsage() {
+    std::printf("Usage: TheVisionaryCooker <sourceDir> <outputDir> [-j N] [--force] [--cache file]\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string sourceDir = argv[1];
+    const std::string outputDir = argv[2];
+    std::string cacheFile;
+    unsigned int numThreads = 0;
+    bool force = false;
+
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            numThreads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--force") == 0) {
+            force = true;
+        }
+        else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheFile = argv[++i];
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    AssetCooker cooker;
+    if (FAILED(cooker.init(sourceDir, outputDir, cacheFile))) {
+        std::printf("Failed to initialize cooker for '%s'\n", sourceDir.c_str());
+        return 1;
+    }
+
+    CookReport report = cooker.cookAll(numThreads, force);
+    AssetCooker::printReport(report);
+    return report.failed == 0 ? 0 : 2;
+}
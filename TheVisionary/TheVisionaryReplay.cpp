@@ -0,0 +1,96 @@
+﻿/**
+ * @file TheVisionaryReplay.cpp
+ * @brief Punto de entrada de consola del reproductor de capturas de comandos de The Visionary Engine.
+ *
+ * Uso: TheVisionaryReplay <captura.vcap> [--repeat N] [--top N]
+ *
+ * Lee una captura del motor (panel "Command Capture"), muestra sus totales
+ * y la reproduce sin GPU sobre el backend nulo con tiempos por llamada.
+ *
+ * Ejemplo (desde el directorio del ejecutable del motor):
+ *   TheVisionaryReplay Captures\Frame.vcap --repeat 100
+ */
+
+#include "CommandReplay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void
+PrintUsage() {
+    std::printf("Usage: TheVisionaryReplay <capture.vcap> [--repeat N] [--top N]\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::string capturePath = argv[1];
+    unsigned int repeats = 10;
+    unsigned int top = 10;
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeats = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    CaptureFileHeader header;
+    std::vector<uint8_t> stream;
+    std::string error;
+    if (!readCaptureFile(capturePath, header, stream, error)) {
+        std::printf("Failed to read '%s': %s\n", capturePath.c_str(), error.c_str());
+        return 1;
+    }
+
+    const CommandStreamStats stats = analyzeCommandStream(stream);
+    if (!stats.valid) {
+        std::printf("'%s' holds a truncated or invalid command stream\n", capturePath.c_str());
+        return 2;
+    }
+    const double perFrame = stats.frames > 0 ? 1.0 / stats.frames : 0.0;
+    std::printf("%s: %u frames, %u resources, %.1f KB stream (%.1f KB of contents)\n", capturePath.c_str(),
+        stats.frames, stats.resources, stream.size() / 1024.0, stats.contentBytes / 1024.0);
+    std::printf("  per frame: %.1f commands, %.1f draws, %.1f binds (%.2f per draw), %.0f indices\n",
+        stats.commands * perFrame, stats.draws * perFrame, stats.binds * perFrame, stats.getBindsPerDraw(),
+        static_cast<double>(stats.indices) * perFrame);
+    std::printf("  per frame: %.1f updates (%.1f KB), %.1f maps (%.1f KB written)\n", stats.uploads * perFrame,
+        stats.uploadBytes * perFrame / 1024.0, stats.maps * perFrame, stats.mapBytes * perFrame / 1024.0);
+
+    const ReplayStats replay = replayHeadless(stream, repeats);
+    std::printf("Replay on the null backend, %u passes: %.4f ms per frame (min %.4f, max %.4f), %.3f of %.3f ms in calls\n",
+        replay.repeats, replay.getFrameMs(), replay.minFrameMs, replay.maxFrameMs, replay.callMs, replay.totalMs);
+
+    // Los comandos que más tiempo se llevan, de mayor a menor.
+    std::vector<int> ops;
+    for (int op = 0; op < COMMAND_OP_COUNT; ++op) {
+        if (replay.calls[op].count > 0) {
+            ops.push_back(op);
+        }
+    }
+    std::sort(ops.begin(), ops.end(), [&replay](int a, int b) { return replay.calls[a].totalMs > replay.calls[b].totalMs; });
+    if (ops.size() > top) {
+        ops.resize(top);
+    }
+    std::printf("  %-24s %10s %10s %10s %10s\n", "command", "calls", "total ms", "avg us", "max us");
+    for (int op : ops) {
+        const ReplayCallStats& call = replay.calls[op];
+        std::printf("  %-24s %10u %10.3f %10.3f %10.3f\n", getCommandName(static_cast<CommandOp>(op)), call.count,
+            call.totalMs, call.totalMs * 1000.0 / call.count, call.maxMs * 1000.0);
+    }
+    if (replay.missing > 0) {
+        std::printf("  %u references without an object\n", replay.missing);
+    }
+    return 0;
+}
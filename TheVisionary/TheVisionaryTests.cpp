@@ -0,0 +1,79 @@
+﻿/**
+ * @file TheVisionaryTests.cpp
+ * @brief Punto de entrada de consola de las pruebas sin dispositivo de The Visionary Engine.
+ *
+ * Uso: TheVisionaryTests [filtro] [--list]
+ *
+ * Ejecuta las pruebas registradas con TEST_CASE (las que contienen filtro
+ * en el nombre) y devuelve 1 si alguna falla, así se puede encadenar como
+ * paso posterior a la compilación o en integración continua.
+ *
+ * Ejemplo:
+ *   TheVisionaryTests MeshOptimizer
+ */
+
+#include "tests/TestFramework.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+TestRegistry&
+TestRegistry::get() {
+    static TestRegistry registry;
+    return registry;
+}
+
+void
+TestRegistry::add(const char* name, const char* file, void (*run)()) {
+    TestCase test;
+    test.name = name;
+    test.file = file;
+    test.run = run;
+    m_tests.push_back(test);
+}
+
+void
+TestRegistry::fail(const char* file, int line, const char* expression) {
+    ++m_failures;
+    std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+}
+
+int
+TestRegistry::runAll(const char* filter) {
+    int failed = 0;
+    unsigned int run = 0;
+    for (const TestCase& test : m_tests) {
+        if (filter && !std::strstr(test.name, filter)) {
+            continue;
+        }
+        m_failures = 0;
+        const auto start = std::chrono::steady_clock::now();
+        test.run();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("[%s] %s (%.1f ms)\n", m_failures == 0 ? " OK " : "FAIL", test.name, ms);
+        failed += m_failures > 0 ? 1 : 0;
+        ++run;
+    }
+    std::printf("%u tests, %d failed\n", run, failed);
+    return failed;
+}
+
+void
+TestRegistry::list() const {
+    for (const TestCase& test : m_tests) {
+        std::printf("%s (%s)\n", test.name, test.file);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--list") == 0) {
+            TestRegistry::get().list();
+            return 0;
+        }
+        filter = argv[i];
+    }
+    return TestRegistry::get().runAll(filter) > 0 ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+﻿/**
+ * @file AssetCooker.h
+ * @brief Cocinado incremental y paralelo de assets (mallas y texturas).
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <unordered_map>
+
+class JobSystem;
+
+/**
+ * @enum CookedAssetType
+ * @brief Tipos de asset que sabe cocinar el AssetCooker.
+ */
+enum CookedAssetType { COOKED_MESH = 0, COOKED_TEXTURE = 1 };
+
+/**
+ * @struct CookCacheEntry
+ * @brief Entrada de la base de datos de caché de cocinado.
+ */
+struct CookCacheEntry {
+    uint64_t sourceHash = 0;   ///< Hash del contenido del archivo fuente.
+    uint64_t settingsHash = 0; ///< Hash de la configuración de importación y del formato.
+    std::string outputPath;    ///< Ruta del archivo cocinado.
+};
+
+/**
+ * @struct CookAssetResult
+ * @brief Resultado del cocinado de un asset.
+ */
+struct CookAssetResult {
+    std::string relativePath; ///< Ruta relativa al directorio fuente.
+    double milliseconds = 0.0; ///< Tiempo empleado (hash + cocinado).
+    bool cacheHit = false;     ///< true si se reutilizó la salida previa.
+    bool success = false;      ///< true si el asset terminó con salida válida.
+};
+
+/**
+ * @struct CookReport
+ * @brief Resumen de una ejecución del cocinador.
+ */
+struct CookReport {
+    std::vector<CookAssetResult> assets; ///< Resultado por asset.
+    unsigned int cacheHits = 0;          ///< Assets reutilizados desde caché.
+    unsigned int cooked = 0;             ///< Assets cocinados en esta ejecución.
+    unsigned int failed = 0;             ///< Assets con error.
+    double totalMilliseconds = 0.0;      ///< Tiempo total de pared.
+
+    /// @return Proporción de aciertos de caché en [0, 1].
+    double hitRate() const {
+        return assets.empty() ? 0.0 : static_cast<double>(cacheHits) / assets.size();
+    }
+};
+
+/**
+ * @class AssetCooker
+ * @brief Convierte assets fuente (FBX/OBJ/PNG/JPG...) en formatos binarios listos para cargar.
+ *
+ * @details
+ * Cada asset se identifica por el hash de su contenido y el de su
+ * configuración de importación (archivo opcional `<asset>.import` junto
+ * al fuente). Si ambos coinciden con la base de datos de caché y la
+ * salida existe, el asset no se vuelve a cocinar. Los assets pendientes
+ * se procesan en paralelo con el JobSystem, usando las rutas de CPU de
+ * ModelLoader y Texture.
+ */
+class AssetCooker {
+public:
+    /** @brief Constructor por defecto. */
+    AssetCooker() = default;
+
+    /** @brief Destructor por defecto. */
+    ~AssetCooker() = default;
+
+    /**
+     * @brief Configura los directorios y la base de datos de caché.
+     * @param sourceDir Directorio raíz de los assets fuente.
+     * @param outputDir Directorio raíz de los assets cocinados.
+     * @param cacheFile Ruta de la base de datos (vacía = outputDir/cook_cache.db).
+     */
+    HRESULT init(const std::string& sourceDir,
+        const std::string& outputDir,
+        const std::string& cacheFile = "");
+
+    /**
+     * @brief Cocina todos los assets soportados del directorio fuente.
+     * @param numThreads Hilos trabajadores (0 = automático).
+     * @param force Ignora la caché y cocina todo.
+     * @return Informe con tiempos por asset y tasa de aciertos.
+     */
+    CookReport cookAll(unsigned int numThreads = 0, bool force = false);
+
+    /**
+     * @brief Imprime el informe en la salida estándar.
+     * @param report Informe a imprimir.
+     */
+    static void printReport(const CookReport& report);
+
+    /**
+     * @brief Obtiene la ruta cocinada que corresponde a un asset fuente.
+     * @param outputDir Directorio de salida.
+     * @param relativePath Ruta relativa del asset fuente.
+     * @param type Tipo de asset.
+     */
+    static std::string getCookedPath(const std::string& outputDir,
+        const std::string& relativePath,
+        CookedAssetType type);
+
+private:
+    /** @brief Carga la base de datos de caché desde disco. */
+    void loadCache();
+
+    /** @brief Guarda la base de datos de caché en disco. */
+    void saveCache() const;
+
+    /**
+     * @brief Cocina un asset concreto (se llama desde los trabajadores).
+     * @param jobs Pool compartido para las etapas paralelas de importación.
+     * @return true si la salida se escribió correctamente.
+     */
+    bool cookAsset(const std::string& sourcePath,
+        const std::string& outputPath,
+        CookedAssetType type,
+        JobSystem* jobs) const;
+
+private:
+    std::string m_sourceDir; ///< Directorio fuente.
+    std::string m_outputDir; ///< Directorio de salida.
+    std::string m_cacheFile; ///< Base de datos de caché.
+    std::unordered_map<std::string, CookCacheEntry> m_cache; ///< Caché por ruta relativa.
+};
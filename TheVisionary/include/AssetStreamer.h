@@ -0,0 +1,204 @@
+﻿/**
+ * @file AssetStreamer.h
+ * @brief Carga asíncrona y priorizada de mallas y texturas con presupuesto de subida por frame.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "MeshComponent.h"
+#include "Texture.h"
+#include "JobSystem.h"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @enum StreamPriority
+ * @brief Prioridad de una petición (menor valor = más urgente).
+ */
+enum StreamPriority {
+    STREAM_VISIBLE = 0,   ///< Necesario para el frame actual.
+    STREAM_NEARBY = 1,    ///< Probablemente visible pronto.
+    STREAM_PREFETCH = 2,  ///< Precarga especulativa.
+    STREAM_PRIORITY_COUNT = 3
+};
+
+/** @brief Tipo de asset que se transmite. */
+enum StreamAssetType { STREAM_MESH = 0, STREAM_TEXTURE = 1 };
+
+/** @brief Estado de una petición a lo largo del pipeline. */
+enum StreamState {
+    STREAM_INVALID = 0,  ///< Handle desconocido.
+    STREAM_QUEUED,       ///< Esperando al hilo de IO.
+    STREAM_LOADING,      ///< Leyendo del disco.
+    STREAM_DECODING,     ///< Decodificando en un trabajador.
+    STREAM_READY,        ///< En CPU, esperando subida a GPU.
+    STREAM_RESIDENT,     ///< Entregado al hilo principal.
+    STREAM_CANCELED,     ///< Cancelado por el usuario.
+    STREAM_FAILED        ///< Error de lectura o decodificación.
+};
+
+/// Identificador de petición (0 = inválido).
+using StreamHandle = unsigned int;
+
+/**
+ * @struct StreamedAsset
+ * @brief Datos de CPU entregados al hilo principal para su subida a GPU.
+ */
+struct StreamedAsset {
+    StreamHandle handle = 0;              ///< Petición de origen.
+    StreamAssetType type = STREAM_MESH;   ///< Tipo de asset.
+    std::string path;                     ///< Ruta solicitada.
+    bool success = false;                 ///< false si la carga falló.
+    std::vector<MeshComponent> meshes;    ///< Mallas (STREAM_MESH).
+    ImageData image;                      ///< Imagen RGBA8 (STREAM_TEXTURE).
+    size_t byteSize = 0;                  ///< Bytes que se subirán a GPU.
+};
+
+/**
+ * @brief Callback invocado en el hilo principal cuando el asset está listo
+ * (o falló). Es el responsable de crear los recursos de GPU.
+ */
+using StreamCallback = std::function<void(StreamedAsset& asset)>;
+
+/**
+ * @struct StreamingStats
+ * @brief Contadores del streamer para la interfaz.
+ */
+struct StreamingStats {
+    unsigned int queued = 0;        ///< Peticiones en cola de IO.
+    unsigned int inFlight = 0;      ///< Leyendo o decodificando.
+    unsigned int ready = 0;         ///< Esperando subida.
+    unsigned int resident = 0;      ///< Entregadas en total.
+    unsigned int canceled = 0;      ///< Canceladas en total.
+    unsigned int failed = 0;        ///< Fallidas en total.
+    size_t frameBytes = 0;          ///< Bytes subidos en el último frame.
+    double frameMs = 0.0;           ///< Tiempo de subida en el último frame.
+    double worstFrameMs = 0.0;      ///< Peor tiempo de subida registrado.
+    size_t totalBytes = 0;          ///< Bytes subidos en total.
+};
+
+/**
+ * @class AssetStreamer
+ * @brief Pipeline de carga asíncrona: hilo de IO -> trabajadores de decodificación -> subida en el hilo principal.
+ *
+ * @details
+ * El hilo de IO atiende siempre primero la cola de mayor prioridad y lee
+ * los archivos completos a memoria; la decodificación (stb, .vmesh, .vtex,
+ * FBX/OBJ) se reparte en un JobSystem. El hilo principal llama a update()
+ * una vez por frame: ejecuta los callbacks de los assets listos, por orden
+ * de prioridad, hasta agotar el presupuesto de bytes o de milisegundos
+ * (siempre al menos uno para garantizar progreso).
+ */
+class AssetStreamer {
+public:
+    /** @brief Constructor por defecto. */
+    AssetStreamer() = default;
+
+    /** @brief Destructor: detiene los hilos si siguen activos. */
+    ~AssetStreamer() { destroy(); }
+
+    AssetStreamer(const AssetStreamer&) = delete;
+    AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+    /**
+     * @brief Arranca el hilo de IO y los trabajadores de decodificación.
+     * @param decodeThreads Trabajadores (0 = automático).
+     */
+    HRESULT init(unsigned int decodeThreads = 0);
+
+    /**
+     * @brief Importa las mallas con vértices compactos (snorm16/half); llamar antes de init().
+     * @param enabled true para cuantizar las mallas que pasen la comprobación de error.
+     */
+    void setCompactVertices(bool enabled) { m_compactVertices = enabled; }
+
+    /**
+     * @brief Solicita la carga asíncrona de un asset.
+     * @param path Ruta del archivo (.vmesh/.fbx/.obj o imagen/.vtex).
+     * @param type Tipo de asset.
+     * @param priority Prioridad inicial.
+     * @param onReady Callback ejecutado en el hilo principal.
+     * @return Handle de la petición (0 si el streamer no está activo).
+     */
+    StreamHandle request(const std::string& path,
+        StreamAssetType type,
+        StreamPriority priority,
+        StreamCallback onReady);
+
+    /**
+     * @brief Cancela una petición pendiente.
+     * @return true si la petición aún no se había entregado.
+     */
+    bool cancel(StreamHandle handle);
+
+    /**
+     * @brief Cambia la prioridad de una petición que sigue en cola o lista.
+     */
+    void setPriority(StreamHandle handle, StreamPriority priority);
+
+    /**
+     * @brief Obtiene el estado actual de una petición.
+     * @return STREAM_INVALID si el handle es desconocido o la petición ya terminó
+     * (entregada, fallida o cancelada): solo se guardan las peticiones vivas.
+     */
+    StreamState getState(StreamHandle handle) const;
+
+    /**
+     * @brief Entrega los assets listos dentro del presupuesto del frame (hilo principal).
+     * @param byteBudget Bytes máximos a subir (0 = sin límite).
+     * @param msBudget Milisegundos máximos de subida (0 = sin límite).
+     */
+    void update(size_t byteBudget, double msBudget);
+
+    /**
+     * @brief Detiene los hilos y descarta las peticiones pendientes.
+     */
+    void destroy();
+
+    /// @return Contadores del streamer.
+    const StreamingStats& getStats() const { return m_stats; }
+
+    /// @return true si no queda trabajo pendiente en ninguna etapa.
+    bool isIdle() const;
+
+    /** @brief Reinicia el peor tiempo de subida registrado. */
+    void resetWorstFrame() { m_stats.worstFrameMs = 0.0; }
+
+private:
+    /** @brief Estado interno de una petición. */
+    struct Request {
+        StreamHandle handle = 0;
+        std::string path;
+        StreamAssetType type = STREAM_MESH;
+        StreamPriority priority = STREAM_PREFETCH;
+        StreamState state = STREAM_QUEUED;
+        StreamCallback onReady;
+        StreamedAsset result;
+    };
+    using RequestPtr = std::shared_ptr<Request>;
+
+    /** @brief Bucle del hilo de IO. */
+    void ioLoop();
+
+    /** @brief Decodifica un asset ya leído (se ejecuta en un trabajador). */
+    void decode(RequestPtr request, std::vector<unsigned char> bytes);
+
+    /** @brief Saca la siguiente petición válida de la cola más prioritaria (con el mutex tomado). */
+    RequestPtr popNextLocked();
+
+private:
+    mutable std::mutex m_mutex;                                 ///< Protege colas, mapa y contadores.
+    std::condition_variable m_ioWake;                           ///< Despierta al hilo de IO.
+    std::deque<StreamHandle> m_queues[STREAM_PRIORITY_COUNT];   ///< Colas de IO por prioridad.
+    std::unordered_map<StreamHandle, RequestPtr> m_requests;    ///< Peticiones vivas.
+    std::vector<RequestPtr> m_ready;                            ///< Listas para subir.
+    std::thread m_ioThread;                                     ///< Hilo de IO.
+    JobSystem m_decoders;                                       ///< Trabajadores de decodificación.
+    StreamHandle m_nextHandle = 1;                              ///< Siguiente handle libre.
+    unsigned int m_inFlight = 0;                                ///< Peticiones leyendo o decodificando.
+    unsigned int m_maxInFlight = 4;                             ///< Límite de memoria en vuelo.
+    bool m_running = false;                                     ///< Indica si el streamer está activo.
+    bool m_compactVertices = false;                             ///< Opción de importación de mallas.
+    StreamingStats m_stats;                                     ///< Contadores publicados.
+};
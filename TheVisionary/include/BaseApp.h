@@ -19,9 +19,27 @@
 #include "MeshComponent.h"
 #include "ModelLoader.h"
 #include "UserInterface.h"
+#include "AssetStreamer.h"
 #include "ECS/Actor.h"
+#include "FrustumCuller.h"
+#include "DynamicAABBTree.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+#include "DeferredContextPool.h"
+#include "NullBackend.h"
+#include "CaptureBackend.h"
+#include "CommandReplay.h"
+#include "FramePipeline.h"
+#include "FramePacing.h"
+#include "Profiler.h"
+#include "InstanceBatcher.h"
+#include "ConstantBufferRing.h"
+#include "GeometryHeap.h"
+#include "D3DShaderCompiler.h"
+#include "JobSystem.h"
 
 #include <vector>
+#include <chrono>
 
  /**
   * @class BaseApp
@@ -61,6 +79,115 @@ public:
         int nCmdShow,
         WNDPROC wndproc);
 
+private:
+    /**
+     * @brief Encola 500 peticiones de streaming para medir picos de frame.
+     */
+    void startStreamingStress();
+
+    /**
+     * @brief Lleva al índice espacial los actores nuevos y los que cambiaron de volumen.
+     */
+    void syncSceneTree();
+
+    /**
+     * @brief Actor más cercano que toca un rayo: candidatos del índice espacial y prueba exacta con el BVH de sus mallas.
+     * @param origin Origen en mundo.
+     * @param direction Dirección normalizada en mundo.
+     * @param distance Distancia al impacto.
+     * @return Índice en m_actors, o -1 si el rayo no toca ningún actor.
+     */
+    int pickActor(const XMFLOAT3& origin, const XMFLOAT3& direction, float& distance);
+
+    /**
+     * @brief Mide rayos por segundo contra la malla cargada más grande y un terreno de 5M triángulos.
+     */
+    void runRayBenchmark();
+
+    /**
+     * @brief Crea copias ligeras instanciadas del actor seleccionado en una rejilla alrededor de él.
+     * @param count Copias.
+     */
+    void spawnInstances(unsigned int count);
+
+    /**
+     * @brief Mide la construcción de 1k y 10k actores completos con la caché de objetos
+     *        y estima el coste sin ella a partir de unos pocos.
+     */
+    void runSpawnBenchmark();
+
+    /**
+     * @brief Compila los shaders del motor con la caché vacía y los vuelve a leer de su archivo (al log).
+     */
+    void runShaderCacheBenchmark();
+
+    /**
+     * @brief Enlaza render targets, viewport, shaders y constantes del frame en un contexto.
+     * @param context Contexto inmediato o diferido.
+     */
+    void bindFrameState(DeviceContext& context);
+
+    /**
+     * @brief Mide el recorrido de la cola repartido en 1..8 hilos y, con contextos diferidos,
+     *        la grabación de la escena con 1..8 trabajadores (al log).
+     */
+    void runParallelSubmitBenchmark();
+
+    /**
+     * @brief Simulación de la escena de un frame: pasos fijos de los actores, índice espacial y visibilidad.
+     * @param steps Pasos de m_timestep a simular (0 = solo interpolar y volver a calcular la visibilidad).
+     * @param alpha Fracción del siguiente paso ya transcurrida (interpolación del dibujo).
+     */
+    void updateScene(unsigned int steps, float alpha);
+
+    /** @brief Cola de dibujo de los visibles y su envío al backend del contexto. */
+    void renderScene();
+
+    /**
+     * @brief Sube las constantes de cámara (el contexto omite la subida si no cambiaron).
+     * @param view Vista.
+     * @param projection Proyección.
+     */
+    void uploadCamera(const XMMATRIX& view, const XMMATRIX& projection);
+
+    /** @brief Arranca o detiene el hilo de render según m_threadedRender y la captura en curso. */
+    void syncRenderThread();
+
+    /**
+     * @brief Espera a que el hilo de render dibuje lo publicado (nada si no está en marcha).
+     * @note Hasta el siguiente paquete el contexto inmediato vuelve a ser de la simulación:
+     *       llamar antes de usarlo o de liberar objetos que puedan estar en un paquete.
+     */
+    void acquireContext();
+
+    /**
+     * @brief Llena el paquete del frame: cámara, cola de los visibles, instancias y ImGui (simulación).
+     * @param packet Paquete que después se publica.
+     */
+    void buildFramePacket(FramePacket& packet);
+
+    /**
+     * @brief Dibuja un paquete y presenta (hilo de render).
+     * @param packet Paquete publicado por la simulación.
+     */
+    void renderFramePacket(FramePacket& packet);
+
+    /**
+     * @brief Ejecuta frames de escena sin GPU con un NullBackend y guarda sus contadores (al log).
+     * @param frames Frames a grabar.
+     */
+    void runHeadlessBenchmark(unsigned int frames);
+
+    /** @brief Cierra la captura en curso y la escribe en kCapturePath (al log). */
+    void finishCapture();
+
+    /**
+     * @brief Reproduce una captura y guarda sus tiempos (al log).
+     * @param onDevice true: la última captura de la sesión sobre el contexto, con sus objetos;
+     *        false: el archivo de captura sobre un NullBackend.
+     */
+    void runCaptureReplay(bool onDevice);
+
 private:
     // --- Core DX11 ---
     Window          m_window;            ///< Ventana principal.
@@ -98,6 +225,74 @@ private:
 
     // Recursos
     ModelLoader    m_modelLoader;        ///< Cargador de modelos.
+    AssetStreamer  m_streamer;           ///< Carga asíncrona de mallas y texturas.
+    ImageData      m_placeholderImage;   ///< Imagen de reemplazo mientras se carga la real.
+    int            m_streamBudgetKB = 4096;   ///< Presupuesto de subida por frame (KB).
+    float          m_streamBudgetMs = 2.0f;   ///< Presupuesto de subida por frame (ms).
+
+    // Métricas de arranque y de frame
+    std::chrono::steady_clock::time_point m_startTime;  ///< Inicio de run().
+    std::chrono::steady_clock::time_point m_lastFrame;  ///< Inicio del frame anterior.
+    double         m_timeToFirstFrameMs = 0.0;          ///< Arranque -> primer Present.
+    double         m_worstFrameMs = 0.0;                ///< Peor frame desde el último reinicio.
+    bool           m_firstFramePresented = false;       ///< Ya se midió el primer frame.
+
+    // Visibilidad
+    JobSystem      m_jobs;                    ///< Pool para etapas por frame (culling).
+    FrustumCuller  m_actorCuller;             ///< AABB en mundo de los actores (SoA).
+    std::vector<unsigned int> m_visibleActors; ///< Índices en m_actors visibles este frame.
+    FrustumCullStats m_frustumStats;          ///< Culling de actores del último frame.
+    bool           m_meshletCulling = true;   ///< Culling de meshlets activado.
+    MeshletCullStats m_meshletStats;          ///< Suma del último frame de los actores visibles.
+    OcclusionBuffer m_occlusion;              ///< Profundidad por software de los oclusores.
+    OcclusionStats m_occlusionStats;          ///< Occlusion culling del último frame.
+    bool           m_occlusionCulling = true; ///< Occlusion culling activado.
+
+    // Dibujo
+    RenderQueue    m_renderQueue;             ///< Paquetes del frame ordenados por estado.
+    InstanceBatcher m_instanceBatcher;        ///< Lotes instanciados de los actores que comparten malla.
+    bool           m_instancing = true;       ///< Instancing activado.
+    int            m_spawnCount = 10000;      ///< Copias que crea el panel de instancing.
+    ConstantBufferRing m_constantRing;        ///< Constantes por draw enlazadas por offset (Direct3D 11.1).
+    bool           m_useConstantRing = true;  ///< Enviar las constantes de la cola por el anillo.
+    DeferredContextPool m_deferredContexts;   ///< Contextos diferidos del envío paralelo.
+    bool           m_parallelSubmit = false;  ///< Grabar la cola en contextos diferidos.
+    int            m_submitWorkers = 4;       ///< Trabajadores del envío paralelo.
+    double         m_sceneTime = 0.0;         ///< Tiempo simulado (suma de pasos fijos).
+    int            m_headlessFrames = 300;    ///< Frames de la medición sin GPU.
+    HeadlessBenchmark m_headless;             ///< Última medición sin GPU.
+    CaptureBackend m_capture;                 ///< Última captura de comandos (retiene sus objetos).
+    int            m_captureFrames = 1;       ///< Frames por captura.
+    int            m_replayRepeats = 10;      ///< Pasadas de la reproducción.
+    ReplayStats    m_replay;                  ///< Última reproducción.
+    RenderThread   m_renderThread;            ///< Envío y Present del frame N mientras se simula el N + 1.
+    bool           m_threadedRender = false;  ///< Usar el hilo de render.
+    bool           m_dropStalePackets = false; ///< El paquete más reciente sustituye al que no se dibujó.
+    uint64_t       m_frameIndex = 0;          ///< Frames simulados.
+    std::chrono::steady_clock::time_point m_inputTime; ///< Comienzo del update() del frame (lectura de la entrada).
+    FrameLatencyTracker m_serialLatency;      ///< Tiempos de los frames en serie.
+    FrameLatencyStats m_latency[2];           ///< Última ventana de cada modo (0 = serie, 1 = hilo de render).
+    FrameRenderResult m_frameResult;          ///< Contadores del último frame del hilo de render.
+    GeometryHeap   m_geometryHeap;            ///< Vértices e índices de las mallas en páginas compartidas.
+
+    // Tiempo y ritmo del bucle
+    FrameClock     m_clock;                   ///< Reloj monotónico de los frames.
+    FixedTimestep  m_timestep;                ///< Pasos fijos de la simulación de los actores.
+    int            m_simulationHz = 60;       ///< Pasos por segundo de la simulación.
+    unsigned int   m_frameSteps = 0;          ///< Pasos simulados en el frame en curso.
+    FramePacer     m_pacer;                   ///< Espera entre frames y medición del ritmo y la CPU.
+    FramePacingSettings m_pacing;             ///< Límites de frames por segundo.
+
+    // Profiler
+    bool           m_profiling = true;        ///< Registrar las zonas del profiler.
+    int            m_profileFrames = 60;      ///< Frames por traza de Chrome.
+
+    // Índice espacial
+    DynamicAABBTree m_sceneTree;              ///< Árbol de AABB de los actores (userData = índice en m_actors).
+    std::vector<int> m_actorProxies;          ///< Proxy de cada actor (kNullNode si aún no tiene volumen).
+    std::vector<unsigned int> m_actorBoundsRevisions; ///< Revisión de volúmenes ya llevada al árbol.
+    std::vector<ProxyUpdate> m_proxyUpdates;  ///< Movimientos del frame (se reutiliza).
+    DynamicTreeStats m_sceneTreeStats;        ///< Última actualización del árbol.
 
     // Plano de referencia
     MeshComponent  planeMesh;            ///< Malla del plano.
@@ -113,4 +308,5 @@ private:
     float   m_camPitchDeg = 15.0f;
     float   m_camDistance = 10.0f;
     XMFLOAT3 m_camTarget = XMFLOAT3(0.0f, -5.0f, 0.0f);
+    XMFLOAT3 m_camEye = XMFLOAT3(0.0f, 3.0f, -6.0f); ///< Posición de la cámara (selección de LOD).
 };
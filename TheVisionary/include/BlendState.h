@@ -53,6 +53,9 @@ public:
      */
     void destroy();
 
+    /// @return Puntero nativo al estado de blending.
+    ID3D11BlendState* raw() const { return m_blendState; }
+
 private:
     ID3D11BlendState* m_blendState = nullptr; ///< Puntero al estado de blending de Direct3D.
 };
@@ -0,0 +1,92 @@
+﻿/**
+ * @file BoundingVolume.h
+ * @brief Volúmenes envolventes de malla (AABB + esfera) y su paso a espacio de mundo.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @struct MeshBounds
+ * @brief Caja alineada a los ejes y esfera envolvente de una malla.
+ */
+struct MeshBounds {
+    XMFLOAT3 center = XMFLOAT3(0.0f, 0.0f, 0.0f);  ///< Centro de la AABB.
+    XMFLOAT3 extents = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Semiejes de la AABB.
+    XMFLOAT4 sphere = XMFLOAT4(0.0f, 0.0f, 0.0f, -1.0f); ///< Esfera (centro, radio); radio < 0 = sin volumen.
+
+    /// true si no se ha calculado (malla vacía).
+    bool isEmpty() const { return sphere.w < 0.0f; }
+};
+
+/**
+ * @struct BoundsBenchmark
+ * @brief Tiempos del cálculo de volúmenes sobre una malla de prueba.
+ */
+struct BoundsBenchmark {
+    size_t vertices = 0;       ///< Vértices procesados.
+    double aabbMs = 0.0;       ///< Reducción min/max.
+    double sphereMs = 0.0;     ///< Esfera (Ritter + comparación con la esfera de la caja).
+    double transformUs = 0.0;  ///< Paso a mundo de un volumen (media de muchas llamadas).
+    float ritterRadius = 0.0f; ///< Radio de Ritter.
+    float boxRadius = 0.0f;    ///< Radio de la esfera centrada en la caja.
+};
+
+/**
+ * @class BoundingVolume
+ * @brief Cálculo de AABB y esfera envolvente de vértices, y transformación a mundo.
+ *
+ * @details
+ * La AABB se obtiene con una reducción min/max de XMVECTOR con cuatro
+ * acumuladores independientes. La esfera usa el método de Ritter (diámetro
+ * inicial entre los extremos del eje más largo y un pase de crecimiento) y se
+ * compara con la esfera centrada en la caja; se queda la de menor radio.
+ */
+class BoundingVolume {
+public:
+    /**
+     * @brief Calcula la AABB y la esfera de una lista de vértices.
+     * @param vertices Vértices en espacio del modelo.
+     * @return Volúmenes; vacío si no hay vértices.
+     */
+    static MeshBounds compute(const std::vector<SimpleVertex>& vertices);
+
+    /**
+     * @brief Reducción min/max de las posiciones.
+     * @param vertices Vértices (no vacío).
+     * @param minimum Esquina mínima.
+     * @param maximum Esquina máxima.
+     */
+    static void computeAABB(const std::vector<SimpleVertex>& vertices, XMFLOAT3& minimum, XMFLOAT3& maximum);
+
+    /**
+     * @brief Esfera envolvente por el método de Ritter.
+     * @param vertices Vértices (no vacío).
+     * @param minimum Esquina mínima de la AABB (elige el eje inicial).
+     * @param maximum Esquina máxima de la AABB.
+     * @return Centro (xyz) y radio (w).
+     */
+    static XMFLOAT4 computeRitterSphere(const std::vector<SimpleVertex>& vertices,
+        const XMFLOAT3& minimum,
+        const XMFLOAT3& maximum);
+
+    /**
+     * @brief Lleva unos volúmenes locales a mundo.
+     * @param local Volúmenes en espacio del modelo.
+     * @param world Matriz de mundo (vectores fila).
+     * @return AABB envolvente de la caja transformada y esfera escalada por el mayor eje.
+     */
+    static MeshBounds transform(const MeshBounds& local, const XMMATRIX& world);
+
+    /**
+     * @brief Une dos volúmenes (cualquiera puede estar vacío).
+     */
+    static MeshBounds merge(const MeshBounds& a, const MeshBounds& b);
+
+    /**
+     * @brief Mide el cálculo sobre una nube aleatoria de vértices.
+     * @param vertexCount Vértices de la malla de prueba (p. ej. 10 millones).
+     * @return Tiempos y radios obtenidos.
+     */
+    static BoundsBenchmark benchmark(size_t vertexCount);
+};
@@ -46,8 +46,21 @@ public:
      */
     HRESULT init(Device& device, unsigned int ByteWidth);
 
+    /**
+     * @brief Inicializa un Vertex Buffer vacío que se rellena con update() (p. ej. datos por instancia).
+     * @param device Referencia al dispositivo de render.
+     * @param stride Tamaño de cada elemento.
+     * @param count Capacidad en elementos.
+     * @return HRESULT indicando éxito o error.
+     */
+    HRESULT init(Device& device, unsigned int stride, unsigned int count);
+
     /**
      * @brief Actualiza el contenido de un Constant Buffer en memoria.
+     *
+     * @details Un Constant Buffer completo (sin pDstBox) se sube con
+     * DeviceContext::UpdateConstantBuffer, que la omite si coincide con lo
+     * último subido.
      * @param deviceContext Contexto del dispositivo.
      * @param pDstResource Recurso destino.
      * @param DstSubresource Índice de subrecurso.
@@ -83,6 +96,15 @@ public:
      */
     void destroy();
 
+    /// @return Puntero nativo al buffer.
+    ID3D11Buffer* raw() const { return m_buffer; }
+
+    /// @return Tamaño de cada elemento (Vertex Buffers).
+    unsigned int getStride() const { return m_stride; }
+
+    /// @return Desplazamiento inicial.
+    unsigned int getOffset() const { return m_offset; }
+
     /**
      * @brief Crea un buffer de Direct3D 11 con una descripción y datos iniciales.
      * @param device Referencia al dispositivo.
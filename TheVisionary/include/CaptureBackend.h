@@ -0,0 +1,168 @@
+﻿/**
+ * @file CaptureBackend.h
+ * @brief Backend que graba los comandos, con sus datos, mientras los pasa a otro backend.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "NullBackend.h"
+
+/**
+ * @struct MappedRange
+ * @brief Bytes de un recurso mapeado que cambiaron entre Map y Unmap.
+ */
+struct MappedRange {
+    unsigned int offset = 0; ///< Primer byte.
+    unsigned int size = 0;   ///< Bytes.
+};
+
+/**
+ * @class CaptureBackend
+ * @brief Captura de frames: cada comando se graba como en NullBackend y se envía al destino.
+ *
+ * @details
+ * A diferencia de NullBackend, el stream lleva los datos de UpdateSubresource
+ * y lo escrito entre Map y Unmap, y los objetos se retienen (AddRef) hasta
+ * reset(): getObjects() los devuelve por id para reproducir la captura en la
+ * misma sesión. Map de un buffer devuelve una copia en CPU; Unmap graba los
+ * rangos que cambiaron respecto a la copia anterior y los pasa a la memoria
+ * real (entera si fue DISCARD). El primer Map de cada buffer en la captura
+ * se hace con DISCARD para que la memoria real y la copia coincidan.
+ */
+class CaptureBackend : public NullBackend {
+public:
+    CaptureBackend() { m_recordContents = true; }
+    ~CaptureBackend() override;
+
+    /**
+     * @brief Backend que ejecuta los comandos (nullptr = solo se graban).
+     * @param target Destino; no es su dueño.
+     */
+    void setTarget(RenderBackend* target) { m_target = target; }
+
+    /** @brief Destino actual. */
+    RenderBackend* getTarget() const { return m_target; }
+
+    /** @brief Vacía la captura y suelta los objetos retenidos. */
+    void reset() override;
+
+    /** @brief Objetos capturados por id (índice = id - 1), retenidos hasta reset(). */
+    const std::vector<void*>& getObjects() const { return m_objects; }
+
+    /**
+     * @brief Escribe la captura en un archivo (writeCaptureFile).
+     * @return false si no se pudo escribir.
+     */
+    bool save(const std::string& path) const;
+
+    const char* getName() const override { return "Capture"; }
+    bool supportsConstantOffsets() const override { return m_target && m_target->supportsConstantOffsets(); }
+
+    void ClearState() override;
+    void RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) override;
+    void PSSetShaderResources(unsigned int StartSlot,
+        unsigned int NumViews,
+        ID3D11ShaderResourceView* const* ppShaderResourceViews) override;
+    void IASetInputLayout(ID3D11InputLayout* pInputLayout) override;
+    void VSSetShader(ID3D11VertexShader* pVertexShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) override;
+    void PSSetShader(ID3D11PixelShader* pPixelShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) override;
+    void UpdateSubresource(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        const BackendBox* pDstBox,
+        const void* pSrcData,
+        unsigned int SrcRowPitch,
+        unsigned int SrcDepthPitch,
+        unsigned int SrcBytes) override;
+    HRESULT Map(ID3D11Resource* pResource,
+        unsigned int Subresource,
+        unsigned int MapType,
+        unsigned int MapFlags,
+        BackendMappedSubresource* pMappedResource) override;
+    void Unmap(ID3D11Resource* pResource, unsigned int Subresource) override;
+    void CopySubresourceRegion(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        unsigned int DstX,
+        unsigned int DstY,
+        unsigned int DstZ,
+        ID3D11Resource* pSrcResource,
+        unsigned int SrcSubresource,
+        const BackendBox* pSrcBox) override;
+    void IASetVertexBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppVertexBuffers,
+        const unsigned int* pStrides,
+        const unsigned int* pOffsets) override;
+    void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+        unsigned int Format,
+        unsigned int Offset) override;
+    void PSSetSamplers(unsigned int StartSlot,
+        unsigned int NumSamplers,
+        ID3D11SamplerState* const* ppSamplers) override;
+    void RSSetState(ID3D11RasterizerState* pRasterizerState) override;
+    void OMSetBlendState(ID3D11BlendState* pBlendState,
+        const float BlendFactor[4],
+        unsigned int SampleMask) override;
+    void OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+        unsigned int StencilRef) override;
+    void OMSetRenderTargets(unsigned int NumViews,
+        ID3D11RenderTargetView* const* ppRenderTargetViews,
+        ID3D11DepthStencilView* pDepthStencilView) override;
+    void IASetPrimitiveTopology(unsigned int Topology) override;
+    void ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+        const float ColorRGBA[4]) override;
+    void ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+        unsigned int ClearFlags,
+        float Depth,
+        uint8_t Stencil) override;
+    void VSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) override;
+    void PSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) override;
+    void VSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) override;
+    void PSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) override;
+    HRESULT FinishCommandList(bool RestoreDeferredContextState,
+        ID3D11CommandList** ppCommandList) override;
+    void ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) override;
+    void DrawIndexed(unsigned int IndexCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation) override;
+    void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+        unsigned int InstanceCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation,
+        unsigned int StartInstanceLocation) override;
+
+protected:
+    /// Retiene el objeto y pregunta a D3D el tamaño y los flags de los buffers.
+    void describeResource(const void* object, NullResource& entry) override;
+
+private:
+    /// Memoria real de un Map en curso.
+    struct OpenMap {
+        void* data = nullptr;  ///< Puntero que devolvió el destino.
+        bool discard = false;  ///< DISCARD: se copia la copia entera.
+        bool shadowed = false; ///< Se devolvió la copia en CPU (tamaño conocido).
+    };
+
+    /// Compara mapped con contents y deja en m_ranges lo que cambió (contents queda al día).
+    void findChangedRanges(NullResource& entry);
+
+    RenderBackend* m_target = nullptr;                     ///< Destino de los comandos.
+    std::vector<void*> m_objects;                          ///< Objetos retenidos, por id.
+    std::unordered_map<const void*, OpenMap> m_open;       ///< Maps sin Unmap.
+    std::vector<MappedRange> m_ranges;                     ///< Rangos del último Unmap.
+};
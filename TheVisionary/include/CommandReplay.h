@@ -0,0 +1,121 @@
+﻿/**
+ * @file CommandReplay.h
+ * @brief Reproducción de un stream de comandos sobre un RenderBackend, con tiempos por llamada.
+ */
+
+#pragma once
+#include "RenderBackend.h"
+#include "CommandStream.h"
+
+/**
+ * @struct ReplayCallStats
+ * @brief Tiempo de un tipo de comando dentro del backend.
+ */
+struct ReplayCallStats {
+    unsigned int count = 0;  ///< Llamadas.
+    double totalMs = 0.0;    ///< Suma.
+    double maxMs = 0.0;      ///< La más lenta.
+};
+
+/**
+ * @struct ReplayStats
+ * @brief Resultado de CommandReplayer::replay().
+ */
+struct ReplayStats {
+    CommandStreamStats stream;                 ///< Totales de una pasada (binds por draw, bytes subidos).
+    ReplayCallStats calls[COMMAND_OP_COUNT];   ///< Por tipo de comando, en todas las pasadas.
+    unsigned int repeats = 0;                  ///< Pasadas.
+    unsigned int frames = 0;                   ///< Frames reproducidos en todas las pasadas.
+    double totalMs = 0.0;                      ///< Reproducción entera (decodificar, copiar y llamar).
+    double callMs = 0.0;                       ///< Solo las llamadas (incluye copiar lo mapeado).
+    double minFrameMs = 0.0;                   ///< Frame más rápido.
+    double maxFrameMs = 0.0;                   ///< Frame más lento.
+    unsigned int missing = 0;                  ///< Ids sin objeto (se enlaza nullptr o se salta el comando).
+    bool valid = false;                        ///< El stream se leyó entero.
+
+    /** @brief Media por frame. */
+    double getFrameMs() const { return frames ? totalMs / frames : 0.0; }
+};
+
+/**
+ * @class CommandReplayer
+ * @brief Vuelve a emitir los comandos de un stream sobre un backend.
+ *
+ * @details
+ * Los ids se traducen con la tabla de objetos que recibe: la de
+ * CaptureBackend::getObjects() para reproducir sobre Direct3D 11 en la misma
+ * sesión, o las de NullBackend::createResource() (sin GPU). Lo escrito entre Map
+ * y Unmap se aplica a una copia por recurso y se copia a la memoria que
+ * devuelve el backend: entera tras DISCARD, solo los rangos en otro caso.
+ * UpdateSubresource sin datos capturados y FinishCommandList no se emiten.
+ */
+class CommandReplayer {
+public:
+    /**
+     * @param target Backend que recibe los comandos.
+     * @param objects Asa de cada id (índice = id - 1; nullptr = sin objeto).
+     */
+    CommandReplayer(RenderBackend& target, const std::vector<void*>& objects)
+        : m_target(target), m_objects(objects) {}
+
+    /**
+     * @brief Reproduce el stream.
+     * @param stream Stream (de CaptureBackend o de un archivo de captura).
+     * @param repeats Pasadas (cada una empieza con las copias a cero, como la captura).
+     * @return Tiempos y totales; valid = false si el stream está cortado.
+     */
+    ReplayStats replay(const std::vector<uint8_t>& stream, unsigned int repeats = 1);
+
+private:
+    /// Emite un comando (false si se saltó por faltar su objeto).
+    bool execute(const CommandRecord& record);
+
+    /// Objeto de un id (nullptr si es 0 o no hay asa; lo segundo cuenta como missing).
+    template <typename T>
+    T* object(uint32_t id) {
+        if (id == 0) {
+            return nullptr;
+        }
+        void* handle = id <= m_objects.size() ? m_objects[id - 1] : nullptr;
+        if (!handle) {
+            ++m_missing;
+        }
+        return static_cast<T*>(handle);
+    }
+
+    /// Objetos de count ranuras a partir de args[first], separados stride argumentos.
+    template <typename T>
+    T* const* slots(const CommandRecord& record, size_t first, unsigned int count, unsigned int stride) {
+        m_slots.resize(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            m_slots[i] = object<T>(record.args[first + i * stride]);
+        }
+        return reinterpret_cast<T* const*>(m_slots.data());
+    }
+
+    /// Argumentos sin signo de count ranuras a partir de args[first].
+    const unsigned int* values(std::vector<unsigned int>& out, const CommandRecord& record,
+        size_t first, unsigned int count, unsigned int stride);
+
+    RenderBackend& m_target;                       ///< Destino.
+    const std::vector<void*>& m_objects;           ///< Asas por id.
+    std::vector<std::vector<uint8_t>> m_shadows;   ///< Copia de lo mapeado, por id.
+    std::vector<void*> m_mapped;                   ///< Memoria del Map en curso, por id.
+    std::vector<uint8_t> m_discard;                ///< El Map en curso fue DISCARD, por id.
+    std::vector<void*> m_slots;                    ///< Asas de un comando con ranuras.
+    std::vector<unsigned int> m_first;             ///< Strides / primeras constantes.
+    std::vector<unsigned int> m_second;            ///< Offsets / número de constantes.
+    std::vector<BackendViewport> m_viewports;      ///< Viewports de RSSetViewports.
+    unsigned int m_missing = 0;                    ///< Ids sin objeto.
+};
+
+/**
+ * @brief Reproduce un stream en un NullBackend, sin GPU.
+ *
+ * @details Cada id recibe un asa del backend con el tipo y el tamaño que
+ * declara el stream, así Map y Unmap funcionan; los tiempos son los del
+ * envío y la copia de los datos, sin driver.
+ * @param stream Stream de una captura.
+ * @param repeats Pasadas.
+ */
+ReplayStats replayHeadless(const std::vector<uint8_t>& stream, unsigned int repeats = 1);
@@ -0,0 +1,318 @@
+﻿/**
+ * @file CommandStream.h
+ * @brief Codificación binaria compacta de los comandos de RenderBackend y su archivo de captura.
+ *
+ * @details No depende de Windows ni de Direct3D: el stream y el archivo se
+ * escriben igual en cualquier plataforma (little-endian explícito) y se
+ * pueden leer y analizar sin dispositivo.
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @enum CommandOp
+ * @brief Primer byte de cada comando del stream; los argumentos van detrás.
+ *
+ * @details Los enteros se escriben como varint LEB128 (con zigzag los que
+ * pueden ser negativos), los float como 4 bytes little-endian y los
+ * recursos por su id (0 = nullptr). Un recurso aparece con CMD_RESOURCE
+ * antes del primer comando que lo usa. Los contenidos (UpdateSubresource,
+ * Unmap) solo van en el stream si quien graba los captura; si no, su
+ * número de bytes es 0.
+ */
+enum CommandOp : uint8_t {
+    CMD_FRAME = 0,                   ///< Índice del frame.
+    CMD_RESOURCE,                    ///< id, ResourceKind, bytes (0 = desconocido), bind flags.
+    CMD_CLEAR_STATE,                 ///< Sin argumentos.
+    CMD_RS_SET_VIEWPORTS,            ///< count, count x (x, y, w, h, minZ, maxZ).
+    CMD_PS_SET_SHADER_RESOURCES,     ///< start, count, count x id.
+    CMD_IA_SET_INPUT_LAYOUT,         ///< id.
+    CMD_VS_SET_SHADER,               ///< id.
+    CMD_PS_SET_SHADER,               ///< id.
+    CMD_UPDATE_SUBRESOURCE,          ///< id, subresource, bytes, row pitch, depth pitch, caja?, [6 x caja], n, n bytes.
+    CMD_MAP,                         ///< id, subresource, D3D11_MAP.
+    CMD_UNMAP,                       ///< id, subresource, rangos, rangos x (offset, n, n bytes escritos).
+    CMD_COPY_SUBRESOURCE_REGION,     ///< dst, subresource, x, y, z, src, subresource, caja?, [6 x caja].
+    CMD_IA_SET_VERTEX_BUFFERS,       ///< start, count, count x (id, stride, offset).
+    CMD_IA_SET_INDEX_BUFFER,         ///< id, DXGI_FORMAT, offset.
+    CMD_PS_SET_SAMPLERS,             ///< start, count, count x id.
+    CMD_RS_SET_STATE,                ///< id.
+    CMD_OM_SET_BLEND_STATE,          ///< id, 4 x factor, sample mask.
+    CMD_OM_SET_DEPTH_STENCIL_STATE,  ///< id, stencil ref.
+    CMD_OM_SET_RENDER_TARGETS,       ///< count, count x id, dsv.
+    CMD_IA_SET_PRIMITIVE_TOPOLOGY,   ///< D3D11_PRIMITIVE_TOPOLOGY.
+    CMD_CLEAR_RENDER_TARGET_VIEW,    ///< id, 4 x color.
+    CMD_CLEAR_DEPTH_STENCIL_VIEW,    ///< id, flags, depth, stencil.
+    CMD_VS_SET_CONSTANT_BUFFERS,     ///< start, count, count x id.
+    CMD_PS_SET_CONSTANT_BUFFERS,     ///< start, count, count x id.
+    CMD_VS_SET_CONSTANT_BUFFERS1,    ///< start, count, count x (id, first, num).
+    CMD_PS_SET_CONSTANT_BUFFERS1,    ///< start, count, count x (id, first, num).
+    CMD_FINISH_COMMAND_LIST,         ///< restore.
+    CMD_EXECUTE_COMMAND_LIST,        ///< id, restore.
+    CMD_DRAW_INDEXED,                ///< indices, start, base vertex.
+    CMD_DRAW_INDEXED_INSTANCED,      ///< indices, instances, start, base vertex, start instance.
+    COMMAND_OP_COUNT
+};
+
+/**
+ * @enum ResourceKind
+ * @brief Tipo de objeto de un id, según la primera llamada que lo usó.
+ */
+enum ResourceKind : uint8_t {
+    RESOURCE_GENERIC = 0,  ///< Recurso sin más datos (UpdateSubresource, Map, copias).
+    RESOURCE_BUFFER,
+    RESOURCE_SHADER_RESOURCE_VIEW,
+    RESOURCE_RENDER_TARGET_VIEW,
+    RESOURCE_DEPTH_STENCIL_VIEW,
+    RESOURCE_INPUT_LAYOUT,
+    RESOURCE_VERTEX_SHADER,
+    RESOURCE_PIXEL_SHADER,
+    RESOURCE_SAMPLER_STATE,
+    RESOURCE_RASTERIZER_STATE,
+    RESOURCE_BLEND_STATE,
+    RESOURCE_DEPTH_STENCIL_STATE,
+    RESOURCE_COMMAND_LIST,
+    RESOURCE_KIND_COUNT
+};
+
+/** @brief Nombre de un comando ("DrawIndexed", ...). */
+const char* getCommandName(CommandOp op);
+
+/** @brief Nombre de un tipo de recurso. */
+const char* getResourceKindName(ResourceKind kind);
+
+/** @brief true si el comando cambia estado enlazado (shaders, buffers, vistas, estados, topología). */
+bool isBindCommand(CommandOp op);
+
+/** @brief true si el comando es un draw. */
+inline bool isDrawCommand(CommandOp op) {
+    return op == CMD_DRAW_INDEXED || op == CMD_DRAW_INDEXED_INSTANCED;
+}
+
+/**
+ * @class CommandWriter
+ * @brief Escribe comandos y argumentos al final de un bloque de bytes.
+ */
+class CommandWriter {
+public:
+    /** @brief Vacía el bloque (conserva la memoria). */
+    void clear() { m_data.clear(); }
+
+    void op(CommandOp op) { m_data.push_back(op); }
+
+    /** @brief Entero sin signo como varint LEB128 (1 byte por debajo de 128). */
+    void u32(uint32_t value) {
+        while (value >= 0x80) {
+            m_data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        m_data.push_back(static_cast<uint8_t>(value));
+    }
+
+    /** @brief Entero con signo en zigzag (los negativos pequeños también ocupan poco). */
+    void i32(int32_t value) {
+        u32((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+    }
+
+    /** @brief float en 4 bytes little-endian. */
+    void f32(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            m_data.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+        }
+    }
+
+    /** @brief Bytes tal cual. */
+    void bytes(const void* data, size_t size) {
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        m_data.insert(m_data.end(), begin, begin + size);
+    }
+
+    /** @brief Bytes escritos. */
+    const std::vector<uint8_t>& getData() const { return m_data; }
+
+    /** @brief Tamaño del bloque. */
+    size_t size() const { return m_data.size(); }
+
+private:
+    std::vector<uint8_t> m_data; ///< Stream codificado.
+};
+
+/**
+ * @class CommandReader
+ * @brief Lee lo que escribió CommandWriter, sin salirse del bloque.
+ *
+ * @details Un stream cortado no lee fuera: a partir del primer error todo
+ * devuelve 0 y failed() queda a true.
+ */
+class CommandReader {
+public:
+    CommandReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    /** @brief true si no quedan bytes (o hubo un error). */
+    bool atEnd() const { return m_failed || m_offset >= m_size; }
+
+    /** @brief true si se intentó leer más allá del final o un varint era inválido. */
+    bool failed() const { return m_failed; }
+
+    /** @brief Posición actual en el bloque. */
+    size_t offset() const { return m_offset; }
+
+    CommandOp op() { return static_cast<CommandOp>(byte()); }
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            const uint8_t next = byte();
+            value |= static_cast<uint32_t>(next & 0x7f) << shift;
+            if (!(next & 0x80)) {
+                return value;
+            }
+        }
+        m_failed = true;
+        return 0;
+    }
+
+    int32_t i32() {
+        const uint32_t value = u32();
+        return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+    }
+
+    float f32() {
+        uint32_t bits = 0;
+        for (int i = 0; i < 4; ++i) {
+            bits |= static_cast<uint32_t>(byte()) << (8 * i);
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /** @brief Puntero a los siguientes size bytes dentro del bloque (nullptr si no caben). */
+    const uint8_t* bytes(size_t size) {
+        if (m_failed || size > m_size - m_offset) {
+            m_failed = true;
+            return nullptr;
+        }
+        const uint8_t* begin = m_data + m_offset;
+        m_offset += size;
+        return begin;
+    }
+
+private:
+    uint8_t byte() {
+        if (m_failed || m_offset >= m_size) {
+            m_failed = true;
+            return 0;
+        }
+        return m_data[m_offset++];
+    }
+
+    const uint8_t* m_data; ///< Bloque leído (no es dueño).
+    size_t m_size;         ///< Tamaño del bloque.
+    size_t m_offset = 0;   ///< Siguiente byte.
+    bool m_failed = false; ///< Lectura fuera del bloque.
+};
+
+/**
+ * @struct CommandRecord
+ * @brief Un comando decodificado: sus argumentos en el orden del stream.
+ *
+ * @details Los float van como sus bits y los enteros con signo ya sin
+ * zigzag; los contenidos apuntan dentro del stream (su tamaño es el
+ * argumento anterior).
+ */
+struct CommandRecord {
+    CommandOp op = CMD_FRAME;             ///< Comando.
+    size_t offset = 0;                    ///< Posición del comando en el stream.
+    std::vector<uint32_t> args;           ///< Argumentos.
+    std::vector<const uint8_t*> blobs;    ///< Contenidos, en orden.
+
+    float getFloat(size_t index) const {
+        float value;
+        std::memcpy(&value, &args[index], sizeof(value));
+        return value;
+    }
+};
+
+/**
+ * @brief Decodifica el siguiente comando.
+ * @param reader Stream (avanza hasta el comando siguiente).
+ * @param record Recibe el comando (reutiliza su memoria).
+ * @return false al final del stream o si el comando está cortado o es desconocido.
+ */
+bool decodeCommand(CommandReader& reader, CommandRecord& record);
+
+/**
+ * @struct CommandStreamStats
+ * @brief Totales de un stream, calculados solo a partir de sus bytes.
+ */
+struct CommandStreamStats {
+    unsigned int frames = 0;        ///< CMD_FRAME.
+    unsigned int commands = 0;      ///< Comandos (sin CMD_FRAME ni CMD_RESOURCE).
+    unsigned int binds = 0;         ///< Comandos que cambian estado enlazado.
+    unsigned int draws = 0;         ///< Draws.
+    uint64_t indices = 0;           ///< Índices dibujados por todas las instancias.
+    unsigned int resources = 0;     ///< Ids declarados.
+    unsigned int uploads = 0;       ///< UpdateSubresource.
+    uint64_t uploadBytes = 0;       ///< Bytes de UpdateSubresource.
+    unsigned int maps = 0;          ///< Map.
+    uint64_t mapBytes = 0;          ///< Bytes escritos entre Map y Unmap (si se capturaron).
+    uint64_t contentBytes = 0;      ///< Contenidos que lleva el stream.
+    unsigned int counts[COMMAND_OP_COUNT] = {}; ///< Comandos por tipo.
+    bool valid = false;             ///< El stream se leyó entero sin errores.
+
+    double getBindsPerDraw() const { return draws ? double(binds) / draws : 0.0; }
+};
+
+/** @brief Recorre un stream y suma sus comandos. */
+CommandStreamStats analyzeCommandStream(const std::vector<uint8_t>& stream);
+
+/**
+ * @struct StreamResource
+ * @brief Lo que declara CMD_RESOURCE de un id (la última declaración).
+ */
+struct StreamResource {
+    uint32_t id = 0;                      ///< Id (0 = no declarado).
+    ResourceKind kind = RESOURCE_GENERIC; ///< Tipo.
+    uint32_t bytes = 0;                   ///< Tamaño (0 = desconocido).
+    uint32_t flags = 0;                   ///< Bind flags de un buffer.
+};
+
+/** @brief Recursos declarados en un stream, por id (índice = id - 1). */
+std::vector<StreamResource> listStreamResources(const std::vector<uint8_t>& stream);
+
+/** Versión del archivo de captura ("VCAP"). */
+const uint32_t kCaptureFileVersion = 1;
+
+/**
+ * @struct CaptureFileHeader
+ * @brief Datos de la cabecera de un archivo de captura.
+ *
+ * @details En disco: "VCAP", versión, frames y recursos en 4 bytes y el
+ * tamaño del stream en 8, todo little-endian; detrás, el stream.
+ */
+struct CaptureFileHeader {
+    uint32_t version = kCaptureFileVersion; ///< Versión del formato.
+    uint32_t frames = 0;                    ///< Frames del stream.
+    uint32_t resources = 0;                 ///< Ids declarados.
+    uint64_t streamBytes = 0;               ///< Bytes del stream.
+};
+
+/**
+ * @brief Escribe un stream en un archivo de captura.
+ * @return false si no se pudo escribir.
+ */
+bool writeCaptureFile(const std::string& path, const CaptureFileHeader& header, const std::vector<uint8_t>& stream);
+
+/**
+ * @brief Lee un archivo de captura.
+ * @param error Recibe el motivo si falla.
+ * @return false si no existe, no es una captura, es de otra versión o está cortado.
+ */
+bool readCaptureFile(const std::string& path, CaptureFileHeader& header, std::vector<uint8_t>& stream, std::string& error);
@@ -0,0 +1,252 @@
+﻿/**
+ * @file ConstantBufferRing.h
+ * @brief Anillo de constantes por frame con offsets de Direct3D 11.1 y subidas filtradas por contenido.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <unordered_map>
+
+class Device;
+class DeviceContext;
+
+/**
+ * @struct ConstantUploadStats
+ * @brief Constantes subidas en un frame.
+ */
+struct ConstantUploadStats {
+    unsigned int updates = 0;      ///< UpdateSubresource sobre constant buffers.
+    uint64_t updateBytes = 0;      ///< Bytes subidos con UpdateSubresource.
+    unsigned int skipped = 0;      ///< Subidas omitidas porque el contenido no cambió.
+    uint64_t skippedBytes = 0;     ///< Bytes que no se subieron.
+    unsigned int ringWrites = 0;   ///< Bloques escritos en el anillo.
+    uint64_t ringBytes = 0;        ///< Bytes copiados al anillo.
+    unsigned int ringMaps = 0;     ///< Map del anillo.
+
+    /// Bytes que llegaron a la GPU (UpdateSubresource + anillo).
+    uint64_t getUploadedBytes() const { return updateBytes + ringBytes; }
+};
+
+/**
+ * @struct ConstantRingBenchmark
+ * @brief Frames sintéticos: subidas de antes, con filtrado por contenido y con el anillo.
+ */
+struct ConstantRingBenchmark {
+    unsigned int draws = 0;          ///< Draws por frame.
+    unsigned int actors = 0;         ///< Actores (cuatro draws cada uno).
+    unsigned int moving = 0;         ///< Actores que cambian de matriz cada frame.
+    unsigned int frames = 0;         ///< Frames simulados.
+    uint64_t naiveBytes = 0;         ///< Por frame: cada actor y cada draw suben siempre (antes).
+    uint64_t trackedBytes = 0;       ///< Por frame: UpdateSubresource solo si el hash cambió.
+    uint64_t ringBytes = 0;          ///< Por frame: draws copiados al anillo más los buffers de actor que cambiaron.
+    unsigned int ringFallbacks = 0;  ///< Draws que no cupieron en el anillo.
+    double trackedMs = 0.0;          ///< Hash y comparación por frame.
+    double ringMs = 0.0;             ///< Asignación y copia al anillo por frame.
+    bool allocatorValid = false;     ///< Offsets alineados, dentro del buffer y sin pisar frames en vuelo.
+};
+
+/**
+ * @class ConstantRingAllocator
+ * @brief Reparte un buffer circular en bloques por frame; un frame libera su espacio kFramesInFlight frames después.
+ *
+ * @details
+ * Los bloques se alinean a kAlignment (los offsets de *SetConstantBuffers1
+ * son múltiplos de 16 constantes de 16 bytes). Las asignaciones avanzan la
+ * cabeza; si no caben al final del buffer, el resto se pierde y se sigue
+ * desde el principio (el hueco se carga al frame actual). beginFrame()
+ * libera lo del frame más antiguo en vuelo moviendo la cola. Si no hay
+ * sitio, allocate() falla sin tocar nada y el llamador usa otro camino.
+ *
+ * Solo maneja offsets: no toca el dispositivo.
+ */
+class ConstantRingAllocator {
+public:
+    static const unsigned int kAlignment = 256;     ///< 16 constantes.
+    static const unsigned int kFramesInFlight = 4;  ///< El frame actual y los 3 que DXGI deja encolar.
+
+    /**
+     * @brief Prepara un anillo vacío.
+     * @param capacity Bytes del buffer (se redondea hacia abajo a kAlignment).
+     */
+    void init(unsigned int capacity);
+
+    /** @brief Empieza un frame: libera los bloques del frame de hace kFramesInFlight. */
+    void beginFrame();
+
+    /**
+     * @brief Reserva un bloque en el frame actual.
+     * @param size Bytes pedidos (se redondean a kAlignment).
+     * @param offset Offset en bytes del bloque.
+     * @return false si no cabe sin pisar un frame en vuelo.
+     */
+    bool allocate(unsigned int size, unsigned int& offset);
+
+    /**
+     * @brief Reserva un bloque y lo expresa en constantes de 16 bytes (para *SetConstantBuffers1).
+     * @param size Bytes pedidos (se redondean a kAlignment).
+     * @param offset Offset en bytes del bloque.
+     * @param firstConstant Primera constante del bloque (múltiplo de 16).
+     * @param numConstants Constantes del bloque (múltiplo de 16).
+     * @return false si no cabe sin pisar un frame en vuelo.
+     */
+    bool allocateConstants(unsigned int size, unsigned int& offset, unsigned int& firstConstant, unsigned int& numConstants);
+
+    /** @brief Bytes del buffer. */
+    unsigned int getCapacity() const { return m_capacity; }
+
+    /** @brief Bytes ocupados por los frames en vuelo (incluye alineación y huecos al dar la vuelta). */
+    unsigned int getUsed() const { return m_used; }
+
+    /** @brief Bytes ocupados por el frame actual. */
+    unsigned int getFrameBytes() const { return m_frameBytes[m_frame % kFramesInFlight]; }
+
+    /** @brief Tamaño alineado de un bloque. */
+    static unsigned int align(unsigned int size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+
+private:
+    unsigned int m_capacity = 0;                     ///< Bytes del buffer.
+    unsigned int m_head = 0;                         ///< Siguiente byte libre.
+    unsigned int m_tail = 0;                         ///< Primer byte del frame más antiguo en vuelo.
+    unsigned int m_used = 0;                         ///< Bytes entre la cola y la cabeza.
+    unsigned int m_frame = 0;                        ///< Frame actual.
+    unsigned int m_frameBytes[kFramesInFlight] = {}; ///< Bytes de cada frame en vuelo.
+};
+
+/**
+ * @class ConstantUploadTracker
+ * @brief Recuerda el hash de lo último subido a cada constant buffer para omitir subidas iguales.
+ *
+ * @details Las entradas que no se usan en kEvictFrames frames se descartan.
+ * Mientras un buffer está en la tabla el contexto conserva una referencia,
+ * así su dirección no puede reutilizarse para otro buffer con datos viejos.
+ */
+class ConstantUploadTracker {
+public:
+    static const unsigned int kEvictFrames = 120; ///< Frames sin uso tras los que se olvida un buffer.
+
+    /**
+     * @brief Compara el contenido pedido con el último subido.
+     * @param buffer Buffer de destino.
+     * @param hash Hash del contenido.
+     * @param inserted true si el buffer no estaba en la tabla (el llamador debe retenerlo).
+     * @return true si hay que subir.
+     */
+    bool check(ID3D11Buffer* buffer, uint64_t hash, bool& inserted);
+
+    /**
+     * @brief Avanza de frame y saca los buffers sin uso reciente.
+     * @param evicted Buffers descartados (el llamador suelta su referencia).
+     */
+    void beginFrame(std::vector<ID3D11Buffer*>& evicted);
+
+    /**
+     * @brief Olvida un buffer que se actualizó por otro camino (p. ej. un contexto diferido).
+     * @return true si estaba en la tabla (el llamador suelta su referencia).
+     */
+    bool forget(ID3D11Buffer* buffer) { return m_entries.erase(buffer) > 0; }
+
+    /**
+     * @brief Olvida todos los buffers.
+     * @param released Buffers que estaban en la tabla.
+     */
+    void clear(std::vector<ID3D11Buffer*>& released);
+
+    /** @brief Buffers seguidos. */
+    size_t size() const { return m_entries.size(); }
+
+private:
+    /// Último contenido subido y frame en que se pidió.
+    struct Entry {
+        uint64_t hash;
+        unsigned int lastFrame;
+    };
+
+    std::unordered_map<ID3D11Buffer*, Entry> m_entries; ///< Buffers seguidos.
+    unsigned int m_frame = 0;                           ///< Frame actual.
+};
+
+/**
+ * @class ConstantBufferRing
+ * @brief Un constant buffer dinámico grande del que cada draw toma un bloque y se enlaza por offset.
+ *
+ * @details
+ * Por frame: map() abre el buffer (DISCARD la primera vez, NO_OVERWRITE
+ * después: el asignador garantiza que no se escribe nada que la GPU pueda
+ * estar leyendo), write() copia las constantes de cada draw y devuelve su
+ * rango en constantes, unmap() cierra y el draw se enlaza con
+ * VSSetConstantBuffers1/PSSetConstantBuffers1. Necesita Direct3D 11.1
+ * (offsets en constant buffers y NO_OVERWRITE sobre ellos); sin él init()
+ * falla y las constantes siguen en los buffers de cada objeto.
+ */
+class ConstantBufferRing {
+public:
+    static const unsigned int kDefaultCapacity = 16 * 1024 * 1024; ///< 16384 draws por frame con kFramesInFlight frames en vuelo.
+
+    /**
+     * @brief Crea el buffer si el contexto admite offsets de constantes.
+     * @param device Dispositivo Direct3D.
+     * @param deviceContext Contexto donde se enlazará.
+     * @param capacity Bytes del buffer.
+     * @return HRESULT con el estado de la operación (E_NOTIMPL sin Direct3D 11.1).
+     */
+    HRESULT init(Device& device, DeviceContext& deviceContext, unsigned int capacity = kDefaultCapacity);
+
+    /** @brief Libera el buffer. */
+    void destroy();
+
+    /** @brief true si init() tuvo éxito. */
+    bool isReady() const { return m_buffer != nullptr; }
+
+    /** @brief Empieza un frame en el asignador. */
+    void beginFrame() { m_allocator.beginFrame(); }
+
+    /**
+     * @brief Hace que el siguiente map() use DISCARD: tras frames enviados a otro
+     *        backend el asignador ya no sabe qué bloques puede estar leyendo la GPU.
+     */
+    void discardNextMap() { m_discarded = false; }
+
+    /**
+     * @brief Abre el buffer para escribir.
+     * @param deviceContext Contexto del buffer.
+     * @return false si no está listo o Map falló.
+     */
+    bool map(DeviceContext& deviceContext);
+
+    /**
+     * @brief Copia un bloque de constantes.
+     * @param data Constantes.
+     * @param size Bytes (múltiplo de 16).
+     * @param firstConstant Primera constante del bloque (para *SetConstantBuffers1).
+     * @param numConstants Constantes del bloque (múltiplo de 16).
+     * @return false si no cabe en el frame (el llamador sube las constantes por su cuenta).
+     */
+    bool write(const void* data, unsigned int size, unsigned int& firstConstant, unsigned int& numConstants);
+
+    /**
+     * @brief Cierra el buffer y anota en el contexto lo escrito.
+     * @param deviceContext Contexto del buffer.
+     */
+    void unmap(DeviceContext& deviceContext);
+
+    /** @brief Buffer nativo. */
+    ID3D11Buffer* raw() const { return m_buffer; }
+
+    /** @brief Asignador (ocupación). */
+    const ConstantRingAllocator& getAllocator() const { return m_allocator; }
+
+    /**
+     * @brief Mide en CPU frames sintéticos con actores quietos y en movimiento.
+     * @param draws Draws por frame (p. ej. 10000).
+     * @param frames Frames simulados.
+     */
+    static ConstantRingBenchmark benchmark(unsigned int draws, unsigned int frames);
+
+private:
+    ConstantRingAllocator m_allocator;  ///< Bloques por frame.
+    ID3D11Buffer* m_buffer = nullptr;   ///< Buffer dinámico.
+    unsigned char* m_mapped = nullptr;  ///< Memoria abierta entre map() y unmap().
+    bool m_discarded = false;           ///< Ya se hizo el primer Map con DISCARD.
+    unsigned int m_writes = 0;          ///< Bloques escritos desde map().
+    unsigned int m_writtenBytes = 0;    ///< Bytes copiados desde map().
+};
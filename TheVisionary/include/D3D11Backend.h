@@ -0,0 +1,132 @@
+﻿/**
+ * @file D3D11Backend.h
+ * @brief Backend que envía los comandos a un ID3D11DeviceContext.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "RenderBackend.h"
+
+/**
+ * @class D3D11Backend
+ * @brief Paso directo de RenderBackend a un contexto de Direct3D 11 (inmediato o diferido).
+ *
+ * @details No es dueño del contexto (lo libera DeviceContext); sí de la
+ * interfaz de 11.1 que obtiene enableConstantOffsets().
+ */
+class D3D11Backend : public RenderBackend {
+public:
+    /**
+     * @brief Contexto al que se envían los comandos.
+     * @param context Contexto creado por el dispositivo (nullptr = ninguno).
+     */
+    void attach(ID3D11DeviceContext* context);
+
+    /** @brief Suelta la interfaz de 11.1 y olvida el contexto. */
+    void detach();
+
+    /**
+     * @brief Obtiene la interfaz de 11.1 si el dispositivo admite offsets en constant
+     *        buffers y NO_OVERWRITE sobre ellos.
+     * @param device Dispositivo que creó el contexto.
+     * @return E_NOTIMPL sin soporte o sin VISIONARY_D3D11_1.
+     */
+    HRESULT enableConstantOffsets(ID3D11Device* device);
+
+    const char* getName() const override { return "Direct3D 11"; }
+    bool supportsConstantOffsets() const override;
+
+    void ClearState() override;
+    void RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) override;
+    void PSSetShaderResources(unsigned int StartSlot,
+        unsigned int NumViews,
+        ID3D11ShaderResourceView* const* ppShaderResourceViews) override;
+    void IASetInputLayout(ID3D11InputLayout* pInputLayout) override;
+    void VSSetShader(ID3D11VertexShader* pVertexShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) override;
+    void PSSetShader(ID3D11PixelShader* pPixelShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) override;
+    void UpdateSubresource(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        const BackendBox* pDstBox,
+        const void* pSrcData,
+        unsigned int SrcRowPitch,
+        unsigned int SrcDepthPitch,
+        unsigned int SrcBytes) override;
+    HRESULT Map(ID3D11Resource* pResource,
+        unsigned int Subresource,
+        unsigned int MapType,
+        unsigned int MapFlags,
+        BackendMappedSubresource* pMappedResource) override;
+    void Unmap(ID3D11Resource* pResource, unsigned int Subresource) override;
+    void CopySubresourceRegion(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        unsigned int DstX,
+        unsigned int DstY,
+        unsigned int DstZ,
+        ID3D11Resource* pSrcResource,
+        unsigned int SrcSubresource,
+        const BackendBox* pSrcBox) override;
+    void IASetVertexBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppVertexBuffers,
+        const unsigned int* pStrides,
+        const unsigned int* pOffsets) override;
+    void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+        unsigned int Format,
+        unsigned int Offset) override;
+    void PSSetSamplers(unsigned int StartSlot,
+        unsigned int NumSamplers,
+        ID3D11SamplerState* const* ppSamplers) override;
+    void RSSetState(ID3D11RasterizerState* pRasterizerState) override;
+    void OMSetBlendState(ID3D11BlendState* pBlendState,
+        const float BlendFactor[4],
+        unsigned int SampleMask) override;
+    void OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+        unsigned int StencilRef) override;
+    void OMSetRenderTargets(unsigned int NumViews,
+        ID3D11RenderTargetView* const* ppRenderTargetViews,
+        ID3D11DepthStencilView* pDepthStencilView) override;
+    void IASetPrimitiveTopology(unsigned int Topology) override;
+    void ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+        const float ColorRGBA[4]) override;
+    void ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+        unsigned int ClearFlags,
+        float Depth,
+        uint8_t Stencil) override;
+    void VSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) override;
+    void PSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) override;
+    void VSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) override;
+    void PSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) override;
+    HRESULT FinishCommandList(bool RestoreDeferredContextState,
+        ID3D11CommandList** ppCommandList) override;
+    void ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) override;
+    void DrawIndexed(unsigned int IndexCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation) override;
+    void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+        unsigned int InstanceCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation,
+        unsigned int StartInstanceLocation) override;
+
+private:
+    ID3D11DeviceContext* m_context = nullptr;   ///< Contexto (propiedad de DeviceContext).
+#if defined(VISIONARY_D3D11_1)
+    ID3D11DeviceContext1* m_context1 = nullptr; ///< Mismo contexto con la interfaz de 11.1.
+#endif
+};
@@ -0,0 +1,24 @@
+﻿/**
+ * @file D3DShaderCompiler.h
+ * @brief Compilador de la caché de shaders basado en D3DCompile.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "ShaderCache.h"
+
+/**
+ * @class D3DShaderCompiler
+ * @brief Compila con D3DCompile y resuelve los #include como ShaderCache::resolveInclude.
+ */
+class D3DShaderCompiler : public ShaderCompiler {
+public:
+    bool compile(const ShaderCompileRequest& request,
+        std::vector<char>& bytecode,
+        std::string& errors) override;
+
+    std::string getId() const override;
+
+    /// Opciones de compilación (las mismas que ShaderProgram::CompileShaderFromFile).
+    static UINT getFlags();
+};
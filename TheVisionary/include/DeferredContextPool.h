@@ -0,0 +1,94 @@
+﻿/**
+ * @file DeferredContextPool.h
+ * @brief Contextos diferidos para grabar listas de comandos en paralelo y reparto de la cola entre ellos.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "DeviceContext.h"
+
+class Device;
+
+/**
+ * @struct SubmitChunk
+ * @brief Tramo [begin, end) de la cola ordenada que graba un contexto diferido.
+ */
+struct SubmitChunk {
+    unsigned int begin = 0; ///< Primera entrada.
+    unsigned int end = 0;   ///< Una después de la última.
+};
+
+/**
+ * @class DeferredContextPool
+ * @brief Un contexto diferido por trabajador y la lista de comandos que cierra cada uno.
+ *
+ * @details
+ * Cada contexto graba un tramo contiguo de la cola y execute() ejecuta
+ * las listas en el orden de los tramos, así el resultado es el mismo que
+ * grabar toda la cola en el contexto inmediato. Los contextos diferidos
+ * empiezan cada lista en el estado por defecto: quien graba debe enlazar
+ * antes el estado del frame (render targets, viewport, constantes).
+ *
+ * Sin soporte nativo de listas de comandos el runtime las emula y
+ * ejecutarlas cuesta tanto como grabarlas; hasNativeCommandLists() permite
+ * seguir enviando en el contexto inmediato.
+ */
+class DeferredContextPool {
+public:
+    static const unsigned int kMaxContexts = 8;       ///< Trabajadores como máximo.
+    static const unsigned int kMinChunkPackets = 256; ///< Entradas mínimas por tramo (menos no compensa una lista).
+
+    /**
+     * @brief Crea los contextos diferidos.
+     * @param device Dispositivo (no puede ser de un solo hilo).
+     * @param count Contextos (como máximo kMaxContexts).
+     * @return HRESULT con el estado de la operación.
+     */
+    HRESULT init(Device& device, unsigned int count);
+
+    /** @brief Suelta las listas pendientes y los contextos. */
+    void destroy();
+
+    /** @brief true si hay contextos creados. */
+    bool isReady() const { return !m_contexts.empty(); }
+
+    /** @brief true si el driver ejecuta listas de comandos sin emularlas. */
+    bool hasNativeCommandLists() const { return m_nativeCommandLists; }
+
+    /** @brief Contextos creados. */
+    unsigned int getCount() const { return static_cast<unsigned int>(m_contexts.size()); }
+
+    /** @brief Contexto diferido de un trabajador. */
+    DeviceContext& getContext(unsigned int index) { return m_contexts[index]; }
+
+    /**
+     * @brief Cierra la lista grabada en un contexto (sin conservar su estado).
+     * @param index Contexto.
+     * @return HRESULT de FinishCommandList.
+     */
+    HRESULT finish(unsigned int index);
+
+    /**
+     * @brief Ejecuta en orden las listas de los primeros contextos y las suelta.
+     * @param deviceContext Contexto inmediato (queda en el estado por defecto).
+     * @param count Contextos que grabaron este envío.
+     */
+    void execute(DeviceContext& deviceContext, unsigned int count);
+
+    /**
+     * @brief Reparte entradas consecutivas en tramos de coste parecido.
+     * @param costs Coste de cada entrada (p. ej. draws que emite), en orden de envío.
+     * @param parts Tramos deseados.
+     * @param minChunk Entradas mínimas por tramo.
+     * @param chunks Recibe los tramos, contiguos y en orden (vacío si no hay entradas).
+     */
+    static void partition(const std::vector<unsigned int>& costs,
+        unsigned int parts,
+        unsigned int minChunk,
+        std::vector<SubmitChunk>& chunks);
+
+private:
+    std::vector<DeviceContext> m_contexts;      ///< Un contexto diferido por trabajador.
+    std::vector<ID3D11CommandList*> m_lists;    ///< Lista cerrada de cada contexto.
+    bool m_nativeCommandLists = false;          ///< DriverCommandLists de D3D11_FEATURE_THREADING.
+};
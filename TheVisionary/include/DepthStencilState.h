@@ -51,6 +51,9 @@ public:
      */
     void destroy();
 
+    /// @return Puntero nativo al estado de profundidad/stencil.
+    ID3D11DepthStencilState* raw() const { return m_depthStencilState; }
+
 private:
     ID3D11DepthStencilState* m_depthStencilState = nullptr; ///< Puntero al estado de profundidad/stencil de Direct3D.
 };
@@ -5,6 +5,10 @@
 
 #pragma once
 #include "Prerequisites.h"
+#include "ObjectCache.h"
+#include <memory>
+
+class ShaderCache;
 
  /**
   * @class Device
@@ -65,22 +69,29 @@ public:
         const D3D11_SUBRESOURCE_DATA* pInitialData,
         ID3D11Buffer** ppBuffer);
 
-    /** Crea un estado de muestreo (sampler). */
+    /** Crea un estado de muestreo (sampler); los descriptores repetidos comparten objeto. */
     HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
         ID3D11SamplerState** ppSamplerState);
 
-    /** Crea un estado de mezcla (blend). */
+    /** Crea un estado de mezcla (blend); los descriptores repetidos comparten objeto. */
     HRESULT CreateBlendState(const D3D11_BLEND_DESC* pBlendStateDesc,
         ID3D11BlendState** ppBlendState);
 
-    /** Crea un estado de depth/stencil. */
+    /** Crea un estado de depth/stencil; los descriptores repetidos comparten objeto. */
     HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC* pDepthStencilDesc,
         ID3D11DepthStencilState** ppDepthStencilState);
 
-    /** Crea un estado de rasterizado. */
+    /** Crea un estado de rasterizado; los descriptores repetidos comparten objeto. */
     HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC* pRasterizerDesc,
         ID3D11RasterizerState** ppRasterizerState);
 
+    /** Crea un contexto diferido (graba listas de comandos desde otro hilo). */
+    HRESULT CreateDeferredContext(ID3D11DeviceContext** ppDeferredContext);
+
 public:
     ID3D11Device* m_device = nullptr; ///< Puntero al dispositivo Direct3D 11.
+    /// Estados y shaders compartidos (las copias de Device usan la misma cach).
+    std::shared_ptr<ObjectCache> m_cache = std::make_shared<ObjectCache>();
+    /// Bytecode de los shaders en disco (nullptr = se compila siempre).
+    std::shared_ptr<ShaderCache> m_shaderCache;
 };
@@ -5,6 +5,12 @@
 
 #pragma once
 #include "Prerequisites.h"
+#include "StateCache.h"
+#include "ConstantBufferRing.h"
+#include "D3D11Backend.h"
+
+class Device;
+class CaptureBackend;
 
  /**
   * @class DeviceContext
@@ -17,7 +23,7 @@ public:
     /** Destructor por defecto. */
     ~DeviceContext() = default;
 
-    /** Inicializa el contexto. */
+    /** Conecta el backend de Direct3D 11 a m_deviceContext (llamar despus de crearlo). */
     void init();
     /** Actualiza el estado del contexto. */
     void update();
@@ -26,6 +32,87 @@ public:
     /** Libera los recursos. */
     void destroy();
 
+    /** Cierra los contadores de llamadas del frame anterior y olvida el estado enlazado. */
+    void beginFrame();
+
+    /**
+     * Olvida el estado enlazado; necesario tras tocar m_deviceContext directamente
+     * (ImGui, ClearState) para que la cach no descarte llamadas que s cambian algo.
+     */
+    void invalidateState();
+
+    /**
+     * Cambia el destino de los comandos (p. ej. un NullBackend para medir sin GPU).
+     * nullptr vuelve a Direct3D 11. Olvida el estado enlazado y lo seguido de las
+     * subidas: lo que recibi un backend no est en el otro.
+     */
+    void setBackend(RenderBackend* backend);
+
+    /** Destino actual de los comandos. */
+    RenderBackend& getBackend() { return m_backend ? *m_backend : m_d3d11; }
+
+    /** true si los comandos llegan a algn sitio: un contexto nativo u otro backend (sin dispositivo). */
+    bool hasTarget() const { return m_deviceContext || m_backend; }
+
+    /**
+     * Empieza a capturar: los comandos pasan por capture, que los graba con sus
+     * datos, antes de llegar al backend actual. Como setBackend(), olvida el
+     * estado enlazado y las subidas, as el primer frame capturado lo enva todo.
+     */
+    void beginCapture(CaptureBackend& capture);
+
+    /** Termina la captura y vuelve al backend de antes. */
+    void endCapture();
+
+    /** Captura en curso (nullptr = ninguna). */
+    CaptureBackend* getCapture() const { return m_capture; }
+
+    /**
+     * Olvida el estado enlazado y lo seguido de las subidas; necesario tras enviar
+     * comandos a getBackend() sin pasar por el contexto (p. ej. al reproducir una captura).
+     */
+    void resetTracking();
+
+    /** Llamadas enviadas y descartadas del ltimo frame completo. */
+    const StateCacheStats& getStateStats() const { return m_stateCache.getFrameStats(); }
+
+    /** Constantes subidas en el ltimo frame completo. */
+    const ConstantUploadStats& getUploadStats() const { return m_lastUploads; }
+
+    /**
+     * Obtiene el contexto de Direct3D 11.1 si el dispositivo admite offsets en
+     * constant buffers y NO_OVERWRITE sobre ellos. Sin VISIONARY_D3D11_1
+     * (headers del Windows SDK) devuelve E_NOTIMPL.
+     */
+    HRESULT enableConstantOffsets(Device& device);
+
+    /** true si el backend admite offsets en constant buffers (en Direct3D 11, si enableConstantOffsets() tuvo xito). */
+    bool supportsConstantOffsets() const;
+
+    /**
+     * Omite las subidas de constantes cuyo contenido coincide con lo ltimo subido.
+     * Al desactivarlo se olvida lo seguido (las subidas sin seguimiento lo dejaran viejo).
+     */
+    void setSkipUnchangedUploads(bool skip);
+
+    /** true si se omiten las subidas sin cambios. */
+    bool getSkipUnchangedUploads() const { return m_skipUnchangedUploads; }
+
+    /**
+     * Sube un constant buffer completo salvo que su hash coincida con lo ltimo subido a l.
+     * @return true si se llam a UpdateSubresource.
+     */
+    bool UpdateConstantBuffer(ID3D11Buffer* pBuffer, const void* pSrcData, unsigned int ByteWidth);
+
+    /**
+     * Olvida lo subido a unos buffers que otro contexto actualiz (listas de comandos):
+     * la siguiente subida a cada uno no se omite.
+     */
+    void forgetConstantBuffers(const std::vector<ID3D11Buffer*>& buffers);
+
+    /** Anota los bloques copiados a un anillo de constantes entre Map y Unmap. */
+    void recordRingWrites(unsigned int writes, unsigned int bytes);
+
     /** Configura el/los viewport(s). */
     void RSSetViewports(unsigned int NumViewports, const D3D11_VIEWPORT* pViewports);
 
@@ -47,13 +134,34 @@ public:
         ID3D11ClassInstance* const* ppClassInstances,
         unsigned int NumClassInstances);
 
-    /** Actualiza un recurso en GPU. */
+    /** Actualiza un recurso en GPU (SrcBytes: tamao de pSrcData si se conoce, para los backends que lo cuentan). */
     void UpdateSubresource(ID3D11Resource* pDstResource,
         unsigned int DstSubresource,
         const D3D11_BOX* pDstBox,
         const void* pSrcData,
         unsigned int SrcRowPitch,
-        unsigned int SrcDepthPitch);
+        unsigned int SrcDepthPitch,
+        unsigned int SrcBytes = 0);
+
+    /** Abre un recurso para escribir o leer desde la CPU. */
+    HRESULT Map(ID3D11Resource* pResource,
+        unsigned int Subresource,
+        D3D11_MAP MapType,
+        unsigned int MapFlags,
+        D3D11_MAPPED_SUBRESOURCE* pMappedResource);
+
+    /** Cierra un recurso abierto con Map. */
+    void Unmap(ID3D11Resource* pResource, unsigned int Subresource);
+
+    /** Copia una regin de un recurso a otro en la GPU. */
+    void CopySubresourceRegion(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        unsigned int DstX,
+        unsigned int DstY,
+        unsigned int DstZ,
+        ID3D11Resource* pSrcResource,
+        unsigned int SrcSubresource,
+        const D3D11_BOX* pSrcBox);
 
     /** Asigna los vertex buffers. */
     void IASetVertexBuffers(unsigned int StartSlot,
@@ -75,11 +183,18 @@ public:
     /** Define el rasterizer state. */
     void RSSetState(ID3D11RasterizerState* pRasterizerState);
 
-    /** Define el blend state. */
+    /** Devuelve el pipeline al estado por defecto y olvida el estado enlazado. */
+    void ClearState();
+
+    /** Define el blend state (nullptr = estado por defecto). */
     void OMSetBlendState(ID3D11BlendState* pBlendState,
         const float BlendFactor[4],
         unsigned int SampleMask);
 
+    /** Define el depth stencil state (nullptr = estado por defecto). */
+    void OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+        unsigned int StencilRef);
+
     /** Asigna render targets y depth stencil. */
     void OMSetRenderTargets(unsigned int NumViews,
         ID3D11RenderTargetView* const* ppRenderTargetViews,
@@ -108,11 +223,62 @@ public:
         unsigned int NumBuffers,
         ID3D11Buffer* const* ppConstantBuffers);
 
+    /**
+     * Asigna al vertex shader rangos de constant buffers (Direct3D 11.1).
+     * Offset y tamao en constantes de 16 bytes, mltiplos de 16.
+     */
+    void VSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants);
+
+    /** Asigna al pixel shader rangos de constant buffers (Direct3D 11.1). */
+    void PSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants);
+
+    /**
+     * Cierra la lista de comandos grabada en un contexto diferido.
+     * Sin RestoreDeferredContextState el contexto vuelve al estado por defecto.
+     */
+    HRESULT FinishCommandList(bool RestoreDeferredContextState,
+        ID3D11CommandList** ppCommandList);
+
+    /**
+     * Ejecuta en el contexto inmediato una lista de comandos.
+     * Sin RestoreContextState el contexto queda en el estado por defecto (hay que volver a enlazar).
+     */
+    void ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState);
+
     /** Dibuja usando ndices. */
     void DrawIndexed(unsigned int IndexCount,
         unsigned int StartIndexLocation,
         int BaseVertexLocation);
 
+    /** Dibuja usando ndices varias instancias (datos por instancia en los vertex buffers por instancia). */
+    void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+        unsigned int InstanceCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation,
+        unsigned int StartInstanceLocation);
+
 public:
     ID3D11DeviceContext* m_deviceContext = nullptr; ///< Puntero al contexto de dispositivo.
+
+private:
+    StateCache m_stateCache; ///< Estado enlazado conocido (filtra llamadas redundantes).
+    ConstantUploadTracker m_uploadTracker; ///< Hash de lo ltimo subido a cada constant buffer.
+    ConstantUploadStats m_uploads;         ///< Subidas del frame en curso.
+    ConstantUploadStats m_lastUploads;     ///< Subidas del ltimo frame completo.
+    /// Suelta la referencia de los buffers que el seguimiento dej de recordar.
+    void releaseUntracked();
+
+    std::vector<ID3D11Buffer*> m_released; ///< Buffers que el seguimiento dej de retener.
+    bool m_skipUnchangedUploads = true;    ///< Omitir subidas sin cambios.
+    D3D11Backend m_d3d11;                  ///< Envo a m_deviceContext.
+    RenderBackend* m_backend = nullptr;    ///< Otro destino (nullptr = m_d3d11); no es su dueo.
+    CaptureBackend* m_capture = nullptr;   ///< Captura en curso; no es su dueo.
 };
@@ -0,0 +1,267 @@
+﻿/**
+ * @file DynamicAABBTree.h
+ * @brief Árbol dinámico de AABB (BVH incremental) para consultas espaciales de la escena.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "BoundingVolume.h"
+#include <functional>
+
+class JobSystem;
+struct Frustum;
+
+/**
+ * @struct AABB
+ * @brief Caja alineada a los ejes en forma mínimo/máximo.
+ */
+struct AABB {
+    XMFLOAT3 minimum = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Esquina mínima.
+    XMFLOAT3 maximum = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Esquina máxima.
+
+    /// Caja de unos volúmenes centro/semiejes.
+    static AABB fromBounds(const MeshBounds& bounds) {
+        AABB box;
+        box.minimum = XMFLOAT3(bounds.center.x - bounds.extents.x, bounds.center.y - bounds.extents.y, bounds.center.z - bounds.extents.z);
+        box.maximum = XMFLOAT3(bounds.center.x + bounds.extents.x, bounds.center.y + bounds.extents.y, bounds.center.z + bounds.extents.z);
+        return box;
+    }
+
+    /// Caja que contiene a las dos.
+    static AABB combine(const AABB& a, const AABB& b) {
+        AABB box;
+        box.minimum = XMFLOAT3(std::min(a.minimum.x, b.minimum.x), std::min(a.minimum.y, b.minimum.y), std::min(a.minimum.z, b.minimum.z));
+        box.maximum = XMFLOAT3(std::max(a.maximum.x, b.maximum.x), std::max(a.maximum.y, b.maximum.y), std::max(a.maximum.z, b.maximum.z));
+        return box;
+    }
+
+    /// true si other queda por completo dentro.
+    bool contains(const AABB& other) const {
+        return minimum.x <= other.minimum.x && minimum.y <= other.minimum.y && minimum.z <= other.minimum.z &&
+            other.maximum.x <= maximum.x && other.maximum.y <= maximum.y && other.maximum.z <= maximum.z;
+    }
+
+    /// true si las cajas se tocan.
+    bool overlaps(const AABB& other) const {
+        return minimum.x <= other.maximum.x && other.minimum.x <= maximum.x &&
+            minimum.y <= other.maximum.y && other.minimum.y <= maximum.y &&
+            minimum.z <= other.maximum.z && other.minimum.z <= maximum.z;
+    }
+
+    /// Área de la superficie (coste de la heurística SAH).
+    float getSurfaceArea() const {
+        const float dx = maximum.x - minimum.x, dy = maximum.y - minimum.y, dz = maximum.z - minimum.z;
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+/**
+ * @struct ProxyUpdate
+ * @brief Nueva caja de un proxy para DynamicAABBTree::updateProxies().
+ */
+struct ProxyUpdate {
+    int proxy = -1;                                     ///< Proxy a mover.
+    AABB aabb;                                          ///< Caja ajustada nueva.
+    XMFLOAT3 displacement = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Desplazamiento previsto (alarga la caja en esa dirección).
+};
+
+/**
+ * @struct RayHit
+ * @brief Proxy atravesado por un rayo.
+ */
+struct RayHit {
+    unsigned int userData = 0; ///< Dato del proxy.
+    float distance = 0.0f;     ///< Distancia de entrada en su caja ampliada.
+};
+
+/**
+ * @struct DynamicTreeStats
+ * @brief Estado del árbol y coste de la última actualización por lotes.
+ */
+struct DynamicTreeStats {
+    unsigned int proxies = 0;    ///< Hojas del árbol.
+    unsigned int height = 0;     ///< Altura de la raíz.
+    float areaRatio = 0.0f;      ///< Suma de áreas de los nodos internos / área de la raíz (calidad).
+    unsigned int moved = 0;      ///< Proxies recibidos en la última actualización.
+    unsigned int reinserted = 0; ///< Proxies que salieron de su caja ampliada.
+    bool refitted = false;       ///< La última actualización reajustó el árbol en vez de reinsertar.
+    double updateMs = 0.0;       ///< Tiempo de la última actualización.
+};
+
+/**
+ * @struct DynamicTreeBenchmark
+ * @brief Rendimiento del árbol con objetos en movimiento.
+ */
+struct DynamicTreeBenchmark {
+    unsigned int count = 0;         ///< Objetos.
+    unsigned int frames = 0;        ///< Frames de movimiento simulados.
+    unsigned int height = 0;        ///< Altura final.
+    double insertMs = 0.0;          ///< Inserción de todos los objetos.
+    double updateMs = 0.0;          ///< Media por frame de updateProxies() con todos moviéndose.
+    double reinsertedPerFrame = 0.0; ///< Media de reinserciones por frame.
+    unsigned int queries = 0;       ///< Consultas de caja.
+    double queryMs = 0.0;           ///< Tiempo de todas las consultas de caja (un hilo).
+    double batchQueryMs = 0.0;      ///< Las mismas consultas por lotes con el JobSystem.
+    unsigned int rays = 0;          ///< Rayos lanzados.
+    double rayMs = 0.0;             ///< Tiempo de todos los rayos.
+    double frustumMs = 0.0;         ///< Consulta de frustum.
+    unsigned int frustumHits = 0;   ///< Objetos en el frustum.
+};
+
+/**
+ * @class DynamicAABBTree
+ * @brief Árbol binario de AABB ampliadas con inserción SAH, rotaciones y reajuste por lotes.
+ *
+ * @details
+ * Cada objeto es una hoja (proxy) cuya caja se amplía con un margen y con el
+ * desplazamiento previsto, de modo que los movimientos pequeños no tocan el
+ * árbol. Al insertar se baja por el hijo de menor coste de área de superficie
+ * y al subir se aplican rotaciones que mantienen la altura equilibrada.
+ * updateProxies() recibe todos los cambios de un frame: si salen de su caja
+ * pocos proxies se reinsertan; si salen muchos se actualizan las hojas y se
+ * reajustan los nodos internos en una sola pasada.
+ *
+ * Las consultas recorren el árbol con una pila local, así que varias pueden
+ * ejecutarse a la vez mientras nadie lo modifique.
+ */
+class DynamicAABBTree {
+public:
+    static const int kNullNode = -1; ///< Nodo inexistente.
+
+    /// Callback de consulta: recibe el dato del proxy; false detiene la consulta.
+    typedef std::function<bool(unsigned int userData)> QueryCallback;
+
+    /// Callback de rayo: recibe el dato y la distancia de entrada; devuelve la nueva distancia
+    /// máxima (la misma para seguir, menor para recortar, 0 para detener).
+    typedef std::function<float(unsigned int userData, float distance)> RayCallback;
+
+    /**
+     * @brief Constructor.
+     * @param margin Margen con el que se amplían las cajas de las hojas.
+     */
+    explicit DynamicAABBTree(float margin = 0.1f) : m_margin(margin) {}
+
+    /**
+     * @brief Inserta un objeto.
+     * @param aabb Caja ajustada del objeto.
+     * @param userData Dato devuelto por las consultas (p. ej. índice del actor).
+     * @return Identificador del proxy.
+     */
+    int createProxy(const AABB& aabb, unsigned int userData);
+
+    /**
+     * @brief Elimina un objeto.
+     * @param proxy Identificador devuelto por createProxy().
+     */
+    void destroyProxy(int proxy);
+
+    /**
+     * @brief Mueve un objeto.
+     * @param proxy Identificador del proxy.
+     * @param aabb Caja ajustada nueva.
+     * @param displacement Desplazamiento previsto hasta el siguiente movimiento.
+     * @return true si salió de su caja ampliada y se reinsertó.
+     */
+    bool moveProxy(int proxy, const AABB& aabb, const XMFLOAT3& displacement = XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+    /**
+     * @brief Aplica los movimientos de un frame de una vez.
+     * @param updates Cajas nuevas de los proxies que cambiaron.
+     * @param stats Contadores de la actualización (opcional).
+     */
+    void updateProxies(const std::vector<ProxyUpdate>& updates, DynamicTreeStats* stats = nullptr);
+
+    /** @brief Caja ampliada de un proxy. */
+    const AABB& getFatAABB(int proxy) const { return m_nodes[proxy].aabb; }
+
+    /** @brief Dato de usuario de un proxy. */
+    unsigned int getUserData(int proxy) const { return m_nodes[proxy].userData; }
+
+    /** @brief Consulta de caja con callback. */
+    void queryAABB(const AABB& aabb, const QueryCallback& callback) const;
+
+    /** @brief Consulta de caja; los datos se agregan a results. */
+    void queryAABB(const AABB& aabb, std::vector<unsigned int>& results) const;
+
+    /** @brief Consulta de esfera con callback (contra las cajas ampliadas). */
+    void querySphere(const XMFLOAT3& center, float radius, const QueryCallback& callback) const;
+
+    /** @brief Consulta de esfera; los datos se agregan a results. */
+    void querySphere(const XMFLOAT3& center, float radius, std::vector<unsigned int>& results) const;
+
+    /** @brief Consulta de frustum con callback (los subárboles por completo dentro no se vuelven a probar). */
+    void queryFrustum(const Frustum& frustum, const QueryCallback& callback) const;
+
+    /** @brief Consulta de frustum; los datos se agregan a results. */
+    void queryFrustum(const Frustum& frustum, std::vector<unsigned int>& results) const;
+
+    /**
+     * @brief Lanza un rayo con callback.
+     * @param origin Origen.
+     * @param direction Dirección (no necesita estar normalizada; las distancias van en sus unidades).
+     * @param maxDistance Distancia máxima inicial.
+     * @param callback Recibe cada proxy atravesado y puede recortar la distancia.
+     */
+    void raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, const RayCallback& callback) const;
+
+    /**
+     * @brief Lanza un rayo y devuelve todos los proxies atravesados, de más cercano a más lejano.
+     */
+    void raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, std::vector<RayHit>& hits) const;
+
+    /**
+     * @brief Resuelve muchas consultas de caja en paralelo.
+     * @param boxes Cajas de consulta.
+     * @param results Un vector de resultados por caja.
+     * @param jobs Pool (nullptr = un hilo).
+     */
+    void queryAABBBatch(const std::vector<AABB>& boxes,
+        std::vector<std::vector<unsigned int>>& results,
+        JobSystem* jobs) const;
+
+    /** @brief Altura de la raíz (0 con una hoja o vacío). */
+    unsigned int getHeight() const;
+
+    /** @brief Número de proxies. */
+    unsigned int getProxyCount() const { return m_proxyCount; }
+
+    /** @brief Suma de áreas de los nodos internos respecto a la raíz (menor es mejor). */
+    float getAreaRatio() const;
+
+    /** @brief Elimina todos los proxies. */
+    void clear();
+
+    /**
+     * @brief Mide inserción, actualización y consultas con objetos en movimiento.
+     * @param count Objetos (p. ej. 100000).
+     * @param jobs Pool para las consultas por lotes (opcional).
+     */
+    static DynamicTreeBenchmark benchmark(unsigned int count, JobSystem* jobs);
+
+private:
+    /// Nodo del árbol; las hojas tienen child1 == kNullNode.
+    struct Node {
+        AABB aabb;                 ///< Caja (ampliada en las hojas).
+        unsigned int userData = 0; ///< Dato de la hoja.
+        int parent = kNullNode;    ///< Padre, o siguiente libre en la lista de libres.
+        int child1 = kNullNode;    ///< Primer hijo.
+        int child2 = kNullNode;    ///< Segundo hijo.
+        int height = -1;           ///< 0 en hojas, -1 en nodos libres.
+
+        bool isLeaf() const { return child1 == kNullNode; }
+    };
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+    void refitAll();
+    AABB fatten(const AABB& aabb, const XMFLOAT3& displacement) const;
+
+    std::vector<Node> m_nodes;    ///< Almacén de nodos (los libres forman una lista).
+    int m_root = kNullNode;       ///< Raíz.
+    int m_freeList = kNullNode;   ///< Primer nodo libre.
+    unsigned int m_proxyCount = 0; ///< Hojas activas.
+    float m_margin;               ///< Margen de ampliación de las hojas.
+};
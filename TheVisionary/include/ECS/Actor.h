@@ -9,6 +9,15 @@
 #include "BlendState.h"
 #include "ShaderProgram.h"
 #include "DepthStencilState.h"
+#include "Meshlet.h"
+#include "BoundingVolume.h"
+#include <memory>
+
+class OcclusionBuffer;
+class RenderQueue;
+class InstanceBatcher;
+class GeometryHeap;
+struct GeometryRange;
 
 class device;
 class MeshComponent;
@@ -48,6 +57,15 @@ public:
      */
     Actor(Device& device);
 
+    /**
+     * @brief Crea una copia ligera que comparte mallas, texturas, estados y shaders con otro actor.
+     * @param device Dispositivo DirectX (solo para los buffers de constantes propios).
+     * @param source Actor del que se comparten los recursos (con las mallas ya subidas).
+     * @note Pensado para poblar escenas con muchas copias de un modelo; con estados compartidos
+     *       las copias caen en el mismo lote instanciado.
+     */
+    Actor(Device& device, const Actor* source);
+
     /**
      * @brief Destructor virtual.
      */
@@ -61,10 +79,18 @@ public:
     /**
      * @brief Actualiza el actor.
      * @param deltaTime El tiempo transcurrido desde la ltima actualizacin.
-     * @param deviceContext Contexto del dispositivo para operaciones grficas.
+     * @note No usa el contexto: las constantes se suben al dibujar (render() o el envo de la cola).
      */
     void
-        update(float deltaTime, DeviceContext& deviceContext) override;
+        update(float deltaTime) override;
+
+    /**
+     * @brief Coloca la world que se dibuja entre el paso anterior de la simulacin y el actual.
+     * @param alpha Fraccin del siguiente paso ya transcurrida (1 = el ltimo update()).
+     * @note Llamar tras los update() del frame y antes de render() o submit().
+     */
+    void
+        interpolate(float alpha);
 
     /**
      * @brief Renderiza el actor.
@@ -73,6 +99,17 @@ public:
     void
         render(DeviceContext& deviceContext) override;
 
+    /**
+     * @brief Emite un paquete por malla (y otro por su sombra) a la cola de dibujo.
+     * @param queue Cola del frame; los paquetes apuntan a datos del actor vlidos hasta el envo.
+     * @param eye Posicin de la cmara (profundidad de la clave de orden).
+     * @param instances Lotes instanciados del frame: si el actor es instanciable sus mallas van
+     *        ah en lugar de a la cola (nullptr = sin instancing).
+     * @note Requiere el programa de shaders (setShaderProgram).
+     */
+    void
+        submit(RenderQueue& queue, const XMFLOAT3& eye, InstanceBatcher* instances = nullptr);
+
     /**
      * @brief Destruye el actor y libera los recursos asociados.
      */
@@ -87,6 +124,135 @@ public:
     void
         setMesh(Device& device, std::vector<MeshComponent> meshes);
 
+    /**
+     * @brief Usa las mallas, buffers, texturas y programa de otro actor sin copiar sus datos.
+     * @param source Actor con las mallas ya subidas.
+     * @note Los buffers y texturas se comparten con AddRef: cada actor libera su referencia en destroy().
+     *       Los datos de meshlets no se copian (las copias instanciadas dibujan el LOD entero).
+     */
+    void
+        shareResources(const Actor& source);
+
+    /**
+     * @brief Marca el actor como instanciable: se agrupa con los que comparten malla y material.
+     */
+    void
+        setInstanced(bool instanced) { m_instanced = instanced; }
+
+    bool
+        isInstanced() const { return m_instanced; }
+
+    /**
+     * @brief Programa de shaders con el que se dibuja el actor.
+     * @param program Programa que provee los Input Layouts de los formatos compactos
+     *        (sin programa, las mallas compactas se suben como float).
+     */
+    void
+        setShaderProgram(ShaderProgram* program) { m_program = program; }
+
+    /**
+     * @brief Heap donde setMesh() sube las mallas en lugar de crear un par de buffers por malla.
+     * @param heap Heap listo (nullptr = buffers propios).
+     * @note Debe fijarse antes de setMesh(); shareResources() usa el del actor original.
+     */
+    void
+        setGeometryHeap(GeometryHeap* heap) { m_geometryHeap = heap; }
+
+    /**
+     * @brief Elige el LOD de cada malla segn su tamao proyectado (con histresis).
+     * @param eye Posicin de la cmara en mundo.
+     * @param projectionScale Escala vertical de la proyeccin (1 / tan(fovY / 2)).
+     */
+    void
+        updateLOD(const XMFLOAT3& eye, float projectionScale);
+
+    /**
+     * @brief Tringulos que se dibujan con los LOD actuales y con el detalle completo.
+     * @param drawn Tringulos de los LOD seleccionados.
+     * @param full Tringulos del LOD 0.
+     */
+    void
+        getTriangleCounts(unsigned int& drawn, unsigned int& full) const;
+
+    /**
+     * @brief Descarta los meshlets fuera del frustum o de espaldas a la cmara y
+     *        prepara la lista compacta de rangos a dibujar.
+     * @param viewProjection Matriz view * projection de la cmara.
+     * @param eye Posicin de la cmara en mundo.
+     * @note Solo afecta a las mallas que dibujan el LOD 0; llamar tras updateLOD().
+     */
+    void
+        cullMeshlets(const XMMATRIX& viewProjection, const XMFLOAT3& eye);
+
+    /**
+     * @brief Activa o desactiva el culling de meshlets (desactivado se dibuja la malla entera).
+     */
+    void
+        setMeshletCulling(bool enabled) { m_meshletCulling = enabled; }
+
+    /**
+     * @brief Resultado del ltimo culling de meshlets del actor.
+     */
+    const MeshletCullStats&
+        getMeshletStats() const { return m_meshletStats; }
+
+    /**
+     * @brief Volmenes en mundo de todo el actor (unin de sus mallas).
+     * @note Se actualizan en update() solo cuando cambia la matriz del Transform.
+     */
+    const MeshBounds&
+        getWorldBounds() const { return m_worldBounds; }
+
+    /**
+     * @brief Volmenes en mundo de cada malla.
+     */
+    const std::vector<MeshBounds>&
+        getMeshWorldBounds() const { return m_meshWorldBounds; }
+
+    /**
+     * @brief Contador que avanza cada vez que se recalculan los volmenes en mundo.
+     * @note Cubre tanto los cambios del Transform como los de malla (setMesh).
+     */
+    unsigned int
+        getWorldBoundsRevision() const { return m_boundsRevision; }
+
+    /**
+     * @brief Impacto ms cercano de un rayo en mundo contra los tringulos del LOD 0 (BVH de cada malla).
+     * @param origin Origen del rayo en mundo.
+     * @param direction Direccin normalizada en mundo.
+     * @param maxDistance Distancia mxima.
+     * @param distance Distancia al impacto (solo se escribe si lo hay).
+     * @return true si el rayo toca alguna malla antes de maxDistance.
+     */
+    bool
+        intersectRay(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, float& distance);
+
+    /**
+     * @brief Mallas del actor (datos de CPU).
+     */
+    const std::vector<MeshComponent>&
+        getMeshes() const { return *m_meshes; }
+
+    /**
+     * @brief Rasteriza el LOD ms simple de cada malla en el buffer de oclusin.
+     * @param buffer Buffer del frame (ya iniciado con begin()).
+     */
+    void
+        submitOccluder(OcclusionBuffer& buffer);
+
+    /**
+     * @brief Marca el actor como oclusor (se rasteriza en el buffer de oclusin y no se prueba contra l).
+     */
+    void
+        setOccluder(bool occluder) {
+        m_occluder = occluder;
+    }
+
+    bool
+        isOccluder() const {
+        return m_occluder;
+    }
+
     std::string
         getName() {
         return m_name;
@@ -120,14 +286,78 @@ public:
         renderShadow(DeviceContext& deviceContext);
 
 private:
-    std::vector<MeshComponent> m_meshes; ///< Vector de componentes de malla.
+    /**
+     * @brief Enlaza los buffers de una malla y su Input Layout, y ajusta la matriz de mundo
+     *        si la posicin est cuantizada.
+     * @param deviceContext Contexto del dispositivo.
+     * @param index ndice de la malla.
+     * @param cb Constantes base (world ya transpuesto).
+     * @param cbBuffer Buffer donde se suben las constantes.
+     * @param dequantized En entrada/salida: true si cbBuffer tiene una world cuantizada.
+     */
+    void
+        bindMesh(DeviceContext& deviceContext,
+            size_t index,
+            const CBChangesEveryFrame& cb,
+            Buffer& cbBuffer,
+            bool& dequantized);
+
+    /**
+     * @brief Dibuja el rango de ndices del LOD seleccionado de una malla.
+     * @param useMeshlets true para dibujar solo los meshlets visibles del ltimo culling.
+     */
+    void
+        drawMesh(DeviceContext& deviceContext, size_t index, bool useMeshlets);
+
+    /**
+     * @brief Ubicacin de una malla en el heap.
+     * @return false si la malla tiene buffers propios (range queda con desplazamientos 0).
+     */
+    bool
+        getGeometry(size_t index, GeometryRange& range) const;
+
+    /**
+     * @brief Libera los buffers propios y las referencias al heap de las mallas.
+     */
+    void
+        releaseGeometry();
+
+    /**
+     * @brief Lleva los volmenes de las mallas a mundo si la matriz cambi desde la ltima vez.
+     */
+    void
+        updateWorldBounds();
+
+    /**
+     * @brief Matriz que aplana el actor sobre el suelo segn la luz (sombra proyectada).
+     */
+    XMMATRIX
+        getShadowWorld();
+
+    std::shared_ptr<std::vector<MeshComponent>> m_meshes =
+        std::make_shared<std::vector<MeshComponent>>(); ///< Componentes de malla (compartidos con shareResources).
     std::vector<Texture> m_textures; ///< Vector de texturas.
     std::vector<Buffer> m_vertexBuffers; ///< Buffers de vrtices.
     std::vector<Buffer> m_indexBuffers; ///< Buffers de ndices.
+    GeometryHeap* m_geometryHeap = nullptr; ///< Heap de las mallas (nullptr = buffers propios).
+    std::vector<unsigned int> m_geometry; ///< Handle de cada malla en m_geometryHeap (kInvalidHandle = buffers propios).
+    ShaderProgram* m_program = nullptr; ///< Programa principal (Input Layouts por formato).
+    std::vector<MeshBounds> m_meshWorldBounds; ///< Volmenes en mundo de cada malla.
+    MeshBounds m_worldBounds; ///< Unin de los volmenes en mundo de las mallas.
+    unsigned int m_boundsVersion = ~0u; ///< Versin del Transform con la que se calcularon.
+    unsigned int m_boundsRevision = 0; ///< Reclculos de los volmenes en mundo.
+    std::vector<unsigned int> m_meshLODs; ///< LOD seleccionado de cada malla.
+    std::vector<MeshletCuller> m_meshletCullers; ///< Datos SoA de los meshlets de cada malla.
+    std::vector<std::vector<MeshletDrawRange>> m_meshletRanges; ///< Rangos visibles de cada malla.
+    std::vector<unsigned char> m_meshletCulled; ///< 1 si los rangos de la malla son vlidos este frame.
+    MeshletCullStats m_meshletStats; ///< Contadores del ltimo culling de meshlets.
+    bool m_meshletCulling = true; ///< Culling de meshlets activado.
     BlendState m_blendstate;
     Rasterizer m_rasterizer;
     SamplerState m_sampler;
     CBChangesEveryFrame m_model; ///< Constante del buffer para cambios en cada frame.
+    std::vector<CBChangesEveryFrame> m_meshConstants; ///< Constantes de cada malla para la cola (world decuantizada).
+    std::vector<CBChangesEveryFrame> m_shadowConstants; ///< Constantes de la sombra de cada malla para la cola.
     Buffer m_modelBuffer; ///< Buffer del modelo.
 
     // Shadows
@@ -141,4 +371,6 @@ private:
     std::string m_name = "Actor"; ///< Nombre del actor.
     bool castShadow = true; ///< Indica si el actor proyecta sombras.
     bool m_receiveShadow = true; ///< Indica si el actor recibe sombras (para el PS).
+    bool m_occluder = false; ///< Se rasteriza como oclusor en el culling por software.
+    bool m_instanced = false; ///< Se dibuja en lotes instanciados con los actores que comparten malla.
 };
\ No newline at end of file
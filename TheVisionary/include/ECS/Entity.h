@@ -28,7 +28,7 @@ public:
    * @param deltaTime El tiempo transcurrido desde la ltima actualizacin.
    */
   virtual void 
-  update(float deltaTime, DeviceContext& deviceContext) = 0;
+  update(float deltaTime) = 0;
 
   /**
    * @brief Mtodo virtual puro para renderizar el componente.
@@ -11,6 +11,7 @@ public:
                 rotation(), 
                 scale(), 
                 matrix(), 
+                previousMatrix(), 
                 Component(ComponentType::TRANSFORM) {}
 
   // Mtodos para inicializacin, actualizacin, renderizado y destruccin
@@ -19,6 +20,7 @@ public:
   init();
 
   // Actualiza el estado del objeto Transform basado en el tiempo transcurrido
+  // (un paso fijo de la simulacin; la matriz anterior queda en previousMatrix)
   // @param deltaTime: Tiempo transcurrido desde la ltima actualizacin
   void 
   update(float deltaTime) override;
@@ -69,11 +71,23 @@ public:
   void 
   translate(const EU::Vector3& translation);
 
+  // Contador que aumenta cada vez que update() produce una matriz distinta
+  // (permite recalcular datos derivados, como los volmenes en mundo, solo al cambiar)
+  unsigned int
+  getVersion() const { return m_version; }
+
+  // Matriz para dibujar entre el paso anterior y el actual
+  // @param alpha: Fraccin del paso siguiente ya transcurrida (0 = previousMatrix, 1 = matrix)
+  XMMATRIX
+  getInterpolatedMatrix(float alpha) const;
+
 private:
   EU::Vector3 position;  // Posicin del objeto
   EU::Vector3 rotation;  // Rotacin del objeto
   EU::Vector3 scale;     // Escala del objeto
+  unsigned int m_version = 0; // Versin de la matriz
 
 public:
   XMMATRIX matrix;    // Matriz de transformacin
+  XMMATRIX previousMatrix; // Matriz del paso anterior (interpolacin del dibujo)
 };
@@ -0,0 +1,222 @@
+﻿/**
+ * @file FramePacing.h
+ * @brief Reloj monotónico de frame, simulación a paso fijo y ritmo del bucle principal.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <chrono>
+
+/**
+ * @class FrameClock
+ * @brief Reloj monotónico de alta resolución (QueryPerformanceCounter en steady_clock).
+ *
+ * @details
+ * tick() se llama una vez por frame y devuelve lo transcurrido desde el
+ * anterior, recortado a kMaxDelta: tras un breakpoint, un arrastre de la
+ * ventana o un minimizado la simulación no intenta recuperar segundos.
+ */
+class FrameClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static const double kMaxDelta; ///< Delta máximo de un frame (s).
+
+    /** @brief Empieza a contar desde ahora (el siguiente tick() devuelve lo transcurrido desde aquí). */
+    void reset();
+
+    /**
+     * @brief Marca un frame.
+     * @param now Instante del frame.
+     * @return Segundos desde el tick anterior (0 en el primero), como mucho kMaxDelta.
+     */
+    double tick(Clock::time_point now);
+
+    /** @brief tick() con el instante actual. */
+    double tick() { return tick(Clock::now()); }
+
+    /** @brief Delta del último tick() (recortado). */
+    double getDelta() const { return m_delta; }
+
+    /** @brief Delta del último tick() sin recortar. */
+    double getRawDelta() const { return m_rawDelta; }
+
+    /** @brief Suma de los deltas recortados desde reset(). */
+    double getTotal() const { return m_total; }
+
+private:
+    Clock::time_point m_last;    ///< Instante del último tick().
+    bool m_started = false;      ///< m_last es válido.
+    double m_delta = 0.0;        ///< Último delta recortado.
+    double m_rawDelta = 0.0;     ///< Último delta sin recortar.
+    double m_total = 0.0;        ///< Tiempo acumulado.
+};
+
+/**
+ * @class FixedTimestep
+ * @brief Acumulador de la simulación a paso fijo con fracción para interpolar el dibujo.
+ *
+ * @details
+ * advance() suma el delta del frame y devuelve cuántos pasos enteros caben;
+ * lo que sobra queda para el siguiente frame y getAlpha() dice qué fracción
+ * de paso representa. El dibujo interpola entre el estado anterior y el
+ * actual con esa fracción, así el movimiento es continuo aunque el frame
+ * no coincida con el paso. Con más de maxSteps pendientes (un frame muy
+ * lento) el exceso se descarta en lugar de encadenar frames cada vez más
+ * lentos.
+ */
+class FixedTimestep {
+public:
+    /** @brief Constructor: 60 Hz y hasta 8 pasos por frame. */
+    FixedTimestep() { reset(); }
+
+    /** @brief Vacía el acumulador; el siguiente advance() simula al menos un paso. */
+    void reset();
+
+    /**
+     * @brief Cambia el paso.
+     * @param step Segundos por paso (se limita a [1/1000, 1/10]).
+     */
+    void setStep(double step);
+
+    /** @brief Segundos por paso. */
+    double getStep() const { return m_step; }
+
+    /** @brief Pasos máximos por frame (al menos 1). */
+    void setMaxSteps(unsigned int maxSteps) { m_maxSteps = maxSteps > 0 ? maxSteps : 1; }
+
+    /** @brief Pasos máximos por frame. */
+    unsigned int getMaxSteps() const { return m_maxSteps; }
+
+    /**
+     * @brief Acumula el delta de un frame.
+     * @param delta Segundos del frame.
+     * @return Pasos a simular este frame (0..maxSteps).
+     */
+    unsigned int advance(double delta);
+
+    /** @brief Fracción del siguiente paso ya transcurrida, en [0, 1). */
+    float getAlpha() const { return static_cast<float>(m_accumulator / m_step); }
+
+    /** @brief Pasos simulados desde reset(). */
+    uint64_t getSteps() const { return m_steps; }
+
+    /** @brief Segundos descartados por superar maxSteps desde reset(). */
+    double getDroppedTime() const { return m_dropped; }
+
+private:
+    double m_step = 1.0 / 60.0;       ///< Segundos por paso.
+    unsigned int m_maxSteps = 8;      ///< Pasos máximos por frame.
+    double m_accumulator = 0.0;       ///< Tiempo aún no simulado.
+    uint64_t m_steps = 0;             ///< Pasos simulados.
+    double m_dropped = 0.0;           ///< Tiempo descartado.
+};
+
+/**
+ * @struct FramePacingSettings
+ * @brief Límites del bucle principal.
+ */
+struct FramePacingSettings {
+    int maxFps = 144;              ///< Frames por segundo con foco (0 = sin límite).
+    int unfocusedFps = 15;         ///< Frames por segundo sin foco (0 = como con foco).
+    float spinMs = 1.5f;           ///< Final de la espera hecho en activo (precisión del temporizador).
+    bool throttleUnfocused = true; ///< Bajar a unfocusedFps sin foco.
+    bool pauseMinimized = true;    ///< Minimizada no simula ni dibuja: espera mensajes.
+};
+
+/**
+ * @struct FramePacingStats
+ * @brief Medias de una ventana de kWindow segundos del bucle principal.
+ */
+struct FramePacingStats {
+    unsigned int frames = 0;       ///< Frames de la ventana (0 = aún no hay una completa).
+    double frameMs = 0.0;          ///< Media entre dos frames.
+    double minFrameMs = 0.0;       ///< El frame más corto.
+    double maxFrameMs = 0.0;       ///< El frame más largo.
+    double varianceMs2 = 0.0;      ///< Varianza del frame (ms^2).
+    double stdDevMs = 0.0;         ///< Desviación típica del frame.
+    double busyMs = 0.0;           ///< Media de update() y render() por frame.
+    double sleepMs = 0.0;          ///< Media dormida por frame.
+    double spinMs = 0.0;           ///< Media en espera activa por frame.
+    unsigned int lateFrames = 0;   ///< Frames que llegaron después de su plazo.
+    double idleMs = 0.0;           ///< Total de la ventana esperando mensajes (minimizada).
+    double processCpu = 0.0;       ///< CPU del proceso sobre todos los núcleos (%).
+    double mainThreadCpu = 0.0;    ///< CPU del hilo principal sobre un núcleo (%).
+    unsigned int cores = 0;        ///< Núcleos lógicos.
+};
+
+/**
+ * @class FramePacer
+ * @brief Limita los frames por segundo con espera en dos fases y mide el ritmo y la CPU.
+ *
+ * @details
+ * El plazo de cada frame se cuenta desde el plazo del anterior (no desde
+ * que acabó), así el error de una espera no se acumula. La espera duerme
+ * con un temporizador de alta resolución hasta spinMs antes del plazo y
+ * termina en activo: dormir solo se pasa de largo (la granularidad del
+ * planificador ronda 1-16 ms) y girar solo quema un núcleo. Un frame que
+ * llega tarde mueve el plazo a ahora en lugar de intentar recuperar.
+ */
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static const double kWindow; ///< Segundos por ventana de estadísticas.
+
+    /** @brief Destructor: libera el temporizador. */
+    ~FramePacer();
+
+    /**
+     * @brief Duración objetivo de un frame según el estado de la ventana.
+     * @param settings Límites.
+     * @param focused La ventana tiene el foco.
+     * @return Segundos por frame (0 = sin límite).
+     */
+    static double getTargetSeconds(const FramePacingSettings& settings, bool focused);
+
+    /**
+     * @brief Cierra el frame: espera hasta su plazo y lo anota.
+     * @param targetSeconds Duración objetivo (0 = no esperar).
+     * @param spinMs Final de la espera hecho en activo.
+     */
+    void pace(double targetSeconds, float spinMs);
+
+    /**
+     * @brief Espera mensajes de la ventana sin simular ni dibujar (minimizada).
+     * @param timeoutMs Espera máxima.
+     */
+    void idle(unsigned int timeoutMs);
+
+    /** @brief Última ventana completa. */
+    const FramePacingStats& getStats() const { return m_stats; }
+
+private:
+    /** @brief Duerme aproximadamente seconds (temporizador de alta resolución si lo hay). */
+    void sleepFor(double seconds);
+
+    /** @brief Publica la ventana si pasaron kWindow segundos. */
+    void flushWindow(Clock::time_point now);
+
+    HANDLE m_timer = nullptr;           ///< Temporizador de espera (creado en la primera).
+    bool m_timerTried = false;          ///< Ya se intentó crear m_timer.
+    Clock::time_point m_deadline;       ///< Plazo del frame en curso.
+    bool m_hasDeadline = false;         ///< m_deadline es válido.
+    Clock::time_point m_lastFrame;      ///< Fin del frame anterior.
+    bool m_hasFrame = false;            ///< m_lastFrame es válido.
+
+    FramePacingStats m_stats;           ///< Última ventana completa.
+    Clock::time_point m_windowStart;    ///< Comienzo de la ventana en curso.
+    bool m_windowStarted = false;       ///< m_windowStart y los tiempos de CPU son válidos.
+    uint64_t m_processCpuStart = 0;     ///< CPU del proceso al comenzar la ventana (100 ns).
+    uint64_t m_threadCpuStart = 0;      ///< CPU del hilo principal al comenzar la ventana (100 ns).
+    unsigned int m_frames = 0;          ///< Frames de la ventana en curso.
+    unsigned int m_late = 0;            ///< Frames tarde en la ventana.
+    double m_frameSum = 0.0;            ///< Suma de frames (ms).
+    double m_frameSquares = 0.0;        ///< Suma de cuadrados (ms^2).
+    double m_frameMin = 0.0;            ///< Frame más corto.
+    double m_frameMax = 0.0;            ///< Frame más largo.
+    double m_busySum = 0.0;             ///< Suma de trabajo.
+    double m_sleepSum = 0.0;            ///< Suma dormida.
+    double m_spinSum = 0.0;             ///< Suma en activo.
+    double m_idleSum = 0.0;             ///< Suma esperando mensajes.
+};
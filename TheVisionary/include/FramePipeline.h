@@ -0,0 +1,249 @@
+﻿/**
+ * @file FramePipeline.h
+ * @brief Paquetes de frame inmutables, buzón triple entre simulación y render, y el hilo que los dibuja.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "ConstantBufferRing.h"
+#include "StateCache.h"
+#include "UserInterface.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/**
+ * @struct FrameLatencyStats
+ * @brief Medias de una ventana de frames presentados.
+ */
+struct FrameLatencyStats {
+    unsigned int frames = 0;    ///< Frames de la ventana (0 = aún no hay una completa).
+    double frameMs = 0.0;       ///< Media entre dos Present.
+    double maxFrameMs = 0.0;    ///< El intervalo más largo.
+    double latencyMs = 0.0;     ///< Media desde la lectura de la entrada hasta la vuelta de Present.
+    double maxLatencyMs = 0.0;  ///< La latencia más alta.
+    double updateMs = 0.0;      ///< Simulación media (update() y, con hilo de render, el paquete).
+    double renderMs = 0.0;      ///< Envío y Present medios.
+    unsigned int dropped = 0;   ///< Paquetes sustituidos por uno más nuevo sin llegar a dibujarse.
+};
+
+/**
+ * @class FrameLatencyTracker
+ * @brief Acumula frames presentados y publica sus medias cada kWindow frames.
+ */
+class FrameLatencyTracker {
+public:
+    static const unsigned int kWindow = 120; ///< Frames por ventana.
+
+    /**
+     * @brief Anota un frame presentado.
+     * @param inputTime Lectura de la entrada del frame (comienzo de su update()).
+     * @param presentTime Vuelta de su Present.
+     * @param updateMs Simulación del frame.
+     * @param renderMs Envío y Present del frame.
+     */
+    void addFrame(std::chrono::steady_clock::time_point inputTime,
+        std::chrono::steady_clock::time_point presentTime,
+        double updateMs,
+        double renderMs);
+
+    /** @brief Anota paquetes que no llegaron a dibujarse. */
+    void addDropped(unsigned int count) { m_dropped += count; }
+
+    /** @brief Olvida la ventana en curso y el último Present (conserva la última completa). */
+    void reset();
+
+    /** @brief Última ventana completa. */
+    const FrameLatencyStats& getStats() const { return m_stats; }
+
+private:
+    FrameLatencyStats m_stats;                             ///< Última ventana completa.
+    unsigned int m_frames = 0;                             ///< Frames de la ventana en curso.
+    unsigned int m_intervals = 0;                          ///< Intervalos entre Present medidos.
+    unsigned int m_dropped = 0;                            ///< Descartados en la ventana en curso.
+    double m_frameSum = 0.0;                               ///< Suma de intervalos.
+    double m_frameMax = 0.0;                               ///< Intervalo más largo.
+    double m_latencySum = 0.0;                             ///< Suma de latencias.
+    double m_latencyMax = 0.0;                             ///< Latencia más alta.
+    double m_updateSum = 0.0;                              ///< Suma de simulación.
+    double m_renderSum = 0.0;                              ///< Suma de envío y Present.
+    std::chrono::steady_clock::time_point m_lastPresent;   ///< Present anterior.
+    bool m_hasPresent = false;                             ///< m_lastPresent es válido.
+};
+
+/**
+ * @struct FrameRenderResult
+ * @brief Lo que el hilo de render deja de un frame para los paneles de la simulación.
+ */
+struct FrameRenderResult {
+    RenderQueueStats queue;        ///< Orden y envío de la cola.
+    StateCacheStats state;         ///< Llamadas del contexto enviadas y descartadas.
+    ConstantUploadStats uploads;   ///< Subidas de constantes del último frame completo.
+    ConstantRingAllocator ring;    ///< Ocupación del anillo de constantes tras el envío.
+    InstancingStats instancing;    ///< Subida de las instancias (capacity y uploadMs).
+};
+
+/**
+ * @struct FramePacket
+ * @brief Todo lo que el render necesita de un frame, sin punteros a datos de la simulación.
+ *
+ * @details
+ * La simulación lo llena y lo publica; desde entonces no lo vuelve a tocar
+ * hasta que el buzón se lo devuelve para otro frame. Los paquetes de la
+ * cola llevan sus constantes y rangos de meshlets copiados
+ * (RenderQueue::retainPayloads) y las instancias viajan empaquetadas: el
+ * buffer de instancias es uno solo y se sube en el hilo de render. Los
+ * objetos nativos (buffers, vistas, estados) solo se referencian; quien los
+ * libere debe esperar antes a que el render termine (RenderThread::drain).
+ */
+struct FramePacket {
+    uint64_t frame = 0;                          ///< Frame de la simulación.
+    XMFLOAT4X4 view;                             ///< Vista de la cámara.
+    XMFLOAT4X4 projection;                       ///< Proyección.
+    XMFLOAT3 eye = XMFLOAT3(0.0f, 0.0f, 0.0f);   ///< Posición de la cámara.
+    RenderQueue queue;                           ///< Paquetes de los actores (sin ordenar).
+    std::vector<InstanceBatch> batches;          ///< Lotes instanciados (el buffer se pone al subir).
+    std::vector<InstanceData> instances;         ///< Instancias empaquetadas en orden de lote.
+    bool useConstantRing = false;                ///< Enviar las constantes por el anillo.
+    UiDrawSnapshot ui;                           ///< Listas de dibujo de ImGui del frame.
+    std::chrono::steady_clock::time_point inputTime; ///< Lectura de la entrada (comienzo del update()).
+    double updateMs = 0.0;                       ///< Simulación del frame, paquete incluido.
+    FrameRenderResult result;                    ///< Lo escribe el hilo de render.
+};
+
+/**
+ * @class FrameMailbox
+ * @brief Buzón de tres paquetes: uno lo escribe la simulación, otro espera y otro lo dibuja el render.
+ *
+ * @details
+ * Publicar intercambia el paquete escrito con el que espera y tomar
+ * intercambia el que espera con el que se dibujaba, así ningún lado espera
+ * al otro para seguir trabajando: si el render no tomó el anterior, el
+ * nuevo lo sustituye (el más reciente gana y publish() lo cuenta).
+ * Quien no quiera descartar frames espera antes con waitForSlot().
+ */
+class FrameMailbox {
+public:
+    /** @brief Paquete que llena la simulación (suyo hasta publish()). */
+    FramePacket& getWriteSlot() { return m_slots[m_write]; }
+
+    /**
+     * @brief Publica el paquete escrito y pasa a escribir en otro libre.
+     * @return true si sustituyó a un paquete que no se llegó a tomar.
+     */
+    bool publish();
+
+    /**
+     * @brief Espera a que el render tome el paquete publicado.
+     * @param timeoutMs Espera máxima.
+     * @return true si se puede publicar sin descartar nada.
+     */
+    bool waitForSlot(unsigned int timeoutMs);
+
+    /**
+     * @brief Render: espera un paquete nuevo y lo toma.
+     * @return Paquete (suyo hasta release()), o nullptr si el buzón se cerró y no queda nada publicado.
+     */
+    FramePacket* acquire();
+
+    /** @brief Render: terminó con el paquete de acquire(). */
+    void release();
+
+    /** @brief Espera a que no quede nada publicado ni en dibujo. */
+    void waitIdle();
+
+    /** @brief acquire() deja de esperar: devuelve lo publicado y después nullptr. */
+    void close();
+
+    /** @brief Vuelve a aceptar paquetes tras close(). */
+    void open();
+
+private:
+    FramePacket m_slots[3];                 ///< Los tres paquetes.
+    unsigned int m_write = 0;               ///< El que escribe la simulación.
+    unsigned int m_ready = 1;               ///< El último publicado.
+    unsigned int m_read = 2;                ///< El que dibuja el render.
+    bool m_fresh = false;                   ///< m_ready no se tomó todavía.
+    bool m_busy = false;                    ///< El render tiene m_read.
+    bool m_closed = false;                  ///< close() sin open().
+    std::mutex m_mutex;                     ///< Protege índices y banderas.
+    std::condition_variable m_changed;      ///< Cambió algo de lo anterior.
+};
+
+/**
+ * @class RenderThread
+ * @brief Hilo que dibuja los paquetes del buzón mientras la simulación prepara el siguiente.
+ *
+ * @details
+ * Reglas de propiedad mientras está en marcha:
+ * - El hilo de render es el único que usa el contexto inmediato, la
+ *   swapchain y el backend DX11 de ImGui (solo sobre las copias del paquete).
+ * - La simulación es dueña del contexto de ImGui (NewFrame, ventanas y
+ *   Render), de los actores y de las colas que llena; no llama al contexto
+ *   inmediato salvo tras drain() y hasta el siguiente publish().
+ * - Lo que comparten viaja en el paquete; los contadores del render
+ *   vuelven con getLastResult().
+ */
+class RenderThread {
+public:
+    /** Dibuja un paquete en el hilo de render (envío, ImGui y Present). */
+    using RenderFunction = std::function<void(FramePacket&)>;
+
+    /** @brief Destructor: dibuja lo publicado y une el hilo. */
+    ~RenderThread() { stop(); }
+
+    /**
+     * @brief Arranca el hilo.
+     * @param render Función que dibuja cada paquete.
+     */
+    void start(RenderFunction render);
+
+    /** @brief Dibuja lo publicado y une el hilo. */
+    void stop();
+
+    /** @brief true entre start() y stop(). */
+    bool isRunning() const { return m_thread.joinable(); }
+
+    /** @brief Paquete que llena la simulación para el siguiente publish(). */
+    FramePacket& beginPacket() { return m_mailbox.getWriteSlot(); }
+
+    /** @brief Publica el paquete de beginPacket() (sustituye al anterior si no se tomó). */
+    void publish();
+
+    /**
+     * @brief Espera a que el render tome el paquete publicado.
+     * @param timeoutMs Espera máxima (corta para seguir atendiendo los mensajes de la ventana).
+     * @return true si publish() no descartaría nada.
+     */
+    bool waitForSlot(unsigned int timeoutMs) { return m_mailbox.waitForSlot(timeoutMs); }
+
+    /**
+     * @brief Espera a que se dibuje todo lo publicado.
+     * @note Hasta el siguiente publish() el contexto inmediato y los objetos que
+     *       referencian los paquetes vuelven a ser de quien llama.
+     */
+    void drain();
+
+    /** @brief Última ventana de tiempos del hilo de render. */
+    FrameLatencyStats getStats() const;
+
+    /** @brief Contadores del último frame dibujado. */
+    FrameRenderResult getLastResult() const;
+
+private:
+    /** @brief Bucle del hilo: toma, dibuja y mide hasta que se cierra el buzón. */
+    void threadLoop();
+
+    FrameMailbox m_mailbox;                  ///< Paquetes entre los dos hilos.
+    std::thread m_thread;                    ///< Hilo de render.
+    RenderFunction m_render;                 ///< Dibuja un paquete.
+    std::atomic<unsigned int> m_dropped{ 0 }; ///< Descartes aún no llevados a m_tracker.
+    mutable std::mutex m_statsMutex;         ///< Protege m_tracker y m_result.
+    FrameLatencyTracker m_tracker;           ///< Tiempos de los frames dibujados.
+    FrameRenderResult m_result;              ///< Contadores del último frame.
+};
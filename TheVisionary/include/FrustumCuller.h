@@ -0,0 +1,149 @@
+﻿/**
+ * @file FrustumCuller.h
+ * @brief Planos del frustum y culling SoA de volúmenes en mundo, en bloques paralelos.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "BoundingVolume.h"
+
+class JobSystem;
+
+/**
+ * @struct Frustum
+ * @brief Seis planos normalizados con la normal hacia el interior.
+ */
+struct Frustum {
+    XMFLOAT4 planes[6]; ///< Izquierdo, derecho, inferior, superior, cercano y lejano (a, b, c, d).
+
+    /**
+     * @brief Extrae los planos de una matriz de vista-proyección (vectores fila, z de D3D en [0, w]).
+     * @param matrix view * projection; con world * view * projection los planos quedan en espacio del objeto.
+     */
+    static Frustum fromMatrix(const XMMATRIX& matrix);
+};
+
+/**
+ * @struct FrustumCullStats
+ * @brief Resultado de una pasada de culling.
+ */
+struct FrustumCullStats {
+    unsigned int tested = 0;   ///< Volúmenes evaluados.
+    unsigned int visible = 0;  ///< Volúmenes dentro del frustum.
+    unsigned int chunks = 0;   ///< Bloques en que se repartió el trabajo.
+    double milliseconds = 0.0; ///< Tiempo total de la pasada.
+
+    /// Volúmenes descartados.
+    unsigned int getCulled() const { return tested - visible; }
+};
+
+/**
+ * @struct FrustumCullBenchmark
+ * @brief Tiempos de culling sobre una escena sintética.
+ */
+struct FrustumCullBenchmark {
+    unsigned int count = 0;    ///< Volúmenes de la escena.
+    unsigned int visible = 0;  ///< Visibles desde la cámara de prueba.
+    unsigned int threads = 0;  ///< Hilos usados en la versión paralela (incluye el que llama).
+    bool avx = false;          ///< La CPU admite el camino AVX (avxMs y parallelMs lo usan).
+    double serialMs = 0.0;     ///< Media por pasada en un hilo, camino SSE de 4 carriles.
+    double avxMs = 0.0;        ///< Media por pasada en un hilo, camino AVX de 8 carriles (0 sin AVX).
+    double parallelMs = 0.0;   ///< Media por pasada con el JobSystem y el camino más ancho.
+    bool pathsMatch = false;   ///< SSE y AVX dan la misma lista de visibles.
+};
+
+/**
+ * @class FrustumCuller
+ * @brief Prueba AABB en mundo contra el frustum, ocho volúmenes por instrucción con AVX o cuatro con SSE.
+ *
+ * @details
+ * Los volúmenes se guardan en grupos SoA de ocho (centro y semiejes por
+ * componente). Con AVX cada plano se evalúa sobre las ocho cajas de un
+ * grupo en un registro de 256 bits; sin AVX (o con setUseAVX(false)) sobre
+ * cada mitad con XMVECTOR. El camino se elige en tiempo de ejecución con
+ * CPUID y XGETBV, así el ejecutable sigue funcionando en CPUs sin AVX. Los
+ * dos caminos hacen las mismas operaciones en el mismo orden y dan la misma
+ * lista. Una caja queda fuera si, para algún plano,
+ * dot(n, c) + d < -(|n| · e). La lista de visibles sale compacta y en el
+ * orden original; con un JobSystem se reparte en bloques de kChunkSize con
+ * una salida por bloque que luego se concatena.
+ */
+class FrustumCuller {
+public:
+    /// Volúmenes por grupo SoA (un registro AVX, dos de SSE).
+    static const unsigned int kGroupWidth = 8;
+
+    /// Volúmenes por bloque paralelo (múltiplo de kGroupWidth).
+    static const unsigned int kChunkSize = 4096;
+
+    /** @brief Constructor: usa AVX si la CPU y el sistema lo admiten. */
+    FrustumCuller() : m_useAVX(isAVXSupported()) {}
+
+    /** @brief true si la CPU admite AVX y el sistema guarda sus registros (se consulta una vez). */
+    static bool isAVXSupported();
+
+    /**
+     * @brief Elige el camino de ocho carriles (AVX) o el de cuatro (SSE).
+     * @param enabled true para AVX; sin soporte se queda en SSE.
+     */
+    void setUseAVX(bool enabled) { m_useAVX = enabled && isAVXSupported(); }
+
+    /// true si cull() usa el camino AVX.
+    bool isUsingAVX() const { return m_useAVX; }
+
+    /**
+     * @brief Ajusta el número de volúmenes.
+     * @param count Volúmenes a evaluar.
+     */
+    void resize(size_t count);
+
+    /// Número de volúmenes.
+    size_t size() const { return m_count; }
+
+    /**
+     * @brief Escribe la AABB en mundo de un volumen.
+     * @param index Posición del volumen.
+     * @param bounds Volúmenes en mundo; vacío = siempre visible.
+     */
+    void setBounds(size_t index, const MeshBounds& bounds);
+
+    /**
+     * @brief Descarta los volúmenes fuera del frustum.
+     * @param frustum Planos en mundo.
+     * @param visible Índices visibles en orden creciente (se reemplazan).
+     * @param jobs Pool para repartir bloques (nullptr o escena pequeña = un hilo).
+     * @param stats Contadores de la pasada (opcional).
+     */
+    void cull(const Frustum& frustum,
+        std::vector<unsigned int>& visible,
+        JobSystem* jobs = nullptr,
+        FrustumCullStats* stats = nullptr) const;
+
+    /**
+     * @brief Mide el culling de una escena aleatoria con y sin paralelismo.
+     * @param count Volúmenes de la escena (p. ej. 100000).
+     * @param jobs Pool para la versión paralela (opcional).
+     */
+    static FrustumCullBenchmark benchmark(unsigned int count, JobSystem* jobs);
+
+private:
+    /// Procesa el rango de volúmenes [begin, end) (begin múltiplo de kGroupWidth) con el camino elegido.
+    void cullRange(const Frustum& frustum, size_t begin, size_t end, std::vector<unsigned int>& visible) const;
+
+    /// cullRange() con XMVECTOR, media grupo por iteración.
+    void cullRangeSSE(const Frustum& frustum, size_t begin, size_t end, std::vector<unsigned int>& visible) const;
+
+    /// cullRange() con registros AVX, un grupo por iteración (solo si isAVXSupported()).
+    void cullRangeAVX(const Frustum& frustum, size_t begin, size_t end, std::vector<unsigned int>& visible) const;
+
+    /// Ocho AABB en formato SoA.
+    struct alignas(32) Group {
+        float centerX[kGroupWidth], centerY[kGroupWidth], centerZ[kGroupWidth];
+        float extentX[kGroupWidth], extentY[kGroupWidth], extentZ[kGroupWidth];
+    };
+
+    std::vector<Group> m_groups; ///< Volúmenes en grupos de ocho.
+    size_t m_count = 0;          ///< Volúmenes válidos.
+    bool m_useAVX = false;       ///< cull() usa el camino de ocho carriles.
+    mutable std::vector<std::vector<unsigned int>> m_chunkVisible; ///< Salida de cada bloque paralelo.
+};
@@ -0,0 +1,302 @@
+﻿/**
+ * @file GeometryHeap.h
+ * @brief Vertex e index buffers grandes compartidos por las mallas, repartidos con un asignador TLSF.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class Device;
+class DeviceContext;
+class MeshComponent;
+
+/**
+ * @struct RangeMove
+ * @brief Bloque que la compactación desplaza dentro de su página.
+ */
+struct RangeMove {
+    unsigned int source = 0;      ///< Offset anterior (en unidades).
+    unsigned int destination = 0; ///< Offset nuevo (en unidades).
+    unsigned int size = 0;        ///< Unidades del bloque.
+};
+
+/**
+ * @struct RangeAllocatorStats
+ * @brief Ocupación de un asignador.
+ */
+struct RangeAllocatorStats {
+    unsigned int capacity = 0;     ///< Unidades totales.
+    unsigned int used = 0;         ///< Unidades asignadas.
+    unsigned int allocations = 0;  ///< Bloques asignados.
+    unsigned int freeBlocks = 0;   ///< Huecos.
+    unsigned int largestFree = 0;  ///< Hueco más grande.
+
+    /** @brief 0 = todo el espacio libre es un hueco; cerca de 1 = libre pero troceado. */
+    float getFragmentation() const {
+        const unsigned int free = capacity - used;
+        return free > 0 ? 1.0f - float(largestFree) / float(free) : 0.0f;
+    }
+};
+
+/**
+ * @class RangeAllocator
+ * @brief Suballocador TLSF (two-level segregated fit) de rangos de un buffer.
+ *
+ * @details
+ * Los huecos se clasifican por tamaño en clases de dos niveles (potencia de
+ * dos y 16 subdivisiones lineales); dos bitmaps dicen qué clases tienen
+ * huecos, así allocate() y free() son O(1). Se busca en la clase del tamaño
+ * redondeado hacia arriba (cualquier hueco de ella sirve) y, si no hay, en
+ * la clase exacta recorriendo su lista. free() fusiona con los vecinos
+ * físicos libres.
+ *
+ * Cada bloque asignado se identifica por un índice estable que no cambia
+ * al compactar: compact() junta los bloques vivos al principio en orden de
+ * dirección y devuelve los movimientos para que el llamador copie los datos.
+ * Solo maneja offsets en unidades (vértices o índices): no toca el dispositivo.
+ */
+class RangeAllocator {
+public:
+    static const unsigned int kInvalid = ~0u;         ///< Bloque nulo.
+    static const unsigned int kMaxCapacity = 1u << 30; ///< Unidades máximas (el redondeo no desborda).
+
+    /**
+     * @brief Prepara un asignador vacío.
+     * @param capacity Unidades del buffer (hasta kMaxCapacity).
+     */
+    void init(unsigned int capacity);
+
+    /**
+     * @brief Reserva un rango.
+     * @param size Unidades.
+     * @return Índice del bloque o kInvalid si no hay un hueco suficiente.
+     */
+    unsigned int allocate(unsigned int size);
+
+    /**
+     * @brief Libera un bloque asignado.
+     * @param block Índice devuelto por allocate().
+     */
+    void free(unsigned int block);
+
+    /** @brief Offset del bloque en unidades. */
+    unsigned int getOffset(unsigned int block) const { return m_blocks[block].offset; }
+
+    /** @brief Tamaño del bloque en unidades. */
+    unsigned int getSize(unsigned int block) const { return m_blocks[block].size; }
+
+    /**
+     * @brief Junta los bloques asignados al principio, en orden de dirección.
+     * @param moves Se vacía y rellena con los bloques desplazados (destino <= origen, en orden ascendente).
+     */
+    void compact(std::vector<RangeMove>& moves);
+
+    /** @brief Ocupación actual (recorre los bloques). */
+    RangeAllocatorStats getStats() const;
+
+    /** @brief Comprueba la lista física, las listas libres y los bitmaps. */
+    bool validate() const;
+
+private:
+    static const unsigned int kSecondLevelBits = 4;                        ///< 16 subdivisiones por potencia de dos.
+    static const unsigned int kSecondLevelCount = 1u << kSecondLevelBits;  ///< Clases de segundo nivel.
+    static const unsigned int kFirstLevelCount = 28;                       ///< Clases de primer nivel (hasta 2^30).
+
+    /// Rango del buffer, libre o asignado.
+    struct Block {
+        unsigned int offset;
+        unsigned int size;
+        unsigned int prevPhysical; ///< Bloque anterior en dirección.
+        unsigned int nextPhysical; ///< Bloque siguiente en dirección.
+        unsigned int prevFree;     ///< Anterior en la lista de su clase (solo libres).
+        unsigned int nextFree;     ///< Siguiente en la lista de su clase (solo libres).
+        bool free;
+    };
+
+    /** @brief Clase de un tamaño. */
+    static void mapping(unsigned int size, unsigned int& firstLevel, unsigned int& secondLevel);
+
+    /** @brief Hueco de al menos size unidades (kInvalid si no hay). */
+    unsigned int findFree(unsigned int size) const;
+
+    void insertFree(unsigned int block);
+    void removeFree(unsigned int block);
+    unsigned int createBlock();
+    void releaseBlock(unsigned int block);
+
+    std::vector<Block> m_blocks;            ///< Bloques (los índices liberados se reutilizan).
+    std::vector<unsigned int> m_unused;     ///< Índices de m_blocks libres.
+    unsigned int m_heads[kFirstLevelCount][kSecondLevelCount]; ///< Primer hueco de cada clase.
+    uint32_t m_firstLevelMap = 0;           ///< Bit por clase de primer nivel con huecos.
+    uint32_t m_secondLevelMaps[kFirstLevelCount] = {}; ///< Bit por clase de segundo nivel con huecos.
+    unsigned int m_first = kInvalid;        ///< Bloque en el offset 0.
+    unsigned int m_capacity = 0;            ///< Unidades totales.
+    unsigned int m_used = 0;                ///< Unidades asignadas.
+    unsigned int m_allocations = 0;         ///< Bloques asignados.
+};
+
+/**
+ * @struct GeometryRange
+ * @brief Dónde está una malla dentro del heap: buffers y desplazamientos para DrawIndexed.
+ */
+struct GeometryRange {
+    ID3D11Buffer* vertexBuffer = nullptr;           ///< Página de vértices.
+    unsigned int vertexStride = 0;                  ///< Stride de la página.
+    int baseVertex = 0;                             ///< Primer vértice de la malla (BaseVertexLocation).
+    ID3D11Buffer* indexBuffer = nullptr;            ///< Página de índices.
+    DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT; ///< Formato de la página.
+    unsigned int startIndex = 0;                    ///< Primer índice de la malla (se suma al rango dibujado).
+};
+
+/**
+ * @struct GeometryHeapStats
+ * @brief Ocupación del heap.
+ */
+struct GeometryHeapStats {
+    unsigned int pages = 0;          ///< Buffers creados (vértices e índices).
+    unsigned int meshes = 0;         ///< Mallas vivas.
+    uint64_t capacityBytes = 0;      ///< Bytes de todas las páginas.
+    uint64_t usedBytes = 0;          ///< Bytes asignados.
+    uint64_t largestFreeBytes = 0;   ///< Hueco más grande (en bytes, de cualquier página).
+    unsigned int freeBlocks = 0;     ///< Huecos entre todas las páginas.
+    float fragmentation = 0.0f;      ///< Peor fragmentación de una página.
+    unsigned int defragMoves = 0;    ///< Bloques copiados en la última desfragmentación.
+    uint64_t defragBytes = 0;        ///< Bytes copiados en la última desfragmentación.
+};
+
+/**
+ * @struct GeometryHeapBenchmark
+ * @brief Prueba del asignador y binds de una escena de muchas mallas con buffers propios o en el heap.
+ */
+struct GeometryHeapBenchmark {
+    unsigned int operations = 0;       ///< Asignaciones y liberaciones aleatorias.
+    double allocatorMs = 0.0;          ///< Tiempo de esas operaciones.
+    float fragmentation = 0.0f;        ///< Fragmentación antes de compactar.
+    unsigned int compactMoves = 0;     ///< Bloques desplazados al compactar.
+    bool allocatorValid = false;       ///< Sin solapes, contenido intacto tras compactar y estructuras coherentes.
+    unsigned int meshes = 0;           ///< Mallas de la escena.
+    unsigned int pages = 0;            ///< Páginas de vértices que ocupan en el heap.
+    unsigned int ownBufferBinds = 0;   ///< Binds de la cola ordenada con un par de buffers por malla.
+    unsigned int heapBinds = 0;        ///< Binds de la cola ordenada con las mallas en el heap.
+};
+
+/**
+ * @class GeometryHeap
+ * @brief Guarda los vértices e índices de todas las mallas en unos pocos buffers grandes.
+ *
+ * @details
+ * Las páginas se agrupan en pools por stride de vértice y por ancho de
+ * índice, cada una con su RangeAllocator. add() codifica la malla como
+ * Buffer::init, le busca sitio en la primera página del pool con hueco
+ * (o crea otra) y la sube con UpdateSubresource sobre el rango. Las mallas
+ * del mismo formato comparten buffers, así que la cola solo los enlaza al
+ * cambiar de página y cada draw se distingue por baseVertex y startIndex.
+ *
+ * Los handles cuentan referencias (las copias de actores comparten la
+ * malla); con la última release() se libera el rango. defragment() copia
+ * los rangos vivos de cada página fragmentada a una página nueva compacta
+ * en la GPU: los handles no cambian y getRange() devuelve ya la ubicación
+ * nueva, así que debe llamarse entre frames.
+ */
+class GeometryHeap {
+public:
+    static const unsigned int kVertexPageBytes = 32 * 1024 * 1024; ///< Tamaño de una página de vértices.
+    static const unsigned int kIndexPageBytes = 16 * 1024 * 1024;  ///< Tamaño de una página de índices.
+    static const unsigned int kInvalidHandle = ~0u;                ///< Handle nulo.
+
+    /**
+     * @brief Guarda el dispositivo y el contexto con los que se crean y suben las páginas.
+     * @return HRESULT con el estado de la operación.
+     */
+    HRESULT init(Device& device, DeviceContext& deviceContext);
+
+    /** @brief Libera todas las páginas (los handles dejan de ser válidos). */
+    void destroy();
+
+    /** @brief true si init() tuvo éxito. */
+    bool isReady() const { return m_device != nullptr; }
+
+    /**
+     * @brief Sube una malla.
+     * @param mesh Malla con su formato de vértice e índice ya elegidos.
+     * @return Handle con una referencia, o kInvalidHandle si falló (el llamador usa buffers propios).
+     */
+    unsigned int add(const MeshComponent& mesh);
+
+    /** @brief Suma una referencia a un handle. */
+    void addRef(unsigned int handle);
+
+    /** @brief Quita una referencia; con la última se libera el rango. */
+    void release(unsigned int handle);
+
+    /**
+     * @brief Ubicación actual de una malla.
+     * @return false si el handle no es válido.
+     */
+    bool getRange(unsigned int handle, GeometryRange& range) const;
+
+    /**
+     * @brief Compacta en la GPU las páginas con huecos.
+     * @return Bloques copiados.
+     */
+    unsigned int defragment();
+
+    /** @brief Ocupación actual. */
+    GeometryHeapStats getStats() const;
+
+    /**
+     * @brief Prueba el asignador en CPU y cuenta los binds de una escena de muchas mallas.
+     * @param meshes Mallas de la escena (p. ej. 2000).
+     * @param operations Asignaciones y liberaciones aleatorias.
+     */
+    static GeometryHeapBenchmark benchmark(unsigned int meshes, unsigned int operations);
+
+private:
+    /// Buffer grande y sus rangos.
+    struct Page {
+        ID3D11Buffer* buffer;
+        RangeAllocator allocator;
+    };
+
+    /// Páginas de un mismo formato.
+    struct Pool {
+        unsigned int bindFlag;    ///< D3D11_BIND_VERTEX_BUFFER o D3D11_BIND_INDEX_BUFFER.
+        unsigned int elementSize; ///< Stride o ancho de índice.
+        std::vector<Page> pages;
+    };
+
+    /// Rango de una malla en un pool.
+    struct Slot {
+        unsigned int pool;
+        unsigned int page;
+        unsigned int block;
+    };
+
+    /// Malla subida.
+    struct Allocation {
+        Slot vertices;
+        Slot indices;
+        DXGI_FORMAT indexFormat;
+        unsigned int references; ///< 0 = handle libre.
+    };
+
+    /**
+     * @brief Reserva y sube un rango en el pool del formato (crea el pool o una página si hace falta).
+     * @return false si no se pudo crear la página.
+     */
+    bool allocate(unsigned int bindFlag, unsigned int elementSize, unsigned int count, const void* data, Slot& slot);
+
+    /** @brief Libera un rango. */
+    void free(const Slot& slot);
+
+    /** @brief Crea una página de al menos units elementos. */
+    HRESULT createPage(Pool& pool, unsigned int units, Page& page);
+
+    Device* m_device = nullptr;               ///< Dispositivo (nullptr = sin init()).
+    DeviceContext* m_deviceContext = nullptr; ///< Contexto de las subidas y copias.
+    std::vector<Pool> m_pools;                ///< Pools por formato.
+    std::vector<Allocation> m_allocations;    ///< Mallas por handle.
+    std::vector<unsigned int> m_freeHandles;  ///< Handles reutilizables.
+    unsigned int m_defragMoves = 0;           ///< Bloques de la última desfragmentación.
+    uint64_t m_defragBytes = 0;               ///< Bytes de la última desfragmentación.
+};
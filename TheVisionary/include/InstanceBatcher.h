@@ -0,0 +1,244 @@
+﻿/**
+ * @file InstanceBatcher.h
+ * @brief Agrupa los draws de actores que comparten malla y material en lotes con DrawIndexedInstanced.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "RenderQueue.h"
+#include "ShaderProgram.h"
+#include "Buffer.h"
+#include <unordered_map>
+
+class Device;
+class DeviceContext;
+
+/**
+ * @struct InstanceData
+ * @brief Datos de una instancia en el vertex buffer del slot 1.
+ */
+struct InstanceData {
+    XMFLOAT4X4 world; ///< Matriz de mundo sin transponer (filas INSTANCE_WORLD0..3).
+    XMFLOAT4 color;   ///< Color que multiplica la textura (INSTANCE_COLOR).
+};
+
+/**
+ * @struct InstanceBatch
+ * @brief Instancias contiguas que se dibujan con un solo DrawIndexedInstanced.
+ */
+struct InstanceBatch {
+    DrawPacket packet;                 ///< Estados, geometría y rango de instancias (firstInstance, instanceCount).
+    RenderPass pass = RENDER_PASS_OPAQUE; ///< Pase de dibujo.
+    float depth = 0.0f;                ///< La más cercana del lote (la más lejana en el pase de sombras).
+};
+
+/**
+ * @struct InstancingStats
+ * @brief Contadores del último frame.
+ */
+struct InstancingStats {
+    unsigned int instances = 0; ///< Instancias recogidas.
+    unsigned int batches = 0;   ///< Lotes (un draw cada uno).
+    unsigned int capacity = 0;  ///< Capacidad del buffer de instancias.
+    double buildMs = 0.0;       ///< Agrupación y empaquetado.
+    double uploadMs = 0.0;      ///< Subida del buffer de instancias.
+};
+
+/**
+ * @struct InstancingBenchmark
+ * @brief Escena sintética: un paquete por actor frente a lotes instanciados.
+ */
+struct InstancingBenchmark {
+    unsigned int instances = 0;          ///< Actores.
+    unsigned int meshes = 0;             ///< Mallas distintas que comparten.
+    unsigned int actorDrawCalls = 0;     ///< Draws con un paquete por actor.
+    unsigned int actorUploads = 0;       ///< Subidas de constantes con un paquete por actor.
+    unsigned int instancedDrawCalls = 0; ///< Draws con lotes instanciados.
+    double actorSubmitMs = 0.0;          ///< push + sort + submit de un paquete por actor.
+    double instancedSubmitMs = 0.0;      ///< add + build + push + sort + submit de los lotes.
+    double buildMs = 0.0;                ///< Parte de agrupación y empaquetado.
+    bool packedCorrectly = false;        ///< Cada actor aparece una vez, en el lote de su malla y con su matriz.
+};
+
+/**
+ * @class InstanceBatcher
+ * @brief Recoge por frame los draws de actores instanciables, los agrupa por malla y material
+ *        y los emite como un paquete instanciado por grupo.
+ *
+ * @details
+ * add() recibe el paquete que el actor enviaría a la cola junto con su
+ * matriz de mundo y su color, y busca su grupo (pase, estados, textura,
+ * buffers y rango de índices; la constante por objeto no cuenta porque
+ * viaja en la instancia) en una tabla hash. build() reparte las instancias
+ * por grupo con un counting sort estable, así que cada lote es un rango
+ * [firstInstance, firstInstance + instanceCount) de un único buffer.
+ * Agrupar y empaquetar no toca el dispositivo: sin init() se puede
+ * ejercitar con punteros ficticios.
+ *
+ * Con init() compila un programa propio (HLSL en memoria) cuyo VS lee la
+ * matriz y el color del slot 1, con un PS para los pases opacos y otro para
+ * las sombras (el color de sombra viaja en la instancia), crea sus Input
+ * Layouts con los elementos por instancia y mantiene el buffer de
+ * instancias, que crece por potencias de dos.
+ */
+class InstanceBatcher {
+public:
+    static const unsigned int kInitialCapacity = 1024; ///< Instancias del primer buffer.
+
+    /**
+     * @brief Compila el programa instanciado y crea el buffer de instancias.
+     * @param device Dispositivo Direct3D.
+     * @return HRESULT con el estado de la operación.
+     */
+    HRESULT init(Device& device);
+
+    /**
+     * @brief Crea (una sola vez) el Input Layout instanciado de un formato de vértice.
+     * @param device Dispositivo Direct3D.
+     * @param layout Formato de la malla.
+     * @return HRESULT con el estado de la operación.
+     */
+    HRESULT createInputLayout(Device& device, const VertexLayout& layout);
+
+    /**
+     * @brief Shaders que add() pone en los paquetes (init() los fija; nullptr = conserva los del paquete).
+     * @param vertexShader VS instanciado.
+     * @param pixelShader PS de los pases opacos.
+     * @param shadowPixelShader PS de RENDER_PASS_SHADOW.
+     */
+    void setShaders(ID3D11VertexShader* vertexShader,
+        ID3D11PixelShader* pixelShader,
+        ID3D11PixelShader* shadowPixelShader);
+
+    /**
+     * @brief Input Layout instanciado de un formato (createInputLayout() lo fija).
+     * @param layout Formato de vértice.
+     * @param inputLayout Input Layout (nullptr = el formato deja de poder instanciarse).
+     */
+    void setInputLayout(const VertexLayout& layout, ID3D11InputLayout* inputLayout);
+
+    /** @brief Libera el programa y el buffer de instancias. */
+    void destroy();
+
+    /** @brief true si init() tuvo éxito (hay shaders para dibujar instancias). */
+    bool isReady() const { return m_ready; }
+
+    /** @brief Vacía el frame (conserva la memoria). */
+    void begin();
+
+    /**
+     * @brief Agrega una instancia.
+     * @param packet Paquete del actor; se sustituyen shaders (el PS de sombra en RENDER_PASS_SHADOW)
+     *        e Input Layout por los instanciados, y se descartan las constantes y los rangos de meshlets.
+     * @param layout Formato de vértice de la malla.
+     * @param pass Pase de dibujo.
+     * @param depth Distancia a la cámara.
+     * @param world Matriz de mundo (con la decuantización de la malla, si la hay).
+     * @param color Color de la instancia.
+     * @return false si no hay Input Layout instanciado para el formato (el actor debe dibujarse sin instancing).
+     */
+    bool add(const DrawPacket& packet,
+        const VertexLayout& layout,
+        RenderPass pass,
+        float depth,
+        const XMMATRIX& world,
+        const XMFLOAT4& color);
+
+    /** @brief Agrupa las instancias del frame y las empaqueta en orden de lote. */
+    void build();
+
+    /**
+     * @brief Sube las instancias empaquetadas (agranda el buffer si no caben).
+     * @param device Dispositivo Direct3D.
+     * @param deviceContext Contexto donde se actualiza el buffer.
+     * @return HRESULT con el estado de la operación.
+     */
+    HRESULT upload(Device& device, DeviceContext& deviceContext);
+
+    /**
+     * @brief Sube instancias empaquetadas en otro momento (p. ej. las de un paquete de frame).
+     * @param device Dispositivo Direct3D.
+     * @param deviceContext Contexto donde se actualiza el buffer.
+     * @param instances Instancias en orden de lote.
+     * @param stats Recibe capacity y uploadMs.
+     * @return HRESULT con el estado de la operación.
+     */
+    HRESULT upload(Device& device,
+        DeviceContext& deviceContext,
+        const std::vector<InstanceData>& instances,
+        InstancingStats& stats);
+
+    /**
+     * @brief Agrega un paquete instanciado por lote a la cola.
+     * @param queue Cola del frame.
+     */
+    void submit(RenderQueue& queue) const;
+
+    /**
+     * @brief Agrega a la cola lotes guardados (con el buffer de instancias actual).
+     * @param queue Cola del frame.
+     * @param batches Lotes de un build() anterior, cuyas instancias ya se subieron.
+     */
+    void submit(RenderQueue& queue, const std::vector<InstanceBatch>& batches) const;
+
+    /** @brief Lotes del último build(). */
+    const std::vector<InstanceBatch>& getBatches() const { return m_batches; }
+
+    /** @brief Instancias empaquetadas del último build(), en orden de lote. */
+    const std::vector<InstanceData>& getInstances() const { return m_instances; }
+
+    /** @brief Contadores del frame. */
+    const InstancingStats& getStats() const { return m_stats; }
+
+    /**
+     * @brief Elementos por instancia del Input Layout (slot 1).
+     * @param elements Se vacía y rellena.
+     */
+    static void getInstanceElements(std::vector<D3D11_INPUT_ELEMENT_DESC>& elements);
+
+    /**
+     * @brief Mide una escena sintética de actores que comparten unas pocas mallas.
+     * @param instances Actores (p. ej. 10000).
+     * @param meshes Mallas distintas.
+     */
+    static InstancingBenchmark benchmark(unsigned int instances, unsigned int meshes);
+
+private:
+    /// Todo lo que debe coincidir para compartir lote.
+    struct GroupKey {
+        uint64_t words[15];
+    };
+
+    /// Grupo de instancias que comparten lote.
+    struct Group {
+        GroupKey key;
+        DrawPacket packet;
+        RenderPass pass;
+        float depth;        ///< Profundidad del lote.
+        unsigned int count; ///< Instancias del grupo.
+        unsigned int next;  ///< Siguiente grupo con el mismo hash (~0u = ninguno).
+    };
+
+    /// Instancia recogida antes de empaquetar.
+    struct Item {
+        unsigned int group;
+        InstanceData data;
+    };
+
+    std::vector<Group> m_groups;           ///< Grupos del frame.
+    std::unordered_map<uint64_t, unsigned int> m_groupLookup; ///< Hash de la clave -> primer grupo con ese hash.
+    std::vector<Item> m_items;             ///< Instancias del frame en orden de add().
+    std::vector<unsigned int> m_offsets;   ///< Siguiente posición libre de cada grupo al empaquetar.
+    std::vector<InstanceData> m_instances; ///< Instancias empaquetadas.
+    std::vector<InstanceBatch> m_batches;  ///< Lotes.
+    ShaderProgram m_program;               ///< VS/PS instanciados y sus Input Layouts.
+    ShaderProgram m_shadowProgram;         ///< PS instanciado de las sombras.
+    ID3D11VertexShader* m_vertexShader = nullptr;     ///< VS que add() pone en los paquetes.
+    ID3D11PixelShader* m_pixelShader = nullptr;       ///< PS de los pases opacos.
+    ID3D11PixelShader* m_shadowPixelShader = nullptr; ///< PS de RENDER_PASS_SHADOW.
+    std::unordered_map<unsigned int, ID3D11InputLayout*> m_inputLayouts; ///< VertexLayout::getKey -> Input Layout instanciado.
+    Buffer m_instanceBuffer;               ///< Vertex buffer por instancia (slot 1).
+    unsigned int m_capacity = 0;           ///< Instancias que caben en m_instanceBuffer.
+    bool m_ready = false;                  ///< init() tuvo éxito.
+    InstancingStats m_stats;               ///< Contadores del frame.
+};
@@ -0,0 +1,85 @@
+﻿/**
+ * @file JobSystem.h
+ * @brief Pool de hilos trabajadores para tareas paralelas de The Visionary Engine.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/**
+ * @class JobSystem
+ * @brief Ejecuta tareas en un conjunto fijo de hilos trabajadores.
+ *
+ * @details
+ * Ofrece dos modos de uso: tareas sueltas mediante submit()/wait() y
+ * bucles paralelos mediante parallelFor(). En parallelFor() el hilo que
+ * llama también procesa bloques, por lo que puede anidarse desde un
+ * trabajador sin bloquear el pool.
+ */
+class JobSystem {
+public:
+    /** @brief Constructor por defecto. */
+    JobSystem() = default;
+
+    /** @brief Destructor: detiene los hilos si siguen activos. */
+    ~JobSystem() { destroy(); }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Crea los hilos trabajadores.
+     * @param numThreads Número de trabajadores (0 = núcleos disponibles - 1).
+     */
+    void init(unsigned int numThreads = 0);
+
+    /**
+     * @brief Encola una tarea para ejecutarse en algún trabajador.
+     * @param job Tarea a ejecutar. Si no hay trabajadores se ejecuta en el acto.
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * @brief Espera a que terminen todas las tareas encoladas con submit().
+     */
+    void wait();
+
+    /**
+     * @brief Divide el rango [0, count) en bloques y los procesa en paralelo.
+     * @param count Número total de elementos.
+     * @param grainSize Elementos por bloque (mínimo 1).
+     * @param fn Función llamada con el rango [begin, end) de cada bloque.
+     */
+    void parallelFor(unsigned int count,
+        unsigned int grainSize,
+        const std::function<void(unsigned int begin, unsigned int end)>& fn);
+
+    /**
+     * @brief Detiene y une los hilos trabajadores.
+     */
+    void destroy();
+
+    /**
+     * @brief Obtiene el número de hilos trabajadores.
+     * @return Trabajadores activos (sin contar el hilo que llama).
+     */
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(m_workers.size()); }
+
+private:
+    /** @brief Bucle principal de cada trabajador. */
+    void workerLoop();
+
+private:
+    std::vector<std::thread> m_workers;           ///< Hilos trabajadores.
+    std::deque<std::function<void()>> m_jobs;     ///< Cola de tareas pendientes.
+    std::mutex m_mutex;                           ///< Protege la cola y los contadores.
+    std::condition_variable m_jobAvailable;       ///< Despierta a los trabajadores.
+    std::condition_variable m_jobsDone;           ///< Notifica que la cola quedó vacía.
+    unsigned int m_pendingJobs = 0;               ///< Tareas encoladas o en ejecución.
+    bool m_running = false;                       ///< Indica si el pool está activo.
+};
@@ -1,9 +1,35 @@
 #pragma once
 #include "Prerequisites.h"
 #include "ECS\Component.h"
+#include "VertexFormat.h"
+#include "BoundingVolume.h"
+#include "TriangleBVH.h"
 
 class DeviceContext;
 
+/**
+ * @struct MeshLOD
+ * @brief Rango de ndices de un nivel de detalle dentro de MeshComponent::m_index.
+ */
+struct MeshLOD {
+    unsigned int indexOffset = 0; ///< Primer ndice del nivel.
+    unsigned int indexCount = 0;  ///< ndices del nivel.
+    float error = 0.0f;           ///< Error geomtrico respecto al original (unidades del modelo).
+    float screenSize = 0.0f;      ///< Tamao proyectado por debajo del cual se usa el nivel.
+};
+
+/**
+ * @struct Meshlet
+ * @brief Clster de tringulos del LOD 0 (rango contiguo de m_index) con sus volmenes de culling.
+ */
+struct Meshlet {
+    unsigned int indexOffset = 0;   ///< Primer ndice del meshlet.
+    unsigned int triangleCount = 0; ///< Tringulos del meshlet.
+    unsigned int vertexCount = 0;   ///< Vrtices nicos que referencia.
+    XMFLOAT4 sphere = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f); ///< Esfera envolvente local (centro, radio).
+    XMFLOAT4 cone = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);   ///< Eje del cono de normales (xyz) y corte (w; 1 = sin cono).
+};
+
 /**
  * @class MeshComponent
  * @brief Componente ECS que almacena y gestiona los datos de una malla.
@@ -50,7 +76,13 @@ public:
 public:
     std::string m_name;                  ///< Nombre de la malla.
     std::vector<SimpleVertex> m_vertex;   ///< Lista de vrtices.
-    std::vector<unsigned int> m_index;    ///< Lista de ndices.
+    std::vector<unsigned int> m_index;    ///< Lista de ndices (LOD 0 seguido de los LOD de m_lods).
     int m_numVertex;                      ///< Nmero de vrtices.
-    int m_numIndex;                       ///< Nmero de ndices.
+    int m_numIndex;                       ///< Nmero de ndices del LOD 0.
+    IndexFormat m_indexFormat = INDEX_UINT32; ///< Ancho de los ndices en el index buffer.
+    VertexLayout m_vertexLayout;          ///< Codificacin de los vrtices en el vertex buffer.
+    std::vector<MeshLOD> m_lods;          ///< Cadena de LOD (vaca = solo el nivel completo).
+    std::vector<Meshlet> m_meshlets;      ///< Meshlets del LOD 0 (vaco = se dibuja entero).
+    MeshBounds m_bounds;                  ///< AABB y esfera en espacio del modelo.
+    TriangleBVH m_bvh;                    ///< BVH de los tringulos del LOD 0 (raycasts y seleccin).
 };
@@ -0,0 +1,99 @@
+﻿/**
+ * @file MeshOptimizer.h
+ * @brief Reordenamiento de triángulos y vértices para la caché post-transformación, overdraw y fetch.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/**
+ * @struct VertexCacheStats
+ * @brief Resultado de simular una caché FIFO de vértices transformados.
+ */
+struct VertexCacheStats {
+    unsigned int triangles = 0;   ///< Triángulos simulados.
+    unsigned int vertices = 0;    ///< Vértices de la malla.
+    unsigned int transformed = 0; ///< Vértices que hubo que transformar (fallos de caché).
+    float acmr = 0.0f;            ///< Average Cache Miss Ratio: transformados / triángulos (ideal ~0.5).
+    float atvr = 0.0f;            ///< Average Transformed Vertex Ratio: transformados / vértices (ideal 1.0).
+};
+
+/**
+ * @struct MeshOptimizationReport
+ * @brief Métricas antes y después de optimizar una malla.
+ */
+struct MeshOptimizationReport {
+    VertexCacheStats before;      ///< Caché con el orden original.
+    VertexCacheStats after;       ///< Caché con el orden optimizado.
+    unsigned int clusters = 0;    ///< Clusters usados para el orden de overdraw.
+    unsigned int removedVertices = 0; ///< Vértices no referenciados eliminados.
+    double milliseconds = 0.0;    ///< Tiempo total de la pasada.
+};
+
+/**
+ * @class MeshOptimizer
+ * @brief Etapa de importación que reordena índices y vértices; solo CPU y determinista.
+ *
+ * @details
+ * 1. Orden de triángulos para la caché de vértices (algoritmo de Forsyth,
+ *    caché LRU de 32 entradas).
+ * 2. Orden para overdraw al estilo Tipsify: la secuencia optimizada se corta
+ *    en clusters donde la caché se reinicia o donde el ACMR local sigue
+ *    dentro de un umbral del global, y los clusters se ordenan de más
+ *    exterior a más interior respecto al centro de la malla.
+ * 3. Orden de vértices por primer uso en el índice (localidad de fetch).
+ *
+ * simulateVertexCache() es el simulador de caché FIFO usado para el
+ * informe ACMR/ATVR; permite comprobar cualquier orden de índices.
+ */
+class MeshOptimizer {
+public:
+    /// Tamaño de caché FIFO por defecto del simulador (típico de GPUs de escritorio).
+    static const unsigned int kDefaultCacheSize = 16;
+
+    /**
+     * @brief Simula una caché FIFO de vértices transformados.
+     * @param indices Lista de triángulos.
+     * @param vertexCount Número de vértices de la malla.
+     * @param cacheSize Entradas de la caché simulada.
+     */
+    static VertexCacheStats simulateVertexCache(const std::vector<unsigned int>& indices,
+        unsigned int vertexCount,
+        unsigned int cacheSize = kDefaultCacheSize);
+
+    /**
+     * @brief Reordena los triángulos para maximizar aciertos en la caché de vértices.
+     * @param indices Lista de triángulos (se reordena en sitio).
+     * @param vertexCount Número de vértices de la malla.
+     */
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+    /**
+     * @brief Reordena clusters de triángulos para reducir overdraw sin romper la localidad de caché.
+     * @param vertices Vértices de la malla (posiciones).
+     * @param indices Lista de triángulos ya optimizada para caché.
+     * @param threshold ACMR máximo permitido respecto al de la entrada (1.05 = 5% peor).
+     * @return Número de clusters generados.
+     */
+    static unsigned int optimizeOverdraw(const std::vector<SimpleVertex>& vertices,
+        std::vector<unsigned int>& indices,
+        float threshold = 1.05f);
+
+    /**
+     * @brief Reordena los vértices por primer uso y descarta los no referenciados.
+     * @param vertices Vértices (se reordenan en sitio).
+     * @param indices Índices (se remapean en sitio).
+     * @return Número de vértices eliminados.
+     */
+    static unsigned int optimizeVertexFetch(std::vector<SimpleVertex>& vertices,
+        std::vector<unsigned int>& indices);
+
+    /**
+     * @brief Ejecuta las tres pasadas sobre una malla y actualiza sus contadores.
+     * @param mesh Malla a optimizar.
+     * @return Métricas antes/después.
+     */
+    static MeshOptimizationReport optimize(MeshComponent& mesh);
+};
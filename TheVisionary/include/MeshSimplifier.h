@@ -0,0 +1,90 @@
+﻿/**
+ * @file MeshSimplifier.h
+ * @brief Simplificación por error cuádrico (QEM) y cadenas de LOD por malla.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+struct MeshLOD;
+
+/**
+ * @struct SimplificationStats
+ * @brief Contadores de la generación de LODs de una carga.
+ */
+struct SimplificationStats {
+    unsigned int meshes = 0;          ///< Mallas con cadena de LOD.
+    unsigned int levels = 0;          ///< Niveles generados (sin contar el LOD 0).
+    unsigned int sourceTriangles = 0; ///< Triángulos del LOD 0 de todas las mallas.
+    unsigned int lodTriangles = 0;    ///< Triángulos generados en los LOD 1..N.
+    double milliseconds = 0.0;        ///< Tiempo total de simplificación.
+};
+
+/**
+ * @class MeshSimplifier
+ * @brief Simplificador de índices por colapso de aristas con métrica cuádrica.
+ *
+ * @details
+ * Los LOD reutilizan los vértices de la malla: cada arista se colapsa sobre
+ * uno de sus extremos, así que solo cambia la lista de índices y todos los
+ * niveles comparten el vertex buffer. Los vértices se clasifican por
+ * posición: interiores (colapso libre), de borde (solo a lo largo del borde),
+ * de costura UV con dos copias (solo a lo largo de la costura, moviendo
+ * ambas copias a la vez) y bloqueados (esquinas y casos no manifold). Se
+ * rechazan los colapsos que invierten triángulos vecinos.
+ */
+class MeshSimplifier {
+public:
+    /// Holgura de la histéresis de selección de LOD (15 % del umbral).
+    static constexpr float kLODHysteresis = 0.15f;
+
+    /**
+     * @brief Simplifica una lista de triángulos hasta un número de índices objetivo.
+     * @param vertices Vértices de la malla (posiciones y UV para detectar costuras).
+     * @param indices Triángulos de entrada.
+     * @param targetIndexCount Índices deseados (múltiplo de 3).
+     * @param destination Triángulos de salida (referencian los mismos vértices).
+     * @param resultError Error geométrico alcanzado (distancia en unidades del modelo, opcional).
+     * @return Número de índices generados (puede quedar por encima del objetivo si
+     *         no hay colapsos válidos).
+     */
+    static size_t simplify(const std::vector<SimpleVertex>& vertices,
+        const std::vector<unsigned int>& indices,
+        size_t targetIndexCount,
+        std::vector<unsigned int>& destination,
+        float* resultError = nullptr);
+
+    /**
+     * @brief Genera la cadena de LOD de una malla y la agrega a su lista de índices.
+     * @param mesh Malla ya optimizada; los índices de cada LOD se añaden tras el LOD 0
+     *        y m_lods describe los rangos (m_numIndex queda como el tamaño del LOD 0).
+     * @param ratios Proporción de triángulos de cada nivel respecto al original (p. ej. 0.5, 0.25, 0.125).
+     * @param stats Contadores acumulados (opcional).
+     */
+    static void buildLODChain(MeshComponent& mesh,
+        const std::vector<float>& ratios,
+        SimplificationStats* stats = nullptr);
+
+    /**
+     * @brief Elige el LOD de una malla según su tamaño proyectado, con histéresis.
+     * @param lods Cadena de LOD (puede estar vacía).
+     * @param screenSize Radio proyectado relativo a media altura de pantalla.
+     * @param current LOD usado en el frame anterior.
+     * @return Índice del LOD a dibujar.
+     */
+    static unsigned int selectLOD(const std::vector<MeshLOD>& lods,
+        float screenSize,
+        unsigned int current);
+
+
+    /**
+     * @brief Tamaño proyectado de una esfera: radio relativo a media altura de pantalla.
+     * @param center Centro en mundo.
+     * @param radius Radio en mundo.
+     * @param eye Posición de la cámara.
+     * @param projectionScale 1 / tan(fovY / 2).
+     * @return >= 1 si la esfera llena la pantalla (FLT_MAX con la cámara dentro).
+     */
+    static float projectedSize(const XMFLOAT3& center, float radius, const XMFLOAT3& eye, float projectionScale);
+};
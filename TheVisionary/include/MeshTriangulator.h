@@ -0,0 +1,72 @@
+﻿/**
+ * @file MeshTriangulator.h
+ * @brief Triangulación de polígonos (triángulos, quads y n-gonos) para la importación de mallas.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class JobSystem;
+
+/**
+ * @struct TriangulationStats
+ * @brief Contadores de una pasada de triangulación.
+ */
+struct TriangulationStats {
+    unsigned int polygons = 0;      ///< Polígonos de entrada.
+    unsigned int triangles = 0;     ///< Triángulos generados.
+    unsigned int quads = 0;         ///< Polígonos de 4 vértices.
+    unsigned int ngons = 0;         ///< Polígonos de más de 4 vértices.
+    unsigned int degenerate = 0;    ///< Polígonos de menos de 3 vértices (descartados).
+    unsigned int fanFallbacks = 0;  ///< N-gonos resueltos en abanico (sin oreja válida o demasiado grandes).
+    double milliseconds = 0.0;      ///< Tiempo total de la pasada.
+};
+
+/**
+ * @class MeshTriangulator
+ * @brief Convierte listas de polígonos en listas de triángulos para TRIANGLELIST.
+ *
+ * @details
+ * Los triángulos se copian tal cual y los quads se parten por la diagonal
+ * adecuada (la que pasa por el vértice cóncavo, o la más corta si es
+ * convexo). Los n-gonos usan ear clipping sobre la proyección al plano
+ * dominante con arreglos en pila, sin reservar memoria por polígono. Como
+ * cada polígono de n vértices produce exactamente n - 2 triángulos, la
+ * salida se reparte por adelantado y los polígonos se procesan en paralelo
+ * sin sincronización. Se conserva el orden de giro del polígono original.
+ */
+class MeshTriangulator {
+public:
+    /// Máximo de vértices por n-gono para ear clipping; los mayores se resuelven en abanico.
+    static const unsigned int kMaxEarClipVertices = 256;
+
+    /**
+     * @brief Triangula todos los polígonos de una malla.
+     * @param vertices Vértices de la malla (se usan sus posiciones).
+     * @param polygonIndices Índices de todos los polígonos, concatenados.
+     * @param polygonSizes Número de vértices de cada polígono.
+     * @param triangles Índices de salida (3 por triángulo).
+     * @param jobs JobSystem para procesar en paralelo (nullptr = un hilo).
+     * @param stats Contadores opcionales de la pasada.
+     * @return false si los tamaños no cuadran con la lista de índices.
+     */
+    static bool triangulate(const std::vector<SimpleVertex>& vertices,
+        const std::vector<unsigned int>& polygonIndices,
+        const std::vector<unsigned int>& polygonSizes,
+        std::vector<unsigned int>& triangles,
+        JobSystem* jobs = nullptr,
+        TriangulationStats* stats = nullptr);
+
+    /**
+     * @brief Triangula un único polígono.
+     * @param vertices Vértices de la malla.
+     * @param polygon Índices del polígono.
+     * @param count Número de vértices del polígono (>= 3).
+     * @param out Destino con espacio para (count - 2) * 3 índices.
+     * @return true si se resolvió con ear clipping o un camino rápido; false si cayó en abanico.
+     */
+    static bool triangulatePolygon(const std::vector<SimpleVertex>& vertices,
+        const unsigned int* polygon,
+        unsigned int count,
+        unsigned int* out);
+};
@@ -0,0 +1,145 @@
+﻿/**
+ * @file Meshlet.h
+ * @brief Agrupación de triángulos en meshlets y culling por clúster en CPU (esfera + cono de normales).
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+struct Meshlet;
+
+/**
+ * @struct MeshletBuildStats
+ * @brief Contadores de la generación de meshlets de una carga.
+ */
+struct MeshletBuildStats {
+    unsigned int meshes = 0;    ///< Mallas divididas en meshlets.
+    unsigned int meshlets = 0;  ///< Meshlets generados.
+    unsigned int triangles = 0; ///< Triángulos repartidos.
+    unsigned int vertices = 0;  ///< Suma de vértices únicos por meshlet.
+    unsigned int cones = 0;     ///< Meshlets con cono de normales útil (culling por orientación).
+    double milliseconds = 0.0;  ///< Tiempo total de construcción.
+};
+
+/**
+ * @struct MeshletDrawRange
+ * @brief Rango contiguo de índices visibles (meshlets consecutivos fusionados).
+ */
+struct MeshletDrawRange {
+    unsigned int indexOffset = 0; ///< Primer índice.
+    unsigned int indexCount = 0;  ///< Número de índices.
+};
+
+/**
+ * @struct MeshletCullStats
+ * @brief Resultado del culling de meshlets de uno o varios frames.
+ */
+struct MeshletCullStats {
+    unsigned int meshlets = 0;        ///< Meshlets evaluados.
+    unsigned int frustumCulled = 0;   ///< Meshlets fuera del frustum.
+    unsigned int backfaceCulled = 0;  ///< Meshlets descartados por su cono de normales.
+    unsigned int triangles = 0;       ///< Triángulos evaluados.
+    unsigned int culledTriangles = 0; ///< Triángulos descartados.
+    unsigned int ranges = 0;          ///< Rangos de dibujo emitidos.
+    double milliseconds = 0.0;        ///< Tiempo de CPU del culling.
+
+    /// Porcentaje de triángulos descartados.
+    double getCulledPercent() const { return triangles ? 100.0 * culledTriangles / triangles : 0.0; }
+
+    /// Coste de CPU por millón de triángulos evaluados (ms).
+    double getMsPerMillionTriangles() const { return triangles ? milliseconds * 1.0e6 / triangles : 0.0; }
+
+    /// Acumula los contadores de otro resultado.
+    void add(const MeshletCullStats& other) {
+        meshlets += other.meshlets;
+        frustumCulled += other.frustumCulled;
+        backfaceCulled += other.backfaceCulled;
+        triangles += other.triangles;
+        culledTriangles += other.culledTriangles;
+        ranges += other.ranges;
+        milliseconds += other.milliseconds;
+    }
+};
+
+/**
+ * @class MeshletBuilder
+ * @brief Divide el LOD 0 de una malla en meshlets y calcula sus volúmenes.
+ *
+ * @details
+ * Cada meshlet crece desde un triángulo semilla añadiendo vecinos que
+ * comparten vértices (prioriza los que no añaden vértices nuevos y los que
+ * están alineados con la normal media), hasta llenar el límite de vértices
+ * o de triángulos. Los índices del LOD 0 se reescriben en orden de meshlet,
+ * de modo que cada uno es un rango contiguo del index buffer.
+ */
+class MeshletBuilder {
+public:
+    static const unsigned int kMaxVertices = 64;   ///< Vértices únicos por meshlet.
+    static const unsigned int kMaxTriangles = 124; ///< Triángulos por meshlet.
+
+    /**
+     * @brief Genera los meshlets de la malla y reordena su LOD 0.
+     * @param mesh Malla con índices de 32 bits (antes de construir la cadena de LOD).
+     * @param stats Contadores acumulados (opcional).
+     */
+    static void build(MeshComponent& mesh, MeshletBuildStats* stats = nullptr);
+
+    /**
+     * @brief Calcula la esfera envolvente y el cono de normales de un rango de triángulos.
+     * @param vertices Vértices de la malla.
+     * @param indices Índices de la malla.
+     * @param meshlet Meshlet con indexOffset y triangleCount ya asignados.
+     */
+    static void computeBounds(const std::vector<SimpleVertex>& vertices,
+        const std::vector<unsigned int>& indices,
+        Meshlet& meshlet);
+};
+
+/**
+ * @class MeshletCuller
+ * @brief Culling por frame de los meshlets de una malla, cuatro clústeres por instrucción.
+ *
+ * @details
+ * Los volúmenes se guardan en grupos SoA de cuatro meshlets para evaluar con
+ * XMVECTOR los seis planos del frustum y el cono de normales de cuatro
+ * clústeres a la vez. Todo el test se hace en espacio del objeto: los planos
+ * se extraen de world * viewProjection (exacto también con escala no
+ * uniforme) y la cámara se lleva al espacio local. El cono solo es válido con
+ * escala uniforme y sin reflejo; en otro caso se desactiva.
+ */
+class MeshletCuller {
+public:
+    /**
+     * @brief Prepara los datos SoA a partir de los meshlets de una malla.
+     * @param meshlets Meshlets de la malla (pueden estar vacíos).
+     */
+    void init(const std::vector<Meshlet>& meshlets);
+
+    /// true si la malla tiene meshlets.
+    bool isEmpty() const { return m_ranges.empty(); }
+
+    /**
+     * @brief Descarta los meshlets invisibles y genera la lista compacta de rangos.
+     * @param worldViewProjection Matriz world * view * projection del actor.
+     * @param localEye Posición de la cámara en espacio del objeto.
+     * @param coneCulling true para aplicar el test del cono de normales.
+     * @param ranges Rangos visibles (se reemplazan); los meshlets contiguos se fusionan.
+     * @param stats Contadores (se acumulan).
+     */
+    void cull(const XMMATRIX& worldViewProjection,
+        const XMFLOAT3& localEye,
+        bool coneCulling,
+        std::vector<MeshletDrawRange>& ranges,
+        MeshletCullStats& stats) const;
+
+private:
+    /// Cuatro meshlets en formato SoA (una componente por XMFLOAT4).
+    struct Group {
+        XMFLOAT4 centerX, centerY, centerZ, radius;
+        XMFLOAT4 axisX, axisY, axisZ, cutoff;
+    };
+
+    std::vector<Group> m_groups;            ///< Volúmenes en grupos de cuatro.
+    std::vector<MeshletDrawRange> m_ranges; ///< Rango de índices de cada meshlet.
+};
@@ -1,8 +1,14 @@
 #pragma once
 #include "Prerequisites.h"
 #include "MeshComponent.h"
+#include "MeshTriangulator.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
 #include "fbxsdk.h"
 
+class JobSystem;
+
 /**
  * @class ModelLoader
  * @brief Carga y procesa modelos 3D en formatos OBJ y FBX.
@@ -63,10 +69,99 @@ public:
      */
     std::vector<std::string> GetTextureFileNames() const { return textureFileNames; }
 
+    /**
+     * @brief Guarda las mallas cargadas en formato cocinado (.vmesh).
+     * @param filePath Ruta de salida.
+     * @return true si el archivo se escribi correctamente.
+     */
+    bool SaveCookedModel(const std::string& filePath) const;
+
+    /**
+     * @brief Carga mallas desde un archivo cocinado (.vmesh) sin pasar por el FBX SDK.
+     * @param filePath Ruta del archivo cocinado.
+     * @return true si el archivo es vlido y se carg.
+     */
+    bool LoadCookedModel(const std::string& filePath);
+
+    /**
+     * @brief Interpreta mallas cocinadas (.vmesh) ya ledas en memoria.
+     * @param data Contenido completo del archivo cocinado.
+     * @param size Tamao en bytes.
+     * @return true si los datos son vlidos y se cargaron.
+     */
+    bool ParseCookedModel(const void* data, size_t size);
+
+    /**
+     * @brief Libera el administrador y la escena del FBX SDK.
+     */
+    void destroy();
+
+    /**
+     * @brief Asigna el JobSystem usado por las etapas paralelas de importacin.
+     * @param jobs Pool de hilos (nullptr = un solo hilo).
+     */
+    void setJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+
+    /**
+     * @brief Activa la codificacin compacta de vrtices (posicin snorm16, UV half).
+     * @param enabled true para cuantizar las mallas que pasen la comprobacin de error.
+     */
+    void setCompactVertices(bool enabled) { m_compactVertices = enabled; }
+
+    /**
+     * @brief Configura la cadena de LOD generada al importar.
+     * @param ratios Proporcin de tringulos de cada nivel (vaco = sin LODs).
+     */
+    void setLODChain(const std::vector<float>& ratios) { m_lodRatios = ratios; }
+
+    /**
+     * @brief Obtiene los contadores de la ltima generacin de LODs.
+     * @return Estadsticas acumuladas de la ltima carga.
+     */
+    const SimplificationStats& getSimplificationStats() const { return m_simplificationStats; }
+
+    /**
+     * @brief Obtiene los contadores de la ltima generacin de meshlets.
+     * @return Estadsticas acumuladas de la ltima carga.
+     */
+    const MeshletBuildStats& getMeshletStats() const { return m_meshletStats; }
+
+    /**
+     * @brief Obtiene los contadores de la ltima construccin de BVH de tringulos.
+     * @return Estadsticas acumuladas de la ltima carga.
+     */
+    const BVHBuildStats& getBVHStats() const { return m_bvhStats; }
+
+    /**
+     * @brief Obtiene los contadores de la ltima triangulacin.
+     * @return Estadsticas acumuladas de la ltima carga.
+     */
+    const TriangulationStats& getTriangulationStats() const { return m_triangulationStats; }
+
+    /**
+     * @brief Obtiene las mtricas de cach de vrtices de la ltima carga.
+     * @return Informe ACMR/ATVR acumulado de todas las mallas de la ltima carga.
+     */
+    const MeshOptimizationReport& getOptimizationReport() const { return m_optimizationReport; }
+
 private:
+    /**
+     * @brief Etapas comunes tras triangular: cach de vrtices, meshlets, LODs y formatos de GPU.
+     * @param mesh Malla triangulada (su informe de cach se suma a m_optimizationReport).
+     */
+    void processStages(MeshComponent& mesh);
+
     FbxManager* lSdkManager = nullptr; ///< Administrador de FBX SDK.
     FbxScene* lScene = nullptr;        ///< Escena FBX cargada.
     std::vector<std::string> textureFileNames; ///< Lista de texturas extradas.
+    JobSystem* m_jobs = nullptr;               ///< Pool para etapas paralelas (opcional).
+    TriangulationStats m_triangulationStats;   ///< Contadores de la ltima triangulacin.
+    MeshOptimizationReport m_optimizationReport; ///< Mtricas de la ltima optimizacin de ndices.
+    bool m_compactVertices = false;            ///< Cuantizar vrtices al importar.
+    std::vector<float> m_lodRatios{ 0.5f, 0.25f, 0.125f }; ///< Niveles de LOD generados al importar.
+    SimplificationStats m_simplificationStats; ///< Contadores de la ltima generacin de LODs.
+    MeshletBuildStats m_meshletStats;          ///< Contadores de la ltima generacin de meshlets.
+    BVHBuildStats m_bvhStats;                  ///< Contadores de la ltima construccin de BVH.
 
 public:
     std::string modelName; ///< Nombre del modelo cargado.
@@ -0,0 +1,251 @@
+﻿/**
+ * @file NullBackend.h
+ * @brief Backend sin GPU que graba los comandos en un stream binario y lleva la cuenta de los recursos.
+ */
+
+#pragma once
+#include "RenderBackend.h"
+#include "CommandStream.h"
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @struct NullBackendStats
+ * @brief Lo grabado desde el último reset().
+ */
+struct NullBackendStats {
+    unsigned int frames = 0;        ///< beginFrame() llamados.
+    unsigned int commands = 0;      ///< Comandos grabados (sin CMD_FRAME ni CMD_RESOURCE).
+    unsigned int binds = 0;         ///< Comandos que cambian estado enlazado (isBindCommand).
+    unsigned int draws = 0;         ///< DrawIndexed y DrawIndexedInstanced.
+    unsigned int instances = 0;     ///< Instancias dibujadas (1 por DrawIndexed).
+    uint64_t indices = 0;           ///< Índices dibujados por todas las instancias.
+    unsigned int uploads = 0;       ///< UpdateSubresource.
+    uint64_t uploadBytes = 0;       ///< Bytes de UpdateSubresource (los conocidos).
+    unsigned int maps = 0;          ///< Map.
+    uint64_t contentBytes = 0;      ///< Contenidos grabados en el stream (solo al capturar).
+    unsigned int resources = 0;     ///< Recursos distintos vistos.
+    size_t streamBytes = 0;         ///< Tamaño del stream.
+    unsigned int counts[COMMAND_OP_COUNT] = {}; ///< Comandos por tipo.
+};
+
+/**
+ * @struct HeadlessBenchmark
+ * @brief Frames completos de la aplicación (escena y envío) grabados en un NullBackend.
+ */
+struct HeadlessBenchmark {
+    unsigned int frames = 0;   ///< Frames grabados (0 = aún no se midió).
+    double updateMs = 0.0;     ///< Update de la escena, media por frame.
+    double renderMs = 0.0;     ///< Cola de dibujo y envío al backend, media por frame.
+    NullBackendStats backend;  ///< Lo grabado en todos los frames.
+};
+
+/**
+ * @struct NullResource
+ * @brief Lo que el backend sabe de un objeto que vio pasar.
+ */
+struct NullResource {
+    unsigned int id = 0;                     ///< Id en el stream (desde 1).
+    ResourceKind kind = RESOURCE_GENERIC;    ///< Tipo según su primer uso.
+    unsigned int bytes = 0;                  ///< Tamaño (0 = desconocido; Map lo necesita).
+    unsigned int flags = 0;                  ///< D3D11_BIND_FLAG de un buffer (0 = desconocido).
+    unsigned int binds = 0;                  ///< Veces que se enlazó.
+    unsigned int updates = 0;                ///< UpdateSubresource y Map sobre él.
+    uint64_t uploadBytes = 0;                ///< Bytes subidos con UpdateSubresource.
+    std::vector<uint8_t> mapped;             ///< Memoria que devuelve Map.
+    std::vector<uint8_t> contents;           ///< Último contenido grabado de mapped (solo al capturar).
+};
+
+/**
+ * @class NullBackend
+ * @brief Graba cada comando en un CommandWriter en lugar de enviarlo a la GPU.
+ *
+ * @details
+ * Sirve para medir sin driver el coste de CPU del envío, los draws y los
+ * cambios de estado de frames reales: DeviceContext::setBackend() lo pone
+ * detrás del contexto y todo lo que pasa la caché de estado acaba aquí.
+ * Los objetos solo se usan como claves: nunca se llama a sus métodos ni se
+ * retienen, así que valen tanto los de Device como las asas que crea
+ * createResource() sin dispositivo. Map devuelve memoria propia del tamaño
+ * conocido (createResource() o setResourceBytes()); sin tamaño falla.
+ * No depende de Windows ni de Direct3D.
+ */
+class NullBackend : public RenderBackend {
+public:
+    /** @brief Marca el comienzo de un frame en el stream. */
+    void beginFrame();
+
+    /** @brief Vacía el stream, los contadores y los recursos conocidos (las asas creadas siguen valiendo). */
+    virtual void reset();
+
+    /**
+     * @brief Crea un asa propia del backend, con tipo, tamaño y flags ya conocidos.
+     * @details Hace las veces de un objeto de Device para grabar frames sin
+     *          dispositivo; vive lo que el backend.
+     * @param kind Tipo de recurso.
+     * @param bytes Tamaño en bytes (0 = desconocido; Map lo necesita).
+     * @param flags D3D11_BIND_FLAG de un buffer (0 = desconocido).
+     * @return Asa opaca del tipo pedido.
+     */
+    template <typename T>
+    T* createResource(ResourceKind kind, unsigned int bytes = 0, unsigned int flags = 0) {
+        return static_cast<T*>(createHandle(kind, bytes, flags));
+    }
+
+    /**
+     * @brief Da el tamaño de un recurso (para Map y el stream).
+     * @param resource Recurso.
+     * @param bytes Tamaño en bytes.
+     */
+    void setResourceBytes(const void* resource, unsigned int bytes);
+
+    /** @brief Recurso visto (nullptr si no pasó por el backend). */
+    const NullResource* findResource(const void* resource) const;
+
+    /** @brief Stream grabado desde el último reset(). */
+    const std::vector<uint8_t>& getStream() const { return m_writer.getData(); }
+
+    /** @brief Contadores desde el último reset(). */
+    NullBackendStats getStats() const;
+
+    const char* getName() const override { return "Null"; }
+    bool supportsConstantOffsets() const override { return true; }
+
+    void ClearState() override;
+    void RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) override;
+    void PSSetShaderResources(unsigned int StartSlot,
+        unsigned int NumViews,
+        ID3D11ShaderResourceView* const* ppShaderResourceViews) override;
+    void IASetInputLayout(ID3D11InputLayout* pInputLayout) override;
+    void VSSetShader(ID3D11VertexShader* pVertexShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) override;
+    void PSSetShader(ID3D11PixelShader* pPixelShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) override;
+    void UpdateSubresource(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        const BackendBox* pDstBox,
+        const void* pSrcData,
+        unsigned int SrcRowPitch,
+        unsigned int SrcDepthPitch,
+        unsigned int SrcBytes) override;
+    BackendResult Map(ID3D11Resource* pResource,
+        unsigned int Subresource,
+        unsigned int MapType,
+        unsigned int MapFlags,
+        BackendMappedSubresource* pMappedResource) override;
+    void Unmap(ID3D11Resource* pResource, unsigned int Subresource) override;
+    void CopySubresourceRegion(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        unsigned int DstX,
+        unsigned int DstY,
+        unsigned int DstZ,
+        ID3D11Resource* pSrcResource,
+        unsigned int SrcSubresource,
+        const BackendBox* pSrcBox) override;
+    void IASetVertexBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppVertexBuffers,
+        const unsigned int* pStrides,
+        const unsigned int* pOffsets) override;
+    void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+        unsigned int Format,
+        unsigned int Offset) override;
+    void PSSetSamplers(unsigned int StartSlot,
+        unsigned int NumSamplers,
+        ID3D11SamplerState* const* ppSamplers) override;
+    void RSSetState(ID3D11RasterizerState* pRasterizerState) override;
+    void OMSetBlendState(ID3D11BlendState* pBlendState,
+        const float BlendFactor[4],
+        unsigned int SampleMask) override;
+    void OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+        unsigned int StencilRef) override;
+    void OMSetRenderTargets(unsigned int NumViews,
+        ID3D11RenderTargetView* const* ppRenderTargetViews,
+        ID3D11DepthStencilView* pDepthStencilView) override;
+    void IASetPrimitiveTopology(unsigned int Topology) override;
+    void ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+        const float ColorRGBA[4]) override;
+    void ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+        unsigned int ClearFlags,
+        float Depth,
+        uint8_t Stencil) override;
+    void VSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) override;
+    void PSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) override;
+    void VSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) override;
+    void PSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) override;
+    BackendResult FinishCommandList(bool RestoreDeferredContextState,
+        ID3D11CommandList** ppCommandList) override;
+    void ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) override;
+    void DrawIndexed(unsigned int IndexCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation) override;
+    void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+        unsigned int InstanceCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation,
+        unsigned int StartInstanceLocation) override;
+
+protected:
+    /// Escribe el código de un comando y lo cuenta.
+    void command(CommandOp op);
+
+    /// Registro de un objeto (lo declara en el stream la primera vez).
+    NullResource& resource(const void* object, ResourceKind kind);
+
+    /// Completa tipo, tamaño y flags de un objeto nuevo antes de declararlo (los de createResource()).
+    virtual void describeResource(const void* object, NullResource& entry);
+
+    /// Reserva un asa de createResource() y guarda su descripción.
+    void* createHandle(ResourceKind kind, unsigned int bytes, unsigned int flags);
+
+    /// Escribe CMD_RESOURCE con lo que se sabe del objeto.
+    void declare(const NullResource& entry);
+
+    /// Caja opcional: 0, o 1 y sus seis coordenadas.
+    void writeBox(const BackendBox* box);
+
+    /// Id de un objeto enlazado (0 = nullptr); cuenta el bind. Va antes de command(): puede declararlo.
+    unsigned int bind(const void* object, ResourceKind kind);
+
+    /// bind() de count objetos, con los ids en m_ids.
+    template <typename T>
+    void bindAll(unsigned int count, T* const* objects, ResourceKind kind) {
+        m_ids.resize(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            m_ids[i] = bind(objects[i], kind);
+        }
+    }
+
+    /// Comando con inicio, número e ids de objetos enlazados.
+    template <typename T>
+    void writeSlots(CommandOp op, unsigned int start, unsigned int count, T* const* objects, ResourceKind kind) {
+        bindAll(count, objects, kind);
+        command(op);
+        m_writer.u32(start);
+        m_writer.u32(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            m_writer.u32(m_ids[i]);
+        }
+    }
+
+    CommandWriter m_writer;                                      ///< Stream grabado.
+    std::unordered_map<const void*, NullResource> m_resources;   ///< Objetos vistos.
+    std::unordered_map<const void*, std::unique_ptr<NullResource>> m_handles; ///< Asas de createResource() (la clave es el asa).
+    NullBackendStats m_stats;                                    ///< Contadores.
+    std::vector<unsigned int> m_ids;                             ///< Ids de un comando con ranuras.
+    bool m_recordContents = false;                               ///< Graba los datos de UpdateSubresource.
+};
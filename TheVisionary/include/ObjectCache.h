@@ -0,0 +1,133 @@
+﻿/**
+ * @file ObjectCache.h
+ * @brief Caché de objetos de estado y shaders del dispositivo, compartidos entre quienes los piden iguales.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <mutex>
+#include <unordered_map>
+
+/** Tipo de objeto guardado en la caché. */
+enum CachedObjectType {
+    CACHED_SAMPLER = 0,
+    CACHED_BLEND,
+    CACHED_RASTERIZER,
+    CACHED_DEPTH_STENCIL,
+    CACHED_VERTEX_SHADER,
+    CACHED_PIXEL_SHADER,
+    CACHED_TYPE_COUNT
+};
+
+/**
+ * @struct ObjectCacheStats
+ * @brief Aciertos y fallos por tipo desde el último resetStats().
+ */
+struct ObjectCacheStats {
+    unsigned int hits[CACHED_TYPE_COUNT] = {};   ///< Peticiones servidas con un objeto existente.
+    unsigned int misses[CACHED_TYPE_COUNT] = {}; ///< Peticiones que crearon (o compilaron) el objeto.
+    unsigned int objects = 0;                    ///< Objetos en la caché.
+
+    unsigned int getHits() const {
+        unsigned int total = 0;
+        for (unsigned int hit : hits) {
+            total += hit;
+        }
+        return total;
+    }
+
+    unsigned int getMisses() const {
+        unsigned int total = 0;
+        for (unsigned int miss : misses) {
+            total += miss;
+        }
+        return total;
+    }
+};
+
+/**
+ * @class ObjectCache
+ * @brief Objetos de Direct3D indexados por el hash de su descriptor completo
+ *        (o del código, punto de entrada y perfil de un shader).
+ *
+ * @details
+ * Cada entrada guarda la clave entera, así que dos descriptores con el mismo
+ * hash nunca comparten objeto. La caché conserva una referencia propia de
+ * cada objeto y find() entrega otra al llamador, que la suelta como si lo
+ * hubiera creado (SAFE_RELEASE en su destroy()). Los shaders guardan además
+ * su bytecode para crear Input Layouts. Es segura entre hilos: el streamer
+ * puede crear recursos fuera del hilo principal. Como find() y la creación
+ * no van bajo el mismo lock, dos hilos pueden crear el mismo objeto; insert()
+ * vuelve a buscar con el lock tomado y, si otro ya lo guardó, devuelve ese
+ * para que todos compartan uno.
+ */
+class ObjectCache {
+public:
+    /**
+     * @brief Busca un objeto.
+     * @param type Tipo del objeto.
+     * @param key Descriptor (bytes sin relleno indefinido) o clave del shader.
+     * @param size Bytes de key.
+     * @param bytecode Si no es nullptr, recibe el bytecode del shader con una referencia.
+     * @return Objeto con una referencia para el llamador, o nullptr (fallo contado).
+     */
+    IUnknown* find(CachedObjectType type, const void* key, size_t size, ID3DBlob** bytecode = nullptr);
+
+    /**
+     * @brief Guarda un objeto recién creado (la caché toma su propia referencia).
+     * @details Si otro hilo guardó antes un objeto con la misma clave, no se
+     * guarda el nuevo y se devuelve el existente. En ambos casos el llamador
+     * recibe una referencia del objeto devuelto y suelta la del que creó.
+     * @param bytecode Bytecode de un shader (nullptr para los estados).
+     * @param sharedBytecode Si no es nullptr, recibe con una referencia el bytecode que va con el objeto devuelto.
+     * @return Objeto que debe usar el llamador, con una referencia para él (nullptr si object lo es).
+     */
+    IUnknown* insert(CachedObjectType type,
+        const void* key,
+        size_t size,
+        IUnknown* object,
+        ID3DBlob* bytecode = nullptr,
+        ID3DBlob** sharedBytecode = nullptr);
+
+    /**
+     * @brief Desactiva la caché: find() siempre falla e insert() no guarda (para medir).
+     */
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+
+    /** @brief true si la caché está activa. */
+    bool isEnabled() const { return m_enabled; }
+
+    /** @brief Suelta las referencias de la caché. */
+    void clear();
+
+    /** @brief Aciertos, fallos y objetos guardados. */
+    ObjectCacheStats getStats() const;
+
+    /** @brief Pone a cero los contadores. */
+    void resetStats();
+
+    /**
+     * @brief Clave de un shader: código, punto de entrada y perfil.
+     * @param source Código HLSL.
+     * @param entryPoint Punto de entrada.
+     * @param profile Perfil (p. ej. "ps_4_0").
+     */
+    static std::string shaderKey(const std::string& source, const char* entryPoint, const char* profile);
+
+private:
+    /// Objeto guardado y la clave completa con la que se creó.
+    struct Entry {
+        CachedObjectType type;
+        std::string key;
+        IUnknown* object;
+        ID3DBlob* bytecode;
+    };
+
+    /// Entrada con esa clave exacta o nullptr (con m_mutex tomado).
+    const Entry* lookup(CachedObjectType type, const void* key, size_t size, uint64_t hash) const;
+
+    mutable std::mutex m_mutex;                           ///< Protege la tabla y los contadores.
+    std::unordered_multimap<uint64_t, Entry> m_entries;   ///< Objetos por hash de tipo y clave.
+    ObjectCacheStats m_stats;                             ///< Contadores.
+    bool m_enabled = true;                                ///< false = siempre crear.
+};
@@ -0,0 +1,160 @@
+﻿/**
+ * @file OcclusionBuffer.h
+ * @brief Rasterizador de profundidad por software (baja resolución, por tiles) para occlusion culling en CPU.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "BoundingVolume.h"
+
+class JobSystem;
+
+/**
+ * @struct OcclusionStats
+ * @brief Coste y resultado del occlusion culling de un frame.
+ */
+struct OcclusionStats {
+    unsigned int occluders = 0;   ///< Mallas rasterizadas como oclusores.
+    unsigned int triangles = 0;   ///< Triángulos de oclusores enviados.
+    unsigned int rasterized = 0;  ///< Triángulos que llegaron a algún tile (frontales y delante del plano cercano).
+    unsigned int tested = 0;      ///< Volúmenes probados.
+    unsigned int occluded = 0;    ///< Volúmenes ocultos.
+    double rasterMs = 0.0;        ///< Transformación, binning y rasterizado.
+    double testMs = 0.0;          ///< Pruebas de los volúmenes.
+
+    /// Porcentaje de volúmenes probados que resultaron ocultos.
+    float getCulledPercent() const { return tested ? 100.0f * occluded / tested : 0.0f; }
+};
+
+/**
+ * @struct OcclusionGoldenResult
+ * @brief Comparación de la escena de prueba con su buffer de profundidad de referencia.
+ */
+struct OcclusionGoldenResult {
+    bool goldenFound = false;      ///< Existía el archivo de referencia (si falta, la prueba falla).
+    bool rewritten = false;        ///< Se pidió rewrite y la referencia se escribió con el resultado actual.
+    bool sizeMatches = false;      ///< Misma resolución que la referencia.
+    unsigned int mismatched = 0;   ///< Píxeles con diferencia mayor que la tolerancia.
+    float maxError = 0.0f;         ///< Mayor diferencia de profundidad.
+    bool serialMatchesParallel = false; ///< El rasterizado en paralelo da el mismo buffer.
+    bool visibilityMatches = false;     ///< Las pruebas de volúmenes dieron lo esperado.
+
+    /// true si todo coincide.
+    bool passed() const {
+        return goldenFound && sizeMatches && mismatched == 0 && serialMatchesParallel && visibilityMatches;
+    }
+};
+
+/**
+ * @class OcclusionBuffer
+ * @brief Buffer de profundidad de baja resolución en el que se rasterizan oclusores y se prueban volúmenes.
+ *
+ * @details
+ * Cada frame se llama a begin() con la view-projection, addOccluder() por
+ * cada malla oclusora y rasterize(); después isVisible() prueba AABB en
+ * mundo. Los triángulos se transforman y se reparten en tiles de
+ * kTileWidth x kTileHeight píxeles; cada tile se rasteriza en un job propio
+ * evaluando las funciones de arista y la profundidad de cuatro píxeles por
+ * XMVECTOR, así que el resultado no depende del número de hilos.
+ *
+ * Cada tile guarda la profundidad máxima (la más lejana) de sus píxeles:
+ * un volumen cuya profundidad mínima no es menor que ella está oculto en
+ * todo el tile sin mirar píxeles. El rasterizado es conservador: los
+ * triángulos de espaldas o que cruzan el plano cercano no ocultan nada, y
+ * los volúmenes que cruzan el plano cercano siempre son visibles.
+ *
+ * No depende de Direct3D: la escena de prueba de checkGolden() se
+ * rasteriza sin dispositivo y se compara con un buffer de referencia.
+ */
+class OcclusionBuffer {
+public:
+    static const unsigned int kTileWidth = 32;  ///< Ancho de un tile (múltiplo de 4).
+    static const unsigned int kTileHeight = 16; ///< Alto de un tile.
+
+    /**
+     * @brief Reserva el buffer.
+     * @param width Ancho en píxeles (se redondea a múltiplo de kTileWidth).
+     * @param height Alto en píxeles (se redondea a múltiplo de kTileHeight).
+     */
+    void init(unsigned int width = 320, unsigned int height = 192);
+
+    /**
+     * @brief Empieza un frame: vacía los tiles y fija la cámara.
+     * @param viewProjection Matriz view * projection (vectores fila, z de D3D en [0, w]).
+     */
+    void begin(const XMMATRIX& viewProjection);
+
+    /**
+     * @brief Transforma y reparte en tiles los triángulos de un oclusor.
+     * @param vertices Vértices de la malla.
+     * @param indices Primer índice del rango a rasterizar (p. ej. el LOD más simple).
+     * @param indexCount Índices del rango.
+     * @param world Matriz de mundo.
+     */
+    void addOccluder(const std::vector<SimpleVertex>& vertices,
+        const unsigned int* indices,
+        unsigned int indexCount,
+        const XMMATRIX& world);
+
+    /**
+     * @brief Rasteriza los tiles y calcula su profundidad máxima.
+     * @param jobs Pool para repartir tiles (nullptr = un hilo).
+     */
+    void rasterize(JobSystem* jobs);
+
+    /**
+     * @brief Prueba una AABB en mundo contra el buffer.
+     * @param bounds Volúmenes en mundo (vacío = visible).
+     * @return false si queda por completo detrás de los oclusores.
+     */
+    bool isVisible(const MeshBounds& bounds);
+
+    /** @brief Contadores del frame (la prueba de volúmenes los va sumando). */
+    const OcclusionStats& getStats() const { return m_stats; }
+
+    /** @brief Profundidad por píxel (fila a fila, 1 = vacío). */
+    const std::vector<float>& getDepth() const { return m_depth; }
+
+    /** @brief Ancho del buffer. */
+    unsigned int getWidth() const { return m_width; }
+
+    /** @brief Alto del buffer. */
+    unsigned int getHeight() const { return m_height; }
+
+    /**
+     * @brief Guarda la profundidad en un archivo binario (cabecera 'VOCC', ancho, alto y floats).
+     * @return false si no se pudo escribir.
+     */
+    bool saveDepth(const std::string& filePath) const;
+
+    /**
+     * @brief Rasteriza una escena fija sin dispositivo y la compara con su referencia.
+     * @details La escena solo usa matrices sin trigonometría para que la
+     * referencia no dependa de la implementación de seno y coseno.
+     * @param goldenPath Archivo de referencia versionado; si no existe la prueba falla.
+     * @param rewrite true para regenerar la referencia con el resultado actual en lugar de compararla.
+     * @param jobs Pool para comprobar que el rasterizado paralelo da el mismo buffer.
+     */
+    static OcclusionGoldenResult checkGolden(const std::string& goldenPath, bool rewrite, JobSystem* jobs);
+
+private:
+    /// Triángulo en pantalla (píxeles) con profundidad z/w por vértice.
+    struct ScreenTriangle {
+        float x[3], y[3], z[3];
+    };
+
+    /// Rasteriza los triángulos de un tile.
+    void rasterizeTile(unsigned int tile);
+
+    unsigned int m_width = 0;           ///< Ancho en píxeles.
+    unsigned int m_height = 0;          ///< Alto en píxeles.
+    unsigned int m_tilesX = 0;          ///< Tiles por fila.
+    unsigned int m_tilesY = 0;          ///< Filas de tiles.
+    XMMATRIX m_viewProjection;          ///< Cámara del frame.
+    std::vector<float> m_depth;         ///< Profundidad por píxel.
+    std::vector<float> m_tileMaxDepth;  ///< Profundidad más lejana de cada tile.
+    std::vector<ScreenTriangle> m_triangles;      ///< Triángulos del frame.
+    std::vector<std::vector<unsigned int>> m_bins; ///< Triángulos que tocan cada tile.
+    std::vector<XMFLOAT4> m_clip;       ///< Vértices en clip del oclusor en curso.
+    OcclusionStats m_stats;             ///< Contadores del frame.
+};
@@ -20,6 +20,12 @@
 #include <d3d11.h>
 #include <d3dx11.h>
 #include <d3dcompiler.h>
+// Direct3D 11.1 (offsets en constant buffers): sus headers vienen con el Windows SDK, no con el
+// DirectX SDK de junio de 2010. Se activa definiendo VISIONARY_D3D11_1 cuando el Windows SDK va
+// antes que $(DXSDK_DIR)Include; sin l las constantes se quedan en los buffers de cada objeto.
+#if defined(VISIONARY_D3D11_1)
+#include <d3d11_1.h>
+#endif
 #include "Resource.h"
 #include "resource.h"
 
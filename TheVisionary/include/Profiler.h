@@ -0,0 +1,297 @@
+﻿/**
+ * @file Profiler.h
+ * @brief Profiler jerárquico de CPU: zonas por hilo, contadores, estadísticas por frame y trazas de Chrome.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+/** Tipo de un evento del profiler. */
+enum ProfileEventType : uint8_t { PROFILE_BEGIN = 0, PROFILE_END, PROFILE_COUNTER };
+
+/**
+ * @struct ProfileEvent
+ * @brief Evento en el anillo de un hilo.
+ */
+struct ProfileEvent {
+    int64_t ticks = 0;            ///< Instante (steady_clock).
+    const char* name = nullptr;   ///< Zona o contador (literal; nullptr en PROFILE_END).
+    double value = 0.0;           ///< Valor del contador.
+    ProfileEventType type = PROFILE_BEGIN; ///< Qué marca.
+};
+
+/**
+ * @struct ProfileZoneStats
+ * @brief Una zona del árbol de un hilo, con los tiempos de la última ventana.
+ */
+struct ProfileZoneStats {
+    const char* name = nullptr;   ///< Nombre de la zona.
+    unsigned int thread = 0;      ///< Índice en getThreads().
+    unsigned int depth = 0;       ///< Anidamiento (0 = raíz del hilo).
+    double calls = 0.0;           ///< Llamadas por frame.
+    double avgMs = 0.0;           ///< Tiempo inclusivo medio por frame.
+    double maxMs = 0.0;           ///< Tiempo inclusivo del peor frame.
+    double selfMs = 0.0;          ///< Media por frame sin las zonas hijas.
+    double peakMs = 0.0;          ///< Peor frame desde que apareció la zona (también sin llamadas en la ventana).
+};
+
+/**
+ * @struct ProfileCounterStats
+ * @brief Un contador con los valores de la última ventana.
+ */
+struct ProfileCounterStats {
+    const char* name = nullptr;   ///< Nombre del contador.
+    double last = 0.0;            ///< Último valor.
+    double average = 0.0;         ///< Media de las muestras.
+    double max = 0.0;             ///< Valor más alto.
+    unsigned int samples = 0;     ///< Muestras de la ventana.
+};
+
+/**
+ * @struct ProfileThreadStats
+ * @brief Un hilo que registró eventos.
+ */
+struct ProfileThreadStats {
+    unsigned int id = 0;          ///< Identificador del sistema.
+    std::string name;             ///< Nombre (setThreadName) o "Thread <id>".
+    unsigned int dropped = 0;     ///< Eventos perdidos con el anillo lleno en la ventana.
+};
+
+/**
+ * @struct ProfilerStats
+ * @brief Resumen de la última ventana del profiler.
+ */
+struct ProfilerStats {
+    unsigned int frames = 0;          ///< Frames de la ventana (0 = aún no hay una completa).
+    double eventsPerFrame = 0.0;      ///< Eventos recogidos por frame.
+    double collectMs = 0.0;           ///< Coste medio de beginFrame() (recogida y árbol).
+    unsigned int dropped = 0;         ///< Eventos perdidos en la ventana (todos los hilos).
+    unsigned int captureFrames = 0;   ///< Frames que le quedan a la traza en curso.
+};
+
+/**
+ * @struct ProfileNode
+ * @brief Nodo del árbol de zonas de un hilo (misma zona bajo el mismo padre).
+ */
+struct ProfileNode {
+    const char* name = nullptr;   ///< Nombre de la zona.
+    unsigned int thread = 0;      ///< Hilo del nodo.
+    int parent = -1;              ///< Nodo padre (-1 = raíz).
+    int firstChild = -1;          ///< Primer hijo.
+    int nextSibling = -1;         ///< Siguiente hermano.
+    unsigned int depth = 0;       ///< Anidamiento.
+    int64_t frameTicks = 0;       ///< Tiempo del frame en curso.
+    unsigned int frameCalls = 0;  ///< Llamadas del frame en curso.
+    int64_t windowTicks = 0;      ///< Suma de la ventana.
+    int64_t windowMax = 0;        ///< Peor frame de la ventana.
+    uint64_t windowCalls = 0;     ///< Llamadas de la ventana.
+    int64_t peak = 0;             ///< Peor frame desde que apareció.
+};
+
+struct ProfileThread;
+
+/**
+ * @class Profiler
+ * @brief Recoge las zonas de todos los hilos una vez por frame y publica sus medias.
+ *
+ * @details
+ * Cada hilo escribe en su propio anillo de eventos sin bloqueos (un solo
+ * productor, el hilo, y un solo consumidor, beginFrame()); el mutex solo se
+ * toma al registrar un hilo nuevo y al recoger. Con el anillo lleno las
+ * zonas nuevas se pierden enteras (apertura y cierre) y se cuentan en
+ * dropped. Desactivado, una zona cuesta una lectura atómica relajada; con
+ * VISIONARY_NO_PROFILER las macros desaparecen.
+ *
+ * Los nombres de zonas y contadores deben ser literales: se guardan sin
+ * copiar en los anillos, el árbol y la traza.
+ */
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static const unsigned int kWindow = 120;          ///< Frames por ventana de estadísticas.
+    static const size_t kMaxTraceEvents = 1 << 21;    ///< Eventos máximos de una traza.
+
+    /** @brief Profiler del proceso. */
+    static Profiler& get();
+
+    /** @brief true si las zonas se registran (coste del camino desactivado). */
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /** @brief Activa o desactiva el registro (las zonas abiertas se cierran igualmente). */
+    static void setEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * @brief Nombre del hilo que llama en el panel y en las trazas.
+     * @param name Literal; se usa al registrar el hilo con su primer evento.
+     */
+    static void setThreadName(const char* name);
+
+    /** @brief Abre una zona en el hilo que llama. */
+    static void beginZone(const char* name);
+
+    /** @brief Cierra la última zona abierta del hilo que llama. */
+    static void endZone();
+
+    /**
+     * @brief Anota el valor de un contador.
+     * @param name Literal con el nombre.
+     * @param value Valor.
+     */
+    static void counter(const char* name, double value);
+
+    /**
+     * @brief Frontera de frame: recoge los anillos, cierra el frame en el árbol y avanza la traza.
+     * @note Solo desde el hilo principal, una vez por frame.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Graba los siguientes frames como traza de Chrome (chrome://tracing, Perfetto).
+     * @param frames Frames a grabar (activa el profiler).
+     * @param path Archivo JSON que se escribe al terminar.
+     * @return false si ya hay una traza en curso.
+     */
+    bool startCapture(unsigned int frames, const std::string& path);
+
+    /** @brief true mientras se graba una traza. */
+    bool isCapturing() const { return m_captureFrames > 0; }
+
+    /** @brief Resumen de la última ventana. */
+    const ProfilerStats& getStats() const { return m_stats; }
+
+    /** @brief Zonas de la última ventana, por hilo y en orden de árbol. */
+    const std::vector<ProfileZoneStats>& getZones() const { return m_zones; }
+
+    /** @brief Contadores de la última ventana. */
+    const std::vector<ProfileCounterStats>& getCounters() const { return m_counters; }
+
+    /** @brief Hilos registrados. */
+    const std::vector<ProfileThreadStats>& getThreads() const { return m_threadStats; }
+
+private:
+    /**
+     * @struct TraceEvent
+     * @brief Evento completo de una traza.
+     */
+    struct TraceEvent {
+        const char* name;      ///< Zona, contador o nullptr (frontera de frame).
+        unsigned int thread;   ///< Índice del hilo.
+        int64_t start;         ///< Inicio (ticks).
+        int64_t duration;      ///< Duración (ticks; 0 en contadores y fronteras).
+        double value;          ///< Valor del contador o número de frame.
+        char phase;            ///< 'X' zona, 'C' contador, 'i' frontera de frame.
+    };
+
+    /**
+     * @struct CounterAccum
+     * @brief Muestras de un contador en la ventana en curso.
+     */
+    struct CounterAccum {
+        const char* name;      ///< Nombre.
+        double last;           ///< Último valor.
+        double sum;            ///< Suma.
+        double max;            ///< Valor más alto.
+        unsigned int samples;  ///< Muestras.
+    };
+
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /** @brief Anillo del hilo que llama (lo registra con su primer evento). */
+    static ProfileThread& currentThread();
+
+    /** @brief Registra el hilo que llama (reutiliza el anillo de un hilo terminado). */
+    ProfileThread* registerThread();
+
+    /** @brief Hijo de parent con ese nombre en el hilo (lo crea si no existe). */
+    int findNode(ProfileThread& thread, int parent, const char* name);
+
+    /** @brief Pasa los eventos de un hilo al árbol, los contadores y la traza. */
+    void consume(ProfileThread& thread);
+
+    /**
+     * @brief Añade a m_zones una lista de hermanos y sus descendientes.
+     * @param first Primer nodo de la lista (-1 = ninguno).
+     * @param frames Frames de la ventana.
+     */
+    void appendZones(int first, double frames);
+
+    /** @brief Copia identificador y nombre de cada hilo a m_threadStats (con m_threadsMutex). */
+    void refreshThreads();
+
+    /** @brief Publica la ventana en curso en m_zones, m_counters y m_stats. */
+    void publishWindow();
+
+    /** @brief Escribe la traza grabada en formato JSON de Chrome. */
+    bool writeChromeTrace(const std::string& path) const;
+
+    static std::atomic<bool> s_enabled;                    ///< Registro activado.
+
+    std::mutex m_threadsMutex;                             ///< Protege m_threads (registro y recogida).
+    std::vector<std::unique_ptr<ProfileThread>> m_threads; ///< Anillos y estado de cada hilo.
+
+    std::vector<ProfileNode> m_nodes;                      ///< Árbol de zonas de todos los hilos.
+    std::vector<CounterAccum> m_counterAccum;              ///< Contadores de la ventana en curso.
+    unsigned int m_windowFrames = 0;                       ///< Frames de la ventana en curso.
+    uint64_t m_windowEvents = 0;                           ///< Eventos de la ventana en curso.
+    double m_windowCollectMs = 0.0;                        ///< Coste de beginFrame() en la ventana.
+    uint64_t m_frame = 0;                                  ///< Fronteras de frame vistas.
+
+    std::vector<TraceEvent> m_trace;                       ///< Traza en curso.
+    unsigned int m_captureFrames = 0;                      ///< Frames que le quedan a la traza.
+    int64_t m_captureStart = 0;                            ///< Comienzo de la traza (ticks).
+    std::string m_capturePath;                             ///< Destino de la traza.
+
+    ProfilerStats m_stats;                                 ///< Última ventana.
+    std::vector<ProfileZoneStats> m_zones;                 ///< Zonas de la última ventana.
+    std::vector<ProfileCounterStats> m_counters;           ///< Contadores de la última ventana.
+    std::vector<ProfileThreadStats> m_threadStats;         ///< Hilos registrados.
+};
+
+/**
+ * @class ProfileScope
+ * @brief Zona del profiler que dura lo que el ámbito (PROFILE_SCOPE).
+ */
+class ProfileScope {
+public:
+    /** @brief Abre la zona si el profiler está activado. */
+    explicit ProfileScope(const char* name) : m_active(Profiler::isEnabled()) {
+        if (m_active) {
+            Profiler::beginZone(name);
+        }
+    }
+
+    /** @brief Cierra la zona si se abrió. */
+    ~ProfileScope() {
+        if (m_active) {
+            Profiler::endZone();
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    bool m_active; ///< La zona se abrió (el profiler estaba activado).
+};
+
+// === Macros ===
+#if defined(VISIONARY_NO_PROFILER)
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+/** Zona con el nombre dado (literal) hasta el final del ámbito. */
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+/** Valor de un contador (literal) en el frame. */
+#define PROFILE_COUNTER(name, value) \
+    do { if (Profiler::isEnabled()) Profiler::counter(name, static_cast<double>(value)); } while (0)
+#endif
@@ -40,6 +40,9 @@ public:
     /** @brief Libera los recursos asociados. */
     void destroy();
 
+    /// @return Puntero nativo al estado de rasterizacin.
+    ID3D11RasterizerState* raw() const { return m_rasterizerState; }
+
 private:
     /** @brief Puntero al estado de rasterizacin de Direct3D 11. */
     ID3D11RasterizerState* m_rasterizerState = nullptr;
@@ -0,0 +1,225 @@
+﻿/**
+ * @file RenderBackend.h
+ * @brief Interfaz de los comandos de dibujo sobre la que se apoya DeviceContext.
+ */
+
+#pragma once
+#include <cstdint>
+
+// Asas opacas: aquí solo se declaran; únicamente D3D11Backend ve su definición.
+struct ID3D11Resource;
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11ClassInstance;
+struct ID3D11SamplerState;
+struct ID3D11RasterizerState;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+struct ID3D11CommandList;
+
+/// Resultado de un comando (el mismo tipo que HRESULT: negativo = fallo).
+typedef long BackendResult;
+
+// Los códigos son de 32 bits con signo: negativos también donde long tiene 64.
+const BackendResult BACKEND_OK = 0;                                                                          ///< S_OK.
+const BackendResult BACKEND_INVALID_ARG = static_cast<BackendResult>(static_cast<int32_t>(0x80070057u));     ///< E_INVALIDARG.
+const BackendResult BACKEND_NOT_IMPLEMENTED = static_cast<BackendResult>(static_cast<int32_t>(0x80004001u)); ///< E_NOTIMPL.
+
+/** @brief true si el resultado es un fallo (como FAILED()). */
+inline bool isBackendFailure(BackendResult result) { return result < 0; }
+
+/**
+ * @enum BackendMap
+ * @brief Tipos de Map que distinguen los backends (mismos valores que D3D11_MAP).
+ */
+enum BackendMap {
+    BACKEND_MAP_WRITE_DISCARD = 4,      ///< D3D11_MAP_WRITE_DISCARD.
+    BACKEND_MAP_WRITE_NO_OVERWRITE = 5  ///< D3D11_MAP_WRITE_NO_OVERWRITE.
+};
+
+/**
+ * @struct BackendViewport
+ * @brief Viewport con la misma disposición que D3D11_VIEWPORT.
+ */
+struct BackendViewport {
+    float TopLeftX = 0.0f;
+    float TopLeftY = 0.0f;
+    float Width = 0.0f;
+    float Height = 0.0f;
+    float MinDepth = 0.0f;
+    float MaxDepth = 1.0f;
+};
+
+/**
+ * @struct BackendBox
+ * @brief Caja de un recurso con la misma disposición que D3D11_BOX.
+ */
+struct BackendBox {
+    unsigned int left = 0;
+    unsigned int top = 0;
+    unsigned int front = 0;
+    unsigned int right = 0;
+    unsigned int bottom = 0;
+    unsigned int back = 0;
+};
+
+/**
+ * @struct BackendMappedSubresource
+ * @brief Memoria devuelta por Map, con la misma disposición que D3D11_MAPPED_SUBRESOURCE.
+ */
+struct BackendMappedSubresource {
+    void* pData = nullptr;
+    unsigned int RowPitch = 0;
+    unsigned int DepthPitch = 0;
+};
+
+/**
+ * @class RenderBackend
+ * @brief Destino de los comandos que DeviceContext deja pasar tras validarlos y filtrarlos.
+ *
+ * @details
+ * DeviceContext conserva la validación, la caché de estado y el seguimiento
+ * de subidas; el backend solo ejecuta (D3D11Backend) o graba (NullBackend)
+ * lo que queda. La interfaz no depende de Windows ni de Direct3D: recursos,
+ * vistas, shaders y estados son asas opacas, y formatos, topologías y tipos
+ * de Map van como enteros con los valores de D3D11. Los nombres y parámetros
+ * son los de ID3D11DeviceContext para que el paso de uno a otro sea directo.
+ */
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    /** @brief Nombre para el log y la UI. */
+    virtual const char* getName() const = 0;
+
+    /** @brief true si admite VS/PSSetConstantBuffers1 (offsets en constant buffers). */
+    virtual bool supportsConstantOffsets() const = 0;
+
+    /** Devuelve el pipeline al estado por defecto. */
+    virtual void ClearState() = 0;
+
+    virtual void RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) = 0;
+
+    virtual void PSSetShaderResources(unsigned int StartSlot,
+        unsigned int NumViews,
+        ID3D11ShaderResourceView* const* ppShaderResourceViews) = 0;
+
+    virtual void IASetInputLayout(ID3D11InputLayout* pInputLayout) = 0;
+
+    virtual void VSSetShader(ID3D11VertexShader* pVertexShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) = 0;
+
+    virtual void PSSetShader(ID3D11PixelShader* pPixelShader,
+        ID3D11ClassInstance* const* ppClassInstances,
+        unsigned int NumClassInstances) = 0;
+
+    /**
+     * Sube datos a un recurso.
+     * @param SrcBytes Bytes de pSrcData si quien llama los conoce (0 = desconocido);
+     *        D3D no los necesita, los backends que llevan la cuenta sí.
+     */
+    virtual void UpdateSubresource(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        const BackendBox* pDstBox,
+        const void* pSrcData,
+        unsigned int SrcRowPitch,
+        unsigned int SrcDepthPitch,
+        unsigned int SrcBytes) = 0;
+
+    virtual BackendResult Map(ID3D11Resource* pResource,
+        unsigned int Subresource,
+        unsigned int MapType,
+        unsigned int MapFlags,
+        BackendMappedSubresource* pMappedResource) = 0;
+
+    virtual void Unmap(ID3D11Resource* pResource, unsigned int Subresource) = 0;
+
+    virtual void CopySubresourceRegion(ID3D11Resource* pDstResource,
+        unsigned int DstSubresource,
+        unsigned int DstX,
+        unsigned int DstY,
+        unsigned int DstZ,
+        ID3D11Resource* pSrcResource,
+        unsigned int SrcSubresource,
+        const BackendBox* pSrcBox) = 0;
+
+    virtual void IASetVertexBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppVertexBuffers,
+        const unsigned int* pStrides,
+        const unsigned int* pOffsets) = 0;
+
+    virtual void IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+        unsigned int Format,
+        unsigned int Offset) = 0;
+
+    virtual void PSSetSamplers(unsigned int StartSlot,
+        unsigned int NumSamplers,
+        ID3D11SamplerState* const* ppSamplers) = 0;
+
+    virtual void RSSetState(ID3D11RasterizerState* pRasterizerState) = 0;
+
+    virtual void OMSetBlendState(ID3D11BlendState* pBlendState,
+        const float BlendFactor[4],
+        unsigned int SampleMask) = 0;
+
+    virtual void OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+        unsigned int StencilRef) = 0;
+
+    virtual void OMSetRenderTargets(unsigned int NumViews,
+        ID3D11RenderTargetView* const* ppRenderTargetViews,
+        ID3D11DepthStencilView* pDepthStencilView) = 0;
+
+    virtual void IASetPrimitiveTopology(unsigned int Topology) = 0;
+
+    virtual void ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+        const float ColorRGBA[4]) = 0;
+
+    virtual void ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+        unsigned int ClearFlags,
+        float Depth,
+        uint8_t Stencil) = 0;
+
+    virtual void VSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) = 0;
+
+    virtual void PSSetConstantBuffers(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers) = 0;
+
+    /** Solo se llama si supportsConstantOffsets(). */
+    virtual void VSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) = 0;
+
+    /** Solo se llama si supportsConstantOffsets(). */
+    virtual void PSSetConstantBuffers1(unsigned int StartSlot,
+        unsigned int NumBuffers,
+        ID3D11Buffer* const* ppConstantBuffers,
+        const unsigned int* pFirstConstant,
+        const unsigned int* pNumConstants) = 0;
+
+    virtual BackendResult FinishCommandList(bool RestoreDeferredContextState,
+        ID3D11CommandList** ppCommandList) = 0;
+
+    virtual void ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) = 0;
+
+    virtual void DrawIndexed(unsigned int IndexCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation) = 0;
+
+    virtual void DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+        unsigned int InstanceCount,
+        unsigned int StartIndexLocation,
+        int BaseVertexLocation,
+        unsigned int StartInstanceLocation) = 0;
+};
@@ -0,0 +1,288 @@
+﻿/**
+ * @file RenderQueue.h
+ * @brief Cola de dibujo con claves de orden de 64 bits, radix sort paralelo y filtrado de estados repetidos.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include "Meshlet.h"
+#include "DeferredContextPool.h"
+#include <functional>
+#include <unordered_map>
+
+class DeviceContext;
+class JobSystem;
+class ConstantBufferRing;
+
+/** Pase de dibujo (bits altos de la clave: los pases se dibujan en este orden). */
+enum RenderPass {
+    RENDER_PASS_OPAQUE = 0, ///< Geometría opaca, de delante hacia atrás.
+    RENDER_PASS_SHADOW = 1  ///< Sombras proyectadas con blending, de atrás hacia delante y sobre lo opaco.
+};
+
+/**
+ * @struct DrawPacket
+ * @brief Todo lo que necesita un draw: estados nativos, buffers, constantes y rango de índices.
+ *
+ * @details Solo guarda punteros; la cola no los desreferencia salvo al
+ * enviar a un contexto real, así que el orden y el filtrado se pueden
+ * ejercitar con punteros ficticios sin dispositivo.
+ */
+struct DrawPacket {
+    ID3D11VertexShader* vertexShader = nullptr;        ///< Vertex shader.
+    ID3D11PixelShader* pixelShader = nullptr;          ///< Pixel shader.
+    ID3D11InputLayout* inputLayout = nullptr;          ///< Input Layout (nullptr = no cambia).
+    ID3D11BlendState* blendState = nullptr;            ///< Estado de blending.
+    ID3D11RasterizerState* rasterizerState = nullptr;  ///< Estado de rasterización.
+    ID3D11DepthStencilState* depthStencilState = nullptr; ///< Profundidad/stencil (nullptr = por defecto).
+    ID3D11SamplerState* sampler = nullptr;             ///< Sampler del slot 0.
+    ID3D11ShaderResourceView* texture = nullptr;       ///< Textura del slot 0 (nullptr = conserva la anterior).
+    ID3D11Buffer* vertexBuffer = nullptr;              ///< Vertex buffer.
+    unsigned int vertexStride = 0;                     ///< Stride del vertex buffer.
+    unsigned int vertexOffset = 0;                     ///< Offset del vertex buffer.
+    ID3D11Buffer* indexBuffer = nullptr;               ///< Index buffer.
+    DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;    ///< Formato de índice.
+    int baseVertex = 0;                                ///< Se suma a cada índice (malla dentro de un GeometryHeap).
+    unsigned int startIndex = 0;                       ///< Se suma a indexOffset y a los rangos de meshlets.
+    ID3D11Buffer* constantBuffer = nullptr;            ///< Constantes del objeto (VS y PS).
+    unsigned int constantSlot = 2;                     ///< Slot de las constantes.
+    const void* constantData = nullptr;                ///< Contenido a subir (nullptr = ya está subido).
+    unsigned int constantSize = 0;                     ///< Bytes de constantData (0 = el buffer entero, sin anillo ni seguimiento).
+    unsigned int indexCount = 0;                       ///< Índices a dibujar (si no hay rangos).
+    unsigned int indexOffset = 0;                      ///< Primer índice (si no hay rangos).
+    const MeshletDrawRange* ranges = nullptr;          ///< Rangos visibles de meshlets (válidos hasta el envío).
+    unsigned int rangeCount = 0;                       ///< Número de rangos.
+    ID3D11Buffer* instanceBuffer = nullptr;            ///< Datos por instancia (slot 1).
+    unsigned int instanceStride = 0;                   ///< Stride de los datos por instancia.
+    unsigned int firstInstance = 0;                    ///< Primera instancia en instanceBuffer.
+    unsigned int instanceCount = 0;                    ///< Instancias (0 = draw sin instancing).
+};
+
+/**
+ * @struct RenderQueueStats
+ * @brief Contadores de un envío.
+ */
+struct RenderQueueStats {
+    unsigned int packets = 0;      ///< Paquetes en la cola.
+    unsigned int drawCalls = 0;    ///< DrawIndexed y DrawIndexedInstanced emitidos.
+    unsigned int instances = 0;    ///< Instancias dibujadas con DrawIndexedInstanced.
+    unsigned int bindsIssued = 0;  ///< Cambios de estado enviados.
+    unsigned int bindsSkipped = 0; ///< Cambios de estado omitidos por repetir el anterior.
+    unsigned int uploads = 0;      ///< Subidas de constantes (UpdateSubresource o copias al anillo).
+    unsigned int ringDraws = 0;    ///< Paquetes con sus constantes en el anillo.
+    unsigned int commandLists = 0; ///< Listas de comandos ejecutadas (0 = grabado en el contexto inmediato).
+    double sortMs = 0.0;           ///< Radix sort.
+    double submitMs = 0.0;         ///< Recorrido y envío.
+    double recordMs = 0.0;         ///< Grabación en paralelo en los contextos diferidos (dentro de submitMs).
+};
+
+/**
+ * @struct RenderQueueBenchmark
+ * @brief Cola sintética: orden y cambios de estado con y sin ordenar.
+ */
+struct RenderQueueBenchmark {
+    unsigned int draws = 0;          ///< Paquetes.
+    unsigned int threads = 0;        ///< Hilos del JobSystem.
+    unsigned int naiveBinds = 0;     ///< Binds si cada draw enlazara todo (como Actor::render).
+    unsigned int unsortedBinds = 0;  ///< Binds filtrados en el orden de inserción.
+    unsigned int sortedBinds = 0;    ///< Binds filtrados tras ordenar.
+    double serialSortMs = 0.0;       ///< Radix sort en un hilo.
+    double parallelSortMs = 0.0;     ///< Radix sort con el JobSystem.
+    double submitMs = 0.0;           ///< Recorrido con filtrado (sin contexto).
+    bool sortedCorrectly = false;    ///< El resultado coincide con un std::stable_sort.
+};
+
+/**
+ * @struct ParallelSubmitBenchmark
+ * @brief Cola sintética ordenada grabada entera en un hilo y repartida en 1..8 tramos paralelos (sin contexto).
+ */
+struct ParallelSubmitBenchmark {
+    unsigned int draws = 0;           ///< Paquetes.
+    unsigned int threads = 0;         ///< Hilos del JobSystem más el que llama.
+    double serialMs = 0.0;            ///< Recorrido de toda la cola en un hilo.
+    unsigned int serialBinds = 0;     ///< Binds del recorrido en un hilo.
+    std::vector<double> recordMs;     ///< Recorrido repartido en N tramos (índice N - 1).
+    std::vector<unsigned int> binds;  ///< Binds con N tramos (cada tramo vuelve a enlazar su estado).
+    bool mergeOrderCorrect = false;   ///< Los tramos concatenados en orden reproducen los draws de un hilo.
+};
+
+/**
+ * @class RenderQueue
+ * @brief Recoge paquetes de dibujo de un frame, los ordena por clave y los envía sin binds redundantes.
+ *
+ * @details
+ * La clave de 64 bits se compone, de más a menos significativo, de pase
+ * (4 bits), shader (12), material (16: Input Layout y textura), geometría
+ * (16: vertex buffer) y profundidad (16). Los objetos nativos se traducen
+ * a ids pequeños y estables la primera vez que aparecen. La profundidad
+ * usa los bits altos del float de la distancia a la cámara (monótonos para
+ * valores positivos) y se invierte en los pases con blending.
+ *
+ * sort() es un radix sort LSD de 8 bits por pasada que omite las pasadas
+ * en las que todas las claves comparten dígito; con un JobSystem el
+ * histograma y el reparto se hacen por bloques en paralelo y el resultado
+ * es estable e igual al de un hilo. submit() recuerda lo último enlazado
+ * en cada slot y solo llama al contexto cuando cambia; sin contexto solo
+ * cuenta, para probar el orden y el filtrado sin dispositivo.
+ *
+ * Con un anillo de constantes listo, submit() copia primero las constantes
+ * de todos los paquetes con un solo Map y después enlaza cada draw por
+ * offset; los que no caben suben a su propio buffer como sin anillo.
+ *
+ * submitParallel() reparte la cola ordenada en tramos contiguos de coste
+ * parecido, graba cada uno en un contexto diferido desde el JobSystem y
+ * ejecuta las listas en el orden de los tramos. El anillo se llena antes en
+ * el contexto inmediato; las subidas a buffers propios se graban en cada
+ * lista y el contexto inmediato deja de dar por conocido su contenido.
+ */
+class RenderQueue {
+public:
+    static const unsigned int kParallelThreshold = 8192; ///< Paquetes a partir de los que sort() reparte en jobs.
+
+    /** @brief Vacía la cola (conserva la memoria y los ids de estados). */
+    void begin();
+
+    /**
+     * @brief Agrega un paquete y calcula su clave.
+     * @param packet Paquete (se copia).
+     * @param pass Pase de dibujo.
+     * @param depth Distancia a la cámara (>= 0).
+     */
+    void push(const DrawPacket& packet, RenderPass pass, float depth);
+
+    /**
+     * @brief Copia a la cola las constantes y los rangos de meshlets de sus paquetes.
+     * @details Después los paquetes ya no apuntan a datos de quien los agregó
+     * (los actores pueden preparar otro frame); los paquetes que compartían
+     * constantes siguen compartiendo la copia. Las constantes sin tamaño
+     * (constantSize = 0) no se copian. Una vez por frame, tras el último push().
+     */
+    void retainPayloads();
+
+    /**
+     * @brief Ordena los paquetes por clave.
+     * @param jobs Pool para colas grandes (nullptr = un hilo).
+     */
+    void sort(JobSystem* jobs);
+
+    /**
+     * @brief Envía los paquetes en orden (el de inserción si no se llamó a sort()).
+     * @param deviceContext Contexto de destino (nullptr = solo contar).
+     * @param ring Anillo para las constantes de cada draw (nullptr = buffer propio de cada paquete).
+     */
+    void submit(DeviceContext* deviceContext, ConstantBufferRing* ring = nullptr);
+
+    /**
+     * @brief Envía los paquetes grabándolos en paralelo en contextos diferidos.
+     * @details Sin contextos diferidos o sin listas de comandos nativas (el runtime
+     * las emularía) envía con submit() en el contexto inmediato.
+     * @param deviceContext Contexto inmediato (con el estado del frame ya enlazado).
+     * @param contexts Contextos diferidos.
+     * @param jobs Pool que graba los tramos.
+     * @param bindFrameState Enlaza el estado del frame (render targets, viewport, constantes
+     *        globales) en un contexto; se llama en cada diferido y en el inmediato al terminar.
+     * @param ring Anillo para las constantes de cada draw (nullptr = buffer propio de cada paquete).
+     * @param workers Tramos como máximo (0 = un contexto por tramo).
+     */
+    void submitParallel(DeviceContext& deviceContext,
+        DeferredContextPool& contexts,
+        JobSystem& jobs,
+        const std::function<void(DeviceContext&)>& bindFrameState,
+        ConstantBufferRing* ring = nullptr,
+        unsigned int workers = 0);
+
+    /** @brief Contadores del último sort() y submit(). */
+    const RenderQueueStats& getStats() const { return m_stats; }
+
+    /** @brief Paquetes en la cola. */
+    size_t size() const { return m_packets.size(); }
+
+    /** @brief Clave de la posición indicada en el orden actual (el de inserción antes de sort()). */
+    uint64_t getSortedKey(size_t position) const { return m_entries[position].key; }
+
+    /** @brief Paquete de la posición indicada en el orden actual. */
+    const DrawPacket& getSortedPacket(size_t position) const { return m_packets[m_entries[position].packet]; }
+
+    /**
+     * @brief Compone una clave.
+     * @param pass Pase de dibujo.
+     * @param shader Id del shader (12 bits).
+     * @param material Id del material (16 bits).
+     * @param geometry Id de la geometría (16 bits).
+     * @param depth Distancia a la cámara (>= 0).
+     */
+    static uint64_t makeKey(RenderPass pass, unsigned int shader, unsigned int material, unsigned int geometry, float depth);
+
+    /**
+     * @brief Mide una cola sintética con estados compartidos entre draws.
+     * @param draws Paquetes (p. ej. 20000).
+     * @param jobs Pool para la versión paralela del orden (opcional).
+     */
+    static RenderQueueBenchmark benchmark(unsigned int draws, JobSystem* jobs);
+
+    /**
+     * @brief Mide el reparto de una cola sintética en 1..8 tramos grabados en paralelo y
+     *        comprueba que concatenarlos en orden da los mismos draws que un hilo.
+     * @param draws Paquetes (p. ej. 20000).
+     * @param jobs Pool que graba los tramos (nullptr = uno tras otro).
+     */
+    static ParallelSubmitBenchmark benchmarkParallel(unsigned int draws, JobSystem* jobs);
+
+private:
+    /// Clave y paquete al que pertenece.
+    struct SortEntry {
+        uint64_t key;
+        unsigned int packet;
+    };
+
+    /// Rango de un paquete en el anillo de constantes.
+    struct RingRange {
+        unsigned int first;
+        unsigned int count; ///< 0 = el paquete no está en el anillo.
+    };
+
+    /// Lo que acumula la grabación de un tramo en un contexto.
+    struct RecordState {
+        RenderQueueStats stats;                                  ///< Draws, binds y subidas del tramo.
+        std::unordered_map<ID3D11Buffer*, const void*> uploaded; ///< Último contenido subido a cada buffer en el tramo.
+        std::vector<ID3D11Buffer*> updated;                      ///< Buffers propios subidos en el tramo.
+        std::vector<unsigned int> recorded;                      ///< Paquetes grabados (si keepRecorded).
+        bool keepRecorded = false;                               ///< Anotar los paquetes (pruebas sin contexto).
+        HRESULT result = S_OK;                                   ///< Cierre de la lista del tramo.
+
+        /// Vacía el estado conservando la memoria.
+        void reset();
+    };
+
+    /// Id pequeño y estable de un objeto nativo.
+    unsigned int getStateId(const void* object);
+
+    /// Pone a cero los contadores del envío.
+    void resetSubmitStats();
+
+    /// Copia las constantes de todos los paquetes al anillo con un solo Map; false si no se usa el anillo.
+    bool writeRing(DeviceContext* context, ConstantBufferRing* ring);
+
+    /**
+     * Graba las entradas [begin, end) en un contexto con el estado enlazado por defecto.
+     * Solo lee la cola: varios tramos se pueden grabar a la vez.
+     */
+    void record(DeviceContext* context, ID3D11Buffer* ringBuffer, size_t begin, size_t end, RecordState& state) const;
+
+    /// Suma los contadores de un tramo a los del envío.
+    void addRecordStats(const RenderQueueStats& stats);
+
+    std::vector<DrawPacket> m_packets;     ///< Paquetes del frame.
+    std::vector<SortEntry> m_entries;      ///< Orden actual.
+    std::vector<SortEntry> m_scratch;      ///< Destino de cada pasada del radix sort.
+    std::vector<unsigned int> m_histograms; ///< 256 contadores por bloque.
+    std::unordered_map<const void*, unsigned int> m_stateIds; ///< Ids de shaders, layouts, texturas y buffers.
+    std::vector<RingRange> m_ringRanges;   ///< Rango en el anillo de cada paquete.
+    std::vector<RecordState> m_recordStates; ///< Estado de cada tramo (uno en el envío en un hilo).
+    std::vector<unsigned int> m_costs;     ///< Draws de cada entrada ordenada (reparto en tramos).
+    std::vector<SubmitChunk> m_chunks;     ///< Tramos del último envío en paralelo.
+    std::vector<uint8_t> m_retainedConstants;            ///< Constantes copiadas por retainPayloads().
+    std::vector<MeshletDrawRange> m_retainedRanges;      ///< Rangos copiados por retainPayloads().
+    std::unordered_map<const void*, size_t> m_retainedOffsets; ///< Constantes originales -> offset en la copia.
+    RenderQueueStats m_stats;              ///< Contadores del frame.
+};
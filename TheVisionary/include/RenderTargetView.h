@@ -70,6 +70,16 @@ public:
     void render(DeviceContext& deviceContext,
         unsigned int numViews);
 
+    /**
+     * @brief Establece el RTV junto al Depth Stencil sin limpiar ninguno.
+     * @param deviceContext Contexto del dispositivo (inmediato o diferido).
+     * @param depthStencilView Vista de profundidad asociada.
+     * @param numViews Nmero de vistas a enlazar.
+     */
+    void render(DeviceContext& deviceContext,
+        DepthStencilView& depthStencilView,
+        unsigned int numViews);
+
     /**
      * @brief Libera los recursos asociados al Render Target View.
      */
@@ -0,0 +1,203 @@
+﻿/**
+ * @file ShaderCache.h
+ * @brief Caché persistente de bytecode de shaders en un único archivo indexado.
+ *
+ * @details Sin tipos de Windows: el compilador concreto (D3DShaderCompiler) va
+ * aparte, así que la caché, la clave y el archivo se prueban en cualquier plataforma.
+ */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Macro del preprocesador pasada al compilador. */
+struct ShaderDefine {
+    std::string name;  ///< Nombre de la macro.
+    std::string value; ///< Valor (vacío = "1").
+};
+
+/**
+ * @struct ShaderCompileRequest
+ * @brief Todo lo que determina el bytecode de un shader.
+ */
+struct ShaderCompileRequest {
+    std::string fileName;             ///< Ruta del archivo (base de los #include y nombre en los errores).
+    std::string source;               ///< Código HLSL (vacío = se lee fileName).
+    std::string entryPoint;           ///< Punto de entrada.
+    std::string profile;              ///< Modelo de shader (p. ej. "vs_4_0").
+    std::vector<ShaderDefine> defines; ///< Macros del preprocesador.
+};
+
+/**
+ * @class ShaderCompiler
+ * @brief Compilador de HLSL intercambiable (D3DCompile en el motor, uno falso en pruebas).
+ */
+class ShaderCompiler {
+public:
+    virtual ~ShaderCompiler() = default;
+
+    /**
+     * @brief Compila un shader.
+     * @param request Código, punto de entrada, perfil y macros (source ya leído).
+     * @param bytecode Recibe el bytecode compilado.
+     * @param errors Recibe los mensajes del compilador si falla.
+     * @return true si se compiló.
+     */
+    virtual bool compile(const ShaderCompileRequest& request,
+        std::vector<char>& bytecode,
+        std::string& errors) = 0;
+
+    /**
+     * @brief Versión y opciones del compilador; forma parte de la clave de la caché.
+     */
+    virtual std::string getId() const = 0;
+};
+
+
+/**
+ * @struct ShaderCacheStats
+ * @brief Contadores de la caché desde el último resetStats().
+ */
+struct ShaderCacheStats {
+    unsigned int hits = 0;       ///< Shaders servidos desde la caché.
+    unsigned int misses = 0;     ///< Shaders compilados.
+    unsigned int failures = 0;   ///< Compilaciones fallidas (no se guardan).
+    unsigned int entries = 0;    ///< Shaders en la caché.
+    unsigned int dropped = 0;    ///< Entradas viejas descartadas en el último save().
+    size_t fileBytes = 0;        ///< Tamaño del archivo leído o escrito por última vez.
+    double loadMs = 0.0;         ///< Lectura e índice del archivo.
+    double lookupMs = 0.0;       ///< Clave y copia de los shaders servidos.
+    double compileMs = 0.0;      ///< Clave y compilación de los fallos.
+    bool warm = false;           ///< load() encontró un archivo válido.
+    bool invalid = false;        ///< load() descartó un archivo cortado o de otra versión.
+};
+
+/**
+ * @struct ShaderCacheBenchmark
+ * @brief Mismos shaders con la caché vacía y con el archivo escrito por la pasada en frío.
+ */
+struct ShaderCacheBenchmark {
+    unsigned int shaders = 0;  ///< Shaders pedidos en cada pasada.
+    double coldMs = 0.0;       ///< Compilación de todos y escritura del archivo.
+    double warmMs = 0.0;       ///< Lectura del archivo y obtención de todos.
+    unsigned int warmHits = 0; ///< Aciertos de la pasada en caliente (debe ser shaders).
+    size_t fileBytes = 0;      ///< Tamaño del archivo.
+    bool identical = false;    ///< El bytecode servido es igual al compilado.
+};
+
+/**
+ * @class ShaderCache
+ * @brief Bytecode indexado por el hash de todo lo que lo determina.
+ *
+ * @details
+ * La clave combina el código, el contenido de cada #include (recursivo,
+ * resuelto como lo hace el compilador), las macros, el punto de entrada, el
+ * perfil y el identificador del compilador: cualquier cambio da otra clave,
+ * así que nunca hay que invalidar a mano. El archivo tiene una cabecera, un
+ * índice y los blobs seguidos; load() lo lee de una vez y los shaders se
+ * copian desde ese bloque. Cada escritura del archivo es una generación; las
+ * entradas que no se usan en kStaleGenerations generaciones se descartan al
+ * guardar para que las ediciones de los shaders no lo hagan crecer.
+ */
+class ShaderCache {
+public:
+    /// Escrituras del archivo sin usar una entrada antes de descartarla.
+    static constexpr uint32_t kStaleGenerations = 8;
+
+    /**
+     * @param compiler Compilador para los fallos.
+     */
+    explicit ShaderCache(std::shared_ptr<ShaderCompiler> compiler) : m_compiler(compiler) {}
+
+    /**
+     * @brief Lee el archivo de la caché (en una sola lectura).
+     * @param path Ruta del archivo; save() escribe en la misma.
+     * @return true si había un archivo válido (caché caliente).
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Escribe el archivo si se compiló algo o se descartaron entradas.
+     * @return false si no se pudo escribir.
+     */
+    bool save();
+
+    /**
+     * @brief Bytecode de un shader: de la caché o compilado (y guardado).
+     * @param request Archivo o código, punto de entrada, perfil y macros.
+     * @param bytecode Recibe el bytecode.
+     * @param errors Recibe los mensajes del compilador si falla.
+     * @return true si hay bytecode (siempre en un acierto).
+     */
+    bool getBytecode(const ShaderCompileRequest& request,
+        std::vector<char>& bytecode,
+        std::string& errors);
+
+    /** @brief Vacía la caché y borra su archivo (el siguiente arranque es en frío). */
+    void clear();
+
+    /** @brief Contadores, entradas y tiempos. */
+    ShaderCacheStats getStats() const;
+
+    /** @brief Pone a cero los contadores y tiempos. */
+    void resetStats();
+
+    /** @brief Ruta del archivo. */
+    const std::string& getPath() const { return m_path; }
+
+    /**
+     * @brief Clave de un shader.
+     * @param request Petición con el código ya leído.
+     * @param compilerId Identificador del compilador.
+     */
+    static uint64_t computeKey(const ShaderCompileRequest& request, const std::string& compilerId);
+
+    /**
+     * @brief Ruta de un #include: junto al archivo que lo incluye y, si no está, junto al archivo raíz.
+     * @details La clave y el compilador usan esta misma resolución.
+     * @param name Nombre escrito en la directiva.
+     * @param parentDir Directorio del archivo que lo incluye.
+     * @param rootDir Directorio del archivo compilado.
+     * @return Ruta encontrada (vacía si no existe).
+     */
+    static std::string resolveInclude(const std::string& name,
+        const std::string& parentDir,
+        const std::string& rootDir);
+
+    /** @brief Directorio de una ruta, con la barra final (vacío si no tiene). */
+    static std::string directoryOf(const std::string& path);
+
+    /** @brief Contenido entero de un archivo (vacío si no se puede abrir). */
+    static std::string readFile(const std::string& fileName);
+
+    /**
+     * @brief Compara la caché vacía con la caché leída del archivo para los mismos shaders.
+     * @param requests Shaders a pedir.
+     * @param compiler Compilador.
+     * @param path Archivo temporal (se borra al terminar).
+     */
+    static ShaderCacheBenchmark benchmark(const std::vector<ShaderCompileRequest>& requests,
+        std::shared_ptr<ShaderCompiler> compiler,
+        const std::string& path);
+
+private:
+    /// Blob dentro de m_data.
+    struct Entry {
+        size_t offset;           ///< Posición en m_data.
+        uint32_t size;           ///< Bytes del bytecode.
+        uint32_t lastGeneration; ///< Generación en la que se usó por última vez.
+    };
+
+    std::shared_ptr<ShaderCompiler> m_compiler;    ///< Compila los fallos.
+    std::string m_path;                            ///< Archivo de la caché.
+    std::vector<char> m_data;                      ///< Blobs leídos y compilados.
+    std::unordered_map<uint64_t, Entry> m_entries; ///< Blob por clave.
+    uint32_t m_generation = 1;                     ///< Generación que escribirá save().
+    bool m_dirty = false;                          ///< Hay que reescribir el archivo.
+    ShaderCacheStats m_stats;                      ///< Contadores.
+    mutable std::mutex m_mutex;                    ///< Los actores pueden crearse fuera del hilo principal.
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include "Prerequisites.h"
 #include "InputLayout.h"
+#include "VertexFormat.h"
+#include <map>
 
 class Device;
 class DeviceContext;
@@ -31,6 +33,25 @@ public:
         const std::string& fileName,
         std::vector<D3D11_INPUT_ELEMENT_DESC> Layout);
 
+    /**
+     * @brief Inicializa el programa compilando los shaders desde cdigo HLSL en memoria.
+     * @param device Dispositivo Direct3D para la creacin de recursos.
+     * @param name Nombre del programa (mensajes de error del compilador).
+     * @param source Cdigo HLSL con los puntos de entrada VS y PS.
+     * @param Layout Descriptores del formato de vrtices.
+     * @return HRESULT con el estado de la operacin.
+     */
+    HRESULT initFromSource(Device& device,
+        const std::string& name,
+        const std::string& source,
+        std::vector<D3D11_INPUT_ELEMENT_DESC> Layout);
+
+    /**
+     * @brief Elementos por instancia que se agregan a cada variante de formato creada despus.
+     * @param elements Descriptores con D3D11_INPUT_PER_INSTANCE_DATA.
+     */
+    void setInstanceElements(const std::vector<D3D11_INPUT_ELEMENT_DESC>& elements) { m_instanceElements = elements; }
+
     /**
      * @brief Actualiza el estado del programa de shaders.
      */
@@ -62,6 +83,27 @@ public:
      */
     HRESULT CreateInputLayout(Device& device, std::vector<D3D11_INPUT_ELEMENT_DESC> Layout);
 
+    /**
+     * @brief Crea (una sola vez) el Input Layout de una variante de formato de vrtice.
+     * @param device Dispositivo Direct3D.
+     * @param layout Descriptor del formato; el layout float usa el Input Layout principal.
+     * @return HRESULT con el estado de la operacin.
+     */
+    HRESULT CreateInputLayout(Device& device, const VertexLayout& layout);
+
+    /**
+     * @brief Aplica el Input Layout que corresponde al formato de vrtice de una malla.
+     * @param deviceContext Contexto del dispositivo donde se usar.
+     * @param layout Descriptor del formato (debe haberse creado con CreateInputLayout).
+     */
+    void renderInputLayout(DeviceContext& deviceContext, const VertexLayout& layout);
+
+    /**
+     * @brief Input Layout que corresponde al formato de vrtice de una malla.
+     * @return nullptr si la variante no se cre.
+     */
+    ID3D11InputLayout* getInputLayout(const VertexLayout& layout) const;
+
     /**
      * @brief Crea un shader del tipo especificado usando el archivo del programa.
      * @param device Dispositivo Direct3D.
@@ -92,12 +134,26 @@ public:
         LPCSTR szShaderModel,
         ID3DBlob** ppBlobOut);
 
+    /**
+     * @brief Compila un shader desde el cdigo HLSL del programa.
+     * @param szEntryPoint Punto de entrada del shader.
+     * @param szShaderModel Modelo de shader (ej. "vs_5_0").
+     * @param ppBlobOut Blob de salida con el bytecode compilado.
+     * @return HRESULT con el estado de la operacin.
+     */
+    HRESULT CompileShaderFromSource(LPCSTR szEntryPoint,
+        LPCSTR szShaderModel,
+        ID3DBlob** ppBlobOut);
+
 public:
     ID3D11VertexShader* m_VertexShader = nullptr; ///< Shader de vrtices.
     ID3D11PixelShader* m_PixelShader = nullptr;   ///< Shader de pxeles.
     InputLayout m_inputLayout;                    ///< Input Layout asociado.
 private:
     std::string m_shaderFileName;                 ///< Nombre del archivo del shader.
+    std::string m_shaderSource;                   ///< Cdigo HLSL (vaco = se compila m_shaderFileName).
+    std::vector<D3D11_INPUT_ELEMENT_DESC> m_instanceElements; ///< Elementos por instancia de las variantes.
     ID3DBlob* m_vertexShaderData = nullptr;       ///< Bytecode del Vertex Shader.
     ID3DBlob* m_pixelShaderData = nullptr;        ///< Bytecode del Pixel Shader.
+    std::map<unsigned int, InputLayout> m_layoutVariants; ///< Input Layouts por formato compacto (VertexLayout::getKey).
 };
@@ -0,0 +1,210 @@
+﻿/**
+ * @file StateCache.h
+ * @brief Copia en CPU del estado enlazado en el contexto para descartar llamadas redundantes.
+ */
+
+#pragma once
+#include <cstdint>
+
+// Solo se comparan punteros: basta con declarar los tipos (sin d3d11.h la caché compila en cualquier plataforma).
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+struct ID3D11RasterizerState;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+
+/** Llamadas del contexto que pasan por la caché. */
+enum StateCall {
+    STATE_CALL_VS_SHADER = 0,
+    STATE_CALL_PS_SHADER,
+    STATE_CALL_INPUT_LAYOUT,
+    STATE_CALL_TOPOLOGY,
+    STATE_CALL_VERTEX_BUFFERS,
+    STATE_CALL_INDEX_BUFFER,
+    STATE_CALL_VS_CONSTANT_BUFFERS,
+    STATE_CALL_PS_CONSTANT_BUFFERS,
+    STATE_CALL_PS_SHADER_RESOURCES,
+    STATE_CALL_PS_SAMPLERS,
+    STATE_CALL_RASTERIZER,
+    STATE_CALL_BLEND,
+    STATE_CALL_DEPTH_STENCIL,
+    STATE_CALL_COUNT
+};
+
+/**
+ * @struct StateCacheStats
+ * @brief Llamadas enviadas y descartadas por tipo.
+ */
+struct StateCacheStats {
+    unsigned int issued[STATE_CALL_COUNT] = {};  ///< Llamadas que llegaron a Direct3D.
+    unsigned int skipped[STATE_CALL_COUNT] = {}; ///< Llamadas descartadas por repetir el estado actual.
+
+    /// Total de llamadas enviadas.
+    unsigned int getIssued() const;
+    /// Total de llamadas descartadas.
+    unsigned int getSkipped() const;
+    /// Nombre de la función de Direct3D de cada tipo.
+    static const char* getCallName(StateCall call);
+};
+
+/**
+ * @class StateCache
+ * @brief Recuerda shaders, estados, buffers, texturas y samplers enlazados y decide si una llamada cambia algo.
+ *
+ * @details
+ * Cada set*() compara con lo guardado: si todo coincide devuelve false
+ * (la llamada sobra); si no, guarda los valores nuevos y devuelve true.
+ * Los slots por encima de kTrackedSlots no se siguen y siempre se envían.
+ * Tras invalidate() (o al empezar frame con beginFrame()) ningún valor se
+ * considera conocido, así que el código que toca el contexto nativo sin
+ * pasar por DeviceContext solo necesita invalidar.
+ *
+ * No depende de Direct3D: los punteros solo se comparan y la topología y
+ * el formato de índices se guardan como enteros, de modo que la lógica se
+ * puede ejercitar con punteros ficticios y un contexto simulado
+ * (tests/StateCacheTests.cpp).
+ */
+class StateCache {
+public:
+    static const unsigned int kTrackedSlots = 16; ///< Slots seguidos por etapa (buffers, texturas, samplers).
+
+    /** @brief Olvida todo el estado conocido (los contadores se conservan). */
+    void invalidate();
+
+    /** @brief Cierra los contadores del frame anterior, los reinicia e invalida el estado. */
+    void beginFrame();
+
+    /** @brief Contadores del último frame completo. */
+    const StateCacheStats& getFrameStats() const { return m_lastFrame; }
+
+    /** @brief Contadores del frame en curso. */
+    const StateCacheStats& getCurrentStats() const { return m_current; }
+
+    /**
+     * @name Filtros
+     * Cada uno devuelve true si la llamada cambia el estado conocido (y hay que enviarla).
+     */
+    ///@{
+    bool setVertexShader(ID3D11VertexShader* shader);
+    bool setPixelShader(ID3D11PixelShader* shader);
+    bool setInputLayout(ID3D11InputLayout* layout);
+    bool setTopology(unsigned int topology);
+    bool setVertexBuffers(unsigned int startSlot,
+        unsigned int count,
+        ID3D11Buffer* const* buffers,
+        const unsigned int* strides,
+        const unsigned int* offsets);
+    bool setIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset);
+    bool setVSConstantBuffers(unsigned int startSlot,
+        unsigned int count,
+        ID3D11Buffer* const* buffers,
+        const unsigned int* firstConstants = nullptr,
+        const unsigned int* numConstants = nullptr);
+    bool setPSConstantBuffers(unsigned int startSlot,
+        unsigned int count,
+        ID3D11Buffer* const* buffers,
+        const unsigned int* firstConstants = nullptr,
+        const unsigned int* numConstants = nullptr);
+    bool setPSShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views);
+    bool setPSSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers);
+    bool setRasterizerState(ID3D11RasterizerState* state);
+    bool setBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask);
+    bool setDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef);
+    ///@}
+
+    /** @brief Olvida las texturas enlazadas (cambiar render targets puede desenlazarlas). */
+    void invalidateShaderResources() { m_shaderResources.valid = 0; }
+
+    /** @brief Olvida el vertex shader (se enlazó con instancias de clase, que no se siguen). */
+    void invalidateVertexShader() { m_vertexShader.valid = false; }
+
+    /** @brief Olvida el pixel shader (se enlazó con instancias de clase, que no se siguen). */
+    void invalidatePixelShader() { m_pixelShader.valid = false; }
+
+private:
+    /// Objetos enlazados en los slots de una etapa y qué slots son conocidos.
+    template<typename T>
+    struct SlotArray {
+        T* objects[kTrackedSlots] = {};
+        uint32_t valid = 0;
+    };
+
+    /// Vertex buffer con su stride y offset.
+    struct VertexBinding {
+        ID3D11Buffer* buffer = nullptr;
+        unsigned int stride = 0;
+        unsigned int offset = 0;
+
+        bool operator==(const VertexBinding& other) const {
+            return buffer == other.buffer && stride == other.stride && offset == other.offset;
+        }
+    };
+
+    /// Constant buffer con su rango (0, 0 = el buffer entero).
+    struct ConstantBinding {
+        ID3D11Buffer* buffer = nullptr;
+        unsigned int first = 0;
+        unsigned int count = 0;
+
+        bool operator==(const ConstantBinding& other) const {
+            return buffer == other.buffer && first == other.first && count == other.count;
+        }
+    };
+
+    /// Constant buffers enlazados en los slots de una etapa.
+    struct ConstantSlots {
+        ConstantBinding bindings[kTrackedSlots];
+        uint32_t valid = 0;
+    };
+
+    /// Valor único con indicador de conocido.
+    template<typename T>
+    struct Single {
+        T value = T();
+        bool valid = false;
+    };
+
+    /// Compara y actualiza un valor único.
+    template<typename T>
+    bool setSingle(StateCall call, Single<T>& state, const T& value);
+
+    /// Compara y actualiza un rango de slots.
+    template<typename T>
+    bool setSlots(StateCall call, SlotArray<T>& slots, unsigned int startSlot, unsigned int count, T* const* values);
+
+    /// Compara y actualiza un rango de slots de constant buffers.
+    bool setConstantBuffers(StateCall call,
+        ConstantSlots& slots,
+        unsigned int startSlot,
+        unsigned int count,
+        ID3D11Buffer* const* buffers,
+        const unsigned int* firstConstants,
+        const unsigned int* numConstants);
+
+    /// Cuenta la llamada y devuelve si hay que enviarla.
+    bool record(StateCall call, bool redundant);
+
+    Single<ID3D11VertexShader*> m_vertexShader;
+    Single<ID3D11PixelShader*> m_pixelShader;
+    Single<ID3D11InputLayout*> m_inputLayout;
+    Single<unsigned int> m_topology;                    ///< D3D11_PRIMITIVE_TOPOLOGY.
+    VertexBinding m_vertexBuffers[kTrackedSlots];       ///< Vertex buffers por slot.
+    uint32_t m_vertexBuffersValid = 0;                  ///< Slots de vertex buffer conocidos.
+    Single<VertexBinding> m_indexBuffer;                ///< buffer, formato (en stride) y offset.
+    ConstantSlots m_vsConstantBuffers;
+    ConstantSlots m_psConstantBuffers;
+    SlotArray<ID3D11ShaderResourceView> m_shaderResources;
+    SlotArray<ID3D11SamplerState> m_samplers;
+    Single<ID3D11RasterizerState*> m_rasterizer;
+    Single<ID3D11BlendState*> m_blendState;
+    float m_blendFactor[4] = {};                        ///< Factor de mezcla del blend state conocido.
+    unsigned int m_sampleMask = 0;                      ///< Máscara del blend state conocido.
+    Single<ID3D11DepthStencilState*> m_depthStencil;
+    unsigned int m_stencilRef = 0;                      ///< Referencia del depth stencil state conocido.
+    StateCacheStats m_current;                          ///< Contadores del frame en curso.
+    StateCacheStats m_lastFrame;                        ///< Contadores del último frame completo.
+};
@@ -4,6 +4,16 @@
 class Device;
 class DeviceContext;
 
+/**
+ * @struct ImageData
+ * @brief Imagen decodificada en memoria de CPU (RGBA8, filas contiguas).
+ */
+struct ImageData {
+    unsigned int width = 0;            ///< Ancho en pxeles.
+    unsigned int height = 0;           ///< Alto en pxeles.
+    std::vector<unsigned char> pixels; ///< Pxeles RGBA8 (width * height * 4 bytes).
+};
+
 /**
  * @class Texture
  * @brief Administra texturas DirectX 11 (desde archivo, vacas o alias).
@@ -53,6 +63,44 @@ public:
      */
     HRESULT init(Device& device, Texture& textureRef, DXGI_FORMAT format);
 
+    /**
+     * @brief Crea la textura y su SRV a partir de una imagen ya decodificada.
+     * @param device Dispositivo de render.
+     * @param image Imagen RGBA8 en memoria.
+     */
+    HRESULT init(Device& device, const ImageData& image);
+
+    /**
+     * @brief Decodifica una imagen (PNG/JPG/TGA/BMP) sin tocar la GPU.
+     * @param fileName Ruta completa del archivo.
+     * @param image Imagen resultante en RGBA8.
+     * @return S_OK si la imagen se decodific.
+     */
+    static HRESULT decodeImage(const std::string& fileName, ImageData& image);
+
+    /**
+     * @brief Decodifica una imagen ya leda en memoria (formatos stb o .vtex).
+     * @param data Contenido completo del archivo.
+     * @param size Tamao en bytes.
+     * @param image Imagen resultante en RGBA8.
+     * @return S_OK si la imagen se decodific.
+     */
+    static HRESULT decodeImage(const void* data, size_t size, ImageData& image);
+
+    /**
+     * @brief Escribe una imagen cocinada (.vtex) lista para subir sin decodificar.
+     * @param fileName Ruta de salida.
+     * @param image Imagen a guardar.
+     */
+    static HRESULT writeCookedImage(const std::string& fileName, const ImageData& image);
+
+    /**
+     * @brief Lee una imagen cocinada (.vtex).
+     * @param fileName Ruta del archivo cocinado.
+     * @param image Imagen resultante.
+     */
+    static HRESULT readCookedImage(const std::string& fileName, ImageData& image);
+
     /**
      * @brief Adjunta un recurso nativo existente (por ejemplo back-buffer).
      */
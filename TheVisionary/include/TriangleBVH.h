@@ -0,0 +1,181 @@
+﻿/**
+ * @file TriangleBVH.h
+ * @brief BVH de triángulos por malla (SAH por bins, nodos de 32 bytes) para raycasts y selección.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class JobSystem;
+struct MeshBounds;
+
+/**
+ * @struct BVHNode
+ * @brief Nodo compacto de 32 bytes.
+ *
+ * @details Un nodo interno guarda en leftFirst su hijo izquierdo (el derecho
+ * es leftFirst + 1); una hoja guarda su primera posición en el orden de
+ * triángulos (múltiplo de 4) y cuántos usa.
+ */
+struct BVHNode {
+    XMFLOAT3 boundsMin = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Esquina mínima.
+    unsigned int leftFirst = 0;                      ///< Hijo izquierdo o primera posición.
+    XMFLOAT3 boundsMax = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Esquina máxima.
+    unsigned int triangleCount = 0;                  ///< Triángulos de la hoja (0 = nodo interno).
+
+    bool isLeaf() const { return triangleCount != 0; }
+};
+
+/**
+ * @struct BVHHit
+ * @brief Impacto más cercano de un rayo.
+ */
+struct BVHHit {
+    float distance = 0.0f;      ///< Parámetro t del rayo (en unidades de su dirección).
+    unsigned int triangle = 0;  ///< Triángulo de la malla (índice / 3 en el LOD 0).
+    float u = 0.0f;             ///< Coordenada baricéntrica del vértice 1.
+    float v = 0.0f;             ///< Coordenada baricéntrica del vértice 2.
+};
+
+/**
+ * @struct BVHBuildStats
+ * @brief Contadores acumulados de la construcción.
+ */
+struct BVHBuildStats {
+    unsigned int meshes = 0;    ///< Mallas procesadas.
+    size_t triangles = 0;       ///< Triángulos indexados.
+    size_t nodes = 0;           ///< Nodos generados.
+    size_t leaves = 0;          ///< Hojas generadas.
+    unsigned int subtrees = 0;  ///< Subárboles construidos en paralelo.
+    double milliseconds = 0.0;  ///< Tiempo total.
+};
+
+/**
+ * @struct BVHRayBenchmark
+ * @brief Rendimiento de rayos contra un BVH.
+ */
+struct BVHRayBenchmark {
+    size_t triangles = 0;       ///< Triángulos de la malla.
+    size_t nodes = 0;           ///< Nodos del BVH.
+    double buildMs = 0.0;       ///< Construcción (solo en la malla sintética).
+    unsigned int rays = 0;      ///< Rayos lanzados.
+    unsigned int hits = 0;      ///< Rayos con impacto.
+    double serialMs = 0.0;      ///< Tiempo en un hilo.
+    double parallelMs = 0.0;    ///< Tiempo con el JobSystem.
+
+    /// Millones de rayos por segundo en un hilo.
+    double getMillionRaysPerSecond() const { return serialMs > 0.0 ? rays / serialMs / 1000.0 : 0.0; }
+    /// Millones de rayos por segundo con el JobSystem.
+    double getParallelMillionRaysPerSecond() const { return parallelMs > 0.0 ? rays / parallelMs / 1000.0 : 0.0; }
+};
+
+/**
+ * @class TriangleBVH
+ * @brief Jerarquía de AABB sobre los triángulos del LOD 0 de una malla.
+ *
+ * @details
+ * Se construye de arriba abajo eligiendo en cada nodo el corte de menor
+ * coste SAH entre kBins cubetas por eje sobre los centroides. Con un
+ * JobSystem, los niveles superiores reparten el binning en bloques y los
+ * subárboles de menos de kParallelSubtree triángulos se construyen en
+ * paralelo y se empalman. Las hojas tienen como mucho cuatro triángulos,
+ * guardados en SoA para probarlos a la vez con Möller-Trumbore; la prueba
+ * rayo-caja usa el método de slabs con XMVECTOR y el recorrido visita
+ * primero el hijo más cercano.
+ *
+ * Los nodos y el orden de triángulos se guardan en el asset cocinado; los
+ * grupos SoA se regeneran desde los vértices con load().
+ */
+class TriangleBVH {
+public:
+    static const unsigned int kBins = 16;               ///< Cubetas por eje del SAH.
+    static const unsigned int kLeafTriangles = 4;       ///< Triángulos por hoja (un grupo SIMD).
+    static const unsigned int kParallelSubtree = 16384; ///< Tamaño a partir del cual un subárbol se construye aparte.
+    static const unsigned int kInvalidTriangle = 0xFFFFFFFFu; ///< Relleno de las hojas incompletas.
+
+    /**
+     * @brief Construye el BVH.
+     * @param vertices Vértices de la malla.
+     * @param indices Índices del LOD 0.
+     * @param triangleCount Triángulos (índices / 3).
+     * @param jobs Pool para construir en paralelo (opcional).
+     * @param stats Contadores acumulados (opcional).
+     */
+    void build(const std::vector<SimpleVertex>& vertices,
+        const unsigned int* indices,
+        size_t triangleCount,
+        JobSystem* jobs,
+        BVHBuildStats* stats = nullptr);
+
+    /**
+     * @brief Restaura un BVH cocinado y regenera los grupos SoA.
+     * @param nodes Nodos guardados.
+     * @param order Orden de triángulos guardado (con relleno).
+     * @param vertices Vértices de la malla.
+     * @param indices Índices del LOD 0.
+     * @param triangleCount Triángulos del LOD 0.
+     * @return false si los datos no son coherentes con la malla (el BVH queda vacío).
+     */
+    bool load(std::vector<BVHNode> nodes,
+        std::vector<unsigned int> order,
+        const std::vector<SimpleVertex>& vertices,
+        const unsigned int* indices,
+        size_t triangleCount);
+
+    /**
+     * @brief Impacto más cercano de un rayo (triángulos de dos caras).
+     * @param origin Origen en espacio del modelo.
+     * @param direction Dirección en espacio del modelo (no necesita estar normalizada).
+     * @param maxDistance Parámetro t máximo.
+     * @param hit Impacto encontrado.
+     * @return true si hay impacto antes de maxDistance.
+     */
+    bool intersect(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, BVHHit& hit) const;
+
+    /** @brief true si no hay nodos. */
+    bool isEmpty() const { return m_nodes.empty(); }
+
+    /** @brief Nodos (para guardarlos en el asset cocinado). */
+    const std::vector<BVHNode>& getNodes() const { return m_nodes; }
+
+    /** @brief Orden de triángulos con relleno (para guardarlo en el asset cocinado). */
+    const std::vector<unsigned int>& getTriangleOrder() const { return m_order; }
+
+    /** @brief Libera los datos. */
+    void clear();
+
+    /**
+     * @brief Mide rayos aleatorios hacia el interior de los volúmenes de la malla.
+     * @param bvh BVH construido.
+     * @param bounds Volúmenes de la malla en espacio del modelo.
+     * @param rayCount Rayos a lanzar.
+     * @param jobs Pool para la versión paralela (opcional).
+     */
+    static BVHRayBenchmark benchmark(const TriangleBVH& bvh,
+        const MeshBounds& bounds,
+        unsigned int rayCount,
+        JobSystem* jobs);
+
+    /**
+     * @brief Construye una malla de prueba (terreno ondulado) y mide construcción y rayos.
+     * @param triangleCount Triángulos aproximados (p. ej. 5 millones).
+     * @param rayCount Rayos a lanzar.
+     * @param jobs Pool para construir y lanzar en paralelo (opcional).
+     */
+    static BVHRayBenchmark benchmarkSynthetic(size_t triangleCount, unsigned int rayCount, JobSystem* jobs);
+
+private:
+    /// Cuatro triángulos en SoA: vértice 0 y las dos aristas desde él.
+    struct TriangleGroup {
+        XMFLOAT4 v0x, v0y, v0z;
+        XMFLOAT4 e1x, e1y, e1z;
+        XMFLOAT4 e2x, e2y, e2z;
+    };
+
+    /// Rellena m_groups a partir de m_order.
+    void buildGroups(const std::vector<SimpleVertex>& vertices, const unsigned int* indices);
+
+    std::vector<BVHNode> m_nodes;         ///< Nodos; la raíz es el 0.
+    std::vector<unsigned int> m_order;    ///< Triángulo de cada posición (4 por hoja, con relleno).
+    std::vector<TriangleGroup> m_groups;  ///< Un grupo SoA por cada 4 posiciones de m_order.
+};
@@ -10,6 +10,67 @@ class SwapChain;
 class Texture;
 class Actor;
 class ModelComponent;
+struct StreamingStats;
+struct MeshletCullStats;
+struct FrustumCullStats;
+struct DynamicTreeStats;
+struct OcclusionStats;
+struct RenderQueueStats;
+struct StateCacheStats;
+struct InstancingStats;
+struct ConstantUploadStats;
+class ConstantRingAllocator;
+struct GeometryHeapStats;
+struct ObjectCacheStats;
+struct ShaderCacheStats;
+class DeferredContextPool;
+struct HeadlessBenchmark;
+struct NullBackendStats;
+struct ReplayStats;
+struct FrameLatencyStats;
+struct FramePacingStats;
+struct FramePacingSettings;
+class FixedTimestep;
+struct ProfilerStats;
+struct ProfileZoneStats;
+struct ProfileCounterStats;
+struct ProfileThreadStats;
+
+/**
+ * @struct UiDrawSnapshot
+ * @brief Copia de las listas de dibujo de un frame de ImGui para dibujarla en otro hilo.
+ */
+struct UiDrawSnapshot {
+    std::vector<ImDrawList*> lists; ///< Copias propias (se reutilizan entre frames).
+    ImDrawData data;                ///< Apunta a lists (Valid = false si an no hay copia).
+
+    UiDrawSnapshot() = default;
+    ~UiDrawSnapshot() {
+        for (ImDrawList* list : lists) {
+            IM_DELETE(list);
+        }
+    }
+    UiDrawSnapshot(const UiDrawSnapshot&) = delete;
+    UiDrawSnapshot& operator=(const UiDrawSnapshot&) = delete;
+};
+
+/** Botn pulsado en el panel de culling. */
+enum CullingPanelAction { CULLING_NONE = 0, CULLING_BOUNDS_BENCHMARK, CULLING_FRUSTUM_BENCHMARK, CULLING_TREE_BENCHMARK, CULLING_RAY_BENCHMARK, CULLING_OCCLUSION_GOLDEN, CULLING_OCCLUSION_GOLDEN_REWRITE };
+
+/** Botn pulsado en el panel de instancing. */
+enum InstancingPanelAction { INSTANCING_NONE = 0, INSTANCING_SPAWN, INSTANCING_BENCHMARK };
+
+/** Botn pulsado en el panel del heap de geometra. */
+enum GeometryPanelAction { GEOMETRY_NONE = 0, GEOMETRY_DEFRAGMENT, GEOMETRY_BENCHMARK };
+
+/** Botn pulsado en el panel de la cach de shaders. */
+enum ShaderCachePanelAction { SHADER_CACHE_NONE = 0, SHADER_CACHE_CLEAR, SHADER_CACHE_BENCHMARK };
+
+/** Botn pulsado en el panel de captura de comandos. */
+enum CapturePanelAction { CAPTURE_NONE = 0, CAPTURE_START, CAPTURE_REPLAY_DEVICE, CAPTURE_REPLAY_HEADLESS };
+
+/** Botn pulsado en el panel del profiler. */
+enum ProfilerPanelAction { PROFILER_NONE = 0, PROFILER_CAPTURE, PROFILER_LOG };
 
 /**
  * @class UserInterface
@@ -54,6 +115,18 @@ public:
      */
     void render();
 
+    /**
+     * @brief Cierra el frame de ImGui y copia sus listas de dibujo (hilo de la simulacin).
+     * @param snapshot Copia que se dibuja despus con renderSnapshot().
+     * @note Solo la ventana principal: las ventanas de plataforma no se copian.
+     */
+    void snapshot(UiDrawSnapshot& snapshot);
+
+    /**
+     * @brief Dibuja una copia de snapshot() (hilo de render; no toca el contexto de ImGui).
+     */
+    void renderSnapshot(UiDrawSnapshot& snapshot);
+
     /**
      * @brief Libera recursos de ImGui.
      */
@@ -143,6 +216,183 @@ public:
      */
     void outliner(const std::vector<EU::TSharedPointer<Actor>>& actors);
 
+    /**
+     * @brief Panel de estadsticas del streaming de assets.
+     * @param stats Contadores del AssetStreamer.
+     * @param timeToFirstFrameMs Tiempo desde el arranque hasta el primer Present.
+     * @param worstFrameMs Peor tiempo de frame desde el ltimo reinicio.
+     * @param budgetKB Presupuesto de subida por frame en KB (editable).
+     * @param budgetMs Presupuesto de subida por frame en ms (editable).
+     * @return true si se puls el botn de prueba de carga (500 assets).
+     */
+    bool streamingPanel(const StreamingStats& stats,
+        double timeToFirstFrameMs,
+        double worstFrameMs,
+        int& budgetKB,
+        float& budgetMs);
+
+    /**
+     * @brief Panel del culling de actores y de meshlets.
+     * @param frustum Culling de actores del ltimo frame.
+     * @param meshlets Culling de meshlets del ltimo frame.
+     * @param sceneTree Estado del ndice espacial de actores.
+     * @param occlusion Occlusion culling por software del ltimo frame.
+     * @param meshletCulling Culling de meshlets activado (editable).
+     * @param occlusionCulling Occlusion culling activado (editable).
+     * @return Prueba de rendimiento pedida (volmenes con 10M vrtices, frustum o rbol con 100k actores).
+     */
+    CullingPanelAction cullingPanel(const FrustumCullStats& frustum,
+        const MeshletCullStats& meshlets,
+        const DynamicTreeStats& sceneTree,
+        const OcclusionStats& occlusion,
+        bool& meshletCulling,
+        bool& occlusionCulling);
+
+    /**
+     * @brief Panel de la cola de dibujo.
+     * @param stats Orden y envo del ltimo frame.
+     * @param context Llamadas del contexto enviadas y descartadas en el ltimo frame.
+     * @return true si se puls el botn de prueba de rendimiento (20k draws).
+     */
+    bool renderQueuePanel(const RenderQueueStats& stats, const StateCacheStats& context);
+
+    /**
+     * @brief Panel del envo paralelo con contextos diferidos.
+     * @param stats Envo del ltimo frame.
+     * @param contexts Contextos diferidos (nullptr = no se pudieron crear).
+     * @param parallel Grabar la cola en contextos diferidos (editable).
+     * @param workers Hilos que graban (editable, 1..8).
+     * @return true si se puls el botn de prueba de rendimiento (20k draws).
+     */
+    bool parallelSubmitPanel(const RenderQueueStats& stats,
+        const DeferredContextPool* contexts,
+        bool& parallel,
+        int& workers);
+
+    /**
+     * @brief Panel de la medicin sin GPU (NullBackend).
+     * @param last ltima medicin (frames == 0 si no hay).
+     * @param frames Frames a grabar (editable).
+     * @return true si se puls el botn de medir.
+     */
+    bool headlessPanel(const HeadlessBenchmark& last, int& frames);
+
+    /**
+     * @brief Panel de captura y reproduccin de comandos.
+     * @param captured Lo grabado en la captura en curso o la ltima (nullptr si no hay).
+     * @param capturing true mientras se captura.
+     * @param replay ltima reproduccin (repeats == 0 si no hay).
+     * @param frames Frames a capturar (editable).
+     * @param repeats Pasadas de la reproduccin (editable).
+     * @return Botn pulsado.
+     */
+    CapturePanelAction capturePanel(const NullBackendStats* captured,
+        bool capturing,
+        const ReplayStats& replay,
+        int& frames,
+        int& repeats);
+
+    /**
+     * @brief Panel del dibujo instanciado.
+     * @param stats Lotes del ltimo frame.
+     * @param drawCalls Draws de la cola en el ltimo frame.
+     * @param submitMs Envo de la cola en el ltimo frame.
+     * @param instancing Instancing activado (editable).
+     * @param spawnCount Copias a crear del actor seleccionado (editable).
+     * @return Accin pedida (crear copias o prueba de rendimiento con 10k instancias).
+     */
+    InstancingPanelAction instancingPanel(const InstancingStats& stats,
+        unsigned int drawCalls,
+        double submitMs,
+        bool& instancing,
+        int& spawnCount);
+
+    /**
+     * @brief Panel de las subidas de constantes.
+     * @param stats Subidas del ltimo frame completo.
+     * @param ring Ocupacin del anillo (nullptr = sin Direct3D 11.1).
+     * @param ringDraws Paquetes de la cola con sus constantes en el anillo.
+     * @param useRing Enviar las constantes por el anillo (editable).
+     * @param skipUnchanged Omitir subidas sin cambios (editable).
+     * @return true si se puls el botn de prueba de rendimiento (10k draws).
+     */
+    bool constantsPanel(const ConstantUploadStats& stats,
+        const ConstantRingAllocator* ring,
+        unsigned int ringDraws,
+        bool& useRing,
+        bool& skipUnchanged);
+
+    /**
+     * @brief Panel del heap de vrtices e ndices compartido por las mallas.
+     * @param stats Ocupacin del heap (nullptr = heap no disponible).
+     * @param queue Contadores de la cola del ltimo frame (binds).
+     * @return Botn pulsado (desfragmentar o prueba de rendimiento).
+     */
+    GeometryPanelAction geometryHeapPanel(const GeometryHeapStats* stats, const RenderQueueStats& queue);
+
+    /**
+     * @brief Panel de la cach de estados y shaders del dispositivo.
+     * @param stats Aciertos y fallos por tipo.
+     * @param enabled Cach activa (editable).
+     * @return true si se puls el botn de prueba de creacin de actores.
+     */
+    bool objectCachePanel(const ObjectCacheStats& stats, bool& enabled);
+
+    /**
+     * @brief Panel de la cach de bytecode de shaders en disco.
+     * @param stats Contadores y tiempos desde el arranque (nullptr = cach no disponible).
+     * @param timeToFirstFrameMs Arranque medido hasta el primer Present.
+     * @return Botn pulsado (borrar la cach o prueba en fro y en caliente).
+     */
+    ShaderCachePanelAction shaderCachePanel(const ShaderCacheStats* stats, double timeToFirstFrameMs);
+
+    /**
+     * @brief Panel del hilo de render: tiempos de frame y latencia en serie y con el hilo.
+     * @param serial ltima ventana medida con update() y render() en serie.
+     * @param threaded ltima ventana medida con el hilo de render.
+     * @param running true si el hilo de render est en marcha.
+     * @param threadedRender Usar el hilo de render (editable).
+     * @param dropStale El paquete ms reciente sustituye al que no se dibuj (editable).
+     * @return true si se puls el botn de llevar la comparacin al log.
+     */
+    bool framePipelinePanel(const FrameLatencyStats& serial,
+        const FrameLatencyStats& threaded,
+        bool running,
+        bool& threadedRender,
+        bool& dropStale);
+
+    /**
+     * @brief Panel del ritmo del bucle: lmites de FPS, paso de la simulacin, varianza del frame y CPU.
+     * @param stats ltima ventana medida por el FramePacer.
+     * @param settings Lmites de frames por segundo (editable).
+     * @param simulationHz Pasos por segundo de la simulacin (editable).
+     * @param timestep Acumulador de la simulacin (pasos, alpha y tiempo descartado).
+     * @param frameSteps Pasos simulados en este frame.
+     * @return true si se puls el botn de llevar las medidas al log.
+     */
+    bool framePacingPanel(const FramePacingStats& stats,
+        FramePacingSettings& settings,
+        int& simulationHz,
+        const FixedTimestep& timestep,
+        unsigned int frameSteps);
+
+    /**
+     * @brief Panel del profiler de CPU: rbol de zonas por hilo, contadores y trazas de Chrome.
+     * @param stats Resumen de la ltima ventana.
+     * @param zones Zonas de la ltima ventana, por hilo y en orden de rbol.
+     * @param counters Contadores de la ltima ventana.
+     * @param threads Hilos registrados.
+     * @param enabled Registrar zonas (editable).
+     * @param captureFrames Frames por traza (editable).
+     * @return Botn pulsado.
+     */
+    ProfilerPanelAction profilerPanel(const ProfilerStats& stats,
+        const std::vector<ProfileZoneStats>& zones,
+        const std::vector<ProfileCounterStats>& counters,
+        const std::vector<ProfileThreadStats>& threads,
+        bool& enabled,
+        int& captureFrames);
+
 public:
     int selectedActorIndex = -1; ///< ndice del actor seleccionado.
 
@@ -0,0 +1,161 @@
+﻿/**
+ * @file VertexFormat.h
+ * @brief Formato de índices, descriptor de layout de vértices y codificación compacta (snorm16/half).
+ */
+
+#pragma once
+#include "Prerequisites.h"
+
+class MeshComponent;
+
+/** Ancho de los índices en GPU. */
+enum IndexFormat { INDEX_UINT16 = 0, INDEX_UINT32 = 1 };
+
+/** Formato de la posición en GPU. */
+enum PositionFormat { POSITION_FLOAT3 = 0, POSITION_SNORM16 = 1 };
+
+/** Formato de las coordenadas UV en GPU. */
+enum TexCoordFormat { TEXCOORD_FLOAT2 = 0, TEXCOORD_HALF2 = 1 };
+
+/**
+ * @struct VertexLayout
+ * @brief Describe cómo se codifica un SimpleVertex en el vertex buffer.
+ *
+ * @details
+ * Con POSITION_SNORM16 la posición se guarda en [-1, 1] relativa a la caja
+ * de la malla (boundsCenter ± boundsExtent); getDequantizeMatrix() deshace
+ * esa transformación y se antepone a la matriz de mundo, así el shader no
+ * cambia. El cuarto componente snorm se escribe a 1 para que POSITION siga
+ * llegando con w = 1.
+ */
+struct VertexLayout {
+    PositionFormat position = POSITION_FLOAT3; ///< Formato de la posición.
+    TexCoordFormat texCoord = TEXCOORD_FLOAT2; ///< Formato de las UV.
+    XMFLOAT3 boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f); ///< Centro de la caja (solo snorm16).
+    XMFLOAT3 boundsExtent = XMFLOAT3(1.0f, 1.0f, 1.0f); ///< Semiejes de la caja (solo snorm16).
+
+    /// true si algún atributo no usa el formato float completo.
+    bool isCompact() const { return position != POSITION_FLOAT3 || texCoord != TEXCOORD_FLOAT2; }
+
+    /// Identificador del par de formatos (independiente de la caja); útil como clave de caché.
+    unsigned int getKey() const { return static_cast<unsigned int>(position) | (static_cast<unsigned int>(texCoord) << 1); }
+
+    /// Bytes por vértice.
+    unsigned int getStride() const;
+
+    /// Desplazamiento en bytes de las UV dentro del vértice.
+    unsigned int getTexCoordOffset() const;
+
+    /**
+     * @brief Genera los descriptores de entrada (POSITION, TEXCOORD) de este layout.
+     * @param elements Descriptores de salida (se reemplazan).
+     */
+    void getInputElements(std::vector<D3D11_INPUT_ELEMENT_DESC>& elements) const;
+
+    /**
+     * @brief Matriz que lleva las posiciones decodificadas al espacio del modelo.
+     * @return Identidad si la posición no está cuantizada.
+     */
+    XMMATRIX getDequantizeMatrix() const;
+};
+
+/**
+ * @struct VertexRoundTripError
+ * @brief Error máximo medido al codificar y decodificar una malla, y su cota teórica.
+ */
+struct VertexRoundTripError {
+    float position = 0.0f;      ///< Error absoluto máximo por eje en la posición.
+    float texCoord = 0.0f;      ///< Error absoluto máximo en las UV.
+    float positionBound = 0.0f; ///< Cota: medio paso de cuantización del eje más largo.
+    float texCoordBound = 0.0f; ///< Cota: medio ulp de half en la mayor |UV|.
+};
+
+/**
+ * @class VertexCodec
+ * @brief Conversión entre SimpleVertex/índices en CPU y sus formatos compactos en GPU.
+ *
+ * @details
+ * Las mallas conservan en CPU los datos completos (SimpleVertex y índices de
+ * 32 bits); la codificación se hace al crear los buffers según el formato
+ * elegido en la importación con selectFormats().
+ */
+class VertexCodec {
+public:
+    /** @brief Convierte un float a half (IEEE 754 binary16, redondeo al par más cercano). */
+    static uint16_t floatToHalf(float value);
+
+    /** @brief Convierte un half a float. */
+    static float halfToFloat(uint16_t value);
+
+    /** @brief Codifica un valor de [-1, 1] como snorm16 (se satura fuera del rango). */
+    static int16_t encodeSnorm16(float value);
+
+    /** @brief Decodifica un snorm16 a [-1, 1]. */
+    static float decodeSnorm16(int16_t value);
+
+    /**
+     * @brief Elige el ancho de índice mínimo para un número de vértices.
+     * @param vertexCount Vértices referenciables por la malla.
+     */
+    static IndexFormat chooseIndexFormat(size_t vertexCount);
+
+    /** @brief Bytes por índice. */
+    static unsigned int getIndexSize(IndexFormat format);
+
+    /** @brief Formato DXGI para IASetIndexBuffer. */
+    static DXGI_FORMAT getDXGIFormat(IndexFormat format);
+
+    /**
+     * @brief Calcula el layout compacto (snorm16 + half) ajustado a la caja de los vértices.
+     * @param vertices Vértices de la malla.
+     */
+    static VertexLayout computeCompactLayout(const std::vector<SimpleVertex>& vertices);
+
+    /**
+     * @brief Codifica los vértices según el layout.
+     * @param vertices Vértices de origen.
+     * @param layout Layout destino.
+     * @param out Bytes de salida (vertices.size() * layout.getStride()).
+     */
+    static void encodeVertices(const std::vector<SimpleVertex>& vertices,
+        const VertexLayout& layout,
+        std::vector<unsigned char>& out);
+
+    /**
+     * @brief Decodifica un vértice codificado con encodeVertices().
+     * @param data Inicio del vértice.
+     * @param layout Layout con el que se codificó.
+     */
+    static SimpleVertex decodeVertex(const unsigned char* data, const VertexLayout& layout);
+
+    /**
+     * @brief Codifica los índices con el ancho indicado.
+     * @param indices Índices de 32 bits.
+     * @param format Ancho destino.
+     * @param out Bytes de salida.
+     * @return false si algún índice no cabe en el formato.
+     */
+    static bool encodeIndices(const std::vector<unsigned int>& indices,
+        IndexFormat format,
+        std::vector<unsigned char>& out);
+
+    /**
+     * @brief Codifica y decodifica todos los vértices y compara con los originales.
+     * @param vertices Vértices de la malla.
+     * @param layout Layout a comprobar.
+     * @param error Errores medidos y cotas (opcional).
+     * @return true si ningún atributo supera su cota teórica.
+     */
+    static bool verifyRoundTrip(const std::vector<SimpleVertex>& vertices,
+        const VertexLayout& layout,
+        VertexRoundTripError* error = nullptr);
+
+    /**
+     * @brief Elige el formato de índices y, opcionalmente, el layout compacto de una malla.
+     * @param mesh Malla importada (se actualizan m_indexFormat y m_vertexLayout).
+     * @param compactVertices true para intentar snorm16/half; si el round-trip supera
+     *        las cotas se mantiene el layout float.
+     * @return true si se usa el layout compacto.
+     */
+    static bool selectFormats(MeshComponent& mesh, bool compactVertices);
+};
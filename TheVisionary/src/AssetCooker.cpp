@@ -0,0 +1,314 @@
+﻿/**
+ * @file AssetCooker.cpp
+ * @brief Implementación del cocinado incremental de assets con caché por contenido.
+ */
+
+#include "AssetCooker.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "ModelLoader.h"
+#include "Texture.h"
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+namespace {
+	/// Versión del cocinador: cambiarla invalida toda la caché.
+	const uint64_t kCookerVersion = 6;
+
+	/// Archivo de caché por defecto dentro del directorio de salida.
+	const char* kDefaultCacheName = "cook_cache.db";
+
+	/**
+	 * @brief Determina el tipo de asset a partir de la extensión.
+	 * @return true si la extensión es soportada.
+	 */
+	bool
+	classifyAsset(const fs::path& path, CookedAssetType& type) {
+		std::string ext = path.extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(),
+			[](unsigned char c) { return static_cast<char>(::tolower(c)); });
+
+		if (ext == ".fbx" || ext == ".obj") {
+			type = COOKED_MESH;
+			return true;
+		}
+		if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga" || ext == ".bmp") {
+			type = COOKED_TEXTURE;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Hash de la configuración de importación de un asset.
+	 * @details Combina la versión del cocinador, el tipo y el contenido del
+	 * archivo `<asset>.import` si existe.
+	 */
+	uint64_t
+	hashImportSettings(const std::string& sourcePath, CookedAssetType type) {
+		uint64_t hash = hashCombine(kHashSeed, kCookerVersion);
+		hash = hashCombine(hash, static_cast<uint64_t>(type));
+
+		uint64_t sidecarHash = 0;
+		if (hashFile(sourcePath + ".import", sidecarHash)) {
+			hash = hashCombine(hash, sidecarHash);
+		}
+		return hash;
+	}
+
+	/**
+	 * @brief Lee un hash hexadecimal de un campo de la base de datos.
+	 * @return false si el campo está vacío o tiene algo que no es un número (entrada corrupta).
+	 */
+	bool
+	parseHash(const std::string& field, uint64_t& hash) {
+		if (field.empty() || !std::isxdigit(static_cast<unsigned char>(field[0]))) {
+			return false;
+		}
+		errno = 0;
+		char* end = nullptr;
+		hash = std::strtoull(field.c_str(), &end, 16);
+		return errno == 0 && end == field.c_str() + field.size();
+	}
+
+	double
+	elapsedMs(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+HRESULT
+AssetCooker::init(const std::string& sourceDir,
+	const std::string& outputDir,
+	const std::string& cacheFile) {
+	std::error_code ec;
+	if (!fs::is_directory(sourceDir, ec)) {
+		ERROR("AssetCooker", "init", "Source directory does not exist: " << sourceDir.c_str());
+		return E_INVALIDARG;
+	}
+
+	fs::create_directories(outputDir, ec);
+	if (ec) {
+		ERROR("AssetCooker", "init", "Cannot create output directory: " << outputDir.c_str());
+		return E_FAIL;
+	}
+
+	m_sourceDir = sourceDir;
+	m_outputDir = outputDir;
+	m_cacheFile = cacheFile.empty()
+		? (fs::path(outputDir) / kDefaultCacheName).string()
+		: cacheFile;
+
+	loadCache();
+	return S_OK;
+}
+
+CookReport
+AssetCooker::cookAll(unsigned int numThreads, bool force) {
+	const auto start = std::chrono::steady_clock::now();
+	CookReport report;
+
+	// 01. Recolectar los assets soportados.
+	struct PendingAsset {
+		std::string relativePath;
+		std::string sourcePath;
+		CookedAssetType type;
+	};
+	std::vector<PendingAsset> assets;
+
+	std::error_code ec;
+	for (auto it = fs::recursive_directory_iterator(m_sourceDir, ec);
+		it != fs::recursive_directory_iterator(); it.increment(ec)) {
+		if (ec || !it->is_regular_file()) {
+			continue;
+		}
+		CookedAssetType type;
+		if (!classifyAsset(it->path(), type)) {
+			continue;
+		}
+		PendingAsset asset;
+		asset.sourcePath = it->path().string();
+		asset.relativePath = fs::relative(it->path(), m_sourceDir).generic_string();
+		asset.type = type;
+		assets.push_back(asset);
+	}
+	// Orden estable para que el informe y la caché sean deterministas.
+	std::sort(assets.begin(), assets.end(),
+		[](const PendingAsset& a, const PendingAsset& b) { return a.relativePath < b.relativePath; });
+
+	report.assets.resize(assets.size());
+	std::vector<CookCacheEntry> entries(assets.size());
+
+	// 02. Hashear y cocinar en paralelo; cada asset escribe solo su propia ranura.
+	JobSystem jobs;
+	jobs.init(numThreads);
+	jobs.parallelFor(static_cast<unsigned int>(assets.size()), 1,
+		[&](unsigned int begin, unsigned int end) {
+			for (unsigned int i = begin; i < end; ++i) {
+				const auto assetStart = std::chrono::steady_clock::now();
+				const PendingAsset& asset = assets[i];
+				CookAssetResult& result = report.assets[i];
+				CookCacheEntry& entry = entries[i];
+
+				result.relativePath = asset.relativePath;
+				entry.outputPath = getCookedPath(m_outputDir, asset.relativePath, asset.type);
+				entry.settingsHash = hashImportSettings(asset.sourcePath, asset.type);
+				if (!hashFile(asset.sourcePath, entry.sourceHash)) {
+					result.milliseconds = elapsedMs(assetStart);
+					continue;
+				}
+
+				auto cached = m_cache.find(asset.relativePath);
+				std::error_code existsError;
+				if (!force && cached != m_cache.end() &&
+					cached->second.sourceHash == entry.sourceHash &&
+					cached->second.settingsHash == entry.settingsHash &&
+					fs::exists(entry.outputPath, existsError)) {
+					result.cacheHit = true;
+					result.success = true;
+				}
+				else {
+					result.success = cookAsset(asset.sourcePath, entry.outputPath, asset.type, &jobs);
+				}
+				result.milliseconds = elapsedMs(assetStart);
+			}
+		});
+	jobs.destroy();
+
+	// 03. Actualizar la caché (solo assets válidos) y los contadores.
+	for (size_t i = 0; i < assets.size(); ++i) {
+		const CookAssetResult& result = report.assets[i];
+		if (!result.success) {
+			++report.failed;
+			m_cache.erase(assets[i].relativePath);
+			continue;
+		}
+		if (result.cacheHit) {
+			++report.cacheHits;
+		}
+		else {
+			++report.cooked;
+		}
+		m_cache[assets[i].relativePath] = entries[i];
+	}
+	saveCache();
+
+	report.totalMilliseconds = elapsedMs(start);
+	return report;
+}
+
+void
+AssetCooker::printReport(const CookReport& report) {
+	for (const CookAssetResult& asset : report.assets) {
+		std::printf("  %-6s %9.2f ms  %s\n",
+			!asset.success ? "FAIL" : (asset.cacheHit ? "cached" : "cooked"),
+			asset.milliseconds,
+			asset.relativePath.c_str());
+	}
+	std::printf("Assets: %zu  cooked: %u  cached: %u  failed: %u\n",
+		report.assets.size(), report.cooked, report.cacheHits, report.failed);
+	std::printf("Cache hit rate: %.1f%%  total: %.2f ms\n",
+		report.hitRate() * 100.0, report.totalMilliseconds);
+}
+
+std::string
+AssetCooker::getCookedPath(const std::string& outputDir,
+	const std::string& relativePath,
+	CookedAssetType type) {
+	fs::path path = fs::path(outputDir) / relativePath;
+	path += (type == COOKED_MESH) ? ".vmesh" : ".vtex";
+	return path.string();
+}
+
+void
+AssetCooker::loadCache() {
+	m_cache.clear();
+	std::ifstream file(m_cacheFile);
+	if (!file) {
+		return;
+	}
+
+	// Formato: ruta relativa \t hash fuente \t hash configuración \t salida
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string relativePath, sourceHash, settingsHash;
+		CookCacheEntry entry;
+		if (!std::getline(fields, relativePath, '\t') ||
+			!std::getline(fields, sourceHash, '\t') ||
+			!std::getline(fields, settingsHash, '\t') ||
+			!std::getline(fields, entry.outputPath)) {
+			continue;
+		}
+		// Una línea cortada o corrupta es un fallo de caché: el asset se vuelve a cocinar.
+		if (!parseHash(sourceHash, entry.sourceHash) || !parseHash(settingsHash, entry.settingsHash) ||
+			relativePath.empty() || entry.outputPath.empty()) {
+			continue;
+		}
+		m_cache[relativePath] = entry;
+	}
+}
+
+void
+AssetCooker::saveCache() const {
+	std::ofstream file(m_cacheFile, std::ios::trunc);
+	if (!file) {
+		ERROR("AssetCooker", "saveCache", "Cannot write cache file " << m_cacheFile.c_str());
+		return;
+	}
+
+	for (const auto& item : m_cache) {
+		file << item.first << '\t'
+			<< std::hex << item.second.sourceHash << '\t'
+			<< item.second.settingsHash << std::dec << '\t'
+			<< item.second.outputPath << '\n';
+	}
+}
+
+bool
+AssetCooker::cookAsset(const std::string& sourcePath,
+	const std::string& outputPath,
+	CookedAssetType type,
+	JobSystem* jobs) const {
+	std::error_code ec;
+	fs::create_directories(fs::path(outputPath).parent_path(), ec);
+
+	if (type == COOKED_TEXTURE) {
+		ImageData image;
+		if (FAILED(Texture::decodeImage(sourcePath, image))) {
+			return false;
+		}
+		return SUCCEEDED(Texture::writeCookedImage(outputPath, image));
+	}
+
+	// Cada tarea usa su propio ModelLoader (y su propio FbxManager).
+	ModelLoader loader;
+	loader.setJobSystem(jobs);
+	std::string ext = fs::path(sourcePath).extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(),
+		[](unsigned char c) { return static_cast<char>(::tolower(c)); });
+
+	bool loaded = false;
+	if (ext == ".obj") {
+		MeshComponent mesh = loader.LoadOBJModel(sourcePath);
+		loaded = !mesh.m_vertex.empty();
+		if (loaded) {
+			loader.meshes.push_back(mesh);
+		}
+	}
+	else {
+		loaded = loader.LoadFBXModel(sourcePath);
+	}
+
+	const bool saved = loaded && loader.SaveCookedModel(outputPath);
+	loader.destroy();
+	return saved;
+}
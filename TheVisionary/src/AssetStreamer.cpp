@@ -0,0 +1,377 @@
+﻿/**
+ * @file AssetStreamer.cpp
+ * @brief Implementación del streaming asíncrono de assets (IO, decodificación y subida por presupuesto).
+ */
+
+#include "AssetStreamer.h"
+#include "ModelLoader.h"
+#include <fstream>
+#include <chrono>
+
+namespace {
+	std::string
+	lowerExtension(const std::string& path) {
+		const size_t dot = path.find_last_of('.');
+		std::string ext = dot == std::string::npos ? std::string() : path.substr(dot);
+		std::transform(ext.begin(), ext.end(), ext.begin(),
+			[](unsigned char c) { return static_cast<char>(::tolower(c)); });
+		return ext;
+	}
+
+	/// FBX y OBJ los leen sus propias librerías; el resto se lee en el hilo de IO.
+	bool
+	readsInIoThread(const std::string& path) {
+		const std::string ext = lowerExtension(path);
+		return ext != ".fbx" && ext != ".obj";
+	}
+
+	bool
+	readWholeFile(const std::string& path, std::vector<unsigned char>& bytes) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		bytes.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		return static_cast<bool>(file);
+	}
+
+	double
+	elapsedMs(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+HRESULT
+AssetStreamer::init(unsigned int decodeThreads) {
+	if (m_running) {
+		ERROR("AssetStreamer", "init", "AssetStreamer is already running.");
+		return E_FAIL;
+	}
+
+	m_decoders.init(decodeThreads);
+	// Límite de assets en memoria a la vez: suficiente para mantener ocupados
+	// a los trabajadores sin que el IO se adelante leyendo toda la cola.
+	m_maxInFlight = std::max(2u, m_decoders.getThreadCount() * 2);
+	m_running = true;
+	m_ioThread = std::thread(&AssetStreamer::ioLoop, this);
+
+	MESSAGE("AssetStreamer", "init", "IO thread + " << m_decoders.getThreadCount() << " decode workers");
+	return S_OK;
+}
+
+StreamHandle
+AssetStreamer::request(const std::string& path,
+	StreamAssetType type,
+	StreamPriority priority,
+	StreamCallback onReady) {
+	RequestPtr req = std::make_shared<Request>();
+	req->path = path;
+	req->type = type;
+	req->priority = priority;
+	req->onReady = std::move(onReady);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_running) {
+			ERROR("AssetStreamer", "request", "AssetStreamer is not running.");
+			return 0;
+		}
+		req->handle = m_nextHandle++;
+		m_requests[req->handle] = req;
+		m_queues[priority].push_back(req->handle);
+		++m_stats.queued;
+	}
+	m_ioWake.notify_one();
+	return req->handle;
+}
+
+bool
+AssetStreamer::cancel(StreamHandle handle) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_requests.find(handle);
+	if (it == m_requests.end()) {
+		return false;
+	}
+
+	RequestPtr& req = it->second;
+	switch (req->state) {
+	case STREAM_QUEUED:
+		// La entrada en la cola queda obsoleta y el hilo de IO la descarta.
+		--m_stats.queued;
+		break;
+	case STREAM_LOADING:
+	case STREAM_DECODING:
+		// El resultado se descarta cuando el trabajador termine.
+		break;
+	case STREAM_READY:
+		m_ready.erase(std::remove(m_ready.begin(), m_ready.end(), req), m_ready.end());
+		break;
+	default:
+		return false;
+	}
+
+	req->state = STREAM_CANCELED;
+	req->onReady = nullptr;
+	req->result = StreamedAsset();
+	++m_stats.canceled;
+	// La cola y el trabajador que aún la tengan ven el estado y la descartan.
+	m_requests.erase(it);
+	return true;
+}
+
+void
+AssetStreamer::setPriority(StreamHandle handle, StreamPriority priority) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_requests.find(handle);
+		if (it == m_requests.end() || it->second->priority == priority) {
+			return;
+		}
+
+		it->second->priority = priority;
+		// En cola: se reencola; la entrada antigua se ignora por no coincidir la prioridad.
+		if (it->second->state == STREAM_QUEUED) {
+			m_queues[priority].push_back(handle);
+		}
+	}
+	m_ioWake.notify_one();
+}
+
+StreamState
+AssetStreamer::getState(StreamHandle handle) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_requests.find(handle);
+	return it == m_requests.end() ? STREAM_INVALID : it->second->state;
+}
+
+void
+AssetStreamer::update(size_t byteBudget, double msBudget) {
+	const auto start = std::chrono::steady_clock::now();
+	size_t frameBytes = 0;
+
+	std::vector<RequestPtr> batch;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		batch.swap(m_ready);
+	}
+	std::sort(batch.begin(), batch.end(), [](const RequestPtr& a, const RequestPtr& b) {
+		return a->priority != b->priority ? a->priority < b->priority : a->handle < b->handle;
+	});
+
+	size_t next = 0;
+	for (; next < batch.size(); ++next) {
+		// Siempre se entrega al menos un asset para garantizar progreso.
+		if (next > 0 &&
+			((byteBudget > 0 && frameBytes >= byteBudget) ||
+				(msBudget > 0.0 && elapsedMs(start) >= msBudget))) {
+			break;
+		}
+
+		RequestPtr& req = batch[next];
+		StreamCallback onReady;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (req->state != STREAM_READY) {
+				continue;
+			}
+			onReady = std::move(req->onReady);
+		}
+
+		if (!req->result.success) {
+			ERROR("AssetStreamer", "update", "Failed to stream " << req->path.c_str());
+		}
+		if (onReady) {
+			onReady(req->result);
+		}
+		frameBytes += req->result.byteSize;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (req->result.success) {
+			req->state = STREAM_RESIDENT;
+			++m_stats.resident;
+		}
+		else {
+			req->state = STREAM_FAILED;
+			++m_stats.failed;
+		}
+		req->result = StreamedAsset();
+		// Terminada: el mapa solo guarda peticiones vivas.
+		m_requests.erase(req->handle);
+	}
+
+	const double frameMs = elapsedMs(start);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_ready.insert(m_ready.end(), batch.begin() + next, batch.end());
+	m_stats.ready = static_cast<unsigned int>(m_ready.size());
+	m_stats.inFlight = m_inFlight;
+	m_stats.frameBytes = frameBytes;
+	m_stats.frameMs = frameMs;
+	m_stats.worstFrameMs = std::max(m_stats.worstFrameMs, frameMs);
+	m_stats.totalBytes += frameBytes;
+}
+
+void
+AssetStreamer::destroy() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_running) {
+			return;
+		}
+		m_running = false;
+	}
+	m_ioWake.notify_all();
+
+	if (m_ioThread.joinable()) {
+		m_ioThread.join();
+	}
+	// Termina las decodificaciones en curso antes de liberar las peticiones.
+	m_decoders.destroy();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto& queue : m_queues) {
+		queue.clear();
+	}
+	m_requests.clear();
+	m_ready.clear();
+	m_inFlight = 0;
+	m_stats = StreamingStats();
+}
+
+bool
+AssetStreamer::isIdle() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats.queued == 0 && m_inFlight == 0 && m_ready.empty();
+}
+
+AssetStreamer::RequestPtr
+AssetStreamer::popNextLocked() {
+	for (int priority = 0; priority < STREAM_PRIORITY_COUNT; ++priority) {
+		auto& queue = m_queues[priority];
+		while (!queue.empty()) {
+			const StreamHandle handle = queue.front();
+			queue.pop_front();
+
+			auto it = m_requests.find(handle);
+			if (it != m_requests.end() &&
+				it->second->state == STREAM_QUEUED &&
+				it->second->priority == priority) {
+				return it->second;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void
+AssetStreamer::ioLoop() {
+	for (;;) {
+		RequestPtr req;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_ioWake.wait(lock, [this]() {
+				if (!m_running) {
+					return true;
+				}
+				if (m_inFlight >= m_maxInFlight) {
+					return false;
+				}
+				for (const auto& queue : m_queues) {
+					if (!queue.empty()) {
+						return true;
+					}
+				}
+				return false;
+			});
+			if (!m_running) {
+				return;
+			}
+
+			req = popNextLocked();
+			if (!req) {
+				continue;
+			}
+			req->state = STREAM_LOADING;
+			--m_stats.queued;
+			++m_inFlight;
+		}
+
+		std::vector<unsigned char> bytes;
+		bool readOk = true;
+		if (readsInIoThread(req->path)) {
+			readOk = readWholeFile(req->path, bytes);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (req->state == STREAM_CANCELED) {
+				--m_inFlight;
+				continue;
+			}
+			req->state = STREAM_DECODING;
+		}
+
+		if (!readOk) {
+			decode(req, std::vector<unsigned char>());
+			continue;
+		}
+		m_decoders.submit([this, req, bytes]() mutable {
+			decode(req, std::move(bytes));
+		});
+	}
+}
+
+void
+AssetStreamer::decode(RequestPtr req, std::vector<unsigned char> bytes) {
+	StreamedAsset result;
+	result.handle = req->handle;
+	result.type = req->type;
+	result.path = req->path;
+
+	const bool needsBytes = readsInIoThread(req->path);
+	if (!needsBytes || !bytes.empty()) {
+		if (req->type == STREAM_TEXTURE) {
+			result.success = SUCCEEDED(Texture::decodeImage(bytes.data(), bytes.size(), result.image));
+			result.byteSize = result.image.pixels.size();
+		}
+		else {
+			ModelLoader loader;
+			loader.setJobSystem(&m_decoders);
+			loader.setCompactVertices(m_compactVertices);
+			const std::string ext = lowerExtension(req->path);
+			if (ext == ".vmesh") {
+				result.success = loader.ParseCookedModel(bytes.data(), bytes.size());
+			}
+			else if (ext == ".obj") {
+				MeshComponent mesh = loader.LoadOBJModel(req->path);
+				result.success = !mesh.m_vertex.empty();
+				if (result.success) {
+					loader.meshes.push_back(mesh);
+				}
+			}
+			else {
+				result.success = loader.LoadFBXModel(req->path) && !loader.meshes.empty();
+				loader.destroy();
+			}
+
+			result.meshes = std::move(loader.meshes);
+			for (const MeshComponent& mesh : result.meshes) {
+				result.byteSize += mesh.m_vertex.size() * sizeof(SimpleVertex) +
+					mesh.m_index.size() * sizeof(unsigned int);
+			}
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--m_inFlight;
+		if (req->state == STREAM_DECODING) {
+			req->result = std::move(result);
+			req->state = STREAM_READY;
+			m_ready.push_back(req);
+		}
+	}
+	m_ioWake.notify_one();
+}
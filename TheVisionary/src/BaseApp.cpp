@@ -10,10 +10,97 @@
 // Color de limpieza
 static const float kClear[4] = { 0.0f, 0.125f, 0.30f, 1.0f };
 
+// Bytecode de los shaders entre arranques.
+static const char* kShaderCachePath = "Cooked\\Shaders.vshc";
+static const char* kCapturePath = "Captures\\Frame.vcap";
+static const char* kProfilePath = "Captures\\Profile.json";
+static const char* kOcclusionGoldenPath = "Golden\\OcclusionScene.vdepth";
+
+// Cubo que sustituye a las mallas mientras se cargan.
+static MeshComponent CreatePlaceholderMesh(float h)
+{
+    MeshComponent mesh;
+    mesh.m_name = "Placeholder";
+    for (int i = 0; i < 8; ++i) {
+        mesh.m_vertex.push_back({ XMFLOAT3((i & 1) ? h : -h, (i & 2) ? h : -h, (i & 4) ? h : -h),
+                                  XMFLOAT2((i & 1) ? 1.0f : 0.0f, (i & 2) ? 0.0f : 1.0f) });
+    }
+    const unsigned int indices[] = {
+        0,2,1, 1,2,3,   4,5,6, 5,7,6,   0,1,4, 1,5,4,
+        2,6,3, 3,6,7,   0,4,2, 2,4,6,   1,3,5, 3,7,5 };
+    mesh.m_index.assign(std::begin(indices), std::end(indices));
+    mesh.m_numVertex = (int)mesh.m_vertex.size();
+    mesh.m_numIndex = (int)mesh.m_index.size();
+    VertexCodec::selectFormats(mesh, false);
+    return mesh;
+}
+
+// Textura de cuadros 8x8 (gris/magenta) para assets aún no residentes.
+static ImageData CreatePlaceholderImage()
+{
+    ImageData image;
+    image.width = 8;
+    image.height = 8;
+    image.pixels.resize(image.width * image.height * 4);
+    for (unsigned int y = 0; y < image.height; ++y) {
+        for (unsigned int x = 0; x < image.width; ++x) {
+            unsigned char* px = &image.pixels[(y * image.width + x) * 4];
+            const bool odd = ((x ^ y) & 1) != 0;
+            px[0] = odd ? 255 : 96;
+            px[1] = odd ? 0 : 96;
+            px[2] = odd ? 255 : 96;
+            px[3] = 255;
+        }
+    }
+    return image;
+}
+
+// Estimación de triángulos con LOD para 1000 instancias en una rejilla de
+// 40x25 (separación 1.5) frente a la cámara, comparada con el detalle completo.
+static void LogInstancedLODSavings(const std::vector<MeshComponent>& meshes, float scale,
+    const XMFLOAT3& eye, const XMFLOAT3& target, float projectionScale)
+{
+    const int kColumns = 40, kRows = 25;
+    const float kSpacing = 1.5f;
+    const auto start = std::chrono::steady_clock::now();
+
+    unsigned long long full = 0, drawn = 0;
+    unsigned int perLevel[8] = {};
+    for (const MeshComponent& mesh : meshes) {
+        const XMFLOAT4& sphere = mesh.m_bounds.sphere;
+        for (int row = 0; row < kRows; ++row) {
+            for (int column = 0; column < kColumns; ++column) {
+                const XMFLOAT3 center(target.x + (column - kColumns / 2) * kSpacing + sphere.x * scale,
+                    target.y + sphere.y * scale,
+                    target.z + row * kSpacing + sphere.z * scale);
+                const float size = MeshSimplifier::projectedSize(center, sphere.w * scale, eye, projectionScale);
+                const unsigned int lod = MeshSimplifier::selectLOD(mesh.m_lods, size, 0);
+                full += mesh.m_numIndex / 3;
+                drawn += (lod < mesh.m_lods.size() ? mesh.m_lods[lod].indexCount : mesh.m_numIndex) / 3;
+                ++perLevel[std::min(lod, 7u)];
+            }
+        }
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    MESSAGE("BaseApp", "LogInstancedLODSavings", "1000 instances: " << drawn << " of " << full << " triangles ("
+        << (full ? 100.0 * (1.0 - double(drawn) / double(full)) : 0.0) << "% saved; LOD0-3 picks "
+        << perLevel[0] << "/" << perLevel[1] << "/" << perLevel[2] << "/" << perLevel[3] << ") selected in " << ms << " ms");
+}
+
+static bool FileExists(const std::string& path)
+{
+    const DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
 HRESULT BaseApp::init()
 {
     HRESULT hr = S_OK;
 
+    // Antes de cargar nada: las etapas de ModelLoader del arranque caen en el primer frame del profiler.
+    Profiler::setEnabled(m_profiling);
+
     // 1) SwapChain + Device + Context + BackBuffer  (sin MSAA para evitar mismatches)
     hr = m_swapChain.init(m_device, m_deviceContext, m_backBuffer, m_window);
     if (FAILED(hr)) {
@@ -56,37 +143,40 @@ HRESULT BaseApp::init()
         return hr;
     }
 
-    // 5) InputLayout (POSITION, TEXCOORD)
+    // 5) InputLayout (POSITION, TEXCOORD) del formato float; las variantes
+    //    compactas (snorm16/half) se crean al subir cada malla.
     std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
-    {
-        D3D11_INPUT_ELEMENT_DESC pos{};
-        pos.SemanticName = "POSITION";
-        pos.SemanticIndex = 0;
-        pos.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-        pos.InputSlot = 0;
-        pos.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-        pos.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-        pos.InstanceDataStepRate = 0;
-        layout.push_back(pos);
-
-        D3D11_INPUT_ELEMENT_DESC uv{};
-        uv.SemanticName = "TEXCOORD";
-        uv.SemanticIndex = 0;
-        uv.Format = DXGI_FORMAT_R32G32_FLOAT;
-        uv.InputSlot = 0;
-        uv.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-        uv.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-        uv.InstanceDataStepRate = 0;
-        layout.push_back(uv);
-    }
+    VertexLayout().getInputElements(layout);
 
     // --- 6) Shaders (.fx) ---
+    // Con la caché en disco caliente no se compila nada: el bytecode sale de una sola lectura.
+    m_device.m_shaderCache = std::make_shared<ShaderCache>(std::make_shared<D3DShaderCompiler>());
+    m_device.m_shaderCache->load(kShaderCachePath);
+    if (m_device.m_shaderCache->getStats().invalid) {
+        ERROR("BaseApp", "init", "Ignoring invalid shader cache " << kShaderCachePath);
+    }
+
     hr = m_shaderProgram.init(m_device, "TheVisionary.fx", layout);  // <- usa aquí el .fx real en tu bin
     if (FAILED(hr)) {
         ERROR("Main", "InitDevice", ("Failed to initialize ShaderProgram. hr=" + std::to_string(hr)).c_str());
         return hr;
     }
 
+    // Programa instanciado (HLSL en memoria); sin él los actores se dibujan uno a uno.
+    if (FAILED(m_instanceBatcher.init(m_device))) {
+        ERROR("Main", "InitDevice", "Instancing disabled: failed to initialize InstanceBatcher.");
+    }
+
+    // Anillo de constantes por draw; sin Direct3D 11.1 cada actor sigue subiendo a su propio buffer.
+    if (FAILED(m_constantRing.init(m_device, m_deviceContext))) {
+        MESSAGE("Main", "InitDevice", "Constant ring unavailable (needs Direct3D 11.1): using per-object constant buffers");
+    }
+
+    // Mallas en páginas compartidas; sin heap cada malla crea su par de buffers.
+    if (FAILED(m_geometryHeap.init(m_device, m_deviceContext))) {
+        ERROR("Main", "InitDevice", "Geometry heap disabled: meshes use their own buffers.");
+    }
+
     // --- 7) Constant Buffers (cámara) ---
     hr = m_neverChanges.init(m_device, sizeof(CBNeverChanges));
     if (FAILED(hr)) {
@@ -116,7 +206,31 @@ HRESULT BaseApp::init()
         cbChangesOnResize.mProjection = XMMatrixTranspose(m_Projection);
     }
 
-    // --- 9) Actor: Ninja (FBX) ---
+    // Trabajadores para las etapas paralelas del frame (culling de escenas grandes)
+    m_jobs.init();
+    m_occlusion.init();
+
+    // Un contexto diferido por trabajador del envío paralelo (opcional: sin ellos se envía en el inmediato)
+    hr = m_deferredContexts.init(m_device, DeferredContextPool::kMaxContexts);
+    if (FAILED(hr)) {
+        ERROR("Main", "InitDevice", ("Failed to create deferred contexts. hr=" + std::to_string(hr)).c_str());
+    }
+    else if (!m_deferredContexts.hasNativeCommandLists()) {
+        MESSAGE("BaseApp", "init", "Driver command lists are emulated; parallel submit records on the immediate context");
+    }
+
+    // --- 9) Streaming de assets + placeholders ---
+    m_streamer.setCompactVertices(true);
+    hr = m_streamer.init();
+    if (FAILED(hr)) {
+        ERROR("Main", "InitDevice", ("Failed to initialize AssetStreamer. hr=" + std::to_string(hr)).c_str());
+        return hr;
+    }
+    m_placeholderImage = CreatePlaceholderImage();
+
+    // --- 9.1) Actor: Ninja (FBX) ---
+    // La malla y la piel se cargan en segundo plano; mientras tanto se
+    // muestra un cubo con textura de cuadros.
     {
         auto ninja = EU::MakeShared<Actor>(m_device);
         if (ninja.isNull()) {
@@ -124,35 +238,53 @@ HRESULT BaseApp::init()
             return E_FAIL;
         }
 
-        const std::string kFBX = "ModelsFBX\\NinjaObscurity\\Ninja of Obscurity v02.fbx";
-        if (!m_modelLoader.LoadFBXModel(kFBX) || m_modelLoader.meshes.empty()) {
-            ERROR("Main", "InitDevice", ("Failed to load Ninja FBX: " + kFBX).c_str());
-            return E_FAIL;
-        }
+        ninja->setShaderProgram(&m_shaderProgram);
+        ninja->setGeometryHeap(&m_geometryHeap);
 
-        // Malla(s)
-        ninja->setMesh(m_device, m_modelLoader.meshes);
+        // Cubo de 100 unidades: con la escala 0.01 del FBX queda de 1 unidad
+        std::vector<MeshComponent> placeholderMeshes{ CreatePlaceholderMesh(50.0f) };
+        ninja->setMesh(m_device, placeholderMeshes);
 
-        // Textura principal (intenta PNG y luego DDS)
-        Texture ninjaSkin;
-        HRESULT th = ninjaSkin.init(m_device, "ModelsFBX\\NinjaObscurity\\ninja_skin_02", PNG);
-        if (FAILED(th)) {
-            th = ninjaSkin.init(m_device, "ModelsFBX\\NinjaObscurity\\ninja_skin_02", DDS);
-        }
+        Texture ninjaPlaceholder;
+        ninjaPlaceholder.init(m_device, m_placeholderImage);
+        std::vector<Texture> placeholderTextures{ ninjaPlaceholder };
+        ninja->setTextures(placeholderTextures);
 
-        std::vector<Texture> ninjaTex;
-        if (SUCCEEDED(th)) {
-            ninjaTex.push_back(ninjaSkin);
-        }
-        else {
-            // Fallback a textura por defecto
-            Texture fallback;
-            if (SUCCEEDED(fallback.init(m_device, "Textures\\Default", DDS)) ||
-                SUCCEEDED(fallback.init(m_device, "Textures\\Default", PNG))) {
-                ninjaTex.push_back(fallback);
-            }
-        }
-        ninja->setTextures(ninjaTex);
+        // Se prefiere la versión cocinada (TheVisionaryCooker ModelsFBX Cooked\ModelsFBX);
+        // si no existe se importa el FBX original.
+        const std::string kFBX = "ModelsFBX\\NinjaObscurity\\Ninja of Obscurity v02.fbx";
+        const std::string kCookedFBX = "Cooked\\" + kFBX + ".vmesh";
+        m_streamer.request(FileExists(kCookedFBX) ? kCookedFBX : kFBX, STREAM_MESH, STREAM_VISIBLE,
+            [this, ninja](StreamedAsset& asset) mutable {
+                if (asset.success && !asset.meshes.empty()) {
+                    ninja->setMesh(m_device, asset.meshes);
+                    LogInstancedLODSavings(asset.meshes, 0.01f, m_camEye, m_camTarget,
+                        XMVectorGetY(m_Projection.r[1]));
+                }
+            });
+
+        // Textura principal (cocinada o PNG en streaming; DDS/Default como respaldo síncrono)
+        const std::string kSkin = "ModelsFBX\\NinjaObscurity\\ninja_skin_02";
+        const std::string kCookedSkin = "Cooked\\" + kSkin + ".png.vtex";
+        m_streamer.request(FileExists(kCookedSkin) ? kCookedSkin : kSkin + ".png", STREAM_TEXTURE, STREAM_VISIBLE,
+            [this, ninja, ninjaPlaceholder, kSkin](StreamedAsset& asset) mutable {
+                Texture ninjaSkin;
+                HRESULT th = asset.success ? ninjaSkin.init(m_device, asset.image) : E_FAIL;
+                if (FAILED(th)) {
+                    th = ninjaSkin.init(m_device, kSkin, DDS);
+                }
+                if (FAILED(th)) {
+                    // Fallback a textura por defecto
+                    if (FAILED(th = ninjaSkin.init(m_device, "Textures\\Default", DDS))) {
+                        th = ninjaSkin.init(m_device, "Textures\\Default", PNG);
+                    }
+                }
+                if (SUCCEEDED(th)) {
+                    ninjaPlaceholder.destroy();
+                    std::vector<Texture> ninjaTex{ ninjaSkin };
+                    ninja->setTextures(ninjaTex);
+                }
+            });
 
         // Transform (FBX suele venir grande)
         ninja->getComponent<Transform>()->setTransform(
@@ -161,6 +293,7 @@ HRESULT BaseApp::init()
             EU::Vector3(0.01f, 0.01f, 0.01f)  // scale
         );
         ninja->setCastShadow(false);
+        ninja->setOccluder(true);
 
         m_actors.push_back(ninja);
     }
@@ -175,6 +308,8 @@ HRESULT BaseApp::init()
             ERROR("Main", "InitDevice", "Failed to create Plane Actor.");
             return E_FAIL;
         }
+        m_APlane->setShaderProgram(&m_shaderProgram);
+        m_APlane->setGeometryHeap(&m_geometryHeap);
 
         // Malla del plano (UVs preparados para tiling)
         SimpleVertex planeVertices[] =
@@ -190,21 +325,33 @@ HRESULT BaseApp::init()
         planeMesh.m_index.assign(std::begin(planeIndices), std::end(planeIndices));
         planeMesh.m_numVertex = 4;
         planeMesh.m_numIndex = 6;
+        VertexCodec::selectFormats(planeMesh, true);
 
         std::vector<MeshComponent> planeMeshes{ planeMesh };
         m_APlane->setMesh(m_device, planeMeshes);
 
-        // *** Textura del piso: ModelsFBX\NinjaObscurity\Lava.png ***
-        HRESULT hr = m_PlaneTexture.init(m_device, "ModelsFBX\\NinjaObscurity\\Lava", PNG);
-        if (FAILED(hr)) {
-            // Fallback si no se encuentra la Lava
-            if (FAILED(m_PlaneTexture.init(m_device, "Textures\\Default", DDS)))
-                m_PlaneTexture.init(m_device, "Textures\\Default", PNG);
-        }
-
-        std::vector<Texture> planeTextures{ m_PlaneTexture };
+        // *** Textura del piso: ModelsFBX\NinjaObscurity\Lava.png (en streaming) ***
+        Texture planePlaceholder;
+        planePlaceholder.init(m_device, m_placeholderImage);
+        std::vector<Texture> planeTextures{ planePlaceholder };
         m_APlane->setTextures(planeTextures);
 
+        m_streamer.request("ModelsFBX\\NinjaObscurity\\Lava.png", STREAM_TEXTURE, STREAM_NEARBY,
+            [this, planePlaceholder](StreamedAsset& asset) mutable {
+                HRESULT th = asset.success ? m_PlaneTexture.init(m_device, asset.image) : E_FAIL;
+                if (FAILED(th)) {
+                    // Fallback si no se encuentra la Lava
+                    if (FAILED(th = m_PlaneTexture.init(m_device, "Textures\\Default", DDS))) {
+                        th = m_PlaneTexture.init(m_device, "Textures\\Default", PNG);
+                    }
+                }
+                if (SUCCEEDED(th)) {
+                    planePlaceholder.destroy();
+                    std::vector<Texture> planeTextures{ m_PlaneTexture };
+                    m_APlane->setTextures(planeTextures);
+                }
+            });
+
         // Transform (ajusta Y si tu escena usa -5.0f como suelo)
         m_APlane->getComponent<Transform>()->setTransform(
             EU::Vector3(0.0f, -5.0f, 0.0f),   // posición
@@ -214,6 +361,7 @@ HRESULT BaseApp::init()
 
         m_APlane->setCastShadow(false);
         m_APlane->setReceiveShadow(true);
+        m_APlane->setOccluder(true);
 
         m_actors.push_back(m_APlane);
     }
@@ -286,9 +434,261 @@ HRESULT BaseApp::init()
 
 void BaseApp::update()
 {
+    // Frontera de frame del profiler antes de abrir las zonas de este.
+    Profiler& profiler = Profiler::get();
+    profiler.beginFrame();
+    PROFILE_SCOPE("BaseApp::update");
+
+    // --- Métricas de frame ---
+    const auto frameStart = std::chrono::steady_clock::now();
+    if (m_firstFramePresented) {
+        const double frameMs = std::chrono::duration<double, std::milli>(frameStart - m_lastFrame).count();
+        m_worstFrameMs = std::max(m_worstFrameMs, frameMs);
+    }
+    m_lastFrame = frameStart;
+    m_inputTime = frameStart;
+    ++m_frameIndex;
+
+    // --- Tiempo: reloj monotónico; los actores avanzan en pasos fijos y se dibujan interpolados ---
+    m_timestep.setStep(1.0 / std::max(m_simulationHz, 1));
+    m_frameSteps = m_timestep.advance(m_clock.tick(frameStart));
+    PROFILE_COUNTER("Simulation steps", m_frameSteps);
+
+    // --- Hilo de render: el modo elegido en el panel se aplica entre frames ---
+    syncRenderThread();
+    const bool threaded = m_renderThread.isRunning();
+    if (threaded) {
+        m_frameResult = m_renderThread.getLastResult();
+        m_latency[1] = m_renderThread.getStats();
+    }
+    m_latency[0] = m_serialLatency.getStats();
+
+    // --- Streaming: subidas a GPU dentro del presupuesto del frame ---
+    // Los callbacks suben al heap y sustituyen buffers que pueden estar en un paquete publicado.
+    if (threaded && !m_streamer.isIdle()) {
+        acquireContext();
+    }
+    m_streamer.update((size_t)m_streamBudgetKB * 1024, m_streamBudgetMs);
+
     // --- UI frame ---
     m_userInterface.update();
 
+    // Con el hilo de render los contadores del envío llegan con su último frame.
+    const RenderQueueStats& queueStats = threaded ? m_frameResult.queue : m_renderQueue.getStats();
+
+    if (m_userInterface.framePipelinePanel(m_latency[0], m_latency[1], threaded, m_threadedRender, m_dropStalePackets)) {
+        const FrameLatencyStats& serial = m_latency[0];
+        const FrameLatencyStats& pipelined = m_latency[1];
+        MESSAGE("BaseApp", "update", "Serial: " << serial.frameMs << " ms per frame (max " << serial.maxFrameMs
+            << "), latency " << serial.latencyMs << " ms (max " << serial.maxLatencyMs << "), update "
+            << serial.updateMs << " ms, render " << serial.renderMs << " ms; render thread: " << pipelined.frameMs
+            << " ms per frame (max " << pipelined.maxFrameMs << "), latency " << pipelined.latencyMs << " ms (max "
+            << pipelined.maxLatencyMs << "), update " << pipelined.updateMs << " ms, render " << pipelined.renderMs
+            << " ms, " << pipelined.dropped << " dropped");
+    }
+
+    if (m_userInterface.framePacingPanel(m_pacer.getStats(), m_pacing, m_simulationHz, m_timestep, m_frameSteps)) {
+        const FramePacingStats& pacing = m_pacer.getStats();
+        MESSAGE("BaseApp", "update", "Frame pacing (cap " << m_pacing.maxFps << " FPS): " << pacing.frameMs
+            << " ms per frame (min " << pacing.minFrameMs << ", max " << pacing.maxFrameMs << ", std dev "
+            << pacing.stdDevMs << " ms, variance " << pacing.varianceMs2 << " ms^2); busy " << pacing.busyMs
+            << " ms, sleep " << pacing.sleepMs << " ms, spin " << pacing.spinMs << " ms, " << pacing.lateFrames
+            << " late; CPU " << pacing.processCpu << "% of " << pacing.cores << " cores, main thread "
+            << pacing.mainThreadCpu << "%");
+    }
+
+    const ProfilerPanelAction profilerAction = m_userInterface.profilerPanel(profiler.getStats(), profiler.getZones(),
+        profiler.getCounters(), profiler.getThreads(), m_profiling, m_profileFrames);
+    if (profilerAction == PROFILER_CAPTURE) {
+        if (profiler.startCapture(static_cast<unsigned int>(m_profileFrames), kProfilePath)) {
+            m_profiling = true;
+            MESSAGE("BaseApp", "update", "Tracing " << m_profileFrames << " frames to " << kProfilePath);
+        }
+    }
+    else if (profilerAction == PROFILER_LOG) {
+        const std::vector<ProfileThreadStats>& threads = profiler.getThreads();
+        for (const ProfileZoneStats& zone : profiler.getZones()) {
+            MESSAGE("BaseApp", "update", (zone.thread < threads.size() ? threads[zone.thread].name.c_str() : "?")
+                << " " << std::string(zone.depth * 2, ' ').c_str() << zone.name << ": " << zone.avgMs << " ms avg ("
+                << zone.selfMs << " self), " << zone.maxMs << " ms max, " << zone.calls << " calls per frame");
+        }
+    }
+    Profiler::setEnabled(m_profiling);
+
+    if (m_userInterface.streamingPanel(m_streamer.getStats(), m_timeToFirstFrameMs,
+        m_worstFrameMs, m_streamBudgetKB, m_streamBudgetMs)) {
+        startStreamingStress();
+    }
+    const CullingPanelAction cullingAction =
+        m_userInterface.cullingPanel(m_frustumStats, m_meshletStats, m_sceneTreeStats, m_occlusionStats,
+            m_meshletCulling, m_occlusionCulling);
+    if (cullingAction == CULLING_BOUNDS_BENCHMARK) {
+        const BoundsBenchmark bench = BoundingVolume::benchmark(10000000);
+        MESSAGE("BaseApp", "update", "Bounds of " << bench.vertices << " vertices: AABB " << bench.aabbMs
+            << " ms (" << (bench.aabbMs > 0.0 ? bench.vertices / bench.aabbMs / 1000.0 : 0.0) << " M vertices/s), sphere "
+            << bench.sphereMs << " ms (Ritter r = " << bench.ritterRadius << ", box r = " << bench.boxRadius
+            << "), world transform " << bench.transformUs << " us");
+    }
+    else if (cullingAction == CULLING_FRUSTUM_BENCHMARK) {
+        const FrustumCullBenchmark bench = FrustumCuller::benchmark(100000, &m_jobs);
+        MESSAGE("BaseApp", "update", "Frustum culling of " << bench.count << " actors (" << bench.visible
+            << " visible): SSE " << bench.serialMs << " ms on 1 thread, AVX "
+            << (bench.avx ? bench.avxMs : 0.0) << " ms on 1 thread" << (bench.avx ? "" : " (not supported)")
+            << ", " << bench.parallelMs << " ms on " << bench.threads << " threads, paths "
+            << (bench.pathsMatch ? "match" : "DIFFER"));
+    }
+    else if (cullingAction == CULLING_TREE_BENCHMARK) {
+        const DynamicTreeBenchmark bench = DynamicAABBTree::benchmark(100000, &m_jobs);
+        MESSAGE("BaseApp", "update", "Dynamic AABB tree with " << bench.count << " moving objects: insert "
+            << bench.insertMs << " ms (" << (bench.insertMs > 0.0 ? bench.count / bench.insertMs / 1000.0 : 0.0)
+            << " M/s), update " << bench.updateMs << " ms/frame (" << bench.reinsertedPerFrame
+            << " reinserted), " << bench.queries << " box queries " << bench.queryMs << " ms (batched "
+            << bench.batchQueryMs << " ms), " << bench.rays << " rays " << bench.rayMs << " ms, frustum "
+            << bench.frustumMs << " ms (" << bench.frustumHits << " hits), height " << bench.height);
+    }
+    else if (cullingAction == CULLING_RAY_BENCHMARK) {
+        runRayBenchmark();
+    }
+    else if (cullingAction == CULLING_OCCLUSION_GOLDEN_REWRITE) {
+        const OcclusionGoldenResult golden = OcclusionBuffer::checkGolden(kOcclusionGoldenPath, true, &m_jobs);
+        if (golden.rewritten) {
+            MESSAGE("BaseApp", "update", "Occlusion golden depth rewritten to " << kOcclusionGoldenPath);
+        }
+        else {
+            ERROR("BaseApp", "update", "Cannot write occlusion golden depth to " << kOcclusionGoldenPath);
+        }
+    }
+    else if (cullingAction == CULLING_OCCLUSION_GOLDEN) {
+        const OcclusionGoldenResult golden = OcclusionBuffer::checkGolden(kOcclusionGoldenPath, false, &m_jobs);
+        if (!golden.goldenFound) {
+            ERROR("BaseApp", "update", "Occlusion golden check failed: " << kOcclusionGoldenPath << " is missing");
+        }
+        else if (golden.passed()) {
+            MESSAGE("BaseApp", "update", "Occlusion golden check passed (max error " << golden.maxError << ")");
+        }
+        else {
+            ERROR("BaseApp", "update", "Occlusion golden check failed: size " << golden.sizeMatches << ", "
+                << golden.mismatched << " pixels differ (max " << golden.maxError << "), serial == parallel "
+                << golden.serialMatchesParallel << ", visibility " << golden.visibilityMatches);
+        }
+    }
+
+    // Headless cambia el backend del contexto: no se mezcla con una captura en curso.
+    const bool capturing = m_deviceContext.getCapture() != nullptr;
+    if (m_userInterface.headlessPanel(m_headless, m_headlessFrames) && !capturing) {
+        acquireContext();
+        runHeadlessBenchmark(static_cast<unsigned int>(m_headlessFrames));
+    }
+
+    const NullBackendStats captured = m_capture.getStats();
+    const CapturePanelAction captureAction = m_userInterface.capturePanel(
+        capturing || captured.frames > 0 ? &captured : nullptr, capturing, m_replay, m_captureFrames, m_replayRepeats);
+    if (captureAction == CAPTURE_START) {
+        // La captura sigue al contexto en este hilo: syncRenderThread() detiene el hilo de render mientras dura.
+        acquireContext();
+        m_capture.reset();
+        m_deviceContext.beginCapture(m_capture);
+        MESSAGE("BaseApp", "update", "Capturing " << m_captureFrames << " frames");
+    }
+    else if (captureAction == CAPTURE_REPLAY_DEVICE) {
+        acquireContext();
+        runCaptureReplay(true);
+    }
+    else if (captureAction == CAPTURE_REPLAY_HEADLESS) {
+        runCaptureReplay(false);
+    }
+
+    if (m_userInterface.parallelSubmitPanel(queueStats,
+        m_deferredContexts.isReady() ? &m_deferredContexts : nullptr, m_parallelSubmit, m_submitWorkers)) {
+        acquireContext();
+        runParallelSubmitBenchmark();
+    }
+
+    if (m_userInterface.renderQueuePanel(queueStats, threaded ? m_frameResult.state : m_deviceContext.getStateStats())) {
+        const RenderQueueBenchmark bench = RenderQueue::benchmark(20000, &m_jobs);
+        MESSAGE("BaseApp", "update", "Render queue with " << bench.draws << " draws: sort " << bench.serialSortMs
+            << " ms on 1 thread, " << bench.parallelSortMs << " ms on " << bench.threads << " threads ("
+            << (bench.sortedCorrectly ? "matches" : "DOES NOT match") << " std::stable_sort), submit "
+            << bench.submitMs << " ms; state changes " << bench.naiveBinds << " naive, " << bench.unsortedBinds
+            << " unsorted, " << bench.sortedBinds << " sorted");
+    }
+
+    bool skipUnchanged = m_deviceContext.getSkipUnchangedUploads();
+    const ConstantRingAllocator* ringAllocator = !m_constantRing.isReady() ? nullptr
+        : threaded ? &m_frameResult.ring : &m_constantRing.getAllocator();
+    const bool constantsBenchmark = m_userInterface.constantsPanel(
+        threaded ? m_frameResult.uploads : m_deviceContext.getUploadStats(), ringAllocator, queueStats.ringDraws,
+        m_useConstantRing, skipUnchanged);
+    if (skipUnchanged != m_deviceContext.getSkipUnchangedUploads()) {
+        acquireContext();
+        m_deviceContext.setSkipUnchangedUploads(skipUnchanged);
+    }
+    if (constantsBenchmark) {
+        const ConstantRingBenchmark bench = ConstantBufferRing::benchmark(10000, 60);
+        MESSAGE("BaseApp", "update", bench.actors << " actors (" << bench.moving << " moving), " << bench.draws
+            << " draws per frame: constant bytes per frame " << bench.naiveBytes << " before, " << bench.trackedBytes
+            << " skipping unchanged (" << bench.trackedMs << " ms hashing), " << bench.ringBytes << " with the ring ("
+            << bench.ringMs << " ms, " << bench.ringFallbacks << " fallbacks); allocator "
+            << (bench.allocatorValid ? "valid" : "INVALID"));
+    }
+
+    const GeometryHeapStats geometryStats = m_geometryHeap.getStats();
+    const GeometryPanelAction geometryAction = m_userInterface.geometryHeapPanel(
+        m_geometryHeap.isReady() ? &geometryStats : nullptr, queueStats);
+    if (geometryAction == GEOMETRY_DEFRAGMENT) {
+        acquireContext();
+        const unsigned int copies = m_geometryHeap.defragment();
+        MESSAGE("BaseApp", "update", "Geometry heap defragmented with " << copies << " copies");
+    }
+    else if (geometryAction == GEOMETRY_BENCHMARK) {
+        const GeometryHeapBenchmark bench = GeometryHeap::benchmark(2000, 200000);
+        MESSAGE("BaseApp", "update", "Range allocator: " << bench.operations << " random operations in "
+            << bench.allocatorMs << " ms, fragmentation " << bench.fragmentation * 100.0f << "%, compacted with "
+            << bench.compactMoves << " moves (" << (bench.allocatorValid ? "valid" : "INVALID") << "); "
+            << bench.meshes << " meshes: " << bench.ownBufferBinds << " binds with their own buffers, "
+            << bench.heapBinds << " in the heap (" << bench.pages << " pages)");
+    }
+
+    bool cacheEnabled = m_device.m_cache->isEnabled();
+    const bool spawnBenchmark = m_userInterface.objectCachePanel(m_device.m_cache->getStats(), cacheEnabled);
+    m_device.m_cache->setEnabled(cacheEnabled);
+    if (spawnBenchmark) {
+        acquireContext();
+        runSpawnBenchmark();
+    }
+
+    const ShaderCacheStats shaderStats = m_device.m_shaderCache ? m_device.m_shaderCache->getStats() : ShaderCacheStats();
+    const ShaderCachePanelAction shaderAction = m_userInterface.shaderCachePanel(
+        m_device.m_shaderCache ? &shaderStats : nullptr, m_timeToFirstFrameMs);
+    if (shaderAction == SHADER_CACHE_CLEAR) {
+        m_device.m_shaderCache->clear();
+        MESSAGE("BaseApp", "update", "Shader cache cleared: the next launch compiles every shader");
+    }
+    else if (shaderAction == SHADER_CACHE_BENCHMARK) {
+        acquireContext();
+        runShaderCacheBenchmark();
+    }
+
+    InstancingStats instancingStats = m_instanceBatcher.getStats();
+    if (threaded) {
+        instancingStats.capacity = m_frameResult.instancing.capacity;
+        instancingStats.uploadMs = m_frameResult.instancing.uploadMs;
+    }
+    const InstancingPanelAction instancingAction = m_userInterface.instancingPanel(instancingStats,
+        queueStats.drawCalls, queueStats.submitMs, m_instancing, m_spawnCount);
+    if (instancingAction == INSTANCING_SPAWN) {
+        acquireContext();
+        spawnInstances(static_cast<unsigned int>(m_spawnCount));
+    }
+    else if (instancingAction == INSTANCING_BENCHMARK) {
+        const InstancingBenchmark bench = InstanceBatcher::benchmark(10000, 4);
+        MESSAGE("BaseApp", "update", bench.instances << " actors sharing " << bench.meshes << " meshes: one packet per actor "
+            << bench.actorDrawCalls << " draw calls and " << bench.actorUploads << " constant uploads, queue CPU "
+            << bench.actorSubmitMs << " ms; instanced " << bench.instancedDrawCalls << " draw calls, CPU "
+            << bench.instancedSubmitMs << " ms (build " << bench.buildMs << " ms), packing "
+            << (bench.packedCorrectly ? "correct" : "INCORRECT"));
+    }
+
     // Inspector + Outliner (tal cual lo tenías)
     if (!m_actors.empty())
     {
@@ -301,12 +701,6 @@ void BaseApp::update()
     }
     m_userInterface.outliner(m_actors);
 
-    // --- Tiempo ---
-    static float t = 0.0f;
-    static DWORD t0 = 0;
-    DWORD tNow = GetTickCount();
-    if (t0 == 0) t0 = tNow;
-    t = (tNow - t0) / 1000.0f;
 
     // ----------------------------------------------------
     // CONTROLES DE CÁMARA (RMB orbitar, rueda zoom, MMB pan)
@@ -382,71 +776,718 @@ void BaseApp::update()
             XMVECTOR up = XMVectorSet(0, 1, 0, 0);
 
             m_View = XMMatrixLookAtLH(eye, at, up);
+            XMStoreFloat3(&m_camEye, eye);
+        }
+    }
+
+    // --- Selección en el viewport: clic izquierdo fuera de la UI ---
+    if (!ImGui::GetIO().WantCaptureMouse && ImGui::IsMouseClicked(0) &&
+        m_window.m_width > 0 && m_window.m_height > 0)
+    {
+        POINT p; GetCursorPos(&p);
+        ScreenToClient(m_window.m_hWnd, &p);
+        const float ndcX = 2.0f * p.x / m_window.m_width - 1.0f;
+        const float ndcY = 1.0f - 2.0f * p.y / m_window.m_height;
+
+        // Rayo del plano cercano (z = 0) al lejano (z = 1) del pixel.
+        XMVECTOR determinant;
+        const XMMATRIX inverseViewProjection = XMMatrixInverse(&determinant, m_View * m_Projection);
+        const XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 0.0f, 1.0f), inverseViewProjection);
+        const XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 1.0f, 1.0f), inverseViewProjection);
+        XMFLOAT3 origin, direction;
+        XMStoreFloat3(&origin, nearPoint);
+        XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSubtract(farPoint, nearPoint)));
+
+        float distance = 0.0f;
+        const int picked = pickActor(origin, direction, distance);
+        if (picked >= 0) {
+            m_userInterface.selectedActorIndex = picked;
+            MESSAGE("BaseApp", "update", "Picked " << m_actors[picked]->getName().c_str() << " at " << distance);
         }
     }
     // ----------------------------------------------------
 
-    // --- Subir cbuffers de cámara (igual que lo tenías) ---
-    cbNeverChanges.mView = XMMatrixTranspose(m_View);
-    m_neverChanges.update(m_deviceContext, nullptr, 0, nullptr, &cbNeverChanges, 0, 0);
+    updateScene(m_frameSteps, m_timestep.getAlpha());
+}
 
-    cbChangesOnResize.mProjection = XMMatrixTranspose(m_Projection);
-    m_changeOnResize.update(m_deviceContext, nullptr, 0, nullptr, &cbChangesOnResize, 0, 0);
+void BaseApp::updateScene(unsigned int steps, float alpha)
+{
+    PROFILE_SCOPE("BaseApp::updateScene");
+    // --- Actores: pasos fijos (las constantes de cámara se suben al dibujar: uploadCamera()) ---
+    const float step = static_cast<float>(m_timestep.getStep());
+    for (unsigned int i = 0; i < steps; ++i) {
+        m_sceneTime += step;
+        for (auto& a : m_actors)
+            if (!a.isNull())
+                a->update(step);
+    }
 
-    // --- Actores ---
+    // --- Dibujo entre el paso anterior y el actual; LOD con la cámara del frame ---
+    const float projectionScale = XMVectorGetY(m_Projection.r[1]);
     for (auto& a : m_actors)
-        if (!a.isNull())
-            a->update(t, m_deviceContext);
+        if (!a.isNull()) {
+            a->interpolate(alpha);
+            a->updateLOD(m_camEye, projectionScale);
+        }
+
+    // --- Índice espacial: solo los actores cuyos volúmenes cambiaron, en un lote ---
+    syncSceneTree();
+
+    // --- Visibilidad: AABB en mundo de cada actor contra el frustum de la cámara ---
+    const XMMATRIX viewProjection = m_View * m_Projection;
+    m_actorCuller.resize(m_actors.size());
+    for (size_t i = 0; i < m_actors.size(); ++i)
+        m_actorCuller.setBounds(i, m_actors[i].isNull() ? MeshBounds() : m_actors[i]->getWorldBounds());
+    m_actorCuller.cull(Frustum::fromMatrix(viewProjection), m_visibleActors, &m_jobs, &m_frustumStats);
+
+    // --- Oclusión: los oclusores visibles se rasterizan por software; el resto se prueba contra ellos ---
+    m_occlusionStats = OcclusionStats();
+    if (m_occlusionCulling) {
+        m_occlusion.begin(viewProjection);
+        for (unsigned int index : m_visibleActors)
+            if (!m_actors[index].isNull() && m_actors[index]->isOccluder())
+                m_actors[index]->submitOccluder(m_occlusion);
+        m_occlusion.rasterize(&m_jobs);
+
+        size_t kept = 0;
+        for (unsigned int index : m_visibleActors) {
+            const auto& a = m_actors[index];
+            if (a.isNull() || a->isOccluder() || m_occlusion.isVisible(a->getWorldBounds()))
+                m_visibleActors[kept++] = index;
+        }
+        m_visibleActors.resize(kept);
+        m_occlusionStats = m_occlusion.getStats();
+    }
+
+    // --- Culling de meshlets de los visibles (tras elegir LOD: solo el LOD 0 tiene meshlets) ---
+    m_meshletStats = MeshletCullStats();
+    for (unsigned int index : m_visibleActors) {
+        auto& a = m_actors[index];
+        if (!a.isNull()) {
+            a->setMeshletCulling(m_meshletCulling);
+            a->cullMeshlets(viewProjection, m_camEye);
+            m_meshletStats.add(a->getMeshletStats());
+        }
+    }
+    PROFILE_COUNTER("Visible actors", m_visibleActors.size());
 }
 
 
 void BaseApp::render() {
+    PROFILE_SCOPE("BaseApp::render");
+    // La captura cubre m_captureFrames llamadas completas a renderScene().
+    if (m_deviceContext.getCapture() && m_capture.getStats().frames >= static_cast<unsigned int>(m_captureFrames)) {
+        finishCapture();
+    }
+
+    // Con el hilo de render la simulación solo llena y publica el paquete del frame.
+    if (m_renderThread.isRunning()) {
+        FramePacket& packet = m_renderThread.beginPacket();
+        buildFramePacket(packet);
+        m_renderThread.publish();
+        return;
+    }
+
+    const auto renderStart = std::chrono::steady_clock::now();
+    renderScene();
+
+    // UI + Present
+    m_userInterface.render();
+    // ImGui dibuja con el contexto nativo (y las ventanas de plataforma cambian render targets).
+    m_deviceContext.invalidateState();
+    m_swapChain.present();
+
+    const auto presented = std::chrono::steady_clock::now();
+    m_serialLatency.addFrame(m_inputTime, presented,
+        std::chrono::duration<double, std::milli>(renderStart - m_inputTime).count(),
+        std::chrono::duration<double, std::milli>(presented - renderStart).count());
+
+    if (!m_firstFramePresented) {
+        m_firstFramePresented = true;
+        m_timeToFirstFrameMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - m_startTime).count();
+        const ShaderCacheStats shaderStats = m_device.m_shaderCache->getStats();
+        MESSAGE("BaseApp", "render", "Time to first frame: " << m_timeToFirstFrameMs << " ms (shader cache "
+            << (shaderStats.warm ? "warm" : "cold") << ": " << shaderStats.hits << " shaders loaded in "
+            << shaderStats.loadMs + shaderStats.lookupMs << " ms, " << shaderStats.misses << " compiled in "
+            << shaderStats.compileMs << " ms)");
+        // Lo compilado al arrancar queda para el siguiente arranque.
+        if (!m_device.m_shaderCache->save()) {
+            ERROR("BaseApp", "render", "Cannot write shader cache " << kShaderCachePath);
+        }
+    }
+}
+
+void BaseApp::renderScene()
+{
+    PROFILE_SCOPE("BaseApp::renderScene");
+    // Contadores de llamadas por frame; el estado de D3D no se da por conocido entre frames
+    m_deviceContext.beginFrame();
+    m_constantRing.beginFrame();
+    uploadCamera(m_View, m_Projection);
+
     // Limpiar y bind RTV/DSV
     m_renderTargetView.render(m_deviceContext, m_depthStencilView, 1, kClear);
-    m_viewport.render(m_deviceContext);
     m_depthStencilView.render(m_deviceContext);
 
-    // Pipeline
-    m_shaderProgram.render(m_deviceContext);
+    // Viewport, pipeline y constantes (los contextos diferidos enlazan lo mismo)
+    bindFrameState(m_deviceContext);
+
+    // Dibujo de actores visibles (lista compacta del culling de update()), ordenado por estado
+    // Los actores instanciables van a m_instanceBatcher: un paquete por lote de malla y material
+    InstanceBatcher* instances = m_instancing && m_instanceBatcher.isReady() ? &m_instanceBatcher : nullptr;
+    m_renderQueue.begin();
+    m_instanceBatcher.begin();
+    for (unsigned int index : m_visibleActors)
+        if (index < m_actors.size() && !m_actors[index].isNull())
+            m_actors[index]->submit(m_renderQueue, m_camEye, instances);
+    m_instanceBatcher.build();
+    if (instances) {
+        if (SUCCEEDED(m_instanceBatcher.upload(m_device, m_deviceContext)))
+            m_instanceBatcher.submit(m_renderQueue);
+    }
+    m_renderQueue.sort(&m_jobs);
+    ConstantBufferRing* ring = m_useConstantRing ? &m_constantRing : nullptr;
+    // Lo grabado en contextos diferidos no pasa por la captura: mientras dura, el envío es en serie.
+    if (m_parallelSubmit && m_deferredContexts.isReady() && !m_deviceContext.getCapture()) {
+        m_renderQueue.submitParallel(m_deviceContext, m_deferredContexts, m_jobs,
+            [this](DeviceContext& context) { bindFrameState(context); }, ring, m_submitWorkers);
+    }
+    else {
+        m_renderQueue.submit(&m_deviceContext, ring);
+    }
+}
+
+void BaseApp::uploadCamera(const XMMATRIX& view, const XMMATRIX& projection)
+{
+    cbNeverChanges.mView = XMMatrixTranspose(view);
+    m_neverChanges.update(m_deviceContext, nullptr, 0, nullptr, &cbNeverChanges, 0, 0);
+
+    cbChangesOnResize.mProjection = XMMatrixTranspose(projection);
+    m_changeOnResize.update(m_deviceContext, nullptr, 0, nullptr, &cbChangesOnResize, 0, 0);
+}
 
-    // Constantes
-    m_neverChanges.render(m_deviceContext, 0, 1);
-    m_changeOnResize.render(m_deviceContext, 1, 1);
+void BaseApp::syncRenderThread()
+{
+    // La captura graba lo que llega al contexto en este hilo: mientras dura, el frame vuelve a ser en serie.
+    const bool threaded = m_threadedRender && !m_deviceContext.getCapture();
+    if (threaded == m_renderThread.isRunning()) {
+        return;
+    }
+    if (threaded) {
+        m_renderThread.start([this](FramePacket& packet) { renderFramePacket(packet); });
+    }
+    else {
+        m_renderThread.stop();
+        // El primer frame en serie no se mide contra el último Present del hilo.
+        m_serialLatency.reset();
+    }
+}
 
-    // Dibujo de actores
-    for (auto& a : m_actors) if (!a.isNull()) a->render(m_deviceContext);
+void BaseApp::acquireContext()
+{
+    m_renderThread.drain();
+}
 
-    // UI + Present
-    m_userInterface.render();
+void BaseApp::buildFramePacket(FramePacket& packet)
+{
+    PROFILE_SCOPE("BaseApp::buildFramePacket");
+    packet.frame = m_frameIndex;
+    packet.inputTime = m_inputTime;
+    XMStoreFloat4x4(&packet.view, m_View);
+    XMStoreFloat4x4(&packet.projection, m_Projection);
+    packet.eye = m_camEye;
+    packet.useConstantRing = m_useConstantRing;
+
+    // La misma cola que renderScene(), sin enviar: las constantes y los rangos se copian al paquete
+    // porque los actores los reescriben en el frame siguiente.
+    InstanceBatcher* instances = m_instancing && m_instanceBatcher.isReady() ? &m_instanceBatcher : nullptr;
+    packet.queue.begin();
+    m_instanceBatcher.begin();
+    for (unsigned int index : m_visibleActors)
+        if (index < m_actors.size() && !m_actors[index].isNull())
+            m_actors[index]->submit(packet.queue, m_camEye, instances);
+    m_instanceBatcher.build();
+    packet.queue.retainPayloads();
+    if (instances) {
+        packet.batches = m_instanceBatcher.getBatches();
+        packet.instances = m_instanceBatcher.getInstances();
+    }
+    else {
+        packet.batches.clear();
+        packet.instances.clear();
+    }
+
+    // ImGui es de este hilo: el render solo recibe la copia de sus listas.
+    m_userInterface.snapshot(packet.ui);
+    packet.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_inputTime).count();
+}
+
+void BaseApp::renderFramePacket(FramePacket& packet)
+{
+    PROFILE_SCOPE("BaseApp::renderFramePacket");
+    m_deviceContext.beginFrame();
+    m_constantRing.beginFrame();
+    uploadCamera(XMLoadFloat4x4(&packet.view), XMLoadFloat4x4(&packet.projection));
+
+    m_renderTargetView.render(m_deviceContext, m_depthStencilView, 1, kClear);
+    m_depthStencilView.render(m_deviceContext);
+    bindFrameState(m_deviceContext);
+
+    // El buffer de instancias es uno solo: se sube aquí, cuando el frame anterior ya se envió.
+    packet.result.instancing = InstancingStats();
+    if (!packet.batches.empty() &&
+        SUCCEEDED(m_instanceBatcher.upload(m_device, m_deviceContext, packet.instances, packet.result.instancing))) {
+        m_instanceBatcher.submit(packet.queue, packet.batches);
+    }
+    // El envío es en serie: los contextos diferidos siguen al hilo de la simulación.
+    packet.queue.sort(&m_jobs);
+    packet.queue.submit(&m_deviceContext, packet.useConstantRing ? &m_constantRing : nullptr);
+
+    m_userInterface.renderSnapshot(packet.ui);
+    m_deviceContext.invalidateState();
     m_swapChain.present();
+
+    packet.result.queue = packet.queue.getStats();
+    packet.result.state = m_deviceContext.getStateStats();
+    packet.result.uploads = m_deviceContext.getUploadStats();
+    if (m_constantRing.isReady()) {
+        packet.result.ring = m_constantRing.getAllocator();
+    }
+}
+
+void BaseApp::startStreamingStress()
+{
+    // Mezcla de assets reales del proyecto; se suben a GPU y se liberan en el
+    // acto, así el coste medido es el de IO + decodificación + subida.
+    std::vector<std::pair<std::string, StreamAssetType>> assets = {
+        { "ModelsFBX\\NinjaObscurity\\Lava.png", STREAM_TEXTURE },
+        { "ModelsFBX\\NinjaObscurity\\ninja_skin_02.png", STREAM_TEXTURE },
+    };
+    const std::string kCookedFBX = "Cooked\\ModelsFBX\\NinjaObscurity\\Ninja of Obscurity v02.fbx.vmesh";
+    if (FileExists(kCookedFBX)) {
+        assets.push_back({ kCookedFBX, STREAM_MESH });
+    }
+
+    m_worstFrameMs = 0.0;
+    m_streamer.resetWorstFrame();
+
+    const unsigned int kStressCount = 500;
+    for (unsigned int i = 0; i < kStressCount; ++i) {
+        const auto& asset = assets[i % assets.size()];
+        StreamHandle handle = m_streamer.request(asset.first, asset.second, (StreamPriority)(i % STREAM_PRIORITY_COUNT),
+            [this](StreamedAsset& streamed) {
+                if (!streamed.success) {
+                    return;
+                }
+                if (streamed.type == STREAM_TEXTURE) {
+                    Texture texture;
+                    if (SUCCEEDED(texture.init(m_device, streamed.image))) {
+                        texture.destroy();
+                    }
+                }
+                else {
+                    for (auto& mesh : streamed.meshes) {
+                        Buffer vertexBuffer, indexBuffer;
+                        if (SUCCEEDED(vertexBuffer.init(m_device, mesh, D3D11_BIND_VERTEX_BUFFER))) {
+                            vertexBuffer.destroy();
+                        }
+                        if (SUCCEEDED(indexBuffer.init(m_device, mesh, D3D11_BIND_INDEX_BUFFER))) {
+                            indexBuffer.destroy();
+                        }
+                    }
+                }
+            });
+
+        // Una de cada diez precargas se cancela para ejercitar la cancelación.
+        if (i % 30 == STREAM_PREFETCH) {
+            m_streamer.cancel(handle);
+        }
+    }
+}
+
+void BaseApp::syncSceneTree()
+{
+    m_proxyUpdates.clear();
+    m_actorProxies.resize(m_actors.size(), DynamicAABBTree::kNullNode);
+    m_actorBoundsRevisions.resize(m_actors.size(), 0);
+    for (size_t i = 0; i < m_actors.size(); ++i) {
+        if (m_actors[i].isNull()) {
+            continue;
+        }
+        const unsigned int revision = m_actors[i]->getWorldBoundsRevision();
+        const int proxy = m_actorProxies[i];
+        if (proxy != DynamicAABBTree::kNullNode && revision == m_actorBoundsRevisions[i]) {
+            continue;
+        }
+        const MeshBounds& bounds = m_actors[i]->getWorldBounds();
+        if (bounds.isEmpty()) {
+            // Malla aún en streaming: entra en el árbol cuando tenga volumen.
+            if (proxy != DynamicAABBTree::kNullNode) {
+                m_sceneTree.destroyProxy(proxy);
+                m_actorProxies[i] = DynamicAABBTree::kNullNode;
+            }
+            continue;
+        }
+        m_actorBoundsRevisions[i] = revision;
+        if (proxy == DynamicAABBTree::kNullNode) {
+            m_actorProxies[i] = m_sceneTree.createProxy(AABB::fromBounds(bounds), static_cast<unsigned int>(i));
+        }
+        else {
+            ProxyUpdate update;
+            update.proxy = proxy;
+            update.aabb = AABB::fromBounds(bounds);
+            m_proxyUpdates.push_back(update);
+        }
+    }
+    m_sceneTree.updateProxies(m_proxyUpdates, &m_sceneTreeStats);
+}
+
+int BaseApp::pickActor(const XMFLOAT3& origin, const XMFLOAT3& direction, float& distance)
+{
+    const float kPickDistance = 10000.0f;
+    int picked = -1;
+    float closest = kPickDistance;
+    // El árbol da los actores cuya caja cruza el rayo; cada impacto exacto recorta la distancia.
+    m_sceneTree.raycast(origin, direction, kPickDistance, [&](unsigned int index, float) {
+        float hit = 0.0f;
+        if (index < m_actors.size() && !m_actors[index].isNull() &&
+            m_actors[index]->intersectRay(origin, direction, closest, hit)) {
+            closest = hit;
+            picked = static_cast<int>(index);
+        }
+        return closest;
+    });
+    distance = closest;
+    return picked;
+}
+
+void BaseApp::runRayBenchmark()
+{
+    const MeshComponent* largest = nullptr;
+    for (auto& a : m_actors) {
+        if (a.isNull()) {
+            continue;
+        }
+        for (const MeshComponent& mesh : a->getMeshes()) {
+            if (!mesh.m_bvh.isEmpty() && (!largest || mesh.m_numIndex > largest->m_numIndex)) {
+                largest = &mesh;
+            }
+        }
+    }
+    const unsigned int kRays = 1000000;
+    if (largest) {
+        const BVHRayBenchmark bench = TriangleBVH::benchmark(largest->m_bvh, largest->m_bounds, kRays, &m_jobs);
+        MESSAGE("BaseApp", "runRayBenchmark", largest->m_name.c_str() << " (" << bench.triangles << " triangles, "
+            << bench.nodes << " nodes): " << bench.getMillionRaysPerSecond() << " M rays/s on 1 thread, "
+            << bench.getParallelMillionRaysPerSecond() << " M rays/s with jobs (" << bench.hits << "/" << bench.rays << " hits)");
+    }
+    const BVHRayBenchmark bench = TriangleBVH::benchmarkSynthetic(5000000, kRays, &m_jobs);
+    MESSAGE("BaseApp", "runRayBenchmark", "Generated terrain (" << bench.triangles << " triangles, " << bench.nodes
+        << " nodes, built in " << bench.buildMs << " ms): " << bench.getMillionRaysPerSecond() << " M rays/s on 1 thread, "
+        << bench.getParallelMillionRaysPerSecond() << " M rays/s with jobs (" << bench.hits << "/" << bench.rays << " hits)");
+}
+
+void BaseApp::spawnInstances(unsigned int count)
+{
+    const int selected = m_userInterface.selectedActorIndex;
+    if (selected < 0 || selected >= (int)m_actors.size() || m_actors[selected].isNull() ||
+        m_actors[selected]->getMeshes().empty()) {
+        ERROR("BaseApp", "spawnInstances", "Select an actor with a mesh to copy");
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    EU::TSharedPointer<Actor> source = m_actors[selected];
+    for (const MeshComponent& mesh : source->getMeshes())
+        m_instanceBatcher.createInputLayout(m_device, mesh.m_vertexLayout);
+    source->setInstanced(true);
+
+    // Rejilla en XZ alrededor del original, con separación según su caja en mundo
+    const MeshBounds& bounds = source->getWorldBounds();
+    const float spacing = std::max(1.0f, 2.5f * std::max(bounds.extents.x, bounds.extents.z));
+    const unsigned int side = (unsigned int)std::ceil(std::sqrt(double(count + 1)));
+    const EU::TSharedPointer<Transform> transform = source->getComponent<Transform>();
+    const EU::Vector3 position = transform->getPosition();
+    const std::string name = source->getName();
+    m_actors.reserve(m_actors.size() + count);
+    for (unsigned int i = 1; i <= count; ++i) {
+        auto copy = EU::MakeShared<Actor>(m_device, source.get());
+        const float x = (float(i % side) - 0.5f * side) * spacing;
+        const float z = (float(i / side) - 0.5f * side) * spacing;
+        copy->getComponent<Transform>()->setTransform(
+            EU::Vector3(position.x + x, position.y, position.z + z),
+            transform->getRotation(),
+            transform->getScale());
+        copy->setName(name + " #" + std::to_string(i));
+        copy->setInstanced(true);
+        m_actors.push_back(copy);
+    }
+    const double spawnMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    MESSAGE("BaseApp", "spawnInstances", "Spawned " << count << " copies of " << name.c_str() << " in " << spawnMs << " ms");
+}
+
+void BaseApp::runSpawnBenchmark()
+{
+    ObjectCache& cache = *m_device.m_cache;
+    const bool enabled = cache.isEnabled();
+    auto spawn = [this](unsigned int count) {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<EU::TSharedPointer<Actor>> actors;
+        actors.reserve(count);
+        for (unsigned int i = 0; i < count; ++i)
+            actors.push_back(EU::MakeShared<Actor>(m_device));
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        for (auto& actor : actors)
+            actor->destroy();
+        return ms;
+    };
+
+    // Sin caché cada actor crea sus estados y su shader de sombra: unos pocos bastan para estimar.
+    const unsigned int uncachedCount = 8;
+    cache.setEnabled(false);
+    const double uncachedMs = spawn(uncachedCount) / uncachedCount;
+    cache.setEnabled(true);
+
+    for (unsigned int count : { 1000u, 10000u }) {
+        const ObjectCacheStats before = cache.getStats();
+        const double ms = spawn(count);
+        const ObjectCacheStats after = cache.getStats();
+        const unsigned int hits = after.getHits() - before.getHits();
+        const unsigned int misses = after.getMisses() - before.getMisses();
+        const double estimateMs = uncachedMs * count;
+        MESSAGE("BaseApp", "runSpawnBenchmark", count << " actors: " << ms << " ms with the object cache ("
+            << hits << " hits, " << misses << " misses, " << after.objects << " objects), ~" << estimateMs
+            << " ms without it (" << uncachedMs << " ms per actor over " << uncachedCount << " actors)");
+    }
+    cache.setEnabled(enabled);
+}
+
+void BaseApp::runShaderCacheBenchmark()
+{
+    // Los shaders que compila el arranque: el programa principal y el de sombra de los actores.
+    std::vector<ShaderCompileRequest> requests(3);
+    requests[0].fileName = "TheVisionary.fx";
+    requests[0].entryPoint = "VS";
+    requests[0].profile = "vs_4_0";
+    requests[1].fileName = "TheVisionary.fx";
+    requests[1].entryPoint = "PS";
+    requests[1].profile = "ps_4_0";
+    requests[2].fileName = "HybridEngine.fx";
+    requests[2].entryPoint = "PS";
+    requests[2].profile = "ps_4_0";
+
+    const ShaderCacheBenchmark bench = ShaderCache::benchmark(requests,
+        std::make_shared<D3DShaderCompiler>(), std::string(kShaderCachePath) + ".bench");
+    MESSAGE("BaseApp", "runShaderCacheBenchmark", bench.shaders << " shaders: cold cache " << bench.coldMs
+        << " ms (compile + write), warm cache " << bench.warmMs << " ms (" << bench.warmHits << " hits from a "
+        << bench.fileBytes << " byte file, bytecode " << (bench.identical ? "identical" : "MISMATCH") << ")");
+}
+
+void BaseApp::bindFrameState(DeviceContext& context)
+{
+    m_renderTargetView.render(context, m_depthStencilView, 1);
+    m_viewport.render(context);
+    m_shaderProgram.render(context);
+    m_neverChanges.render(context, 0, 1);
+    m_changeOnResize.render(context, 1, 1);
+}
+
+void BaseApp::runParallelSubmitBenchmark()
+{
+    const unsigned int kDraws = 20000;
+    const ParallelSubmitBenchmark bench = RenderQueue::benchmarkParallel(kDraws, &m_jobs);
+    std::string split;
+    for (size_t i = 0; i < bench.recordMs.size(); ++i) {
+        split += " " + std::to_string(i + 1) + "t " + std::to_string(bench.recordMs[i]) + " ms ("
+            + std::to_string(bench.binds[i]) + " binds)";
+    }
+    MESSAGE("BaseApp", "runParallelSubmitBenchmark", "Synthetic queue with " << bench.draws << " draws on "
+        << bench.threads << " threads: serial " << bench.serialMs << " ms (" << bench.serialBinds << " binds), split"
+        << split.c_str() << "; merge order " << (bench.mergeOrderCorrect ? "matches" : "DOES NOT match") << " serial");
+
+    if (!m_deferredContexts.isReady() || !m_deferredContexts.hasNativeCommandLists()) {
+        MESSAGE("BaseApp", "runParallelSubmitBenchmark", "Device run skipped: no native driver command lists");
+        return;
+    }
+
+    // La escena visible repetida hasta kDraws paquetes, enviada de verdad con 1..8 trabajadores
+    RenderQueue queue;
+    queue.begin();
+    size_t previous = static_cast<size_t>(-1);
+    while (queue.size() < kDraws && queue.size() != previous) {
+        previous = queue.size();
+        for (unsigned int index : m_visibleActors)
+            if (index < m_actors.size() && !m_actors[index].isNull())
+                m_actors[index]->submit(queue, m_camEye, nullptr);
+    }
+    if (queue.size() == 0) {
+        MESSAGE("BaseApp", "runParallelSubmitBenchmark", "Device run skipped: nothing visible");
+        return;
+    }
+    queue.sort(&m_jobs);
+
+    const auto bindState = [this](DeviceContext& context) { bindFrameState(context); };
+    std::string device;
+    for (unsigned int workers = 1; workers <= DeferredContextPool::kMaxContexts; ++workers) {
+        double bestMs = 0.0;
+        double bestRecordMs = 0.0;
+        unsigned int lists = 0;
+        for (int run = 0; run < 3; ++run) {
+            bindFrameState(m_deviceContext);
+            queue.submitParallel(m_deviceContext, m_deferredContexts, m_jobs, bindState, nullptr, workers);
+            const RenderQueueStats& stats = queue.getStats();
+            if (run == 0 || stats.submitMs < bestMs) {
+                bestMs = stats.submitMs;
+                bestRecordMs = stats.recordMs;
+                lists = stats.commandLists;
+            }
+        }
+        device += " " + std::to_string(workers) + "w " + std::to_string(bestMs) + " ms (record "
+            + std::to_string(bestRecordMs) + " ms, " + std::to_string(lists) + " lists)";
+    }
+    MESSAGE("BaseApp", "runParallelSubmitBenchmark", "Scene queue with " << queue.size() << " draws, best of 3:"
+        << device.c_str());
+}
+
+void BaseApp::runHeadlessBenchmark(unsigned int frames)
+{
+    // Los mismos updateScene()/renderScene() de cada frame, con los comandos grabados
+    // en lugar de enviados: sin driver ni Present, solo el coste de CPU.
+    NullBackend backend;
+    if (m_constantRing.isReady()) {
+        backend.setResourceBytes(m_constantRing.raw(), m_constantRing.getAllocator().getCapacity());
+    }
+    // Los contextos diferidos irían a Direct3D 11: el envío se graba en serie.
+    const bool parallelSubmit = m_parallelSubmit;
+    m_parallelSubmit = false;
+    m_deviceContext.setBackend(&backend);
+
+    double updateMs = 0.0;
+    double renderMs = 0.0;
+    for (unsigned int frame = 0; frame < frames; ++frame) {
+        backend.beginFrame();
+        const auto start = std::chrono::steady_clock::now();
+        // Un paso fijo por frame, dibujado sin interpolar.
+        updateScene(1, 1.0f);
+        const auto updated = std::chrono::steady_clock::now();
+        renderScene();
+        const auto rendered = std::chrono::steady_clock::now();
+        updateMs += std::chrono::duration<double, std::milli>(updated - start).count();
+        renderMs += std::chrono::duration<double, std::milli>(rendered - updated).count();
+    }
+
+    m_deviceContext.setBackend(nullptr);
+    m_constantRing.discardNextMap();
+    m_parallelSubmit = parallelSubmit;
+
+    m_headless.frames = frames;
+    m_headless.updateMs = frames > 0 ? updateMs / frames : 0.0;
+    m_headless.renderMs = frames > 0 ? renderMs / frames : 0.0;
+    m_headless.backend = backend.getStats();
+    const NullBackendStats& stats = m_headless.backend;
+    const double perFrame = frames > 0 ? 1.0 / frames : 0.0;
+    MESSAGE("BaseApp", "runHeadlessBenchmark", frames << " headless frames: update " << m_headless.updateMs
+        << " ms, render " << m_headless.renderMs << " ms per frame; per frame " << stats.draws * perFrame
+        << " draws, " << stats.binds * perFrame << " binds, " << stats.commands * perFrame << " commands, "
+        << stats.uploadBytes * perFrame / 1024.0 << " KB uploaded; " << stats.resources << " resources, "
+        << stats.streamBytes << " byte stream");
+}
+
+void BaseApp::finishCapture()
+{
+    m_deviceContext.endCapture();
+    const NullBackendStats stats = m_capture.getStats();
+    if (!m_capture.save(kCapturePath)) {
+        ERROR("BaseApp", "finishCapture", "Cannot write " << kCapturePath);
+        return;
+    }
+    MESSAGE("BaseApp", "finishCapture", stats.frames << " frames captured to " << kCapturePath << ": "
+        << stats.commands << " commands, " << stats.draws << " draws, " << stats.resources << " resources, "
+        << stats.streamBytes / 1024.0 << " KB (" << stats.contentBytes / 1024.0 << " KB of contents)");
+}
+
+void BaseApp::runCaptureReplay(bool onDevice)
+{
+    const unsigned int repeats = static_cast<unsigned int>(m_replayRepeats);
+    if (onDevice) {
+        // Los comandos van directos al backend: el estado y las subidas seguidos dejan de valer.
+        CommandReplayer replayer(m_deviceContext.getBackend(), m_capture.getObjects());
+        m_replay = replayer.replay(m_capture.getStream(), repeats);
+        m_deviceContext.resetTracking();
+    }
+    else {
+        CaptureFileHeader header;
+        std::vector<uint8_t> stream;
+        std::string error;
+        if (!readCaptureFile(kCapturePath, header, stream, error)) {
+            ERROR("BaseApp", "runCaptureReplay", "Cannot read " << kCapturePath << ": " << error.c_str());
+            return;
+        }
+        m_replay = replayHeadless(stream, repeats);
+    }
+
+    const CommandStreamStats& stream = m_replay.stream;
+    const double perFrame = stream.frames > 0 ? 1.0 / stream.frames : 0.0;
+    MESSAGE("BaseApp", "runCaptureReplay", "Replayed " << m_replay.frames << " frames on "
+        << (onDevice ? m_deviceContext.getBackend().getName() : "Null") << ": " << m_replay.getFrameMs()
+        << " ms per frame (min " << m_replay.minFrameMs << ", max " << m_replay.maxFrameMs << "), "
+        << m_replay.callMs << " of " << m_replay.totalMs << " ms in calls; per frame " << stream.draws * perFrame
+        << " draws, " << stream.getBindsPerDraw() << " binds per draw, "
+        << (stream.uploadBytes + stream.mapBytes) * perFrame / 1024.0 << " KB uploaded; "
+        << m_replay.missing << " missing objects" << (m_replay.valid ? "" : " (INVALID stream)"));
 }
 
 void BaseApp::destroy() {
+    // Lo publicado se dibuja y el contexto vuelve a este hilo
+    m_renderThread.stop();
+
+    // Detiene el streaming antes de liberar los actores que usan sus callbacks
+    m_streamer.destroy();
+    m_jobs.destroy();
+
     // Cierra ImGui correctamente (evita Live Objects)
     m_userInterface.destroy();
 
-    if (m_deviceContext.m_deviceContext)
-        m_deviceContext.m_deviceContext->ClearState();
+    if (m_deviceContext.m_deviceContext) {
+        m_deviceContext.ClearState();
+    }
 
     for (auto& a : m_actors) if (!a.isNull()) a->destroy();
     m_actors.clear();
+    m_sceneTree.clear();
+    m_actorProxies.clear();
+    m_actorBoundsRevisions.clear();
 
     m_neverChanges.destroy();
     m_changeOnResize.destroy();
     m_shaderProgram.destroy();
+    m_instanceBatcher.destroy();
+    m_deviceContext.endCapture();
+    m_capture.reset();
+    m_deferredContexts.destroy();
+    m_constantRing.destroy();
+    m_geometryHeap.destroy();
     m_depthStencil.destroy();
     m_depthStencilView.destroy();
     m_renderTargetView.destroy();
     m_swapChain.destroy();
 
-    if (m_deviceContext.m_deviceContext) m_deviceContext.m_deviceContext->Release();
-    if (m_device.m_device)               m_device.m_device->Release();
+    // También suelta los constant buffers que retenía el seguimiento de subidas.
+    m_deviceContext.destroy();
+    // También suelta los estados y shaders de la caché.
+    if (m_device.m_shaderCache && !m_device.m_shaderCache->save()) {
+        ERROR("BaseApp", "destroy", "Cannot write shader cache " << kShaderCachePath);
+    }
+    m_device.destroy();
 }
 
 int BaseApp::run(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow, WNDPROC wndproc) {
     UNREFERENCED_PARAMETER(hPrevInstance);
     UNREFERENCED_PARAMETER(lpCmdLine);
 
+    m_startTime = std::chrono::steady_clock::now();
+    Profiler::setThreadName("Main");
+
     if (FAILED(m_window.init(hInstance, nCmdShow, wndproc)))
         return 0;
 
@@ -461,9 +1502,19 @@ int BaseApp::run(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine,
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
-        else {
+        // Con el hilo de render la simulación va como mucho un paquete por delante (salvo que
+        // el más reciente sustituya al anterior); la espera es corta para seguir atendiendo
+        // la ventana, que Present puede necesitar.
+        // Minimizada no hay nada que presentar: se espera al siguiente mensaje (como mucho 100 ms).
+        else if (m_pacing.pauseMinimized && IsIconic(m_window.m_hWnd)) {
+            m_pacer.idle(100);
+        }
+        else if (!m_renderThread.isRunning() || m_dropStalePackets || m_renderThread.waitForSlot(1)) {
             update();
             render();
+            // Límite de FPS (más bajo sin foco) en lugar de girar sobre PeekMessage.
+            const bool focused = GetForegroundWindow() == m_window.m_hWnd;
+            m_pacer.pace(FramePacer::getTargetSeconds(m_pacing, focused), m_pacing.spinMs);
         }
     }
 
@@ -30,7 +30,7 @@ BlendState::init(Device& device) {
 
 	blendDesc.RenderTarget[0] = rtBlendDesc;
 
-	HRESULT hr = device.m_device->CreateBlendState(&blendDesc, &m_blendState);
+	HRESULT hr = device.CreateBlendState(&blendDesc, &m_blendState);
 	if (FAILED(hr)) {
 		ERROR("BlendState", "init",
 			("Failed to create blend state. HRESULT: " + std::to_string(hr)).c_str());
@@ -59,10 +59,10 @@ BlendState::render(DeviceContext& deviceContext,
 	}
 
 	if (!reset) {
-		deviceContext.m_deviceContext->OMSetBlendState(m_blendState, blendFactor, sampleMask);
+		deviceContext.OMSetBlendState(m_blendState, blendFactor, sampleMask);
 	}
 	else {
-		deviceContext.m_deviceContext->OMSetBlendState(nullptr, blendFactor, sampleMask);
+		deviceContext.OMSetBlendState(nullptr, blendFactor, sampleMask);
 	}
 }
 
@@ -0,0 +1,242 @@
+﻿/**
+ * @file BoundingVolume.cpp
+ * @brief Implementación de la reducción min/max, la esfera de Ritter y la transformación de volúmenes.
+ */
+
+#include "BoundingVolume.h"
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+	// La posición se carga con un solo XMLoadFloat4 sin alinear: la componente w
+	// lee Tex.x (dentro del mismo vértice) y se ignora en todas las operaciones.
+	static_assert(offsetof(SimpleVertex, Pos) + sizeof(XMFLOAT4) <= sizeof(SimpleVertex),
+		"SimpleVertex must have a float after Pos");
+
+	/// Holgura relativa del radio para cubrir el redondeo de float.
+	const float kRadiusSlack = 1.0e-5f;
+
+	inline XMVECTOR
+	loadPosition(const SimpleVertex& vertex) {
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&vertex.Pos));
+	}
+
+	/// Distancia máxima (al cuadrado) de los vértices a un punto.
+	float
+	maxDistanceSq(const std::vector<SimpleVertex>& vertices, FXMVECTOR center) {
+		const size_t count = vertices.size();
+		XMVECTOR best[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			for (size_t k = 0; k < 4; ++k) {
+				const XMVECTOR d = XMVectorSubtract(loadPosition(vertices[i + k]), center);
+				best[k] = XMVectorMax(best[k], XMVector3LengthSq(d));
+			}
+		}
+		for (; i < count; ++i) {
+			const XMVECTOR d = XMVectorSubtract(loadPosition(vertices[i]), center);
+			best[0] = XMVectorMax(best[0], XMVector3LengthSq(d));
+		}
+		return XMVectorGetX(XMVectorMax(XMVectorMax(best[0], best[1]), XMVectorMax(best[2], best[3])));
+	}
+}
+
+MeshBounds
+BoundingVolume::compute(const std::vector<SimpleVertex>& vertices) {
+	MeshBounds bounds;
+	if (vertices.empty()) {
+		return bounds;
+	}
+
+	XMFLOAT3 minimum, maximum;
+	computeAABB(vertices, minimum, maximum);
+	bounds.center = XMFLOAT3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+	bounds.extents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+
+	// Ritter suele ganar en mallas alargadas o irregulares; la esfera de la caja, en mallas muy simétricas.
+	const XMFLOAT4 ritter = computeRitterSphere(vertices, minimum, maximum);
+	const float boxRadius = std::sqrt(maxDistanceSq(vertices, XMLoadFloat3(&bounds.center)));
+	if (boxRadius < ritter.w) {
+		bounds.sphere = XMFLOAT4(bounds.center.x, bounds.center.y, bounds.center.z, boxRadius * (1.0f + kRadiusSlack));
+	}
+	else {
+		bounds.sphere = ritter;
+	}
+	return bounds;
+}
+
+void
+BoundingVolume::computeAABB(const std::vector<SimpleVertex>& vertices, XMFLOAT3& minimum, XMFLOAT3& maximum) {
+	const size_t count = vertices.size();
+	const XMVECTOR first = loadPosition(vertices[0]);
+	// Cuatro acumuladores: rompen la dependencia entre iteraciones de min/max.
+	XMVECTOR lo[4] = { first, first, first, first };
+	XMVECTOR hi[4] = { first, first, first, first };
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		for (size_t k = 0; k < 4; ++k) {
+			const XMVECTOR p = loadPosition(vertices[i + k]);
+			lo[k] = XMVectorMin(lo[k], p);
+			hi[k] = XMVectorMax(hi[k], p);
+		}
+	}
+	for (; i < count; ++i) {
+		const XMVECTOR p = loadPosition(vertices[i]);
+		lo[0] = XMVectorMin(lo[0], p);
+		hi[0] = XMVectorMax(hi[0], p);
+	}
+	XMStoreFloat3(&minimum, XMVectorMin(XMVectorMin(lo[0], lo[1]), XMVectorMin(lo[2], lo[3])));
+	XMStoreFloat3(&maximum, XMVectorMax(XMVectorMax(hi[0], hi[1]), XMVectorMax(hi[2], hi[3])));
+}
+
+XMFLOAT4
+BoundingVolume::computeRitterSphere(const std::vector<SimpleVertex>& vertices,
+	const XMFLOAT3& minimum,
+	const XMFLOAT3& maximum) {
+	// Diámetro inicial: vértices extremos del eje con mayor recorrido de la caja.
+	const float spans[3] = { maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z };
+	const int axis = spans[0] >= spans[1] ? (spans[0] >= spans[2] ? 0 : 2) : (spans[1] >= spans[2] ? 1 : 2);
+	size_t lowIndex = 0, highIndex = 0;
+	for (size_t i = 1; i < vertices.size(); ++i) {
+		const float* p = &vertices[i].Pos.x;
+		if (p[axis] < (&vertices[lowIndex].Pos.x)[axis]) lowIndex = i;
+		if (p[axis] > (&vertices[highIndex].Pos.x)[axis]) highIndex = i;
+	}
+
+	const XMVECTOR low = loadPosition(vertices[lowIndex]);
+	const XMVECTOR high = loadPosition(vertices[highIndex]);
+	XMVECTOR center = XMVectorScale(XMVectorAdd(low, high), 0.5f);
+	float radius = XMVectorGetX(XMVector3Length(XMVectorSubtract(high, center)));
+	float radiusSq = radius * radius;
+
+	// Pase de crecimiento: cada vértice exterior desplaza el centro hacia él lo justo para contenerlo.
+	for (const SimpleVertex& vertex : vertices) {
+		const XMVECTOR d = XMVectorSubtract(loadPosition(vertex), center);
+		const float distanceSq = XMVectorGetX(XMVector3LengthSq(d));
+		if (distanceSq > radiusSq) {
+			const float distance = std::sqrt(distanceSq);
+			const float grown = (radius + distance) * 0.5f;
+			center = XMVectorAdd(center, XMVectorScale(d, (grown - radius) / distance));
+			radius = grown;
+			radiusSq = radius * radius;
+		}
+	}
+
+	XMFLOAT4 sphere;
+	XMStoreFloat4(&sphere, center);
+	sphere.w = radius * (1.0f + kRadiusSlack);
+	return sphere;
+}
+
+MeshBounds
+BoundingVolume::transform(const MeshBounds& local, const XMMATRIX& world) {
+	if (local.isEmpty()) {
+		return local;
+	}
+	MeshBounds result;
+
+	// AABB: centro transformado y semiejes por el valor absoluto de la parte lineal.
+	const XMVECTOR extents = XMLoadFloat3(&local.extents);
+	XMVECTOR worldExtents = XMVectorMultiply(XMVectorSplatX(extents), XMVectorAbs(world.r[0]));
+	worldExtents = XMVectorMultiplyAdd(XMVectorSplatY(extents), XMVectorAbs(world.r[1]), worldExtents);
+	worldExtents = XMVectorMultiplyAdd(XMVectorSplatZ(extents), XMVectorAbs(world.r[2]), worldExtents);
+	XMStoreFloat3(&result.center, XMVector3TransformCoord(XMLoadFloat3(&local.center), world));
+	XMStoreFloat3(&result.extents, worldExtents);
+
+	// Esfera: radio escalado por el eje de mayor escala (cubre escalas no uniformes).
+	const XMVECTOR scaleSq = XMVectorMax(XMVector3LengthSq(world.r[0]),
+		XMVectorMax(XMVector3LengthSq(world.r[1]), XMVector3LengthSq(world.r[2])));
+	const XMVECTOR center = XMVector3TransformCoord(XMVectorSet(local.sphere.x, local.sphere.y, local.sphere.z, 1.0f), world);
+	XMStoreFloat4(&result.sphere, center);
+	result.sphere.w = local.sphere.w * std::sqrt(XMVectorGetX(scaleSq));
+	return result;
+}
+
+MeshBounds
+BoundingVolume::merge(const MeshBounds& a, const MeshBounds& b) {
+	if (a.isEmpty()) {
+		return b;
+	}
+	if (b.isEmpty()) {
+		return a;
+	}
+	MeshBounds result;
+
+	const XMVECTOR centerA = XMLoadFloat3(&a.center), extentsA = XMLoadFloat3(&a.extents);
+	const XMVECTOR centerB = XMLoadFloat3(&b.center), extentsB = XMLoadFloat3(&b.extents);
+	const XMVECTOR minimum = XMVectorMin(XMVectorSubtract(centerA, extentsA), XMVectorSubtract(centerB, extentsB));
+	const XMVECTOR maximum = XMVectorMax(XMVectorAdd(centerA, extentsA), XMVectorAdd(centerB, extentsB));
+	XMStoreFloat3(&result.center, XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f));
+	XMStoreFloat3(&result.extents, XMVectorScale(XMVectorSubtract(maximum, minimum), 0.5f));
+
+	// Esfera mínima que contiene a ambas.
+	const XMVECTOR sphereA = XMVectorSet(a.sphere.x, a.sphere.y, a.sphere.z, 0.0f);
+	const XMVECTOR sphereB = XMVectorSet(b.sphere.x, b.sphere.y, b.sphere.z, 0.0f);
+	const XMVECTOR d = XMVectorSubtract(sphereB, sphereA);
+	const float distance = XMVectorGetX(XMVector3Length(d));
+	if (distance + b.sphere.w <= a.sphere.w) {
+		result.sphere = a.sphere;
+	}
+	else if (distance + a.sphere.w <= b.sphere.w) {
+		result.sphere = b.sphere;
+	}
+	else {
+		const float radius = (distance + a.sphere.w + b.sphere.w) * 0.5f;
+		XMStoreFloat4(&result.sphere, XMVectorAdd(sphereA, XMVectorScale(d, (radius - a.sphere.w) / distance)));
+		result.sphere.w = radius;
+	}
+	return result;
+}
+
+BoundsBenchmark
+BoundingVolume::benchmark(size_t vertexCount) {
+	BoundsBenchmark result;
+	if (vertexCount == 0) {
+		return result;
+	}
+
+	// Nube pseudoaleatoria en un elipsoide alargado (generador lineal: la generación no domina la prueba).
+	std::vector<SimpleVertex> vertices(vertexCount);
+	uint32_t state = 0x12345678u;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return float(state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+	};
+	for (SimpleVertex& vertex : vertices) {
+		vertex.Pos = XMFLOAT3(next() * 40.0f, next() * 10.0f, next() * 5.0f);
+		vertex.Tex = XMFLOAT2(0.0f, 0.0f);
+	}
+	result.vertices = vertexCount;
+
+	using Clock = std::chrono::steady_clock;
+	auto start = Clock::now();
+	XMFLOAT3 minimum, maximum;
+	computeAABB(vertices, minimum, maximum);
+	result.aabbMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	start = Clock::now();
+	const XMFLOAT4 ritter = computeRitterSphere(vertices, minimum, maximum);
+	const XMFLOAT3 boxCenter((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+	result.boxRadius = std::sqrt(maxDistanceSq(vertices, XMLoadFloat3(&boxCenter)));
+	result.sphereMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	result.ritterRadius = ritter.w;
+
+	MeshBounds local;
+	local.center = boxCenter;
+	local.extents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+	local.sphere = ritter;
+	const int kTransforms = 100000;
+	const XMMATRIX matrix = XMMatrixScaling(0.01f, 0.01f, 0.01f) * XMMatrixRotationY(0.5f) * XMMatrixTranslation(2.0f, -4.9f, 0.0f);
+	float sink = 0.0f;
+	start = Clock::now();
+	for (int i = 0; i < kTransforms; ++i) {
+		local.center.x = float(i);
+		sink += transform(local, matrix).center.x;
+	}
+	result.transformUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / kTransforms;
+	if (sink < 0.0f) {
+		result.transformUs = 0.0; // evita que el compilador elimine el bucle
+	}
+	return result;
+}
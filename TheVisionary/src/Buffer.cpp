@@ -30,17 +30,34 @@ Buffer::init(Device& device, const MeshComponent& mesh, unsigned int bindFlag) {
 	desc.CPUAccessFlags = 0;
 	m_bindFlag = bindFlag;
 
+	// Los datos en CPU son siempre float/32 bits; se codifican al formato de la malla.
+	std::vector<unsigned char> encoded;
 	if (bindFlag & D3D11_BIND_VERTEX_BUFFER) {
-		m_stride = sizeof(SimpleVertex);
+		m_stride = mesh.m_vertexLayout.getStride();
 		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.m_vertex.size());
 		desc.BindFlags = (D3D11_BIND_FLAG)bindFlag;
-		data.pSysMem = mesh.m_vertex.data();
+		if (mesh.m_vertexLayout.isCompact()) {
+			VertexCodec::encodeVertices(mesh.m_vertex, mesh.m_vertexLayout, encoded);
+			data.pSysMem = encoded.data();
+		}
+		else {
+			data.pSysMem = mesh.m_vertex.data();
+		}
 	}
 	else if (bindFlag & D3D11_BIND_INDEX_BUFFER) {
-		m_stride = sizeof(unsigned int);
+		m_stride = VertexCodec::getIndexSize(mesh.m_indexFormat);
 		desc.ByteWidth = m_stride * static_cast<unsigned int>(mesh.m_index.size());
 		desc.BindFlags = (D3D11_BIND_FLAG)bindFlag;
-		data.pSysMem = mesh.m_index.data();
+		if (mesh.m_indexFormat == INDEX_UINT16) {
+			if (!VertexCodec::encodeIndices(mesh.m_index, INDEX_UINT16, encoded)) {
+				ERROR("Buffer", "init", "Index out of range for a 16-bit index buffer");
+				return E_INVALIDARG;
+			}
+			data.pSysMem = encoded.data();
+		}
+		else {
+			data.pSysMem = mesh.m_index.data();
+		}
 	}
 
 	return createBuffer(device, desc, &data);
@@ -67,6 +84,27 @@ Buffer::init(Device& device, unsigned int ByteWidth) {
 	return createBuffer(device, desc, nullptr);
 }
 
+HRESULT
+Buffer::init(Device& device, unsigned int stride, unsigned int count) {
+	if (!device.m_device) {
+		ERROR("Buffer", "init", "Device is null.");
+		return E_POINTER;
+	}
+	if (stride == 0 || count == 0) {
+		ERROR("Buffer", "init", "Stride or count is zero");
+		return E_INVALIDARG;
+	}
+	m_stride = stride;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = stride * count;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	m_bindFlag = desc.BindFlags;
+
+	return createBuffer(device, desc, nullptr);
+}
+
 void
 Buffer::update(DeviceContext& deviceContext,
 	ID3D11Resource* pDstResource,
@@ -83,7 +121,12 @@ Buffer::update(DeviceContext& deviceContext,
 		ERROR("ShaderProgram", "update", "pSrcData is null.");
 		return;
 	}
-	deviceContext.m_deviceContext->UpdateSubresource(m_buffer,
+	// Constant buffer entero: el contexto omite la subida si el contenido no cambi.
+	if (m_bindFlag == D3D11_BIND_CONSTANT_BUFFER && !pDstBox) {
+		deviceContext.UpdateConstantBuffer(m_buffer, pSrcData, m_stride);
+		return;
+	}
+	deviceContext.UpdateSubresource(m_buffer,
 		DstSubresource,
 		pDstBox,
 		pSrcData,
@@ -110,16 +153,16 @@ Buffer::render(DeviceContext& deviceContext,
 
 	switch (m_bindFlag) {
 	case D3D11_BIND_VERTEX_BUFFER:
-		deviceContext.m_deviceContext->IASetVertexBuffers(StartSlot, NumBuffers, &m_buffer, &m_stride, &m_offset);
+		deviceContext.IASetVertexBuffers(StartSlot, NumBuffers, &m_buffer, &m_stride, &m_offset);
 		break;
 	case D3D11_BIND_CONSTANT_BUFFER:
-		deviceContext.m_deviceContext->VSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
+		deviceContext.VSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
 		if (setPixelShader) {
-			deviceContext.m_deviceContext->PSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
+			deviceContext.PSSetConstantBuffers(StartSlot, NumBuffers, &m_buffer);
 		}
 		break;
 	case D3D11_BIND_INDEX_BUFFER:
-		deviceContext.m_deviceContext->IASetIndexBuffer(m_buffer, format, m_offset);
+		deviceContext.IASetIndexBuffer(m_buffer, format, m_offset);
 		break;
 	default:
 		ERROR("Buffer", "render", "Unsupported BindFlag");
@@ -0,0 +1,384 @@
+﻿/**
+ * @file CaptureBackend.cpp
+ * @brief Captura de comandos y datos, con envío al backend destino.
+ */
+
+#include "CaptureBackend.h"
+
+namespace {
+	const unsigned int kCompareBlock = 16;  ///< Bytes comparados de una vez.
+	const unsigned int kMergeGap = 64;      ///< Huecos sin cambios menores que esto no parten un rango.
+}
+
+CaptureBackend::~CaptureBackend() {
+	reset();
+}
+
+void
+CaptureBackend::reset() {
+	for (void* object : m_objects) {
+		if (object) {
+			static_cast<IUnknown*>(object)->Release();
+		}
+	}
+	m_objects.clear();
+	m_open.clear();
+	NullBackend::reset();
+}
+
+bool
+CaptureBackend::save(const std::string& path) const {
+	const NullBackendStats stats = getStats();
+	CaptureFileHeader header;
+	header.frames = stats.frames;
+	header.resources = stats.resources;
+	return writeCaptureFile(path, header, getStream());
+}
+
+void
+CaptureBackend::describeResource(const void* object, NullResource& entry) {
+	// Los objetos de D3D11 derivan de IUnknown con herencia simple: el asa es el objeto.
+	IUnknown* unknown = static_cast<IUnknown*>(const_cast<void*>(object));
+	unknown->AddRef();
+	if (m_objects.size() < entry.id) {
+		m_objects.resize(entry.id, nullptr);
+	}
+	m_objects[entry.id - 1] = unknown;
+
+	if (entry.kind != RESOURCE_GENERIC && entry.kind != RESOURCE_BUFFER) {
+		return;
+	}
+	ID3D11Resource* resource = static_cast<ID3D11Resource*>(unknown);
+	D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	resource->GetType(&dimension);
+	if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER) {
+		D3D11_BUFFER_DESC desc = {};
+		static_cast<ID3D11Buffer*>(resource)->GetDesc(&desc);
+		entry.kind = RESOURCE_BUFFER;
+		entry.bytes = desc.ByteWidth;
+		entry.flags = desc.BindFlags;
+	}
+}
+
+void
+CaptureBackend::findChangedRanges(NullResource& entry) {
+	m_ranges.clear();
+	const uint8_t* written = entry.mapped.data();
+	uint8_t* previous = entry.contents.data();
+	const unsigned int size = entry.bytes;
+	unsigned int offset = 0;
+	while (offset < size) {
+		unsigned int block = std::min(kCompareBlock, size - offset);
+		if (std::memcmp(written + offset, previous + offset, block) == 0) {
+			offset += block;
+			continue;
+		}
+		// Se alarga el rango mientras los bloques distintos estén a menos de kMergeGap.
+		MappedRange range;
+		range.offset = offset;
+		unsigned int end = offset + block;
+		offset = end;
+		while (offset < size && offset - end < kMergeGap) {
+			block = std::min(kCompareBlock, size - offset);
+			if (std::memcmp(written + offset, previous + offset, block) != 0) {
+				end = offset + block;
+			}
+			offset += block;
+		}
+		range.size = end - range.offset;
+		std::memcpy(previous + range.offset, written + range.offset, range.size);
+		m_ranges.push_back(range);
+	}
+}
+
+void
+CaptureBackend::ClearState() {
+	NullBackend::ClearState();
+	m_target->ClearState();
+}
+
+void
+CaptureBackend::RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) {
+	NullBackend::RSSetViewports(NumViewports, pViewports);
+	m_target->RSSetViewports(NumViewports, pViewports);
+}
+
+void
+CaptureBackend::PSSetShaderResources(unsigned int StartSlot,
+	unsigned int NumViews,
+	ID3D11ShaderResourceView* const* ppShaderResourceViews) {
+	NullBackend::PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
+	m_target->PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
+}
+
+void
+CaptureBackend::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
+	NullBackend::IASetInputLayout(pInputLayout);
+	m_target->IASetInputLayout(pInputLayout);
+}
+
+void
+CaptureBackend::VSSetShader(ID3D11VertexShader* pVertexShader,
+	ID3D11ClassInstance* const* ppClassInstances,
+	unsigned int NumClassInstances) {
+	NullBackend::VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
+	m_target->VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
+}
+
+void
+CaptureBackend::PSSetShader(ID3D11PixelShader* pPixelShader,
+	ID3D11ClassInstance* const* ppClassInstances,
+	unsigned int NumClassInstances) {
+	NullBackend::PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
+	m_target->PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
+}
+
+void
+CaptureBackend::UpdateSubresource(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	const BackendBox* pDstBox,
+	const void* pSrcData,
+	unsigned int SrcRowPitch,
+	unsigned int SrcDepthPitch,
+	unsigned int SrcBytes) {
+	NullBackend::UpdateSubresource(pDstResource, DstSubresource, pDstBox, pSrcData, SrcRowPitch,
+		SrcDepthPitch, SrcBytes);
+	m_target->UpdateSubresource(pDstResource, DstSubresource, pDstBox, pSrcData, SrcRowPitch,
+		SrcDepthPitch, SrcBytes);
+}
+
+HRESULT
+CaptureBackend::Map(ID3D11Resource* pResource,
+	unsigned int Subresource,
+	unsigned int MapType,
+	unsigned int MapFlags,
+	BackendMappedSubresource* pMappedResource) {
+	NullResource& entry = resource(pResource, RESOURCE_GENERIC);
+	OpenMap open;
+	open.shadowed = entry.bytes > 0 && Subresource == 0;
+	// Sin copia anterior, la memoria real no coincide con ella: se empieza de cero.
+	if (open.shadowed && entry.contents.empty() && MapType == BACKEND_MAP_WRITE_NO_OVERWRITE) {
+		MapType = BACKEND_MAP_WRITE_DISCARD;
+	}
+	BackendMappedSubresource mapped;
+	HRESULT hr = m_target->Map(pResource, Subresource, MapType, MapFlags, &mapped);
+	if (FAILED(hr)) {
+		return hr;
+	}
+	open.data = mapped.pData;
+	open.discard = MapType == BACKEND_MAP_WRITE_DISCARD;
+	if (open.shadowed) {
+		NullBackend::Map(pResource, Subresource, MapType, MapFlags, pMappedResource);
+		entry.contents.resize(entry.bytes);
+	}
+	else {
+		// Texturas y recursos sin tamaño: se graba el Map, pero no lo escrito.
+		command(CMD_MAP);
+		m_writer.u32(entry.id);
+		m_writer.u32(Subresource);
+		m_writer.u32(MapType);
+		++entry.updates;
+		++m_stats.maps;
+		*pMappedResource = mapped;
+	}
+	m_open[pResource] = open;
+	return S_OK;
+}
+
+void
+CaptureBackend::Unmap(ID3D11Resource* pResource, unsigned int Subresource) {
+	NullResource& entry = resource(pResource, RESOURCE_GENERIC);
+	OpenMap open;
+	auto it = m_open.find(pResource);
+	if (it != m_open.end()) {
+		open = it->second;
+		m_open.erase(it);
+	}
+	m_ranges.clear();
+	if (open.shadowed) {
+		findChangedRanges(entry);
+		uint8_t* target = static_cast<uint8_t*>(open.data);
+		if (open.discard) {
+			std::memcpy(target, entry.mapped.data(), entry.bytes);
+		}
+		else {
+			for (const MappedRange& range : m_ranges) {
+				std::memcpy(target + range.offset, entry.mapped.data() + range.offset, range.size);
+			}
+		}
+	}
+	command(CMD_UNMAP);
+	m_writer.u32(entry.id);
+	m_writer.u32(Subresource);
+	m_writer.u32(static_cast<uint32_t>(m_ranges.size()));
+	for (const MappedRange& range : m_ranges) {
+		m_writer.u32(range.offset);
+		m_writer.u32(range.size);
+		m_writer.bytes(entry.mapped.data() + range.offset, range.size);
+		m_stats.contentBytes += range.size;
+	}
+	m_target->Unmap(pResource, Subresource);
+}
+
+void
+CaptureBackend::CopySubresourceRegion(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	unsigned int DstX,
+	unsigned int DstY,
+	unsigned int DstZ,
+	ID3D11Resource* pSrcResource,
+	unsigned int SrcSubresource,
+	const BackendBox* pSrcBox) {
+	NullBackend::CopySubresourceRegion(pDstResource, DstSubresource, DstX, DstY, DstZ, pSrcResource,
+		SrcSubresource, pSrcBox);
+	m_target->CopySubresourceRegion(pDstResource, DstSubresource, DstX, DstY, DstZ, pSrcResource,
+		SrcSubresource, pSrcBox);
+}
+
+void
+CaptureBackend::IASetVertexBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppVertexBuffers,
+	const unsigned int* pStrides,
+	const unsigned int* pOffsets) {
+	NullBackend::IASetVertexBuffers(StartSlot, NumBuffers, ppVertexBuffers, pStrides, pOffsets);
+	m_target->IASetVertexBuffers(StartSlot, NumBuffers, ppVertexBuffers, pStrides, pOffsets);
+}
+
+void
+CaptureBackend::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+	unsigned int Format,
+	unsigned int Offset) {
+	NullBackend::IASetIndexBuffer(pIndexBuffer, Format, Offset);
+	m_target->IASetIndexBuffer(pIndexBuffer, Format, Offset);
+}
+
+void
+CaptureBackend::PSSetSamplers(unsigned int StartSlot,
+	unsigned int NumSamplers,
+	ID3D11SamplerState* const* ppSamplers) {
+	NullBackend::PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
+	m_target->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
+}
+
+void
+CaptureBackend::RSSetState(ID3D11RasterizerState* pRasterizerState) {
+	NullBackend::RSSetState(pRasterizerState);
+	m_target->RSSetState(pRasterizerState);
+}
+
+void
+CaptureBackend::OMSetBlendState(ID3D11BlendState* pBlendState,
+	const float BlendFactor[4],
+	unsigned int SampleMask) {
+	NullBackend::OMSetBlendState(pBlendState, BlendFactor, SampleMask);
+	m_target->OMSetBlendState(pBlendState, BlendFactor, SampleMask);
+}
+
+void
+CaptureBackend::OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+	unsigned int StencilRef) {
+	NullBackend::OMSetDepthStencilState(pDepthStencilState, StencilRef);
+	m_target->OMSetDepthStencilState(pDepthStencilState, StencilRef);
+}
+
+void
+CaptureBackend::OMSetRenderTargets(unsigned int NumViews,
+	ID3D11RenderTargetView* const* ppRenderTargetViews,
+	ID3D11DepthStencilView* pDepthStencilView) {
+	NullBackend::OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+	m_target->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+}
+
+void
+CaptureBackend::IASetPrimitiveTopology(unsigned int Topology) {
+	NullBackend::IASetPrimitiveTopology(Topology);
+	m_target->IASetPrimitiveTopology(Topology);
+}
+
+void
+CaptureBackend::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+	const float ColorRGBA[4]) {
+	NullBackend::ClearRenderTargetView(pRenderTargetView, ColorRGBA);
+	m_target->ClearRenderTargetView(pRenderTargetView, ColorRGBA);
+}
+
+void
+CaptureBackend::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+	unsigned int ClearFlags,
+	float Depth,
+	uint8_t Stencil) {
+	NullBackend::ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+	m_target->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+}
+
+void
+CaptureBackend::VSSetConstantBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers) {
+	NullBackend::VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+	m_target->VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+}
+
+void
+CaptureBackend::PSSetConstantBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers) {
+	NullBackend::PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+	m_target->PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+}
+
+void
+CaptureBackend::VSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+	NullBackend::VSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant,
+		pNumConstants);
+	m_target->VSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+}
+
+void
+CaptureBackend::PSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+	NullBackend::PSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant,
+		pNumConstants);
+	m_target->PSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+}
+
+HRESULT
+CaptureBackend::FinishCommandList(bool RestoreDeferredContextState,
+	ID3D11CommandList** ppCommandList) {
+	NullBackend::FinishCommandList(RestoreDeferredContextState, ppCommandList);
+	return m_target->FinishCommandList(RestoreDeferredContextState, ppCommandList);
+}
+
+void
+CaptureBackend::ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) {
+	NullBackend::ExecuteCommandList(pCommandList, RestoreContextState);
+	m_target->ExecuteCommandList(pCommandList, RestoreContextState);
+}
+
+void
+CaptureBackend::DrawIndexed(unsigned int IndexCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation) {
+	NullBackend::DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+	m_target->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+}
+
+void
+CaptureBackend::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+	unsigned int InstanceCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation,
+	unsigned int StartInstanceLocation) {
+	NullBackend::DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation,
+		BaseVertexLocation, StartInstanceLocation);
+	m_target->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation,
+		BaseVertexLocation, StartInstanceLocation);
+}
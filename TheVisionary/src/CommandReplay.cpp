@@ -0,0 +1,316 @@
+﻿/**
+ * @file CommandReplay.cpp
+ * @brief Decodificación y nueva emisión de un stream de comandos con tiempos por llamada.
+ */
+
+#include "CommandReplay.h"
+#include "NullBackend.h"
+#include <chrono>
+
+namespace {
+	/// Caja de los argumentos (hasBox y seis coordenadas); nullptr si no hay.
+	const BackendBox*
+	readBox(const CommandRecord& record, size_t index, BackendBox& box) {
+		if (!record.args[index]) {
+			return nullptr;
+		}
+		box.left = record.args[index + 1];
+		box.top = record.args[index + 2];
+		box.front = record.args[index + 3];
+		box.right = record.args[index + 4];
+		box.bottom = record.args[index + 5];
+		box.back = record.args[index + 6];
+		return &box;
+	}
+
+	double
+	elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+ReplayStats
+CommandReplayer::replay(const std::vector<uint8_t>& stream, unsigned int repeats) {
+	ReplayStats stats;
+	stats.stream = analyzeCommandStream(stream);
+	stats.repeats = repeats;
+	stats.valid = stats.stream.valid;
+	m_missing = 0;
+
+	CommandRecord record;
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int pass = 0; pass < repeats && stats.valid; ++pass) {
+		// Como en la captura, las copias empiezan a cero y el primer Map es DISCARD.
+		for (std::vector<uint8_t>& shadow : m_shadows) {
+			std::fill(shadow.begin(), shadow.end(), uint8_t(0));
+		}
+		std::fill(m_mapped.begin(), m_mapped.end(), nullptr);
+
+		CommandReader reader(stream.data(), stream.size());
+		bool inFrame = false;
+		auto frameStart = std::chrono::steady_clock::now();
+		while (decodeCommand(reader, record)) {
+			if (record.op == CMD_FRAME) {
+				const auto now = std::chrono::steady_clock::now();
+				if (inFrame) {
+					const double frameMs = elapsedMs(frameStart, now);
+					stats.minFrameMs = stats.frames ? std::min(stats.minFrameMs, frameMs) : frameMs;
+					stats.maxFrameMs = std::max(stats.maxFrameMs, frameMs);
+					++stats.frames;
+				}
+				inFrame = true;
+				frameStart = now;
+				continue;
+			}
+			const auto callStart = std::chrono::steady_clock::now();
+			const bool issued = execute(record);
+			const double callMs = elapsedMs(callStart, std::chrono::steady_clock::now());
+			if (!issued) {
+				continue;
+			}
+			ReplayCallStats& call = stats.calls[record.op];
+			++call.count;
+			call.totalMs += callMs;
+			call.maxMs = std::max(call.maxMs, callMs);
+			stats.callMs += callMs;
+		}
+		if (inFrame) {
+			const double frameMs = elapsedMs(frameStart, std::chrono::steady_clock::now());
+			stats.minFrameMs = stats.frames ? std::min(stats.minFrameMs, frameMs) : frameMs;
+			stats.maxFrameMs = std::max(stats.maxFrameMs, frameMs);
+			++stats.frames;
+		}
+	}
+	stats.totalMs = elapsedMs(start, std::chrono::steady_clock::now());
+	stats.missing = m_missing;
+	return stats;
+}
+
+const unsigned int*
+CommandReplayer::values(std::vector<unsigned int>& out, const CommandRecord& record,
+	size_t first, unsigned int count, unsigned int stride) {
+	out.resize(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		out[i] = record.args[first + i * stride];
+	}
+	return out.data();
+}
+
+bool
+CommandReplayer::execute(const CommandRecord& record) {
+	const std::vector<uint32_t>& args = record.args;
+	switch (record.op) {
+	case CMD_RESOURCE: {
+		const uint32_t id = args[0];
+		if (id == 0) {
+			return false;
+		}
+		if (m_shadows.size() < id) {
+			m_shadows.resize(id);
+			m_mapped.resize(id, nullptr);
+			m_discard.resize(id, 0);
+		}
+		if (args[2] && m_shadows[id - 1].size() != args[2]) {
+			m_shadows[id - 1].assign(args[2], 0);
+		}
+		return false;
+	}
+	case CMD_CLEAR_STATE:
+		m_target.ClearState();
+		return true;
+	case CMD_RS_SET_VIEWPORTS:
+		m_viewports.resize(args[0]);
+		for (uint32_t i = 0; i < args[0]; ++i) {
+			BackendViewport& viewport = m_viewports[i];
+			viewport.TopLeftX = record.getFloat(1 + i * 6);
+			viewport.TopLeftY = record.getFloat(2 + i * 6);
+			viewport.Width = record.getFloat(3 + i * 6);
+			viewport.Height = record.getFloat(4 + i * 6);
+			viewport.MinDepth = record.getFloat(5 + i * 6);
+			viewport.MaxDepth = record.getFloat(6 + i * 6);
+		}
+		m_target.RSSetViewports(args[0], m_viewports.data());
+		return true;
+	case CMD_PS_SET_SHADER_RESOURCES:
+		m_target.PSSetShaderResources(args[0], args[1], slots<ID3D11ShaderResourceView>(record, 2, args[1], 1));
+		return true;
+	case CMD_IA_SET_INPUT_LAYOUT:
+		m_target.IASetInputLayout(object<ID3D11InputLayout>(args[0]));
+		return true;
+	case CMD_VS_SET_SHADER:
+		m_target.VSSetShader(object<ID3D11VertexShader>(args[0]), nullptr, 0);
+		return true;
+	case CMD_PS_SET_SHADER:
+		m_target.PSSetShader(object<ID3D11PixelShader>(args[0]), nullptr, 0);
+		return true;
+	case CMD_UPDATE_SUBRESOURCE: {
+		// id, subresource, bytes, pitches, caja (1 o 7 argumentos) y datos.
+		ID3D11Resource* resource = object<ID3D11Resource>(args[0]);
+		const uint32_t dataBytes = args.back();
+		if (!resource || dataBytes == 0) {
+			return false;
+		}
+		BackendBox box;
+		m_target.UpdateSubresource(resource, args[1], readBox(record, 5, box), record.blobs[0],
+			args[3], args[4], dataBytes);
+		return true;
+	}
+	case CMD_MAP: {
+		ID3D11Resource* resource = object<ID3D11Resource>(args[0]);
+		if (!resource || args[0] > m_mapped.size()) {
+			return false;
+		}
+		BackendMappedSubresource mapped;
+		if (isBackendFailure(m_target.Map(resource, args[1], args[2], 0, &mapped))) {
+			++m_missing;
+			return false;
+		}
+		m_mapped[args[0] - 1] = mapped.pData;
+		m_discard[args[0] - 1] = args[2] == BACKEND_MAP_WRITE_DISCARD ? 1 : 0;
+		return true;
+	}
+	case CMD_UNMAP: {
+		ID3D11Resource* resource = object<ID3D11Resource>(args[0]);
+		if (!resource || args[0] > m_mapped.size() || !m_mapped[args[0] - 1]) {
+			return false;
+		}
+		// Lo escrito pasa a la copia y de ella a la memoria mapeada.
+		std::vector<uint8_t>& shadow = m_shadows[args[0] - 1];
+		uint8_t* target = static_cast<uint8_t*>(m_mapped[args[0] - 1]);
+		const bool discard = m_discard[args[0] - 1] != 0;
+		for (uint32_t i = 0; i < args[2]; ++i) {
+			const uint32_t offset = args[3 + i * 2];
+			const uint32_t size = args[4 + i * 2];
+			if (uint64_t(offset) + size > shadow.size()) {
+				continue;
+			}
+			std::memcpy(shadow.data() + offset, record.blobs[i], size);
+			if (!discard) {
+				std::memcpy(target + offset, record.blobs[i], size);
+			}
+		}
+		if (discard && !shadow.empty()) {
+			std::memcpy(target, shadow.data(), shadow.size());
+		}
+		m_mapped[args[0] - 1] = nullptr;
+		m_target.Unmap(resource, args[1]);
+		return true;
+	}
+	case CMD_COPY_SUBRESOURCE_REGION: {
+		ID3D11Resource* destination = object<ID3D11Resource>(args[0]);
+		ID3D11Resource* source = object<ID3D11Resource>(args[5]);
+		if (!destination || !source) {
+			return false;
+		}
+		BackendBox box;
+		m_target.CopySubresourceRegion(destination, args[1], args[2], args[3], args[4],
+			source, args[6], readBox(record, 7, box));
+		return true;
+	}
+	case CMD_IA_SET_VERTEX_BUFFERS:
+		m_target.IASetVertexBuffers(args[0], args[1], slots<ID3D11Buffer>(record, 2, args[1], 3),
+			values(m_first, record, 3, args[1], 3), values(m_second, record, 4, args[1], 3));
+		return true;
+	case CMD_IA_SET_INDEX_BUFFER:
+		m_target.IASetIndexBuffer(object<ID3D11Buffer>(args[0]), args[1], args[2]);
+		return true;
+	case CMD_PS_SET_SAMPLERS:
+		m_target.PSSetSamplers(args[0], args[1], slots<ID3D11SamplerState>(record, 2, args[1], 1));
+		return true;
+	case CMD_RS_SET_STATE:
+		m_target.RSSetState(object<ID3D11RasterizerState>(args[0]));
+		return true;
+	case CMD_OM_SET_BLEND_STATE: {
+		const float factor[4] = { record.getFloat(1), record.getFloat(2), record.getFloat(3), record.getFloat(4) };
+		m_target.OMSetBlendState(object<ID3D11BlendState>(args[0]), factor, args[5]);
+		return true;
+	}
+	case CMD_OM_SET_DEPTH_STENCIL_STATE:
+		m_target.OMSetDepthStencilState(object<ID3D11DepthStencilState>(args[0]), args[1]);
+		return true;
+	case CMD_OM_SET_RENDER_TARGETS:
+		m_target.OMSetRenderTargets(args[0], slots<ID3D11RenderTargetView>(record, 1, args[0], 1),
+			object<ID3D11DepthStencilView>(args[1 + args[0]]));
+		return true;
+	case CMD_IA_SET_PRIMITIVE_TOPOLOGY:
+		m_target.IASetPrimitiveTopology(args[0]);
+		return true;
+	case CMD_CLEAR_RENDER_TARGET_VIEW: {
+		ID3D11RenderTargetView* view = object<ID3D11RenderTargetView>(args[0]);
+		if (!view) {
+			return false;
+		}
+		const float color[4] = { record.getFloat(1), record.getFloat(2), record.getFloat(3), record.getFloat(4) };
+		m_target.ClearRenderTargetView(view, color);
+		return true;
+	}
+	case CMD_CLEAR_DEPTH_STENCIL_VIEW: {
+		ID3D11DepthStencilView* view = object<ID3D11DepthStencilView>(args[0]);
+		if (!view) {
+			return false;
+		}
+		m_target.ClearDepthStencilView(view, args[1], record.getFloat(2), static_cast<uint8_t>(args[3]));
+		return true;
+	}
+	case CMD_VS_SET_CONSTANT_BUFFERS:
+		m_target.VSSetConstantBuffers(args[0], args[1], slots<ID3D11Buffer>(record, 2, args[1], 1));
+		return true;
+	case CMD_PS_SET_CONSTANT_BUFFERS:
+		m_target.PSSetConstantBuffers(args[0], args[1], slots<ID3D11Buffer>(record, 2, args[1], 1));
+		return true;
+	case CMD_VS_SET_CONSTANT_BUFFERS1:
+	case CMD_PS_SET_CONSTANT_BUFFERS1: {
+		// Sin offsets en el destino se enlaza el buffer entero (como hace DeviceContext).
+		ID3D11Buffer* const* buffers = slots<ID3D11Buffer>(record, 2, args[1], 3);
+		const bool vertex = record.op == CMD_VS_SET_CONSTANT_BUFFERS1;
+		if (!m_target.supportsConstantOffsets()) {
+			if (vertex) {
+				m_target.VSSetConstantBuffers(args[0], args[1], buffers);
+			}
+			else {
+				m_target.PSSetConstantBuffers(args[0], args[1], buffers);
+			}
+			return true;
+		}
+		const unsigned int* first = values(m_first, record, 3, args[1], 3);
+		const unsigned int* count = values(m_second, record, 4, args[1], 3);
+		if (vertex) {
+			m_target.VSSetConstantBuffers1(args[0], args[1], buffers, first, count);
+		}
+		else {
+			m_target.PSSetConstantBuffers1(args[0], args[1], buffers, first, count);
+		}
+		return true;
+	}
+	case CMD_EXECUTE_COMMAND_LIST: {
+		ID3D11CommandList* list = object<ID3D11CommandList>(args[0]);
+		if (!list) {
+			return false;
+		}
+		m_target.ExecuteCommandList(list, args[1] != 0);
+		return true;
+	}
+	case CMD_DRAW_INDEXED:
+		m_target.DrawIndexed(args[0], args[1], static_cast<int>(args[2]));
+		return true;
+	case CMD_DRAW_INDEXED_INSTANCED:
+		m_target.DrawIndexedInstanced(args[0], args[1], args[2], static_cast<int>(args[3]), args[4]);
+		return true;
+	default:
+		// CMD_FINISH_COMMAND_LIST: la lista grabada ya existe (ExecuteCommandList la usa).
+		return false;
+	}
+}
+
+ReplayStats
+replayHeadless(const std::vector<uint8_t>& stream, unsigned int repeats) {
+	// El backend crea un asa por id con lo que declara el stream.
+	const std::vector<StreamResource> resources = listStreamResources(stream);
+	std::vector<void*> objects(resources.size());
+	NullBackend backend;
+	for (size_t i = 0; i < resources.size(); ++i) {
+		objects[i] = backend.createResource<void>(resources[i].kind, resources[i].bytes, resources[i].flags);
+	}
+	CommandReplayer replayer(backend, objects);
+	return replayer.replay(stream, repeats);
+}
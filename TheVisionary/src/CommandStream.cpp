@@ -0,0 +1,416 @@
+﻿/**
+ * @file CommandStream.cpp
+ * @brief Nombres, decodificación y archivo de captura del stream binario.
+ */
+
+#include "CommandStream.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+const char*
+getCommandName(CommandOp op) {
+	static const char* const kNames[COMMAND_OP_COUNT] = {
+		"Frame",
+		"Resource",
+		"ClearState",
+		"RSSetViewports",
+		"PSSetShaderResources",
+		"IASetInputLayout",
+		"VSSetShader",
+		"PSSetShader",
+		"UpdateSubresource",
+		"Map",
+		"Unmap",
+		"CopySubresourceRegion",
+		"IASetVertexBuffers",
+		"IASetIndexBuffer",
+		"PSSetSamplers",
+		"RSSetState",
+		"OMSetBlendState",
+		"OMSetDepthStencilState",
+		"OMSetRenderTargets",
+		"IASetPrimitiveTopology",
+		"ClearRenderTargetView",
+		"ClearDepthStencilView",
+		"VSSetConstantBuffers",
+		"PSSetConstantBuffers",
+		"VSSetConstantBuffers1",
+		"PSSetConstantBuffers1",
+		"FinishCommandList",
+		"ExecuteCommandList",
+		"DrawIndexed",
+		"DrawIndexedInstanced",
+	};
+	return op < COMMAND_OP_COUNT ? kNames[op] : "Unknown";
+}
+
+const char*
+getResourceKindName(ResourceKind kind) {
+	static const char* const kNames[RESOURCE_KIND_COUNT] = {
+		"Resource",
+		"Buffer",
+		"ShaderResourceView",
+		"RenderTargetView",
+		"DepthStencilView",
+		"InputLayout",
+		"VertexShader",
+		"PixelShader",
+		"SamplerState",
+		"RasterizerState",
+		"BlendState",
+		"DepthStencilState",
+		"CommandList",
+	};
+	return kind < RESOURCE_KIND_COUNT ? kNames[kind] : "Unknown";
+}
+
+bool
+isBindCommand(CommandOp op) {
+	switch (op) {
+	case CMD_RS_SET_VIEWPORTS:
+	case CMD_PS_SET_SHADER_RESOURCES:
+	case CMD_IA_SET_INPUT_LAYOUT:
+	case CMD_VS_SET_SHADER:
+	case CMD_PS_SET_SHADER:
+	case CMD_IA_SET_VERTEX_BUFFERS:
+	case CMD_IA_SET_INDEX_BUFFER:
+	case CMD_PS_SET_SAMPLERS:
+	case CMD_RS_SET_STATE:
+	case CMD_OM_SET_BLEND_STATE:
+	case CMD_OM_SET_DEPTH_STENCIL_STATE:
+	case CMD_OM_SET_RENDER_TARGETS:
+	case CMD_IA_SET_PRIMITIVE_TOPOLOGY:
+	case CMD_VS_SET_CONSTANT_BUFFERS:
+	case CMD_PS_SET_CONSTANT_BUFFERS:
+	case CMD_VS_SET_CONSTANT_BUFFERS1:
+	case CMD_PS_SET_CONSTANT_BUFFERS1:
+		return true;
+	default:
+		return false;
+	}
+}
+
+namespace {
+	/// Argumentos sin signo.
+	void
+	readArgs(CommandReader& reader, CommandRecord& record, unsigned int count) {
+		for (unsigned int i = 0; i < count; ++i) {
+			record.args.push_back(reader.u32());
+		}
+	}
+
+	/// Argumentos float (se guardan sus bits).
+	void
+	readFloats(CommandReader& reader, CommandRecord& record, unsigned int count) {
+		for (unsigned int i = 0; i < count; ++i) {
+			const float value = reader.f32();
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			record.args.push_back(bits);
+		}
+	}
+
+	/// Número de bytes y los bytes detrás.
+	void
+	readBlob(CommandReader& reader, CommandRecord& record) {
+		const uint32_t size = reader.u32();
+		record.args.push_back(size);
+		record.blobs.push_back(reader.bytes(size));
+	}
+
+	/// Caja opcional (left, top, front, right, bottom, back).
+	void
+	readBox(CommandReader& reader, CommandRecord& record) {
+		const uint32_t hasBox = reader.u32();
+		record.args.push_back(hasBox);
+		if (hasBox) {
+			readArgs(reader, record, 6);
+		}
+	}
+
+	/// start, count y count grupos de perSlot argumentos.
+	void
+	readSlots(CommandReader& reader, CommandRecord& record, unsigned int perSlot) {
+		readArgs(reader, record, 1);
+		const uint32_t count = reader.u32();
+		record.args.push_back(count);
+		for (uint32_t i = 0; i < count && !reader.failed(); ++i) {
+			readArgs(reader, record, perSlot);
+		}
+	}
+
+	void
+	writeLE(std::vector<uint8_t>& data, uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; ++i) {
+			data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+		}
+	}
+
+	uint64_t
+	readLE(const uint8_t* data, int bytes) {
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; ++i) {
+			value |= static_cast<uint64_t>(data[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	const char kCaptureMagic[4] = { 'V', 'C', 'A', 'P' };
+	const size_t kCaptureHeaderBytes = 4 + 4 + 4 + 4 + 8;
+}
+
+bool
+decodeCommand(CommandReader& reader, CommandRecord& record) {
+	if (reader.atEnd()) {
+		return false;
+	}
+	record.offset = reader.offset();
+	record.op = reader.op();
+	record.args.clear();
+	record.blobs.clear();
+
+	switch (record.op) {
+	case CMD_FRAME:
+	case CMD_IA_SET_INPUT_LAYOUT:
+	case CMD_VS_SET_SHADER:
+	case CMD_PS_SET_SHADER:
+	case CMD_RS_SET_STATE:
+	case CMD_IA_SET_PRIMITIVE_TOPOLOGY:
+	case CMD_FINISH_COMMAND_LIST:
+		readArgs(reader, record, 1);
+		break;
+	case CMD_RESOURCE:
+		readArgs(reader, record, 4);
+		break;
+	case CMD_CLEAR_STATE:
+		break;
+	case CMD_RS_SET_VIEWPORTS: {
+		const uint32_t count = reader.u32();
+		record.args.push_back(count);
+		for (uint32_t i = 0; i < count && !reader.failed(); ++i) {
+			readFloats(reader, record, 6);
+		}
+		break;
+	}
+	case CMD_PS_SET_SHADER_RESOURCES:
+	case CMD_PS_SET_SAMPLERS:
+	case CMD_VS_SET_CONSTANT_BUFFERS:
+	case CMD_PS_SET_CONSTANT_BUFFERS:
+		readSlots(reader, record, 1);
+		break;
+	case CMD_IA_SET_VERTEX_BUFFERS:
+	case CMD_VS_SET_CONSTANT_BUFFERS1:
+	case CMD_PS_SET_CONSTANT_BUFFERS1:
+		readSlots(reader, record, 3);
+		break;
+	case CMD_UPDATE_SUBRESOURCE:
+		readArgs(reader, record, 5);
+		readBox(reader, record);
+		readBlob(reader, record);
+		break;
+	case CMD_MAP:
+	case CMD_IA_SET_INDEX_BUFFER:
+		readArgs(reader, record, 3);
+		break;
+	case CMD_UNMAP: {
+		readArgs(reader, record, 2);
+		const uint32_t ranges = reader.u32();
+		record.args.push_back(ranges);
+		for (uint32_t i = 0; i < ranges && !reader.failed(); ++i) {
+			readArgs(reader, record, 1);
+			readBlob(reader, record);
+		}
+		break;
+	}
+	case CMD_COPY_SUBRESOURCE_REGION:
+		readArgs(reader, record, 7);
+		readBox(reader, record);
+		break;
+	case CMD_OM_SET_BLEND_STATE:
+		readArgs(reader, record, 1);
+		readFloats(reader, record, 4);
+		readArgs(reader, record, 1);
+		break;
+	case CMD_OM_SET_DEPTH_STENCIL_STATE:
+	case CMD_EXECUTE_COMMAND_LIST:
+		readArgs(reader, record, 2);
+		break;
+	case CMD_OM_SET_RENDER_TARGETS: {
+		const uint32_t count = reader.u32();
+		record.args.push_back(count);
+		if (count > 8) {
+			return false;
+		}
+		// Vistas y el depth-stencil.
+		readArgs(reader, record, count + 1);
+		break;
+	}
+	case CMD_CLEAR_RENDER_TARGET_VIEW:
+		readArgs(reader, record, 1);
+		readFloats(reader, record, 4);
+		break;
+	case CMD_CLEAR_DEPTH_STENCIL_VIEW:
+		readArgs(reader, record, 2);
+		readFloats(reader, record, 1);
+		readArgs(reader, record, 1);
+		break;
+	case CMD_DRAW_INDEXED:
+		readArgs(reader, record, 2);
+		record.args.push_back(static_cast<uint32_t>(reader.i32()));
+		break;
+	case CMD_DRAW_INDEXED_INSTANCED:
+		readArgs(reader, record, 3);
+		record.args.push_back(static_cast<uint32_t>(reader.i32()));
+		readArgs(reader, record, 1);
+		break;
+	default:
+		return false;
+	}
+	return !reader.failed();
+}
+
+CommandStreamStats
+analyzeCommandStream(const std::vector<uint8_t>& stream) {
+	CommandStreamStats stats;
+	CommandReader reader(stream.data(), stream.size());
+	CommandRecord record;
+	bool ordered = true;
+	bool decoded = true;
+	while (!reader.atEnd()) {
+		// Un código desconocido al final deja el lector al final: se cuenta como error aparte.
+		if (!decodeCommand(reader, record)) {
+			decoded = false;
+			break;
+		}
+		if (record.op == CMD_FRAME) {
+			++stats.frames;
+			continue;
+		}
+		if (record.op == CMD_RESOURCE) {
+			// Los ids se reparten en orden: uno nuevo es siempre el siguiente.
+			if (record.args[0] == 0 || record.args[0] > stats.resources + 1) {
+				ordered = false;
+				break;
+			}
+			stats.resources = std::max(stats.resources, record.args[0]);
+			continue;
+		}
+		++stats.commands;
+		++stats.counts[record.op];
+		if (isBindCommand(record.op)) {
+			++stats.binds;
+		}
+		switch (record.op) {
+		case CMD_DRAW_INDEXED:
+			++stats.draws;
+			stats.indices += record.args[0];
+			break;
+		case CMD_DRAW_INDEXED_INSTANCED:
+			++stats.draws;
+			stats.indices += static_cast<uint64_t>(record.args[0]) * record.args[1];
+			break;
+		case CMD_UPDATE_SUBRESOURCE:
+			++stats.uploads;
+			stats.uploadBytes += record.args[2];
+			stats.contentBytes += record.args.back();
+			break;
+		case CMD_MAP:
+			++stats.maps;
+			break;
+		case CMD_UNMAP:
+			// id, subresource, rangos y (offset, n) por rango.
+			for (size_t i = 4; i < record.args.size(); i += 2) {
+				stats.mapBytes += record.args[i];
+				stats.contentBytes += record.args[i];
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	stats.valid = ordered && decoded && reader.atEnd() && !reader.failed();
+	return stats;
+}
+
+std::vector<StreamResource>
+listStreamResources(const std::vector<uint8_t>& stream) {
+	std::vector<StreamResource> resources;
+	CommandReader reader(stream.data(), stream.size());
+	CommandRecord record;
+	while (decodeCommand(reader, record)) {
+		if (record.op != CMD_RESOURCE) {
+			continue;
+		}
+		if (record.args[0] == 0 || record.args[0] > resources.size() + 1) {
+			break;
+		}
+		if (resources.size() < record.args[0]) {
+			resources.resize(record.args[0]);
+		}
+		StreamResource& resource = resources[record.args[0] - 1];
+		resource.id = record.args[0];
+		resource.kind = static_cast<ResourceKind>(record.args[1]);
+		resource.bytes = record.args[2];
+		resource.flags = record.args[3];
+	}
+	return resources;
+}
+
+bool
+writeCaptureFile(const std::string& path, const CaptureFileHeader& header, const std::vector<uint8_t>& stream) {
+	std::vector<uint8_t> data(kCaptureMagic, kCaptureMagic + 4);
+	writeLE(data, header.version, 4);
+	writeLE(data, header.frames, 4);
+	writeLE(data, header.resources, 4);
+	writeLE(data, stream.size(), 8);
+
+	std::error_code ec;
+	const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty()) {
+		std::filesystem::create_directories(parent, ec);
+	}
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	file.write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size()));
+	return static_cast<bool>(file);
+}
+
+bool
+readCaptureFile(const std::string& path, CaptureFileHeader& header, std::vector<uint8_t>& stream, std::string& error) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		error = "cannot open file";
+		return false;
+	}
+	const uint64_t fileBytes = static_cast<uint64_t>(file.tellg());
+	file.seekg(0);
+
+	uint8_t data[kCaptureHeaderBytes];
+	if (fileBytes < kCaptureHeaderBytes || !file.read(reinterpret_cast<char*>(data), kCaptureHeaderBytes)) {
+		error = "file too small";
+		return false;
+	}
+	if (std::memcmp(data, kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+		error = "not a capture file";
+		return false;
+	}
+	header.version = static_cast<uint32_t>(readLE(data + 4, 4));
+	header.frames = static_cast<uint32_t>(readLE(data + 8, 4));
+	header.resources = static_cast<uint32_t>(readLE(data + 12, 4));
+	header.streamBytes = readLE(data + 16, 8);
+	if (header.version != kCaptureFileVersion) {
+		error = "unsupported version " + std::to_string(header.version);
+		return false;
+	}
+	if (header.streamBytes != fileBytes - kCaptureHeaderBytes) {
+		error = "truncated stream";
+		return false;
+	}
+	stream.resize(static_cast<size_t>(header.streamBytes));
+	if (!file.read(reinterpret_cast<char*>(stream.data()), static_cast<std::streamsize>(stream.size()))) {
+		error = "read error";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,320 @@
+﻿/**
+ * @file ConstantBufferRing.cpp
+ * @brief Asignador circular por frame, seguimiento de subidas por hash y buffer dinámico con offsets.
+ */
+
+#include "ConstantBufferRing.h"
+#include "Device.h"
+#include "DeviceContext.h"
+#include "Hash.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+	/// Bloque asignado en un frame (para comprobar solapes en la prueba).
+	struct RingBlock {
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	/// Puntero ficticio para la prueba sintética (nunca se desreferencia).
+	ID3D11Buffer*
+	fakeBuffer(unsigned int index) {
+		return reinterpret_cast<ID3D11Buffer*>(uintptr_t(index + 1) << 4);
+	}
+}
+
+void
+ConstantRingAllocator::init(unsigned int capacity) {
+	m_capacity = capacity & ~(kAlignment - 1);
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+	m_frame = 0;
+	std::fill_n(m_frameBytes, kFramesInFlight, 0u);
+}
+
+void
+ConstantRingAllocator::beginFrame() {
+	++m_frame;
+	// El hueco de este frame es el del frame de hace kFramesInFlight: la GPU ya terminó con él.
+	unsigned int& retired = m_frameBytes[m_frame % kFramesInFlight];
+	if (retired > 0) {
+		m_tail = (m_tail + retired) % m_capacity;
+		m_used -= retired;
+		retired = 0;
+	}
+	if (m_used == 0) {
+		m_head = 0;
+		m_tail = 0;
+	}
+}
+
+bool
+ConstantRingAllocator::allocate(unsigned int size, unsigned int& offset) {
+	const unsigned int alignedSize = align(size);
+	if (size == 0 || alignedSize > m_capacity) {
+		return false;
+	}
+	if (m_used == 0) {
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	unsigned int start = m_head;
+	unsigned int waste = 0;
+	if (m_head > m_tail || m_used == 0) {
+		// Ocupado [tail, head): libre hasta el final y, dando la vuelta, [0, tail).
+		if (m_capacity - m_head < alignedSize) {
+			if (m_tail < alignedSize) {
+				return false;
+			}
+			waste = m_capacity - m_head;
+			start = 0;
+		}
+	}
+	else if (m_tail - m_head < alignedSize) {
+		// Ya dio la vuelta: libre solo [head, tail) (vacío si head == tail con el anillo lleno).
+		return false;
+	}
+
+	m_head = start + alignedSize;
+	m_used += waste + alignedSize;
+	m_frameBytes[m_frame % kFramesInFlight] += waste + alignedSize;
+	offset = start;
+	return true;
+}
+
+bool
+ConstantRingAllocator::allocateConstants(unsigned int size,
+	unsigned int& offset,
+	unsigned int& firstConstant,
+	unsigned int& numConstants) {
+	if (!allocate(size, offset)) {
+		return false;
+	}
+	firstConstant = offset / 16;
+	numConstants = align(size) / 16;
+	return true;
+}
+
+bool
+ConstantUploadTracker::check(ID3D11Buffer* buffer, uint64_t hash, bool& inserted) {
+	auto result = m_entries.emplace(buffer, Entry{ hash, m_frame });
+	inserted = result.second;
+	if (inserted) {
+		return true;
+	}
+	Entry& entry = result.first->second;
+	entry.lastFrame = m_frame;
+	if (entry.hash == hash) {
+		return false;
+	}
+	entry.hash = hash;
+	return true;
+}
+
+void
+ConstantUploadTracker::beginFrame(std::vector<ID3D11Buffer*>& evicted) {
+	++m_frame;
+	// Recorrer la tabla cada frame no compensa: se revisa unas pocas veces por periodo.
+	if (m_frame % (kEvictFrames / 4) != 0) {
+		return;
+	}
+	for (auto it = m_entries.begin(); it != m_entries.end();) {
+		if (m_frame - it->second.lastFrame > kEvictFrames) {
+			evicted.push_back(it->first);
+			it = m_entries.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void
+ConstantUploadTracker::clear(std::vector<ID3D11Buffer*>& released) {
+	for (const auto& entry : m_entries) {
+		released.push_back(entry.first);
+	}
+	m_entries.clear();
+}
+
+HRESULT
+ConstantBufferRing::init(Device& device, DeviceContext& deviceContext, unsigned int capacity) {
+	if (!device.m_device || !deviceContext.m_deviceContext) {
+		ERROR("ConstantBufferRing", "init", "Device or DeviceContext is nullptr");
+		return E_POINTER;
+	}
+	HRESULT hr = deviceContext.enableConstantOffsets(device);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = capacity & ~(ConstantRingAllocator::kAlignment - 1);
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	hr = device.CreateBuffer(&desc, nullptr, &m_buffer);
+	if (FAILED(hr)) {
+		ERROR("ConstantBufferRing", "init", "Failed to create the constant ring buffer");
+		return hr;
+	}
+	m_allocator.init(desc.ByteWidth);
+	m_discarded = false;
+	return S_OK;
+}
+
+void
+ConstantBufferRing::destroy() {
+	SAFE_RELEASE(m_buffer);
+	m_allocator.init(0);
+	m_mapped = nullptr;
+	m_discarded = false;
+}
+
+bool
+ConstantBufferRing::map(DeviceContext& deviceContext) {
+	if (!m_buffer) {
+		return false;
+	}
+	// NO_OVERWRITE exige que el buffer se haya abierto antes con DISCARD.
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	const D3D11_MAP type = m_discarded ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+	HRESULT hr = deviceContext.Map(m_buffer, 0, type, 0, &mapped);
+	if (FAILED(hr) || !mapped.pData) {
+		ERROR("ConstantBufferRing", "map", "Failed to map the constant ring buffer");
+		return false;
+	}
+	m_discarded = true;
+	m_mapped = static_cast<unsigned char*>(mapped.pData);
+	m_writes = 0;
+	m_writtenBytes = 0;
+	return true;
+}
+
+bool
+ConstantBufferRing::write(const void* data, unsigned int size, unsigned int& firstConstant, unsigned int& numConstants) {
+	unsigned int offset = 0;
+	if (!m_mapped || !data || !m_allocator.allocateConstants(size, offset, firstConstant, numConstants)) {
+		return false;
+	}
+	std::memcpy(m_mapped + offset, data, size);
+	++m_writes;
+	m_writtenBytes += size;
+	return true;
+}
+
+void
+ConstantBufferRing::unmap(DeviceContext& deviceContext) {
+	if (!m_mapped) {
+		return;
+	}
+	deviceContext.Unmap(m_buffer, 0);
+	deviceContext.recordRingWrites(m_writes, m_writtenBytes);
+	m_mapped = nullptr;
+}
+
+ConstantRingBenchmark
+ConstantBufferRing::benchmark(unsigned int draws, unsigned int frames) {
+	ConstantRingBenchmark result;
+	const unsigned int meshesPerActor = 4;
+	result.actors = std::max(1u, draws / meshesPerActor);
+	result.draws = result.actors * meshesPerActor;
+	result.moving = result.actors / 10;
+	result.frames = std::max(2u, frames);
+	const unsigned int blockSize = sizeof(CBChangesEveryFrame);
+
+	std::vector<CBChangesEveryFrame> constants(result.actors);
+	for (unsigned int actor = 0; actor < result.actors; ++actor) {
+		constants[actor].mWorld = XMMatrixTranspose(XMMatrixTranslation(float(actor % 100), 0.0f, float(actor / 100)));
+		constants[actor].vMeshColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
+	// Antes: Actor::update subía su buffer y la cola volvía a subir las constantes de cada draw.
+	result.naiveBytes = uint64_t(result.actors + result.draws) * blockSize;
+
+	ConstantUploadTracker tracker;
+	ConstantRingAllocator allocator;
+	allocator.init(kDefaultCapacity);
+	std::vector<unsigned char> ring(allocator.getCapacity());
+	std::vector<std::vector<RingBlock>> inFlight(ConstantRingAllocator::kFramesInFlight);
+	std::vector<RingBlock> live;
+	std::vector<ID3D11Buffer*> evicted;
+	bool valid = true;
+	uint64_t trackedBytes = 0;
+	uint64_t ringBytes = 0;
+
+	for (unsigned int frame = 0; frame < result.frames; ++frame) {
+		// Una décima parte de los actores se mueve cada frame.
+		for (unsigned int actor = 0; actor < result.moving; ++actor) {
+			constants[actor].mWorld = XMMatrixTranspose(XMMatrixTranslation(float(actor % 100), float(frame), float(actor / 100)));
+		}
+
+		// Con seguimiento: el buffer de cada actor se sube en update() y en cada draw solo si el hash cambió.
+		auto start = std::chrono::steady_clock::now();
+		tracker.beginFrame(evicted);
+		uint64_t frameTracked = 0;
+		uint64_t frameActorUploads = 0;
+		for (unsigned int actor = 0; actor < result.actors; ++actor) {
+			bool inserted = false;
+			if (tracker.check(fakeBuffer(actor), hashBlock(&constants[actor], blockSize), inserted)) {
+				frameTracked += blockSize;
+				frameActorUploads += blockSize;
+			}
+			for (unsigned int mesh = 0; mesh < meshesPerActor; ++mesh) {
+				if (tracker.check(fakeBuffer(actor), hashBlock(&constants[actor], blockSize), inserted)) {
+					frameTracked += blockSize;
+				}
+			}
+		}
+		const double trackedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// Con el anillo: las constantes de cada draw se copian al bloque del frame.
+		start = std::chrono::steady_clock::now();
+		allocator.beginFrame();
+		std::vector<RingBlock>& blocks = inFlight[frame % ConstantRingAllocator::kFramesInFlight];
+		blocks.clear();
+		uint64_t frameRing = 0;
+		for (unsigned int draw = 0; draw < result.draws; ++draw) {
+			unsigned int offset = 0;
+			if (!allocator.allocate(blockSize, offset)) {
+				++result.ringFallbacks;
+				continue;
+			}
+			std::memcpy(ring.data() + offset, &constants[draw / meshesPerActor], blockSize);
+			blocks.push_back({ offset, ConstantRingAllocator::align(blockSize) });
+			frameRing += blockSize;
+		}
+		const double ringMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// Los bloques de los frames en vuelo no se solapan, están alineados y caben en el buffer.
+		live.clear();
+		for (const auto& frameBlocks : inFlight) {
+			live.insert(live.end(), frameBlocks.begin(), frameBlocks.end());
+		}
+		std::sort(live.begin(), live.end(), [](const RingBlock& a, const RingBlock& b) { return a.offset < b.offset; });
+		for (size_t i = 0; i < live.size(); ++i) {
+			valid = valid && live[i].offset % ConstantRingAllocator::kAlignment == 0 &&
+				live[i].offset + live[i].size <= allocator.getCapacity() &&
+				(i == 0 || live[i - 1].offset + live[i - 1].size <= live[i].offset);
+		}
+
+		// El primer frame sube todo en cualquier caso: el promedio es del régimen estable.
+		if (frame > 0) {
+			trackedBytes += frameTracked;
+			ringBytes += frameRing + frameActorUploads;
+			result.trackedMs += trackedMs;
+			result.ringMs += ringMs;
+		}
+	}
+
+	const unsigned int measured = result.frames - 1;
+	result.trackedBytes = trackedBytes / measured;
+	result.ringBytes = ringBytes / measured;
+	result.trackedMs /= measured;
+	result.ringMs /= measured;
+	result.allocatorValid = valid && result.ringFallbacks == 0;
+	return result;
+}
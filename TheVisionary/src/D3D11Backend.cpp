@@ -0,0 +1,280 @@
+﻿/**
+ * @file D3D11Backend.cpp
+ * @brief Envío directo de los comandos de RenderBackend a Direct3D 11.
+ */
+
+#include "D3D11Backend.h"
+
+// Los tipos simples de RenderBackend se pasan tal cual a D3D11: misma disposición.
+static_assert(sizeof(BackendViewport) == sizeof(D3D11_VIEWPORT), "BackendViewport != D3D11_VIEWPORT");
+static_assert(sizeof(BackendBox) == sizeof(D3D11_BOX), "BackendBox != D3D11_BOX");
+static_assert(sizeof(BackendMappedSubresource) == sizeof(D3D11_MAPPED_SUBRESOURCE),
+	"BackendMappedSubresource != D3D11_MAPPED_SUBRESOURCE");
+static_assert(BACKEND_MAP_WRITE_DISCARD == D3D11_MAP_WRITE_DISCARD &&
+	BACKEND_MAP_WRITE_NO_OVERWRITE == D3D11_MAP_WRITE_NO_OVERWRITE, "BackendMap != D3D11_MAP");
+static_assert(sizeof(BackendResult) == sizeof(HRESULT), "BackendResult != HRESULT");
+
+void
+D3D11Backend::attach(ID3D11DeviceContext* context) {
+	if (context != m_context) {
+		detach();
+	}
+	m_context = context;
+}
+
+void
+D3D11Backend::detach() {
+#if defined(VISIONARY_D3D11_1)
+	SAFE_RELEASE(m_context1);
+#endif
+	m_context = nullptr;
+}
+
+HRESULT
+D3D11Backend::enableConstantOffsets(ID3D11Device* device) {
+#if defined(VISIONARY_D3D11_1)
+	if (m_context1) {
+		return S_OK;
+	}
+	if (!device || !m_context) {
+		ERROR("D3D11Backend", "enableConstantOffsets", "Device or context is nullptr");
+		return E_POINTER;
+	}
+	// El runtime 11.1 con un driver antiguo expone la interfaz pero no las dos capacidades.
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	HRESULT hr = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if (FAILED(hr) || !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer) {
+		return E_NOTIMPL;
+	}
+	hr = m_context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&m_context1));
+	if (FAILED(hr)) {
+		m_context1 = nullptr;
+		return hr;
+	}
+	return S_OK;
+#else
+	(void)device;
+	return E_NOTIMPL;
+#endif
+}
+
+bool
+D3D11Backend::supportsConstantOffsets() const {
+#if defined(VISIONARY_D3D11_1)
+	return m_context1 != nullptr;
+#else
+	return false;
+#endif
+}
+
+void
+D3D11Backend::ClearState() {
+	m_context->ClearState();
+}
+
+void
+D3D11Backend::RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) {
+	m_context->RSSetViewports(NumViewports, reinterpret_cast<const D3D11_VIEWPORT*>(pViewports));
+}
+
+void
+D3D11Backend::PSSetShaderResources(unsigned int StartSlot,
+	unsigned int NumViews,
+	ID3D11ShaderResourceView* const* ppShaderResourceViews) {
+	m_context->PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
+}
+
+void
+D3D11Backend::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
+	m_context->IASetInputLayout(pInputLayout);
+}
+
+void
+D3D11Backend::VSSetShader(ID3D11VertexShader* pVertexShader,
+	ID3D11ClassInstance* const* ppClassInstances,
+	unsigned int NumClassInstances) {
+	m_context->VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
+}
+
+void
+D3D11Backend::PSSetShader(ID3D11PixelShader* pPixelShader,
+	ID3D11ClassInstance* const* ppClassInstances,
+	unsigned int NumClassInstances) {
+	m_context->PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
+}
+
+void
+D3D11Backend::UpdateSubresource(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	const BackendBox* pDstBox,
+	const void* pSrcData,
+	unsigned int SrcRowPitch,
+	unsigned int SrcDepthPitch,
+	unsigned int SrcBytes) {
+	(void)SrcBytes;
+	m_context->UpdateSubresource(pDstResource, DstSubresource, reinterpret_cast<const D3D11_BOX*>(pDstBox),
+		pSrcData, SrcRowPitch, SrcDepthPitch);
+}
+
+HRESULT
+D3D11Backend::Map(ID3D11Resource* pResource,
+	unsigned int Subresource,
+	unsigned int MapType,
+	unsigned int MapFlags,
+	BackendMappedSubresource* pMappedResource) {
+	return m_context->Map(pResource, Subresource, static_cast<D3D11_MAP>(MapType), MapFlags,
+		reinterpret_cast<D3D11_MAPPED_SUBRESOURCE*>(pMappedResource));
+}
+
+void
+D3D11Backend::Unmap(ID3D11Resource* pResource, unsigned int Subresource) {
+	m_context->Unmap(pResource, Subresource);
+}
+
+void
+D3D11Backend::CopySubresourceRegion(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	unsigned int DstX,
+	unsigned int DstY,
+	unsigned int DstZ,
+	ID3D11Resource* pSrcResource,
+	unsigned int SrcSubresource,
+	const BackendBox* pSrcBox) {
+	m_context->CopySubresourceRegion(pDstResource, DstSubresource, DstX, DstY, DstZ,
+		pSrcResource, SrcSubresource, reinterpret_cast<const D3D11_BOX*>(pSrcBox));
+}
+
+void
+D3D11Backend::IASetVertexBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppVertexBuffers,
+	const unsigned int* pStrides,
+	const unsigned int* pOffsets) {
+	m_context->IASetVertexBuffers(StartSlot, NumBuffers, ppVertexBuffers, pStrides, pOffsets);
+}
+
+void
+D3D11Backend::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+	unsigned int Format,
+	unsigned int Offset) {
+	m_context->IASetIndexBuffer(pIndexBuffer, static_cast<DXGI_FORMAT>(Format), Offset);
+}
+
+void
+D3D11Backend::PSSetSamplers(unsigned int StartSlot,
+	unsigned int NumSamplers,
+	ID3D11SamplerState* const* ppSamplers) {
+	m_context->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
+}
+
+void
+D3D11Backend::RSSetState(ID3D11RasterizerState* pRasterizerState) {
+	m_context->RSSetState(pRasterizerState);
+}
+
+void
+D3D11Backend::OMSetBlendState(ID3D11BlendState* pBlendState,
+	const float BlendFactor[4],
+	unsigned int SampleMask) {
+	m_context->OMSetBlendState(pBlendState, BlendFactor, SampleMask);
+}
+
+void
+D3D11Backend::OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+	unsigned int StencilRef) {
+	m_context->OMSetDepthStencilState(pDepthStencilState, StencilRef);
+}
+
+void
+D3D11Backend::OMSetRenderTargets(unsigned int NumViews,
+	ID3D11RenderTargetView* const* ppRenderTargetViews,
+	ID3D11DepthStencilView* pDepthStencilView) {
+	m_context->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+}
+
+void
+D3D11Backend::IASetPrimitiveTopology(unsigned int Topology) {
+	m_context->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(Topology));
+}
+
+void
+D3D11Backend::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+	const float ColorRGBA[4]) {
+	m_context->ClearRenderTargetView(pRenderTargetView, ColorRGBA);
+}
+
+void
+D3D11Backend::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+	unsigned int ClearFlags,
+	float Depth,
+	uint8_t Stencil) {
+	m_context->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+}
+
+void
+D3D11Backend::VSSetConstantBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers) {
+	m_context->VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+}
+
+void
+D3D11Backend::PSSetConstantBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers) {
+	m_context->PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+}
+
+void
+D3D11Backend::VSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+#if defined(VISIONARY_D3D11_1)
+	m_context1->VSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+#else
+	(void)StartSlot; (void)NumBuffers; (void)ppConstantBuffers; (void)pFirstConstant; (void)pNumConstants;
+#endif
+}
+
+void
+D3D11Backend::PSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+#if defined(VISIONARY_D3D11_1)
+	m_context1->PSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+#else
+	(void)StartSlot; (void)NumBuffers; (void)ppConstantBuffers; (void)pFirstConstant; (void)pNumConstants;
+#endif
+}
+
+HRESULT
+D3D11Backend::FinishCommandList(bool RestoreDeferredContextState,
+	ID3D11CommandList** ppCommandList) {
+	return m_context->FinishCommandList(RestoreDeferredContextState ? TRUE : FALSE, ppCommandList);
+}
+
+void
+D3D11Backend::ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) {
+	m_context->ExecuteCommandList(pCommandList, RestoreContextState ? TRUE : FALSE);
+}
+
+void
+D3D11Backend::DrawIndexed(unsigned int IndexCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation) {
+	m_context->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+}
+
+void
+D3D11Backend::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+	unsigned int InstanceCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation,
+	unsigned int StartInstanceLocation) {
+	m_context->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation,
+		BaseVertexLocation, StartInstanceLocation);
+}
@@ -0,0 +1,99 @@
+﻿/**
+ * @file D3DShaderCompiler.cpp
+ * @brief D3DCompile con un manejador de #include que resuelve igual que la clave de ShaderCache.
+ */
+
+#include "D3DShaderCompiler.h"
+#include <list>
+#include <map>
+
+namespace {
+	/// Sirve los #include a D3DCompile con la misma resolución que usa la clave.
+	class ShaderIncludeHandler : public ID3DInclude {
+	public:
+		explicit ShaderIncludeHandler(const std::string& rootDir) : m_rootDir(rootDir) {}
+
+		HRESULT STDMETHODCALLTYPE
+		Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes) override {
+			auto parent = m_dirs.find(parentData);
+			const std::string& dir = parent != m_dirs.end() ? parent->second : m_rootDir;
+			const std::string path = ShaderCache::resolveInclude(fileName, dir, m_rootDir);
+			if (path.empty()) {
+				return E_FAIL;
+			}
+			m_files.push_back(ShaderCache::readFile(path));
+			const std::string& contents = m_files.back();
+			m_dirs[contents.data()] = ShaderCache::directoryOf(path);
+			*data = contents.data();
+			*bytes = static_cast<UINT>(contents.size());
+			return S_OK;
+		}
+
+		HRESULT STDMETHODCALLTYPE
+		Close(LPCVOID) override {
+			// El contenido vive hasta que termina la compilación.
+			return S_OK;
+		}
+
+	private:
+		std::string m_rootDir;                    ///< Directorio del archivo compilado.
+		std::list<std::string> m_files;           ///< Contenido de los archivos abiertos.
+		std::map<const void*, std::string> m_dirs; ///< Directorio de cada archivo abierto.
+	};
+}
+
+bool
+D3DShaderCompiler::compile(const ShaderCompileRequest& request,
+	std::vector<char>& bytecode,
+	std::string& errors) {
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (const ShaderDefine& define : request.defines) {
+		macros.push_back({ define.name.c_str(), define.value.empty() ? "1" : define.value.c_str() });
+	}
+	macros.push_back({ nullptr, nullptr });
+
+	ShaderIncludeHandler includes(ShaderCache::directoryOf(request.fileName));
+	ID3DBlob* shaderData = nullptr;
+	ID3DBlob* errorData = nullptr;
+	HRESULT hr = D3DCompile(request.source.data(),
+		request.source.size(),
+		request.fileName.c_str(),
+		macros.data(),
+		&includes,
+		request.entryPoint.c_str(),
+		request.profile.c_str(),
+		getFlags(),
+		0,
+		&shaderData,
+		&errorData);
+
+	if (errorData) {
+		errors.assign(static_cast<const char*>(errorData->GetBufferPointer()), errorData->GetBufferSize());
+	}
+	SAFE_RELEASE(errorData);
+	if (FAILED(hr) || !shaderData) {
+		SAFE_RELEASE(shaderData);
+		if (errors.empty()) {
+			errors = "D3DCompile failed, hr=" + std::to_string(hr);
+		}
+		return false;
+	}
+	const char* data = static_cast<const char*>(shaderData->GetBufferPointer());
+	bytecode.assign(data, data + shaderData->GetBufferSize());
+	SAFE_RELEASE(shaderData);
+	return true;
+}
+
+std::string
+D3DShaderCompiler::getId() const {
+	return "D3DCompile_" + std::to_string(D3D_COMPILER_VERSION) + " flags " + std::to_string(getFlags());
+}
+
+UINT
+D3DShaderCompiler::getFlags() {
+	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined( DEBUG ) || defined( _DEBUG )
+	flags |= D3DCOMPILE_DEBUG;
+#endif
+	return flags;
+}
@@ -0,0 +1,112 @@
+﻿/**
+ * @file DeferredContextPool.cpp
+ * @brief Creación de contextos diferidos, cierre y ejecución ordenada de listas, y reparto por coste.
+ */
+
+#include "DeferredContextPool.h"
+#include "Device.h"
+
+HRESULT
+DeferredContextPool::init(Device& device, unsigned int count) {
+	if (!device.m_device) {
+		ERROR("DeferredContextPool", "init", "Device is nullptr");
+		return E_POINTER;
+	}
+	destroy();
+
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	HRESULT hr = device.m_device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+	m_nativeCommandLists = SUCCEEDED(hr) && threading.DriverCommandLists;
+
+	count = std::min(std::max(count, 1u), kMaxContexts);
+	m_contexts.resize(count);
+	m_lists.assign(count, nullptr);
+	for (DeviceContext& context : m_contexts) {
+		hr = device.CreateDeferredContext(&context.m_deviceContext);
+		if (FAILED(hr)) {
+			destroy();
+			return hr;
+		}
+		context.init();
+		// Las subidas de un contexto diferido se ejecutan más tarde: el seguimiento por hash
+		// solo es válido en el contexto inmediato.
+		context.setSkipUnchangedUploads(false);
+		// Sin anillo disponible falla sin más: los paquetes suben a su propio buffer.
+		context.enableConstantOffsets(device);
+	}
+	return S_OK;
+}
+
+void
+DeferredContextPool::destroy() {
+	for (ID3D11CommandList*& list : m_lists) {
+		SAFE_RELEASE(list);
+	}
+	m_lists.clear();
+	for (DeviceContext& context : m_contexts) {
+		context.destroy();
+	}
+	m_contexts.clear();
+	m_nativeCommandLists = false;
+}
+
+HRESULT
+DeferredContextPool::finish(unsigned int index) {
+	if (index >= m_contexts.size()) {
+		ERROR("DeferredContextPool", "finish", "Context index out of range");
+		return E_INVALIDARG;
+	}
+	SAFE_RELEASE(m_lists[index]);
+	return m_contexts[index].FinishCommandList(false, &m_lists[index]);
+}
+
+void
+DeferredContextPool::execute(DeviceContext& deviceContext, unsigned int count) {
+	count = std::min(count, getCount());
+	for (unsigned int i = 0; i < count; ++i) {
+		// Una lista que no se pudo cerrar se omite: sus draws faltan en este frame y nada más.
+		if (m_lists[i]) {
+			deviceContext.ExecuteCommandList(m_lists[i], false);
+			SAFE_RELEASE(m_lists[i]);
+		}
+	}
+}
+
+void
+DeferredContextPool::partition(const std::vector<unsigned int>& costs,
+	unsigned int parts,
+	unsigned int minChunk,
+	std::vector<SubmitChunk>& chunks) {
+	chunks.clear();
+	const unsigned int count = static_cast<unsigned int>(costs.size());
+	if (count == 0) {
+		return;
+	}
+	minChunk = std::max(minChunk, 1u);
+	parts = std::max(1u, std::min(parts, (count + minChunk - 1) / minChunk));
+
+	uint64_t total = 0;
+	for (unsigned int cost : costs) {
+		total += cost;
+	}
+
+	// Corta cuando el coste acumulado pasa la fracción del tramo, sin bajar de minChunk
+	// entradas y dejando al menos minChunk para cada tramo que falta.
+	SubmitChunk chunk;
+	uint64_t accumulated = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		accumulated += costs[i];
+		const unsigned int part = static_cast<unsigned int>(chunks.size());
+		const unsigned int size = i + 1 - chunk.begin;
+		const unsigned int remaining = count - (i + 1);
+		const unsigned int partsLeft = parts - part - 1;
+		if (partsLeft > 0 && remaining > 0 && size >= minChunk &&
+			(accumulated * parts >= total * (part + 1) || remaining <= partsLeft * minChunk)) {
+			chunk.end = i + 1;
+			chunks.push_back(chunk);
+			chunk.begin = chunk.end;
+		}
+	}
+	chunk.end = count;
+	chunks.push_back(chunk);
+}
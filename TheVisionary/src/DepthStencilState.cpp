@@ -61,10 +61,10 @@ DepthStencilState::render(DeviceContext& deviceContext,
     }
 
     if (!reset) {
-        deviceContext.m_deviceContext->OMSetDepthStencilState(m_depthStencilState, stencilRef);
+        deviceContext.OMSetDepthStencilState(m_depthStencilState, stencilRef);
     }
     else {
-        deviceContext.m_deviceContext->OMSetDepthStencilState(nullptr, stencilRef);
+        deviceContext.OMSetDepthStencilState(nullptr, stencilRef);
     }
 }
 
@@ -62,7 +62,7 @@ DepthStencilView::render(DeviceContext& deviceContext) {
     }
 
     // Limpia profundidad y stencil
-    deviceContext.m_deviceContext->ClearDepthStencilView(
+    deviceContext.ClearDepthStencilView(
         m_depthStencilView,
         D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
         1.0f,
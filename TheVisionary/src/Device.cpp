@@ -4,9 +4,60 @@
  */
 
 #include "Device.h"
+#include <cstring>
+
+namespace {
+	/// Copia del descriptor sin bytes de relleno indefinidos (tras las mscaras UINT8), para usarlo como clave.
+	D3D11_DEPTH_STENCIL_DESC
+	depthStencilKey(const D3D11_DEPTH_STENCIL_DESC& desc) {
+		D3D11_DEPTH_STENCIL_DESC key;
+		std::memset(&key, 0, sizeof(key));
+		key.DepthEnable = desc.DepthEnable;
+		key.DepthWriteMask = desc.DepthWriteMask;
+		key.DepthFunc = desc.DepthFunc;
+		key.StencilEnable = desc.StencilEnable;
+		key.StencilReadMask = desc.StencilReadMask;
+		key.StencilWriteMask = desc.StencilWriteMask;
+		key.FrontFace = desc.FrontFace;
+		key.BackFace = desc.BackFace;
+		return key;
+	}
+
+	/// Igual para el blending: cada render target tiene relleno tras RenderTargetWriteMask.
+	D3D11_BLEND_DESC
+	blendKey(const D3D11_BLEND_DESC& desc) {
+		D3D11_BLEND_DESC key;
+		std::memset(&key, 0, sizeof(key));
+		key.AlphaToCoverageEnable = desc.AlphaToCoverageEnable;
+		key.IndependentBlendEnable = desc.IndependentBlendEnable;
+		for (unsigned int i = 0; i < 8; ++i) {
+			D3D11_RENDER_TARGET_BLEND_DESC& target = key.RenderTarget[i];
+			const D3D11_RENDER_TARGET_BLEND_DESC& source = desc.RenderTarget[i];
+			target.BlendEnable = source.BlendEnable;
+			target.SrcBlend = source.SrcBlend;
+			target.DestBlend = source.DestBlend;
+			target.BlendOp = source.BlendOp;
+			target.SrcBlendAlpha = source.SrcBlendAlpha;
+			target.DestBlendAlpha = source.DestBlendAlpha;
+			target.BlendOpAlpha = source.BlendOpAlpha;
+			target.RenderTargetWriteMask = source.RenderTargetWriteMask;
+		}
+		return key;
+	}
+
+	/// Guarda el objeto recin creado; si otro hilo guard antes uno igual, el llamador se queda con ese.
+	template<typename T>
+	void
+	keepCached(ObjectCache& cache, CachedObjectType type, const void* key, size_t size, T** object) {
+		T* created = *object;
+		*object = static_cast<T*>(cache.insert(type, key, size, created));
+		created->Release();
+	}
+}
 
 void
 Device::destroy() {
+	m_cache->clear();
 	SAFE_RELEASE(m_device);
 }
 
@@ -211,10 +262,17 @@ Device::CreateSamplerState(const D3D11_SAMPLER_DESC* pSamplerDesc,
 		return E_POINTER;
 	}
 
+	// Mismo descriptor: se comparte el objeto (el llamador lo suelta como si lo hubiera creado)
+	if (IUnknown* cached = m_cache->find(CACHED_SAMPLER, pSamplerDesc, sizeof(*pSamplerDesc))) {
+		*ppSamplerState = static_cast<ID3D11SamplerState*>(cached);
+		return S_OK;
+	}
+
 	// Crear el Sampler State
 	HRESULT hr = m_device->CreateSamplerState(pSamplerDesc, ppSamplerState);
 
 	if (SUCCEEDED(hr)) {
+		keepCached(*m_cache, CACHED_SAMPLER, pSamplerDesc, sizeof(*pSamplerDesc), ppSamplerState);
 		MESSAGE("Device", "CreateSamplerState",
 			"Sampler State created successfully!");
 	}
@@ -268,10 +326,17 @@ Device::CreateBlendState(const D3D11_BLEND_DESC* pBlendStateDesc,
 		return E_POINTER;
 	}
 
+	const D3D11_BLEND_DESC key = blendKey(*pBlendStateDesc);
+	if (IUnknown* cached = m_cache->find(CACHED_BLEND, &key, sizeof(key))) {
+		*ppBlendState = static_cast<ID3D11BlendState*>(cached);
+		return S_OK;
+	}
+
 	// Crear el Blend State
 	HRESULT hr = m_device->CreateBlendState(pBlendStateDesc, ppBlendState);
 
 	if (SUCCEEDED(hr)) {
+		keepCached(*m_cache, CACHED_BLEND, &key, sizeof(key), ppBlendState);
 		MESSAGE("Device", "CreateBlendState",
 			"Blend State created successfully!");
 	}
@@ -295,10 +360,17 @@ Device::CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC* pDepthStencilDes
 		return E_POINTER;
 	}
 
+	const D3D11_DEPTH_STENCIL_DESC key = depthStencilKey(*pDepthStencilDesc);
+	if (IUnknown* cached = m_cache->find(CACHED_DEPTH_STENCIL, &key, sizeof(key))) {
+		*ppDepthStencilState = static_cast<ID3D11DepthStencilState*>(cached);
+		return S_OK;
+	}
+
 	// Crear el Depth Stencil State
 	HRESULT hr = m_device->CreateDepthStencilState(pDepthStencilDesc, ppDepthStencilState);
 
 	if (SUCCEEDED(hr)) {
+		keepCached(*m_cache, CACHED_DEPTH_STENCIL, &key, sizeof(key), ppDepthStencilState);
 		MESSAGE("Device", "CreateDepthStencilState",
 			"Depth Stencil State created successfully!");
 	}
@@ -323,10 +395,16 @@ Device::CreateRasterizerState(const D3D11_RASTERIZER_DESC* pRasterizerDesc,
 		return E_POINTER;
 	}
 
+	if (IUnknown* cached = m_cache->find(CACHED_RASTERIZER, pRasterizerDesc, sizeof(*pRasterizerDesc))) {
+		*ppRasterizerState = static_cast<ID3D11RasterizerState*>(cached);
+		return S_OK;
+	}
+
 	// Crear el Rasterizer State
 	HRESULT hr = m_device->CreateRasterizerState(pRasterizerDesc, ppRasterizerState);
 
 	if (SUCCEEDED(hr)) {
+		keepCached(*m_cache, CACHED_RASTERIZER, pRasterizerDesc, sizeof(*pRasterizerDesc), ppRasterizerState);
 		MESSAGE("Device", "CreateRasterizerState",
 			"Rasterizer State created successfully!");
 	}
@@ -337,3 +415,22 @@ Device::CreateRasterizerState(const D3D11_RASTERIZER_DESC* pRasterizerDesc,
 
 	return hr;
 }
+
+HRESULT
+Device::CreateDeferredContext(ID3D11DeviceContext** ppDeferredContext) {
+	if (!m_device) {
+		ERROR("Device", "CreateDeferredContext", "Device is nullptr");
+		return E_POINTER;
+	}
+	if (!ppDeferredContext) {
+		ERROR("Device", "CreateDeferredContext", "ppDeferredContext is nullptr");
+		return E_POINTER;
+	}
+	// Falla si el dispositivo se cre con D3D11_CREATE_DEVICE_SINGLETHREADED.
+	HRESULT hr = m_device->CreateDeferredContext(0, ppDeferredContext);
+	if (FAILED(hr)) {
+		ERROR("Device", "CreateDeferredContext",
+			("Failed to create deferred context. HRESULT: " + std::to_string(hr)).c_str());
+	}
+	return hr;
+}
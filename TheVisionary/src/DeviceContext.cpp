@@ -4,10 +4,149 @@
  */
 
 #include "DeviceContext.h"
+#include "Device.h"
+#include "Hash.h"
+#include "CaptureBackend.h"
+
+void
+DeviceContext::init() {
+	m_d3d11.attach(m_deviceContext);
+}
 
 void
 DeviceContext::destroy() {
+	m_uploadTracker.clear(m_released);
+	releaseUntracked();
+	m_d3d11.detach();
 	SAFE_RELEASE(m_deviceContext);
+	m_backend = nullptr;
+	m_stateCache.invalidate();
+}
+
+void
+DeviceContext::setBackend(RenderBackend* backend) {
+	// Lo seguido se subi al backend anterior: el nuevo no lo tiene.
+	resetTracking();
+	m_backend = backend;
+}
+
+void
+DeviceContext::beginCapture(CaptureBackend& capture) {
+	if (m_capture) {
+		endCapture();
+	}
+	capture.setTarget(&getBackend());
+	setBackend(&capture);
+	m_capture = &capture;
+}
+
+void
+DeviceContext::endCapture() {
+	if (!m_capture) {
+		return;
+	}
+	RenderBackend* target = m_capture->getTarget();
+	m_capture->setTarget(nullptr);
+	m_capture = nullptr;
+	setBackend(target == &m_d3d11 ? nullptr : target);
+}
+
+void
+DeviceContext::resetTracking() {
+	m_uploadTracker.clear(m_released);
+	releaseUntracked();
+	m_stateCache.invalidate();
+}
+
+void
+DeviceContext::beginFrame() {
+	if (m_capture) {
+		m_capture->beginFrame();
+	}
+	m_stateCache.beginFrame();
+	m_lastUploads = m_uploads;
+	m_uploads = ConstantUploadStats();
+	m_uploadTracker.beginFrame(m_released);
+	releaseUntracked();
+}
+
+void
+DeviceContext::releaseUntracked() {
+	for (ID3D11Buffer* buffer : m_released) {
+		buffer->Release();
+	}
+	m_released.clear();
+}
+
+HRESULT
+DeviceContext::enableConstantOffsets(Device& device) {
+	return m_d3d11.enableConstantOffsets(device.m_device);
+}
+
+bool
+DeviceContext::supportsConstantOffsets() const {
+	return m_backend ? m_backend->supportsConstantOffsets() : m_d3d11.supportsConstantOffsets();
+}
+
+void
+DeviceContext::setSkipUnchangedUploads(bool skip) {
+	if (!skip) {
+		m_uploadTracker.clear(m_released);
+		releaseUntracked();
+	}
+	m_skipUnchangedUploads = skip;
+}
+
+bool
+DeviceContext::UpdateConstantBuffer(ID3D11Buffer* pBuffer, const void* pSrcData, unsigned int ByteWidth) {
+	if (!pBuffer || !pSrcData) {
+		ERROR("DeviceContext", "UpdateConstantBuffer", "pBuffer or pSrcData is nullptr");
+		return false;
+	}
+	if (m_skipUnchangedUploads) {
+		bool inserted = false;
+		if (!m_uploadTracker.check(pBuffer, hashBlock(pSrcData, ByteWidth), inserted)) {
+			++m_uploads.skipped;
+			m_uploads.skippedBytes += ByteWidth;
+			return false;
+		}
+		// Retenido mientras se sigue: si su dueo lo libera, la direccin no se reutiliza con el hash viejo.
+		if (inserted) {
+			pBuffer->AddRef();
+		}
+	}
+	getBackend().UpdateSubresource(pBuffer, 0, nullptr, pSrcData, 0, 0, ByteWidth);
+	++m_uploads.updates;
+	m_uploads.updateBytes += ByteWidth;
+	return true;
+}
+
+void
+DeviceContext::forgetConstantBuffers(const std::vector<ID3D11Buffer*>& buffers) {
+	for (ID3D11Buffer* buffer : buffers) {
+		if (m_uploadTracker.forget(buffer)) {
+			m_released.push_back(buffer);
+		}
+	}
+	releaseUntracked();
+}
+
+void
+DeviceContext::recordRingWrites(unsigned int writes, unsigned int bytes) {
+	++m_uploads.ringMaps;
+	m_uploads.ringWrites += writes;
+	m_uploads.ringBytes += bytes;
+}
+
+void
+DeviceContext::invalidateState() {
+	m_stateCache.invalidate();
+}
+
+void
+DeviceContext::ClearState() {
+	getBackend().ClearState();
+	m_stateCache.invalidate();
 }
 
 void
@@ -17,7 +156,7 @@ DeviceContext::RSSetViewports(unsigned int NumViewports,
 		ERROR("DeviceContext", "RSSetViewports", "pViewports is nullptr");
 		return;
 	}
-	m_deviceContext->RSSetViewports(NumViewports, pViewports);
+	getBackend().RSSetViewports(NumViewports, reinterpret_cast<const BackendViewport*>(pViewports));
 }
 
 void
@@ -28,7 +167,10 @@ DeviceContext::PSSetShaderResources(unsigned int StartSlot,
 		ERROR("DeviceContext", "PSSetShaderResources", "ppShaderResourceViews is nullptr");
 		return;
 	}
-	m_deviceContext->PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
+	if (!m_stateCache.setPSShaderResources(StartSlot, NumViews, ppShaderResourceViews)) {
+		return;
+	}
+	getBackend().PSSetShaderResources(StartSlot, NumViews, ppShaderResourceViews);
 }
 
 void
@@ -37,7 +179,10 @@ DeviceContext::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
 		ERROR("DeviceContext", "IASetInputLayout", "pInputLayout is nullptr");
 		return;
 	}
-	m_deviceContext->IASetInputLayout(pInputLayout);
+	if (!m_stateCache.setInputLayout(pInputLayout)) {
+		return;
+	}
+	getBackend().IASetInputLayout(pInputLayout);
 }
 
 void
@@ -48,7 +193,14 @@ DeviceContext::VSSetShader(ID3D11VertexShader* pVertexShader,
 		ERROR("DeviceContext", "VSSetShader", "pVertexShader is nullptr");
 		return;
 	}
-	m_deviceContext->VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
+	// Las instancias de clase no se siguen: esa llamada se enva siempre y el shader deja de ser conocido.
+	if (NumClassInstances != 0) {
+		m_stateCache.invalidateVertexShader();
+	}
+	else if (!m_stateCache.setVertexShader(pVertexShader)) {
+		return;
+	}
+	getBackend().VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
 }
 
 void
@@ -59,7 +211,13 @@ DeviceContext::PSSetShader(ID3D11PixelShader* pPixelShader,
 		ERROR("DeviceContext", "PSSetShader", "pPixelShader is nullptr");
 		return;
 	}
-	m_deviceContext->PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
+	if (NumClassInstances != 0) {
+		m_stateCache.invalidatePixelShader();
+	}
+	else if (!m_stateCache.setPixelShader(pPixelShader)) {
+		return;
+	}
+	getBackend().PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
 }
 
 void
@@ -68,18 +226,60 @@ DeviceContext::UpdateSubresource(ID3D11Resource* pDstResource,
 	const D3D11_BOX* pDstBox,
 	const void* pSrcData,
 	unsigned int SrcRowPitch,
-	unsigned int SrcDepthPitch) {
+	unsigned int SrcDepthPitch,
+	unsigned int SrcBytes) {
 	if (!pDstResource || !pSrcData) {
 		ERROR("DeviceContext", "UpdateSubresource",
 			"Invalid arguments: pDstResource or pSrcData is nullptr");
 		return;
 	}
-	m_deviceContext->UpdateSubresource(pDstResource,
+	getBackend().UpdateSubresource(pDstResource,
 		DstSubresource,
-		pDstBox,
+		reinterpret_cast<const BackendBox*>(pDstBox),
 		pSrcData,
 		SrcRowPitch,
-		SrcDepthPitch);
+		SrcDepthPitch,
+		SrcBytes);
+}
+
+HRESULT
+DeviceContext::Map(ID3D11Resource* pResource,
+	unsigned int Subresource,
+	D3D11_MAP MapType,
+	unsigned int MapFlags,
+	D3D11_MAPPED_SUBRESOURCE* pMappedResource) {
+	if (!pResource || !pMappedResource) {
+		ERROR("DeviceContext", "Map", "pResource or pMappedResource is nullptr");
+		return E_POINTER;
+	}
+	return getBackend().Map(pResource, Subresource, MapType, MapFlags,
+		reinterpret_cast<BackendMappedSubresource*>(pMappedResource));
+}
+
+void
+DeviceContext::Unmap(ID3D11Resource* pResource, unsigned int Subresource) {
+	if (!pResource) {
+		ERROR("DeviceContext", "Unmap", "pResource is nullptr");
+		return;
+	}
+	getBackend().Unmap(pResource, Subresource);
+}
+
+void
+DeviceContext::CopySubresourceRegion(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	unsigned int DstX,
+	unsigned int DstY,
+	unsigned int DstZ,
+	ID3D11Resource* pSrcResource,
+	unsigned int SrcSubresource,
+	const D3D11_BOX* pSrcBox) {
+	if (!pDstResource || !pSrcResource) {
+		ERROR("DeviceContext", "CopySubresourceRegion", "pDstResource or pSrcResource is nullptr");
+		return;
+	}
+	getBackend().CopySubresourceRegion(pDstResource, DstSubresource, DstX, DstY, DstZ,
+		pSrcResource, SrcSubresource, reinterpret_cast<const BackendBox*>(pSrcBox));
 }
 
 void
@@ -93,7 +293,10 @@ DeviceContext::IASetVertexBuffers(unsigned int StartSlot,
 			"Invalid arguments: ppVertexBuffers, pStrides, or pOffsets is nullptr");
 		return;
 	}
-	m_deviceContext->IASetVertexBuffers(StartSlot,
+	if (!m_stateCache.setVertexBuffers(StartSlot, NumBuffers, ppVertexBuffers, pStrides, pOffsets)) {
+		return;
+	}
+	getBackend().IASetVertexBuffers(StartSlot,
 		NumBuffers,
 		ppVertexBuffers,
 		pStrides,
@@ -108,7 +311,10 @@ DeviceContext::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
 		ERROR("DeviceContext", "IASetIndexBuffer", "pIndexBuffer is nullptr");
 		return;
 	}
-	m_deviceContext->IASetIndexBuffer(pIndexBuffer, Format, Offset);
+	if (!m_stateCache.setIndexBuffer(pIndexBuffer, static_cast<unsigned int>(Format), Offset)) {
+		return;
+	}
+	getBackend().IASetIndexBuffer(pIndexBuffer, Format, Offset);
 }
 
 void
@@ -119,7 +325,10 @@ DeviceContext::PSSetSamplers(unsigned int StartSlot,
 		ERROR("DeviceContext", "PSSetSamplers", "ppSamplers is nullptr");
 		return;
 	}
-	m_deviceContext->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
+	if (!m_stateCache.setPSSamplers(StartSlot, NumSamplers, ppSamplers)) {
+		return;
+	}
+	getBackend().PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
 }
 
 void
@@ -128,18 +337,31 @@ DeviceContext::RSSetState(ID3D11RasterizerState* pRasterizerState) {
 		ERROR("DeviceContext", "RSSetState", "pRasterizerState is nullptr");
 		return;
 	}
-	m_deviceContext->RSSetState(pRasterizerState);
+	if (!m_stateCache.setRasterizerState(pRasterizerState)) {
+		return;
+	}
+	getBackend().RSSetState(pRasterizerState);
 }
 
 void
 DeviceContext::OMSetBlendState(ID3D11BlendState* pBlendState,
 	const float BlendFactor[4],
 	unsigned int SampleMask) {
-	if (!pBlendState) {
-		ERROR("DeviceContext", "OMSetBlendState", "pBlendState is nullptr");
+	// nullptr es vlido: restablece el estado por defecto.
+	if (!m_stateCache.setBlendState(pBlendState, BlendFactor, SampleMask)) {
 		return;
 	}
-	m_deviceContext->OMSetBlendState(pBlendState, BlendFactor, SampleMask);
+	getBackend().OMSetBlendState(pBlendState, BlendFactor, SampleMask);
+}
+
+void
+DeviceContext::OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+	unsigned int StencilRef) {
+	// nullptr es vlido: restablece el estado por defecto.
+	if (!m_stateCache.setDepthStencilState(pDepthStencilState, StencilRef)) {
+		return;
+	}
+	getBackend().OMSetDepthStencilState(pDepthStencilState, StencilRef);
 }
 
 void
@@ -159,8 +381,9 @@ DeviceContext::OMSetRenderTargets(unsigned int NumViews,
 		return;
 	}
 
-	// Asignar los render targets y el depth stencil
-	m_deviceContext->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
+	// Asignar los render targets y el depth stencil (D3D desenlaza las texturas que pasen a ser target)
+	m_stateCache.invalidateShaderResources();
+	getBackend().OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
 }
 
 void
@@ -173,7 +396,10 @@ DeviceContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology) {
 	}
 
 	// Asignar la topologa al Input Assembler
-	m_deviceContext->IASetPrimitiveTopology(Topology);
+	if (!m_stateCache.setTopology(static_cast<unsigned int>(Topology))) {
+		return;
+	}
+	getBackend().IASetPrimitiveTopology(Topology);
 }
 
 void
@@ -190,7 +416,7 @@ DeviceContext::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
 	}
 
 	// Limpiar el render target
-	m_deviceContext->ClearRenderTargetView(pRenderTargetView, ColorRGBA);
+	getBackend().ClearRenderTargetView(pRenderTargetView, ColorRGBA);
 }
 
 void
@@ -213,7 +439,7 @@ DeviceContext::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
 	}
 
 	// Limpiar el depth stencil
-	m_deviceContext->ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
+	getBackend().ClearDepthStencilView(pDepthStencilView, ClearFlags, Depth, Stencil);
 }
 
 void
@@ -227,7 +453,10 @@ DeviceContext::VSSetConstantBuffers(unsigned int StartSlot,
 	}
 
 	// Asignar los constant buffers al vertex shader
-	m_deviceContext->VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+	if (!m_stateCache.setVSConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers)) {
+		return;
+	}
+	getBackend().VSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
 }
 
 void
@@ -241,7 +470,77 @@ DeviceContext::PSSetConstantBuffers(unsigned int StartSlot,
 	}
 
 	// Asignar los constant buffers al pixel shader
-	m_deviceContext->PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+	if (!m_stateCache.setPSConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers)) {
+		return;
+	}
+	getBackend().PSSetConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers);
+}
+
+void
+DeviceContext::VSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+	if (!ppConstantBuffers || !pFirstConstant || !pNumConstants) {
+		ERROR("DeviceContext", "VSSetConstantBuffers1", "ppConstantBuffers or constant ranges are nullptr");
+		return;
+	}
+	if (!supportsConstantOffsets()) {
+		ERROR("DeviceContext", "VSSetConstantBuffers1", "Constant buffer offsets are not enabled");
+		return;
+	}
+	if (!m_stateCache.setVSConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants)) {
+		return;
+	}
+	getBackend().VSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+}
+
+void
+DeviceContext::PSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+	if (!ppConstantBuffers || !pFirstConstant || !pNumConstants) {
+		ERROR("DeviceContext", "PSSetConstantBuffers1", "ppConstantBuffers or constant ranges are nullptr");
+		return;
+	}
+	if (!supportsConstantOffsets()) {
+		ERROR("DeviceContext", "PSSetConstantBuffers1", "Constant buffer offsets are not enabled");
+		return;
+	}
+	if (!m_stateCache.setPSConstantBuffers(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants)) {
+		return;
+	}
+	getBackend().PSSetConstantBuffers1(StartSlot, NumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+}
+
+HRESULT
+DeviceContext::FinishCommandList(bool RestoreDeferredContextState,
+	ID3D11CommandList** ppCommandList) {
+	if (!ppCommandList) {
+		ERROR("DeviceContext", "FinishCommandList", "ppCommandList is nullptr");
+		return E_POINTER;
+	}
+	HRESULT hr = getBackend().FinishCommandList(RestoreDeferredContextState, ppCommandList);
+	if (!RestoreDeferredContextState) {
+		m_stateCache.invalidate();
+	}
+	return hr;
+}
+
+void
+DeviceContext::ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) {
+	if (!pCommandList) {
+		ERROR("DeviceContext", "ExecuteCommandList", "pCommandList is nullptr");
+		return;
+	}
+	getBackend().ExecuteCommandList(pCommandList, RestoreContextState);
+	if (!RestoreContextState) {
+		// El contexto queda en el estado por defecto: lo conocido ya no vale.
+		m_stateCache.invalidate();
+	}
 }
 
 void
@@ -255,5 +554,23 @@ DeviceContext::DrawIndexed(unsigned int IndexCount,
 	}
 
 	// Ejecutar el dibujo
-	m_deviceContext->DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+	getBackend().DrawIndexed(IndexCount, StartIndexLocation, BaseVertexLocation);
+}
+
+void
+DeviceContext::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+	unsigned int InstanceCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation,
+	unsigned int StartInstanceLocation) {
+	if (IndexCountPerInstance == 0 || InstanceCount == 0) {
+		ERROR("DeviceContext", "DrawIndexedInstanced", "IndexCountPerInstance or InstanceCount is zero");
+		return;
+	}
+
+	getBackend().DrawIndexedInstanced(IndexCountPerInstance,
+		InstanceCount,
+		StartIndexLocation,
+		BaseVertexLocation,
+		StartInstanceLocation);
 }
@@ -0,0 +1,732 @@
+﻿/**
+ * @file DynamicAABBTree.cpp
+ * @brief Implementación del árbol dinámico de AABB: inserción SAH, rotaciones, reajuste y consultas.
+ */
+
+#include "DynamicAABBTree.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+	/// Fracción de proxies reinsertados a partir de la cual sale más barato reajustar todo el árbol.
+	const float kRefitFraction = 0.25f;
+
+	/// Multiplicador del desplazamiento previsto al ampliar una hoja.
+	const float kDisplacementMultiplier = 4.0f;
+
+	/**
+	 * @brief Pila de recorrido con almacenamiento local; solo reserva memoria en árboles muy desequilibrados.
+	 */
+	class TraversalStack {
+	public:
+		void push(int node) {
+			if (m_count < kLocalSize) {
+				m_local[m_count++] = node;
+			}
+			else {
+				m_overflow.push_back(node);
+			}
+		}
+		int pop() {
+			if (!m_overflow.empty()) {
+				const int node = m_overflow.back();
+				m_overflow.pop_back();
+				return node;
+			}
+			return m_local[--m_count];
+		}
+		bool empty() const { return m_count == 0 && m_overflow.empty(); }
+
+	private:
+		static const int kLocalSize = 256;
+		int m_local[kLocalSize];
+		int m_count = 0;
+		std::vector<int> m_overflow;
+	};
+
+	/// Distancia de entrada del rayo en la caja (slab test); < 0 si no la cruza dentro de [0, maxDistance].
+	float
+	rayBoxEntry(const XMFLOAT3& origin, const XMFLOAT3& inverse, const AABB& box, float maxDistance) {
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+		const float o[3] = { origin.x, origin.y, origin.z };
+		const float inv[3] = { inverse.x, inverse.y, inverse.z };
+		const float lo[3] = { box.minimum.x, box.minimum.y, box.minimum.z };
+		const float hi[3] = { box.maximum.x, box.maximum.y, box.maximum.z };
+		for (int axis = 0; axis < 3; ++axis) {
+			float t0 = (lo[axis] - o[axis]) * inv[axis];
+			float t1 = (hi[axis] - o[axis]) * inv[axis];
+			if (t0 > t1) {
+				std::swap(t0, t1);
+			}
+			// Los NaN (rayo paralelo sobre el plano de la caja) no recortan el intervalo.
+			tMin = t0 > tMin ? t0 : tMin;
+			tMax = t1 < tMax ? t1 : tMax;
+			if (tMin > tMax) {
+				return -1.0f;
+			}
+		}
+		return tMin;
+	}
+
+	/// Distancia al cuadrado de un punto a una caja.
+	float
+	pointBoxDistanceSq(const XMFLOAT3& point, const AABB& box) {
+		const float dx = std::max(std::max(box.minimum.x - point.x, 0.0f), point.x - box.maximum.x);
+		const float dy = std::max(std::max(box.minimum.y - point.y, 0.0f), point.y - box.maximum.y);
+		const float dz = std::max(std::max(box.minimum.z - point.z, 0.0f), point.z - box.maximum.z);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	/// Resultado de probar una caja contra el frustum.
+	enum FrustumTest {
+		FRUSTUM_OUTSIDE,
+		FRUSTUM_INTERSECT,
+		FRUSTUM_INSIDE
+	};
+
+	FrustumTest
+	boxFrustum(const Frustum& frustum, const AABB& box) {
+		const float cx = 0.5f * (box.minimum.x + box.maximum.x);
+		const float cy = 0.5f * (box.minimum.y + box.maximum.y);
+		const float cz = 0.5f * (box.minimum.z + box.maximum.z);
+		const float ex = 0.5f * (box.maximum.x - box.minimum.x);
+		const float ey = 0.5f * (box.maximum.y - box.minimum.y);
+		const float ez = 0.5f * (box.maximum.z - box.minimum.z);
+		FrustumTest result = FRUSTUM_INSIDE;
+		for (int p = 0; p < 6; ++p) {
+			const XMFLOAT4& plane = frustum.planes[p];
+			const float distance = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+			const float radius = std::fabs(plane.x) * ex + std::fabs(plane.y) * ey + std::fabs(plane.z) * ez;
+			if (distance + radius < 0.0f) {
+				return FRUSTUM_OUTSIDE;
+			}
+			if (distance - radius < 0.0f) {
+				result = FRUSTUM_INTERSECT;
+			}
+		}
+		return result;
+	}
+}
+
+int
+DynamicAABBTree::allocateNode() {
+	if (m_freeList == kNullNode) {
+		m_nodes.push_back(Node());
+		return static_cast<int>(m_nodes.size()) - 1;
+	}
+	const int node = m_freeList;
+	m_freeList = m_nodes[node].parent;
+	m_nodes[node] = Node();
+	return node;
+}
+
+void
+DynamicAABBTree::freeNode(int node) {
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].child1 = kNullNode;
+	m_nodes[node].child2 = kNullNode;
+	m_nodes[node].height = -1;
+	m_freeList = node;
+}
+
+AABB
+DynamicAABBTree::fatten(const AABB& aabb, const XMFLOAT3& displacement) const {
+	AABB fat;
+	fat.minimum = XMFLOAT3(aabb.minimum.x - m_margin, aabb.minimum.y - m_margin, aabb.minimum.z - m_margin);
+	fat.maximum = XMFLOAT3(aabb.maximum.x + m_margin, aabb.maximum.y + m_margin, aabb.maximum.z + m_margin);
+	// Se alarga solo en la dirección del movimiento: la caja aguanta varios frames sin reinsertar.
+	const float d[3] = { kDisplacementMultiplier * displacement.x,
+		kDisplacementMultiplier * displacement.y, kDisplacementMultiplier * displacement.z };
+	float* lo[3] = { &fat.minimum.x, &fat.minimum.y, &fat.minimum.z };
+	float* hi[3] = { &fat.maximum.x, &fat.maximum.y, &fat.maximum.z };
+	for (int axis = 0; axis < 3; ++axis) {
+		if (d[axis] < 0.0f) {
+			*lo[axis] += d[axis];
+		}
+		else {
+			*hi[axis] += d[axis];
+		}
+	}
+	return fat;
+}
+
+int
+DynamicAABBTree::createProxy(const AABB& aabb, unsigned int userData) {
+	const int proxy = allocateNode();
+	m_nodes[proxy].aabb = fatten(aabb, XMFLOAT3(0.0f, 0.0f, 0.0f));
+	m_nodes[proxy].userData = userData;
+	m_nodes[proxy].height = 0;
+	insertLeaf(proxy);
+	++m_proxyCount;
+	return proxy;
+}
+
+void
+DynamicAABBTree::destroyProxy(int proxy) {
+	removeLeaf(proxy);
+	freeNode(proxy);
+	--m_proxyCount;
+}
+
+bool
+DynamicAABBTree::moveProxy(int proxy, const AABB& aabb, const XMFLOAT3& displacement) {
+	if (m_nodes[proxy].aabb.contains(aabb)) {
+		return false;
+	}
+	removeLeaf(proxy);
+	m_nodes[proxy].aabb = fatten(aabb, displacement);
+	insertLeaf(proxy);
+	return true;
+}
+
+void
+DynamicAABBTree::updateProxies(const std::vector<ProxyUpdate>& updates, DynamicTreeStats* stats) {
+	const auto start = std::chrono::steady_clock::now();
+
+	unsigned int escaped = 0;
+	for (const ProxyUpdate& update : updates) {
+		if (!m_nodes[update.proxy].aabb.contains(update.aabb)) {
+			++escaped;
+		}
+	}
+
+	const bool refit = escaped > kRefitFraction * m_proxyCount;
+	if (refit) {
+		// Muchos cambios: se actualizan las hojas y los nodos internos se reajustan en una pasada,
+		// sin cambiar la topología (las reinserciones posteriores la vuelven a equilibrar).
+		for (const ProxyUpdate& update : updates) {
+			Node& leaf = m_nodes[update.proxy];
+			if (!leaf.aabb.contains(update.aabb)) {
+				leaf.aabb = fatten(update.aabb, update.displacement);
+			}
+		}
+		refitAll();
+	}
+	else if (escaped > 0) {
+		for (const ProxyUpdate& update : updates) {
+			moveProxy(update.proxy, update.aabb, update.displacement);
+		}
+	}
+
+	if (stats) {
+		stats->proxies = m_proxyCount;
+		stats->height = getHeight();
+		stats->areaRatio = getAreaRatio();
+		stats->moved = static_cast<unsigned int>(updates.size());
+		stats->reinserted = escaped;
+		stats->refitted = refit;
+		stats->updateMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void
+DynamicAABBTree::insertLeaf(int leaf) {
+	if (m_root == kNullNode) {
+		m_root = leaf;
+		m_nodes[leaf].parent = kNullNode;
+		return;
+	}
+
+	// Descenso por el hijo de menor coste SAH: área del nuevo padre más lo que crecen los ancestros.
+	const AABB leafAABB = m_nodes[leaf].aabb;
+	int index = m_root;
+	while (!m_nodes[index].isLeaf()) {
+		const Node& node = m_nodes[index];
+		const float area = node.aabb.getSurfaceArea();
+		const float combinedArea = AABB::combine(node.aabb, leafAABB).getSurfaceArea();
+
+		// Coste de colgar la hoja aquí como hermana de este nodo.
+		const float cost = 2.0f * combinedArea;
+		// Coste mínimo de bajar: todos los ancestros crecen.
+		const float inheritance = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		const int children[2] = { node.child1, node.child2 };
+		for (int c = 0; c < 2; ++c) {
+			const Node& child = m_nodes[children[c]];
+			const float grown = AABB::combine(leafAABB, child.aabb).getSurfaceArea();
+			childCost[c] = (child.isLeaf() ? grown : grown - child.aabb.getSurfaceArea()) + inheritance;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1]) {
+			break;
+		}
+		index = childCost[0] < childCost[1] ? node.child1 : node.child2;
+	}
+
+	const int sibling = index;
+	const int oldParent = m_nodes[sibling].parent;
+	const int newParent = allocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].aabb = AABB::combine(leafAABB, m_nodes[sibling].aabb);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != kNullNode) {
+		if (m_nodes[oldParent].child1 == sibling) {
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else {
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else {
+		m_root = newParent;
+	}
+
+	// Subida: rotaciones y reajuste de cajas y alturas.
+	index = m_nodes[leaf].parent;
+	while (index != kNullNode) {
+		index = balance(index);
+		Node& node = m_nodes[index];
+		node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+		node.aabb = AABB::combine(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+		index = node.parent;
+	}
+}
+
+void
+DynamicAABBTree::removeLeaf(int leaf) {
+	if (leaf == m_root) {
+		m_root = kNullNode;
+		return;
+	}
+
+	const int parent = m_nodes[leaf].parent;
+	const int grandParent = m_nodes[parent].parent;
+	const int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	if (grandParent == kNullNode) {
+		m_root = sibling;
+		m_nodes[sibling].parent = kNullNode;
+		freeNode(parent);
+		return;
+	}
+
+	// El hermano ocupa el lugar del padre.
+	if (m_nodes[grandParent].child1 == parent) {
+		m_nodes[grandParent].child1 = sibling;
+	}
+	else {
+		m_nodes[grandParent].child2 = sibling;
+	}
+	m_nodes[sibling].parent = grandParent;
+	freeNode(parent);
+
+	int index = grandParent;
+	while (index != kNullNode) {
+		index = balance(index);
+		Node& node = m_nodes[index];
+		node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+		node.aabb = AABB::combine(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+		index = node.parent;
+	}
+}
+
+int
+DynamicAABBTree::balance(int iA) {
+	Node& A = m_nodes[iA];
+	if (A.isLeaf() || A.height < 2) {
+		return iA;
+	}
+
+	const int iB = A.child1;
+	const int iC = A.child2;
+	const int heightDelta = m_nodes[iC].height - m_nodes[iB].height;
+	if (heightDelta >= -1 && heightDelta <= 1) {
+		return iA;
+	}
+
+	// Rotación: el hijo más alto (P) sube al lugar de A y A adopta uno de los nietos de P,
+	// el de menor altura se queda con P.
+	const int iP = heightDelta > 1 ? iC : iB;   // hijo que sube
+	const int iQ = heightDelta > 1 ? iB : iC;   // hijo que se queda bajo A
+	Node& P = m_nodes[iP];
+	const int iF = P.child1;
+	const int iG = P.child2;
+
+	// P sustituye a A.
+	P.child1 = iA;
+	P.parent = A.parent;
+	A.parent = iP;
+	if (P.parent != kNullNode) {
+		if (m_nodes[P.parent].child1 == iA) {
+			m_nodes[P.parent].child1 = iP;
+		}
+		else {
+			m_nodes[P.parent].child2 = iP;
+		}
+	}
+	else {
+		m_root = iP;
+	}
+
+	// El nieto más alto se queda con P; el otro pasa a A en el sitio que ocupaba P.
+	const bool keepF = m_nodes[iF].height > m_nodes[iG].height;
+	const int iKeep = keepF ? iF : iG;
+	const int iMove = keepF ? iG : iF;
+	P.child2 = iKeep;
+	if (heightDelta > 1) {
+		A.child2 = iMove;
+	}
+	else {
+		A.child1 = iMove;
+	}
+	m_nodes[iMove].parent = iA;
+
+	A.aabb = AABB::combine(m_nodes[iQ].aabb, m_nodes[iMove].aabb);
+	A.height = 1 + std::max(m_nodes[iQ].height, m_nodes[iMove].height);
+	P.aabb = AABB::combine(A.aabb, m_nodes[iKeep].aabb);
+	P.height = 1 + std::max(A.height, m_nodes[iKeep].height);
+	return iP;
+}
+
+void
+DynamicAABBTree::refitAll() {
+	if (m_root == kNullNode) {
+		return;
+	}
+	// Post-orden iterativo: cada nodo interno se recalcula después de sus dos hijos.
+	std::vector<int> order;
+	order.reserve(m_nodes.size());
+	TraversalStack stack;
+	stack.push(m_root);
+	while (!stack.empty()) {
+		const int index = stack.pop();
+		const Node& node = m_nodes[index];
+		if (node.isLeaf()) {
+			continue;
+		}
+		order.push_back(index);
+		stack.push(node.child1);
+		stack.push(node.child2);
+	}
+	// En preorden el padre precede a sus hijos: recorrer al revés deja los hijos primero.
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		Node& node = m_nodes[*it];
+		node.aabb = AABB::combine(m_nodes[node.child1].aabb, m_nodes[node.child2].aabb);
+	}
+}
+
+void
+DynamicAABBTree::queryAABB(const AABB& aabb, const QueryCallback& callback) const {
+	if (m_root == kNullNode) {
+		return;
+	}
+	TraversalStack stack;
+	stack.push(m_root);
+	while (!stack.empty()) {
+		const Node& node = m_nodes[stack.pop()];
+		if (!node.aabb.overlaps(aabb)) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			if (!callback(node.userData)) {
+				return;
+			}
+		}
+		else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+void
+DynamicAABBTree::queryAABB(const AABB& aabb, std::vector<unsigned int>& results) const {
+	if (m_root == kNullNode) {
+		return;
+	}
+	TraversalStack stack;
+	stack.push(m_root);
+	while (!stack.empty()) {
+		const Node& node = m_nodes[stack.pop()];
+		if (!node.aabb.overlaps(aabb)) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			results.push_back(node.userData);
+		}
+		else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+void
+DynamicAABBTree::querySphere(const XMFLOAT3& center, float radius, const QueryCallback& callback) const {
+	if (m_root == kNullNode) {
+		return;
+	}
+	const float radiusSq = radius * radius;
+	TraversalStack stack;
+	stack.push(m_root);
+	while (!stack.empty()) {
+		const Node& node = m_nodes[stack.pop()];
+		if (pointBoxDistanceSq(center, node.aabb) > radiusSq) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			if (!callback(node.userData)) {
+				return;
+			}
+		}
+		else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+void
+DynamicAABBTree::querySphere(const XMFLOAT3& center, float radius, std::vector<unsigned int>& results) const {
+	querySphere(center, radius, [&results](unsigned int userData) {
+		results.push_back(userData);
+		return true;
+	});
+}
+
+void
+DynamicAABBTree::queryFrustum(const Frustum& frustum, const QueryCallback& callback) const {
+	if (m_root == kNullNode) {
+		return;
+	}
+	// Cada entrada lleva en el bit alto si su subárbol ya está por completo dentro.
+	const int kInsideBit = 1 << 30;
+	TraversalStack stack;
+	stack.push(m_root);
+	while (!stack.empty()) {
+		const int entry = stack.pop();
+		const bool inside = (entry & kInsideBit) != 0;
+		const Node& node = m_nodes[entry & ~kInsideBit];
+		FrustumTest test = FRUSTUM_INSIDE;
+		if (!inside) {
+			test = boxFrustum(frustum, node.aabb);
+			if (test == FRUSTUM_OUTSIDE) {
+				continue;
+			}
+		}
+		if (node.isLeaf()) {
+			if (!callback(node.userData)) {
+				return;
+			}
+		}
+		else {
+			const int flag = test == FRUSTUM_INSIDE ? kInsideBit : 0;
+			stack.push(node.child1 | flag);
+			stack.push(node.child2 | flag);
+		}
+	}
+}
+
+void
+DynamicAABBTree::queryFrustum(const Frustum& frustum, std::vector<unsigned int>& results) const {
+	queryFrustum(frustum, [&results](unsigned int userData) {
+		results.push_back(userData);
+		return true;
+	});
+}
+
+void
+DynamicAABBTree::raycast(const XMFLOAT3& origin,
+	const XMFLOAT3& direction,
+	float maxDistance,
+	const RayCallback& callback) const {
+	if (m_root == kNullNode) {
+		return;
+	}
+	const XMFLOAT3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	TraversalStack stack;
+	stack.push(m_root);
+	while (!stack.empty()) {
+		const Node& node = m_nodes[stack.pop()];
+		const float entry = rayBoxEntry(origin, inverse, node.aabb, maxDistance);
+		if (entry < 0.0f) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			maxDistance = callback(node.userData, entry);
+			if (maxDistance <= 0.0f) {
+				return;
+			}
+		}
+		else {
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
+
+void
+DynamicAABBTree::raycast(const XMFLOAT3& origin,
+	const XMFLOAT3& direction,
+	float maxDistance,
+	std::vector<RayHit>& hits) const {
+	const size_t first = hits.size();
+	raycast(origin, direction, maxDistance, [&hits, maxDistance](unsigned int userData, float distance) {
+		RayHit hit;
+		hit.userData = userData;
+		hit.distance = distance;
+		hits.push_back(hit);
+		return maxDistance;
+	});
+	std::sort(hits.begin() + first, hits.end(), [](const RayHit& a, const RayHit& b) {
+		return a.distance < b.distance;
+	});
+}
+
+void
+DynamicAABBTree::queryAABBBatch(const std::vector<AABB>& boxes,
+	std::vector<std::vector<unsigned int>>& results,
+	JobSystem* jobs) const {
+	results.resize(boxes.size());
+	auto run = [this, &boxes, &results](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			results[i].clear();
+			queryAABB(boxes[i], results[i]);
+		}
+	};
+	const unsigned int count = static_cast<unsigned int>(boxes.size());
+	if (!jobs || jobs->getThreadCount() == 0) {
+		run(0, count);
+	}
+	else {
+		jobs->parallelFor(count, 64, run);
+	}
+}
+
+unsigned int
+DynamicAABBTree::getHeight() const {
+	return m_root == kNullNode ? 0u : static_cast<unsigned int>(m_nodes[m_root].height);
+}
+
+float
+DynamicAABBTree::getAreaRatio() const {
+	if (m_root == kNullNode) {
+		return 0.0f;
+	}
+	const float rootArea = m_nodes[m_root].aabb.getSurfaceArea();
+	if (rootArea <= 0.0f) {
+		return 0.0f;
+	}
+	float total = 0.0f;
+	for (const Node& node : m_nodes) {
+		if (node.height > 0) {
+			total += node.aabb.getSurfaceArea();
+		}
+	}
+	return total / rootArea;
+}
+
+void
+DynamicAABBTree::clear() {
+	m_nodes.clear();
+	m_root = kNullNode;
+	m_freeList = kNullNode;
+	m_proxyCount = 0;
+}
+
+DynamicTreeBenchmark
+DynamicAABBTree::benchmark(unsigned int count, JobSystem* jobs) {
+	DynamicTreeBenchmark result;
+	result.count = count;
+	result.frames = 30;
+
+	uint32_t state = 0x2545F491u;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return float(state >> 8) / 16777216.0f;
+	};
+
+	// Cajas de 1 a 3 unidades en un área de 1000 x 1000, cada una con su velocidad.
+	std::vector<MeshBounds> bounds(count);
+	std::vector<XMFLOAT3> velocity(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		bounds[i].center = XMFLOAT3(next() * 1000.0f - 500.0f, next() * 20.0f, next() * 1000.0f - 500.0f);
+		bounds[i].extents = XMFLOAT3(0.5f + next(), 0.5f + next(), 0.5f + next());
+		bounds[i].sphere = XMFLOAT4(bounds[i].center.x, bounds[i].center.y, bounds[i].center.z, 3.0f);
+		velocity[i] = XMFLOAT3(next() * 0.4f - 0.2f, 0.0f, next() * 0.4f - 0.2f);
+	}
+
+	DynamicAABBTree tree;
+	std::vector<int> proxies(count);
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < count; ++i) {
+		proxies[i] = tree.createProxy(AABB::fromBounds(bounds[i]), i);
+	}
+	result.insertMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Todos los objetos se mueven cada frame.
+	std::vector<ProxyUpdate> updates(count);
+	double reinserted = 0.0;
+	for (unsigned int frame = 0; frame < result.frames; ++frame) {
+		for (unsigned int i = 0; i < count; ++i) {
+			bounds[i].center.x += velocity[i].x;
+			bounds[i].center.z += velocity[i].z;
+			updates[i].proxy = proxies[i];
+			updates[i].aabb = AABB::fromBounds(bounds[i]);
+			updates[i].displacement = velocity[i];
+		}
+		DynamicTreeStats stats;
+		tree.updateProxies(updates, &stats);
+		result.updateMs += stats.updateMs;
+		reinserted += stats.reinserted;
+	}
+	result.updateMs /= result.frames;
+	result.reinsertedPerFrame = reinserted / result.frames;
+	result.height = tree.getHeight();
+
+	// Consultas de caja de 10 unidades.
+	result.queries = 10000;
+	std::vector<AABB> boxes(result.queries);
+	for (AABB& box : boxes) {
+		const float x = next() * 1000.0f - 500.0f, z = next() * 1000.0f - 500.0f;
+		box.minimum = XMFLOAT3(x - 5.0f, 0.0f, z - 5.0f);
+		box.maximum = XMFLOAT3(x + 5.0f, 20.0f, z + 5.0f);
+	}
+	std::vector<unsigned int> hits;
+	start = std::chrono::steady_clock::now();
+	for (const AABB& box : boxes) {
+		hits.clear();
+		tree.queryAABB(box, hits);
+	}
+	result.queryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<std::vector<unsigned int>> batchResults;
+	start = std::chrono::steady_clock::now();
+	tree.queryAABBBatch(boxes, batchResults, jobs);
+	result.batchQueryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Rayos horizontales desde el borde hacia el interior, detenidos en el primer impacto.
+	result.rays = 1000;
+	start = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < result.rays; ++r) {
+		const XMFLOAT3 origin(-500.0f, next() * 20.0f, next() * 1000.0f - 500.0f);
+		const XMFLOAT3 direction(1.0f, 0.0f, next() * 0.2f - 0.1f);
+		float closest = 1000.0f;
+		tree.raycast(origin, direction, closest, [&closest](unsigned int, float distance) {
+			closest = std::min(closest, distance);
+			return closest;
+		});
+	}
+	result.rayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, 0.0f, 1.0f),
+		XMVectorSet(0.0f, 10.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	const Frustum frustum = Frustum::fromMatrix(view * projection);
+	start = std::chrono::steady_clock::now();
+	hits.clear();
+	tree.queryFrustum(frustum, hits);
+	result.frustumMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.frustumHits = static_cast<unsigned int>(hits.size());
+	return result;
+}
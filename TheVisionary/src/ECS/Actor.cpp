@@ -2,6 +2,25 @@
 #include "MeshComponent.h"
 #include "Device.h"
 #include "DeviceContext.h"
+#include "MeshSimplifier.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "GeometryHeap.h"
+#include "Profiler.h"
+
+namespace {
+	/// Constantes de una malla: con posicin snorm16 la decuantizacin (caja de la malla) se antepone a la world.
+	CBChangesEveryFrame
+	meshConstants(const CBChangesEveryFrame& cb, const MeshComponent& mesh) {
+		CBChangesEveryFrame local = cb;
+		if (mesh.m_vertexLayout.position == POSITION_SNORM16) {
+			// cb.mWorld est transpuesta, as que transpose(D * W) = cb.mWorld * transpose(D).
+			local.mWorld = cb.mWorld * XMMatrixTranspose(mesh.m_vertexLayout.getDequantizeMatrix());
+		}
+		return local;
+	}
+}
 
 Actor::Actor(Device& device) {
 	// Setup Default Components
@@ -64,8 +83,51 @@ Actor::Actor(Device& device) {
 	m_LightPos = XMFLOAT4(2.0f, 4.0f, -2.0f, 1.0f);
 }
 
+Actor::Actor(Device& device, const Actor* source) {
+	EU::TSharedPointer<Transform> transform = EU::MakeShared<Transform>();
+	addComponent(transform);
+	EU::TSharedPointer<MeshComponent> meshComponent = EU::MakeShared<MeshComponent>();
+	addComponent(meshComponent);
+
+	// Constantes propias: el dibujo sin instancing las sube por actor.
+	HRESULT hr = m_modelBuffer.init(device, sizeof(CBChangesEveryFrame));
+	if (FAILED(hr)) {
+		ERROR("Actor", "Actor", "Failed to create new CBChangesEveryFrame");
+	}
+	hr = m_shaderBuffer.init(device, sizeof(CBChangesEveryFrame));
+	if (FAILED(hr)) {
+		ERROR("Actor", "Actor", "Failed to initialize Shadow Buffer");
+	}
+	m_LightPos = XMFLOAT4(2.0f, 4.0f, -2.0f, 1.0f);
+	if (!source) {
+		ERROR("Actor", "Actor", "Source actor is null");
+		return;
+	}
+
+	// Mismos objetos de estado que el original: las copias comparten clave de lote.
+	m_blendstate = source->m_blendstate;
+	m_rasterizer = source->m_rasterizer;
+	m_sampler = source->m_sampler;
+	for (IUnknown* shared : { static_cast<IUnknown*>(m_blendstate.raw()),
+		static_cast<IUnknown*>(m_rasterizer.raw()), static_cast<IUnknown*>(m_sampler.m_sampler) }) {
+		if (shared) {
+			shared->AddRef();
+		}
+	}
+	// destroy() no libera los recursos de la sombra, as que se comparten sin referencia propia.
+	m_shaderShadow = source->m_shaderShadow;
+	m_shadowBlendState = source->m_shadowBlendState;
+	m_shadowDepthStencilState = source->m_shadowDepthStencilState;
+	m_LightPos = source->m_LightPos;
+	castShadow = source->castShadow;
+	m_receiveShadow = source->m_receiveShadow;
+	m_name = source->m_name;
+	shareResources(*source);
+}
+
 void
-Actor::update(float deltaTime, DeviceContext& deviceContext) {
+Actor::update(float deltaTime) {
+	PROFILE_SCOPE("Actor::update");
 	// Update all components
 	for (auto& component : m_components) {
 		if (component) {
@@ -73,16 +135,24 @@ Actor::update(float deltaTime, DeviceContext& deviceContext) {
 		}
 	}
 
+	updateWorldBounds();
+
 	// Update the model buffer
 	m_model.mWorld = XMMatrixTranspose(getComponent<Transform>()->matrix);
 	m_model.vMeshColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
 
-	// Update the constant buffer
-	m_modelBuffer.update(deviceContext, nullptr, 0, nullptr, &m_model, 0, 0);
+	// Las constantes se suben al dibujar (render() o el envo de la cola): update() puede
+	// correr mientras otro hilo dibuja el frame anterior.
+}
+
+void
+Actor::interpolate(float alpha) {
+	m_model.mWorld = XMMatrixTranspose(getComponent<Transform>()->getInterpolatedMatrix(alpha));
 }
 
 void
 Actor::render(DeviceContext& deviceContext) {
+	PROFILE_SCOPE("Actor::render");
 	// 1) Proyectar sombra primero (sobre el suelo)
 	if (canCastShadow()) {
 		renderShadow(deviceContext);
@@ -95,9 +165,10 @@ Actor::render(DeviceContext& deviceContext) {
 
 	deviceContext.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	// Update buffer and render all components
-	for (unsigned int i = 0; i < m_meshes.size(); i++) {
-		m_vertexBuffers[i].render(deviceContext, 0, 1);
-		m_indexBuffers[i].render(deviceContext, 0, 1, false, DXGI_FORMAT_R32_UINT);
+	m_modelBuffer.update(deviceContext, nullptr, 0, nullptr, &m_model, 0, 0);
+	bool dequantized = false;
+	for (unsigned int i = 0; i < m_meshes->size(); i++) {
+		bindMesh(deviceContext, i, m_model, m_modelBuffer, dequantized);
 		// Bind del CB normal (world + color)
 		m_modelBuffer.render(deviceContext, 2, 1, true);
 
@@ -108,24 +179,305 @@ Actor::render(DeviceContext& deviceContext) {
 			}
 		}
 
-		deviceContext.DrawIndexed(m_meshes[i].m_numIndex, 0, 0);
+		drawMesh(deviceContext, i, true);
+	}
+	if (dequantized) {
+		// El resto de usuarios del CB esperan la world sin cuantizar.
+		m_modelBuffer.update(deviceContext, nullptr, 0, nullptr, &m_model, 0, 0);
+	}
+	if (m_program) {
+		m_program->renderInputLayout(deviceContext, VertexLayout());
 	}
 }
 
 void
-Actor::destroy() {
+Actor::bindMesh(DeviceContext& deviceContext,
+	size_t index,
+	const CBChangesEveryFrame& cb,
+	Buffer& cbBuffer,
+	bool& dequantized) {
+	const MeshComponent& mesh = (*m_meshes)[index];
+	GeometryRange range;
+	if (getGeometry(index, range)) {
+		const unsigned int offset = 0;
+		deviceContext.IASetVertexBuffers(0, 1, &range.vertexBuffer, &range.vertexStride, &offset);
+		deviceContext.IASetIndexBuffer(range.indexBuffer, range.indexFormat, 0);
+	}
+	else {
+		m_vertexBuffers[index].render(deviceContext, 0, 1);
+		m_indexBuffers[index].render(deviceContext, 0, 1, false, VertexCodec::getDXGIFormat(mesh.m_indexFormat));
+	}
+	if (m_program) {
+		m_program->renderInputLayout(deviceContext, mesh.m_vertexLayout);
+	}
+
+	if (mesh.m_vertexLayout.position == POSITION_SNORM16) {
+		const CBChangesEveryFrame local = meshConstants(cb, mesh);
+		cbBuffer.update(deviceContext, nullptr, 0, nullptr, &local, 0, 0);
+		dequantized = true;
+	}
+	else if (dequantized) {
+		cbBuffer.update(deviceContext, nullptr, 0, nullptr, &cb, 0, 0);
+		dequantized = false;
+	}
+}
+
+void
+Actor::drawMesh(DeviceContext& deviceContext, size_t index, bool useMeshlets) {
+	GeometryRange geometry;
+	getGeometry(index, geometry);
+	if (useMeshlets && index < m_meshletCulled.size() && m_meshletCulled[index]) {
+		for (const MeshletDrawRange& range : m_meshletRanges[index]) {
+			deviceContext.DrawIndexed(range.indexCount, geometry.startIndex + range.indexOffset, geometry.baseVertex);
+		}
+		return;
+	}
+	const MeshComponent& mesh = (*m_meshes)[index];
+	const unsigned int lod = index < m_meshLODs.size() ? m_meshLODs[index] : 0;
+	if (lod < mesh.m_lods.size()) {
+		deviceContext.DrawIndexed(mesh.m_lods[lod].indexCount, geometry.startIndex + mesh.m_lods[lod].indexOffset,
+			geometry.baseVertex);
+	}
+	else {
+		deviceContext.DrawIndexed(mesh.m_numIndex, geometry.startIndex, geometry.baseVertex);
+	}
+}
+
+bool
+Actor::getGeometry(size_t index, GeometryRange& range) const {
+	if (!m_geometryHeap || index >= m_geometry.size()) {
+		return false;
+	}
+	return m_geometryHeap->getRange(m_geometry[index], range);
+}
+
+void
+Actor::releaseGeometry() {
 	for (auto& vertexBuffer : m_vertexBuffers) {
 		vertexBuffer.destroy();
 	}
-
 	for (auto& indexBuffer : m_indexBuffers) {
 		indexBuffer.destroy();
 	}
+	if (m_geometryHeap) {
+		for (unsigned int handle : m_geometry) {
+			m_geometryHeap->release(handle);
+		}
+	}
+	m_vertexBuffers.clear();
+	m_indexBuffers.clear();
+	m_geometry.clear();
+}
+
+void
+Actor::submit(RenderQueue& queue, const XMFLOAT3& eye, InstanceBatcher* instances) {
+	PROFILE_SCOPE("Actor::submit");
+	if (!m_program) {
+		return;
+	}
+	const size_t meshCount = std::min(m_meshes->size(), std::min(m_vertexBuffers.size(), m_indexBuffers.size()));
+	m_meshConstants.resize(meshCount);
+	// La world interpolada de interpolate(), la misma que usa render().
+	const XMMATRIX world = XMMatrixTranspose(m_model.mWorld);
+	XMMATRIX shadowWorld = XMMatrixIdentity();
+	if (canCastShadow()) {
+		shadowWorld = getShadowWorld();
+		m_cbShadow.mWorld = XMMatrixTranspose(shadowWorld);
+		m_cbShadow.vMeshColor = XMFLOAT4(0, 0, 0, 0.5f);
+		m_shadowConstants.resize(meshCount);
+	}
+
+	for (size_t i = 0; i < meshCount; ++i) {
+		const MeshComponent& mesh = (*m_meshes)[i];
+		DrawPacket packet;
+		packet.vertexShader = m_program->m_VertexShader;
+		packet.pixelShader = m_program->m_PixelShader;
+		packet.inputLayout = m_program->getInputLayout(mesh.m_vertexLayout);
+		packet.blendState = m_blendstate.raw();
+		packet.rasterizerState = m_rasterizer.raw();
+		packet.sampler = m_sampler.m_sampler;
+		// Como en render(): las mallas sin textura propia usan la ltima del actor.
+		if (!m_textures.empty()) {
+			packet.texture = m_textures[std::min(i, m_textures.size() - 1)].srv();
+		}
+		// En el heap las mallas comparten buffers: la cola solo los enlaza al cambiar de pgina.
+		GeometryRange range;
+		if (getGeometry(i, range)) {
+			packet.vertexBuffer = range.vertexBuffer;
+			packet.vertexStride = range.vertexStride;
+			packet.indexBuffer = range.indexBuffer;
+			packet.baseVertex = range.baseVertex;
+			packet.startIndex = range.startIndex;
+		}
+		else {
+			packet.vertexBuffer = m_vertexBuffers[i].raw();
+			packet.vertexStride = m_vertexBuffers[i].getStride();
+			packet.vertexOffset = m_vertexBuffers[i].getOffset();
+			packet.indexBuffer = m_indexBuffers[i].raw();
+		}
+		packet.indexFormat = VertexCodec::getDXGIFormat(mesh.m_indexFormat);
+		packet.constantBuffer = m_modelBuffer.raw();
+		m_meshConstants[i] = meshConstants(m_model, mesh);
+		packet.constantData = &m_meshConstants[i];
+		packet.constantSize = sizeof(CBChangesEveryFrame);
+
+		// Rango del LOD seleccionado; los meshlets visibles lo sustituyen en el pase opaco.
+		const unsigned int lod = i < m_meshLODs.size() ? m_meshLODs[i] : 0;
+		packet.indexCount = lod < mesh.m_lods.size() ? mesh.m_lods[lod].indexCount : mesh.m_numIndex;
+		packet.indexOffset = lod < mesh.m_lods.size() ? mesh.m_lods[lod].indexOffset : 0;
+		const bool meshlets = m_meshletCulling && i < m_meshletCulled.size() && m_meshletCulled[i];
+		if (meshlets) {
+			packet.ranges = m_meshletRanges[i].data();
+			packet.rangeCount = static_cast<unsigned int>(m_meshletRanges[i].size());
+		}
+
+		float depth = 0.0f;
+		if (i < m_meshWorldBounds.size()) {
+			const XMFLOAT4& sphere = m_meshWorldBounds[i].sphere;
+			depth = XMVectorGetX(XMVector3Length(XMVectorSubtract(
+				XMVectorSet(sphere.x, sphere.y, sphere.z, 0.0f), XMLoadFloat3(&eye))));
+		}
+		// Instanciable: la matriz viaja en la instancia (con la decuantizacin delante, como en meshConstants).
+		const XMMATRIX dequantize = mesh.m_vertexLayout.getDequantizeMatrix();
+		const bool instanced = m_instanced && instances &&
+			instances->add(packet, mesh.m_vertexLayout, RENDER_PASS_OPAQUE, depth, dequantize * world, m_model.vMeshColor);
+		if (!instanced) {
+			queue.push(packet, RENDER_PASS_OPAQUE, depth);
+		}
+
+		if (canCastShadow()) {
+			// La sombra proyectada no depende de la cmara: se dibuja la malla entera.
+			packet.pixelShader = m_shaderShadow.m_PixelShader;
+			packet.blendState = m_shadowBlendState.raw();
+			packet.depthStencilState = m_shadowDepthStencilState.raw();
+			packet.constantBuffer = m_shaderBuffer.raw();
+			m_shadowConstants[i] = meshConstants(m_cbShadow, mesh);
+			packet.constantData = &m_shadowConstants[i];
+			packet.ranges = nullptr;
+			packet.rangeCount = 0;
+			if (!instanced || !instances->add(packet, mesh.m_vertexLayout, RENDER_PASS_SHADOW, depth,
+				dequantize * shadowWorld, m_cbShadow.vMeshColor)) {
+				queue.push(packet, RENDER_PASS_SHADOW, depth);
+			}
+		}
+	}
+}
+
+void
+Actor::updateWorldBounds() {
+	const EU::TSharedPointer<Transform> transform = getComponent<Transform>();
+	if (transform->getVersion() == m_boundsVersion) {
+		return;
+	}
+	m_boundsVersion = transform->getVersion();
+
+	m_worldBounds = MeshBounds();
+	m_meshWorldBounds.resize(m_meshes->size());
+	for (size_t i = 0; i < m_meshes->size(); ++i) {
+		m_meshWorldBounds[i] = BoundingVolume::transform((*m_meshes)[i].m_bounds, transform->matrix);
+		m_worldBounds = BoundingVolume::merge(m_worldBounds, m_meshWorldBounds[i]);
+	}
+	++m_boundsRevision;
+}
+
+void
+Actor::updateLOD(const XMFLOAT3& eye, float projectionScale) {
+	for (size_t i = 0; i < m_meshes->size() && i < m_meshWorldBounds.size(); ++i) {
+		if ((*m_meshes)[i].m_lods.size() < 2) {
+			continue;
+		}
+		const XMFLOAT4& sphere = m_meshWorldBounds[i].sphere;
+		const float screenSize = MeshSimplifier::projectedSize(XMFLOAT3(sphere.x, sphere.y, sphere.z),
+			sphere.w, eye, projectionScale);
+		m_meshLODs[i] = MeshSimplifier::selectLOD((*m_meshes)[i].m_lods, screenSize, m_meshLODs[i]);
+	}
+}
+
+void
+Actor::cullMeshlets(const XMMATRIX& viewProjection, const XMFLOAT3& eye) {
+	m_meshletStats = MeshletCullStats();
+	const XMMATRIX& world = getComponent<Transform>()->matrix;
+	const XMMATRIX worldViewProjection = world * viewProjection;
+
+	// Cmara en espacio local; el cono de normales solo es vlido con escala uniforme y sin reflejo.
+	XMVECTOR determinant;
+	const XMMATRIX inverseWorld = XMMatrixInverse(&determinant, world);
+	XMFLOAT3 localEye;
+	XMStoreFloat3(&localEye, XMVector3TransformCoord(XMLoadFloat3(&eye), inverseWorld));
+	const float sx = XMVectorGetX(XMVector3Length(world.r[0]));
+	const float sy = XMVectorGetX(XMVector3Length(world.r[1]));
+	const float sz = XMVectorGetX(XMVector3Length(world.r[2]));
+	const bool coneCulling = XMVectorGetX(determinant) > 0.0f &&
+		std::fabs(sx - sy) <= 0.01f * sx && std::fabs(sx - sz) <= 0.01f * sx;
+
+	for (size_t i = 0; i < m_meshes->size() && i < m_meshletCullers.size(); ++i) {
+		m_meshletCulled[i] = 0;
+		if (!m_meshletCulling || m_meshletCullers[i].isEmpty() || m_meshLODs[i] != 0) {
+			continue;
+		}
+		m_meshletCullers[i].cull(worldViewProjection, localEye, coneCulling, m_meshletRanges[i], m_meshletStats);
+		m_meshletCulled[i] = 1;
+	}
+}
+
+bool
+Actor::intersectRay(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, float& distance) {
+	// Rayo a espacio local sin normalizar la direccin: el parmetro t es el mismo en ambos espacios.
+	XMVECTOR determinant;
+	const XMMATRIX inverseWorld = XMMatrixInverse(&determinant, getComponent<Transform>()->matrix);
+	XMFLOAT3 localOrigin, localDirection;
+	XMStoreFloat3(&localOrigin, XMVector3TransformCoord(XMLoadFloat3(&origin), inverseWorld));
+	XMStoreFloat3(&localDirection, XMVector3TransformNormal(XMLoadFloat3(&direction), inverseWorld));
+
+	bool found = false;
+	float closest = maxDistance;
+	for (const MeshComponent& mesh : *m_meshes) {
+		BVHHit hit;
+		if (mesh.m_bvh.intersect(localOrigin, localDirection, closest, hit)) {
+			closest = hit.distance;
+			found = true;
+		}
+	}
+	if (found) {
+		distance = closest;
+	}
+	return found;
+}
+
+void
+Actor::submitOccluder(OcclusionBuffer& buffer) {
+	const XMMATRIX& world = getComponent<Transform>()->matrix;
+	for (const MeshComponent& mesh : *m_meshes) {
+		const unsigned int offset = mesh.m_lods.empty() ? 0 : mesh.m_lods.back().indexOffset;
+		const unsigned int count = mesh.m_lods.empty() ? mesh.m_numIndex : mesh.m_lods.back().indexCount;
+		if (count == 0 || offset + count > mesh.m_index.size()) {
+			continue;
+		}
+		buffer.addOccluder(mesh.m_vertex, &mesh.m_index[offset], count, world);
+	}
+}
+
+void
+Actor::getTriangleCounts(unsigned int& drawn, unsigned int& full) const {
+	drawn = 0;
+	full = 0;
+	for (size_t i = 0; i < m_meshes->size(); ++i) {
+		const MeshComponent& mesh = (*m_meshes)[i];
+		const unsigned int lod = i < m_meshLODs.size() ? m_meshLODs[i] : 0;
+		full += mesh.m_numIndex / 3;
+		drawn += (lod < mesh.m_lods.size() ? mesh.m_lods[lod].indexCount : mesh.m_numIndex) / 3;
+	}
+}
+
+void
+Actor::destroy() {
+	releaseGeometry();
 
 	for (auto& tex : m_textures) {
 		tex.destroy();
 	}
 	m_modelBuffer.destroy();
+	m_shaderBuffer.destroy();
 
 	m_rasterizer.destroy();
 	m_blendstate.destroy();
@@ -134,9 +486,45 @@ Actor::destroy() {
 
 void
 Actor::setMesh(Device& device, std::vector<MeshComponent> meshes) {
-	m_meshes = meshes;
+	// Reemplazo (por ejemplo, placeholder -> malla real): liberar los buffers previos
+	releaseGeometry();
+
+	m_meshes = std::make_shared<std::vector<MeshComponent>>(std::move(meshes));
+	m_meshLODs.assign(m_meshes->size(), 0);
+	m_meshletCullers.assign(m_meshes->size(), MeshletCuller());
+	m_meshletRanges.assign(m_meshes->size(), std::vector<MeshletDrawRange>());
+	m_meshletCulled.assign(m_meshes->size(), 0);
+	for (size_t i = 0; i < m_meshes->size(); ++i) {
+		// Mallas creadas a mano (plano, placeholder) no pasan por el importador.
+		if ((*m_meshes)[i].m_bounds.isEmpty()) {
+			(*m_meshes)[i].m_bounds = BoundingVolume::compute((*m_meshes)[i].m_vertex);
+		}
+		if ((*m_meshes)[i].m_bvh.isEmpty()) {
+			(*m_meshes)[i].m_bvh.build((*m_meshes)[i].m_vertex, (*m_meshes)[i].m_index.data(),
+				size_t((*m_meshes)[i].m_numIndex) / 3, nullptr);
+		}
+		m_meshletCullers[i].init((*m_meshes)[i].m_meshlets);
+	}
+	m_boundsVersion = ~0u;
+	updateWorldBounds();
 	HRESULT hr;
-	for (auto& mesh : m_meshes) {
+	for (auto& mesh : *m_meshes) {
+		// Formato compacto: requiere su Input Layout; si no se puede crear se sube como float.
+		if (mesh.m_vertexLayout.isCompact() &&
+			(!m_program || FAILED(m_program->CreateInputLayout(device, mesh.m_vertexLayout)))) {
+			ERROR("Actor", "setMesh", "No input layout for compact vertices; uploading " << mesh.m_name.c_str() << " as float");
+			mesh.m_vertexLayout = VertexLayout();
+		}
+
+		// En el heap: los buffers propios quedan vacos para que sus ndices sigan siendo los de las mallas.
+		const unsigned int handle = m_geometryHeap ? m_geometryHeap->add(mesh) : GeometryHeap::kInvalidHandle;
+		m_geometry.push_back(handle);
+		if (handle != GeometryHeap::kInvalidHandle) {
+			m_vertexBuffers.push_back(Buffer());
+			m_indexBuffers.push_back(Buffer());
+			continue;
+		}
+
 		// Crear vertex buffer
 		Buffer vertexBuffer;
 		hr = vertexBuffer.init(device, mesh, D3D11_BIND_VERTEX_BUFFER);
@@ -160,8 +548,55 @@ Actor::setMesh(Device& device, std::vector<MeshComponent> meshes) {
 }
 
 void
-Actor::renderShadow(DeviceContext& deviceContext) {
-// --- 1) Descompn world en traslacin + yaw + escala ---
+Actor::shareResources(const Actor& source) {
+	releaseGeometry();
+	for (auto& tex : m_textures) {
+		tex.destroy();
+	}
+
+	m_meshes = source.m_meshes;
+	m_program = source.m_program;
+	m_vertexBuffers = source.m_vertexBuffers;
+	m_indexBuffers = source.m_indexBuffers;
+	m_geometryHeap = source.m_geometryHeap;
+	m_geometry = source.m_geometry;
+	m_textures = source.m_textures;
+	// Cada copia tiene su referencia: destroy() libera solo la suya.
+	for (const Buffer& buffer : m_vertexBuffers) {
+		if (buffer.raw()) {
+			buffer.raw()->AddRef();
+		}
+	}
+	for (const Buffer& buffer : m_indexBuffers) {
+		if (buffer.raw()) {
+			buffer.raw()->AddRef();
+		}
+	}
+	if (m_geometryHeap) {
+		for (unsigned int handle : m_geometry) {
+			m_geometryHeap->addRef(handle);
+		}
+	}
+	for (const Texture& tex : m_textures) {
+		if (tex.srv()) {
+			tex.srv()->AddRef();
+		}
+		if (tex.raw()) {
+			tex.raw()->AddRef();
+		}
+	}
+
+	m_meshLODs.assign(m_meshes->size(), 0);
+	m_meshletCullers.assign(m_meshes->size(), MeshletCuller());
+	m_meshletRanges.assign(m_meshes->size(), std::vector<MeshletDrawRange>());
+	m_meshletCulled.assign(m_meshes->size(), 0);
+	m_boundsVersion = ~0u;
+	updateWorldBounds();
+}
+
+XMMATRIX
+Actor::getShadowWorld() {
+	// --- 1) Descompn world en traslacin + yaw + escala ---
 	auto t = getComponent<Transform>();
 	auto pos = t->getPosition();   // Vector3
 	auto yaw = t->getRotation().y; // slo yaw
@@ -187,24 +622,29 @@ Actor::renderShadow(DeviceContext& deviceContext) {
 	);
 
 	// --- 3) Aplica worldYaw * S para obtener la sombra en el suelo ---
-	XMMATRIX worldShadow = worldYaw * S;
-	// 2) Preparar y actualizar constant buffer
-	m_cbShadow.mWorld = XMMatrixTranspose(worldShadow);
+	return worldYaw * S;
+}
+
+void
+Actor::renderShadow(DeviceContext& deviceContext) {
+	// 1) Preparar y actualizar constant buffer
+	m_cbShadow.mWorld = XMMatrixTranspose(getShadowWorld());
 	m_cbShadow.vMeshColor = XMFLOAT4(0, 0, 0, 0.5f);
 	m_shaderBuffer.update(deviceContext, nullptr, 0, nullptr, &m_cbShadow, 0, 0);
 	m_shaderBuffer.render(deviceContext, 2, 1, true);
 
-	// 3) Bind de shader y estados
+	// 2) Bind de shader y estados
 	float blendFactor[4] = { 0.f, 0.f, 0.f, 0.f };
 	m_shaderShadow.render(deviceContext, PIXEL_SHADER);
 	m_shadowBlendState.render(deviceContext, blendFactor, 0xffffffff);
 	m_shadowDepthStencilState.render(deviceContext, 0);
 
 	deviceContext.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	// 4) Dibujar cada malla del actor
-	for (size_t i = 0; i < m_meshes.size(); ++i) {
-		m_vertexBuffers[i].render(deviceContext, 0, 1);
-		m_indexBuffers[i].render(deviceContext, 0, 1, false, DXGI_FORMAT_R32_UINT);
-		deviceContext.DrawIndexed(m_meshes[i].m_numIndex, 0, 0);
+	// 3) Dibujar cada malla del actor
+	bool dequantized = false;
+	for (size_t i = 0; i < m_meshes->size(); ++i) {
+		bindMesh(deviceContext, i, m_cbShadow, m_shaderBuffer, dequantized);
+		// La sombra proyectada no depende de la cmara: se dibuja la malla entera.
+		drawMesh(deviceContext, i, false);
 	}
 }
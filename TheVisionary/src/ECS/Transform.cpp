@@ -1,11 +1,13 @@
 #include "ECS\Transform.h"
 #include "DeviceContext.h"
+#include <cstring>
 
 void
 Transform::init() {
 	scale.one();
 
 	matrix = XMMatrixIdentity();
+	previousMatrix = matrix;
 }
 
 void
@@ -18,7 +20,35 @@ Transform::update(float deltaTime) {
 	XMMATRIX translationMatrix = XMMatrixTranslation(position.x, position.y, position.z);
 
 	// Componer la matriz final en el orden: scale -> rotation -> translation
-	matrix = scaleMatrix * rotationMatrix * translationMatrix;
+	const XMMATRIX composed = scaleMatrix * rotationMatrix * translationMatrix;
+	// Sin matriz propia todava (versin 0) no hay paso anterior del que venir:
+	// el actor recin colocado no se dibuja deslizndose desde el origen.
+	previousMatrix = m_version == 0 ? composed : matrix;
+	if (memcmp(&composed, &matrix, sizeof(XMMATRIX)) != 0) {
+		matrix = composed;
+		++m_version;
+	}
+}
+
+XMMATRIX
+Transform::getInterpolatedMatrix(float alpha) const {
+	if (alpha >= 1.0f || memcmp(&previousMatrix, &matrix, sizeof(XMMATRIX)) == 0) {
+		return matrix;
+	}
+	if (alpha <= 0.0f) {
+		return previousMatrix;
+	}
+	// Escala y traslacin lineales; la rotacin por slerp para no deformar la malla.
+	XMVECTOR scale0, rotation0, translation0;
+	XMVECTOR scale1, rotation1, translation1;
+	if (!XMMatrixDecompose(&scale0, &rotation0, &translation0, previousMatrix) ||
+			!XMMatrixDecompose(&scale1, &rotation1, &translation1, matrix)) {
+		return matrix;
+	}
+	return XMMatrixAffineTransformation(XMVectorLerp(scale0, scale1, alpha),
+		XMVectorZero(),
+		XMQuaternionSlerp(rotation0, rotation1, alpha),
+		XMVectorLerp(translation0, translation1, alpha));
 }
 
 void 
@@ -0,0 +1,248 @@
+﻿/**
+ * @file FramePacing.cpp
+ * @brief Reloj de frame, acumulador de paso fijo y espera del bucle principal.
+ */
+
+#include "FramePacing.h"
+#include <cmath>
+
+// Windows 10 1803+: el temporizador no depende de timeBeginPeriod() para bajar de 15.6 ms.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+const double FrameClock::kMaxDelta = 0.25;
+const double FramePacer::kWindow = 1.0;
+
+static double
+ElapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+static uint64_t
+FileTimeTicks(const FILETIME& time) {
+	return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+}
+
+/** CPU de usuario y kernel del proceso (100 ns). */
+static uint64_t
+ProcessCpuTicks() {
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+		return 0;
+	}
+	return FileTimeTicks(kernel) + FileTimeTicks(user);
+}
+
+/** CPU de usuario y kernel del hilo que llama (100 ns). */
+static uint64_t
+ThreadCpuTicks() {
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+		return 0;
+	}
+	return FileTimeTicks(kernel) + FileTimeTicks(user);
+}
+
+void
+FrameClock::reset() {
+	m_last = Clock::now();
+	m_started = true;
+	m_delta = m_rawDelta = 0.0;
+	m_total = 0.0;
+}
+
+double
+FrameClock::tick(Clock::time_point now) {
+	if (!m_started) {
+		m_last = now;
+		m_started = true;
+		m_delta = m_rawDelta = 0.0;
+		return 0.0;
+	}
+	m_rawDelta = std::chrono::duration<double>(now - m_last).count();
+	m_last = now;
+	m_delta = std::min(std::max(m_rawDelta, 0.0), kMaxDelta);
+	m_total += m_delta;
+	return m_delta;
+}
+
+void
+FixedTimestep::reset() {
+	// Un paso entero pendiente: el primer frame deja los actores actualizados.
+	m_accumulator = m_step;
+	m_steps = 0;
+	m_dropped = 0.0;
+}
+
+void
+FixedTimestep::setStep(double step) {
+	m_step = std::min(std::max(step, 0.001), 0.1);
+}
+
+unsigned int
+FixedTimestep::advance(double delta) {
+	m_accumulator += std::max(delta, 0.0);
+	unsigned int steps = static_cast<unsigned int>(m_accumulator / m_step);
+	if (steps > m_maxSteps) {
+		const double excess = (steps - m_maxSteps) * m_step;
+		m_dropped += excess;
+		m_accumulator -= excess;
+		steps = m_maxSteps;
+	}
+	m_accumulator = std::max(m_accumulator - steps * m_step, 0.0);
+	m_steps += steps;
+	return steps;
+}
+
+FramePacer::~FramePacer() {
+	if (m_timer) {
+		CloseHandle(m_timer);
+		m_timer = nullptr;
+	}
+}
+
+double
+FramePacer::getTargetSeconds(const FramePacingSettings& settings, bool focused) {
+	int fps = settings.maxFps;
+	if (!focused && settings.throttleUnfocused && settings.unfocusedFps > 0) {
+		fps = fps > 0 ? std::min(fps, settings.unfocusedFps) : settings.unfocusedFps;
+	}
+	return fps > 0 ? 1.0 / fps : 0.0;
+}
+
+void
+FramePacer::pace(double targetSeconds, float spinMs) {
+	const Clock::time_point start = Clock::now();
+	Clock::time_point slept = start;
+	if (targetSeconds > 0.0) {
+		if (!m_hasDeadline) {
+			m_deadline = m_hasFrame ? m_lastFrame : start;
+			m_hasDeadline = true;
+		}
+		m_deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(targetSeconds));
+		if (m_deadline <= start) {
+			// Tarde: el siguiente plazo se cuenta desde ahora, sin frames de recuperación.
+			m_deadline = start;
+			++m_late;
+		}
+		else {
+			const double remaining = std::chrono::duration<double>(m_deadline - start).count();
+			const double spin = std::max(spinMs, 0.0f) / 1000.0;
+			if (remaining > spin) {
+				sleepFor(remaining - spin);
+			}
+			slept = Clock::now();
+			while (Clock::now() < m_deadline) {
+				YieldProcessor();
+			}
+		}
+	}
+	else {
+		m_hasDeadline = false;
+	}
+
+	const Clock::time_point end = Clock::now();
+	if (m_hasFrame) {
+		const double frameMs = ElapsedMs(m_lastFrame, end);
+		if (m_frames == 0) {
+			m_frameMin = m_frameMax = frameMs;
+		}
+		m_frameMin = std::min(m_frameMin, frameMs);
+		m_frameMax = std::max(m_frameMax, frameMs);
+		m_frameSum += frameMs;
+		m_frameSquares += frameMs * frameMs;
+		m_busySum += ElapsedMs(m_lastFrame, start);
+		m_sleepSum += ElapsedMs(start, slept);
+		m_spinSum += ElapsedMs(slept, end);
+		++m_frames;
+	}
+	m_lastFrame = end;
+	m_hasFrame = true;
+	flushWindow(end);
+}
+
+void
+FramePacer::idle(unsigned int timeoutMs) {
+	const Clock::time_point start = Clock::now();
+	MsgWaitForMultipleObjects(0, nullptr, FALSE, timeoutMs, QS_ALLINPUT);
+	const Clock::time_point end = Clock::now();
+	m_idleSum += ElapsedMs(start, end);
+	// Al volver, el primer frame no cuenta la espera ni intenta cumplir plazos pasados.
+	m_hasDeadline = false;
+	m_hasFrame = false;
+	flushWindow(end);
+}
+
+void
+FramePacer::sleepFor(double seconds) {
+	if (!m_timerTried) {
+		m_timerTried = true;
+		m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!m_timer) {
+			// Sistemas anteriores: temporizador normal; el final en activo cubre su granularidad.
+			m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		}
+		if (!m_timer) {
+			ERROR("FramePacer", "sleepFor", "CreateWaitableTimerExW failed; falling back to Sleep()");
+		}
+	}
+	if (m_timer) {
+		LARGE_INTEGER due;
+		due.QuadPart = -static_cast<LONGLONG>(seconds * 1.0e7); // Relativo, en 100 ns.
+		if (SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE)) {
+			WaitForSingleObject(m_timer, INFINITE);
+			return;
+		}
+	}
+	Sleep(static_cast<DWORD>(seconds * 1000.0));
+}
+
+void
+FramePacer::flushWindow(Clock::time_point now) {
+	if (!m_windowStarted) {
+		m_windowStart = now;
+		m_processCpuStart = ProcessCpuTicks();
+		m_threadCpuStart = ThreadCpuTicks();
+		m_windowStarted = true;
+		return;
+	}
+	const double wall = std::chrono::duration<double>(now - m_windowStart).count();
+	if (wall < kWindow) {
+		return;
+	}
+
+	if (m_stats.cores == 0) {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		m_stats.cores = std::max(1u, static_cast<unsigned int>(info.dwNumberOfProcessors));
+	}
+	const uint64_t processCpu = ProcessCpuTicks();
+	const uint64_t threadCpu = ThreadCpuTicks();
+	m_stats.processCpu = (processCpu - m_processCpuStart) * 1.0e-7 / (wall * m_stats.cores) * 100.0;
+	m_stats.mainThreadCpu = (threadCpu - m_threadCpuStart) * 1.0e-7 / wall * 100.0;
+
+	m_stats.frames = m_frames;
+	m_stats.lateFrames = m_late;
+	m_stats.idleMs = m_idleSum;
+	if (m_frames > 0) {
+		const double mean = m_frameSum / m_frames;
+		m_stats.frameMs = mean;
+		m_stats.minFrameMs = m_frameMin;
+		m_stats.maxFrameMs = m_frameMax;
+		m_stats.varianceMs2 = std::max(m_frameSquares / m_frames - mean * mean, 0.0);
+		m_stats.stdDevMs = std::sqrt(m_stats.varianceMs2);
+		m_stats.busyMs = m_busySum / m_frames;
+		m_stats.sleepMs = m_sleepSum / m_frames;
+		m_stats.spinMs = m_spinSum / m_frames;
+	}
+
+	m_windowStart = now;
+	m_processCpuStart = processCpu;
+	m_threadCpuStart = threadCpu;
+	m_frames = 0;
+	m_late = 0;
+	m_frameSum = m_frameSquares = 0.0;
+	m_frameMin = m_frameMax = 0.0;
+	m_busySum = m_sleepSum = m_spinSum = m_idleSum = 0.0;
+}
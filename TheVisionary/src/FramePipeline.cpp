@@ -0,0 +1,208 @@
+﻿/**
+ * @file FramePipeline.cpp
+ * @brief Buzón triple de paquetes de frame, hilo de render y medición de latencia.
+ */
+
+#include "FramePipeline.h"
+#include "Profiler.h"
+
+static double
+ElapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+	return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+void
+FrameLatencyTracker::addFrame(std::chrono::steady_clock::time_point inputTime,
+	std::chrono::steady_clock::time_point presentTime,
+	double updateMs,
+	double renderMs) {
+	if (m_hasPresent) {
+		const double frameMs = ElapsedMs(m_lastPresent, presentTime);
+		m_frameSum += frameMs;
+		m_frameMax = std::max(m_frameMax, frameMs);
+		++m_intervals;
+	}
+	m_lastPresent = presentTime;
+	m_hasPresent = true;
+
+	const double latencyMs = ElapsedMs(inputTime, presentTime);
+	m_latencySum += latencyMs;
+	m_latencyMax = std::max(m_latencyMax, latencyMs);
+	m_updateSum += updateMs;
+	m_renderSum += renderMs;
+	if (++m_frames < kWindow) {
+		return;
+	}
+
+	m_stats.frames = m_frames;
+	m_stats.frameMs = m_intervals > 0 ? m_frameSum / m_intervals : 0.0;
+	m_stats.maxFrameMs = m_frameMax;
+	m_stats.latencyMs = m_latencySum / m_frames;
+	m_stats.maxLatencyMs = m_latencyMax;
+	m_stats.updateMs = m_updateSum / m_frames;
+	m_stats.renderMs = m_renderSum / m_frames;
+	m_stats.dropped = m_dropped;
+
+	m_frames = 0;
+	m_intervals = 0;
+	m_dropped = 0;
+	m_frameSum = m_frameMax = 0.0;
+	m_latencySum = m_latencyMax = 0.0;
+	m_updateSum = m_renderSum = 0.0;
+}
+
+void
+FrameLatencyTracker::reset() {
+	m_frames = 0;
+	m_intervals = 0;
+	m_dropped = 0;
+	m_frameSum = m_frameMax = 0.0;
+	m_latencySum = m_latencyMax = 0.0;
+	m_updateSum = m_renderSum = 0.0;
+	m_hasPresent = false;
+}
+
+bool
+FrameMailbox::publish() {
+	bool dropped = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		dropped = m_fresh;
+		std::swap(m_write, m_ready);
+		m_fresh = true;
+	}
+	m_changed.notify_all();
+	return dropped;
+}
+
+bool
+FrameMailbox::waitForSlot(unsigned int timeoutMs) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_changed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+		[this]() { return !m_fresh || m_closed; });
+}
+
+FramePacket*
+FrameMailbox::acquire() {
+	FramePacket* packet = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this]() { return m_fresh || m_closed; });
+		if (!m_fresh) {
+			return nullptr;
+		}
+		std::swap(m_read, m_ready);
+		m_fresh = false;
+		m_busy = true;
+		packet = &m_slots[m_read];
+	}
+	// La simulación puede estar esperando hueco en waitForSlot().
+	m_changed.notify_all();
+	return packet;
+}
+
+void
+FrameMailbox::release() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_busy = false;
+	}
+	m_changed.notify_all();
+}
+
+void
+FrameMailbox::waitIdle() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changed.wait(lock, [this]() { return !m_fresh && !m_busy; });
+}
+
+void
+FrameMailbox::close() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	m_changed.notify_all();
+}
+
+void
+FrameMailbox::open() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_closed = false;
+}
+
+void
+RenderThread::start(RenderFunction render) {
+	if (isRunning()) {
+		ERROR("RenderThread", "start", "The render thread is already running.");
+		return;
+	}
+	if (!render) {
+		ERROR("RenderThread", "start", "No render function.");
+		return;
+	}
+	m_render = std::move(render);
+	{
+		std::lock_guard<std::mutex> lock(m_statsMutex);
+		m_tracker.reset();
+	}
+	m_dropped = 0;
+	m_mailbox.open();
+	m_thread = std::thread(&RenderThread::threadLoop, this);
+	MESSAGE("RenderThread", "start", "Render thread started");
+}
+
+void
+RenderThread::stop() {
+	if (!isRunning()) {
+		return;
+	}
+	// Lo publicado se dibuja antes de salir: acquire() solo devuelve nullptr sin nada pendiente.
+	m_mailbox.close();
+	m_thread.join();
+	m_render = nullptr;
+	MESSAGE("RenderThread", "stop", "Render thread stopped");
+}
+
+void
+RenderThread::publish() {
+	if (m_mailbox.publish()) {
+		++m_dropped;
+	}
+}
+
+void
+RenderThread::drain() {
+	if (isRunning()) {
+		m_mailbox.waitIdle();
+	}
+}
+
+FrameLatencyStats
+RenderThread::getStats() const {
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	return m_tracker.getStats();
+}
+
+FrameRenderResult
+RenderThread::getLastResult() const {
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	return m_result;
+}
+
+void
+RenderThread::threadLoop() {
+	Profiler::setThreadName("Render");
+	while (FramePacket* packet = m_mailbox.acquire()) {
+		const auto start = std::chrono::steady_clock::now();
+		m_render(*packet);
+		const auto presented = std::chrono::steady_clock::now();
+		{
+			std::lock_guard<std::mutex> lock(m_statsMutex);
+			m_tracker.addDropped(m_dropped.exchange(0));
+			m_tracker.addFrame(packet->inputTime, presented, packet->updateMs, ElapsedMs(start, presented));
+			m_result = packet->result;
+		}
+		m_mailbox.release();
+	}
+}
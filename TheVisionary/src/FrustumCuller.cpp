@@ -0,0 +1,292 @@
+﻿/**
+ * @file FrustumCuller.cpp
+ * @brief Implementación de la extracción de planos y del culling SoA de AABB.
+ */
+
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC acepta intrínsecos AVX sin /arch:AVX; GCC y Clang necesitan habilitarlos por función.
+#if defined(_MSC_VER)
+#define FRUSTUM_TARGET_AVX
+#else
+#define FRUSTUM_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace {
+	/// Semieje de los volúmenes vacíos: nunca quedan fuera de un plano.
+	const float kUnboundedExtent = 1.0e30f;
+}
+
+Frustum
+Frustum::fromMatrix(const XMMATRIX& matrix) {
+	// Gribb-Hartmann: con vectores fila, la columna j de la matriz da la coordenada j del clip.
+	const XMMATRIX m = XMMatrixTranspose(matrix);
+	const XMVECTOR planes[6] = {
+		XMVectorAdd(m.r[3], m.r[0]), XMVectorSubtract(m.r[3], m.r[0]),
+		XMVectorAdd(m.r[3], m.r[1]), XMVectorSubtract(m.r[3], m.r[1]),
+		m.r[2], XMVectorSubtract(m.r[3], m.r[2])
+	};
+	Frustum frustum;
+	for (int p = 0; p < 6; ++p) {
+		XMStoreFloat4(&frustum.planes[p], XMPlaneNormalize(planes[p]));
+	}
+	return frustum;
+}
+
+bool
+FrustumCuller::isAVXSupported() {
+	static const bool supported = []() {
+#if defined(_MSC_VER)
+		// CPUID.1:ECX bit 28 = AVX, bit 27 = OSXSAVE; XCR0 bits 1 y 2 = el sistema guarda XMM e YMM.
+		int info[4];
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+		return __builtin_cpu_supports("avx") != 0;
+#endif
+	}();
+	return supported;
+}
+
+void
+FrustumCuller::resize(size_t count) {
+	m_count = count;
+	m_groups.resize((count + kGroupWidth - 1) / kGroupWidth);
+	// Carriles de relleno: caja nula en el origen (se ignoran al emitir índices).
+	for (size_t i = count; i < m_groups.size() * kGroupWidth; ++i) {
+		setBounds(i, MeshBounds());
+	}
+}
+
+void
+FrustumCuller::setBounds(size_t index, const MeshBounds& bounds) {
+	Group& group = m_groups[index / kGroupWidth];
+	const size_t lane = index % kGroupWidth;
+	const bool unbounded = bounds.isEmpty();
+	group.centerX[lane] = unbounded ? 0.0f : bounds.center.x;
+	group.centerY[lane] = unbounded ? 0.0f : bounds.center.y;
+	group.centerZ[lane] = unbounded ? 0.0f : bounds.center.z;
+	group.extentX[lane] = unbounded ? kUnboundedExtent : bounds.extents.x;
+	group.extentY[lane] = unbounded ? kUnboundedExtent : bounds.extents.y;
+	group.extentZ[lane] = unbounded ? kUnboundedExtent : bounds.extents.z;
+}
+
+void
+FrustumCuller::cullRange(const Frustum& frustum, size_t begin, size_t end, std::vector<unsigned int>& visible) const {
+	if (m_useAVX) {
+		cullRangeAVX(frustum, begin, end, visible);
+	}
+	else {
+		cullRangeSSE(frustum, begin, end, visible);
+	}
+}
+
+void
+FrustumCuller::cullRangeSSE(const Frustum& frustum, size_t begin, size_t end, std::vector<unsigned int>& visible) const {
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	XMVECTOR absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; ++p) {
+		const XMVECTOR plane = XMLoadFloat4(&frustum.planes[p]);
+		planeX[p] = XMVectorSplatX(plane);
+		planeY[p] = XMVectorSplatY(plane);
+		planeZ[p] = XMVectorSplatZ(plane);
+		planeW[p] = XMVectorSplatW(plane);
+		absX[p] = XMVectorAbs(planeX[p]);
+		absY[p] = XMVectorAbs(planeY[p]);
+		absZ[p] = XMVectorAbs(planeZ[p]);
+	}
+
+	// Cada grupo de ocho se evalúa en dos mitades de cuatro.
+	for (size_t first = begin; first < end; first += 4) {
+		const Group& group = m_groups[first / kGroupWidth];
+		const size_t lane = first % kGroupWidth;
+		const XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(group.centerX + lane));
+		const XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(group.centerY + lane));
+		const XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(group.centerZ + lane));
+		const XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(group.extentX + lane));
+		const XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(group.extentY + lane));
+		const XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(group.extentZ + lane));
+
+		XMVECTOR outside = XMVectorFalseInt();
+		for (int p = 0; p < 6; ++p) {
+			const XMVECTOR distance = XMVectorMultiplyAdd(cx, planeX[p],
+				XMVectorMultiplyAdd(cy, planeY[p], XMVectorMultiplyAdd(cz, planeZ[p], planeW[p])));
+			const XMVECTOR radius = XMVectorMultiplyAdd(ex, absX[p],
+				XMVectorMultiplyAdd(ey, absY[p], XMVectorMultiply(ez, absZ[p])));
+			outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), XMVectorZero()));
+		}
+
+		const size_t last = std::min(first + 4, end);
+		// Camino rápido: las cuatro cajas dentro.
+		if (XMVector4EqualInt(outside, XMVectorFalseInt())) {
+			for (size_t i = first; i < last; ++i) {
+				visible.push_back(static_cast<unsigned int>(i));
+			}
+			continue;
+		}
+		UINT mask[4];
+		XMStoreInt4(mask, outside);
+		for (size_t i = first; i < last; ++i) {
+			if (!mask[i - first]) {
+				visible.push_back(static_cast<unsigned int>(i));
+			}
+		}
+	}
+}
+
+FRUSTUM_TARGET_AVX void
+FrustumCuller::cullRangeAVX(const Frustum& frustum, size_t begin, size_t end, std::vector<unsigned int>& visible) const {
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m256 absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; ++p) {
+		const XMFLOAT4& plane = frustum.planes[p];
+		planeX[p] = _mm256_set1_ps(plane.x);
+		planeY[p] = _mm256_set1_ps(plane.y);
+		planeZ[p] = _mm256_set1_ps(plane.z);
+		planeW[p] = _mm256_set1_ps(plane.w);
+		absX[p] = _mm256_set1_ps(std::fabs(plane.x));
+		absY[p] = _mm256_set1_ps(std::fabs(plane.y));
+		absZ[p] = _mm256_set1_ps(std::fabs(plane.z));
+	}
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (size_t g = begin / kGroupWidth; g * kGroupWidth < end; ++g) {
+		const Group& group = m_groups[g];
+		const __m256 cx = _mm256_load_ps(group.centerX);
+		const __m256 cy = _mm256_load_ps(group.centerY);
+		const __m256 cz = _mm256_load_ps(group.centerZ);
+		const __m256 ex = _mm256_load_ps(group.extentX);
+		const __m256 ey = _mm256_load_ps(group.extentY);
+		const __m256 ez = _mm256_load_ps(group.extentZ);
+
+		// Mismo orden de operaciones que cullRangeSSE (sin FMA) para obtener la misma lista.
+		__m256 outside = zero;
+		for (int p = 0; p < 6; ++p) {
+			const __m256 distance = _mm256_add_ps(_mm256_mul_ps(cx, planeX[p]),
+				_mm256_add_ps(_mm256_mul_ps(cy, planeY[p]), _mm256_add_ps(_mm256_mul_ps(cz, planeZ[p]), planeW[p])));
+			const __m256 radius = _mm256_add_ps(_mm256_mul_ps(ex, absX[p]),
+				_mm256_add_ps(_mm256_mul_ps(ey, absY[p]), _mm256_mul_ps(ez, absZ[p])));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+		}
+
+		const size_t first = g * kGroupWidth;
+		const size_t last = std::min(first + kGroupWidth, end);
+		const int mask = _mm256_movemask_ps(outside);
+		for (size_t i = first; i < last; ++i) {
+			if (!(mask & (1 << (i - first)))) {
+				visible.push_back(static_cast<unsigned int>(i));
+			}
+		}
+	}
+	// Evita la penalización de mezclar AVX con el código SSE que sigue.
+	_mm256_zeroupper();
+}
+
+void
+FrustumCuller::cull(const Frustum& frustum,
+	std::vector<unsigned int>& visible,
+	JobSystem* jobs,
+	FrustumCullStats* stats) const {
+	const auto start = std::chrono::steady_clock::now();
+	visible.clear();
+
+	const unsigned int chunkCount = static_cast<unsigned int>((m_count + kChunkSize - 1) / kChunkSize);
+	if (!jobs || jobs->getThreadCount() == 0 || chunkCount < 2) {
+		cullRange(frustum, 0, m_count, visible);
+	}
+	else {
+		// Una salida por bloque: sin sincronización entre hilos y con el orden original al concatenar.
+		m_chunkVisible.resize(chunkCount);
+		jobs->parallelFor(chunkCount, 1, [this, &frustum](unsigned int begin, unsigned int end) {
+			for (unsigned int chunk = begin; chunk < end; ++chunk) {
+				std::vector<unsigned int>& out = m_chunkVisible[chunk];
+				out.clear();
+				cullRange(frustum, size_t(chunk) * kChunkSize,
+					std::min(m_count, size_t(chunk + 1) * kChunkSize), out);
+			}
+		});
+		size_t total = 0;
+		for (unsigned int chunk = 0; chunk < chunkCount; ++chunk) {
+			total += m_chunkVisible[chunk].size();
+		}
+		visible.reserve(total);
+		for (unsigned int chunk = 0; chunk < chunkCount; ++chunk) {
+			visible.insert(visible.end(), m_chunkVisible[chunk].begin(), m_chunkVisible[chunk].end());
+		}
+	}
+
+	if (stats) {
+		stats->tested = static_cast<unsigned int>(m_count);
+		stats->visible = static_cast<unsigned int>(visible.size());
+		stats->chunks = std::max(chunkCount, 1u);
+		stats->milliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+FrustumCullBenchmark
+FrustumCuller::benchmark(unsigned int count, JobSystem* jobs) {
+	FrustumCullBenchmark result;
+	result.count = count;
+	result.threads = jobs ? jobs->getThreadCount() + 1 : 1;
+
+	// Cajas de 1 a 3 unidades repartidas en un área de 1000 x 1000 alrededor de la cámara.
+	FrustumCuller culler;
+	culler.resize(count);
+	uint32_t state = 0x9E3779B9u;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return float(state >> 8) / 16777216.0f;
+	};
+	for (unsigned int i = 0; i < count; ++i) {
+		MeshBounds bounds;
+		bounds.center = XMFLOAT3(next() * 1000.0f - 500.0f, next() * 20.0f, next() * 1000.0f - 500.0f);
+		bounds.extents = XMFLOAT3(0.5f + next(), 0.5f + next(), 0.5f + next());
+		bounds.sphere = XMFLOAT4(bounds.center.x, bounds.center.y, bounds.center.z, 3.0f);
+		culler.setBounds(i, bounds);
+	}
+
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, 0.0f, 1.0f),
+		XMVectorSet(0.0f, 10.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	const Frustum frustum = Frustum::fromMatrix(view * projection);
+
+	const int kRuns = 20;
+	std::vector<unsigned int> visible;
+	culler.setUseAVX(false);
+	auto start = std::chrono::steady_clock::now();
+	for (int run = 0; run < kRuns; ++run) {
+		culler.cull(frustum, visible, nullptr);
+	}
+	result.serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kRuns;
+	result.visible = static_cast<unsigned int>(visible.size());
+	result.pathsMatch = true;
+
+	result.avx = isAVXSupported();
+	if (result.avx) {
+		const std::vector<unsigned int> reference = visible;
+		culler.setUseAVX(true);
+		start = std::chrono::steady_clock::now();
+		for (int run = 0; run < kRuns; ++run) {
+			culler.cull(frustum, visible, nullptr);
+		}
+		result.avxMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kRuns;
+		result.pathsMatch = visible == reference;
+	}
+
+	start = std::chrono::steady_clock::now();
+	for (int run = 0; run < kRuns; ++run) {
+		culler.cull(frustum, visible, jobs);
+	}
+	result.parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kRuns;
+	return result;
+}
@@ -0,0 +1,718 @@
+﻿/**
+ * @file GeometryHeap.cpp
+ * @brief Asignador TLSF de rangos y páginas de vértices e índices compartidas por las mallas.
+ */
+
+#include "GeometryHeap.h"
+#include "Device.h"
+#include "DeviceContext.h"
+#include "MeshComponent.h"
+#include "RenderQueue.h"
+#include <chrono>
+#include <random>
+
+namespace {
+	/// Bit más alto puesto (value > 0).
+	unsigned int
+	highestBit(uint32_t value) {
+		unsigned int bit = 0;
+		while (value >>= 1) {
+			++bit;
+		}
+		return bit;
+	}
+
+	/// Bit más bajo puesto (value > 0).
+	unsigned int
+	lowestBit(uint32_t value) {
+		unsigned int bit = 0;
+		while (!(value & 1u)) {
+			value >>= 1;
+			++bit;
+		}
+		return bit;
+	}
+
+	/// Puntero ficticio para la escena sintética (nunca se desreferencia).
+	template<typename T>
+	T*
+	fakeObject(unsigned int kind, unsigned int index) {
+		return reinterpret_cast<T*>((uintptr_t(kind) << 24) | (uintptr_t(index + 1) << 4));
+	}
+}
+
+void
+RangeAllocator::init(unsigned int capacity) {
+	m_blocks.clear();
+	m_unused.clear();
+	for (auto& heads : m_heads) {
+		std::fill_n(heads, kSecondLevelCount, kInvalid);
+	}
+	m_firstLevelMap = 0;
+	std::fill_n(m_secondLevelMaps, kFirstLevelCount, 0u);
+	m_capacity = std::min(capacity, kMaxCapacity);
+	m_used = 0;
+	m_allocations = 0;
+	m_first = kInvalid;
+	if (m_capacity == 0) {
+		return;
+	}
+	m_first = createBlock();
+	Block& block = m_blocks[m_first];
+	block.offset = 0;
+	block.size = m_capacity;
+	insertFree(m_first);
+}
+
+void
+RangeAllocator::mapping(unsigned int size, unsigned int& firstLevel, unsigned int& secondLevel) {
+	// Por debajo de 16 cada tamaño es su propia clase; por encima, 16 clases lineales por potencia de dos.
+	if (size < kSecondLevelCount) {
+		firstLevel = 0;
+		secondLevel = size;
+		return;
+	}
+	const unsigned int bit = highestBit(size);
+	firstLevel = bit - (kSecondLevelBits - 1);
+	secondLevel = (size >> (bit - kSecondLevelBits)) - kSecondLevelCount;
+}
+
+unsigned int
+RangeAllocator::findFree(unsigned int size) const {
+	// Redondear al inicio de la clase siguiente: cualquier hueco de esa clase o mayores sirve sin recorrer listas.
+	unsigned int rounded = size;
+	if (size >= kSecondLevelCount) {
+		rounded += (1u << (highestBit(size) - kSecondLevelBits)) - 1;
+	}
+	unsigned int firstLevel, secondLevel;
+	mapping(rounded, firstLevel, secondLevel);
+	if (firstLevel < kFirstLevelCount) {
+		uint32_t secondMap = m_secondLevelMaps[firstLevel] & (~0u << secondLevel);
+		if (!secondMap) {
+			const uint32_t firstMap = firstLevel + 1 < 32 ? m_firstLevelMap & (~0u << (firstLevel + 1)) : 0;
+			if (firstMap) {
+				firstLevel = lowestBit(firstMap);
+				secondMap = m_secondLevelMaps[firstLevel];
+			}
+		}
+		if (secondMap) {
+			return m_heads[firstLevel][lowestBit(secondMap)];
+		}
+	}
+
+	// Sin clase mayor: puede quedar un hueco suficiente en la clase exacta.
+	mapping(size, firstLevel, secondLevel);
+	for (unsigned int block = m_heads[firstLevel][secondLevel]; block != kInvalid; block = m_blocks[block].nextFree) {
+		if (m_blocks[block].size >= size) {
+			return block;
+		}
+	}
+	return kInvalid;
+}
+
+void
+RangeAllocator::insertFree(unsigned int block) {
+	unsigned int firstLevel, secondLevel;
+	mapping(m_blocks[block].size, firstLevel, secondLevel);
+	unsigned int& head = m_heads[firstLevel][secondLevel];
+	m_blocks[block].free = true;
+	m_blocks[block].prevFree = kInvalid;
+	m_blocks[block].nextFree = head;
+	if (head != kInvalid) {
+		m_blocks[head].prevFree = block;
+	}
+	head = block;
+	m_firstLevelMap |= 1u << firstLevel;
+	m_secondLevelMaps[firstLevel] |= 1u << secondLevel;
+}
+
+void
+RangeAllocator::removeFree(unsigned int block) {
+	unsigned int firstLevel, secondLevel;
+	mapping(m_blocks[block].size, firstLevel, secondLevel);
+	Block& entry = m_blocks[block];
+	if (entry.prevFree != kInvalid) {
+		m_blocks[entry.prevFree].nextFree = entry.nextFree;
+	}
+	else {
+		m_heads[firstLevel][secondLevel] = entry.nextFree;
+	}
+	if (entry.nextFree != kInvalid) {
+		m_blocks[entry.nextFree].prevFree = entry.prevFree;
+	}
+	entry.free = false;
+	if (m_heads[firstLevel][secondLevel] == kInvalid) {
+		m_secondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+		if (!m_secondLevelMaps[firstLevel]) {
+			m_firstLevelMap &= ~(1u << firstLevel);
+		}
+	}
+}
+
+unsigned int
+RangeAllocator::createBlock() {
+	unsigned int index;
+	if (!m_unused.empty()) {
+		index = m_unused.back();
+		m_unused.pop_back();
+	}
+	else {
+		index = static_cast<unsigned int>(m_blocks.size());
+		m_blocks.push_back(Block());
+	}
+	m_blocks[index] = { 0, 0, kInvalid, kInvalid, kInvalid, kInvalid, false };
+	return index;
+}
+
+void
+RangeAllocator::releaseBlock(unsigned int block) {
+	m_blocks[block].size = 0;
+	m_unused.push_back(block);
+}
+
+unsigned int
+RangeAllocator::allocate(unsigned int size) {
+	if (size == 0 || size > m_capacity - m_used) {
+		return kInvalid;
+	}
+	const unsigned int block = findFree(size);
+	if (block == kInvalid) {
+		return kInvalid;
+	}
+	removeFree(block);
+
+	// El resto del hueco vuelve a las listas como un bloque nuevo a continuación.
+	if (m_blocks[block].size > size) {
+		const unsigned int rest = createBlock();
+		Block& remainder = m_blocks[rest];
+		remainder.offset = m_blocks[block].offset + size;
+		remainder.size = m_blocks[block].size - size;
+		remainder.prevPhysical = block;
+		remainder.nextPhysical = m_blocks[block].nextPhysical;
+		if (remainder.nextPhysical != kInvalid) {
+			m_blocks[remainder.nextPhysical].prevPhysical = rest;
+		}
+		m_blocks[block].nextPhysical = rest;
+		m_blocks[block].size = size;
+		insertFree(rest);
+	}
+	m_used += size;
+	++m_allocations;
+	return block;
+}
+
+void
+RangeAllocator::free(unsigned int block) {
+	if (block >= m_blocks.size() || m_blocks[block].free || m_blocks[block].size == 0) {
+		return;
+	}
+	m_used -= m_blocks[block].size;
+	--m_allocations;
+
+	const unsigned int next = m_blocks[block].nextPhysical;
+	if (next != kInvalid && m_blocks[next].free) {
+		removeFree(next);
+		m_blocks[block].size += m_blocks[next].size;
+		m_blocks[block].nextPhysical = m_blocks[next].nextPhysical;
+		if (m_blocks[block].nextPhysical != kInvalid) {
+			m_blocks[m_blocks[block].nextPhysical].prevPhysical = block;
+		}
+		releaseBlock(next);
+	}
+	const unsigned int prev = m_blocks[block].prevPhysical;
+	if (prev != kInvalid && m_blocks[prev].free) {
+		removeFree(prev);
+		m_blocks[prev].size += m_blocks[block].size;
+		m_blocks[prev].nextPhysical = m_blocks[block].nextPhysical;
+		if (m_blocks[prev].nextPhysical != kInvalid) {
+			m_blocks[m_blocks[prev].nextPhysical].prevPhysical = prev;
+		}
+		releaseBlock(block);
+		block = prev;
+	}
+	insertFree(block);
+}
+
+void
+RangeAllocator::compact(std::vector<RangeMove>& moves) {
+	moves.clear();
+	std::vector<unsigned int> live;
+	live.reserve(m_allocations);
+	for (unsigned int block = m_first; block != kInvalid;) {
+		const unsigned int next = m_blocks[block].nextPhysical;
+		if (m_blocks[block].free) {
+			removeFree(block);
+			releaseBlock(block);
+		}
+		else {
+			live.push_back(block);
+		}
+		block = next;
+	}
+
+	// Los bloques vivos conservan su índice; solo cambia el offset.
+	unsigned int offset = 0;
+	unsigned int prev = kInvalid;
+	for (unsigned int block : live) {
+		Block& entry = m_blocks[block];
+		if (entry.offset != offset) {
+			moves.push_back({ entry.offset, offset, entry.size });
+			entry.offset = offset;
+		}
+		entry.prevPhysical = prev;
+		entry.nextPhysical = kInvalid;
+		if (prev != kInvalid) {
+			m_blocks[prev].nextPhysical = block;
+		}
+		offset += entry.size;
+		prev = block;
+	}
+	m_first = live.empty() ? kInvalid : live.front();
+	if (offset < m_capacity) {
+		const unsigned int tail = createBlock();
+		m_blocks[tail].offset = offset;
+		m_blocks[tail].size = m_capacity - offset;
+		m_blocks[tail].prevPhysical = prev;
+		if (prev != kInvalid) {
+			m_blocks[prev].nextPhysical = tail;
+		}
+		else {
+			m_first = tail;
+		}
+		insertFree(tail);
+	}
+}
+
+RangeAllocatorStats
+RangeAllocator::getStats() const {
+	RangeAllocatorStats stats;
+	stats.capacity = m_capacity;
+	stats.used = m_used;
+	stats.allocations = m_allocations;
+	for (unsigned int block = m_first; block != kInvalid; block = m_blocks[block].nextPhysical) {
+		if (m_blocks[block].free) {
+			++stats.freeBlocks;
+			stats.largestFree = std::max(stats.largestFree, m_blocks[block].size);
+		}
+	}
+	return stats;
+}
+
+bool
+RangeAllocator::validate() const {
+	// Lista física: contigua desde 0, cubre la capacidad y nunca deja dos huecos seguidos.
+	unsigned int offset = 0;
+	unsigned int used = 0;
+	unsigned int allocations = 0;
+	unsigned int freeBlocks = 0;
+	unsigned int prev = kInvalid;
+	for (unsigned int block = m_first; block != kInvalid; block = m_blocks[block].nextPhysical) {
+		const Block& entry = m_blocks[block];
+		if (entry.offset != offset || entry.size == 0 || entry.prevPhysical != prev) {
+			return false;
+		}
+		if (entry.free) {
+			if (prev != kInvalid && m_blocks[prev].free) {
+				return false;
+			}
+			++freeBlocks;
+		}
+		else {
+			used += entry.size;
+			++allocations;
+		}
+		offset += entry.size;
+		prev = block;
+	}
+	if (offset != m_capacity || used != m_used || allocations != m_allocations) {
+		return false;
+	}
+
+	// Listas libres: cada hueco en la de su clase y los bitmaps de acuerdo con las cabezas.
+	unsigned int listed = 0;
+	for (unsigned int firstLevel = 0; firstLevel < kFirstLevelCount; ++firstLevel) {
+		for (unsigned int secondLevel = 0; secondLevel < kSecondLevelCount; ++secondLevel) {
+			const unsigned int head = m_heads[firstLevel][secondLevel];
+			const bool bit = (m_secondLevelMaps[firstLevel] >> secondLevel) & 1u;
+			if (bit != (head != kInvalid)) {
+				return false;
+			}
+			for (unsigned int block = head; block != kInvalid; block = m_blocks[block].nextFree) {
+				unsigned int fl, sl;
+				mapping(m_blocks[block].size, fl, sl);
+				if (!m_blocks[block].free || fl != firstLevel || sl != secondLevel) {
+					return false;
+				}
+				++listed;
+			}
+		}
+		if (bool((m_firstLevelMap >> firstLevel) & 1u) != (m_secondLevelMaps[firstLevel] != 0)) {
+			return false;
+		}
+	}
+	return listed == freeBlocks;
+}
+
+HRESULT
+GeometryHeap::init(Device& device, DeviceContext& deviceContext) {
+	if (!device.m_device || !deviceContext.m_deviceContext) {
+		ERROR("GeometryHeap", "init", "Device or DeviceContext is nullptr");
+		return E_POINTER;
+	}
+	m_device = &device;
+	m_deviceContext = &deviceContext;
+	return S_OK;
+}
+
+void
+GeometryHeap::destroy() {
+	for (Pool& pool : m_pools) {
+		for (Page& page : pool.pages) {
+			SAFE_RELEASE(page.buffer);
+		}
+	}
+	m_pools.clear();
+	m_allocations.clear();
+	m_freeHandles.clear();
+	m_device = nullptr;
+	m_deviceContext = nullptr;
+}
+
+HRESULT
+GeometryHeap::createPage(Pool& pool, unsigned int units, Page& page) {
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = units * pool.elementSize;
+	desc.BindFlags = pool.bindFlag;
+	page.buffer = nullptr;
+	HRESULT hr = m_device->CreateBuffer(&desc, nullptr, &page.buffer);
+	if (FAILED(hr)) {
+		ERROR("GeometryHeap", "createPage", "Failed to create a geometry page");
+		return hr;
+	}
+	page.allocator.init(units);
+	return S_OK;
+}
+
+bool
+GeometryHeap::allocate(unsigned int bindFlag, unsigned int elementSize, unsigned int count, const void* data, Slot& slot) {
+	unsigned int poolIndex = 0;
+	while (poolIndex < m_pools.size() &&
+		(m_pools[poolIndex].bindFlag != bindFlag || m_pools[poolIndex].elementSize != elementSize)) {
+		++poolIndex;
+	}
+	if (poolIndex == m_pools.size()) {
+		m_pools.push_back({ bindFlag, elementSize, std::vector<Page>() });
+	}
+	Pool& pool = m_pools[poolIndex];
+
+	slot.pool = poolIndex;
+	slot.block = RangeAllocator::kInvalid;
+	for (slot.page = 0; slot.page < pool.pages.size(); ++slot.page) {
+		slot.block = pool.pages[slot.page].allocator.allocate(count);
+		if (slot.block != RangeAllocator::kInvalid) {
+			break;
+		}
+	}
+	if (slot.block == RangeAllocator::kInvalid) {
+		// Página nueva; una malla más grande que una página ocupa una a su medida.
+		const unsigned int pageBytes = bindFlag == D3D11_BIND_VERTEX_BUFFER ? kVertexPageBytes : kIndexPageBytes;
+		Page page;
+		if (FAILED(createPage(pool, std::max(pageBytes / elementSize, count), page))) {
+			return false;
+		}
+		pool.pages.push_back(page);
+		slot.page = static_cast<unsigned int>(pool.pages.size() - 1);
+		slot.block = pool.pages[slot.page].allocator.allocate(count);
+	}
+
+	Page& page = pool.pages[slot.page];
+	D3D11_BOX box = {};
+	box.left = page.allocator.getOffset(slot.block) * elementSize;
+	box.right = box.left + count * elementSize;
+	box.bottom = 1;
+	box.back = 1;
+	m_deviceContext->UpdateSubresource(page.buffer, 0, &box, data, 0, 0);
+	return true;
+}
+
+void
+GeometryHeap::free(const Slot& slot) {
+	m_pools[slot.pool].pages[slot.page].allocator.free(slot.block);
+}
+
+unsigned int
+GeometryHeap::add(const MeshComponent& mesh) {
+	if (!isReady() || mesh.m_vertex.empty() || mesh.m_index.empty()) {
+		return kInvalidHandle;
+	}
+
+	// Misma codificación que Buffer::init: los datos en CPU son float/32 bits.
+	std::vector<unsigned char> vertices;
+	const void* vertexData = mesh.m_vertex.data();
+	if (mesh.m_vertexLayout.isCompact()) {
+		VertexCodec::encodeVertices(mesh.m_vertex, mesh.m_vertexLayout, vertices);
+		vertexData = vertices.data();
+	}
+	std::vector<unsigned char> indices;
+	const void* indexData = mesh.m_index.data();
+	if (mesh.m_indexFormat == INDEX_UINT16) {
+		if (!VertexCodec::encodeIndices(mesh.m_index, INDEX_UINT16, indices)) {
+			ERROR("GeometryHeap", "add", "Index out of range for a 16-bit index buffer");
+			return kInvalidHandle;
+		}
+		indexData = indices.data();
+	}
+
+	Allocation allocation;
+	allocation.indexFormat = VertexCodec::getDXGIFormat(mesh.m_indexFormat);
+	allocation.references = 1;
+	if (!allocate(D3D11_BIND_VERTEX_BUFFER, mesh.m_vertexLayout.getStride(),
+		static_cast<unsigned int>(mesh.m_vertex.size()), vertexData, allocation.vertices)) {
+		return kInvalidHandle;
+	}
+	if (!allocate(D3D11_BIND_INDEX_BUFFER, VertexCodec::getIndexSize(mesh.m_indexFormat),
+		static_cast<unsigned int>(mesh.m_index.size()), indexData, allocation.indices)) {
+		free(allocation.vertices);
+		return kInvalidHandle;
+	}
+
+	unsigned int handle;
+	if (!m_freeHandles.empty()) {
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+		m_allocations[handle] = allocation;
+	}
+	else {
+		handle = static_cast<unsigned int>(m_allocations.size());
+		m_allocations.push_back(allocation);
+	}
+	return handle;
+}
+
+void
+GeometryHeap::addRef(unsigned int handle) {
+	if (handle < m_allocations.size() && m_allocations[handle].references > 0) {
+		++m_allocations[handle].references;
+	}
+}
+
+void
+GeometryHeap::release(unsigned int handle) {
+	if (handle >= m_allocations.size() || m_allocations[handle].references == 0) {
+		return;
+	}
+	Allocation& allocation = m_allocations[handle];
+	if (--allocation.references > 0) {
+		return;
+	}
+	free(allocation.vertices);
+	free(allocation.indices);
+	m_freeHandles.push_back(handle);
+}
+
+bool
+GeometryHeap::getRange(unsigned int handle, GeometryRange& range) const {
+	if (handle >= m_allocations.size() || m_allocations[handle].references == 0) {
+		return false;
+	}
+	const Allocation& allocation = m_allocations[handle];
+	const Pool& vertexPool = m_pools[allocation.vertices.pool];
+	const Page& vertexPage = vertexPool.pages[allocation.vertices.page];
+	const Page& indexPage = m_pools[allocation.indices.pool].pages[allocation.indices.page];
+	range.vertexBuffer = vertexPage.buffer;
+	range.vertexStride = vertexPool.elementSize;
+	range.baseVertex = static_cast<int>(vertexPage.allocator.getOffset(allocation.vertices.block));
+	range.indexBuffer = indexPage.buffer;
+	range.indexFormat = allocation.indexFormat;
+	range.startIndex = indexPage.allocator.getOffset(allocation.indices.block);
+	return true;
+}
+
+unsigned int
+GeometryHeap::defragment() {
+	m_defragMoves = 0;
+	m_defragBytes = 0;
+	if (!isReady()) {
+		return 0;
+	}
+	std::vector<RangeMove> moves;
+	for (Pool& pool : m_pools) {
+		for (Page& page : pool.pages) {
+			if (page.allocator.getStats().freeBlocks < 2) {
+				continue;
+			}
+			// Página nueva del mismo tamaño: la copia no puede solapar origen y destino en un mismo recurso.
+			Page compacted;
+			if (FAILED(createPage(pool, page.allocator.getStats().capacity, compacted))) {
+				continue;
+			}
+			compacted.allocator = page.allocator;
+			compacted.allocator.compact(moves);
+
+			// Los bloques que no se mueven también se copian (el buffer nuevo empieza vacío), y los
+			// que eran contiguos en el origen se copian juntos.
+			const unsigned int used = compacted.allocator.getStats().used;
+			unsigned int offset = 0;
+			size_t move = 0;
+			while (offset < used) {
+				unsigned int source = offset;
+				unsigned int size = 0;
+				if (move < moves.size() && moves[move].destination == offset) {
+					source = moves[move].source;
+					size = moves[move].size;
+					while (++move < moves.size() && moves[move].source == source + size) {
+						size += moves[move].size;
+					}
+				}
+				else {
+					// Tramo sin mover hasta el primer bloque desplazado (o el final de lo usado).
+					size = (move < moves.size() ? moves[move].destination : used) - offset;
+				}
+				D3D11_BOX box = {};
+				box.left = source * pool.elementSize;
+				box.right = box.left + size * pool.elementSize;
+				box.bottom = 1;
+				box.back = 1;
+				m_deviceContext->CopySubresourceRegion(compacted.buffer, 0, offset * pool.elementSize, 0, 0,
+					page.buffer, 0, &box);
+				++m_defragMoves;
+				m_defragBytes += uint64_t(size) * pool.elementSize;
+				offset += size;
+			}
+			SAFE_RELEASE(page.buffer);
+			page = compacted;
+		}
+	}
+	return m_defragMoves;
+}
+
+GeometryHeapStats
+GeometryHeap::getStats() const {
+	GeometryHeapStats stats;
+	stats.meshes = static_cast<unsigned int>(m_allocations.size() - m_freeHandles.size());
+	for (const Pool& pool : m_pools) {
+		for (const Page& page : pool.pages) {
+			const RangeAllocatorStats pageStats = page.allocator.getStats();
+			++stats.pages;
+			stats.capacityBytes += uint64_t(pageStats.capacity) * pool.elementSize;
+			stats.usedBytes += uint64_t(pageStats.used) * pool.elementSize;
+			stats.largestFreeBytes = std::max(stats.largestFreeBytes, uint64_t(pageStats.largestFree) * pool.elementSize);
+			stats.freeBlocks += pageStats.freeBlocks;
+			stats.fragmentation = std::max(stats.fragmentation, pageStats.getFragmentation());
+		}
+	}
+	stats.defragMoves = m_defragMoves;
+	stats.defragBytes = m_defragBytes;
+	return stats;
+}
+
+GeometryHeapBenchmark
+GeometryHeap::benchmark(unsigned int meshes, unsigned int operations) {
+	GeometryHeapBenchmark result;
+	result.operations = operations;
+	result.meshes = meshes;
+	std::mt19937 rng(42);
+
+	// Asignador: altas y bajas aleatorias; cada unidad guarda el bloque que la ocupa para detectar solapes.
+	const unsigned int capacity = 1u << 20;
+	RangeAllocator allocator;
+	allocator.init(capacity);
+	std::vector<unsigned int> owner(capacity, 0);
+	std::vector<unsigned int> live;
+	bool valid = true;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int op = 0; op < operations; ++op) {
+		if (!live.empty() && (rng() % 100 < 45 || allocator.getStats().used > capacity / 10 * 9)) {
+			const size_t pick = rng() % live.size();
+			const unsigned int block = live[pick];
+			std::fill_n(owner.begin() + allocator.getOffset(block), allocator.getSize(block), 0u);
+			allocator.free(block);
+			live[pick] = live.back();
+			live.pop_back();
+		}
+		else {
+			const unsigned int size = rng() % 8 == 0 ? 1 + rng() % 65536 : 1 + rng() % 4096;
+			const unsigned int block = allocator.allocate(size);
+			if (block == RangeAllocator::kInvalid) {
+				continue;
+			}
+			const unsigned int offset = allocator.getOffset(block);
+			for (unsigned int unit = offset; unit < offset + size; ++unit) {
+				valid = valid && owner[unit] == 0;
+				owner[unit] = block + 1;
+			}
+			live.push_back(block);
+		}
+		if (op % 1024 == 0) {
+			valid = valid && allocator.validate();
+		}
+	}
+	result.allocatorMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.fragmentation = allocator.getStats().getFragmentation();
+
+	// Compactar y aplicar los movimientos al contenido: cada bloque debe seguir teniendo lo suyo.
+	std::vector<RangeMove> moves;
+	allocator.compact(moves);
+	result.compactMoves = static_cast<unsigned int>(moves.size());
+	for (const RangeMove& move : moves) {
+		std::copy_n(owner.begin() + move.source, move.size, owner.begin() + move.destination);
+	}
+	for (unsigned int block : live) {
+		const unsigned int offset = allocator.getOffset(block);
+		for (unsigned int unit = offset; unit < offset + allocator.getSize(block); ++unit) {
+			valid = valid && owner[unit] == block + 1;
+		}
+	}
+	const RangeAllocatorStats stats = allocator.getStats();
+	result.allocatorValid = valid && allocator.validate() && stats.freeBlocks <= 1 && stats.allocations == live.size();
+
+	// Escena: mallas de tamaños variados con un par de buffers propios o en páginas del heap.
+	const unsigned int stride = sizeof(SimpleVertex);
+	RangeAllocator page;
+	page.init(kVertexPageBytes / stride);
+	unsigned int pageIndex = 0;
+	std::vector<DrawPacket> packets(meshes);
+	std::vector<float> depths(meshes);
+	for (unsigned int mesh = 0; mesh < meshes; ++mesh) {
+		DrawPacket& packet = packets[mesh];
+		packet.vertexShader = fakeObject<ID3D11VertexShader>(1, 0);
+		packet.pixelShader = fakeObject<ID3D11PixelShader>(2, 0);
+		packet.inputLayout = fakeObject<ID3D11InputLayout>(3, 0);
+		packet.blendState = fakeObject<ID3D11BlendState>(4, 0);
+		packet.rasterizerState = fakeObject<ID3D11RasterizerState>(5, 0);
+		packet.sampler = fakeObject<ID3D11SamplerState>(7, 0);
+		packet.texture = fakeObject<ID3D11ShaderResourceView>(8, mesh % 16);
+		packet.vertexStride = stride;
+		packet.indexCount = 3 * (64 + rng() % 4096);
+		depths[mesh] = 1.0f + float(rng() % 50000) * 0.01f;
+
+		const unsigned int vertices = 256 + rng() % 32768;
+		if (page.allocate(vertices) == RangeAllocator::kInvalid) {
+			page.init(kVertexPageBytes / stride);
+			page.allocate(vertices);
+			++pageIndex;
+		}
+		packet.vertexBuffer = fakeObject<ID3D11Buffer>(9, pageIndex);
+		packet.indexBuffer = fakeObject<ID3D11Buffer>(10, pageIndex);
+	}
+	result.pages = pageIndex + 1;
+
+	RenderQueue queue;
+	auto countBinds = [&]() {
+		queue.begin();
+		for (unsigned int mesh = 0; mesh < meshes; ++mesh) {
+			queue.push(packets[mesh], RENDER_PASS_OPAQUE, depths[mesh]);
+		}
+		queue.sort(nullptr);
+		queue.submit(nullptr);
+		return queue.getStats().bindsIssued;
+	};
+	result.heapBinds = countBinds();
+	for (unsigned int mesh = 0; mesh < meshes; ++mesh) {
+		packets[mesh].vertexBuffer = fakeObject<ID3D11Buffer>(9, mesh);
+		packets[mesh].indexBuffer = fakeObject<ID3D11Buffer>(10, mesh);
+	}
+	result.ownBufferBinds = countBinds();
+	return result;
+}
@@ -0,0 +1,449 @@
+﻿/**
+ * @file InstanceBatcher.cpp
+ * @brief Agrupación por malla y material, empaquetado de instancias y programa instanciado.
+ */
+
+#include "InstanceBatcher.h"
+#include "Device.h"
+#include "DeviceContext.h"
+#include "Hash.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+	/// VS instanciado: la matriz y el color llegan por instancia; cámara en b0/b1 como el programa principal.
+	const char kInstancedVertexSource[] = R"(
+Texture2D txDiffuse : register(t0);
+SamplerState samLinear : register(s0);
+
+cbuffer cbNeverChanges : register(b0) { matrix View; };
+cbuffer cbChangeOnResize : register(b1) { matrix Projection; };
+
+struct VS_INPUT {
+    float4 Pos : POSITION;
+    float2 Tex : TEXCOORD0;
+    float4 World0 : INSTANCE_WORLD0;
+    float4 World1 : INSTANCE_WORLD1;
+    float4 World2 : INSTANCE_WORLD2;
+    float4 World3 : INSTANCE_WORLD3;
+    float4 Color : INSTANCE_COLOR0;
+};
+
+struct PS_INPUT {
+    float4 Pos : SV_POSITION;
+    float2 Tex : TEXCOORD0;
+    float4 Color : COLOR0;
+};
+
+PS_INPUT VS(VS_INPUT input) {
+    PS_INPUT output;
+    float4x4 world = float4x4(input.World0, input.World1, input.World2, input.World3);
+    output.Pos = mul(input.Pos, world);
+    output.Pos = mul(output.Pos, View);
+    output.Pos = mul(output.Pos, Projection);
+    output.Tex = input.Tex;
+    output.Color = input.Color;
+    return output;
+}
+)";
+
+	/// PS de los pases opacos: textura por el color de la instancia.
+	const char kInstancedPixelSource[] = R"(
+float4 PS(PS_INPUT input) : SV_Target {
+    return txDiffuse.Sample(samLinear, input.Tex) * input.Color;
+}
+)";
+
+	/// PS de las sombras: el color de sombra (con su alfa) viaja en la instancia en lugar de en b2.
+	const char kInstancedShadowSource[] = R"(
+float4 PS(PS_INPUT input) : SV_Target {
+    return input.Color;
+}
+)";
+
+	/// Hash de una clave de palabras de 64 bits (FNV-1a por palabra con mezcla final).
+	uint64_t
+	hashWords(const uint64_t* words, size_t count) {
+		uint64_t hash = kHashSeed;
+		for (size_t i = 0; i < count; ++i) {
+			hash = (hash ^ words[i]) * 1099511628211ull;
+		}
+		hash ^= hash >> 29;
+		hash *= 0xBF58476D1CE4E5B9ull;
+		return hash ^ (hash >> 32);
+	}
+
+	/// Puntero ficticio para la escena sintética (nunca se desreferencia).
+	template<typename T>
+	T*
+	fakeObject(unsigned int kind, unsigned int index) {
+		return reinterpret_cast<T*>((uintptr_t(kind) << 24) | (uintptr_t(index + 1) << 4));
+	}
+}
+
+HRESULT
+InstanceBatcher::init(Device& device) {
+	std::vector<D3D11_INPUT_ELEMENT_DESC> instanceElements;
+	getInstanceElements(instanceElements);
+	m_program.setInstanceElements(instanceElements);
+
+	std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
+	VertexLayout().getInputElements(layout);
+	layout.insert(layout.end(), instanceElements.begin(), instanceElements.end());
+	HRESULT hr = m_program.initFromSource(device, "InstancedActors",
+		std::string(kInstancedVertexSource) + kInstancedPixelSource, layout);
+	if (FAILED(hr)) {
+		ERROR("InstanceBatcher", "init", "Failed to create the instanced shader program.");
+		return hr;
+	}
+	// Solo se usa su PS: el VS y los Input Layouts del programa principal tienen la misma firma.
+	hr = m_shadowProgram.initFromSource(device, "InstancedShadows",
+		std::string(kInstancedVertexSource) + kInstancedShadowSource, layout);
+	if (FAILED(hr)) {
+		ERROR("InstanceBatcher", "init", "Failed to create the instanced shadow program.");
+		return hr;
+	}
+
+	hr = m_instanceBuffer.init(device, sizeof(InstanceData), kInitialCapacity);
+	if (FAILED(hr)) {
+		ERROR("InstanceBatcher", "init", "Failed to create the instance buffer.");
+		return hr;
+	}
+	m_capacity = kInitialCapacity;
+	setShaders(m_program.m_VertexShader, m_program.m_PixelShader, m_shadowProgram.m_PixelShader);
+	setInputLayout(VertexLayout(), m_program.getInputLayout(VertexLayout()));
+	m_ready = true;
+	return S_OK;
+}
+
+HRESULT
+InstanceBatcher::createInputLayout(Device& device, const VertexLayout& layout) {
+	if (!m_ready) {
+		return E_FAIL;
+	}
+	const HRESULT hr = m_program.CreateInputLayout(device, layout);
+	if (SUCCEEDED(hr)) {
+		setInputLayout(layout, m_program.getInputLayout(layout));
+	}
+	return hr;
+}
+
+void
+InstanceBatcher::setShaders(ID3D11VertexShader* vertexShader,
+	ID3D11PixelShader* pixelShader,
+	ID3D11PixelShader* shadowPixelShader) {
+	m_vertexShader = vertexShader;
+	m_pixelShader = pixelShader;
+	m_shadowPixelShader = shadowPixelShader;
+}
+
+void
+InstanceBatcher::setInputLayout(const VertexLayout& layout, ID3D11InputLayout* inputLayout) {
+	if (inputLayout) {
+		m_inputLayouts[layout.getKey()] = inputLayout;
+	}
+	else {
+		m_inputLayouts.erase(layout.getKey());
+	}
+}
+
+void
+InstanceBatcher::destroy() {
+	setShaders(nullptr, nullptr, nullptr);
+	m_inputLayouts.clear();
+	m_program.destroy();
+	m_shadowProgram.destroy();
+	m_instanceBuffer.destroy();
+	m_capacity = 0;
+	m_ready = false;
+}
+
+void
+InstanceBatcher::begin() {
+	m_groups.clear();
+	m_groupLookup.clear();
+	m_items.clear();
+}
+
+bool
+InstanceBatcher::add(const DrawPacket& packet,
+	const VertexLayout& layout,
+	RenderPass pass,
+	float depth,
+	const XMMATRIX& world,
+	const XMFLOAT4& color) {
+	DrawPacket p = packet;
+	if (m_vertexShader) {
+		auto inputLayout = m_inputLayouts.find(layout.getKey());
+		if (inputLayout == m_inputLayouts.end()) {
+			return false;
+		}
+		p.inputLayout = inputLayout->second;
+		p.vertexShader = m_vertexShader;
+		// El PS de sombra del actor lee su color de b2, que el lote no enlaza: se usa el instanciado.
+		p.pixelShader = pass == RENDER_PASS_SHADOW ? m_shadowPixelShader : m_pixelShader;
+	}
+	// La constante por objeto viaja en la instancia; el lote dibuja el rango completo del LOD.
+	p.constantBuffer = nullptr;
+	p.constantData = nullptr;
+	p.constantSize = 0;
+	p.ranges = nullptr;
+	p.rangeCount = 0;
+
+	GroupKey key;
+	key.words[0] = pass;
+	key.words[1] = uintptr_t(p.vertexShader);
+	key.words[2] = uintptr_t(p.pixelShader);
+	key.words[3] = uintptr_t(p.inputLayout);
+	key.words[4] = uintptr_t(p.blendState);
+	key.words[5] = uintptr_t(p.rasterizerState);
+	key.words[6] = uintptr_t(p.depthStencilState);
+	key.words[7] = uintptr_t(p.sampler);
+	key.words[8] = uintptr_t(p.texture);
+	key.words[9] = uintptr_t(p.vertexBuffer);
+	key.words[10] = (uint64_t(p.vertexStride) << 32) | p.vertexOffset;
+	key.words[11] = uintptr_t(p.indexBuffer);
+	key.words[12] = p.indexFormat;
+	key.words[13] = (uint64_t(p.indexCount) << 32) | p.indexOffset;
+	key.words[14] = (uint64_t(uint32_t(p.baseVertex)) << 32) | p.startIndex;
+	const uint64_t hash = hashWords(key.words, sizeof(key.words) / sizeof(key.words[0]));
+
+	// Grupo existente con la misma clave (la cadena solo crece si dos claves comparten hash).
+	unsigned int group = ~0u;
+	auto found = m_groupLookup.find(hash);
+	if (found != m_groupLookup.end()) {
+		unsigned int candidate = found->second;
+		while (candidate != ~0u && std::memcmp(m_groups[candidate].key.words, key.words, sizeof(key.words)) != 0) {
+			candidate = m_groups[candidate].next;
+		}
+		group = candidate;
+	}
+	if (group == ~0u) {
+		Group created;
+		created.key = key;
+		created.packet = p;
+		created.pass = pass;
+		created.depth = depth;
+		created.count = 0;
+		created.next = found != m_groupLookup.end() ? found->second : ~0u;
+		group = static_cast<unsigned int>(m_groups.size());
+		m_groups.push_back(created);
+		m_groupLookup[hash] = group;
+	}
+
+	Group& target = m_groups[group];
+	target.depth = pass == RENDER_PASS_SHADOW ? std::max(target.depth, depth) : std::min(target.depth, depth);
+	++target.count;
+
+	Item item;
+	item.group = group;
+	XMStoreFloat4x4(&item.data.world, world);
+	item.data.color = color;
+	m_items.push_back(item);
+	return true;
+}
+
+void
+InstanceBatcher::build() {
+	const auto start = std::chrono::steady_clock::now();
+	const unsigned int groupCount = static_cast<unsigned int>(m_groups.size());
+
+	// Counting sort estable: cada grupo ocupa un rango contiguo en el orden en que se agregaron sus instancias.
+	m_offsets.resize(groupCount);
+	m_batches.resize(groupCount);
+	unsigned int offset = 0;
+	for (unsigned int g = 0; g < groupCount; ++g) {
+		const Group& group = m_groups[g];
+		InstanceBatch& batch = m_batches[g];
+		batch.packet = group.packet;
+		batch.packet.instanceStride = sizeof(InstanceData);
+		batch.packet.firstInstance = offset;
+		batch.packet.instanceCount = group.count;
+		batch.pass = group.pass;
+		batch.depth = group.depth;
+		m_offsets[g] = offset;
+		offset += group.count;
+	}
+	m_instances.resize(m_items.size());
+	for (const Item& item : m_items) {
+		m_instances[m_offsets[item.group]++] = item.data;
+	}
+
+	m_stats.instances = static_cast<unsigned int>(m_items.size());
+	m_stats.batches = groupCount;
+	m_stats.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+HRESULT
+InstanceBatcher::upload(Device& device, DeviceContext& deviceContext) {
+	return upload(device, deviceContext, m_instances, m_stats);
+}
+
+HRESULT
+InstanceBatcher::upload(Device& device,
+	DeviceContext& deviceContext,
+	const std::vector<InstanceData>& instances,
+	InstancingStats& stats) {
+	const auto start = std::chrono::steady_clock::now();
+	if (!m_ready) {
+		ERROR("InstanceBatcher", "upload", "Instancing is not initialized.");
+		return E_FAIL;
+	}
+	const unsigned int count = static_cast<unsigned int>(instances.size());
+	if (count > m_capacity) {
+		unsigned int capacity = std::max(m_capacity, kInitialCapacity);
+		while (capacity < count) {
+			capacity *= 2;
+		}
+		// El nuevo se crea antes de liberar el anterior: no puede reutilizar su dirección en este frame.
+		Buffer grown;
+		HRESULT hr = grown.init(device, sizeof(InstanceData), capacity);
+		if (FAILED(hr)) {
+			ERROR("InstanceBatcher", "upload", "Failed to grow the instance buffer.");
+			return hr;
+		}
+		m_instanceBuffer.destroy();
+		m_instanceBuffer = grown;
+		m_capacity = capacity;
+	}
+	if (count > 0) {
+		D3D11_BOX box = {};
+		box.right = count * sizeof(InstanceData);
+		box.bottom = 1;
+		box.back = 1;
+		m_instanceBuffer.update(deviceContext, nullptr, 0, &box, instances.data(), 0, 0);
+	}
+	stats.capacity = m_capacity;
+	stats.uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return S_OK;
+}
+
+void
+InstanceBatcher::submit(RenderQueue& queue) const {
+	submit(queue, m_batches);
+}
+
+void
+InstanceBatcher::submit(RenderQueue& queue, const std::vector<InstanceBatch>& batches) const {
+	for (const InstanceBatch& batch : batches) {
+		DrawPacket packet = batch.packet;
+		packet.instanceBuffer = m_instanceBuffer.raw();
+		queue.push(packet, batch.pass, batch.depth);
+	}
+}
+
+void
+InstanceBatcher::getInstanceElements(std::vector<D3D11_INPUT_ELEMENT_DESC>& elements) {
+	elements.clear();
+	for (unsigned int row = 0; row < 4; ++row) {
+		D3D11_INPUT_ELEMENT_DESC world{};
+		world.SemanticName = "INSTANCE_WORLD";
+		world.SemanticIndex = row;
+		world.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		world.InputSlot = 1;
+		world.AlignedByteOffset = row * sizeof(XMFLOAT4);
+		world.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+		world.InstanceDataStepRate = 1;
+		elements.push_back(world);
+	}
+
+	D3D11_INPUT_ELEMENT_DESC color{};
+	color.SemanticName = "INSTANCE_COLOR";
+	color.SemanticIndex = 0;
+	color.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	color.InputSlot = 1;
+	color.AlignedByteOffset = offsetof(InstanceData, color);
+	color.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+	color.InstanceDataStepRate = 1;
+	elements.push_back(color);
+}
+
+InstancingBenchmark
+InstanceBatcher::benchmark(unsigned int instances, unsigned int meshes) {
+	InstancingBenchmark result;
+	result.instances = instances;
+	result.meshes = std::max(1u, meshes);
+
+	// Actores que comparten result.meshes mallas y estados, cada uno con su buffer de constantes.
+	std::vector<DrawPacket> packets(instances);
+	std::vector<CBChangesEveryFrame> constants(instances);
+	std::vector<XMFLOAT4X4> worlds(instances);
+	std::vector<float> depths(instances);
+	for (unsigned int i = 0; i < instances; ++i) {
+		const unsigned int mesh = i % result.meshes;
+		DrawPacket& packet = packets[i];
+		packet.vertexShader = fakeObject<ID3D11VertexShader>(1, 0);
+		packet.pixelShader = fakeObject<ID3D11PixelShader>(2, 0);
+		packet.inputLayout = fakeObject<ID3D11InputLayout>(3, 0);
+		packet.blendState = fakeObject<ID3D11BlendState>(4, 0);
+		packet.rasterizerState = fakeObject<ID3D11RasterizerState>(5, 0);
+		packet.sampler = fakeObject<ID3D11SamplerState>(7, 0);
+		packet.texture = fakeObject<ID3D11ShaderResourceView>(8, mesh);
+		packet.vertexBuffer = fakeObject<ID3D11Buffer>(9, mesh);
+		packet.vertexStride = sizeof(SimpleVertex);
+		packet.indexBuffer = fakeObject<ID3D11Buffer>(10, mesh);
+		packet.indexCount = 3 * (500 + mesh);
+		packet.constantBuffer = fakeObject<ID3D11Buffer>(11, i);
+		packet.constantData = &constants[i];
+		XMStoreFloat4x4(&worlds[i], XMMatrixTranslation(float(i), float(mesh), 0.0f));
+		constants[i].mWorld = XMMatrixTranspose(XMLoadFloat4x4(&worlds[i]));
+		depths[i] = 1.0f + float(i % 1000) * 0.1f;
+	}
+
+	// Mejor de varias repeticiones: la primera paga la reserva de memoria.
+	const int kRuns = 5;
+	RenderQueue actorQueue;
+	for (int run = 0; run < kRuns; ++run) {
+		const auto start = std::chrono::steady_clock::now();
+		actorQueue.begin();
+		for (unsigned int i = 0; i < instances; ++i) {
+			actorQueue.push(packets[i], RENDER_PASS_OPAQUE, depths[i]);
+		}
+		actorQueue.sort(nullptr);
+		actorQueue.submit(nullptr);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.actorSubmitMs = run == 0 ? ms : std::min(result.actorSubmitMs, ms);
+	}
+	result.actorDrawCalls = actorQueue.getStats().drawCalls;
+	result.actorUploads = actorQueue.getStats().uploads;
+
+	InstanceBatcher batcher;
+	RenderQueue instancedQueue;
+	const XMFLOAT4 white(1.0f, 1.0f, 1.0f, 1.0f);
+	for (int run = 0; run < kRuns; ++run) {
+		const auto start = std::chrono::steady_clock::now();
+		batcher.begin();
+		for (unsigned int i = 0; i < instances; ++i) {
+			batcher.add(packets[i], VertexLayout(), RENDER_PASS_OPAQUE, depths[i], XMLoadFloat4x4(&worlds[i]), white);
+		}
+		batcher.build();
+		instancedQueue.begin();
+		batcher.submit(instancedQueue);
+		instancedQueue.sort(nullptr);
+		instancedQueue.submit(nullptr);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (run == 0 || ms < result.instancedSubmitMs) {
+			result.instancedSubmitMs = ms;
+			result.buildMs = batcher.getStats().buildMs;
+		}
+	}
+	result.instancedDrawCalls = instancedQueue.getStats().drawCalls;
+
+	// Cada actor (su índice va en la traslación x) debe aparecer una vez y en el lote de su malla.
+	std::vector<unsigned char> seen(instances, 0);
+	bool correct = batcher.getInstances().size() == instances;
+	for (const InstanceBatch& batch : batcher.getBatches()) {
+		for (unsigned int k = batch.packet.firstInstance; correct && k < batch.packet.firstInstance + batch.packet.instanceCount; ++k) {
+			const XMFLOAT4X4& world = batcher.getInstances()[k].world;
+			const unsigned int actor = static_cast<unsigned int>(world.m[3][0]);
+			correct = actor < instances && !seen[actor] &&
+				packets[actor].vertexBuffer == batch.packet.vertexBuffer &&
+				std::memcmp(&world, &worlds[actor], sizeof(world)) == 0;
+			if (correct) {
+				seen[actor] = 1;
+			}
+		}
+	}
+	result.packedCorrectly = correct;
+	return result;
+}
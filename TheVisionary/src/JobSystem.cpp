@@ -0,0 +1,154 @@
+﻿/**
+ * @file JobSystem.cpp
+ * @brief Implementación del pool de hilos y del bucle paralelo por bloques.
+ */
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+void
+JobSystem::init(unsigned int numThreads) {
+	if (m_running) {
+		ERROR("JobSystem", "init", "JobSystem is already running.");
+		return;
+	}
+
+	if (numThreads == 0) {
+		unsigned int cores = std::thread::hardware_concurrency();
+		numThreads = cores > 1 ? cores - 1 : 1;
+	}
+
+	m_running = true;
+	m_workers.reserve(numThreads);
+	for (unsigned int i = 0; i < numThreads; ++i) {
+		m_workers.emplace_back(&JobSystem::workerLoop, this);
+	}
+	MESSAGE("JobSystem", "init", numThreads << " worker threads");
+}
+
+void
+JobSystem::submit(std::function<void()> job) {
+	if (!job) {
+		return;
+	}
+	// Sin trabajadores la tarea se ejecuta en el hilo que llama.
+	if (m_workers.empty()) {
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+		++m_pendingJobs;
+	}
+	m_jobAvailable.notify_one();
+}
+
+void
+JobSystem::wait() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobsDone.wait(lock, [this]() { return m_pendingJobs == 0; });
+}
+
+void
+JobSystem::parallelFor(unsigned int count,
+	unsigned int grainSize,
+	const std::function<void(unsigned int begin, unsigned int end)>& fn) {
+	if (count == 0 || !fn) {
+		return;
+	}
+	if (grainSize == 0) {
+		grainSize = 1;
+	}
+
+	const unsigned int numChunks = (count + grainSize - 1) / grainSize;
+	if (m_workers.empty() || numChunks == 1) {
+		fn(0, count);
+		return;
+	}
+
+	// Estado compartido: los ayudantes pueden arrancar después de que el
+	// bucle termine, así que se mantiene vivo con un shared_ptr.
+	struct ForState {
+		std::atomic<unsigned int> nextChunk{ 0 };
+		std::atomic<unsigned int> doneChunks{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	auto state = std::make_shared<ForState>();
+
+	auto runChunks = [state, numChunks, count, grainSize, &fn]() {
+		unsigned int chunk;
+		while ((chunk = state->nextChunk.fetch_add(1)) < numChunks) {
+			const unsigned int begin = chunk * grainSize;
+			const unsigned int end = std::min(begin + grainSize, count);
+			fn(begin, end);
+			if (state->doneChunks.fetch_add(1) + 1 == numChunks) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	const unsigned int helpers = std::min(numChunks - 1, getThreadCount());
+	for (unsigned int i = 0; i < helpers; ++i) {
+		submit(runChunks);
+	}
+
+	// El hilo que llama también procesa bloques.
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, numChunks]() {
+		return state->doneChunks.load() == numChunks;
+	});
+}
+
+void
+JobSystem::destroy() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_running) {
+			return;
+		}
+		m_running = false;
+	}
+	m_jobAvailable.notify_all();
+
+	for (auto& worker : m_workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	m_workers.clear();
+	m_jobs.clear();
+	m_pendingJobs = 0;
+}
+
+void
+JobSystem::workerLoop() {
+	Profiler::setThreadName("Job worker");
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobAvailable.wait(lock, [this]() { return !m_running || !m_jobs.empty(); });
+			if (!m_running && m_jobs.empty()) {
+				return;
+			}
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_pendingJobs;
+			if (m_pendingJobs == 0) {
+				m_jobsDone.notify_all();
+			}
+		}
+	}
+}
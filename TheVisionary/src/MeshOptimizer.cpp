@@ -0,0 +1,379 @@
+﻿/**
+ * @file MeshOptimizer.cpp
+ * @brief Implementación de Forsyth (caché de vértices), clusters de overdraw y orden de fetch.
+ */
+
+#include "MeshOptimizer.h"
+#include "MeshComponent.h"
+#include <chrono>
+#include <cmath>
+
+namespace {
+	/// Tamaño de la caché LRU que modela el algoritmo de Forsyth.
+	const unsigned int kForsythCacheSize = 32;
+	/// Valencia máxima con puntuación tabulada.
+	const unsigned int kMaxValenceScore = 32;
+
+	/// Tablas de puntuación de Forsyth (posición en caché y valencia restante).
+	struct ForsythTables {
+		float cache[kForsythCacheSize];
+		float valence[kMaxValenceScore + 1];
+
+		ForsythTables() {
+			for (unsigned int i = 0; i < kForsythCacheSize; ++i) {
+				// Los tres últimos vértices usados puntúan igual para no favorecer tiras.
+				cache[i] = i < 3 ? 0.75f
+					: std::pow(1.0f - float(i - 3) / float(kForsythCacheSize - 3), 1.5f);
+			}
+			valence[0] = 0.0f;
+			for (unsigned int i = 1; i <= kMaxValenceScore; ++i) {
+				// Bonificación a vértices con pocos triángulos vivos: evita dejarlos aislados.
+				valence[i] = 2.0f / std::sqrt(float(i));
+			}
+		}
+	};
+
+	float
+	vertexScore(const ForsythTables& tables, int cachePosition, unsigned int liveTriangles) {
+		if (liveTriangles == 0) {
+			return -1.0f;
+		}
+		float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+		score += tables.valence[std::min(liveTriangles, kMaxValenceScore)];
+		return score;
+	}
+
+	struct Float3 { float x, y, z; };
+
+	inline Float3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Float3 cross(const Float3& a, const Float3& b) {
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+}
+
+VertexCacheStats
+MeshOptimizer::simulateVertexCache(const std::vector<unsigned int>& indices,
+	unsigned int vertexCount,
+	unsigned int cacheSize) {
+	VertexCacheStats stats;
+	stats.triangles = static_cast<unsigned int>(indices.size() / 3);
+	stats.vertices = vertexCount;
+	if (stats.triangles == 0 || vertexCount == 0) {
+		return stats;
+	}
+
+	// FIFO por marcas de tiempo: un vértice está en caché si entró hace menos de cacheSize fallos.
+	std::vector<unsigned int> timestamps(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+	for (unsigned int index : indices) {
+		if (timestamp - timestamps[index] > cacheSize) {
+			timestamps[index] = timestamp++;
+			++stats.transformed;
+		}
+	}
+
+	stats.acmr = float(stats.transformed) / float(stats.triangles);
+	stats.atvr = float(stats.transformed) / float(vertexCount);
+	return stats;
+}
+
+void
+MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount) {
+	const unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+	if (triangleCount == 0) {
+		return;
+	}
+	static const ForsythTables tables;
+
+	// 01. Adyacencia vértice -> triángulos (rangos contiguos; los vivos al principio).
+	std::vector<unsigned int> liveCount(vertexCount, 0);
+	for (unsigned int index : indices) {
+		++liveCount[index];
+	}
+	std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; ++v) {
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+	}
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (unsigned int t = 0; t < triangleCount; ++t) {
+			for (unsigned int k = 0; k < 3; ++k) {
+				const unsigned int v = indices[t * 3 + k];
+				adjacency[fill[v]++] = t;
+			}
+		}
+	}
+
+	// 02. Puntuaciones iniciales.
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; ++v) {
+		vertexScores[v] = vertexScore(tables, -1, liveCount[v]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	unsigned int best = 0;
+	for (unsigned int t = 0; t < triangleCount; ++t) {
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+			vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[best]) {
+			best = t;
+		}
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(kForsythCacheSize + 3);
+	newCache.reserve(kForsythCacheSize + 3);
+	unsigned int cursor = 0;
+	bool haveBest = true;
+
+	for (unsigned int emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		if (!haveBest) {
+			// Sin candidatos en caché: siguiente triángulo pendiente en orden de entrada.
+			while (emitted[cursor]) {
+				++cursor;
+			}
+			best = cursor;
+		}
+
+		// 03. Emitir el mejor triángulo y retirarlo de la adyacencia de sus vértices.
+		const unsigned int* tri = &indices[best * 3];
+		emitted[best] = 1;
+		newCache.clear();
+		for (unsigned int k = 0; k < 3; ++k) {
+			const unsigned int v = tri[k];
+			output.push_back(v);
+
+			unsigned int* begin = &adjacency[adjacencyOffset[v]];
+			unsigned int* end = begin + liveCount[v];
+			unsigned int* found = std::find(begin, end, best);
+			if (found != end) {
+				std::swap(*found, *(end - 1));
+				--liveCount[v];
+			}
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+				newCache.push_back(v);
+			}
+		}
+
+		// 04. Nueva caché LRU: el triángulo al frente, después el resto en orden.
+		for (unsigned int v : cache) {
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+				newCache.push_back(v);
+			}
+		}
+		for (unsigned int i = 0; i < newCache.size(); ++i) {
+			const unsigned int v = newCache[i];
+			cachePosition[v] = i < kForsythCacheSize ? static_cast<int>(i) : -1;
+			vertexScores[v] = vertexScore(tables, cachePosition[v], liveCount[v]);
+		}
+
+		// 05. Repuntuar los triángulos vivos de la caché y elegir el siguiente.
+		haveBest = false;
+		float bestScore = -1.0f;
+		for (unsigned int v : newCache) {
+			const unsigned int* adjacent = &adjacency[adjacencyOffset[v]];
+			for (unsigned int i = 0; i < liveCount[v]; ++i) {
+				const unsigned int t = adjacent[i];
+				const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] +
+					vertexScores[indices[t * 3 + 2]];
+				triangleScores[t] = score;
+				if (score > bestScore) {
+					bestScore = score;
+					best = t;
+					haveBest = true;
+				}
+			}
+		}
+
+		if (newCache.size() > kForsythCacheSize) {
+			newCache.resize(kForsythCacheSize);
+		}
+		cache.swap(newCache);
+	}
+
+	indices.swap(output);
+}
+
+unsigned int
+MeshOptimizer::optimizeOverdraw(const std::vector<SimpleVertex>& vertices,
+	std::vector<unsigned int>& indices,
+	float threshold) {
+	const unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+	if (triangleCount == 0) {
+		return 0;
+	}
+	const unsigned int cacheSize = kDefaultCacheSize;
+	const unsigned int vertexCount = static_cast<unsigned int>(vertices.size());
+
+	// 01. Límites duros: triángulos cuyos tres vértices fallan (la caché se "reinicia").
+	std::vector<unsigned int> hardBoundaries;
+	{
+		std::vector<unsigned int> timestamps(vertexCount, 0);
+		unsigned int timestamp = cacheSize + 1;
+		for (unsigned int t = 0; t < triangleCount; ++t) {
+			unsigned int misses = 0;
+			for (unsigned int k = 0; k < 3; ++k) {
+				const unsigned int v = indices[t * 3 + k];
+				if (timestamp - timestamps[v] > cacheSize) {
+					timestamps[v] = timestamp++;
+					++misses;
+				}
+			}
+			if (t == 0 || misses == 3) {
+				hardBoundaries.push_back(t);
+			}
+		}
+		hardBoundaries.push_back(triangleCount);
+	}
+
+	// 02. Límites blandos: dentro de cada cluster duro, cortar donde el ACMR
+	//     acumulado no supere threshold * ACMR del cluster completo.
+	std::vector<unsigned int> boundaries;
+	{
+		std::vector<unsigned int> timestamps(vertexCount, 0);
+		unsigned int timestamp = cacheSize + 1;
+		for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c) {
+			const unsigned int start = hardBoundaries[c];
+			const unsigned int end = hardBoundaries[c + 1];
+
+			timestamp += cacheSize + 1;
+			unsigned int clusterMisses = 0;
+			for (unsigned int t = start; t < end; ++t) {
+				for (unsigned int k = 0; k < 3; ++k) {
+					const unsigned int v = indices[t * 3 + k];
+					if (timestamp - timestamps[v] > cacheSize) {
+						timestamps[v] = timestamp++;
+						++clusterMisses;
+					}
+				}
+			}
+			const float target = threshold * float(clusterMisses) / float(end - start);
+
+			boundaries.push_back(start);
+			timestamp += cacheSize + 1;
+			unsigned int misses = 0;
+			unsigned int clusterStart = start;
+			for (unsigned int t = start; t < end; ++t) {
+				for (unsigned int k = 0; k < 3; ++k) {
+					const unsigned int v = indices[t * 3 + k];
+					if (timestamp - timestamps[v] > cacheSize) {
+						timestamps[v] = timestamp++;
+						++misses;
+					}
+				}
+				if (t + 1 < end && float(misses) / float(t - clusterStart + 1) <= target) {
+					boundaries.push_back(t + 1);
+					clusterStart = t + 1;
+					misses = 0;
+					timestamp += cacheSize + 1;
+				}
+			}
+		}
+		boundaries.push_back(triangleCount);
+	}
+	const unsigned int clusterCount = static_cast<unsigned int>(boundaries.size() - 1);
+
+	// 03. Centro de la malla (ponderado por área) y orientación de cada cluster.
+	double meshArea = 0.0;
+	double meshCenter[3] = { 0.0, 0.0, 0.0 };
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<Float3> clusterCenters(clusterCount);
+	std::vector<Float3> clusterNormals(clusterCount);
+	for (unsigned int c = 0; c < clusterCount; ++c) {
+		double area = 0.0;
+		double center[3] = { 0.0, 0.0, 0.0 };
+		Float3 normal = { 0.0f, 0.0f, 0.0f };
+		for (unsigned int t = boundaries[c]; t < boundaries[c + 1]; ++t) {
+			const XMFLOAT3& a = vertices[indices[t * 3]].Pos;
+			const XMFLOAT3& b = vertices[indices[t * 3 + 1]].Pos;
+			const XMFLOAT3& p = vertices[indices[t * 3 + 2]].Pos;
+			const Float3 n = cross(sub(b, a), sub(p, a));
+			const float triArea = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+			normal.x += n.x; normal.y += n.y; normal.z += n.z;
+			center[0] += triArea * (a.x + b.x + p.x) / 3.0;
+			center[1] += triArea * (a.y + b.y + p.y) / 3.0;
+			center[2] += triArea * (a.z + b.z + p.z) / 3.0;
+			area += triArea;
+		}
+		meshArea += area;
+		for (int i = 0; i < 3; ++i) meshCenter[i] += center[i];
+
+		const double inv = area > 0.0 ? 1.0 / area : 0.0;
+		clusterCenters[c] = { float(center[0] * inv), float(center[1] * inv), float(center[2] * inv) };
+		const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		clusterNormals[c] = length > 0.0f
+			? Float3{ normal.x / length, normal.y / length, normal.z / length }
+			: Float3{ 0.0f, 0.0f, 0.0f };
+	}
+	const double invMeshArea = meshArea > 0.0 ? 1.0 / meshArea : 0.0;
+	const Float3 center = { float(meshCenter[0] * invMeshArea), float(meshCenter[1] * invMeshArea),
+		float(meshCenter[2] * invMeshArea) };
+
+	// 04. Clusters exteriores (mirando hacia fuera) primero: ocultan a los interiores.
+	std::vector<unsigned int> order(clusterCount);
+	for (unsigned int c = 0; c < clusterCount; ++c) {
+		order[c] = c;
+		const Float3 offset = { clusterCenters[c].x - center.x, clusterCenters[c].y - center.y,
+			clusterCenters[c].z - center.z };
+		sortKeys[c] = offset.x * clusterNormals[c].x + offset.y * clusterNormals[c].y +
+			offset.z * clusterNormals[c].z;
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[&sortKeys](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	for (unsigned int c : order) {
+		output.insert(output.end(), indices.begin() + boundaries[c] * 3, indices.begin() + boundaries[c + 1] * 3);
+	}
+	indices.swap(output);
+	return clusterCount;
+}
+
+unsigned int
+MeshOptimizer::optimizeVertexFetch(std::vector<SimpleVertex>& vertices,
+	std::vector<unsigned int>& indices) {
+	const unsigned int kUnused = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), kUnused);
+	std::vector<SimpleVertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (unsigned int& index : indices) {
+		if (remap[index] == kUnused) {
+			remap[index] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	const unsigned int removed = static_cast<unsigned int>(vertices.size() - reordered.size());
+	vertices.swap(reordered);
+	return removed;
+}
+
+MeshOptimizationReport
+MeshOptimizer::optimize(MeshComponent& mesh) {
+	MeshOptimizationReport report;
+	if (mesh.m_index.empty() || mesh.m_index.size() % 3 != 0) {
+		return report;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	const unsigned int vertexCount = static_cast<unsigned int>(mesh.m_vertex.size());
+
+	report.before = simulateVertexCache(mesh.m_index, vertexCount);
+	optimizeVertexCache(mesh.m_index, vertexCount);
+	report.clusters = optimizeOverdraw(mesh.m_vertex, mesh.m_index);
+	report.removedVertices = optimizeVertexFetch(mesh.m_vertex, mesh.m_index);
+	report.after = simulateVertexCache(mesh.m_index, static_cast<unsigned int>(mesh.m_vertex.size()));
+
+	mesh.m_numVertex = static_cast<int>(mesh.m_vertex.size());
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	report.milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	return report;
+}
@@ -0,0 +1,526 @@
+﻿/**
+ * @file MeshSimplifier.cpp
+ * @brief Implementación del colapso de aristas con cuádricas, clasificación de bordes/costuras y LODs.
+ */
+
+#include "MeshSimplifier.h"
+#include "MeshComponent.h"
+#include "MeshOptimizer.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+namespace {
+	const unsigned int kNone = ~0u;      ///< Sin arista abierta.
+	const unsigned int kMultiple = ~1u;  ///< Más de una arista abierta.
+
+	/// Peso de las cuádricas de borde respecto a las de cara: mantiene la silueta.
+	const double kBorderWeight = 10.0;
+	/// Tope de pasadas por llamada (cada pasada colapsa un conjunto independiente).
+	const unsigned int kMaxPasses = 128;
+
+	enum VertexKind { KIND_MANIFOLD = 0, KIND_BORDER, KIND_SEAM, KIND_LOCKED };
+
+	struct Quadric {
+		double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+		double b0 = 0, b1 = 0, b2 = 0, c = 0, w = 0;
+	};
+
+	void
+	addPlane(Quadric& q, double a, double b, double c, double d, double weight) {
+		q.a00 += weight * a * a; q.a11 += weight * b * b; q.a22 += weight * c * c;
+		q.a01 += weight * a * b; q.a02 += weight * a * c; q.a12 += weight * b * c;
+		q.b0 += weight * a * d; q.b1 += weight * b * d; q.b2 += weight * c * d;
+		q.c += weight * d * d;
+		q.w += weight;
+	}
+
+	void
+	addQuadric(Quadric& q, const Quadric& r) {
+		q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+		q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+		q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+		q.c += r.c; q.w += r.w;
+	}
+
+	/// Distancia cuadrática media (ponderada) del punto a los planos de la cuádrica.
+	double
+	evaluate(const Quadric& q, const XMFLOAT3& p) {
+		const double x = p.x, y = p.y, z = p.z;
+		const double r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+			2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+			2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+		return q.w > 0.0 ? std::fabs(r) / q.w : 0.0;
+	}
+
+	struct Vec3 { double x, y, z; };
+
+	inline Vec3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { double(a.x) - b.x, double(a.y) - b.y, double(a.z) - b.z }; }
+	inline Vec3 cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	inline double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	/**
+	 * @brief Agrupa los vértices con la misma posición exacta (copias por costura UV).
+	 * @return Grupo de cada vértice; los miembros de cada grupo quedan en orden creciente.
+	 */
+	unsigned int
+	buildPositionGroups(const std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& group) {
+		const unsigned int count = static_cast<unsigned int>(vertices.size());
+		std::vector<unsigned int> order(count);
+		for (unsigned int i = 0; i < count; ++i) {
+			order[i] = i;
+		}
+		auto less = [&vertices](unsigned int a, unsigned int b) {
+			const int c = std::memcmp(&vertices[a].Pos, &vertices[b].Pos, sizeof(XMFLOAT3));
+			return c != 0 ? c < 0 : a < b;
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		group.assign(count, 0);
+		unsigned int groups = 0;
+		for (unsigned int i = 0; i < count; ++i) {
+			if (i > 0 && std::memcmp(&vertices[order[i]].Pos, &vertices[order[i - 1]].Pos, sizeof(XMFLOAT3)) != 0) {
+				++groups;
+			}
+			group[order[i]] = groups;
+		}
+		return count ? groups + 1 : 0;
+	}
+
+	/// Estado topológico de una pasada (se recalcula tras cada ronda de colapsos).
+	struct Topology {
+		std::vector<unsigned int> edgeOffsets;  ///< Aristas salientes por vértice (CSR).
+		std::vector<unsigned int> edges;
+		std::vector<unsigned int> openIn;       ///< Origen de la única arista abierta entrante.
+		std::vector<unsigned int> openOut;      ///< Destino de la única arista abierta saliente.
+		std::vector<unsigned int> wedge;        ///< Siguiente copia usada de la misma posición.
+		std::vector<unsigned char> kind;        ///< VertexKind de cada vértice.
+		std::vector<unsigned int> triOffsets;   ///< Triángulos por grupo de posición (CSR).
+		std::vector<unsigned int> tris;
+
+		bool
+		hasEdge(unsigned int a, unsigned int b) const {
+			for (unsigned int i = edgeOffsets[a]; i < edgeOffsets[a + 1]; ++i) {
+				if (edges[i] == b) {
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	void
+	buildTopology(const std::vector<unsigned int>& indices,
+		const std::vector<unsigned int>& group,
+		unsigned int groupCount,
+		Topology& topo) {
+		const unsigned int vertexCount = static_cast<unsigned int>(group.size());
+		const size_t triangleCount = indices.size() / 3;
+
+		// 01. Aristas salientes (en índices reales: las costuras UV quedan abiertas).
+		topo.edgeOffsets.assign(vertexCount + 1, 0);
+		for (unsigned int index : indices) {
+			++topo.edgeOffsets[index + 1];
+		}
+		for (unsigned int v = 0; v < vertexCount; ++v) {
+			topo.edgeOffsets[v + 1] += topo.edgeOffsets[v];
+		}
+		topo.edges.resize(indices.size());
+		{
+			std::vector<unsigned int> fill(topo.edgeOffsets.begin(), topo.edgeOffsets.end() - 1);
+			for (size_t t = 0; t < triangleCount; ++t) {
+				for (int k = 0; k < 3; ++k) {
+					const unsigned int a = indices[t * 3 + k];
+					const unsigned int b = indices[t * 3 + (k + 1) % 3];
+					topo.edges[fill[a]++] = b;
+				}
+			}
+		}
+
+		// 02. Aristas abiertas (sin gemela inversa).
+		topo.openIn.assign(vertexCount, kNone);
+		topo.openOut.assign(vertexCount, kNone);
+		for (unsigned int a = 0; a < vertexCount; ++a) {
+			for (unsigned int i = topo.edgeOffsets[a]; i < topo.edgeOffsets[a + 1]; ++i) {
+				const unsigned int b = topo.edges[i];
+				if (topo.hasEdge(b, a)) {
+					continue;
+				}
+				topo.openOut[a] = topo.openOut[a] == kNone ? b : kMultiple;
+				topo.openIn[b] = topo.openIn[b] == kNone ? a : kMultiple;
+			}
+		}
+
+		// 03. Anillos de copias usadas por posición.
+		std::vector<unsigned int> first(groupCount, kNone);
+		std::vector<unsigned int> last(groupCount, kNone);
+		topo.wedge.assign(vertexCount, kNone);
+		for (unsigned int v = 0; v < vertexCount; ++v) {
+			if (topo.edgeOffsets[v] == topo.edgeOffsets[v + 1]) {
+				continue;
+			}
+			const unsigned int g = group[v];
+			if (first[g] == kNone) {
+				first[g] = v;
+			}
+			else {
+				topo.wedge[last[g]] = v;
+			}
+			last[g] = v;
+		}
+		for (unsigned int g = 0; g < groupCount; ++g) {
+			if (first[g] != kNone) {
+				topo.wedge[last[g]] = first[g];
+			}
+		}
+
+		// 04. Clasificación.
+		auto single = [](unsigned int e) { return e != kNone && e != kMultiple; };
+		topo.kind.assign(vertexCount, KIND_LOCKED);
+		for (unsigned int v = 0; v < vertexCount; ++v) {
+			const unsigned int w = topo.wedge[v];
+			if (w == kNone) {
+				continue;
+			}
+			if (w == v) {
+				if (topo.openIn[v] == kNone && topo.openOut[v] == kNone) {
+					topo.kind[v] = KIND_MANIFOLD;
+				}
+				else if (single(topo.openIn[v]) && single(topo.openOut[v])) {
+					topo.kind[v] = KIND_BORDER;
+				}
+			}
+			else if (topo.wedge[w] == v &&
+				single(topo.openIn[v]) && single(topo.openOut[v]) &&
+				single(topo.openIn[w]) && single(topo.openOut[w]) &&
+				group[topo.openOut[v]] == group[topo.openIn[w]] &&
+				group[topo.openIn[v]] == group[topo.openOut[w]]) {
+				// Dos copias cuyas aristas abiertas recorren la misma costura en sentidos opuestos.
+				topo.kind[v] = KIND_SEAM;
+			}
+		}
+
+		// 05. Triángulos por grupo de posición (para detectar inversiones).
+		topo.triOffsets.assign(groupCount + 1, 0);
+		for (unsigned int index : indices) {
+			++topo.triOffsets[group[index] + 1];
+		}
+		for (unsigned int g = 0; g < groupCount; ++g) {
+			topo.triOffsets[g + 1] += topo.triOffsets[g];
+		}
+		topo.tris.resize(indices.size());
+		std::vector<unsigned int> fill(topo.triOffsets.begin(), topo.triOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t) {
+			for (int k = 0; k < 3; ++k) {
+				topo.tris[fill[group[indices[t * 3 + k]]]++] = static_cast<unsigned int>(t);
+			}
+		}
+	}
+
+	struct Collapse {
+		unsigned int v;       ///< Vértice que desaparece.
+		unsigned int t;       ///< Vértice destino.
+		unsigned int sibling; ///< Copia de costura de v (o kNone).
+		unsigned int siblingTarget;
+		double cost;
+	};
+
+	/**
+	 * @brief Comprueba si mover el grupo gv a la posición de target invierte algún triángulo.
+	 */
+	bool
+	hasTriangleFlips(const std::vector<SimpleVertex>& vertices,
+		const std::vector<unsigned int>& indices,
+		const std::vector<unsigned int>& group,
+		const Topology& topo,
+		unsigned int gv,
+		unsigned int gt,
+		const XMFLOAT3& target) {
+		for (unsigned int i = topo.triOffsets[gv]; i < topo.triOffsets[gv + 1]; ++i) {
+			const unsigned int* tri = &indices[topo.tris[i] * 3];
+			if (group[tri[0]] == gt || group[tri[1]] == gt || group[tri[2]] == gt) {
+				continue; // desaparece con el colapso
+			}
+			XMFLOAT3 p[3] = { vertices[tri[0]].Pos, vertices[tri[1]].Pos, vertices[tri[2]].Pos };
+			const Vec3 before = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+			for (int k = 0; k < 3; ++k) {
+				if (group[tri[k]] == gv) {
+					p[k] = target;
+				}
+			}
+			const Vec3 after = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+			if (dot(before, after) <= 0.0) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+size_t
+MeshSimplifier::simplify(const std::vector<SimpleVertex>& vertices,
+	const std::vector<unsigned int>& indices,
+	size_t targetIndexCount,
+	std::vector<unsigned int>& destination,
+	float* resultError) {
+	destination.assign(indices.begin(), indices.end() - indices.size() % 3);
+	double maxCost = 0.0;
+	if (destination.size() <= targetIndexCount || vertices.empty()) {
+		if (resultError) *resultError = 0.0f;
+		return destination.size();
+	}
+
+	std::vector<unsigned int> group;
+	const unsigned int groupCount = buildPositionGroups(vertices, group);
+	Topology topo;
+	buildTopology(destination, group, groupCount, topo);
+
+	// 01. Cuádricas por posición: planos de las caras (ponderados por área) y
+	//     planos perpendiculares a las aristas de borde.
+	std::vector<Quadric> quadrics(groupCount);
+	for (size_t t = 0; t < destination.size() / 3; ++t) {
+		const unsigned int* tri = &destination[t * 3];
+		const Vec3 n = cross(sub(vertices[tri[1]].Pos, vertices[tri[0]].Pos),
+			sub(vertices[tri[2]].Pos, vertices[tri[0]].Pos));
+		const double length = std::sqrt(dot(n, n));
+		if (length <= 0.0) {
+			continue;
+		}
+		const Vec3 unit = { n.x / length, n.y / length, n.z / length };
+		const XMFLOAT3& p0 = vertices[tri[0]].Pos;
+		const double d = -(unit.x * p0.x + unit.y * p0.y + unit.z * p0.z);
+		for (int k = 0; k < 3; ++k) {
+			addPlane(quadrics[group[tri[k]]], unit.x, unit.y, unit.z, d, length * 0.5);
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			const unsigned int a = tri[k];
+			const unsigned int b = tri[(k + 1) % 3];
+			if (topo.kind[a] != KIND_BORDER || topo.openOut[a] != b) {
+				continue;
+			}
+			const Vec3 edge = sub(vertices[b].Pos, vertices[a].Pos);
+			const Vec3 side = cross(edge, unit);
+			const double sideLength = std::sqrt(dot(side, side));
+			if (sideLength <= 0.0) {
+				continue;
+			}
+			const Vec3 sn = { side.x / sideLength, side.y / sideLength, side.z / sideLength };
+			const XMFLOAT3& pa = vertices[a].Pos;
+			const double sd = -(sn.x * pa.x + sn.y * pa.y + sn.z * pa.z);
+			const double weight = dot(edge, edge) * kBorderWeight;
+			addPlane(quadrics[group[a]], sn.x, sn.y, sn.z, sd, weight);
+			addPlane(quadrics[group[b]], sn.x, sn.y, sn.z, sd, weight);
+		}
+	}
+
+	std::vector<Collapse> candidates;
+	std::vector<unsigned int> collapseTo(vertices.size());
+	std::vector<unsigned char> locked(groupCount);
+
+	for (unsigned int pass = 0; pass < kMaxPasses && destination.size() > targetIndexCount; ++pass) {
+		if (pass > 0) {
+			buildTopology(destination, group, groupCount, topo);
+		}
+
+		// 02. Colapsos válidos de cada arista en ambos sentidos.
+		candidates.clear();
+		auto consider = [&](unsigned int v, unsigned int t) {
+			if (group[v] == group[t]) {
+				return;
+			}
+			Collapse c = { v, t, kNone, kNone, 0.0 };
+			switch (topo.kind[v]) {
+			case KIND_MANIFOLD:
+				break;
+			case KIND_BORDER:
+				if (topo.kind[t] != KIND_BORDER || (topo.openOut[v] != t && topo.openIn[v] != t)) {
+					return;
+				}
+				break;
+			case KIND_SEAM: {
+				if (topo.kind[t] != KIND_SEAM || (topo.openOut[v] != t && topo.openIn[v] != t)) {
+					return;
+				}
+				// La otra copia recorre la costura en sentido contrario.
+				const unsigned int s = topo.wedge[v];
+				const unsigned int st = topo.openOut[v] == t ? topo.openIn[s] : topo.openOut[s];
+				if (group[st] != group[t]) {
+					return;
+				}
+				c.sibling = s;
+				c.siblingTarget = st;
+				break;
+			}
+			default:
+				return;
+			}
+			Quadric q = quadrics[group[v]];
+			addQuadric(q, quadrics[group[t]]);
+			c.cost = evaluate(q, vertices[t].Pos);
+			candidates.push_back(c);
+		};
+		for (size_t i = 0; i < destination.size(); i += 3) {
+			for (int k = 0; k < 3; ++k) {
+				const unsigned int a = destination[i + k];
+				const unsigned int b = destination[i + (k + 1) % 3];
+				consider(a, b);
+				consider(b, a);
+			}
+		}
+		if (candidates.empty()) {
+			break;
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+			if (a.cost != b.cost) return a.cost < b.cost;
+			return a.v != b.v ? a.v < b.v : a.t < b.t;
+		});
+
+		// 03. Conjunto independiente de colapsos baratos: cada colapso bloquea su anillo.
+		const size_t triangles = destination.size() / 3;
+		const size_t limit = std::max<size_t>(1, (triangles - targetIndexCount / 3) / 2);
+		for (size_t v = 0; v < collapseTo.size(); ++v) {
+			collapseTo[v] = static_cast<unsigned int>(v);
+		}
+		std::fill(locked.begin(), locked.end(), 0);
+		size_t collapses = 0;
+		for (const Collapse& c : candidates) {
+			const unsigned int gv = group[c.v];
+			const unsigned int gt = group[c.t];
+			if (locked[gv] || locked[gt]) {
+				continue;
+			}
+			if (hasTriangleFlips(vertices, destination, group, topo, gv, gt, vertices[c.t].Pos)) {
+				continue;
+			}
+
+			collapseTo[c.v] = c.t;
+			if (c.sibling != kNone) {
+				collapseTo[c.sibling] = c.siblingTarget;
+			}
+			addQuadric(quadrics[gt], quadrics[gv]);
+			maxCost = std::max(maxCost, c.cost);
+
+			for (unsigned int i = topo.triOffsets[gv]; i < topo.triOffsets[gv + 1]; ++i) {
+				const unsigned int* tri = &destination[topo.tris[i] * 3];
+				locked[group[tri[0]]] = locked[group[tri[1]]] = locked[group[tri[2]]] = 1;
+			}
+			if (++collapses >= limit) {
+				break;
+			}
+		}
+		if (collapses == 0) {
+			break;
+		}
+
+		// 04. Reescribir los índices y descartar los triángulos degenerados.
+		size_t write = 0;
+		for (size_t i = 0; i < destination.size(); i += 3) {
+			const unsigned int a = collapseTo[destination[i]];
+			const unsigned int b = collapseTo[destination[i + 1]];
+			const unsigned int c = collapseTo[destination[i + 2]];
+			if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c]) {
+				continue;
+			}
+			destination[write++] = a;
+			destination[write++] = b;
+			destination[write++] = c;
+		}
+		destination.resize(write);
+	}
+
+	if (resultError) {
+		*resultError = static_cast<float>(std::sqrt(maxCost));
+	}
+	return destination.size();
+}
+
+void
+MeshSimplifier::buildLODChain(MeshComponent& mesh,
+	const std::vector<float>& ratios,
+	SimplificationStats* stats) {
+	mesh.m_lods.clear();
+	const size_t baseCount = mesh.m_index.size() - mesh.m_index.size() % 3;
+	if (baseCount < 3 || ratios.empty() || mesh.m_vertex.empty()) {
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+
+	const std::vector<unsigned int> base(mesh.m_index.begin(), mesh.m_index.begin() + baseCount);
+	mesh.m_index.resize(baseCount);
+
+	MeshLOD full;
+	full.indexOffset = 0;
+	full.indexCount = static_cast<unsigned int>(baseCount);
+	full.screenSize = FLT_MAX;
+	mesh.m_lods.push_back(full);
+
+	// Cada nivel se simplifica desde el original: el error medido es respecto a él.
+	size_t previous = baseCount;
+	std::vector<unsigned int> level;
+	for (float ratio : ratios) {
+		const size_t target = static_cast<size_t>(double(baseCount / 3) * ratio) * 3;
+		float error = 0.0f;
+		const size_t count = simplify(mesh.m_vertex, base, std::max<size_t>(target, 3), level, &error);
+		if (count == 0 || count * 10 > previous * 9) {
+			break; // menos de un 10 % de ahorro: la malla ya no se puede reducir más
+		}
+		MeshOptimizer::optimizeVertexCache(level, static_cast<unsigned int>(mesh.m_vertex.size()));
+
+		MeshLOD lod;
+		lod.indexOffset = static_cast<unsigned int>(mesh.m_index.size());
+		lod.indexCount = static_cast<unsigned int>(count);
+		lod.error = error;
+		// Densidad de triángulos por píxel constante: el área proyectada escala con el cuadrado del tamaño.
+		lod.screenSize = std::sqrt(float(count) / float(baseCount));
+		mesh.m_index.insert(mesh.m_index.end(), level.begin(), level.end());
+		mesh.m_lods.push_back(lod);
+		previous = count;
+	}
+
+	if (mesh.m_lods.size() == 1) {
+		mesh.m_lods.clear();
+	}
+	mesh.m_numIndex = static_cast<int>(baseCount);
+
+	if (stats) {
+		++stats->meshes;
+		stats->sourceTriangles += static_cast<unsigned int>(baseCount / 3);
+		for (size_t i = 1; i < mesh.m_lods.size(); ++i) {
+			++stats->levels;
+			stats->lodTriangles += mesh.m_lods[i].indexCount / 3;
+		}
+		stats->milliseconds += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+unsigned int
+MeshSimplifier::selectLOD(const std::vector<MeshLOD>& lods,
+	float screenSize,
+	unsigned int current) {
+	if (lods.size() < 2) {
+		return 0;
+	}
+	current = std::min(current, static_cast<unsigned int>(lods.size() - 1));
+
+	// Para bajar de detalle hay que quedar claramente por debajo del umbral;
+	// para subir, claramente por encima. Entre ambos se mantiene el nivel actual.
+	unsigned int coarser = 0;
+	unsigned int finer = 0;
+	for (unsigned int i = 1; i < lods.size(); ++i) {
+		if (screenSize < lods[i].screenSize * (1.0f - kLODHysteresis)) coarser = i;
+		if (screenSize < lods[i].screenSize * (1.0f + kLODHysteresis)) finer = i;
+	}
+	if (current < coarser) return coarser;
+	if (current > finer) return finer;
+	return current;
+}
+
+float
+MeshSimplifier::projectedSize(const XMFLOAT3& center, float radius, const XMFLOAT3& eye, float projectionScale) {
+	const float dx = center.x - eye.x, dy = center.y - eye.y, dz = center.z - eye.z;
+	const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+	return distance > radius ? radius * projectionScale / distance : FLT_MAX;
+}
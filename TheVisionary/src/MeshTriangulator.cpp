@@ -0,0 +1,276 @@
+﻿/**
+ * @file MeshTriangulator.cpp
+ * @brief Implementación de la triangulación con caminos rápidos y ear clipping sin reservas.
+ */
+
+#include "MeshTriangulator.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <cmath>
+
+namespace {
+	/// Polígonos por bloque en la pasada paralela.
+	const unsigned int kPolygonsPerJob = 4096;
+
+	struct Point2 { float x, y; };
+
+	inline float
+	cross2(const Point2& a, const Point2& b, const Point2& c) {
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	/**
+	 * @brief Proyecta el polígono al plano de su eje dominante (normal de Newell).
+	 * @return Área con signo del polígono proyectado (el signo da el sentido de giro).
+	 */
+	float
+	projectPolygon(const std::vector<SimpleVertex>& vertices,
+		const unsigned int* polygon,
+		unsigned int count,
+		Point2* points) {
+		float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+		for (unsigned int i = 0, j = count - 1; i < count; j = i++) {
+			const XMFLOAT3& a = vertices[polygon[j]].Pos;
+			const XMFLOAT3& b = vertices[polygon[i]].Pos;
+			nx += (a.y - b.y) * (a.z + b.z);
+			ny += (a.z - b.z) * (a.x + b.x);
+			nz += (a.x - b.x) * (a.y + b.y);
+		}
+
+		const float ax = std::fabs(nx), ay = std::fabs(ny), az = std::fabs(nz);
+		for (unsigned int i = 0; i < count; ++i) {
+			const XMFLOAT3& p = vertices[polygon[i]].Pos;
+			if (ax >= ay && ax >= az)      points[i] = { p.y, p.z };
+			else if (ay >= az)             points[i] = { p.z, p.x };
+			else                           points[i] = { p.x, p.y };
+		}
+
+		float area = 0.0f;
+		for (unsigned int i = 0, j = count - 1; i < count; j = i++) {
+			area += points[j].x * points[i].y - points[i].x * points[j].y;
+		}
+		return area;
+	}
+
+	/// Abanico desde el primer vértice (n - 2 triángulos).
+	void
+	emitFan(const unsigned int* polygon, unsigned int count, unsigned int* out) {
+		for (unsigned int i = 1; i + 1 < count; ++i) {
+			*out++ = polygon[0];
+			*out++ = polygon[i];
+			*out++ = polygon[i + 1];
+		}
+	}
+
+	/// Quad: diagonal por el vértice cóncavo o, si es convexo, la más corta.
+	void
+	triangulateQuad(const std::vector<SimpleVertex>& vertices,
+		const unsigned int* q,
+		unsigned int* out) {
+		Point2 p[4];
+		const float orientation = projectPolygon(vertices, q, 4, p) >= 0.0f ? 1.0f : -1.0f;
+
+		bool useDiagonal13 = false;
+		if (cross2(p[0], p[1], p[2]) * orientation < 0.0f ||
+			cross2(p[2], p[3], p[0]) * orientation < 0.0f) {
+			useDiagonal13 = true;   // cóncavo en 1 o 3
+		}
+		else if (cross2(p[3], p[0], p[1]) * orientation < 0.0f ||
+			cross2(p[1], p[2], p[3]) * orientation < 0.0f) {
+			useDiagonal13 = false;  // cóncavo en 0 o 2
+		}
+		else {
+			const XMFLOAT3& a = vertices[q[0]].Pos;
+			const XMFLOAT3& b = vertices[q[1]].Pos;
+			const XMFLOAT3& c = vertices[q[2]].Pos;
+			const XMFLOAT3& d = vertices[q[3]].Pos;
+			const float d02 = (c.x - a.x) * (c.x - a.x) + (c.y - a.y) * (c.y - a.y) + (c.z - a.z) * (c.z - a.z);
+			const float d13 = (d.x - b.x) * (d.x - b.x) + (d.y - b.y) * (d.y - b.y) + (d.z - b.z) * (d.z - b.z);
+			useDiagonal13 = d13 < d02;
+		}
+
+		if (useDiagonal13) {
+			out[0] = q[0]; out[1] = q[1]; out[2] = q[3];
+			out[3] = q[1]; out[4] = q[2]; out[5] = q[3];
+		}
+		else {
+			out[0] = q[0]; out[1] = q[1]; out[2] = q[2];
+			out[3] = q[0]; out[4] = q[2]; out[5] = q[3];
+		}
+	}
+
+	/// true si p está estrictamente dentro del triángulo abc (orientado según `orientation`).
+	inline bool
+	insideTriangle(const Point2& a, const Point2& b, const Point2& c, const Point2& p, float orientation) {
+		return cross2(a, b, p) * orientation > 0.0f &&
+			cross2(b, c, p) * orientation > 0.0f &&
+			cross2(c, a, p) * orientation > 0.0f;
+	}
+}
+
+bool
+MeshTriangulator::triangulatePolygon(const std::vector<SimpleVertex>& vertices,
+	const unsigned int* polygon,
+	unsigned int count,
+	unsigned int* out) {
+	if (count == 3) {
+		out[0] = polygon[0]; out[1] = polygon[1]; out[2] = polygon[2];
+		return true;
+	}
+	if (count == 4) {
+		triangulateQuad(vertices, polygon, out);
+		return true;
+	}
+	if (count > kMaxEarClipVertices) {
+		emitFan(polygon, count, out);
+		return false;
+	}
+
+	// Todo el estado vive en la pila: lista doblemente enlazada de vértices restantes.
+	Point2 points[kMaxEarClipVertices];
+	unsigned short prev[kMaxEarClipVertices];
+	unsigned short next[kMaxEarClipVertices];
+
+	const float area = projectPolygon(vertices, polygon, count, points);
+	if (std::fabs(area) <= 1e-12f) {
+		emitFan(polygon, count, out);
+		return false;
+	}
+	const float orientation = area > 0.0f ? 1.0f : -1.0f;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		prev[i] = static_cast<unsigned short>(i == 0 ? count - 1 : i - 1);
+		next[i] = static_cast<unsigned short>(i + 1 == count ? 0 : i + 1);
+	}
+
+	unsigned int remaining = count;
+	unsigned int current = 0;
+	unsigned int misses = 0;
+	while (remaining > 3) {
+		const unsigned int a = prev[current];
+		const unsigned int b = current;
+		const unsigned int c = next[current];
+
+		bool isEar = cross2(points[a], points[b], points[c]) * orientation > 0.0f;
+		if (isEar) {
+			// Solo los vértices reflejos pueden quedar dentro de una oreja convexa.
+			for (unsigned int v = next[c]; v != a; v = next[v]) {
+				if (cross2(points[prev[v]], points[v], points[next[v]]) * orientation > 0.0f) {
+					continue;
+				}
+				if (insideTriangle(points[a], points[b], points[c], points[v], orientation)) {
+					isEar = false;
+					break;
+				}
+			}
+		}
+
+		if (isEar) {
+			*out++ = polygon[a];
+			*out++ = polygon[b];
+			*out++ = polygon[c];
+			next[a] = static_cast<unsigned short>(c);
+			prev[c] = static_cast<unsigned short>(a);
+			--remaining;
+			misses = 0;
+			current = a;
+			continue;
+		}
+
+		current = c;
+		if (++misses > remaining) {
+			// Polígono degenerado o autointersectante: abanico con lo que queda.
+			const unsigned int first = current;
+			for (unsigned int v = next[first]; next[v] != first; v = next[v]) {
+				*out++ = polygon[first];
+				*out++ = polygon[v];
+				*out++ = polygon[next[v]];
+			}
+			return false;
+		}
+	}
+
+	*out++ = polygon[prev[current]];
+	*out++ = polygon[current];
+	*out++ = polygon[next[current]];
+	return true;
+}
+
+bool
+MeshTriangulator::triangulate(const std::vector<SimpleVertex>& vertices,
+	const std::vector<unsigned int>& polygonIndices,
+	const std::vector<unsigned int>& polygonSizes,
+	std::vector<unsigned int>& triangles,
+	JobSystem* jobs,
+	TriangulationStats* stats) {
+	const auto start = std::chrono::steady_clock::now();
+	const unsigned int polygonCount = static_cast<unsigned int>(polygonSizes.size());
+
+	// 01. Desplazamientos de entrada y salida de cada polígono (n vértices -> n - 2 triángulos).
+	std::vector<unsigned int> inputOffsets(polygonCount);
+	std::vector<unsigned int> outputOffsets(polygonCount);
+	TriangulationStats local;
+	local.polygons = polygonCount;
+
+	size_t inputCursor = 0;
+	size_t outputCursor = 0;
+	for (unsigned int i = 0; i < polygonCount; ++i) {
+		const unsigned int size = polygonSizes[i];
+		inputOffsets[i] = static_cast<unsigned int>(inputCursor);
+		outputOffsets[i] = static_cast<unsigned int>(outputCursor);
+		inputCursor += size;
+		if (size < 3) {
+			++local.degenerate;
+			continue;
+		}
+		if (size == 4) ++local.quads;
+		else if (size > 4) ++local.ngons;
+		outputCursor += (size - 2) * 3;
+	}
+
+	if (inputCursor != polygonIndices.size()) {
+		ERROR("MeshTriangulator", "triangulate", "Polygon sizes do not match the index count.");
+		return false;
+	}
+	for (unsigned int index : polygonIndices) {
+		if (index >= vertices.size()) {
+			ERROR("MeshTriangulator", "triangulate", "Polygon index out of range.");
+			return false;
+		}
+	}
+
+	triangles.resize(outputCursor);
+	local.triangles = static_cast<unsigned int>(outputCursor / 3);
+
+	// 02. Cada polígono escribe en su propio rango: no hace falta sincronizar.
+	std::atomic<unsigned int> fanFallbacks{ 0 };
+	auto process = [&](unsigned int begin, unsigned int end) {
+		unsigned int fans = 0;
+		for (unsigned int i = begin; i < end; ++i) {
+			const unsigned int size = polygonSizes[i];
+			if (size < 3) {
+				continue;
+			}
+			if (!triangulatePolygon(vertices, &polygonIndices[inputOffsets[i]], size,
+				&triangles[outputOffsets[i]])) {
+				++fans;
+			}
+		}
+		fanFallbacks += fans;
+	};
+
+	if (jobs && jobs->getThreadCount() > 0) {
+		jobs->parallelFor(polygonCount, kPolygonsPerJob, process);
+	}
+	else if (polygonCount > 0) {
+		process(0, polygonCount);
+	}
+
+	local.fanFallbacks = fanFallbacks.load();
+	local.milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	if (stats) {
+		*stats = local;
+	}
+	return true;
+}
@@ -0,0 +1,373 @@
+﻿/**
+ * @file Meshlet.cpp
+ * @brief Implementación de la agrupación en meshlets, sus volúmenes y el culling SoA por frame.
+ */
+
+#include "Meshlet.h"
+#include "MeshComponent.h"
+#include "FrustumCuller.h"
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+namespace {
+	/// Peso de la alineación con la normal media frente a los vértices nuevos al elegir el siguiente triángulo.
+	const float kConeWeight = 0.5f;
+	/// Por debajo de este coseno mínimo el cono no descarta nada (clúster casi plano en ángulo o curvado).
+	const float kMinConeDot = 0.1f;
+
+	XMFLOAT3
+	triangleNormal(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c, float& area2) {
+		// Con FrontCounterClockwise = false, cross(b - a, c - a) apunta hacia la cara visible.
+		const float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+		const float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+		XMFLOAT3 n(uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx);
+		area2 = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+		if (area2 > 0.0f) {
+			n.x /= area2; n.y /= area2; n.z /= area2;
+		}
+		return n;
+	}
+}
+
+void
+MeshletBuilder::build(MeshComponent& mesh, MeshletBuildStats* stats) {
+	mesh.m_meshlets.clear();
+	const size_t indexCount = static_cast<size_t>(mesh.m_numIndex) - mesh.m_numIndex % 3;
+	const size_t triangleCount = indexCount / 3;
+	const size_t vertexCount = mesh.m_vertex.size();
+	// Con un solo meshlet el culling por clúster no aporta nada frente al de la malla.
+	if (triangleCount <= kMaxTriangles || vertexCount == 0 || indexCount > mesh.m_index.size()) {
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<unsigned int>& indices = mesh.m_index;
+
+	std::vector<XMFLOAT3> normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t) {
+		float area2 = 0.0f;
+		normals[t] = triangleNormal(mesh.m_vertex[indices[t * 3]].Pos,
+			mesh.m_vertex[indices[t * 3 + 1]].Pos,
+			mesh.m_vertex[indices[t * 3 + 2]].Pos, area2);
+	}
+
+	// Triángulos por vértice (CSR).
+	std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; ++i) {
+		++adjacencyOffset[indices[i] + 1];
+	}
+	for (size_t v = 0; v < vertexCount; ++v) {
+		adjacencyOffset[v + 1] += adjacencyOffset[v];
+	}
+	std::vector<unsigned int> adjacency(indexCount);
+	{
+		std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i) {
+			adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+	}
+
+	std::vector<unsigned int> vertexTag(vertexCount, 0);       // meshlet + 1 que contiene el vértice
+	std::vector<unsigned int> candidateTag(triangleCount, 0);  // meshlet + 1 que lo tiene como candidato
+	std::vector<bool> used(triangleCount, false);
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> order;
+	order.reserve(indexCount);
+
+	unsigned int meshletTag = 0;
+	unsigned int meshletVertices = 0;
+	unsigned int meshletTriangles = 0;
+	float axisX = 0.0f, axisY = 0.0f, axisZ = 0.0f;
+	size_t scan = 0;
+
+	auto newVertices = [&](size_t t) {
+		unsigned int extra = 0;
+		for (int k = 0; k < 3; ++k) {
+			extra += vertexTag[indices[t * 3 + k]] != meshletTag ? 1u : 0u;
+		}
+		// Vértices repetidos dentro del triángulo (degenerado) cuentan una vez.
+		const unsigned int a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+		if (vertexTag[a] != meshletTag && (a == b || a == c)) --extra;
+		if (vertexTag[b] != meshletTag && b == c) --extra;
+		return extra;
+	};
+
+	auto flush = [&]() {
+		if (meshletTriangles == 0) {
+			return;
+		}
+		Meshlet meshlet;
+		meshlet.indexOffset = static_cast<unsigned int>(order.size() - meshletTriangles * 3);
+		meshlet.triangleCount = meshletTriangles;
+		meshlet.vertexCount = meshletVertices;
+		mesh.m_meshlets.push_back(meshlet);
+		meshletVertices = 0;
+		meshletTriangles = 0;
+		axisX = axisY = axisZ = 0.0f;
+		candidates.clear();
+	};
+
+	auto addTriangle = [&](size_t t) {
+		used[t] = true;
+		for (int k = 0; k < 3; ++k) {
+			const unsigned int v = indices[t * 3 + k];
+			order.push_back(v);
+			if (vertexTag[v] != meshletTag) {
+				vertexTag[v] = meshletTag;
+				++meshletVertices;
+			}
+			for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v + 1]; ++a) {
+				const unsigned int other = adjacency[a];
+				if (!used[other] && candidateTag[other] != meshletTag) {
+					candidateTag[other] = meshletTag;
+					candidates.push_back(other);
+				}
+			}
+		}
+		++meshletTriangles;
+		axisX += normals[t].x; axisY += normals[t].y; axisZ += normals[t].z;
+	};
+
+	size_t remaining = triangleCount;
+	while (remaining > 0) {
+		if (meshletTriangles == 0) {
+			++meshletTag;
+		}
+
+		// Mejor vecino: el que menos vértices añade y más se alinea con la normal media.
+		const float axisLength = std::sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
+		const float invAxis = axisLength > 0.0f ? 1.0f / axisLength : 0.0f;
+		size_t best = triangleCount;
+		float bestCost = FLT_MAX;
+		size_t kept = 0;
+		for (size_t c = 0; c < candidates.size(); ++c) {
+			const unsigned int t = candidates[c];
+			if (used[t]) {
+				continue;
+			}
+			candidates[kept++] = t;
+			const unsigned int extra = newVertices(t);
+			if (meshletVertices + extra > kMaxVertices) {
+				continue;
+			}
+			const float alignment = (normals[t].x * axisX + normals[t].y * axisY + normals[t].z * axisZ) * invAxis;
+			const float cost = float(extra) + kConeWeight * (1.0f - alignment);
+			if (cost < bestCost) {
+				bestCost = cost;
+				best = t;
+			}
+		}
+		candidates.resize(kept);
+
+		if (best == triangleCount) {
+			if (!candidates.empty()) {
+				flush(); // los vecinos ya no caben: cerrar el meshlet
+				continue;
+			}
+			// Isla agotada: continuar con el siguiente triángulo libre en el orden del índice.
+			while (used[scan]) {
+				++scan;
+			}
+			if (meshletVertices + newVertices(scan) > kMaxVertices) {
+				flush();
+				continue;
+			}
+			best = scan;
+		}
+
+		addTriangle(best);
+		--remaining;
+		if (meshletTriangles == kMaxTriangles) {
+			flush();
+		}
+	}
+	flush();
+
+	std::copy(order.begin(), order.end(), mesh.m_index.begin());
+	for (Meshlet& meshlet : mesh.m_meshlets) {
+		computeBounds(mesh.m_vertex, mesh.m_index, meshlet);
+	}
+
+	if (stats) {
+		++stats->meshes;
+		stats->meshlets += static_cast<unsigned int>(mesh.m_meshlets.size());
+		stats->triangles += static_cast<unsigned int>(triangleCount);
+		for (const Meshlet& meshlet : mesh.m_meshlets) {
+			stats->vertices += meshlet.vertexCount;
+			stats->cones += meshlet.cone.w < 1.0f ? 1u : 0u;
+		}
+		stats->milliseconds += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void
+MeshletBuilder::computeBounds(const std::vector<SimpleVertex>& vertices,
+	const std::vector<unsigned int>& indices,
+	Meshlet& meshlet) {
+	const size_t first = meshlet.indexOffset;
+	const size_t last = first + meshlet.triangleCount * 3;
+
+	// Esfera: centro de la caja y distancia máxima a él.
+	XMFLOAT3 minP(FLT_MAX, FLT_MAX, FLT_MAX), maxP(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = first; i < last; ++i) {
+		const XMFLOAT3& p = vertices[indices[i]].Pos;
+		minP.x = std::min(minP.x, p.x); minP.y = std::min(minP.y, p.y); minP.z = std::min(minP.z, p.z);
+		maxP.x = std::max(maxP.x, p.x); maxP.y = std::max(maxP.y, p.y); maxP.z = std::max(maxP.z, p.z);
+	}
+	const XMFLOAT3 center((minP.x + maxP.x) * 0.5f, (minP.y + maxP.y) * 0.5f, (minP.z + maxP.z) * 0.5f);
+	float radius2 = 0.0f;
+	for (size_t i = first; i < last; ++i) {
+		const XMFLOAT3& p = vertices[indices[i]].Pos;
+		const float dx = p.x - center.x, dy = p.y - center.y, dz = p.z - center.z;
+		radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+	}
+	meshlet.sphere = XMFLOAT4(center.x, center.y, center.z, std::sqrt(radius2));
+
+	// Cono: eje = normal media ponderada por área; corte = seno del ángulo máximo al eje.
+	std::vector<XMFLOAT3> normals;
+	normals.reserve(meshlet.triangleCount);
+	float axisX = 0.0f, axisY = 0.0f, axisZ = 0.0f;
+	for (size_t i = first; i < last; i += 3) {
+		float area2 = 0.0f;
+		const XMFLOAT3 n = triangleNormal(vertices[indices[i]].Pos,
+			vertices[indices[i + 1]].Pos,
+			vertices[indices[i + 2]].Pos, area2);
+		if (area2 > 0.0f) {
+			normals.push_back(n);
+			axisX += n.x * area2; axisY += n.y * area2; axisZ += n.z * area2;
+		}
+	}
+	meshlet.cone = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	const float axisLength = std::sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
+	if (normals.empty() || axisLength <= 0.0f) {
+		return;
+	}
+	axisX /= axisLength; axisY /= axisLength; axisZ /= axisLength;
+	float minDot = 1.0f;
+	for (const XMFLOAT3& n : normals) {
+		minDot = std::min(minDot, n.x * axisX + n.y * axisY + n.z * axisZ);
+	}
+	if (minDot <= kMinConeDot) {
+		return;
+	}
+	meshlet.cone = XMFLOAT4(axisX, axisY, axisZ, std::sqrt(1.0f - minDot * minDot));
+}
+
+void
+MeshletCuller::init(const std::vector<Meshlet>& meshlets) {
+	m_ranges.clear();
+	m_groups.clear();
+	m_groups.resize((meshlets.size() + 3) / 4);
+	for (size_t i = 0; i < meshlets.size(); ++i) {
+		const Meshlet& meshlet = meshlets[i];
+		MeshletDrawRange range;
+		range.indexOffset = meshlet.indexOffset;
+		range.indexCount = meshlet.triangleCount * 3;
+		m_ranges.push_back(range);
+
+		Group& group = m_groups[i / 4];
+		float* lanes[8] = { &group.centerX.x, &group.centerY.x, &group.centerZ.x, &group.radius.x,
+			&group.axisX.x, &group.axisY.x, &group.axisZ.x, &group.cutoff.x };
+		const float values[8] = { meshlet.sphere.x, meshlet.sphere.y, meshlet.sphere.z, meshlet.sphere.w,
+			meshlet.cone.x, meshlet.cone.y, meshlet.cone.z, meshlet.cone.w };
+		for (int c = 0; c < 8; ++c) {
+			lanes[c][i % 4] = values[c];
+		}
+	}
+	// Carriles de relleno: esfera nula y sin cono (se ignoran al emitir rangos).
+	for (size_t i = meshlets.size(); i < m_groups.size() * 4; ++i) {
+		Group& group = m_groups[i / 4];
+		float* lanes[8] = { &group.centerX.x, &group.centerY.x, &group.centerZ.x, &group.radius.x,
+			&group.axisX.x, &group.axisY.x, &group.axisZ.x, &group.cutoff.x };
+		for (int c = 0; c < 8; ++c) {
+			lanes[c][i % 4] = c == 7 ? 1.0f : 0.0f;
+		}
+	}
+}
+
+void
+MeshletCuller::cull(const XMMATRIX& worldViewProjection,
+	const XMFLOAT3& localEye,
+	bool coneCulling,
+	std::vector<MeshletDrawRange>& ranges,
+	MeshletCullStats& stats) const {
+	const auto start = std::chrono::steady_clock::now();
+	ranges.clear();
+
+	// Planos del frustum en espacio del objeto.
+	const Frustum frustum = Frustum::fromMatrix(worldViewProjection);
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; ++p) {
+		const XMVECTOR plane = XMLoadFloat4(&frustum.planes[p]);
+		planeX[p] = XMVectorSplatX(plane);
+		planeY[p] = XMVectorSplatY(plane);
+		planeZ[p] = XMVectorSplatZ(plane);
+		planeW[p] = XMVectorSplatW(plane);
+	}
+	const XMVECTOR eyeX = XMVectorReplicate(localEye.x);
+	const XMVECTOR eyeY = XMVectorReplicate(localEye.y);
+	const XMVECTOR eyeZ = XMVectorReplicate(localEye.z);
+
+	const size_t count = m_ranges.size();
+	for (size_t g = 0; g < m_groups.size(); ++g) {
+		const Group& group = m_groups[g];
+		const XMVECTOR cx = XMLoadFloat4(&group.centerX);
+		const XMVECTOR cy = XMLoadFloat4(&group.centerY);
+		const XMVECTOR cz = XMLoadFloat4(&group.centerZ);
+		const XMVECTOR radius = XMLoadFloat4(&group.radius);
+		const XMVECTOR negRadius = XMVectorNegate(radius);
+
+		// Fuera si la esfera queda por completo detrás de algún plano.
+		XMVECTOR outside = XMVectorFalseInt();
+		for (int p = 0; p < 6; ++p) {
+			const XMVECTOR distance = XMVectorMultiplyAdd(cx, planeX[p],
+				XMVectorMultiplyAdd(cy, planeY[p], XMVectorMultiplyAdd(cz, planeZ[p], planeW[p])));
+			outside = XMVectorOrInt(outside, XMVectorLess(distance, negRadius));
+		}
+
+		// De espaldas si dot(c - eye, eje) >= corte * |c - eye| + radio.
+		XMVECTOR backface = XMVectorFalseInt();
+		if (coneCulling) {
+			const XMVECTOR dx = XMVectorSubtract(cx, eyeX);
+			const XMVECTOR dy = XMVectorSubtract(cy, eyeY);
+			const XMVECTOR dz = XMVectorSubtract(cz, eyeZ);
+			const XMVECTOR length = XMVectorSqrt(XMVectorMultiplyAdd(dx, dx,
+				XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz))));
+			const XMVECTOR projection = XMVectorMultiplyAdd(dx, XMLoadFloat4(&group.axisX),
+				XMVectorMultiplyAdd(dy, XMLoadFloat4(&group.axisY), XMVectorMultiply(dz, XMLoadFloat4(&group.axisZ))));
+			backface = XMVectorGreaterOrEqual(projection,
+				XMVectorMultiplyAdd(XMLoadFloat4(&group.cutoff), length, radius));
+		}
+
+		UINT outsideMask[4], backfaceMask[4];
+		XMStoreInt4(outsideMask, outside);
+		XMStoreInt4(backfaceMask, backface);
+		for (size_t lane = 0; lane < 4; ++lane) {
+			const size_t i = g * 4 + lane;
+			if (i >= count) {
+				break;
+			}
+			const MeshletDrawRange& range = m_ranges[i];
+			++stats.meshlets;
+			stats.triangles += range.indexCount / 3;
+			if (outsideMask[lane] || backfaceMask[lane]) {
+				stats.frustumCulled += outsideMask[lane] ? 1u : 0u;
+				stats.backfaceCulled += outsideMask[lane] ? 0u : 1u;
+				stats.culledTriangles += range.indexCount / 3;
+				continue;
+			}
+			// Compactación: meshlets consecutivos en el index buffer se dibujan con una sola llamada.
+			if (!ranges.empty() && ranges.back().indexOffset + ranges.back().indexCount == range.indexOffset) {
+				ranges.back().indexCount += range.indexCount;
+			}
+			else {
+				ranges.push_back(range);
+			}
+		}
+	}
+
+	stats.ranges += static_cast<unsigned int>(ranges.size());
+	stats.milliseconds += std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
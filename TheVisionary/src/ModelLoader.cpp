@@ -4,39 +4,206 @@
  */
 
 #include "ModelLoader.h"
-#include "OBJ_Loader.h"
+#include "Profiler.h"
+#include "tiny_obj_loader.h"
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+	/// Identificador y versin del formato de malla cocinada (.vmesh).
+	const uint32_t kCookedMeshMagic = 0x48534D56; // 'VMSH'
+	const uint32_t kCookedMeshVersion = 4;  // v2: tabla de LODs por malla; v3: meshlets del LOD 0; v4: BVH del LOD 0
+
+	void
+	accumulateStats(TriangulationStats& total, const TriangulationStats& pass) {
+		total.polygons += pass.polygons;
+		total.triangles += pass.triangles;
+		total.quads += pass.quads;
+		total.ngons += pass.ngons;
+		total.degenerate += pass.degenerate;
+		total.fanFallbacks += pass.fanFallbacks;
+		total.milliseconds += pass.milliseconds;
+	}
+
+	void
+	accumulateCache(VertexCacheStats& total, const VertexCacheStats& pass) {
+		total.triangles += pass.triangles;
+		total.vertices += pass.vertices;
+		total.transformed += pass.transformed;
+		total.acmr = total.triangles ? float(total.transformed) / float(total.triangles) : 0.0f;
+		total.atvr = total.vertices ? float(total.transformed) / float(total.vertices) : 0.0f;
+	}
+
+	void
+	accumulateReport(MeshOptimizationReport& total, const MeshOptimizationReport& pass) {
+		accumulateCache(total.before, pass.before);
+		accumulateCache(total.after, pass.after);
+		total.clusters += pass.clusters;
+		total.removedVertices += pass.removedVertices;
+		total.milliseconds += pass.milliseconds;
+	}
+
+	void
+	logReport(const char* method, const MeshOptimizationReport& report) {
+		MESSAGE("ModelLoader", method, "Vertex cache ACMR " << report.before.acmr << " -> " << report.after.acmr
+			<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << " ("
+			<< report.clusters << " overdraw clusters, " << report.removedVertices << " unused vertices) in "
+			<< report.milliseconds << " ms");
+	}
+
+	void
+	logLODs(const char* method, const SimplificationStats& stats) {
+		if (stats.meshes == 0) {
+			return;
+		}
+		MESSAGE("ModelLoader", method, "Built " << stats.levels << " LODs for " << stats.meshes << " meshes ("
+			<< stats.sourceTriangles << " source triangles -> " << stats.lodTriangles << " LOD triangles) in "
+			<< stats.milliseconds << " ms, "
+			<< (stats.milliseconds > 0.0 ? stats.sourceTriangles / stats.milliseconds / 1000.0 : 0.0)
+			<< " M source triangles/s");
+	}
+
+	void
+	logMeshlets(const char* method, const MeshletBuildStats& stats) {
+		if (stats.meshlets == 0) {
+			return;
+		}
+		MESSAGE("ModelLoader", method, "Built " << stats.meshlets << " meshlets for " << stats.meshes << " meshes ("
+			<< double(stats.vertices) / stats.meshlets << " vertices, "
+			<< double(stats.triangles) / stats.meshlets << " triangles per meshlet, "
+			<< stats.cones << " with normal cones) in " << stats.milliseconds << " ms");
+	}
+
+	/// Calcula los volmenes envolventes de un rango de mallas y registra el rendimiento.
+	void
+	computeBounds(const char* method, MeshComponent* first, MeshComponent* last) {
+		PROFILE_SCOPE("ModelLoader::computeBounds");
+		const auto start = std::chrono::steady_clock::now();
+		size_t vertices = 0;
+		for (MeshComponent* mesh = first; mesh != last; ++mesh) {
+			mesh->m_bounds = BoundingVolume::compute(mesh->m_vertex);
+			vertices += mesh->m_vertex.size();
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (method && vertices > 0) {
+			MESSAGE("ModelLoader", method, "Bounds for " << (last - first) << " meshes (" << vertices << " vertices) in "
+				<< ms << " ms, " << (ms > 0.0 ? vertices / ms / 1000.0 : 0.0) << " M vertices/s");
+		}
+	}
+
+	/// Construye el BVH de tringulos del LOD 0 de un rango de mallas y registra el rendimiento.
+	void
+	buildBVHs(const char* method, MeshComponent* first, MeshComponent* last, JobSystem* jobs, BVHBuildStats& stats) {
+		PROFILE_SCOPE("ModelLoader::buildBVHs");
+		stats = BVHBuildStats();
+		for (MeshComponent* mesh = first; mesh != last; ++mesh) {
+			mesh->m_bvh.build(mesh->m_vertex, mesh->m_index.data(), size_t(mesh->m_numIndex) / 3, jobs, &stats);
+		}
+		if (method && stats.triangles > 0) {
+			MESSAGE("ModelLoader", method, "Triangle BVH for " << stats.meshes << " meshes (" << stats.triangles
+				<< " triangles, " << stats.nodes << " nodes, " << stats.subtrees << " parallel subtrees) in "
+				<< stats.milliseconds << " ms");
+		}
+	}
+
+	/// Memoria de GPU de las mallas con sus formatos frente a float + ndices de 32 bits.
+	void
+	logGpuFormats(const char* method, const std::vector<MeshComponent>& meshes) {
+		size_t fullBytes = 0;
+		size_t packedBytes = 0;
+		unsigned int compactMeshes = 0;
+		unsigned int shortIndexMeshes = 0;
+		for (const MeshComponent& mesh : meshes) {
+			fullBytes += mesh.m_vertex.size() * sizeof(SimpleVertex) + mesh.m_index.size() * sizeof(unsigned int);
+			packedBytes += mesh.m_vertex.size() * mesh.m_vertexLayout.getStride() +
+				mesh.m_index.size() * VertexCodec::getIndexSize(mesh.m_indexFormat);
+			compactMeshes += mesh.m_vertexLayout.isCompact() ? 1 : 0;
+			shortIndexMeshes += mesh.m_indexFormat == INDEX_UINT16 ? 1 : 0;
+		}
+		MESSAGE("ModelLoader", method, "GPU mesh data " << fullBytes << " -> " << packedBytes << " bytes ("
+			<< shortIndexMeshes << "/" << meshes.size() << " meshes with 16-bit indices, "
+			<< compactMeshes << " with compact vertices)");
+	}
+}
 
 MeshComponent
 ModelLoader::LoadOBJModel(const std::string& filePath) {
+	PROFILE_SCOPE("ModelLoader::LoadOBJModel");
 	MeshComponent mesh;
-	objl::Loader loader;
-
-	if (!loader.LoadFile(filePath)) {
+	m_triangulationStats = TriangulationStats();
+	m_optimizationReport = MeshOptimizationReport();
+	m_simplificationStats = SimplificationStats();
+	m_meshletStats = MeshletBuildStats();
+
+	// Se carga sin triangular: la triangulacin la hace MeshTriangulator.
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+	bool parsed = false;
+	{
+		PROFILE_SCOPE("ModelLoader::parseOBJ");
+		parsed = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str(), nullptr, false);
+	}
+	if (!parsed) {
+		ERROR("ModelLoader", "LoadOBJModel", "Unable to load OBJ " << filePath.c_str() << ": " << err.c_str());
 		return mesh;
 	}
 
 	mesh.m_name = filePath;
 
-	const unsigned int numVertices = loader.LoadedVertices.size();
-	const unsigned int numIndices = loader.LoadedIndices.size();
-
-	// Reservar memoria exacta para evitar reallocs
-	mesh.m_vertex.resize(numVertices);
-	mesh.m_index = std::move(loader.LoadedIndices);  // Mover directamente
-
-	// Usar acceso por ndice para evitar cpias extra
-	for (unsigned int i = 0; i < numVertices; ++i) {
-		const auto& v = loader.LoadedVertices[i];
-
-		mesh.m_vertex[i] = SimpleVertex{
-			{ v.Position.X, v.Position.Y, v.Position.Z },
-			{ v.TextureCoordinate.X, 1.0f - v.TextureCoordinate.Y }
-		};
+	// Un vrtice por par (posicin, UV) distinto; todas las shapes van a la misma malla.
+	std::unordered_map<uint64_t, unsigned int> vertexLookup;
+	std::vector<unsigned int> polygonIndices;
+	std::vector<unsigned int> polygonSizes;
+
+	for (const tinyobj::shape_t& shape : shapes) {
+		size_t corner = 0;
+		for (unsigned char faceSize : shape.mesh.num_face_vertices) {
+			for (unsigned int k = 0; k < faceSize; ++k, ++corner) {
+				const tinyobj::index_t& idx = shape.mesh.indices[corner];
+				const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(idx.vertex_index)) << 32) |
+					static_cast<uint32_t>(idx.texcoord_index);
+
+				auto found = vertexLookup.find(key);
+				if (found == vertexLookup.end()) {
+					SimpleVertex vertex{ XMFLOAT3(
+						attrib.vertices[3 * idx.vertex_index + 0],
+						attrib.vertices[3 * idx.vertex_index + 1],
+						attrib.vertices[3 * idx.vertex_index + 2]), XMFLOAT2(0.0f, 0.0f) };
+					if (idx.texcoord_index >= 0) {
+						vertex.Tex = XMFLOAT2(attrib.texcoords[2 * idx.texcoord_index + 0],
+							1.0f - attrib.texcoords[2 * idx.texcoord_index + 1]);
+					}
+					found = vertexLookup.emplace(key, static_cast<unsigned int>(mesh.m_vertex.size())).first;
+					mesh.m_vertex.push_back(vertex);
+				}
+				polygonIndices.push_back(found->second);
+			}
+			polygonSizes.push_back(faceSize);
+		}
 	}
 
-	mesh.m_numVertex = numVertices;
-	mesh.m_numIndex = numIndices;
+	{
+		PROFILE_SCOPE("ModelLoader::triangulate");
+		MeshTriangulator::triangulate(mesh.m_vertex, polygonIndices, polygonSizes,
+			mesh.m_index, m_jobs, &m_triangulationStats);
+	}
 
+	mesh.m_numVertex = static_cast<int>(mesh.m_vertex.size());
+	mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	processStages(mesh);
+
+	MESSAGE("ModelLoader", "LoadOBJModel", "Triangulated " << m_triangulationStats.polygons << " polygons ("
+		<< m_triangulationStats.quads << " quads, " << m_triangulationStats.ngons << " n-gons) in "
+		<< m_triangulationStats.milliseconds << " ms");
+	logReport("LoadOBJModel", m_optimizationReport);
+	logMeshlets("LoadOBJModel", m_meshletStats);
+	logLODs("LoadOBJModel", m_simplificationStats);
+	computeBounds("LoadOBJModel", &mesh, &mesh + 1);
+	buildBVHs("LoadOBJModel", &mesh, &mesh + 1, m_jobs, m_bvhStats);
+	logGpuFormats("LoadOBJModel", std::vector<MeshComponent>{ mesh });
 	return mesh;
 }
 
@@ -69,8 +236,29 @@ ModelLoader::InitializeFBXManager() {
 	return true;
 }
 
+void
+ModelLoader::processStages(MeshComponent& mesh) {
+	{
+		PROFILE_SCOPE("ModelLoader::optimize");
+		accumulateReport(m_optimizationReport, MeshOptimizer::optimize(mesh));
+	}
+	{
+		PROFILE_SCOPE("ModelLoader::buildMeshlets");
+		MeshletBuilder::build(mesh, &m_meshletStats);
+	}
+	{
+		PROFILE_SCOPE("ModelLoader::buildLODs");
+		MeshSimplifier::buildLODChain(mesh, m_lodRatios, &m_simplificationStats);
+	}
+	{
+		PROFILE_SCOPE("ModelLoader::selectFormats");
+		VertexCodec::selectFormats(mesh, m_compactVertices);
+	}
+}
+
 bool
 ModelLoader::LoadFBXModel(const std::string& filePath) {
+	PROFILE_SCOPE("ModelLoader::LoadFBXModel");
 	// 01. Initialize the SDK from FBX Manager
 	if (InitializeFBXManager()) {
 		// 02. Create an importer using the SDK manager
@@ -95,7 +283,12 @@ ModelLoader::LoadFBXModel(const std::string& filePath) {
 		}
 
 		// 04. Import the scene from the file into the scene
-		if (!lImporter->Import(lScene)) {
+		bool imported = false;
+		{
+			PROFILE_SCOPE("ModelLoader::importFBX");
+			imported = lImporter->Import(lScene);
+		}
+		if (!imported) {
 			ERROR("ModelLoader", "FbxImporter::Import()",
 				"Unable to import FBX Scene! Error: " << lImporter->GetStatus().GetErrorString());
 			lImporter->Destroy();
@@ -115,9 +308,24 @@ ModelLoader::LoadFBXModel(const std::string& filePath) {
 
 		if (lRootNode) {
 			MESSAGE("ModelLoader", "ModelLoader", "Processing model from the scene root node.");
+			m_triangulationStats = TriangulationStats();
+			m_optimizationReport = MeshOptimizationReport();
+			m_simplificationStats = SimplificationStats();
+			m_meshletStats = MeshletBuildStats();
+			const size_t firstMesh = meshes.size();
 			for (int i = 0; i < lRootNode->GetChildCount(); i++) {
 				ProcessFBXNode(lRootNode->GetChild(i));
 			}
+			MESSAGE("ModelLoader", "ModelLoader", "Triangulated " << m_triangulationStats.polygons << " polygons ("
+				<< m_triangulationStats.quads << " quads, " << m_triangulationStats.ngons << " n-gons, "
+				<< m_triangulationStats.fanFallbacks << " fan fallbacks) in "
+				<< m_triangulationStats.milliseconds << " ms");
+			logReport("LoadFBXModel", m_optimizationReport);
+			logMeshlets("LoadFBXModel", m_meshletStats);
+			logLODs("LoadFBXModel", m_simplificationStats);
+			computeBounds("LoadFBXModel", meshes.data() + firstMesh, meshes.data() + meshes.size());
+			buildBVHs("LoadFBXModel", meshes.data() + firstMesh, meshes.data() + meshes.size(), m_jobs, m_bvhStats);
+			logGpuFormats("LoadFBXModel", meshes);
 			return true;
 		}
 		else {
@@ -146,6 +354,7 @@ ModelLoader::ProcessFBXNode(FbxNode* node) {
 
 void
 ModelLoader::ProcessFBXMesh(FbxNode* node) {
+	PROFILE_SCOPE("ModelLoader::ProcessFBXMesh");
 	// 01. Get the mesh from the node. If there is no mesh, exit early.
 	FbxMesh* mesh = node->GetMesh();
 	if (!mesh) return;
@@ -205,13 +414,25 @@ ModelLoader::ProcessFBXMesh(FbxNode* node) {
 		}
 	}
 
-	// 04. Process indices: extract polygon vertex indices.
+	// 04. Process indices: extract polygon vertex indices and triangulate them
+	//     (Actor::render dibuja con TRIANGLELIST; quads y n-gonos no son vlidos tal cual).
+	std::vector<unsigned int> polygonIndices;
+	std::vector<unsigned int> polygonSizes(mesh->GetPolygonCount());
+	polygonIndices.reserve(mesh->GetPolygonVertexCount());
 	for (int i = 0; i < mesh->GetPolygonCount(); i++) {
+		polygonSizes[i] = mesh->GetPolygonSize(i);
 		for (int j = 0; j < mesh->GetPolygonSize(i); j++) {
-			indices.push_back(mesh->GetPolygonVertex(i, j));
+			polygonIndices.push_back(mesh->GetPolygonVertex(i, j));
 		}
 	}
 
+	TriangulationStats stats;
+	{
+		PROFILE_SCOPE("ModelLoader::triangulate");
+		MeshTriangulator::triangulate(vertices, polygonIndices, polygonSizes, indices, m_jobs, &stats);
+	}
+	accumulateStats(m_triangulationStats, stats);
+
 	// 05. Create a MeshComponent and populate it with the processed data.
 	MeshComponent meshData;
 	meshData.m_name = node->GetName();
@@ -220,6 +441,9 @@ ModelLoader::ProcessFBXMesh(FbxNode* node) {
 	meshData.m_numVertex = vertices.size();
 	meshData.m_numIndex = indices.size();
 
+	// Cach post-transformacin, meshlets, LODs y formatos de GPU.
+	processStages(meshData);
+
 	// 06. Add the processed mesh data to the collection.
 	meshes.push_back(meshData);
 }
@@ -239,3 +463,212 @@ ModelLoader::ProcessFBXMaterials(FbxSurfaceMaterial* material) {
 		}
 	}
 }
+
+bool
+ModelLoader::SaveCookedModel(const std::string& filePath) const {
+	PROFILE_SCOPE("ModelLoader::SaveCookedModel");
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		ERROR("ModelLoader", "SaveCookedModel", "Cannot open " << filePath.c_str());
+		return false;
+	}
+
+	const uint32_t header[3] = { kCookedMeshMagic, kCookedMeshVersion,
+		static_cast<uint32_t>(meshes.size()) };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	for (const MeshComponent& mesh : meshes) {
+		const uint32_t counts[3] = {
+			static_cast<uint32_t>(mesh.m_name.size()),
+			static_cast<uint32_t>(mesh.m_vertex.size()),
+			static_cast<uint32_t>(mesh.m_index.size()) };
+		file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+		file.write(mesh.m_name.data(), counts[0]);
+		file.write(reinterpret_cast<const char*>(mesh.m_vertex.data()),
+			static_cast<std::streamsize>(mesh.m_vertex.size() * sizeof(SimpleVertex)));
+		file.write(reinterpret_cast<const char*>(mesh.m_index.data()),
+			static_cast<std::streamsize>(mesh.m_index.size() * sizeof(unsigned int)));
+
+		const uint32_t lodCount = static_cast<uint32_t>(mesh.m_lods.size());
+		file.write(reinterpret_cast<const char*>(&lodCount), sizeof(lodCount));
+		file.write(reinterpret_cast<const char*>(mesh.m_lods.data()),
+			static_cast<std::streamsize>(lodCount * sizeof(MeshLOD)));
+
+		const uint32_t meshletCount = static_cast<uint32_t>(mesh.m_meshlets.size());
+		file.write(reinterpret_cast<const char*>(&meshletCount), sizeof(meshletCount));
+		file.write(reinterpret_cast<const char*>(mesh.m_meshlets.data()),
+			static_cast<std::streamsize>(meshletCount * sizeof(Meshlet)));
+
+		const std::vector<BVHNode>& bvhNodes = mesh.m_bvh.getNodes();
+		const std::vector<unsigned int>& bvhOrder = mesh.m_bvh.getTriangleOrder();
+		const uint32_t bvhCounts[2] = { static_cast<uint32_t>(bvhNodes.size()), static_cast<uint32_t>(bvhOrder.size()) };
+		file.write(reinterpret_cast<const char*>(bvhCounts), sizeof(bvhCounts));
+		file.write(reinterpret_cast<const char*>(bvhNodes.data()),
+			static_cast<std::streamsize>(bvhNodes.size() * sizeof(BVHNode)));
+		file.write(reinterpret_cast<const char*>(bvhOrder.data()),
+			static_cast<std::streamsize>(bvhOrder.size() * sizeof(unsigned int)));
+	}
+	return static_cast<bool>(file);
+}
+
+bool
+ModelLoader::LoadCookedModel(const std::string& filePath) {
+	PROFILE_SCOPE("ModelLoader::LoadCookedModel");
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+
+	// Lectura en un solo bloque; el parseo se hace en memoria.
+	const std::streamoff fileSize = file.tellg();
+	if (fileSize < 0) {
+		ERROR("ModelLoader", "LoadCookedModel", "Cannot read the size of " << filePath.c_str());
+		return false;
+	}
+	std::vector<char> data(static_cast<size_t>(fileSize));
+	file.seekg(0);
+	file.read(data.data(), static_cast<std::streamsize>(data.size()));
+	if (!file || !ParseCookedModel(data.data(), data.size())) {
+		ERROR("ModelLoader", "LoadCookedModel", "Invalid cooked model " << filePath.c_str());
+		return false;
+	}
+
+	modelName = filePath;
+	return true;
+}
+
+bool
+ModelLoader::ParseCookedModel(const void* data, size_t size) {
+	PROFILE_SCOPE("ModelLoader::ParseCookedModel");
+	const char* cursor = static_cast<const char*>(data);
+	const char* end = cursor + size;
+	auto read = [&cursor, end](void* dst, size_t bytes) {
+		if (static_cast<size_t>(end - cursor) < bytes) {
+			return false;
+		}
+		memcpy(dst, cursor, bytes);
+		cursor += bytes;
+		return true;
+	};
+	// Cada cuenta se compara con lo que queda antes de reservar: un archivo
+	// truncado o corrupto no provoca reservas enormes.
+	auto fits = [&cursor, end](size_t count, size_t elementSize) {
+		return count <= static_cast<size_t>(end - cursor) / elementSize;
+	};
+
+	uint32_t header[3] = {};
+	if (!read(header, sizeof(header)) ||
+		header[0] != kCookedMeshMagic || header[1] < 1 || header[1] > kCookedMeshVersion) {
+		return false;
+	}
+	// Cada malla ocupa al menos sus tres cuentas.
+	if (!fits(header[2], 3 * sizeof(uint32_t))) {
+		return false;
+	}
+
+	std::vector<MeshComponent> loaded(header[2]);
+	for (MeshComponent& mesh : loaded) {
+		uint32_t counts[3] = {};
+		if (!read(counts, sizeof(counts))) {
+			return false;
+		}
+		if (!fits(counts[0], 1) || !fits(counts[1], sizeof(SimpleVertex)) ||
+			!fits(counts[2], sizeof(unsigned int)) ||
+			size_t(counts[0]) + size_t(counts[1]) * sizeof(SimpleVertex) +
+			size_t(counts[2]) * sizeof(unsigned int) > static_cast<size_t>(end - cursor)) {
+			return false;
+		}
+		mesh.m_name.resize(counts[0]);
+		mesh.m_vertex.resize(counts[1]);
+		mesh.m_index.resize(counts[2]);
+		if (!read(&mesh.m_name[0], counts[0]) ||
+			!read(mesh.m_vertex.data(), counts[1] * sizeof(SimpleVertex)) ||
+			!read(mesh.m_index.data(), counts[2] * sizeof(unsigned int))) {
+			return false;
+		}
+		// ndices fuera de la malla leeran fuera de m_vertex al construir el BVH y los volmenes.
+		for (unsigned int index : mesh.m_index) {
+			if (index >= counts[1]) {
+				return false;
+			}
+		}
+		mesh.m_numVertex = static_cast<int>(counts[1]);
+		mesh.m_numIndex = static_cast<int>(counts[2]);
+		if (header[1] >= 2) {
+			uint32_t lodCount = 0;
+			if (!read(&lodCount, sizeof(lodCount)) || lodCount > counts[2] || !fits(lodCount, sizeof(MeshLOD))) {
+				return false;
+			}
+			mesh.m_lods.resize(lodCount);
+			if (!read(mesh.m_lods.data(), lodCount * sizeof(MeshLOD))) {
+				return false;
+			}
+			for (const MeshLOD& lod : mesh.m_lods) {
+				if (size_t(lod.indexOffset) + lod.indexCount > counts[2]) {
+					return false;
+				}
+			}
+			if (!mesh.m_lods.empty()) {
+				mesh.m_numIndex = static_cast<int>(mesh.m_lods[0].indexCount);
+			}
+		}
+		if (header[1] >= 3) {
+			uint32_t meshletCount = 0;
+			if (!read(&meshletCount, sizeof(meshletCount)) || meshletCount > counts[2] / 3 ||
+				!fits(meshletCount, sizeof(Meshlet))) {
+				return false;
+			}
+			mesh.m_meshlets.resize(meshletCount);
+			if (!read(mesh.m_meshlets.data(), meshletCount * sizeof(Meshlet))) {
+				return false;
+			}
+			for (const Meshlet& meshlet : mesh.m_meshlets) {
+				if (size_t(meshlet.indexOffset) + size_t(meshlet.triangleCount) * 3 > size_t(mesh.m_numIndex)) {
+					return false;
+				}
+			}
+		}
+		const size_t triangleCount = size_t(mesh.m_numIndex) / 3;
+		if (header[1] >= 4) {
+			uint32_t bvhCounts[2] = { 0, 0 };
+			if (!read(bvhCounts, sizeof(bvhCounts)) || bvhCounts[0] > 2 * triangleCount + 1 ||
+				bvhCounts[1] > 4 * triangleCount || !fits(bvhCounts[0], sizeof(BVHNode)) ||
+				size_t(bvhCounts[0]) * sizeof(BVHNode) + size_t(bvhCounts[1]) * sizeof(unsigned int) >
+				static_cast<size_t>(end - cursor)) {
+				return false;
+			}
+			std::vector<BVHNode> bvhNodes(bvhCounts[0]);
+			std::vector<unsigned int> bvhOrder(bvhCounts[1]);
+			if (!read(bvhNodes.data(), bvhCounts[0] * sizeof(BVHNode)) ||
+				!read(bvhOrder.data(), bvhCounts[1] * sizeof(unsigned int))) {
+				return false;
+			}
+			if (triangleCount > 0 && !mesh.m_bvh.load(std::move(bvhNodes), std::move(bvhOrder),
+				mesh.m_vertex, mesh.m_index.data(), triangleCount)) {
+				return false;
+			}
+		}
+		else {
+			// Asset anterior al BVH cocinado: se construye al cargar.
+			mesh.m_bvh.build(mesh.m_vertex, mesh.m_index.data(), triangleCount, m_jobs);
+		}
+		// Los volmenes no se guardan: se recalculan en una pasada SIMD sobre los vrtices.
+		mesh.m_bounds = BoundingVolume::compute(mesh.m_vertex);
+		// El formato de GPU no se guarda: depende de la opcin del cargador, no del asset.
+		VertexCodec::selectFormats(mesh, m_compactVertices);
+	}
+
+	meshes.insert(meshes.end(),
+		std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+	return true;
+}
+
+void
+ModelLoader::destroy() {
+	if (lSdkManager) {
+		// Destruir el administrador libera tambin la escena y los IOSettings.
+		lSdkManager->Destroy();
+		lSdkManager = nullptr;
+		lScene = nullptr;
+	}
+}
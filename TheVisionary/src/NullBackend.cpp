@@ -0,0 +1,471 @@
+﻿/**
+ * @file NullBackend.cpp
+ * @brief Grabación de los comandos en el stream binario y cuenta de recursos, sin GPU.
+ */
+
+#include "NullBackend.h"
+
+void
+NullBackend::beginFrame() {
+	m_writer.op(CMD_FRAME);
+	m_writer.u32(m_stats.frames++);
+}
+
+void
+NullBackend::reset() {
+	m_writer.clear();
+	m_resources.clear();
+	m_stats = NullBackendStats();
+}
+
+void
+NullBackend::setResourceBytes(const void* object, unsigned int bytes) {
+	if (!object) {
+		return;
+	}
+	NullResource& entry = resource(object, RESOURCE_GENERIC);
+	if (entry.bytes != bytes) {
+		// Se vuelve a declarar con el tamaño: quien lea el stream ve el último.
+		entry.bytes = bytes;
+		declare(entry);
+	}
+}
+
+void*
+NullBackend::createHandle(ResourceKind kind, unsigned int bytes, unsigned int flags) {
+	// La descripción vive en el montón: su dirección es única y sirve de asa.
+	std::unique_ptr<NullResource> handle(new NullResource());
+	handle->kind = kind;
+	handle->bytes = bytes;
+	handle->flags = flags;
+	void* object = handle.get();
+	m_handles.emplace(object, std::move(handle));
+	return object;
+}
+
+void
+NullBackend::describeResource(const void* object, NullResource& entry) {
+	auto it = m_handles.find(object);
+	if (it != m_handles.end()) {
+		entry.kind = it->second->kind;
+		entry.bytes = it->second->bytes;
+		entry.flags = it->second->flags;
+	}
+}
+
+const NullResource*
+NullBackend::findResource(const void* object) const {
+	auto it = m_resources.find(object);
+	return it != m_resources.end() ? &it->second : nullptr;
+}
+
+NullBackendStats
+NullBackend::getStats() const {
+	NullBackendStats stats = m_stats;
+	stats.resources = static_cast<unsigned int>(m_resources.size());
+	stats.streamBytes = m_writer.size();
+	return stats;
+}
+
+void
+NullBackend::command(CommandOp op) {
+	m_writer.op(op);
+	++m_stats.commands;
+	++m_stats.counts[op];
+	if (isBindCommand(op)) {
+		++m_stats.binds;
+	}
+}
+
+NullResource&
+NullBackend::resource(const void* object, ResourceKind kind) {
+	auto inserted = m_resources.emplace(object, NullResource());
+	NullResource& entry = inserted.first->second;
+	if (inserted.second) {
+		entry.id = static_cast<unsigned int>(m_resources.size());
+		entry.kind = kind;
+		describeResource(object, entry);
+		declare(entry);
+	}
+	else if (entry.kind == RESOURCE_GENERIC) {
+		// Visto antes solo como recurso (UpdateSubresource, Map): el enlace dice qué es.
+		entry.kind = kind;
+	}
+	return entry;
+}
+
+void
+NullBackend::declare(const NullResource& entry) {
+	m_writer.op(CMD_RESOURCE);
+	m_writer.u32(entry.id);
+	m_writer.u32(entry.kind);
+	m_writer.u32(entry.bytes);
+	m_writer.u32(entry.flags);
+}
+
+unsigned int
+NullBackend::bind(const void* object, ResourceKind kind) {
+	if (!object) {
+		return 0;
+	}
+	NullResource& entry = resource(object, kind);
+	++entry.binds;
+	return entry.id;
+}
+
+void
+NullBackend::writeBox(const BackendBox* box) {
+	m_writer.u32(box ? 1 : 0);
+	if (box) {
+		m_writer.u32(box->left);
+		m_writer.u32(box->top);
+		m_writer.u32(box->front);
+		m_writer.u32(box->right);
+		m_writer.u32(box->bottom);
+		m_writer.u32(box->back);
+	}
+}
+
+void
+NullBackend::ClearState() {
+	command(CMD_CLEAR_STATE);
+}
+
+void
+NullBackend::RSSetViewports(unsigned int NumViewports, const BackendViewport* pViewports) {
+	command(CMD_RS_SET_VIEWPORTS);
+	m_writer.u32(NumViewports);
+	for (unsigned int i = 0; i < NumViewports; ++i) {
+		m_writer.f32(pViewports[i].TopLeftX);
+		m_writer.f32(pViewports[i].TopLeftY);
+		m_writer.f32(pViewports[i].Width);
+		m_writer.f32(pViewports[i].Height);
+		m_writer.f32(pViewports[i].MinDepth);
+		m_writer.f32(pViewports[i].MaxDepth);
+	}
+}
+
+void
+NullBackend::PSSetShaderResources(unsigned int StartSlot,
+	unsigned int NumViews,
+	ID3D11ShaderResourceView* const* ppShaderResourceViews) {
+	writeSlots(CMD_PS_SET_SHADER_RESOURCES, StartSlot, NumViews, ppShaderResourceViews, RESOURCE_SHADER_RESOURCE_VIEW);
+}
+
+void
+NullBackend::IASetInputLayout(ID3D11InputLayout* pInputLayout) {
+	const unsigned int id = bind(pInputLayout, RESOURCE_INPUT_LAYOUT);
+	command(CMD_IA_SET_INPUT_LAYOUT);
+	m_writer.u32(id);
+}
+
+void
+NullBackend::VSSetShader(ID3D11VertexShader* pVertexShader,
+	ID3D11ClassInstance* const* ppClassInstances,
+	unsigned int NumClassInstances) {
+	(void)ppClassInstances; (void)NumClassInstances;
+	const unsigned int id = bind(pVertexShader, RESOURCE_VERTEX_SHADER);
+	command(CMD_VS_SET_SHADER);
+	m_writer.u32(id);
+}
+
+void
+NullBackend::PSSetShader(ID3D11PixelShader* pPixelShader,
+	ID3D11ClassInstance* const* ppClassInstances,
+	unsigned int NumClassInstances) {
+	(void)ppClassInstances; (void)NumClassInstances;
+	const unsigned int id = bind(pPixelShader, RESOURCE_PIXEL_SHADER);
+	command(CMD_PS_SET_SHADER);
+	m_writer.u32(id);
+}
+
+void
+NullBackend::UpdateSubresource(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	const BackendBox* pDstBox,
+	const void* pSrcData,
+	unsigned int SrcRowPitch,
+	unsigned int SrcDepthPitch,
+	unsigned int SrcBytes) {
+	NullResource& entry = resource(pDstResource, RESOURCE_GENERIC);
+	// Sin tamaño dado: el ancho de la caja (buffers) o el recurso entero si se conoce.
+	const unsigned int bytes = SrcBytes ? SrcBytes : pDstBox ? pDstBox->right - pDstBox->left : entry.bytes;
+	command(CMD_UPDATE_SUBRESOURCE);
+	m_writer.u32(entry.id);
+	m_writer.u32(DstSubresource);
+	m_writer.u32(bytes);
+	m_writer.u32(SrcRowPitch);
+	m_writer.u32(SrcDepthPitch);
+	writeBox(pDstBox);
+	// En texturas la caja va en texels: solo se graba lo que tiene tamaño en bytes seguro.
+	const bool record = m_recordContents && pSrcData && bytes && (SrcBytes || entry.kind == RESOURCE_BUFFER);
+	m_writer.u32(record ? bytes : 0);
+	if (record) {
+		m_writer.bytes(pSrcData, bytes);
+		m_stats.contentBytes += bytes;
+	}
+	++entry.updates;
+	entry.uploadBytes += bytes;
+	++m_stats.uploads;
+	m_stats.uploadBytes += bytes;
+}
+
+BackendResult
+NullBackend::Map(ID3D11Resource* pResource,
+	unsigned int Subresource,
+	unsigned int MapType,
+	unsigned int MapFlags,
+	BackendMappedSubresource* pMappedResource) {
+	(void)MapFlags;
+	NullResource& entry = resource(pResource, RESOURCE_GENERIC);
+	if (entry.bytes == 0) {
+		// Sin tamaño no hay memoria que devolver: setResourceBytes() o createResource() antes.
+		return BACKEND_INVALID_ARG;
+	}
+	// DISCARD no conserva el contenido en D3D; aquí la memoria simplemente se reutiliza.
+	entry.mapped.resize(entry.bytes);
+	command(CMD_MAP);
+	m_writer.u32(entry.id);
+	m_writer.u32(Subresource);
+	m_writer.u32(MapType);
+	++entry.updates;
+	++m_stats.maps;
+	pMappedResource->pData = entry.mapped.data();
+	pMappedResource->RowPitch = entry.bytes;
+	pMappedResource->DepthPitch = entry.bytes;
+	return BACKEND_OK;
+}
+
+void
+NullBackend::Unmap(ID3D11Resource* pResource, unsigned int Subresource) {
+	command(CMD_UNMAP);
+	m_writer.u32(resource(pResource, RESOURCE_GENERIC).id);
+	m_writer.u32(Subresource);
+	m_writer.u32(0);
+}
+
+void
+NullBackend::CopySubresourceRegion(ID3D11Resource* pDstResource,
+	unsigned int DstSubresource,
+	unsigned int DstX,
+	unsigned int DstY,
+	unsigned int DstZ,
+	ID3D11Resource* pSrcResource,
+	unsigned int SrcSubresource,
+	const BackendBox* pSrcBox) {
+	const unsigned int dst = resource(pDstResource, RESOURCE_GENERIC).id;
+	const unsigned int src = resource(pSrcResource, RESOURCE_GENERIC).id;
+	command(CMD_COPY_SUBRESOURCE_REGION);
+	m_writer.u32(dst);
+	m_writer.u32(DstSubresource);
+	m_writer.u32(DstX);
+	m_writer.u32(DstY);
+	m_writer.u32(DstZ);
+	m_writer.u32(src);
+	m_writer.u32(SrcSubresource);
+	writeBox(pSrcBox);
+}
+
+void
+NullBackend::IASetVertexBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppVertexBuffers,
+	const unsigned int* pStrides,
+	const unsigned int* pOffsets) {
+	bindAll(NumBuffers, ppVertexBuffers, RESOURCE_BUFFER);
+	command(CMD_IA_SET_VERTEX_BUFFERS);
+	m_writer.u32(StartSlot);
+	m_writer.u32(NumBuffers);
+	for (unsigned int i = 0; i < NumBuffers; ++i) {
+		m_writer.u32(m_ids[i]);
+		m_writer.u32(pStrides[i]);
+		m_writer.u32(pOffsets[i]);
+	}
+}
+
+void
+NullBackend::IASetIndexBuffer(ID3D11Buffer* pIndexBuffer,
+	unsigned int Format,
+	unsigned int Offset) {
+	const unsigned int id = bind(pIndexBuffer, RESOURCE_BUFFER);
+	command(CMD_IA_SET_INDEX_BUFFER);
+	m_writer.u32(id);
+	m_writer.u32(Format);
+	m_writer.u32(Offset);
+}
+
+void
+NullBackend::PSSetSamplers(unsigned int StartSlot,
+	unsigned int NumSamplers,
+	ID3D11SamplerState* const* ppSamplers) {
+	writeSlots(CMD_PS_SET_SAMPLERS, StartSlot, NumSamplers, ppSamplers, RESOURCE_SAMPLER_STATE);
+}
+
+void
+NullBackend::RSSetState(ID3D11RasterizerState* pRasterizerState) {
+	const unsigned int id = bind(pRasterizerState, RESOURCE_RASTERIZER_STATE);
+	command(CMD_RS_SET_STATE);
+	m_writer.u32(id);
+}
+
+void
+NullBackend::OMSetBlendState(ID3D11BlendState* pBlendState,
+	const float BlendFactor[4],
+	unsigned int SampleMask) {
+	const unsigned int id = bind(pBlendState, RESOURCE_BLEND_STATE);
+	command(CMD_OM_SET_BLEND_STATE);
+	m_writer.u32(id);
+	for (int i = 0; i < 4; ++i) {
+		m_writer.f32(BlendFactor ? BlendFactor[i] : 1.0f);
+	}
+	m_writer.u32(SampleMask);
+}
+
+void
+NullBackend::OMSetDepthStencilState(ID3D11DepthStencilState* pDepthStencilState,
+	unsigned int StencilRef) {
+	const unsigned int id = bind(pDepthStencilState, RESOURCE_DEPTH_STENCIL_STATE);
+	command(CMD_OM_SET_DEPTH_STENCIL_STATE);
+	m_writer.u32(id);
+	m_writer.u32(StencilRef);
+}
+
+void
+NullBackend::OMSetRenderTargets(unsigned int NumViews,
+	ID3D11RenderTargetView* const* ppRenderTargetViews,
+	ID3D11DepthStencilView* pDepthStencilView) {
+	bindAll(NumViews, ppRenderTargetViews, RESOURCE_RENDER_TARGET_VIEW);
+	const unsigned int depthStencil = bind(pDepthStencilView, RESOURCE_DEPTH_STENCIL_VIEW);
+	command(CMD_OM_SET_RENDER_TARGETS);
+	m_writer.u32(NumViews);
+	for (unsigned int i = 0; i < NumViews; ++i) {
+		m_writer.u32(m_ids[i]);
+	}
+	m_writer.u32(depthStencil);
+}
+
+void
+NullBackend::IASetPrimitiveTopology(unsigned int Topology) {
+	command(CMD_IA_SET_PRIMITIVE_TOPOLOGY);
+	m_writer.u32(Topology);
+}
+
+void
+NullBackend::ClearRenderTargetView(ID3D11RenderTargetView* pRenderTargetView,
+	const float ColorRGBA[4]) {
+	const unsigned int id = resource(pRenderTargetView, RESOURCE_RENDER_TARGET_VIEW).id;
+	command(CMD_CLEAR_RENDER_TARGET_VIEW);
+	m_writer.u32(id);
+	for (int i = 0; i < 4; ++i) {
+		m_writer.f32(ColorRGBA[i]);
+	}
+}
+
+void
+NullBackend::ClearDepthStencilView(ID3D11DepthStencilView* pDepthStencilView,
+	unsigned int ClearFlags,
+	float Depth,
+	uint8_t Stencil) {
+	const unsigned int id = resource(pDepthStencilView, RESOURCE_DEPTH_STENCIL_VIEW).id;
+	command(CMD_CLEAR_DEPTH_STENCIL_VIEW);
+	m_writer.u32(id);
+	m_writer.u32(ClearFlags);
+	m_writer.f32(Depth);
+	m_writer.u32(Stencil);
+}
+
+void
+NullBackend::VSSetConstantBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers) {
+	writeSlots(CMD_VS_SET_CONSTANT_BUFFERS, StartSlot, NumBuffers, ppConstantBuffers, RESOURCE_BUFFER);
+}
+
+void
+NullBackend::PSSetConstantBuffers(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers) {
+	writeSlots(CMD_PS_SET_CONSTANT_BUFFERS, StartSlot, NumBuffers, ppConstantBuffers, RESOURCE_BUFFER);
+}
+
+void
+NullBackend::VSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+	bindAll(NumBuffers, ppConstantBuffers, RESOURCE_BUFFER);
+	command(CMD_VS_SET_CONSTANT_BUFFERS1);
+	m_writer.u32(StartSlot);
+	m_writer.u32(NumBuffers);
+	for (unsigned int i = 0; i < NumBuffers; ++i) {
+		m_writer.u32(m_ids[i]);
+		m_writer.u32(pFirstConstant[i]);
+		m_writer.u32(pNumConstants[i]);
+	}
+}
+
+void
+NullBackend::PSSetConstantBuffers1(unsigned int StartSlot,
+	unsigned int NumBuffers,
+	ID3D11Buffer* const* ppConstantBuffers,
+	const unsigned int* pFirstConstant,
+	const unsigned int* pNumConstants) {
+	bindAll(NumBuffers, ppConstantBuffers, RESOURCE_BUFFER);
+	command(CMD_PS_SET_CONSTANT_BUFFERS1);
+	m_writer.u32(StartSlot);
+	m_writer.u32(NumBuffers);
+	for (unsigned int i = 0; i < NumBuffers; ++i) {
+		m_writer.u32(m_ids[i]);
+		m_writer.u32(pFirstConstant[i]);
+		m_writer.u32(pNumConstants[i]);
+	}
+}
+
+BackendResult
+NullBackend::FinishCommandList(bool RestoreDeferredContextState,
+	ID3D11CommandList** ppCommandList) {
+	// Sin GPU no hay lista que devolver: el envío paralelo cae al contexto inmediato.
+	command(CMD_FINISH_COMMAND_LIST);
+	m_writer.u32(RestoreDeferredContextState ? 1 : 0);
+	*ppCommandList = nullptr;
+	return BACKEND_NOT_IMPLEMENTED;
+}
+
+void
+NullBackend::ExecuteCommandList(ID3D11CommandList* pCommandList, bool RestoreContextState) {
+	const unsigned int id = resource(pCommandList, RESOURCE_COMMAND_LIST).id;
+	command(CMD_EXECUTE_COMMAND_LIST);
+	m_writer.u32(id);
+	m_writer.u32(RestoreContextState ? 1 : 0);
+}
+
+void
+NullBackend::DrawIndexed(unsigned int IndexCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation) {
+	command(CMD_DRAW_INDEXED);
+	m_writer.u32(IndexCount);
+	m_writer.u32(StartIndexLocation);
+	m_writer.i32(BaseVertexLocation);
+	++m_stats.draws;
+	++m_stats.instances;
+	m_stats.indices += IndexCount;
+}
+
+void
+NullBackend::DrawIndexedInstanced(unsigned int IndexCountPerInstance,
+	unsigned int InstanceCount,
+	unsigned int StartIndexLocation,
+	int BaseVertexLocation,
+	unsigned int StartInstanceLocation) {
+	command(CMD_DRAW_INDEXED_INSTANCED);
+	m_writer.u32(IndexCountPerInstance);
+	m_writer.u32(InstanceCount);
+	m_writer.u32(StartIndexLocation);
+	m_writer.i32(BaseVertexLocation);
+	m_writer.u32(StartInstanceLocation);
+	++m_stats.draws;
+	m_stats.instances += InstanceCount;
+	m_stats.indices += static_cast<uint64_t>(IndexCountPerInstance) * InstanceCount;
+}
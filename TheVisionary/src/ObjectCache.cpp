@@ -0,0 +1,125 @@
+﻿/**
+ * @file ObjectCache.cpp
+ * @brief Búsqueda e inserción de objetos de estado y shaders compartidos.
+ */
+
+#include "ObjectCache.h"
+#include "Hash.h"
+#include <cstring>
+
+namespace {
+	/// Hash de una clave de un tipo (los tipos no comparten entradas).
+	uint64_t
+	entryHash(CachedObjectType type, const void* key, size_t size) {
+		return hashCombine(hashBytes(key, size), type);
+	}
+}
+
+const ObjectCache::Entry*
+ObjectCache::lookup(CachedObjectType type, const void* key, size_t size, uint64_t hash) const {
+	auto range = m_entries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		const Entry& entry = it->second;
+		if (entry.type == type && entry.key.size() == size && std::memcmp(entry.key.data(), key, size) == 0) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+IUnknown*
+ObjectCache::find(CachedObjectType type, const void* key, size_t size, ID3DBlob** bytecode) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_enabled) {
+		if (const Entry* entry = lookup(type, key, size, entryHash(type, key, size))) {
+			++m_stats.hits[type];
+			entry->object->AddRef();
+			if (bytecode) {
+				*bytecode = entry->bytecode;
+				if (entry->bytecode) {
+					entry->bytecode->AddRef();
+				}
+			}
+			return entry->object;
+		}
+	}
+	++m_stats.misses[type];
+	return nullptr;
+}
+
+IUnknown*
+ObjectCache::insert(CachedObjectType type,
+	const void* key,
+	size_t size,
+	IUnknown* object,
+	ID3DBlob* bytecode,
+	ID3DBlob** sharedBytecode) {
+	if (!object) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_enabled) {
+		const uint64_t hash = entryHash(type, key, size);
+		// Otro hilo falló el mismo find() y guardó su objeto antes: se comparte ese.
+		if (const Entry* existing = lookup(type, key, size, hash)) {
+			object = existing->object;
+			bytecode = existing->bytecode;
+		}
+		else {
+			Entry entry;
+			entry.type = type;
+			entry.key.assign(static_cast<const char*>(key), size);
+			entry.object = object;
+			entry.bytecode = bytecode;
+			object->AddRef();
+			if (bytecode) {
+				bytecode->AddRef();
+			}
+			m_entries.emplace(hash, entry);
+		}
+	}
+	// Referencias del llamador, igual que en find().
+	object->AddRef();
+	if (sharedBytecode) {
+		*sharedBytecode = bytecode;
+		if (bytecode) {
+			bytecode->AddRef();
+		}
+	}
+	return object;
+}
+
+void
+ObjectCache::clear() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto& item : m_entries) {
+		SAFE_RELEASE(item.second.object);
+		SAFE_RELEASE(item.second.bytecode);
+	}
+	m_entries.clear();
+}
+
+ObjectCacheStats
+ObjectCache::getStats() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	ObjectCacheStats stats = m_stats;
+	stats.objects = static_cast<unsigned int>(m_entries.size());
+	return stats;
+}
+
+void
+ObjectCache::resetStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats = ObjectCacheStats();
+}
+
+std::string
+ObjectCache::shaderKey(const std::string& source, const char* entryPoint, const char* profile) {
+	// Punto de entrada y perfil delante del código, separados por '\0' para que no se confundan.
+	std::string key = entryPoint;
+	key += '\0';
+	key += profile;
+	key += '\0';
+	key += source;
+	return key;
+}
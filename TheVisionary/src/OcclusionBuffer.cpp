@@ -0,0 +1,389 @@
+﻿/**
+ * @file OcclusionBuffer.cpp
+ * @brief Binning por tiles, rasterizado SIMD de profundidad y prueba jerárquica de volúmenes.
+ */
+
+#include "OcclusionBuffer.h"
+#include "JobSystem.h"
+#include <cfloat>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+	/// Cabecera de los buffers de referencia ('VOCC').
+	const uint32_t kDepthFileMagic = 0x43434F56;
+
+	/// Diferencia de profundidad tolerada frente a la referencia.
+	const float kGoldenTolerance = 1.0e-6f;
+
+	/// Agrega una caja con las caras en sentido horario vistas desde fuera (cara frontal del rasterizador).
+	void
+	appendBox(std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& indices,
+		const XMFLOAT3& center, const XMFLOAT3& half) {
+		// Normal de la cara y dos ejes con u x v = normal.
+		const float faces[6][9] = {
+			{ 1, 0, 0,  0, 1, 0,  0, 0, 1 }, { -1, 0, 0,  0, 0, 1,  0, 1, 0 },
+			{ 0, 1, 0,  0, 0, 1,  1, 0, 0 }, { 0, -1, 0,  1, 0, 0,  0, 0, 1 },
+			{ 0, 0, 1,  1, 0, 0,  0, 1, 0 }, { 0, 0, -1,  0, 1, 0,  1, 0, 0 } };
+		const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+		for (const float* face : faces) {
+			const unsigned int base = static_cast<unsigned int>(vertices.size());
+			for (const float* corner : corners) {
+				SimpleVertex vertex;
+				vertex.Pos = XMFLOAT3(
+					center.x + half.x * (face[0] + corner[0] * face[3] + corner[1] * face[6]),
+					center.y + half.y * (face[1] + corner[0] * face[4] + corner[1] * face[7]),
+					center.z + half.z * (face[2] + corner[0] * face[5] + corner[1] * face[8]));
+				vertex.Tex = XMFLOAT2(0.0f, 0.0f);
+				vertices.push_back(vertex);
+			}
+			indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+		}
+	}
+}
+
+void
+OcclusionBuffer::init(unsigned int width, unsigned int height) {
+	m_tilesX = std::max(1u, (width + kTileWidth - 1) / kTileWidth);
+	m_tilesY = std::max(1u, (height + kTileHeight - 1) / kTileHeight);
+	m_width = m_tilesX * kTileWidth;
+	m_height = m_tilesY * kTileHeight;
+	m_depth.assign(size_t(m_width) * m_height, 1.0f);
+	m_tileMaxDepth.assign(size_t(m_tilesX) * m_tilesY, 1.0f);
+	m_bins.assign(size_t(m_tilesX) * m_tilesY, std::vector<unsigned int>());
+	m_viewProjection = XMMatrixIdentity();
+}
+
+void
+OcclusionBuffer::begin(const XMMATRIX& viewProjection) {
+	if (m_width == 0) {
+		init();
+	}
+	m_viewProjection = viewProjection;
+	m_triangles.clear();
+	for (auto& bin : m_bins) {
+		bin.clear();
+	}
+	m_stats = OcclusionStats();
+}
+
+void
+OcclusionBuffer::addOccluder(const std::vector<SimpleVertex>& vertices,
+	const unsigned int* indices,
+	unsigned int indexCount,
+	const XMMATRIX& world) {
+	const auto start = std::chrono::steady_clock::now();
+	const XMMATRIX worldViewProjection = world * m_viewProjection;
+	m_clip.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const XMFLOAT3& p = vertices[i].Pos;
+		XMStoreFloat4(&m_clip[i], XMVector4Transform(XMVectorSet(p.x, p.y, p.z, 1.0f), worldViewProjection));
+	}
+
+	const float width = float(m_width);
+	const float height = float(m_height);
+	++m_stats.occluders;
+	m_stats.triangles += indexCount / 3;
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+		const XMFLOAT4* clip[3] = { &m_clip[indices[i]], &m_clip[indices[i + 1]], &m_clip[indices[i + 2]] };
+		// Conservador: lo que cruza el plano cercano no se rasteriza (no oculta nada).
+		if (clip[0]->z < 0.0f || clip[1]->z < 0.0f || clip[2]->z < 0.0f) {
+			continue;
+		}
+		ScreenTriangle triangle;
+		for (int v = 0; v < 3; ++v) {
+			const float invW = 1.0f / clip[v]->w;
+			triangle.x[v] = (clip[v]->x * invW * 0.5f + 0.5f) * width;
+			triangle.y[v] = (0.5f - clip[v]->y * invW * 0.5f) * height;
+			triangle.z[v] = clip[v]->z * invW;
+		}
+		// Horario en pantalla (y hacia abajo) = área positiva = cara frontal.
+		const float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+			(triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+		if (!(area > 0.0f)) {
+			continue;
+		}
+		const float minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+		const float maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+		const float minY = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+		const float maxY = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+		const float minZ = std::min(std::min(triangle.z[0], triangle.z[1]), triangle.z[2]);
+		if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height || minZ > 1.0f) {
+			continue;
+		}
+
+		const unsigned int index = static_cast<unsigned int>(m_triangles.size());
+		m_triangles.push_back(triangle);
+		const unsigned int tileX0 = static_cast<unsigned int>(std::max(minX, 0.0f)) / kTileWidth;
+		const unsigned int tileX1 = std::min(static_cast<unsigned int>(maxX) / kTileWidth, m_tilesX - 1);
+		const unsigned int tileY0 = static_cast<unsigned int>(std::max(minY, 0.0f)) / kTileHeight;
+		const unsigned int tileY1 = std::min(static_cast<unsigned int>(maxY) / kTileHeight, m_tilesY - 1);
+		for (unsigned int ty = tileY0; ty <= tileY1; ++ty) {
+			for (unsigned int tx = tileX0; tx <= tileX1; ++tx) {
+				m_bins[ty * m_tilesX + tx].push_back(index);
+			}
+		}
+		++m_stats.rasterized;
+	}
+	m_stats.rasterMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+OcclusionBuffer::rasterize(JobSystem* jobs) {
+	const auto start = std::chrono::steady_clock::now();
+	const unsigned int tileCount = m_tilesX * m_tilesY;
+	if (jobs && jobs->getThreadCount() > 0) {
+		jobs->parallelFor(tileCount, 4, [this](unsigned int begin, unsigned int end) {
+			for (unsigned int tile = begin; tile < end; ++tile) {
+				rasterizeTile(tile);
+			}
+		});
+	}
+	else {
+		for (unsigned int tile = 0; tile < tileCount; ++tile) {
+			rasterizeTile(tile);
+		}
+	}
+	m_stats.rasterMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+OcclusionBuffer::rasterizeTile(unsigned int tile) {
+	const unsigned int tileX = (tile % m_tilesX) * kTileWidth;
+	const unsigned int tileY = (tile / m_tilesX) * kTileHeight;
+	for (unsigned int y = tileY; y < tileY + kTileHeight; ++y) {
+		std::fill_n(&m_depth[size_t(y) * m_width + tileX], kTileWidth, 1.0f);
+	}
+
+	const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR one = XMVectorReplicate(1.0f);
+	for (unsigned int index : m_bins[tile]) {
+		const ScreenTriangle& t = m_triangles[index];
+
+		// Funciones de arista E(x, y) = A x + B y + C, positivas dentro (triángulo horario en pantalla).
+		float edgeA[3], edgeB[3], edgeC[3];
+		for (int e = 0; e < 3; ++e) {
+			const int next = (e + 1) % 3;
+			edgeA[e] = t.y[e] - t.y[next];
+			edgeB[e] = t.x[next] - t.x[e];
+			edgeC[e] = -(edgeA[e] * t.x[e] + edgeB[e] * t.y[e]);
+		}
+		// Plano de profundidad z = a x + b y + c (z/w es lineal en pantalla).
+		const float dx1 = t.x[1] - t.x[0], dy1 = t.y[1] - t.y[0], dz1 = t.z[1] - t.z[0];
+		const float dx2 = t.x[2] - t.x[0], dy2 = t.y[2] - t.y[0], dz2 = t.z[2] - t.z[0];
+		const float invArea = 1.0f / (dx1 * dy2 - dx2 * dy1);
+		const float depthA = (dz1 * dy2 - dz2 * dy1) * invArea;
+		const float depthB = (dx1 * dz2 - dx2 * dz1) * invArea;
+		const float depthC = t.z[0] - depthA * t.x[0] - depthB * t.y[0];
+
+		// Rectángulo del triángulo dentro del tile, con x alineada a 4 píxeles.
+		const float minX = std::min(std::min(t.x[0], t.x[1]), t.x[2]);
+		const float maxX = std::max(std::max(t.x[0], t.x[1]), t.x[2]);
+		const float minY = std::min(std::min(t.y[0], t.y[1]), t.y[2]);
+		const float maxY = std::max(std::max(t.y[0], t.y[1]), t.y[2]);
+		const unsigned int x0 = std::max(tileX, static_cast<unsigned int>(std::max(minX, 0.0f)) & ~3u);
+		const unsigned int x1 = std::min(tileX + kTileWidth, static_cast<unsigned int>(std::max(maxX + 1.0f, 0.0f)));
+		const unsigned int y0 = std::max(tileY, static_cast<unsigned int>(std::max(minY, 0.0f)));
+		const unsigned int y1 = std::min(tileY + kTileHeight, static_cast<unsigned int>(std::max(maxY + 1.0f, 0.0f)));
+
+		const XMVECTOR a0 = XMVectorReplicate(edgeA[0]), a1 = XMVectorReplicate(edgeA[1]), a2 = XMVectorReplicate(edgeA[2]);
+		const XMVECTOR depthAV = XMVectorReplicate(depthA);
+		for (unsigned int y = y0; y < y1; ++y) {
+			const float py = float(y) + 0.5f;
+			const XMVECTOR row0 = XMVectorReplicate(edgeB[0] * py + edgeC[0]);
+			const XMVECTOR row1 = XMVectorReplicate(edgeB[1] * py + edgeC[1]);
+			const XMVECTOR row2 = XMVectorReplicate(edgeB[2] * py + edgeC[2]);
+			const XMVECTOR rowDepth = XMVectorReplicate(depthB * py + depthC);
+			float* depthRow = &m_depth[size_t(y) * m_width];
+			for (unsigned int x = x0; x < x1; x += 4) {
+				const XMVECTOR px = XMVectorAdd(XMVectorReplicate(float(x)), laneOffsets);
+				XMVECTOR inside = XMVectorGreaterOrEqual(XMVectorMultiplyAdd(a0, px, row0), zero);
+				inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(a1, px, row1), zero));
+				inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(a2, px, row2), zero));
+				if (XMVector4EqualInt(inside, XMVectorFalseInt())) {
+					continue;
+				}
+				const XMVECTOR depth = XMVectorMin(XMVectorMax(XMVectorMultiplyAdd(depthAV, px, rowDepth), zero), one);
+				XMFLOAT4* target = reinterpret_cast<XMFLOAT4*>(depthRow + x);
+				const XMVECTOR current = XMLoadFloat4(target);
+				XMStoreFloat4(target, XMVectorSelect(current, XMVectorMin(current, depth), inside));
+			}
+		}
+	}
+
+	// Profundidad más lejana del tile (nivel grueso de la jerarquía).
+	float tileMax = 0.0f;
+	for (unsigned int y = tileY; y < tileY + kTileHeight; ++y) {
+		const float* depthRow = &m_depth[size_t(y) * m_width + tileX];
+		tileMax = std::max(tileMax, *std::max_element(depthRow, depthRow + kTileWidth));
+	}
+	m_tileMaxDepth[tile] = tileMax;
+}
+
+bool
+OcclusionBuffer::isVisible(const MeshBounds& bounds) {
+	if (bounds.isEmpty() || m_width == 0) {
+		return true;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	++m_stats.tested;
+
+	// Rectángulo en pantalla y profundidad mínima de las 8 esquinas.
+	float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+	bool crossesNear = false;
+	for (int corner = 0; corner < 8 && !crossesNear; ++corner) {
+		const XMVECTOR point = XMVectorSet(
+			bounds.center.x + ((corner & 1) ? bounds.extents.x : -bounds.extents.x),
+			bounds.center.y + ((corner & 2) ? bounds.extents.y : -bounds.extents.y),
+			bounds.center.z + ((corner & 4) ? bounds.extents.z : -bounds.extents.z), 1.0f);
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(point, m_viewProjection));
+		if (clip.z < 0.0f) {
+			crossesNear = true;
+			break;
+		}
+		const float invW = 1.0f / clip.w;
+		const float sx = (clip.x * invW * 0.5f + 0.5f) * m_width;
+		const float sy = (0.5f - clip.y * invW * 0.5f) * m_height;
+		minX = std::min(minX, sx);
+		maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy);
+		maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, clip.z * invW);
+	}
+
+	bool visible = true;
+	if (!crossesNear && maxX >= 0.0f && maxY >= 0.0f && minX < float(m_width) && minY < float(m_height)) {
+		const unsigned int x0 = static_cast<unsigned int>(std::max(minX, 0.0f));
+		const unsigned int x1 = std::min(m_width - 1, static_cast<unsigned int>(maxX));
+		const unsigned int y0 = static_cast<unsigned int>(std::max(minY, 0.0f));
+		const unsigned int y1 = std::min(m_height - 1, static_cast<unsigned int>(maxY));
+		visible = false;
+		for (unsigned int ty = y0 / kTileHeight; ty <= y1 / kTileHeight && !visible; ++ty) {
+			for (unsigned int tx = x0 / kTileWidth; tx <= x1 / kTileWidth && !visible; ++tx) {
+				// Todo el tile está más cerca que el punto más cercano del volumen: oculto en este tile.
+				if (minZ >= m_tileMaxDepth[ty * m_tilesX + tx]) {
+					continue;
+				}
+				const unsigned int px0 = std::max(x0, tx * kTileWidth);
+				const unsigned int px1 = std::min(x1, (tx + 1) * kTileWidth - 1);
+				const unsigned int py0 = std::max(y0, ty * kTileHeight);
+				const unsigned int py1 = std::min(y1, (ty + 1) * kTileHeight - 1);
+				for (unsigned int y = py0; y <= py1 && !visible; ++y) {
+					const float* depthRow = &m_depth[size_t(y) * m_width];
+					for (unsigned int x = px0; x <= px1; ++x) {
+						if (depthRow[x] > minZ) {
+							visible = true;
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (!visible) {
+		++m_stats.occluded;
+	}
+	m_stats.testMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return visible;
+}
+
+bool
+OcclusionBuffer::saveDepth(const std::string& filePath) const {
+	std::error_code ec;
+	const std::filesystem::path parent = std::filesystem::path(filePath).parent_path();
+	if (!parent.empty()) {
+		std::filesystem::create_directories(parent, ec);
+	}
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		ERROR("OcclusionBuffer", "saveDepth", "Cannot open " << filePath.c_str());
+		return false;
+	}
+	const uint32_t header[3] = { kDepthFileMagic, m_width, m_height };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(m_depth.data()),
+		static_cast<std::streamsize>(m_depth.size() * sizeof(float)));
+	return static_cast<bool>(file);
+}
+
+OcclusionGoldenResult
+OcclusionBuffer::checkGolden(const std::string& goldenPath, bool rewrite, JobSystem* jobs) {
+	OcclusionGoldenResult result;
+
+	// Escena fija: un muro frente a la cámara y un cubo a la derecha.
+	std::vector<SimpleVertex> wallVertices(4);
+	wallVertices[0].Pos = XMFLOAT3(-4.0f, 0.0f, 0.0f);
+	wallVertices[1].Pos = XMFLOAT3(-4.0f, 4.0f, 0.0f);
+	wallVertices[2].Pos = XMFLOAT3(4.0f, 4.0f, 0.0f);
+	wallVertices[3].Pos = XMFLOAT3(4.0f, 0.0f, 0.0f);
+	const std::vector<unsigned int> wallIndices = { 0, 1, 2, 0, 2, 3 };
+	std::vector<SimpleVertex> cubeVertices;
+	std::vector<unsigned int> cubeIndices;
+	appendBox(cubeVertices, cubeIndices, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	// Giro en Y con coseno 0.8 y seno 0.6 escritos a mano: sin seno ni coseno, la referencia no depende de su aproximación.
+	const XMMATRIX cubeWorld(
+		0.8f, 0.0f, -0.6f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.6f, 0.0f, 0.8f, 0.0f,
+		6.0f, 1.0f, 2.0f, 1.0f);
+
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f),
+		XMVectorSet(0.0f, 2.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	// Unos 44 grados de campo vertical con la proporción 5:3 del buffer, sin tangente.
+	const XMMATRIX projection = XMMatrixPerspectiveLH(0.25f, 0.15f, 0.1875f, 100.0f);
+
+	OcclusionBuffer buffer;
+	buffer.init(320, 192);
+	auto render = [&](JobSystem* pool) {
+		buffer.begin(view * projection);
+		buffer.addOccluder(wallVertices, wallIndices.data(), static_cast<unsigned int>(wallIndices.size()), XMMatrixIdentity());
+		buffer.addOccluder(cubeVertices, cubeIndices.data(), static_cast<unsigned int>(cubeIndices.size()), cubeWorld);
+		buffer.rasterize(pool);
+	};
+	render(nullptr);
+	const std::vector<float> serial = buffer.getDepth();
+	render(jobs);
+	result.serialMatchesParallel = buffer.getDepth() == serial;
+
+	// Detrás del muro: oculto; delante del muro y por encima de él: visibles.
+	auto box = [](float x, float y, float z, float half) {
+		MeshBounds bounds;
+		bounds.center = XMFLOAT3(x, y, z);
+		bounds.extents = XMFLOAT3(half, half, half);
+		bounds.sphere = XMFLOAT4(x, y, z, half * 1.7320508f);
+		return bounds;
+	};
+	result.visibilityMatches = !buffer.isVisible(box(0.0f, 2.0f, 5.0f, 1.0f)) &&
+		buffer.isVisible(box(0.0f, 2.0f, -3.0f, 0.5f)) &&
+		buffer.isVisible(box(0.0f, 9.0f, 5.0f, 1.0f));
+
+	if (rewrite) {
+		result.rewritten = buffer.saveDepth(goldenPath);
+		return result;
+	}
+
+	// Sin referencia la prueba falla: solo se escribe con rewrite explícito.
+	std::ifstream file(goldenPath, std::ios::binary);
+	if (file) {
+		result.goldenFound = true;
+		uint32_t header[3] = { 0, 0, 0 };
+		file.read(reinterpret_cast<char*>(header), sizeof(header));
+		result.sizeMatches = file && header[0] == kDepthFileMagic &&
+			header[1] == buffer.getWidth() && header[2] == buffer.getHeight();
+		if (result.sizeMatches) {
+			std::vector<float> golden(serial.size());
+			file.read(reinterpret_cast<char*>(golden.data()), static_cast<std::streamsize>(golden.size() * sizeof(float)));
+			result.sizeMatches = static_cast<bool>(file);
+			for (size_t i = 0; i < golden.size() && result.sizeMatches; ++i) {
+				const float error = std::fabs(golden[i] - serial[i]);
+				result.maxError = std::max(result.maxError, error);
+				result.mismatched += error > kGoldenTolerance ? 1 : 0;
+			}
+		}
+	}
+	return result;
+}
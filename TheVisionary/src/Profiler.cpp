@@ -0,0 +1,474 @@
+﻿/**
+ * @file Profiler.cpp
+ * @brief Anillos de eventos por hilo, árbol de zonas por frame y exportación a trazas de Chrome.
+ */
+
+#include "Profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+	const uint32_t kRingCapacity = 1u << 16; // Eventos por hilo (potencia de dos).
+	const uint32_t kRingReserve = 64;        // Huecos que solo usan los cierres: una zona abierta siempre se cierra.
+
+	int64_t
+	Now() {
+		return Profiler::Clock::now().time_since_epoch().count();
+	}
+
+	double
+	TicksToMs(int64_t ticks) {
+		return std::chrono::duration<double, std::milli>(Profiler::Clock::duration(ticks)).count();
+	}
+
+	double
+	TicksToUs(int64_t ticks) {
+		return std::chrono::duration<double, std::micro>(Profiler::Clock::duration(ticks)).count();
+	}
+
+	bool
+	SameName(const char* a, const char* b) {
+		return a == b || std::strcmp(a, b) == 0;
+	}
+
+	/// Nombre entre comillas y escapado para JSON.
+	std::string
+	JsonString(const char* text) {
+		std::string out = "\"";
+		for (const char* c = text; *c; ++c) {
+			if (*c == '"' || *c == '\\') {
+				out += '\\';
+				out += *c;
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20) {
+				out += ' ';
+			}
+			else {
+				out += *c;
+			}
+		}
+		out += '"';
+		return out;
+	}
+}
+
+/**
+ * @struct ProfileThread
+ * @brief Anillo de eventos de un hilo (productor) y su estado en la recogida (consumidor).
+ */
+struct ProfileThread {
+	// Productor: solo el hilo dueño.
+	std::vector<ProfileEvent> events;            ///< Anillo de kRingCapacity eventos.
+	std::atomic<uint32_t> head{ 0 };             ///< Siguiente escritura (la publica el productor).
+	std::atomic<uint32_t> tail{ 0 };             ///< Siguiente lectura (la publica el consumidor).
+	unsigned int skipped = 0;                    ///< Zonas abiertas que no cupieron (sus cierres se omiten).
+	std::atomic<unsigned int> dropped{ 0 };      ///< Eventos perdidos desde la última ventana.
+	std::atomic<bool> retired{ false };          ///< El hilo terminó (el anillo se puede reutilizar).
+	std::atomic<const char*> label{ nullptr };   ///< Nombre de setThreadName().
+
+	// Consumidor: beginFrame(), con el mutex del profiler.
+	unsigned int index = 0;                      ///< Posición en m_threads.
+	unsigned int id = 0;                         ///< Identificador del sistema.
+	std::vector<std::pair<int, int64_t>> stack;  ///< Zonas abiertas: nodo e inicio.
+	int firstRoot = -1;                          ///< Primera zona raíz del hilo.
+
+	ProfileThread() : events(kRingCapacity) {}
+
+	/** Escribe un evento si quedan más de reserve huecos libres. */
+	bool
+	push(ProfileEventType type, const char* name, double value, uint32_t reserve) {
+		const uint32_t write = head.load(std::memory_order_relaxed);
+		const uint32_t read = tail.load(std::memory_order_acquire);
+		if (write - read + reserve >= kRingCapacity) {
+			return false;
+		}
+		ProfileEvent& event = events[write & (kRingCapacity - 1)];
+		event.ticks = Now();
+		event.name = name;
+		event.value = value;
+		event.type = type;
+		head.store(write + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+namespace {
+	thread_local const char* t_threadName = nullptr;
+
+	/// Anillo del hilo; al terminar el hilo lo deja para otro.
+	struct ThreadSlot {
+		ProfileThread* thread = nullptr;
+		~ThreadSlot() {
+			if (thread) {
+				thread->retired.store(true, std::memory_order_release);
+			}
+		}
+	};
+	thread_local ThreadSlot t_slot;
+}
+
+std::atomic<bool> Profiler::s_enabled{ false };
+const unsigned int Profiler::kWindow;
+const size_t Profiler::kMaxTraceEvents;
+
+Profiler::Profiler() = default;
+
+Profiler::~Profiler() = default;
+
+Profiler&
+Profiler::get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+void
+Profiler::setThreadName(const char* name) {
+	t_threadName = name;
+	if (t_slot.thread) {
+		t_slot.thread->label.store(name, std::memory_order_release);
+	}
+}
+
+ProfileThread&
+Profiler::currentThread() {
+	if (!t_slot.thread) {
+		t_slot.thread = get().registerThread();
+	}
+	return *t_slot.thread;
+}
+
+void
+Profiler::beginZone(const char* name) {
+	ProfileThread& thread = currentThread();
+	if (thread.skipped > 0 || !thread.push(PROFILE_BEGIN, name, 0.0, kRingReserve)) {
+		// Las hijas de una zona perdida también se pierden: el árbol no se descuadra.
+		++thread.skipped;
+		thread.dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void
+Profiler::endZone() {
+	ProfileThread& thread = currentThread();
+	if (thread.skipped > 0) {
+		--thread.skipped;
+		return;
+	}
+	if (!thread.push(PROFILE_END, nullptr, 0.0, 0)) {
+		thread.dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void
+Profiler::counter(const char* name, double value) {
+	ProfileThread& thread = currentThread();
+	if (!thread.push(PROFILE_COUNTER, name, value, kRingReserve)) {
+		thread.dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+ProfileThread*
+Profiler::registerThread() {
+	std::lock_guard<std::mutex> lock(m_threadsMutex);
+	ProfileThread* thread = nullptr;
+	for (const auto& candidate : m_threads) {
+		// Un hilo terminado y ya recogido: su anillo y su árbol pasan al nuevo.
+		if (candidate->retired.load(std::memory_order_acquire) &&
+			candidate->head.load(std::memory_order_acquire) == candidate->tail.load(std::memory_order_relaxed)) {
+			thread = candidate.get();
+			thread->retired.store(false, std::memory_order_relaxed);
+			thread->stack.clear();
+			thread->skipped = 0;
+			break;
+		}
+	}
+	if (!thread) {
+		m_threads.emplace_back(new ProfileThread());
+		thread = m_threads.back().get();
+		thread->index = static_cast<unsigned int>(m_threads.size() - 1);
+	}
+	thread->id = static_cast<unsigned int>(GetCurrentThreadId());
+	thread->label.store(t_threadName, std::memory_order_release);
+	return thread;
+}
+
+int
+Profiler::findNode(ProfileThread& thread, int parent, const char* name) {
+	int last = -1;
+	for (int child = parent < 0 ? thread.firstRoot : m_nodes[parent].firstChild; child >= 0;
+		child = m_nodes[child].nextSibling) {
+		if (SameName(m_nodes[child].name, name)) {
+			return child;
+		}
+		last = child;
+	}
+
+	ProfileNode node;
+	node.name = name;
+	node.thread = thread.index;
+	node.parent = parent;
+	node.depth = parent < 0 ? 0 : m_nodes[parent].depth + 1;
+	const int index = static_cast<int>(m_nodes.size());
+	m_nodes.push_back(node);
+	if (last >= 0) {
+		m_nodes[last].nextSibling = index;
+	}
+	else if (parent < 0) {
+		thread.firstRoot = index;
+	}
+	else {
+		m_nodes[parent].firstChild = index;
+	}
+	return index;
+}
+
+void
+Profiler::consume(ProfileThread& thread) {
+	const uint32_t read = thread.tail.load(std::memory_order_relaxed);
+	const uint32_t write = thread.head.load(std::memory_order_acquire);
+	const bool tracing = m_captureFrames > 0;
+	for (uint32_t i = read; i != write; ++i) {
+		const ProfileEvent& event = thread.events[i & (kRingCapacity - 1)];
+		switch (event.type) {
+		case PROFILE_BEGIN: {
+			const int parent = thread.stack.empty() ? -1 : thread.stack.back().first;
+			thread.stack.push_back(std::make_pair(findNode(thread, parent, event.name), event.ticks));
+			break;
+		}
+		case PROFILE_END: {
+			if (thread.stack.empty()) {
+				break;
+			}
+			const int index = thread.stack.back().first;
+			const int64_t start = thread.stack.back().second;
+			thread.stack.pop_back();
+			ProfileNode& node = m_nodes[index];
+			node.frameTicks += event.ticks - start;
+			++node.frameCalls;
+			if (tracing && start >= m_captureStart && m_trace.size() < kMaxTraceEvents) {
+				m_trace.push_back(TraceEvent{ node.name, thread.index, start, event.ticks - start, 0.0, 'X' });
+			}
+			break;
+		}
+		default: {
+			CounterAccum* accum = nullptr;
+			for (CounterAccum& candidate : m_counterAccum) {
+				if (SameName(candidate.name, event.name)) {
+					accum = &candidate;
+					break;
+				}
+			}
+			if (!accum) {
+				m_counterAccum.push_back(CounterAccum{ event.name, 0.0, 0.0, event.value, 0 });
+				accum = &m_counterAccum.back();
+			}
+			accum->last = event.value;
+			accum->sum += event.value;
+			accum->max = accum->samples > 0 ? std::max(accum->max, event.value) : event.value;
+			++accum->samples;
+			if (tracing && event.ticks >= m_captureStart && m_trace.size() < kMaxTraceEvents) {
+				m_trace.push_back(TraceEvent{ event.name, thread.index, event.ticks, 0, event.value, 'C' });
+			}
+			break;
+		}
+		}
+	}
+	m_windowEvents += write - read;
+	thread.tail.store(write, std::memory_order_release);
+}
+
+void
+Profiler::beginFrame() {
+	const int64_t start = Now();
+	{
+		std::lock_guard<std::mutex> lock(m_threadsMutex);
+		for (const auto& thread : m_threads) {
+			consume(*thread);
+		}
+	}
+
+	// Las zonas cerradas desde la frontera anterior son el frame que termina.
+	for (ProfileNode& node : m_nodes) {
+		node.windowTicks += node.frameTicks;
+		node.windowMax = std::max(node.windowMax, node.frameTicks);
+		node.peak = std::max(node.peak, node.frameTicks);
+		node.windowCalls += node.frameCalls;
+		node.frameTicks = 0;
+		node.frameCalls = 0;
+	}
+	++m_frame;
+	++m_windowFrames;
+
+	if (m_captureFrames > 0) {
+		if (m_trace.size() < kMaxTraceEvents) {
+			m_trace.push_back(TraceEvent{ nullptr, 0, start, 0, static_cast<double>(m_frame), 'i' });
+		}
+		if (--m_captureFrames == 0) {
+			{
+				std::lock_guard<std::mutex> lock(m_threadsMutex);
+				refreshThreads();
+			}
+			if (writeChromeTrace(m_capturePath)) {
+				MESSAGE("Profiler", "beginFrame", "Chrome trace with " << m_trace.size() << " events written to "
+					<< m_capturePath.c_str() << (m_trace.size() >= kMaxTraceEvents ? " (truncated)" : ""));
+			}
+			else {
+				ERROR("Profiler", "beginFrame", "Cannot write " << m_capturePath.c_str());
+			}
+			m_trace.clear();
+			m_trace.shrink_to_fit();
+		}
+	}
+	m_stats.captureFrames = m_captureFrames;
+
+	m_windowCollectMs += TicksToMs(Now() - start);
+	if (m_windowFrames >= kWindow) {
+		publishWindow();
+	}
+}
+
+bool
+Profiler::startCapture(unsigned int frames, const std::string& path) {
+	if (isCapturing() || frames == 0) {
+		return false;
+	}
+	m_trace.clear();
+	m_capturePath = path;
+	m_captureStart = Now();
+	m_captureFrames = frames;
+	m_stats.captureFrames = frames;
+	setEnabled(true);
+	return true;
+}
+
+void
+Profiler::appendZones(int first, double frames) {
+	for (int index = first; index >= 0; index = m_nodes[index].nextSibling) {
+		const ProfileNode& node = m_nodes[index];
+		int64_t childTicks = 0;
+		for (int child = node.firstChild; child >= 0; child = m_nodes[child].nextSibling) {
+			childTicks += m_nodes[child].windowTicks;
+		}
+
+		ProfileZoneStats zone;
+		zone.name = node.name;
+		zone.thread = node.thread;
+		zone.depth = node.depth;
+		zone.calls = node.windowCalls / frames;
+		zone.avgMs = TicksToMs(node.windowTicks) / frames;
+		zone.maxMs = TicksToMs(node.windowMax);
+		zone.selfMs = TicksToMs(node.windowTicks - childTicks) / frames;
+		zone.peakMs = TicksToMs(node.peak);
+		m_zones.push_back(zone);
+
+		appendZones(node.firstChild, frames);
+	}
+}
+
+void
+Profiler::refreshThreads() {
+	m_threadStats.resize(m_threads.size());
+	for (const auto& thread : m_threads) {
+		ProfileThreadStats& stats = m_threadStats[thread->index];
+		stats.id = thread->id;
+		const char* label = thread->label.load(std::memory_order_acquire);
+		stats.name = label ? label : "Thread " + std::to_string(thread->id);
+	}
+}
+
+void
+Profiler::publishWindow() {
+	const double frames = m_windowFrames;
+	m_zones.clear();
+	unsigned int dropped = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_threadsMutex);
+		refreshThreads();
+		for (const auto& thread : m_threads) {
+			ProfileThreadStats& stats = m_threadStats[thread->index];
+			stats.dropped = thread->dropped.exchange(0, std::memory_order_relaxed);
+			dropped += stats.dropped;
+			appendZones(thread->firstRoot, frames);
+		}
+	}
+	for (ProfileNode& node : m_nodes) {
+		node.windowTicks = 0;
+		node.windowMax = 0;
+		node.windowCalls = 0;
+	}
+
+	m_counters.clear();
+	for (CounterAccum& accum : m_counterAccum) {
+		if (accum.samples == 0) {
+			continue;
+		}
+		ProfileCounterStats counter;
+		counter.name = accum.name;
+		counter.last = accum.last;
+		counter.average = accum.sum / accum.samples;
+		counter.max = accum.max;
+		counter.samples = accum.samples;
+		m_counters.push_back(counter);
+		accum.sum = 0.0;
+		accum.samples = 0;
+	}
+
+	m_stats.frames = m_windowFrames;
+	m_stats.eventsPerFrame = m_windowEvents / frames;
+	m_stats.collectMs = m_windowCollectMs / frames;
+	m_stats.dropped = dropped;
+	m_windowFrames = 0;
+	m_windowEvents = 0;
+	m_windowCollectMs = 0.0;
+}
+
+bool
+Profiler::writeChromeTrace(const std::string& path) const {
+	std::error_code ec;
+	const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+	if (!parent.empty()) {
+		std::filesystem::create_directories(parent, ec);
+	}
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	// Formato "JSON Object" de Trace Event: tiempos en microsegundos desde el comienzo.
+	char line[256];
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const ProfileThreadStats& thread : m_threadStats) {
+		std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+			thread.id);
+		file << (first ? "" : ",\n") << line << JsonString(thread.name.c_str()) << "}}";
+		first = false;
+	}
+	for (const TraceEvent& event : m_trace) {
+		const unsigned int tid = event.thread < m_threadStats.size() ? m_threadStats[event.thread].id : 0;
+		const double ts = TicksToUs(event.start - m_captureStart);
+		file << (first ? "" : ",\n");
+		first = false;
+		switch (event.phase) {
+		case 'X':
+			std::snprintf(line, sizeof(line), ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				tid, ts, TicksToUs(event.duration));
+			file << "{\"name\":" << JsonString(event.name) << line;
+			break;
+		case 'C':
+			std::snprintf(line, sizeof(line), ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%.17g}}",
+				tid, ts, event.value);
+			file << "{\"name\":" << JsonString(event.name) << line;
+			break;
+		default:
+			std::snprintf(line, sizeof(line), "{\"name\":\"Frame %.0f\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+				event.value, tid, ts);
+			file << line;
+			break;
+		}
+	}
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,617 @@
+﻿/**
+ * @file RenderQueue.cpp
+ * @brief Claves de orden, radix sort por bloques y envío con filtrado de estados.
+ */
+
+#include "RenderQueue.h"
+#include "DeviceContext.h"
+#include "JobSystem.h"
+#include "ConstantBufferRing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+namespace {
+	/// Slots de estado que submit() recuerda entre paquetes.
+	enum StateSlot {
+		STATE_VERTEX_SHADER = 0,
+		STATE_PIXEL_SHADER,
+		STATE_INPUT_LAYOUT,
+		STATE_BLEND,
+		STATE_RASTERIZER,
+		STATE_DEPTH_STENCIL,
+		STATE_SAMPLER,
+		STATE_TEXTURE,
+		STATE_VERTEX_BUFFER,
+		STATE_INDEX_BUFFER,
+		STATE_CONSTANT_BUFFER,
+		STATE_INSTANCE_BUFFER,
+		STATE_COUNT
+	};
+
+	/// Valor inicial de los slots: no coincide con ningún objeto (ni con nullptr).
+	const char kUnbound = 0;
+
+	/// Puntero ficticio para la cola sintética (nunca se desreferencia).
+	template<typename T>
+	T*
+	fakeObject(unsigned int kind, unsigned int index) {
+		return reinterpret_cast<T*>((uintptr_t(kind) << 24) | (uintptr_t(index + 1) << 4));
+	}
+
+	/// Paquetes de la cola sintética y lo que push() necesita de cada uno.
+	struct SyntheticScene {
+		std::vector<DrawPacket> packets;
+		std::vector<RenderPass> passes;
+		std::vector<float> depths;
+		std::vector<CBChangesEveryFrame> constants;
+	};
+
+	/// Actores de cuatro mallas con estados compartidos, como los de la escena, en orden de inserción.
+	void
+	buildSyntheticScene(unsigned int draws, SyntheticScene& scene) {
+		std::mt19937 rng(1234);
+		const unsigned int meshesPerActor = 4;
+		const unsigned int sharedMeshes = std::max(1u, draws / 16);
+		scene.packets.assign(draws, DrawPacket());
+		scene.passes.resize(draws);
+		scene.depths.resize(draws);
+		scene.constants.resize(draws);
+		for (unsigned int i = 0; i < draws; ++i) {
+			const unsigned int actor = i / meshesPerActor;
+			std::mt19937 actorRng(actor);
+			const bool shadow = actorRng() % 10 == 0;
+			DrawPacket& packet = scene.packets[i];
+			packet.vertexShader = fakeObject<ID3D11VertexShader>(1, 0);
+			packet.pixelShader = fakeObject<ID3D11PixelShader>(2, shadow ? 3 : actorRng() % 3);
+			const unsigned int mesh = rng() % sharedMeshes;
+			packet.inputLayout = fakeObject<ID3D11InputLayout>(3, mesh % 3);
+			packet.blendState = fakeObject<ID3D11BlendState>(4, shadow ? 1 : 0);
+			packet.rasterizerState = fakeObject<ID3D11RasterizerState>(5, actorRng() % 2);
+			packet.depthStencilState = shadow ? fakeObject<ID3D11DepthStencilState>(6, 0) : nullptr;
+			packet.sampler = fakeObject<ID3D11SamplerState>(7, actorRng() % 2);
+			packet.texture = fakeObject<ID3D11ShaderResourceView>(8, mesh % 256);
+			packet.vertexBuffer = fakeObject<ID3D11Buffer>(9, mesh);
+			packet.indexBuffer = fakeObject<ID3D11Buffer>(10, mesh);
+			packet.constantBuffer = fakeObject<ID3D11Buffer>(11, actor);
+			packet.constantData = &scene.constants[i];
+			packet.constantSize = sizeof(CBChangesEveryFrame);
+			packet.indexCount = 3 * (64 + rng() % 4096);
+			scene.passes[i] = shadow ? RENDER_PASS_SHADOW : RENDER_PASS_OPAQUE;
+			scene.depths[i] = 1.0f + float(rng() % 50000) * 0.01f;
+		}
+	}
+}
+
+void
+RenderQueue::begin() {
+	m_packets.clear();
+	m_entries.clear();
+}
+
+void
+RenderQueue::push(const DrawPacket& packet, RenderPass pass, float depth) {
+	const unsigned int shader = getStateId(packet.pixelShader);
+	const unsigned int material = ((getStateId(packet.inputLayout) & 0xF) << 12) | (getStateId(packet.texture) & 0xFFF);
+	const unsigned int geometry = getStateId(packet.vertexBuffer);
+	m_entries.push_back({ makeKey(pass, shader, material, geometry, depth), static_cast<unsigned int>(m_packets.size()) });
+	m_packets.push_back(packet);
+}
+
+void
+RenderQueue::retainPayloads() {
+	// Primero los tamaños: los punteros a las copias solo valen cuando ya no crecen.
+	size_t constantBytes = 0;
+	size_t rangeCount = 0;
+	m_retainedOffsets.clear();
+	for (const DrawPacket& packet : m_packets) {
+		if (packet.constantData && packet.constantSize > 0 &&
+			m_retainedOffsets.emplace(packet.constantData, constantBytes).second) {
+			constantBytes += (packet.constantSize + 15u) & ~15u;
+		}
+		if (packet.ranges) {
+			rangeCount += packet.rangeCount;
+		}
+	}
+	m_retainedConstants.resize(constantBytes);
+	m_retainedRanges.resize(rangeCount);
+
+	size_t nextRange = 0;
+	for (DrawPacket& packet : m_packets) {
+		if (packet.constantData && packet.constantSize > 0) {
+			uint8_t* copy = m_retainedConstants.data() + m_retainedOffsets[packet.constantData];
+			std::memcpy(copy, packet.constantData, packet.constantSize);
+			packet.constantData = copy;
+		}
+		if (packet.ranges) {
+			MeshletDrawRange* copy = m_retainedRanges.data() + nextRange;
+			std::copy(packet.ranges, packet.ranges + packet.rangeCount, copy);
+			packet.ranges = copy;
+			nextRange += packet.rangeCount;
+		}
+	}
+}
+
+uint64_t
+RenderQueue::makeKey(RenderPass pass, unsigned int shader, unsigned int material, unsigned int geometry, float depth) {
+	// Los bits de un float positivo crecen con su valor: los 16 altos (signo fuera) bastan para ordenar.
+	uint32_t bits = 0;
+	if (depth > 0.0f) {
+		std::memcpy(&bits, &depth, sizeof(bits));
+	}
+	uint64_t depthBits = bits >> 15;
+	if (pass == RENDER_PASS_SHADOW) {
+		depthBits = 0xFFFF - depthBits;
+	}
+	return (uint64_t(pass & 0xF) << 60) | (uint64_t(shader & 0xFFF) << 48) |
+		(uint64_t(material & 0xFFFF) << 32) | (uint64_t(geometry & 0xFFFF) << 16) | depthBits;
+}
+
+unsigned int
+RenderQueue::getStateId(const void* object) {
+	if (!object) {
+		return 0;
+	}
+	auto it = m_stateIds.find(object);
+	if (it == m_stateIds.end()) {
+		it = m_stateIds.emplace(object, static_cast<unsigned int>(m_stateIds.size() + 1)).first;
+	}
+	return it->second;
+}
+
+void
+RenderQueue::sort(JobSystem* jobs) {
+	const auto start = std::chrono::steady_clock::now();
+	const size_t count = m_entries.size();
+	unsigned int chunks = 1;
+	if (jobs && jobs->getThreadCount() > 0 && count >= kParallelThreshold) {
+		chunks = std::min<unsigned int>(jobs->getThreadCount() + 1,
+			static_cast<unsigned int>(count / (kParallelThreshold / 4)));
+	}
+	const size_t chunkSize = (count + chunks - 1) / std::max(1u, chunks);
+	m_scratch.resize(count);
+	m_histograms.resize(size_t(chunks) * 256);
+
+	auto forEachChunk = [&](auto&& body) {
+		if (chunks > 1) {
+			jobs->parallelFor(chunks, 1, [&](unsigned int begin, unsigned int end) {
+				for (unsigned int chunk = begin; chunk < end; ++chunk) {
+					body(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+				}
+			});
+		}
+		else {
+			body(0u, size_t(0), count);
+		}
+	};
+
+	for (unsigned int shift = 0; shift < 64 && count > 1; shift += 8) {
+		forEachChunk([&](unsigned int chunk, size_t begin, size_t end) {
+			unsigned int* histogram = &m_histograms[size_t(chunk) * 256];
+			std::fill_n(histogram, 256, 0u);
+			for (size_t i = begin; i < end; ++i) {
+				++histogram[(m_entries[i].key >> shift) & 0xFF];
+			}
+		});
+
+		// Si todas las claves comparten este dígito la pasada no mueve nada.
+		bool uniform = false;
+		for (unsigned int bucket = 0; bucket < 256 && !uniform; ++bucket) {
+			size_t total = 0;
+			for (unsigned int chunk = 0; chunk < chunks; ++chunk) {
+				total += m_histograms[size_t(chunk) * 256 + bucket];
+			}
+			uniform = total == count;
+		}
+		if (uniform) {
+			continue;
+		}
+
+		// Posición de salida de cada (cubeta, bloque): el orden de los bloques conserva la estabilidad.
+		unsigned int offset = 0;
+		for (unsigned int bucket = 0; bucket < 256; ++bucket) {
+			for (unsigned int chunk = 0; chunk < chunks; ++chunk) {
+				unsigned int& slot = m_histograms[size_t(chunk) * 256 + bucket];
+				const unsigned int bucketCount = slot;
+				slot = offset;
+				offset += bucketCount;
+			}
+		}
+
+		forEachChunk([&](unsigned int chunk, size_t begin, size_t end) {
+			unsigned int* histogram = &m_histograms[size_t(chunk) * 256];
+			for (size_t i = begin; i < end; ++i) {
+				const SortEntry& entry = m_entries[i];
+				m_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+			}
+		});
+		m_entries.swap(m_scratch);
+	}
+	m_stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+RenderQueue::RecordState::reset() {
+	stats = RenderQueueStats();
+	uploaded.clear();
+	updated.clear();
+	recorded.clear();
+	result = S_OK;
+}
+
+void
+RenderQueue::resetSubmitStats() {
+	m_stats.packets = static_cast<unsigned int>(m_packets.size());
+	m_stats.drawCalls = 0;
+	m_stats.instances = 0;
+	m_stats.bindsIssued = 0;
+	m_stats.bindsSkipped = 0;
+	m_stats.uploads = 0;
+	m_stats.ringDraws = 0;
+	m_stats.commandLists = 0;
+	m_stats.recordMs = 0.0;
+}
+
+void
+RenderQueue::addRecordStats(const RenderQueueStats& stats) {
+	m_stats.drawCalls += stats.drawCalls;
+	m_stats.instances += stats.instances;
+	m_stats.bindsIssued += stats.bindsIssued;
+	m_stats.bindsSkipped += stats.bindsSkipped;
+	m_stats.uploads += stats.uploads;
+	m_stats.ringDraws += stats.ringDraws;
+}
+
+bool
+RenderQueue::writeRing(DeviceContext* context, ConstantBufferRing* ring) {
+	// Todas las constantes del frame al anillo con un solo Map; luego cada draw se enlaza por offset.
+	if (!context || !ring || !ring->isReady() || !context->supportsConstantOffsets() || !ring->map(*context)) {
+		return false;
+	}
+	m_ringRanges.assign(m_packets.size(), RingRange{ 0, 0 });
+	for (size_t i = 0; i < m_packets.size(); ++i) {
+		const DrawPacket& packet = m_packets[i];
+		if (packet.constantBuffer && packet.constantData && packet.constantSize > 0 &&
+			ring->write(packet.constantData, packet.constantSize, m_ringRanges[i].first, m_ringRanges[i].count)) {
+			++m_stats.uploads;
+		}
+	}
+	ring->unmap(*context);
+	return true;
+}
+
+void
+RenderQueue::submit(DeviceContext* deviceContext, ConstantBufferRing* ring) {
+	const auto start = std::chrono::steady_clock::now();
+	DeviceContext* context = deviceContext && deviceContext->hasTarget() ? deviceContext : nullptr;
+	resetSubmitStats();
+	const bool useRing = writeRing(context, ring);
+
+	if (m_recordStates.empty()) {
+		m_recordStates.resize(1);
+	}
+	RecordState& state = m_recordStates[0];
+	state.reset();
+	record(context, useRing ? ring->raw() : nullptr, 0, m_entries.size(), state);
+	addRecordStats(state.stats);
+	m_stats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+RenderQueue::submitParallel(DeviceContext& deviceContext,
+	DeferredContextPool& contexts,
+	JobSystem& jobs,
+	const std::function<void(DeviceContext&)>& bindFrameState,
+	ConstantBufferRing* ring,
+	unsigned int workers) {
+	// Con listas emuladas por el runtime ejecutarlas cuesta lo mismo que grabar: se graba en el inmediato.
+	if (!deviceContext.m_deviceContext || !contexts.isReady() || !contexts.hasNativeCommandLists()) {
+		submit(&deviceContext, ring);
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	resetSubmitStats();
+
+	// Coste de cada entrada: los draws que emite.
+	m_costs.resize(m_entries.size());
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		const DrawPacket& packet = m_packets[m_entries[i].packet];
+		m_costs[i] = packet.instanceCount == 0 && packet.ranges ? std::max(1u, packet.rangeCount) : 1u;
+	}
+	const unsigned int parts = workers > 0 ? std::min(workers, contexts.getCount()) : contexts.getCount();
+	DeferredContextPool::partition(m_costs, parts, DeferredContextPool::kMinChunkPackets, m_chunks);
+	if (m_chunks.size() <= 1) {
+		// Un solo tramo: una lista no ahorra nada.
+		submit(&deviceContext, ring);
+		return;
+	}
+
+	// Los diferidos solo enlazan rangos del anillo: el Map se hace aquí, antes de grabar.
+	const bool useRing = contexts.getContext(0).supportsConstantOffsets() && writeRing(&deviceContext, ring);
+	ID3D11Buffer* ringBuffer = useRing ? ring->raw() : nullptr;
+	const unsigned int chunkCount = static_cast<unsigned int>(m_chunks.size());
+	if (m_recordStates.size() < chunkCount) {
+		m_recordStates.resize(chunkCount);
+	}
+
+	const auto recordStart = std::chrono::steady_clock::now();
+	jobs.parallelFor(chunkCount, 1, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int chunk = begin; chunk < end; ++chunk) {
+			DeviceContext& context = contexts.getContext(chunk);
+			RecordState& state = m_recordStates[chunk];
+			state.reset();
+			context.beginFrame();
+			bindFrameState(context);
+			record(&context, ringBuffer, m_chunks[chunk].begin, m_chunks[chunk].end, state);
+			state.result = contexts.finish(chunk);
+		}
+	});
+	m_stats.recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+
+	contexts.execute(deviceContext, chunkCount);
+	for (unsigned int chunk = 0; chunk < chunkCount; ++chunk) {
+		const RecordState& state = m_recordStates[chunk];
+		if (FAILED(state.result)) {
+			ERROR("RenderQueue", "submitParallel", "Failed to close the command list of chunk " << chunk);
+			continue;
+		}
+		++m_stats.commandLists;
+		addRecordStats(state.stats);
+		// Las listas subieron a estos buffers: lo que el inmediato recordaba de ellos ya no vale.
+		deviceContext.forgetConstantBuffers(state.updated);
+	}
+	// Las listas dejan el contexto inmediato en el estado por defecto (la UI dibuja después).
+	bindFrameState(deviceContext);
+	m_stats.submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void
+RenderQueue::record(DeviceContext* context, ID3D11Buffer* ringBuffer, size_t begin, size_t end, RecordState& state) const {
+	RenderQueueStats& stats = state.stats;
+	const void* bound[STATE_COUNT];
+	std::fill_n(bound, STATE_COUNT, static_cast<const void*>(&kUnbound));
+	unsigned int boundConstantSlot = 0;
+	auto changed = [&](StateSlot slot, const void* object) {
+		if (bound[slot] == object) {
+			++stats.bindsSkipped;
+			return false;
+		}
+		bound[slot] = object;
+		++stats.bindsIssued;
+		return true;
+	};
+
+	const float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	if (context) {
+		context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	}
+	for (size_t e = begin; e < end; ++e) {
+		const SortEntry& entry = m_entries[e];
+		const DrawPacket& packet = m_packets[entry.packet];
+		if (state.keepRecorded) {
+			state.recorded.push_back(entry.packet);
+		}
+		if (packet.vertexShader && changed(STATE_VERTEX_SHADER, packet.vertexShader) && context) {
+			context->VSSetShader(packet.vertexShader, nullptr, 0);
+		}
+		if (packet.pixelShader && changed(STATE_PIXEL_SHADER, packet.pixelShader) && context) {
+			context->PSSetShader(packet.pixelShader, nullptr, 0);
+		}
+		if (packet.inputLayout && changed(STATE_INPUT_LAYOUT, packet.inputLayout) && context) {
+			context->IASetInputLayout(packet.inputLayout);
+		}
+		if (packet.blendState && changed(STATE_BLEND, packet.blendState) && context) {
+			context->OMSetBlendState(packet.blendState, blendFactor, 0xffffffff);
+		}
+		if (packet.rasterizerState && changed(STATE_RASTERIZER, packet.rasterizerState) && context) {
+			context->RSSetState(packet.rasterizerState);
+		}
+		if (changed(STATE_DEPTH_STENCIL, packet.depthStencilState) && context) {
+			context->OMSetDepthStencilState(packet.depthStencilState, 0);
+		}
+		if (packet.sampler && changed(STATE_SAMPLER, packet.sampler) && context) {
+			context->PSSetSamplers(0, 1, &packet.sampler);
+		}
+		if (packet.texture && changed(STATE_TEXTURE, packet.texture) && context) {
+			context->PSSetShaderResources(0, 1, &packet.texture);
+		}
+		if (packet.vertexBuffer && changed(STATE_VERTEX_BUFFER, packet.vertexBuffer) && context) {
+			context->IASetVertexBuffers(0, 1, &packet.vertexBuffer, &packet.vertexStride, &packet.vertexOffset);
+		}
+		if (packet.indexBuffer && changed(STATE_INDEX_BUFFER, packet.indexBuffer) && context) {
+			context->IASetIndexBuffer(packet.indexBuffer, packet.indexFormat, 0);
+		}
+		if (packet.instanceBuffer && changed(STATE_INSTANCE_BUFFER, packet.instanceBuffer) && context) {
+			const unsigned int offset = 0;
+			context->IASetVertexBuffers(1, 1, &packet.instanceBuffer, &packet.instanceStride, &offset);
+		}
+		if (ringBuffer && m_ringRanges[entry.packet].count > 0) {
+			// Cada draw tiene su propio rango: el contexto filtra los repetidos y el siguiente buffer propio se reenlaza.
+			const RingRange& range = m_ringRanges[entry.packet];
+			bound[STATE_CONSTANT_BUFFER] = &kUnbound;
+			++stats.bindsIssued;
+			++stats.ringDraws;
+			if (context) {
+				context->VSSetConstantBuffers1(packet.constantSlot, 1, &ringBuffer, &range.first, &range.count);
+				context->PSSetConstantBuffers1(packet.constantSlot, 1, &ringBuffer, &range.first, &range.count);
+			}
+		}
+		else if (packet.constantBuffer) {
+			if (boundConstantSlot != packet.constantSlot) {
+				bound[STATE_CONSTANT_BUFFER] = &kUnbound;
+				boundConstantSlot = packet.constantSlot;
+			}
+			if (changed(STATE_CONSTANT_BUFFER, packet.constantBuffer) && context) {
+				context->VSSetConstantBuffers(packet.constantSlot, 1, &packet.constantBuffer);
+				context->PSSetConstantBuffers(packet.constantSlot, 1, &packet.constantBuffer);
+			}
+			// Varios paquetes comparten el buffer de su actor: solo se sube cuando cambia el contenido.
+			if (packet.constantData) {
+				const void*& uploaded = state.uploaded[packet.constantBuffer];
+				if (uploaded != packet.constantData) {
+					uploaded = packet.constantData;
+					++stats.uploads;
+					state.updated.push_back(packet.constantBuffer);
+					if (context && packet.constantSize > 0) {
+						context->UpdateConstantBuffer(packet.constantBuffer, packet.constantData, packet.constantSize);
+					}
+					else if (context) {
+						context->UpdateSubresource(packet.constantBuffer, 0, nullptr, packet.constantData, 0, 0);
+					}
+				}
+			}
+		}
+
+		if (packet.instanceCount > 0) {
+			// Los datos por instancia empiezan en firstInstance: todos los lotes comparten el buffer.
+			if (context) {
+				context->DrawIndexedInstanced(packet.indexCount, packet.instanceCount,
+					packet.startIndex + packet.indexOffset, packet.baseVertex, packet.firstInstance);
+			}
+			stats.instances += packet.instanceCount;
+			++stats.drawCalls;
+		}
+		else if (packet.ranges) {
+			for (unsigned int r = 0; r < packet.rangeCount; ++r) {
+				if (context) {
+					context->DrawIndexed(packet.ranges[r].indexCount, packet.startIndex + packet.ranges[r].indexOffset,
+						packet.baseVertex);
+				}
+			}
+			stats.drawCalls += packet.rangeCount;
+		}
+		else {
+			if (context) {
+				context->DrawIndexed(packet.indexCount, packet.startIndex + packet.indexOffset, packet.baseVertex);
+			}
+			++stats.drawCalls;
+		}
+	}
+}
+
+RenderQueueBenchmark
+RenderQueue::benchmark(unsigned int draws, JobSystem* jobs) {
+	RenderQueueBenchmark result;
+	result.draws = draws;
+	result.threads = jobs ? jobs->getThreadCount() + 1 : 1;
+
+	SyntheticScene scene;
+	buildSyntheticScene(draws, scene);
+	RenderQueue queue;
+	auto fill = [&]() {
+		queue.begin();
+		for (unsigned int i = 0; i < draws; ++i) {
+			queue.push(scene.packets[i], scene.passes[i], scene.depths[i]);
+		}
+	};
+
+	fill();
+	queue.submit(nullptr);
+	result.naiveBinds = queue.m_stats.bindsIssued + queue.m_stats.bindsSkipped;
+	result.unsortedBinds = queue.m_stats.bindsIssued;
+
+	std::vector<SortEntry> expected = queue.m_entries;
+	std::stable_sort(expected.begin(), expected.end(),
+		[](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+	auto matches = [&]() {
+		for (size_t i = 0; i < expected.size(); ++i) {
+			if (queue.m_entries[i].packet != expected[i].packet) {
+				return false;
+			}
+		}
+		return queue.m_entries.size() == expected.size();
+	};
+
+	queue.sort(nullptr);
+	result.serialSortMs = queue.m_stats.sortMs;
+	result.sortedCorrectly = matches();
+
+	fill();
+	queue.sort(jobs);
+	result.parallelSortMs = queue.m_stats.sortMs;
+	result.sortedCorrectly = result.sortedCorrectly && matches();
+
+	queue.submit(nullptr);
+	result.sortedBinds = queue.m_stats.bindsIssued;
+	result.submitMs = queue.m_stats.submitMs;
+	return result;
+}
+
+ParallelSubmitBenchmark
+RenderQueue::benchmarkParallel(unsigned int draws, JobSystem* jobs) {
+	ParallelSubmitBenchmark result;
+	result.draws = draws;
+	result.threads = jobs ? jobs->getThreadCount() + 1 : 1;
+
+	SyntheticScene scene;
+	buildSyntheticScene(draws, scene);
+	RenderQueue queue;
+	queue.begin();
+	for (unsigned int i = 0; i < draws; ++i) {
+		queue.push(scene.packets[i], scene.passes[i], scene.depths[i]);
+	}
+	queue.sort(jobs);
+	const size_t count = queue.m_entries.size();
+
+	// Referencia: toda la cola en un hilo.
+	RecordState serial;
+	auto start = std::chrono::steady_clock::now();
+	queue.record(nullptr, nullptr, 0, count, serial);
+	result.serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.serialBinds = serial.stats.bindsIssued;
+	RecordState expected;
+	expected.keepRecorded = true;
+	queue.record(nullptr, nullptr, 0, count, expected);
+
+	queue.m_costs.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		const DrawPacket& packet = queue.m_packets[queue.m_entries[i].packet];
+		queue.m_costs[i] = packet.instanceCount == 0 && packet.ranges ? std::max(1u, packet.rangeCount) : 1u;
+	}
+
+	result.mergeOrderCorrect = true;
+	std::vector<RecordState> states;
+	for (unsigned int parts = 1; parts <= DeferredContextPool::kMaxContexts; ++parts) {
+		DeferredContextPool::partition(queue.m_costs, parts, DeferredContextPool::kMinChunkPackets, queue.m_chunks);
+		const unsigned int chunkCount = static_cast<unsigned int>(queue.m_chunks.size());
+		states.resize(chunkCount);
+		auto recordChunks = [&](unsigned int begin, unsigned int end) {
+			for (unsigned int chunk = begin; chunk < end; ++chunk) {
+				states[chunk].reset();
+				queue.record(nullptr, nullptr, queue.m_chunks[chunk].begin, queue.m_chunks[chunk].end, states[chunk]);
+			}
+		};
+		for (RecordState& state : states) {
+			state.keepRecorded = false;
+		}
+		start = std::chrono::steady_clock::now();
+		if (jobs) {
+			jobs->parallelFor(chunkCount, 1, recordChunks);
+		}
+		else {
+			recordChunks(0, chunkCount);
+		}
+		result.recordMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		unsigned int binds = 0;
+		for (const RecordState& state : states) {
+			binds += state.stats.bindsIssued;
+		}
+		result.binds.push_back(binds);
+
+		// Las listas se ejecutan en el orden de los tramos: concatenadas deben dar los draws de un hilo.
+		for (RecordState& state : states) {
+			state.keepRecorded = true;
+		}
+		recordChunks(0, chunkCount);
+		std::vector<unsigned int> merged;
+		unsigned int drawCalls = 0;
+		for (const RecordState& state : states) {
+			merged.insert(merged.end(), state.recorded.begin(), state.recorded.end());
+			drawCalls += state.stats.drawCalls;
+		}
+		result.mergeOrderCorrect = result.mergeOrderCorrect && merged == expected.recorded &&
+			drawCalls == expected.stats.drawCalls;
+	}
+	return result;
+}
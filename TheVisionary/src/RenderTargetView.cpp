@@ -110,10 +110,10 @@ RenderTargetView::render(DeviceContext& deviceContext,
     ID3D11DepthStencilView* dsv = depthStencilView.m_depthStencilView;
 
     // Liga RTV/DSV y limpia
-    deviceContext.m_deviceContext->OMSetRenderTargets(numViews, &rtv, dsv);
-    deviceContext.m_deviceContext->ClearRenderTargetView(rtv, ClearColor);
+    deviceContext.OMSetRenderTargets(numViews, &rtv, dsv);
+    deviceContext.ClearRenderTargetView(rtv, ClearColor);
     if (dsv) {
-        deviceContext.m_deviceContext->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+        deviceContext.ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
     }
 }
 
@@ -128,7 +128,23 @@ RenderTargetView::render(DeviceContext& deviceContext, unsigned int numViews) {
         return;
     }
     ID3D11RenderTargetView* rtv = m_renderTargetView;
-    deviceContext.m_deviceContext->OMSetRenderTargets(numViews, &rtv, nullptr);
+    deviceContext.OMSetRenderTargets(numViews, &rtv, nullptr);
+}
+
+void
+RenderTargetView::render(DeviceContext& deviceContext,
+    DepthStencilView& depthStencilView,
+    unsigned int numViews) {
+    if (!deviceContext.m_deviceContext) {
+        ERROR("RenderTargetView", "render", "DeviceContext is nullptr.");
+        return;
+    }
+    if (!m_renderTargetView) {
+        ERROR("RenderTargetView", "render", "RenderTargetView is nullptr.");
+        return;
+    }
+    ID3D11RenderTargetView* rtv = m_renderTargetView;
+    deviceContext.OMSetRenderTargets(numViews, &rtv, depthStencilView.m_depthStencilView);
 }
 
 void
@@ -0,0 +1,381 @@
+﻿/**
+ * @file ShaderCache.cpp
+ * @brief Clave de los shaders (con sus #include) y archivo indexado de bytecode.
+ */
+
+#include "ShaderCache.h"
+#include "Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+	const uint32_t kShaderCacheMagic = 0x43485356; // 'VSHC'
+	const uint32_t kShaderCacheVersion = 1;
+
+	/// Entrada del índice del archivo (offset relativo al inicio de los blobs).
+	struct ShaderCacheIndexEntry {
+		uint64_t key;
+		uint32_t offset;
+		uint32_t size;
+		uint32_t lastGeneration;
+		uint32_t reserved;
+	};
+
+
+	/// Nombres de las directivas #include "x" y #include <x> de un código.
+	void
+	parseIncludes(const std::string& source, std::vector<std::string>& names) {
+		size_t line = 0;
+		while (line < source.size()) {
+			size_t end = source.find('\n', line);
+			if (end == std::string::npos) {
+				end = source.size();
+			}
+			size_t i = source.find_first_not_of(" \t", line);
+			if (i < end && source[i] == '#') {
+				i = source.find_first_not_of(" \t", i + 1);
+				if (i < end && source.compare(i, 7, "include") == 0) {
+					i = source.find_first_not_of(" \t", i + 7);
+					if (i < end && (source[i] == '"' || source[i] == '<')) {
+						const size_t close = source.find(source[i] == '"' ? '"' : '>', i + 1);
+						if (close < end) {
+							names.push_back(source.substr(i + 1, close - i - 1));
+						}
+					}
+				}
+			}
+			line = end + 1;
+		}
+	}
+
+
+	/// Encadena al hash el nombre y el contenido de los #include de un código (recursivo).
+	uint64_t
+	hashIncludes(const std::string& source,
+		const std::string& dir,
+		const std::string& rootDir,
+		std::set<std::string>& visited,
+		uint64_t hash) {
+		std::vector<std::string> names;
+		parseIncludes(source, names);
+		for (const std::string& name : names) {
+			hash = hashString(name, hash);
+			const std::string path = ShaderCache::resolveInclude(name, dir, rootDir);
+			// Un include que falta también cuenta: si aparece después cambia la clave.
+			if (path.empty() || !visited.insert(path).second) {
+				hash = hashCombine(hash, path.empty() ? 0 : 1);
+				continue;
+			}
+			const std::string contents = ShaderCache::readFile(path);
+			hash = hashString(contents, hashCombine(hash, contents.size()));
+			hash = hashIncludes(contents, ShaderCache::directoryOf(path), rootDir, visited, hash);
+		}
+		return hash;
+	}
+}
+
+std::string
+ShaderCache::resolveInclude(const std::string& name, const std::string& parentDir, const std::string& rootDir) {
+	for (const std::string& dir : { parentDir, rootDir }) {
+		const std::string path = dir + name;
+		if (std::ifstream(path, std::ios::binary)) {
+			return path;
+		}
+	}
+	return std::string();
+}
+
+std::string
+ShaderCache::directoryOf(const std::string& path) {
+	const size_t slash = path.find_last_of("\\/");
+	return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+std::string
+ShaderCache::readFile(const std::string& fileName) {
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file) {
+		return std::string();
+	}
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+bool
+ShaderCache::load(const std::string& path) {
+	const auto start = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_path = path;
+	m_data.clear();
+	m_entries.clear();
+	m_generation = 1;
+	m_dirty = false;
+	m_stats.warm = false;
+	m_stats.invalid = false;
+	m_stats.fileBytes = 0;
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		m_stats.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return false;
+	}
+
+	// Lectura en un solo bloque; los blobs se sirven desde él.
+	std::vector<char> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+	uint32_t header[4] = {};
+	bool valid = file && data.size() >= sizeof(header);
+	if (valid) {
+		std::memcpy(header, data.data(), sizeof(header));
+		valid = header[0] == kShaderCacheMagic && header[1] == kShaderCacheVersion &&
+			(data.size() - sizeof(header)) / sizeof(ShaderCacheIndexEntry) >= header[2];
+	}
+	const size_t blobStart = sizeof(header) + size_t(header[2]) * sizeof(ShaderCacheIndexEntry);
+	for (uint32_t i = 0; valid && i < header[2]; ++i) {
+		ShaderCacheIndexEntry index;
+		std::memcpy(&index, data.data() + sizeof(header) + i * sizeof(index), sizeof(index));
+		valid = uint64_t(index.offset) + index.size <= data.size() - blobStart;
+		m_entries[index.key] = Entry{ blobStart + index.offset, index.size, index.lastGeneration };
+	}
+	if (!valid) {
+		// Un archivo cortado o de otra versión se reescribe entero; quien la carga lo avisa.
+		m_entries.clear();
+		m_dirty = true;
+		m_stats.invalid = true;
+	}
+	else {
+		m_data = std::move(data);
+		m_generation = header[3] + 1;
+		m_stats.warm = true;
+		m_stats.fileBytes = m_data.size();
+	}
+	m_stats.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return valid;
+}
+
+bool
+ShaderCache::save() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_path.empty()) {
+		return false;
+	}
+
+	std::vector<std::pair<uint64_t, Entry>> kept;
+	unsigned int dropped = 0;
+	for (const auto& item : m_entries) {
+		if (m_generation - item.second.lastGeneration > kStaleGenerations) {
+			++dropped;
+			continue;
+		}
+		kept.push_back(item);
+	}
+	if (!m_dirty && dropped == 0) {
+		return true;
+	}
+	std::sort(kept.begin(), kept.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	// Cabecera, índice y blobs en un solo bloque, que pasa a ser el contenido en memoria.
+	const uint32_t header[4] = { kShaderCacheMagic, kShaderCacheVersion, static_cast<uint32_t>(kept.size()), m_generation };
+	const size_t blobStart = sizeof(header) + kept.size() * sizeof(ShaderCacheIndexEntry);
+	std::vector<char> data(blobStart);
+	std::memcpy(data.data(), header, sizeof(header));
+	std::unordered_map<uint64_t, Entry> entries;
+	for (size_t i = 0; i < kept.size(); ++i) {
+		const Entry& entry = kept[i].second;
+		const ShaderCacheIndexEntry index = { kept[i].first, static_cast<uint32_t>(data.size() - blobStart),
+			entry.size, entry.lastGeneration, 0 };
+		std::memcpy(data.data() + sizeof(header) + i * sizeof(index), &index, sizeof(index));
+		entries[index.key] = Entry{ data.size(), entry.size, entry.lastGeneration };
+		data.insert(data.end(), m_data.begin() + entry.offset, m_data.begin() + entry.offset + entry.size);
+	}
+	m_data = std::move(data);
+	m_entries = std::move(entries);
+	m_stats.dropped = dropped;
+
+	// Se escribe al lado y se renombra: un cierre a medias no deja un archivo cortado.
+	std::error_code error;
+	const fs::path target(m_path);
+	if (target.has_parent_path()) {
+		fs::create_directories(target.parent_path(), error);
+	}
+	const std::string temporary = m_path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+		if (!file) {
+			return false;
+		}
+	}
+	fs::rename(temporary, target, error);
+	if (error) {
+		fs::remove(temporary, error);
+		return false;
+	}
+	m_dirty = false;
+	m_stats.fileBytes = m_data.size();
+	return true;
+}
+
+bool
+ShaderCache::getBytecode(const ShaderCompileRequest& request,
+	std::vector<char>& bytecode,
+	std::string& errors) {
+	if (!m_compiler) {
+		errors = "Shader cache has no compiler";
+		return false;
+	}
+	const auto start = std::chrono::steady_clock::now();
+
+	ShaderCompileRequest loaded;
+	const ShaderCompileRequest* source = &request;
+	if (request.source.empty()) {
+		loaded = request;
+		loaded.source = readFile(request.fileName);
+		if (loaded.source.empty()) {
+			errors = "Cannot read " + request.fileName;
+			return false;
+		}
+		source = &loaded;
+	}
+	const uint64_t key = computeKey(*source, m_compiler->getId());
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_entries.find(key);
+		if (it != m_entries.end()) {
+			Entry& entry = it->second;
+			bytecode.assign(m_data.begin() + entry.offset, m_data.begin() + entry.offset + entry.size);
+			// Refrescarla a media vida basta para que no caduque sin reescribir el archivo en cada arranque.
+			if (m_generation - entry.lastGeneration >= kStaleGenerations / 2) {
+				entry.lastGeneration = m_generation;
+				m_dirty = true;
+			}
+			++m_stats.hits;
+			m_stats.lookupMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			return true;
+		}
+	}
+
+	// Se compila sin el candado: otro hilo puede servir aciertos mientras tanto.
+	const bool compiled = m_compiler->compile(*source, bytecode, errors);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.compileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (!compiled) {
+		++m_stats.failures;
+		return false;
+	}
+	++m_stats.misses;
+	if (!m_entries.count(key) && bytecode.size() <= UINT32_MAX) {
+		m_entries[key] = Entry{ m_data.size(), static_cast<uint32_t>(bytecode.size()), m_generation };
+		m_data.insert(m_data.end(), bytecode.begin(), bytecode.end());
+		m_dirty = true;
+	}
+	return true;
+}
+
+void
+ShaderCache::clear() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_data.clear();
+	m_entries.clear();
+	m_dirty = false;
+	m_stats.warm = false;
+	m_stats.fileBytes = 0;
+	if (!m_path.empty()) {
+		std::error_code error;
+		fs::remove(m_path, error);
+	}
+}
+
+ShaderCacheStats
+ShaderCache::getStats() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	ShaderCacheStats stats = m_stats;
+	stats.entries = static_cast<unsigned int>(m_entries.size());
+	return stats;
+}
+
+void
+ShaderCache::resetStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.hits = 0;
+	m_stats.misses = 0;
+	m_stats.failures = 0;
+	m_stats.lookupMs = 0.0;
+	m_stats.compileMs = 0.0;
+}
+
+uint64_t
+ShaderCache::computeKey(const ShaderCompileRequest& request, const std::string& compilerId) {
+	// La longitud delante de cada campo evita que dos divisiones distintas den el mismo flujo de bytes.
+	uint64_t hash = kHashSeed;
+	auto add = [&hash](const std::string& text) {
+		hash = hashString(text, hashCombine(hash, text.size()));
+	};
+	add(compilerId);
+	add(request.fileName);
+	add(request.entryPoint);
+	add(request.profile);
+	hash = hashCombine(hash, request.defines.size());
+	for (const ShaderDefine& define : request.defines) {
+		add(define.name);
+		add(define.value);
+	}
+	add(request.source);
+
+	const std::string rootDir = directoryOf(request.fileName);
+	std::set<std::string> visited;
+	return hashIncludes(request.source, rootDir, rootDir, visited, hash);
+}
+
+ShaderCacheBenchmark
+ShaderCache::benchmark(const std::vector<ShaderCompileRequest>& requests,
+	std::shared_ptr<ShaderCompiler> compiler,
+	const std::string& path) {
+	ShaderCacheBenchmark result;
+	result.shaders = static_cast<unsigned int>(requests.size());
+	std::vector<std::vector<char>> compiled(requests.size());
+	std::string errors;
+	std::error_code error;
+	fs::remove(path, error);
+
+	// En frío: sin archivo, todo se compila y se escribe.
+	auto start = std::chrono::steady_clock::now();
+	{
+		ShaderCache cold(compiler);
+		cold.load(path);
+		for (size_t i = 0; i < requests.size(); ++i) {
+			cold.getBytecode(requests[i], compiled[i], errors);
+		}
+		cold.save();
+		result.fileBytes = cold.getStats().fileBytes;
+	}
+	result.coldMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// En caliente: una lectura del archivo y cada shader copiado desde ella.
+	start = std::chrono::steady_clock::now();
+	ShaderCache warm(compiler);
+	warm.load(path);
+	result.identical = true;
+	std::vector<char> bytecode;
+	for (size_t i = 0; i < requests.size(); ++i) {
+		warm.getBytecode(requests[i], bytecode, errors);
+		result.identical = result.identical && !bytecode.empty() && bytecode == compiled[i];
+	}
+	result.warmMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.warmHits = warm.getStats().hits;
+
+	fs::remove(path, error);
+	return result;
+}
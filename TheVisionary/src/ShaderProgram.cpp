@@ -6,6 +6,7 @@
 #include "ShaderProgram.h"
 #include "Device.h"
 #include "DeviceContext.h"
+#include "ShaderCache.h"
 
 HRESULT
 ShaderProgram::init(Device& device,
@@ -49,6 +50,20 @@ ShaderProgram::init(Device& device,
 	return hr;
 }
 
+HRESULT
+ShaderProgram::initFromSource(Device& device,
+	const std::string& name,
+	const std::string& source,
+	std::vector<D3D11_INPUT_ELEMENT_DESC> Layout) {
+	if (source.empty()) {
+		ERROR("ShaderProgram", "initFromSource", "Shader source is empty.");
+		return E_INVALIDARG;
+	}
+	// init() compila desde m_shaderSource en lugar de abrir el archivo.
+	m_shaderSource = source;
+	return init(device, name, Layout);
+}
+
 HRESULT
 ShaderProgram::CreateInputLayout(Device& device,
 	std::vector<D3D11_INPUT_ELEMENT_DESC> Layout) {
@@ -65,8 +80,8 @@ ShaderProgram::CreateInputLayout(Device& device,
 		return E_INVALIDARG;
 	}
 
+	// El bytecode se conserva hasta destroy(): las variantes de formato se crean despus.
 	HRESULT hr = m_inputLayout.init(device, Layout, m_vertexShaderData);
-	SAFE_RELEASE(m_vertexShaderData);
 
 	if (FAILED(hr)) {
 		ERROR("ShaderProgram", "CreateInputLayout", "Failed to create input layout.");
@@ -77,6 +92,52 @@ ShaderProgram::CreateInputLayout(Device& device,
 	return hr;
 }
 
+HRESULT
+ShaderProgram::CreateInputLayout(Device& device, const VertexLayout& layout) {
+	if (!layout.isCompact() || m_layoutVariants.count(layout.getKey())) {
+		return S_OK;
+	}
+	if (!m_vertexShaderData) {
+		ERROR("ShaderProgram", "CreateInputLayout", "Vertex shader data is null.");
+		return E_POINTER;
+	}
+
+	std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+	layout.getInputElements(elements);
+	elements.insert(elements.end(), m_instanceElements.begin(), m_instanceElements.end());
+	InputLayout variant;
+	HRESULT hr = variant.init(device, elements, m_vertexShaderData);
+	if (FAILED(hr)) {
+		ERROR("ShaderProgram", "CreateInputLayout", "Failed to create compact input layout.");
+		return hr;
+	}
+	m_layoutVariants[layout.getKey()] = variant;
+	return S_OK;
+}
+
+void
+ShaderProgram::renderInputLayout(DeviceContext& deviceContext, const VertexLayout& layout) {
+	if (!layout.isCompact()) {
+		m_inputLayout.render(deviceContext);
+		return;
+	}
+	auto it = m_layoutVariants.find(layout.getKey());
+	if (it == m_layoutVariants.end()) {
+		ERROR("ShaderProgram", "renderInputLayout", "Input layout variant was not created.");
+		return;
+	}
+	it->second.render(deviceContext);
+}
+
+ID3D11InputLayout*
+ShaderProgram::getInputLayout(const VertexLayout& layout) const {
+	if (!layout.isCompact()) {
+		return m_inputLayout.m_inputLayout;
+	}
+	auto it = m_layoutVariants.find(layout.getKey());
+	return it != m_layoutVariants.end() ? it->second.m_inputLayout : nullptr;
+}
+
 HRESULT
 ShaderProgram::CreateShader(Device& device, ShaderType type) {
 	if (!device.m_device) {
@@ -94,11 +155,60 @@ ShaderProgram::CreateShader(Device& device, ShaderType type) {
 	const char* shaderEntryPoint = (type == ShaderType::PIXEL_SHADER) ? "PS" : "VS";
 	const char* shaderModel = (type == ShaderType::PIXEL_SHADER) ? "ps_4_0" : "vs_4_0";
 
-	// Compile the shader from file
-	hr = CompileShaderFromFile(m_shaderFileName.data(),
-		shaderEntryPoint,
-		shaderModel,
-		&shaderData);
+	// Mismo cdigo, punto de entrada y perfil: se comparten el shader y su bytecode sin compilar.
+	const std::string source = m_shaderSource.empty() ? ShaderCache::readFile(m_shaderFileName) : m_shaderSource;
+	const std::string cacheKey = source.empty() ? std::string() : ObjectCache::shaderKey(source, shaderEntryPoint, shaderModel);
+	const CachedObjectType cacheType = type == PIXEL_SHADER ? CACHED_PIXEL_SHADER : CACHED_VERTEX_SHADER;
+	if (!cacheKey.empty()) {
+		ID3DBlob* cachedData = nullptr;
+		if (IUnknown* cached = device.m_cache->find(cacheType, cacheKey.data(), cacheKey.size(), &cachedData)) {
+			if (type == PIXEL_SHADER) {
+				SAFE_RELEASE(m_PixelShader);
+				m_PixelShader = static_cast<ID3D11PixelShader*>(cached);
+				SAFE_RELEASE(m_pixelShaderData);
+				m_pixelShaderData = cachedData;
+			}
+			else {
+				SAFE_RELEASE(m_VertexShader);
+				m_VertexShader = static_cast<ID3D11VertexShader*>(cached);
+				SAFE_RELEASE(m_vertexShaderData);
+				m_vertexShaderData = cachedData;
+			}
+			return S_OK;
+		}
+	}
+
+	// Bytecode de la cach en disco (compila y guarda si no est); sin ella se compila como antes.
+	if (device.m_shaderCache && !source.empty()) {
+		ShaderCompileRequest request;
+		request.fileName = m_shaderFileName;
+		request.source = source;
+		request.entryPoint = shaderEntryPoint;
+		request.profile = shaderModel;
+		std::vector<char> bytecode;
+		std::string errors;
+		if (!device.m_shaderCache->getBytecode(request, bytecode, errors)) {
+			ERROR("ShaderProgram", "CreateShader",
+				"Failed to compile shader " << m_shaderFileName.c_str() << ": " << errors.c_str());
+			hr = E_FAIL;
+		}
+		else {
+			hr = D3DCreateBlob(bytecode.size(), &shaderData);
+			if (SUCCEEDED(hr)) {
+				memcpy(shaderData->GetBufferPointer(), bytecode.data(), bytecode.size());
+			}
+		}
+	}
+	// Compile the shader from file (or from the program's HLSL source)
+	else if (m_shaderSource.empty()) {
+		hr = CompileShaderFromFile(m_shaderFileName.data(),
+			shaderEntryPoint,
+			shaderModel,
+			&shaderData);
+	}
+	else {
+		hr = CompileShaderFromSource(shaderEntryPoint, shaderModel, &shaderData);
+	}
 
 	if (FAILED(hr)) {
 		ERROR("ShaderProgram", "CreateShader",
@@ -127,6 +237,22 @@ ShaderProgram::CreateShader(Device& device, ShaderType type) {
 		return hr;
 	}
 
+	if (!cacheKey.empty()) {
+		// Si otro hilo guard antes el mismo shader se usan el suyo y su bytecode, y se sueltan los nuestros.
+		IUnknown* shader = type == PIXEL_SHADER ? static_cast<IUnknown*>(m_PixelShader) : static_cast<IUnknown*>(m_VertexShader);
+		ID3DBlob* sharedData = nullptr;
+		IUnknown* shared = device.m_cache->insert(cacheType, cacheKey.data(), cacheKey.size(), shader, shaderData, &sharedData);
+		shader->Release();
+		shaderData->Release();
+		shaderData = sharedData;
+		if (type == PIXEL_SHADER) {
+			m_PixelShader = static_cast<ID3D11PixelShader*>(shared);
+		}
+		else {
+			m_VertexShader = static_cast<ID3D11VertexShader*>(shared);
+		}
+	}
+
 	// Store the compiled shader data
 	if (type == PIXEL_SHADER) {
 		SAFE_RELEASE(m_pixelShaderData);
@@ -151,6 +277,7 @@ ShaderProgram::CreateShader(Device& device, ShaderType type, const std::string&
 		return E_INVALIDARG;
 	}
 	m_shaderFileName = fileName;
+	m_shaderSource.clear();
 	CreateShader(device, type);
 
 
@@ -206,6 +333,47 @@ ShaderProgram::CompileShaderFromFile(char* szFileName,
 		return S_OK;
 }
 
+HRESULT
+ShaderProgram::CompileShaderFromSource(LPCSTR szEntryPoint,
+	LPCSTR szShaderModel,
+	ID3DBlob** ppBlobOut) {
+	DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined( DEBUG ) || defined( _DEBUG )
+	dwShaderFlags |= D3DCOMPILE_DEBUG;
+#endif
+	ID3DBlob* pErrorBlob = nullptr;
+	HRESULT hr = D3DX11CompileFromMemory(m_shaderSource.data(),
+		m_shaderSource.size(),
+		m_shaderFileName.c_str(),
+		nullptr,
+		nullptr,
+		szEntryPoint,
+		szShaderModel,
+		dwShaderFlags,
+		0,
+		nullptr,
+		ppBlobOut,
+		&pErrorBlob,
+		nullptr);
+
+	if (FAILED(hr)) {
+		if (pErrorBlob) {
+			ERROR("ShaderProgram", "CompileShaderFromSource",
+				"Failed to compile shader source " << m_shaderFileName.c_str() << ": "
+				<< static_cast<const char*>(pErrorBlob->GetBufferPointer()));
+			pErrorBlob->Release();
+		}
+		else {
+			ERROR("ShaderProgram", "CompileShaderFromSource",
+				"Failed to compile shader source " << m_shaderFileName.c_str());
+		}
+		return hr;
+	}
+
+	SAFE_RELEASE(pErrorBlob);
+	return S_OK;
+}
+
 void
 ShaderProgram::update() {
 }
@@ -218,8 +386,8 @@ ShaderProgram::render(DeviceContext& deviceContext) {
 	}
 
 	m_inputLayout.render(deviceContext);
-	deviceContext.m_deviceContext->VSSetShader(m_VertexShader, nullptr, 0);
-	deviceContext.m_deviceContext->PSSetShader(m_PixelShader, nullptr, 0);
+	deviceContext.VSSetShader(m_VertexShader, nullptr, 0);
+	deviceContext.PSSetShader(m_PixelShader, nullptr, 0);
 }
 
 void
@@ -230,10 +398,10 @@ ShaderProgram::render(DeviceContext& deviceContext, ShaderType type) {
 	}
 	switch (type) {
 	case VERTEX_SHADER:
-		deviceContext.m_deviceContext->VSSetShader(m_VertexShader, nullptr, 0);
+		deviceContext.VSSetShader(m_VertexShader, nullptr, 0);
 		break;
 	case PIXEL_SHADER:
-		deviceContext.m_deviceContext->PSSetShader(m_PixelShader, nullptr, 0);
+		deviceContext.PSSetShader(m_PixelShader, nullptr, 0);
 		break;
 	default:
 		break;
@@ -244,6 +412,10 @@ void
 ShaderProgram::destroy() {
 	SAFE_RELEASE(m_VertexShader);
 	m_inputLayout.destroy();
+	for (auto& variant : m_layoutVariants) {
+		variant.second.destroy();
+	}
+	m_layoutVariants.clear();
 	SAFE_RELEASE(m_PixelShader);
 	SAFE_RELEASE(m_vertexShaderData);
 	SAFE_RELEASE(m_pixelShaderData);
@@ -0,0 +1,256 @@
+﻿/**
+ * @file StateCache.cpp
+ * @brief Comparación del estado pedido con el enlazado y contadores por tipo de llamada.
+ */
+
+#include "StateCache.h"
+#include <cstring>
+
+unsigned int
+StateCacheStats::getIssued() const {
+	unsigned int total = 0;
+	for (unsigned int count : issued) {
+		total += count;
+	}
+	return total;
+}
+
+unsigned int
+StateCacheStats::getSkipped() const {
+	unsigned int total = 0;
+	for (unsigned int count : skipped) {
+		total += count;
+	}
+	return total;
+}
+
+const char*
+StateCacheStats::getCallName(StateCall call) {
+	switch (call) {
+	case STATE_CALL_VS_SHADER: return "VSSetShader";
+	case STATE_CALL_PS_SHADER: return "PSSetShader";
+	case STATE_CALL_INPUT_LAYOUT: return "IASetInputLayout";
+	case STATE_CALL_TOPOLOGY: return "IASetPrimitiveTopology";
+	case STATE_CALL_VERTEX_BUFFERS: return "IASetVertexBuffers";
+	case STATE_CALL_INDEX_BUFFER: return "IASetIndexBuffer";
+	case STATE_CALL_VS_CONSTANT_BUFFERS: return "VSSetConstantBuffers";
+	case STATE_CALL_PS_CONSTANT_BUFFERS: return "PSSetConstantBuffers";
+	case STATE_CALL_PS_SHADER_RESOURCES: return "PSSetShaderResources";
+	case STATE_CALL_PS_SAMPLERS: return "PSSetSamplers";
+	case STATE_CALL_RASTERIZER: return "RSSetState";
+	case STATE_CALL_BLEND: return "OMSetBlendState";
+	case STATE_CALL_DEPTH_STENCIL: return "OMSetDepthStencilState";
+	default: return "Unknown";
+	}
+}
+
+void
+StateCache::invalidate() {
+	m_vertexShader.valid = false;
+	m_pixelShader.valid = false;
+	m_inputLayout.valid = false;
+	m_topology.valid = false;
+	m_vertexBuffersValid = 0;
+	m_indexBuffer.valid = false;
+	m_vsConstantBuffers.valid = 0;
+	m_psConstantBuffers.valid = 0;
+	m_shaderResources.valid = 0;
+	m_samplers.valid = 0;
+	m_rasterizer.valid = false;
+	m_blendState.valid = false;
+	m_depthStencil.valid = false;
+}
+
+void
+StateCache::beginFrame() {
+	m_lastFrame = m_current;
+	m_current = StateCacheStats();
+	invalidate();
+}
+
+bool
+StateCache::record(StateCall call, bool redundant) {
+	if (redundant) {
+		++m_current.skipped[call];
+		return false;
+	}
+	++m_current.issued[call];
+	return true;
+}
+
+template<typename T>
+bool
+StateCache::setSingle(StateCall call, Single<T>& state, const T& value) {
+	const bool redundant = state.valid && state.value == value;
+	state.value = value;
+	state.valid = true;
+	return record(call, redundant);
+}
+
+template<typename T>
+bool
+StateCache::setSlots(StateCall call, SlotArray<T>& slots, unsigned int startSlot, unsigned int count, T* const* values) {
+	if (startSlot + count > kTrackedSlots) {
+		// Fuera de lo que se sigue: se envía y se olvidan los slots tocados.
+		for (unsigned int slot = startSlot; slot < kTrackedSlots; ++slot) {
+			slots.valid &= ~(1u << slot);
+		}
+		return record(call, false);
+	}
+	bool redundant = true;
+	for (unsigned int i = 0; i < count; ++i) {
+		const unsigned int slot = startSlot + i;
+		if (!(slots.valid & (1u << slot)) || slots.objects[slot] != values[i]) {
+			redundant = false;
+		}
+		slots.objects[slot] = values[i];
+		slots.valid |= 1u << slot;
+	}
+	return record(call, redundant);
+}
+
+bool
+StateCache::setVertexShader(ID3D11VertexShader* shader) {
+	return setSingle(STATE_CALL_VS_SHADER, m_vertexShader, shader);
+}
+
+bool
+StateCache::setPixelShader(ID3D11PixelShader* shader) {
+	return setSingle(STATE_CALL_PS_SHADER, m_pixelShader, shader);
+}
+
+bool
+StateCache::setInputLayout(ID3D11InputLayout* layout) {
+	return setSingle(STATE_CALL_INPUT_LAYOUT, m_inputLayout, layout);
+}
+
+bool
+StateCache::setTopology(unsigned int topology) {
+	return setSingle(STATE_CALL_TOPOLOGY, m_topology, topology);
+}
+
+bool
+StateCache::setVertexBuffers(unsigned int startSlot,
+	unsigned int count,
+	ID3D11Buffer* const* buffers,
+	const unsigned int* strides,
+	const unsigned int* offsets) {
+	if (startSlot + count > kTrackedSlots) {
+		for (unsigned int slot = startSlot; slot < kTrackedSlots; ++slot) {
+			m_vertexBuffersValid &= ~(1u << slot);
+		}
+		return record(STATE_CALL_VERTEX_BUFFERS, false);
+	}
+	bool redundant = true;
+	for (unsigned int i = 0; i < count; ++i) {
+		const unsigned int slot = startSlot + i;
+		VertexBinding binding;
+		binding.buffer = buffers[i];
+		binding.stride = strides[i];
+		binding.offset = offsets[i];
+		if (!(m_vertexBuffersValid & (1u << slot)) || !(m_vertexBuffers[slot] == binding)) {
+			redundant = false;
+		}
+		m_vertexBuffers[slot] = binding;
+		m_vertexBuffersValid |= 1u << slot;
+	}
+	return record(STATE_CALL_VERTEX_BUFFERS, redundant);
+}
+
+bool
+StateCache::setIndexBuffer(ID3D11Buffer* buffer, unsigned int format, unsigned int offset) {
+	VertexBinding binding;
+	binding.buffer = buffer;
+	binding.stride = format;
+	binding.offset = offset;
+	return setSingle(STATE_CALL_INDEX_BUFFER, m_indexBuffer, binding);
+}
+
+bool
+StateCache::setConstantBuffers(StateCall call,
+	ConstantSlots& slots,
+	unsigned int startSlot,
+	unsigned int count,
+	ID3D11Buffer* const* buffers,
+	const unsigned int* firstConstants,
+	const unsigned int* numConstants) {
+	if (startSlot + count > kTrackedSlots) {
+		for (unsigned int slot = startSlot; slot < kTrackedSlots; ++slot) {
+			slots.valid &= ~(1u << slot);
+		}
+		return record(call, false);
+	}
+	bool redundant = true;
+	for (unsigned int i = 0; i < count; ++i) {
+		const unsigned int slot = startSlot + i;
+		// El mismo buffer con otro rango (anillo de constantes) es otro enlace.
+		ConstantBinding binding;
+		binding.buffer = buffers[i];
+		binding.first = firstConstants ? firstConstants[i] : 0;
+		binding.count = numConstants ? numConstants[i] : 0;
+		if (!(slots.valid & (1u << slot)) || !(slots.bindings[slot] == binding)) {
+			redundant = false;
+		}
+		slots.bindings[slot] = binding;
+		slots.valid |= 1u << slot;
+	}
+	return record(call, redundant);
+}
+
+bool
+StateCache::setVSConstantBuffers(unsigned int startSlot,
+	unsigned int count,
+	ID3D11Buffer* const* buffers,
+	const unsigned int* firstConstants,
+	const unsigned int* numConstants) {
+	return setConstantBuffers(STATE_CALL_VS_CONSTANT_BUFFERS, m_vsConstantBuffers, startSlot, count, buffers,
+		firstConstants, numConstants);
+}
+
+bool
+StateCache::setPSConstantBuffers(unsigned int startSlot,
+	unsigned int count,
+	ID3D11Buffer* const* buffers,
+	const unsigned int* firstConstants,
+	const unsigned int* numConstants) {
+	return setConstantBuffers(STATE_CALL_PS_CONSTANT_BUFFERS, m_psConstantBuffers, startSlot, count, buffers,
+		firstConstants, numConstants);
+}
+
+bool
+StateCache::setPSShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views) {
+	return setSlots(STATE_CALL_PS_SHADER_RESOURCES, m_shaderResources, startSlot, count, views);
+}
+
+bool
+StateCache::setPSSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers) {
+	return setSlots(STATE_CALL_PS_SAMPLERS, m_samplers, startSlot, count, samplers);
+}
+
+bool
+StateCache::setRasterizerState(ID3D11RasterizerState* state) {
+	return setSingle(STATE_CALL_RASTERIZER, m_rasterizer, state);
+}
+
+bool
+StateCache::setBlendState(ID3D11BlendState* state, const float blendFactor[4], unsigned int sampleMask) {
+	// D3D11 usa {1, 1, 1, 1} cuando el factor es nullptr.
+	const float defaultFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	const float* factor = blendFactor ? blendFactor : defaultFactor;
+	const bool redundant = m_blendState.valid && m_blendState.value == state &&
+		std::memcmp(m_blendFactor, factor, sizeof(m_blendFactor)) == 0 && m_sampleMask == sampleMask;
+	m_blendState.value = state;
+	m_blendState.valid = true;
+	std::memcpy(m_blendFactor, factor, sizeof(m_blendFactor));
+	m_sampleMask = sampleMask;
+	return record(STATE_CALL_BLEND, redundant);
+}
+
+bool
+StateCache::setDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef) {
+	const bool redundant = m_depthStencil.valid && m_depthStencil.value == state && m_stencilRef == stencilRef;
+	m_depthStencil.value = state;
+	m_depthStencil.valid = true;
+	m_stencilRef = stencilRef;
+	return record(STATE_CALL_DEPTH_STENCIL, redundant);
+}
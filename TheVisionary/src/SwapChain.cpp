@@ -68,6 +68,7 @@ SwapChain::init(Device& device,
             ("Failed to create D3D11 device. HRESULT: " + std::to_string(hr)).c_str());
         return hr;
     }
+    deviceContext.init();
 
     // **Sin MSAA para depurar (estable y simple)**
     m_sampleCount = 1;
@@ -8,6 +8,13 @@
 #include "Texture.h"
 #include "Device.h"
 #include "DeviceContext.h"
+#include <fstream>
+
+namespace {
+    /// Identificador y versin del formato de imagen cocinada (.vtex).
+    const uint32_t kCookedImageMagic = 0x58455456; // 'VTEX'
+    const uint32_t kCookedImageVersion = 1;
+}
 
 // Opcional: helper local
 static void SafeRelease(IUnknown*& p) { if (p) { p->Release(); p = nullptr; } }
@@ -53,54 +60,14 @@ Texture::init(Device device, const std::string& textureName, ExtensionType exten
 
     case PNG: {
         m_textureName = textureName + ".png";
-        int width = 0, height = 0, channels = 0;
-        unsigned char* data = stbi_load(m_textureName.c_str(), &width, &height, &channels, 4); // RGBA
-        if (!data) {
-            ERROR("Texture", "init",
-                ("Failed to load PNG texture: " + std::string(stbi_failure_reason())).c_str());
-            return E_FAIL;
-        }
-
-        // Descripcin de la textura
-        D3D11_TEXTURE2D_DESC textureDesc = {};
-        textureDesc.Width = width;
-        textureDesc.Height = height;
-        textureDesc.MipLevels = 1;
-        textureDesc.ArraySize = 1;
-        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        textureDesc.SampleDesc.Count = 1;
-        textureDesc.SampleDesc.Quality = 0;
-        textureDesc.Usage = D3D11_USAGE_DEFAULT;
-        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        textureDesc.CPUAccessFlags = 0;
-        textureDesc.MiscFlags = 0;
-
-        // Datos iniciales
-        D3D11_SUBRESOURCE_DATA initData = {};
-        initData.pSysMem = data;
-        initData.SysMemPitch = width * 4;
-
-        hr = device.m_device->CreateTexture2D(&textureDesc, &initData, &m_texture);
-        stbi_image_free(data);
-
+        ImageData image;
+        hr = decodeImage(m_textureName, image);
         if (FAILED(hr)) {
-            ERROR("Texture", "init", "Failed to create texture from PNG data");
             return hr;
         }
 
-        // Crear SRV
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = textureDesc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Texture2D.MostDetailedMip = 0;
-
-        hr = device.m_device->CreateShaderResourceView(m_texture, &srvDesc, &m_textureFromImg);
-        // ya no necesitamos la ID3D11Texture2D suelta (la SRV mantiene la referencia al recurso subyacente)
-        SafeRelease(reinterpret_cast<IUnknown*&>(m_texture));
-
+        hr = init(device, image);
         if (FAILED(hr)) {
-            ERROR("Texture", "init", "Failed to create shader resource view for PNG texture");
             return hr;
         }
         break;
@@ -190,6 +157,159 @@ Texture::init(Device& device, Texture& textureRef, DXGI_FORMAT format) {
     return S_OK;
 }
 
+HRESULT
+Texture::init(Device& device, const ImageData& image) {
+    if (!device.m_device) {
+        ERROR("Texture", "init", "Device is null.");
+        return E_POINTER;
+    }
+    if (image.width == 0 || image.height == 0 ||
+        image.pixels.size() < static_cast<size_t>(image.width) * image.height * 4) {
+        ERROR("Texture", "init", "Image data is empty or truncated.");
+        return E_INVALIDARG;
+    }
+
+    SafeRelease(reinterpret_cast<IUnknown*&>(m_textureFromImg));
+    SafeRelease(reinterpret_cast<IUnknown*&>(m_texture));
+
+    // Descripcin de la textura
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width = image.width;
+    textureDesc.Height = image.height;
+    textureDesc.MipLevels = 1;
+    textureDesc.ArraySize = 1;
+    textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.SampleDesc.Quality = 0;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    textureDesc.CPUAccessFlags = 0;
+    textureDesc.MiscFlags = 0;
+
+    // Datos iniciales
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = image.pixels.data();
+    initData.SysMemPitch = image.width * 4;
+
+    HRESULT hr = device.m_device->CreateTexture2D(&textureDesc, &initData, &m_texture);
+    if (FAILED(hr)) {
+        ERROR("Texture", "init", "Failed to create texture from image data");
+        return hr;
+    }
+
+    // Crear SRV
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = textureDesc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    srvDesc.Texture2D.MostDetailedMip = 0;
+
+    hr = device.m_device->CreateShaderResourceView(m_texture, &srvDesc, &m_textureFromImg);
+    // ya no necesitamos la ID3D11Texture2D suelta (la SRV mantiene la referencia al recurso subyacente)
+    SafeRelease(reinterpret_cast<IUnknown*&>(m_texture));
+
+    if (FAILED(hr)) {
+        ERROR("Texture", "init", "Failed to create shader resource view for image");
+        return hr;
+    }
+    return S_OK;
+}
+
+HRESULT
+Texture::decodeImage(const std::string& fileName, ImageData& image) {
+    int width = 0, height = 0, channels = 0;
+    unsigned char* data = stbi_load(fileName.c_str(), &width, &height, &channels, 4); // RGBA
+    if (!data) {
+        ERROR("Texture", "decodeImage",
+            ("Failed to load image " + fileName + ": " + std::string(stbi_failure_reason())).c_str());
+        return E_FAIL;
+    }
+
+    image.width = static_cast<unsigned int>(width);
+    image.height = static_cast<unsigned int>(height);
+    image.pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+    return S_OK;
+}
+
+HRESULT
+Texture::decodeImage(const void* data, size_t size, ImageData& image) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint32_t header[4] = {};
+
+    // Imagen cocinada: cabecera + pxeles RGBA8 sin comprimir.
+    if (size >= sizeof(header)) {
+        memcpy(header, bytes, sizeof(header));
+        if (header[0] == kCookedImageMagic) {
+            const size_t pixelBytes = static_cast<size_t>(header[2]) * header[3] * 4;
+            if (header[1] != kCookedImageVersion || size - sizeof(header) < pixelBytes) {
+                ERROR("Texture", "decodeImage", "Invalid cooked image in memory");
+                return E_FAIL;
+            }
+            image.width = header[2];
+            image.height = header[3];
+            image.pixels.assign(bytes + sizeof(header), bytes + sizeof(header) + pixelBytes);
+            return S_OK;
+        }
+    }
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = stbi_load_from_memory(bytes, static_cast<int>(size),
+        &width, &height, &channels, 4); // RGBA
+    if (!pixels) {
+        ERROR("Texture", "decodeImage",
+            ("Failed to decode image: " + std::string(stbi_failure_reason())).c_str());
+        return E_FAIL;
+    }
+
+    image.width = static_cast<unsigned int>(width);
+    image.height = static_cast<unsigned int>(height);
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+    return S_OK;
+}
+
+HRESULT
+Texture::writeCookedImage(const std::string& fileName, const ImageData& image) {
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        ERROR("Texture", "writeCookedImage", ("Cannot open " + fileName).c_str());
+        return E_FAIL;
+    }
+
+    const uint32_t header[4] = { kCookedImageMagic, kCookedImageVersion, image.width, image.height };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(image.pixels.data()),
+        static_cast<std::streamsize>(image.pixels.size()));
+    return file ? S_OK : E_FAIL;
+}
+
+HRESULT
+Texture::readCookedImage(const std::string& fileName, ImageData& image) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) {
+        return E_FAIL;
+    }
+
+    uint32_t header[4] = {};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || header[0] != kCookedImageMagic || header[1] != kCookedImageVersion) {
+        ERROR("Texture", "readCookedImage", ("Invalid cooked image " + fileName).c_str());
+        return E_FAIL;
+    }
+
+    image.width = header[2];
+    image.height = header[3];
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+    file.read(reinterpret_cast<char*>(image.pixels.data()),
+        static_cast<std::streamsize>(image.pixels.size()));
+    if (!file) {
+        ERROR("Texture", "readCookedImage", ("Truncated cooked image " + fileName).c_str());
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
 void Texture::update() {
     // no-op
 }
@@ -207,7 +327,7 @@ Texture::render(DeviceContext& deviceContext,
     if (m_textureFromImg) {
         // En la mayora de casos NumViews = 1. Si usas ms, crea un array y psalo.
         ID3D11ShaderResourceView* srv = m_textureFromImg;
-        deviceContext.m_deviceContext->PSSetShaderResources(StartSlot, 1, &srv);
+        deviceContext.PSSetShaderResources(StartSlot, 1, &srv);
     }
 }
 
@@ -0,0 +1,653 @@
+﻿/**
+ * @file TriangleBVH.cpp
+ * @brief Construcción SAH por bins (paralela por subárboles) y recorrido SIMD del BVH de triángulos.
+ */
+
+#include "TriangleBVH.h"
+#include "BoundingVolume.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <cfloat>
+
+namespace {
+	/// Triángulos a partir de los cuales el cálculo de cajas y el binning de un nodo se reparten en bloques.
+	const unsigned int kParallelBinning = 65536;
+
+	/// Profundidad de la pila local del recorrido (se desborda a un vector si hace falta).
+	const int kStackSize = 64;
+
+	/// Caja mínima/máxima en arrays para indexar por eje.
+	struct Box3 {
+		float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void grow(const float* point) {
+			for (int axis = 0; axis < 3; ++axis) {
+				minimum[axis] = std::min(minimum[axis], point[axis]);
+				maximum[axis] = std::max(maximum[axis], point[axis]);
+			}
+		}
+		void grow(const Box3& other) {
+			for (int axis = 0; axis < 3; ++axis) {
+				minimum[axis] = std::min(minimum[axis], other.minimum[axis]);
+				maximum[axis] = std::max(maximum[axis], other.maximum[axis]);
+			}
+		}
+		float area() const {
+			const float dx = maximum[0] - minimum[0], dy = maximum[1] - minimum[1], dz = maximum[2] - minimum[2];
+			return dx < 0.0f ? 0.0f : 2.0f * (dx * dy + dy * dz + dz * dx);
+		}
+	};
+
+	/// Cubeta del SAH.
+	struct Bin {
+		Box3 bounds;
+		unsigned int count = 0;
+	};
+
+	/// Cubetas de los tres ejes.
+	struct BinSet {
+		Bin bins[3][TriangleBVH::kBins];
+	};
+
+	/// Subárbol pendiente de construir en paralelo.
+	struct PendingSubtree {
+		unsigned int node;
+		unsigned int first;
+		unsigned int count;
+	};
+
+	/**
+	 * @brief Estado de la construcción: cajas y centroides por triángulo y orden a particionar.
+	 */
+	class Builder {
+	public:
+		Builder(const std::vector<SimpleVertex>& vertices, const unsigned int* indices, size_t triangleCount, JobSystem* jobs)
+			: m_jobs(jobs && jobs->getThreadCount() > 0 ? jobs : nullptr) {
+			m_bounds.resize(triangleCount);
+			m_centroids.resize(triangleCount * 3);
+			order.resize(triangleCount);
+			forRange(static_cast<unsigned int>(triangleCount), [&](unsigned int begin, unsigned int end) {
+				for (unsigned int t = begin; t < end; ++t) {
+					Box3 box;
+					for (int corner = 0; corner < 3; ++corner) {
+						box.grow(&vertices[indices[t * 3 + corner]].Pos.x);
+					}
+					m_bounds[t] = box;
+					for (int axis = 0; axis < 3; ++axis) {
+						m_centroids[t * 3 + axis] = 0.5f * (box.minimum[axis] + box.maximum[axis]);
+					}
+					order[t] = t;
+				}
+			});
+		}
+
+		/// Divide el nodo; con pending, los subárboles pequeños se aplazan para construirlos en paralelo.
+		void
+		split(std::vector<BVHNode>& nodes, unsigned int node, unsigned int first, unsigned int count,
+			std::vector<PendingSubtree>* pending) {
+			Box3 bounds, centroidBounds;
+			computeBounds(first, count, bounds, centroidBounds);
+			nodes[node].boundsMin = XMFLOAT3(bounds.minimum[0], bounds.minimum[1], bounds.minimum[2]);
+			nodes[node].boundsMax = XMFLOAT3(bounds.maximum[0], bounds.maximum[1], bounds.maximum[2]);
+
+			if (count <= TriangleBVH::kLeafTriangles) {
+				nodes[node].leftFirst = first;
+				nodes[node].triangleCount = count;
+				return;
+			}
+			if (pending && count <= TriangleBVH::kParallelSubtree) {
+				pending->push_back({ node, first, count });
+				return;
+			}
+
+			// Corte SAH: para cada eje, barrido de las cubetas acumulando área x triángulos a cada lado.
+			int bestAxis = -1;
+			unsigned int bestSplit = 0;
+			float bestCost = FLT_MAX;
+			BinSet bins;
+			binTriangles(first, count, centroidBounds, bins);
+			for (int axis = 0; axis < 3; ++axis) {
+				if (centroidBounds.maximum[axis] <= centroidBounds.minimum[axis]) {
+					continue;
+				}
+				const Bin* axisBins = bins.bins[axis];
+				float leftCost[TriangleBVH::kBins];
+				Box3 box;
+				unsigned int sum = 0;
+				for (unsigned int b = 0; b + 1 < TriangleBVH::kBins; ++b) {
+					box.grow(axisBins[b].bounds);
+					sum += axisBins[b].count;
+					leftCost[b] = box.area() * sum;
+				}
+				box = Box3();
+				sum = 0;
+				for (unsigned int b = TriangleBVH::kBins - 1; b > 0; --b) {
+					box.grow(axisBins[b].bounds);
+					sum += axisBins[b].count;
+					const float cost = leftCost[b - 1] + box.area() * sum;
+					if (cost < bestCost) {
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = b;
+					}
+				}
+			}
+
+			unsigned int middle = first + count / 2;
+			if (bestAxis >= 0) {
+				const float origin = centroidBounds.minimum[bestAxis];
+				const float scale = TriangleBVH::kBins / (centroidBounds.maximum[bestAxis] - origin);
+				const unsigned int* boundary = std::partition(order.data() + first, order.data() + first + count,
+					[&](unsigned int t) {
+						return binIndex(m_centroids[t * 3 + bestAxis], origin, scale) < bestSplit;
+					});
+				middle = static_cast<unsigned int>(boundary - order.data());
+				// Corte degenerado (todo a un lado): se parte por la mitad.
+				if (middle == first || middle == first + count) {
+					middle = first + count / 2;
+				}
+			}
+
+			const unsigned int left = static_cast<unsigned int>(nodes.size());
+			nodes.resize(nodes.size() + 2);
+			nodes[node].leftFirst = left;
+			nodes[node].triangleCount = 0;
+			split(nodes, left, first, middle - first, pending);
+			split(nodes, left + 1, middle, first + count - middle, pending);
+		}
+
+		JobSystem* getJobs() const { return m_jobs; }
+
+		std::vector<unsigned int> order; ///< Triángulo en cada posición; cada nodo ocupa un rango contiguo.
+
+	private:
+		static unsigned int
+		binIndex(float centroid, float origin, float scale) {
+			const int bin = static_cast<int>((centroid - origin) * scale);
+			return static_cast<unsigned int>(std::min(std::max(bin, 0), int(TriangleBVH::kBins) - 1));
+		}
+
+		/// Ejecuta fn en bloques, en paralelo si hay pool y el rango es grande.
+		template <typename Fn>
+		void
+		forRange(unsigned int count, const Fn& fn) const {
+			if (m_jobs && count >= kParallelBinning) {
+				m_jobs->parallelFor(count, kParallelBinning / 4, fn);
+			}
+			else {
+				fn(0, count);
+			}
+		}
+
+		/// Número de bloques para las reducciones paralelas de un nodo.
+		unsigned int
+		chunkCount(unsigned int count) const {
+			return (m_jobs && count >= kParallelBinning) ? std::min(32u, count / (kParallelBinning / 4)) : 1u;
+		}
+
+		void
+		computeBounds(unsigned int first, unsigned int count, Box3& bounds, Box3& centroidBounds) const {
+			const unsigned int chunks = chunkCount(count);
+			std::vector<Box3> partial(chunks * 2);
+			auto run = [&](unsigned int begin, unsigned int end) {
+				for (unsigned int chunk = begin; chunk < end; ++chunk) {
+					const unsigned int from = first + unsigned(uint64_t(count) * chunk / chunks);
+					const unsigned int to = first + unsigned(uint64_t(count) * (chunk + 1) / chunks);
+					for (unsigned int i = from; i < to; ++i) {
+						const unsigned int t = order[i];
+						partial[chunk * 2].grow(m_bounds[t]);
+						partial[chunk * 2 + 1].grow(&m_centroids[t * 3]);
+					}
+				}
+			};
+			if (chunks > 1) {
+				m_jobs->parallelFor(chunks, 1, run);
+			}
+			else {
+				run(0, 1);
+			}
+			for (unsigned int chunk = 0; chunk < chunks; ++chunk) {
+				bounds.grow(partial[chunk * 2]);
+				centroidBounds.grow(partial[chunk * 2 + 1]);
+			}
+		}
+
+		void
+		binTriangles(unsigned int first, unsigned int count, const Box3& centroidBounds, BinSet& result) const {
+			float origin[3], scale[3];
+			for (int axis = 0; axis < 3; ++axis) {
+				const float extent = centroidBounds.maximum[axis] - centroidBounds.minimum[axis];
+				origin[axis] = centroidBounds.minimum[axis];
+				scale[axis] = extent > 0.0f ? TriangleBVH::kBins / extent : 0.0f;
+			}
+			const unsigned int chunks = chunkCount(count);
+			std::vector<BinSet> partial(chunks);
+			auto run = [&](unsigned int begin, unsigned int end) {
+				for (unsigned int chunk = begin; chunk < end; ++chunk) {
+					const unsigned int from = first + unsigned(uint64_t(count) * chunk / chunks);
+					const unsigned int to = first + unsigned(uint64_t(count) * (chunk + 1) / chunks);
+					BinSet& bins = partial[chunk];
+					for (unsigned int i = from; i < to; ++i) {
+						const unsigned int t = order[i];
+						for (int axis = 0; axis < 3; ++axis) {
+							Bin& bin = bins.bins[axis][binIndex(m_centroids[t * 3 + axis], origin[axis], scale[axis])];
+							bin.bounds.grow(m_bounds[t]);
+							++bin.count;
+						}
+					}
+				}
+			};
+			if (chunks > 1) {
+				m_jobs->parallelFor(chunks, 1, run);
+			}
+			else {
+				run(0, 1);
+			}
+			result = partial[0];
+			for (unsigned int chunk = 1; chunk < chunks; ++chunk) {
+				for (int axis = 0; axis < 3; ++axis) {
+					for (unsigned int b = 0; b < TriangleBVH::kBins; ++b) {
+						result.bins[axis][b].bounds.grow(partial[chunk].bins[axis][b].bounds);
+						result.bins[axis][b].count += partial[chunk].bins[axis][b].count;
+					}
+				}
+			}
+		}
+
+		JobSystem* m_jobs;              ///< Pool (nullptr = un hilo).
+		std::vector<Box3> m_bounds;     ///< Caja de cada triángulo.
+		std::vector<float> m_centroids; ///< Centroide de cada triángulo (xyz).
+	};
+
+	/// Entrada de la pila de recorrido: nodo y distancia de entrada en su caja.
+	struct StackEntry {
+		unsigned int node;
+		float distance;
+	};
+
+	/// Distancia de entrada del rayo en la caja del nodo (slabs con XMVECTOR); FLT_MAX si no la cruza antes de best.
+	inline float
+	rayNode(const BVHNode& node, FXMVECTOR origin, FXMVECTOR inverse, float best) {
+		const XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.boundsMin), origin), inverse);
+		const XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.boundsMax), origin), inverse);
+		const XMVECTOR tMin = XMVectorMin(t0, t1);
+		const XMVECTOR tMax = XMVectorMax(t0, t1);
+		const float entry = XMVectorGetX(XMVectorMax(XMVectorMax(XMVectorSplatX(tMin), XMVectorSplatY(tMin)),
+			XMVectorMax(XMVectorSplatZ(tMin), XMVectorZero())));
+		const float exit = std::min(std::min(XMVectorGetX(tMax), XMVectorGetY(tMax)), std::min(XMVectorGetZ(tMax), best));
+		return entry <= exit ? entry : FLT_MAX;
+	}
+}
+
+void
+TriangleBVH::clear() {
+	m_nodes.clear();
+	m_order.clear();
+	m_groups.clear();
+}
+
+void
+TriangleBVH::build(const std::vector<SimpleVertex>& vertices,
+	const unsigned int* indices,
+	size_t triangleCount,
+	JobSystem* jobs,
+	BVHBuildStats* stats) {
+	const auto start = std::chrono::steady_clock::now();
+	clear();
+	if (triangleCount == 0) {
+		return;
+	}
+
+	Builder builder(vertices, indices, triangleCount, jobs);
+	m_nodes.reserve(triangleCount / 2 + 1);
+	m_nodes.resize(1);
+
+	// Niveles superiores en este hilo (con binning repartido); los subárboles pequeños, en paralelo.
+	std::vector<PendingSubtree> pending;
+	builder.split(m_nodes, 0, 0, static_cast<unsigned int>(triangleCount),
+		builder.getJobs() ? &pending : nullptr);
+	if (!pending.empty()) {
+		std::vector<std::vector<BVHNode>> subtrees(pending.size());
+		builder.getJobs()->parallelFor(static_cast<unsigned int>(pending.size()), 1,
+			[&](unsigned int begin, unsigned int end) {
+				for (unsigned int i = begin; i < end; ++i) {
+					std::vector<BVHNode>& local = subtrees[i];
+					local.reserve(pending[i].count / 2 + 1);
+					local.resize(1);
+					builder.split(local, 0, pending[i].first, pending[i].count, nullptr);
+				}
+			});
+		// Empalme: la raíz local ocupa el nodo aplazado y el resto se agrega al final.
+		for (size_t i = 0; i < pending.size(); ++i) {
+			const std::vector<BVHNode>& local = subtrees[i];
+			const unsigned int base = static_cast<unsigned int>(m_nodes.size());
+			auto relocate = [base](BVHNode node) {
+				if (!node.isLeaf()) {
+					node.leftFirst = base + node.leftFirst - 1;
+				}
+				return node;
+			};
+			m_nodes[pending[i].node] = relocate(local[0]);
+			for (size_t n = 1; n < local.size(); ++n) {
+				m_nodes.push_back(relocate(local[n]));
+			}
+		}
+	}
+
+	// Cada hoja ocupa un grupo de 4 posiciones (relleno con kInvalidTriangle).
+	size_t leaves = 0;
+	m_order.reserve(triangleCount + triangleCount / 2);
+	for (BVHNode& node : m_nodes) {
+		if (!node.isLeaf()) {
+			continue;
+		}
+		const unsigned int first = node.leftFirst;
+		node.leftFirst = static_cast<unsigned int>(m_order.size());
+		for (unsigned int i = 0; i < kLeafTriangles; ++i) {
+			const unsigned int triangle = i < node.triangleCount ? builder.order[first + i] : kInvalidTriangle;
+			m_order.push_back(triangle);
+		}
+		++leaves;
+	}
+	buildGroups(vertices, indices);
+
+	if (stats) {
+		stats->meshes++;
+		stats->triangles += triangleCount;
+		stats->nodes += m_nodes.size();
+		stats->leaves += leaves;
+		stats->subtrees += static_cast<unsigned int>(pending.size());
+		stats->milliseconds += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+bool
+TriangleBVH::load(std::vector<BVHNode> nodes,
+	std::vector<unsigned int> order,
+	const std::vector<SimpleVertex>& vertices,
+	const unsigned int* indices,
+	size_t triangleCount) {
+	clear();
+	if (nodes.empty() || order.size() % kLeafTriangles != 0) {
+		return false;
+	}
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const BVHNode& node = nodes[i];
+		if (node.isLeaf()) {
+			if (node.triangleCount > kLeafTriangles || node.leftFirst % kLeafTriangles != 0 ||
+				size_t(node.leftFirst) + kLeafTriangles > order.size()) {
+				return false;
+			}
+		}
+		// Los hijos siempre van después del padre: evita ciclos en datos corruptos.
+		else if (node.leftFirst <= i || size_t(node.leftFirst) + 1 >= nodes.size()) {
+			return false;
+		}
+	}
+	for (unsigned int triangle : order) {
+		if (triangle == kInvalidTriangle) {
+			continue;
+		}
+		if (triangle >= triangleCount) {
+			return false;
+		}
+		for (int corner = 0; corner < 3; ++corner) {
+			if (indices[triangle * 3 + corner] >= vertices.size()) {
+				return false;
+			}
+		}
+	}
+	m_nodes = std::move(nodes);
+	m_order = std::move(order);
+	buildGroups(vertices, indices);
+	return true;
+}
+
+void
+TriangleBVH::buildGroups(const std::vector<SimpleVertex>& vertices, const unsigned int* indices) {
+	m_groups.assign(m_order.size() / kLeafTriangles, TriangleGroup());
+	for (size_t slot = 0; slot < m_order.size(); ++slot) {
+		const unsigned int triangle = m_order[slot];
+		if (triangle == kInvalidTriangle) {
+			// Relleno: triángulo nulo, det = 0 y nunca da impacto.
+			continue;
+		}
+		const XMFLOAT3& p0 = vertices[indices[triangle * 3 + 0]].Pos;
+		const XMFLOAT3& p1 = vertices[indices[triangle * 3 + 1]].Pos;
+		const XMFLOAT3& p2 = vertices[indices[triangle * 3 + 2]].Pos;
+		TriangleGroup& group = m_groups[slot / kLeafTriangles];
+		const size_t lane = slot % kLeafTriangles;
+		(&group.v0x.x)[lane] = p0.x;
+		(&group.v0y.x)[lane] = p0.y;
+		(&group.v0z.x)[lane] = p0.z;
+		(&group.e1x.x)[lane] = p1.x - p0.x;
+		(&group.e1y.x)[lane] = p1.y - p0.y;
+		(&group.e1z.x)[lane] = p1.z - p0.z;
+		(&group.e2x.x)[lane] = p2.x - p0.x;
+		(&group.e2y.x)[lane] = p2.y - p0.y;
+		(&group.e2z.x)[lane] = p2.z - p0.z;
+	}
+}
+
+bool
+TriangleBVH::intersect(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, BVHHit& hit) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+	// Componentes nulas de la dirección: un valor diminuto evita 0 * inf = NaN en los slabs.
+	const float kTiny = 1.0e-30f;
+	const XMFLOAT3 safe(std::fabs(direction.x) < kTiny ? kTiny : direction.x,
+		std::fabs(direction.y) < kTiny ? kTiny : direction.y,
+		std::fabs(direction.z) < kTiny ? kTiny : direction.z);
+	const XMVECTOR rayOrigin = XMLoadFloat3(&origin);
+	const XMVECTOR inverse = XMVectorReciprocal(XMLoadFloat3(&safe));
+
+	const XMVECTOR ox = XMVectorReplicate(origin.x), oy = XMVectorReplicate(origin.y), oz = XMVectorReplicate(origin.z);
+	const XMVECTOR dx = XMVectorReplicate(direction.x), dy = XMVectorReplicate(direction.y), dz = XMVectorReplicate(direction.z);
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR one = XMVectorReplicate(1.0f);
+	const XMVECTOR epsilon = XMVectorReplicate(1.0e-12f);
+
+	float best = maxDistance;
+	bool found = false;
+
+	StackEntry stack[kStackSize];
+	std::vector<StackEntry> overflow;
+	int depth = 0;
+	auto push = [&](unsigned int node, float distance) {
+		if (depth < kStackSize) {
+			stack[depth++] = { node, distance };
+		}
+		else {
+			overflow.push_back({ node, distance });
+		}
+	};
+
+	float rootEntry = rayNode(m_nodes[0], rayOrigin, inverse, best);
+	if (rootEntry == FLT_MAX) {
+		return false;
+	}
+	push(0, rootEntry);
+	while (depth > 0 || !overflow.empty()) {
+		StackEntry entry;
+		if (!overflow.empty()) {
+			entry = overflow.back();
+			overflow.pop_back();
+		}
+		else {
+			entry = stack[--depth];
+		}
+		if (entry.distance > best) {
+			continue;
+		}
+		const BVHNode& node = m_nodes[entry.node];
+
+		if (!node.isLeaf()) {
+			// Primero el hijo más cercano: se apila el lejano antes.
+			const unsigned int left = node.leftFirst;
+			const float leftEntry = rayNode(m_nodes[left], rayOrigin, inverse, best);
+			const float rightEntry = rayNode(m_nodes[left + 1], rayOrigin, inverse, best);
+			const bool leftFirst = leftEntry <= rightEntry;
+			const float nearEntry = leftFirst ? leftEntry : rightEntry;
+			const float farEntry = leftFirst ? rightEntry : leftEntry;
+			if (farEntry != FLT_MAX) {
+				push(leftFirst ? left + 1 : left, farEntry);
+			}
+			if (nearEntry != FLT_MAX) {
+				push(leftFirst ? left : left + 1, nearEntry);
+			}
+			continue;
+		}
+
+		// Möller-Trumbore sobre los cuatro triángulos de la hoja a la vez.
+		const TriangleGroup& group = m_groups[node.leftFirst / kLeafTriangles];
+		const XMVECTOR e1x = XMLoadFloat4(&group.e1x), e1y = XMLoadFloat4(&group.e1y), e1z = XMLoadFloat4(&group.e1z);
+		const XMVECTOR e2x = XMLoadFloat4(&group.e2x), e2y = XMLoadFloat4(&group.e2y), e2z = XMLoadFloat4(&group.e2z);
+
+		const XMVECTOR px = XMVectorSubtract(XMVectorMultiply(dy, e2z), XMVectorMultiply(dz, e2y));
+		const XMVECTOR py = XMVectorSubtract(XMVectorMultiply(dz, e2x), XMVectorMultiply(dx, e2z));
+		const XMVECTOR pz = XMVectorSubtract(XMVectorMultiply(dx, e2y), XMVectorMultiply(dy, e2x));
+		const XMVECTOR det = XMVectorMultiplyAdd(e1x, px, XMVectorMultiplyAdd(e1y, py, XMVectorMultiply(e1z, pz)));
+		const XMVECTOR invDet = XMVectorReciprocal(det);
+
+		const XMVECTOR tx = XMVectorSubtract(ox, XMLoadFloat4(&group.v0x));
+		const XMVECTOR ty = XMVectorSubtract(oy, XMLoadFloat4(&group.v0y));
+		const XMVECTOR tz = XMVectorSubtract(oz, XMLoadFloat4(&group.v0z));
+		const XMVECTOR u = XMVectorMultiply(
+			XMVectorMultiplyAdd(tx, px, XMVectorMultiplyAdd(ty, py, XMVectorMultiply(tz, pz))), invDet);
+
+		const XMVECTOR qx = XMVectorSubtract(XMVectorMultiply(ty, e1z), XMVectorMultiply(tz, e1y));
+		const XMVECTOR qy = XMVectorSubtract(XMVectorMultiply(tz, e1x), XMVectorMultiply(tx, e1z));
+		const XMVECTOR qz = XMVectorSubtract(XMVectorMultiply(tx, e1y), XMVectorMultiply(ty, e1x));
+		const XMVECTOR v = XMVectorMultiply(
+			XMVectorMultiplyAdd(dx, qx, XMVectorMultiplyAdd(dy, qy, XMVectorMultiply(dz, qz))), invDet);
+		const XMVECTOR t = XMVectorMultiply(
+			XMVectorMultiplyAdd(e2x, qx, XMVectorMultiplyAdd(e2y, qy, XMVectorMultiply(e2z, qz))), invDet);
+
+		XMVECTOR valid = XMVectorGreater(XMVectorAbs(det), epsilon);
+		valid = XMVectorAndInt(valid, XMVectorGreaterOrEqual(u, zero));
+		valid = XMVectorAndInt(valid, XMVectorGreaterOrEqual(v, zero));
+		valid = XMVectorAndInt(valid, XMVectorLessOrEqual(XMVectorAdd(u, v), one));
+		valid = XMVectorAndInt(valid, XMVectorGreater(t, zero));
+		valid = XMVectorAndInt(valid, XMVectorLess(t, XMVectorReplicate(best)));
+		if (XMVector4EqualInt(valid, XMVectorFalseInt())) {
+			continue;
+		}
+
+		UINT mask[4];
+		XMFLOAT4 distances, us, vs;
+		XMStoreInt4(mask, valid);
+		XMStoreFloat4(&distances, t);
+		XMStoreFloat4(&us, u);
+		XMStoreFloat4(&vs, v);
+		for (unsigned int lane = 0; lane < kLeafTriangles; ++lane) {
+			const float distance = (&distances.x)[lane];
+			if (mask[lane] && distance < best) {
+				best = distance;
+				hit.distance = distance;
+				hit.triangle = m_order[node.leftFirst + lane];
+				hit.u = (&us.x)[lane];
+				hit.v = (&vs.x)[lane];
+				found = true;
+			}
+		}
+	}
+	return found;
+}
+
+BVHRayBenchmark
+TriangleBVH::benchmark(const TriangleBVH& bvh, const MeshBounds& bounds, unsigned int rayCount, JobSystem* jobs) {
+	BVHRayBenchmark result;
+	result.triangles = 0;
+	for (unsigned int triangle : bvh.m_order) {
+		result.triangles += triangle != kInvalidTriangle ? 1 : 0;
+	}
+	result.nodes = bvh.m_nodes.size();
+	result.rays = rayCount;
+	if (bvh.isEmpty() || bounds.isEmpty()) {
+		return result;
+	}
+
+	// Rayos desde una esfera del doble del radio hacia puntos al azar de la AABB.
+	std::vector<XMFLOAT3> origins(rayCount), directions(rayCount);
+	uint32_t state = 0x68E31DA4u;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return float(state >> 8) / 16777216.0f;
+	};
+	const float radius = 2.0f * bounds.sphere.w;
+	for (unsigned int r = 0; r < rayCount; ++r) {
+		const float z = next() * 2.0f - 1.0f;
+		const float angle = next() * XM_2PI;
+		const float ring = std::sqrt(std::max(0.0f, 1.0f - z * z));
+		origins[r] = XMFLOAT3(bounds.sphere.x + radius * ring * std::cos(angle),
+			bounds.sphere.y + radius * ring * std::sin(angle), bounds.sphere.z + radius * z);
+		const XMFLOAT3 target(bounds.center.x + (next() * 2.0f - 1.0f) * bounds.extents.x,
+			bounds.center.y + (next() * 2.0f - 1.0f) * bounds.extents.y,
+			bounds.center.z + (next() * 2.0f - 1.0f) * bounds.extents.z);
+		directions[r] = XMFLOAT3(target.x - origins[r].x, target.y - origins[r].y, target.z - origins[r].z);
+	}
+
+	unsigned int hits = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < rayCount; ++r) {
+		BVHHit hit;
+		hits += bvh.intersect(origins[r], directions[r], FLT_MAX, hit) ? 1 : 0;
+	}
+	result.serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.hits = hits;
+
+	std::atomic<unsigned int> parallelHits{ 0 };
+	start = std::chrono::steady_clock::now();
+	auto run = [&](unsigned int begin, unsigned int end) {
+		unsigned int local = 0;
+		for (unsigned int r = begin; r < end; ++r) {
+			BVHHit hit;
+			local += bvh.intersect(origins[r], directions[r], FLT_MAX, hit) ? 1 : 0;
+		}
+		parallelHits += local;
+	};
+	if (jobs) {
+		jobs->parallelFor(rayCount, 4096, run);
+	}
+	else {
+		run(0, rayCount);
+	}
+	result.parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+BVHRayBenchmark
+TriangleBVH::benchmarkSynthetic(size_t triangleCount, unsigned int rayCount, JobSystem* jobs) {
+	// Terreno ondulado de n x n cuadriláteros (2 triángulos cada uno).
+	const unsigned int side = std::max(1u, static_cast<unsigned int>(std::sqrt(triangleCount / 2.0)));
+	std::vector<SimpleVertex> vertices(size_t(side + 1) * (side + 1));
+	for (unsigned int z = 0; z <= side; ++z) {
+		for (unsigned int x = 0; x <= side; ++x) {
+			SimpleVertex& vertex = vertices[size_t(z) * (side + 1) + x];
+			vertex.Pos = XMFLOAT3(float(x), 8.0f * std::sin(x * 0.05f) * std::cos(z * 0.07f), float(z));
+			vertex.Tex = XMFLOAT2(float(x) / side, float(z) / side);
+		}
+	}
+	std::vector<unsigned int> indices;
+	indices.reserve(size_t(side) * side * 6);
+	for (unsigned int z = 0; z < side; ++z) {
+		for (unsigned int x = 0; x < side; ++x) {
+			const unsigned int i0 = z * (side + 1) + x;
+			const unsigned int i1 = i0 + 1;
+			const unsigned int i2 = i0 + side + 1;
+			const unsigned int i3 = i2 + 1;
+			indices.insert(indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+
+	TriangleBVH bvh;
+	BVHBuildStats stats;
+	bvh.build(vertices, indices.data(), indices.size() / 3, jobs, &stats);
+	BVHRayBenchmark result = benchmark(bvh, BoundingVolume::compute(vertices), rayCount, jobs);
+	result.buildMs = stats.milliseconds;
+	return result;
+}
@@ -11,6 +11,33 @@
 #include "Texture.h"
 #include "MeshComponent.h"
 #include "ECS\\Actor.h"
+#include "AssetStreamer.h"
+#include "FrustumCuller.h"
+#include "DynamicAABBTree.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+#include "DeferredContextPool.h"
+#include "NullBackend.h"
+#include "CommandReplay.h"
+#include "StateCache.h"
+#include "InstanceBatcher.h"
+#include "ConstantBufferRing.h"
+#include "GeometryHeap.h"
+#include "ObjectCache.h"
+#include "ShaderCache.h"
+#include "FramePipeline.h"
+#include "FramePacing.h"
+#include "Profiler.h"
+
+
+// Copia sin soltar la memoria del destino (ImVector::operator= la libera cada vez).
+template <typename T>
+static void CopyImVector(ImVector<T>& dst, const ImVector<T>& src) {
+    dst.resize(src.Size);
+    if (src.Size > 0) {
+        memcpy(dst.Data, src.Data, src.size_in_bytes());
+    }
+}
 
 UserInterface::UserInterface() {}
 UserInterface::~UserInterface() {}
@@ -66,6 +93,37 @@ void UserInterface::render() {
     }
 }
 
+void UserInterface::snapshot(UiDrawSnapshot& snapshot) {
+    ImGui::Render();
+    const ImDrawData* source = ImGui::GetDrawData();
+    if (!source || !source->Valid) {
+        snapshot.data.Clear();
+        return;
+    }
+
+    // Solo los buffers: sin datos compartidos de ImGui la copia no admite más primitivas, pero se puede dibujar.
+    while (snapshot.lists.size() < static_cast<size_t>(source->CmdListsCount)) {
+        snapshot.lists.push_back(IM_NEW(ImDrawList)(nullptr));
+    }
+    for (int i = 0; i < source->CmdListsCount; ++i) {
+        const ImDrawList* list = source->CmdLists[i];
+        ImDrawList* copy = snapshot.lists[i];
+        CopyImVector(copy->CmdBuffer, list->CmdBuffer);
+        CopyImVector(copy->IdxBuffer, list->IdxBuffer);
+        CopyImVector(copy->VtxBuffer, list->VtxBuffer);
+        copy->Flags = list->Flags;
+    }
+    snapshot.data = *source;
+    snapshot.data.CmdLists = snapshot.lists.data();
+    snapshot.data.OwnerViewport = nullptr;
+}
+
+void UserInterface::renderSnapshot(UiDrawSnapshot& snapshot) {
+    if (snapshot.data.Valid) {
+        ImGui_ImplDX11_RenderDrawData(&snapshot.data);
+    }
+}
+
 void UserInterface::destroy()
 {
     if (!m_imguiInitialized || ImGui::GetCurrentContext() == nullptr)
@@ -202,6 +260,18 @@ void UserInterface::inspectorGeneral(EU::TSharedPointer<Actor> actor) {
     ImGui::SetNextItemWidth(ImGui::GetContentRegionAvailWidth() * 0.5f);
     ImGui::Combo("Layer", &currentLayer, layers, IM_ARRAYSIZE(layers));
 
+    bool occluder = actor->isOccluder();
+    if (ImGui::Checkbox("Occluder", &occluder)) {
+        actor->setOccluder(occluder);
+    }
+    ToolTip("Rasterize this actor's simplest LOD into the occlusion buffer");
+
+    bool instanced = actor->isInstanced();
+    if (ImGui::Checkbox("Instanced", &instanced)) {
+        actor->setInstanced(instanced);
+    }
+    ToolTip("Draw with DrawIndexedInstanced together with every actor that shares its mesh and material");
+
     ImGui::Separator();
     if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen)) {
         inspectorContainer(actor);
@@ -626,3 +696,629 @@ void UserInterface::outliner(const std::vector<EU::TSharedPointer<Actor>>& actor
 
     ImGui::End();
 }
+
+bool UserInterface::streamingPanel(const StreamingStats& stats,
+    double timeToFirstFrameMs,
+    double worstFrameMs,
+    int& budgetKB,
+    float& budgetMs) {
+    ImGui::Begin("Streaming");
+
+    ImGui::Text("Time to first frame: %.2f ms", timeToFirstFrameMs);
+    ImGui::Text("Worst frame:         %.2f ms", worstFrameMs);
+    ImGui::Separator();
+
+    ImGui::Text("Queued: %u  In flight: %u  Ready: %u", stats.queued, stats.inFlight, stats.ready);
+    ImGui::Text("Resident: %u  Canceled: %u  Failed: %u", stats.resident, stats.canceled, stats.failed);
+    ImGui::Text("Upload (frame): %.1f KB in %.3f ms", stats.frameBytes / 1024.0, stats.frameMs);
+    ImGui::Text("Upload (worst): %.3f ms  total: %.1f MB", stats.worstFrameMs, stats.totalBytes / (1024.0 * 1024.0));
+    ImGui::Separator();
+
+    ImGui::SliderInt("Budget (KB)", &budgetKB, 0, 65536);
+    ImGui::SliderFloat("Budget (ms)", &budgetMs, 0.0f, 16.0f, "%.2f");
+    ToolTip("0 = unlimited");
+
+    const bool stress = ImGui::Button("Stream 500 assets");
+    ToolTip("Queues 500 requests and resets the worst frame time");
+
+    ImGui::End();
+    return stress;
+}
+
+CullingPanelAction UserInterface::cullingPanel(const FrustumCullStats& frustum,
+    const MeshletCullStats& meshlets,
+    const DynamicTreeStats& sceneTree,
+    const OcclusionStats& occlusion,
+    bool& meshletCulling,
+    bool& occlusionCulling) {
+    ImGui::Begin("Culling");
+
+    ImGui::Text("Actors visible: %u / %u  (culled %u)", frustum.visible, frustum.tested, frustum.getCulled());
+    ImGui::Text("Frustum CPU: %.3f ms in %u chunks", frustum.milliseconds, frustum.chunks);
+    ImGui::Separator();
+
+    ImGui::Checkbox("Meshlet culling", &meshletCulling);
+    ToolTip("Frustum and normal-cone culling per cluster of 64 vertices / 124 triangles");
+    ImGui::Separator();
+
+    ImGui::Text("Meshlets: %u  (frustum %u, backface %u)", meshlets.meshlets, meshlets.frustumCulled, meshlets.backfaceCulled);
+    ImGui::Text("Triangles culled: %u / %u (%.1f%%)", meshlets.culledTriangles, meshlets.triangles, meshlets.getCulledPercent());
+    ImGui::Text("Draw ranges: %u", meshlets.ranges);
+    ImGui::Text("CPU: %.3f ms  (%.3f ms per M triangles)", meshlets.milliseconds, meshlets.getMsPerMillionTriangles());
+    ImGui::Separator();
+
+    ImGui::Text("Scene tree: %u proxies, height %u, area ratio %.1f", sceneTree.proxies, sceneTree.height, sceneTree.areaRatio);
+    ImGui::Text("Last update: %u moved, %u reinserted%s (%.3f ms)", sceneTree.moved, sceneTree.reinserted,
+        sceneTree.refitted ? ", refit" : "", sceneTree.updateMs);
+    ToolTip("Dynamic AABB tree over the actors' world bounds (fattened leaves, SAH insertion, rotations)");
+    ImGui::Separator();
+
+    ImGui::Checkbox("Occlusion culling", &occlusionCulling);
+    ToolTip("Software depth buffer of the occluder actors' simplest LOD; visible actors are tested against it before drawing");
+    ImGui::Text("Occluders: %u  (%u / %u triangles rasterized)", occlusion.occluders, occlusion.rasterized, occlusion.triangles);
+    ImGui::Text("Occluded: %u / %u (%.1f%%)", occlusion.occluded, occlusion.tested, occlusion.getCulledPercent());
+    ImGui::Text("CPU: raster %.3f ms, tests %.3f ms", occlusion.rasterMs, occlusion.testMs);
+    ImGui::Separator();
+
+    CullingPanelAction action = CULLING_NONE;
+    if (ImGui::Button("Bounds benchmark (10M vertices)")) {
+        action = CULLING_BOUNDS_BENCHMARK;
+    }
+    ToolTip("AABB, bounding sphere and world transform timings; results go to the log");
+    if (ImGui::Button("Frustum benchmark (100k actors)")) {
+        action = CULLING_FRUSTUM_BENCHMARK;
+    }
+    ToolTip("Single-threaded vs. job system culling of 100k random boxes; results go to the log");
+    if (ImGui::Button("Scene tree benchmark (100k moving)")) {
+        action = CULLING_TREE_BENCHMARK;
+    }
+    ToolTip("Insert, update, box/ray/frustum query throughput of the dynamic AABB tree; results go to the log");
+    if (ImGui::Button("Ray benchmark (largest mesh + 5M triangles)")) {
+        action = CULLING_RAY_BENCHMARK;
+    }
+    ToolTip("Million rays per second against the triangle BVH of the largest loaded mesh and of a generated 5M-triangle terrain");
+    if (ImGui::Button("Occlusion golden check")) {
+        action = CULLING_OCCLUSION_GOLDEN;
+    }
+    ToolTip("Rasterizes a fixed scene without the GPU and compares it with its reference depth buffer; results go to the log");
+    ImGui::SameLine();
+    if (ImGui::Button("Rewrite golden")) {
+        action = CULLING_OCCLUSION_GOLDEN_REWRITE;
+    }
+    ToolTip("Overwrites the reference depth buffer with the current rasterizer output; only after an intended change");
+
+    ImGui::End();
+    return action;
+}
+
+bool UserInterface::renderQueuePanel(const RenderQueueStats& stats, const StateCacheStats& context) {
+    ImGui::Begin("Render Queue");
+
+    ImGui::Text("Packets: %u  (%u draw calls)", stats.packets, stats.drawCalls);
+    ImGui::Text("State changes: %u issued, %u skipped", stats.bindsIssued, stats.bindsSkipped);
+    ToolTip("Binds that matched the previous draw after sorting by pass, shader, material, geometry and depth");
+    ImGui::Text("Constant uploads: %u", stats.uploads);
+    ImGui::Text("CPU: sort %.3f ms, submit %.3f ms", stats.sortMs, stats.submitMs);
+    ImGui::Separator();
+
+    ImGui::Text("Device context: %u calls issued, %u redundant skipped", context.getIssued(), context.getSkipped());
+    ToolTip("Calls dropped by the DeviceContext state cache because the slot already held that object");
+    if (ImGui::TreeNode("Per call")) {
+        for (int call = 0; call < STATE_CALL_COUNT; ++call) {
+            ImGui::Text("%-24s %5u issued %5u skipped", StateCacheStats::getCallName(static_cast<StateCall>(call)),
+                context.issued[call], context.skipped[call]);
+        }
+        ImGui::TreePop();
+    }
+    ImGui::Separator();
+
+    const bool benchmark = ImGui::Button("Render queue benchmark (20k draws)");
+    ToolTip("Radix sort and state filtering of 20k synthetic draws without the GPU; results go to the log");
+
+    ImGui::End();
+    return benchmark;
+}
+
+bool UserInterface::parallelSubmitPanel(const RenderQueueStats& stats,
+    const DeferredContextPool* contexts,
+    bool& parallel,
+    int& workers) {
+    ImGui::Begin("Parallel Submit");
+
+    if (contexts) {
+        ImGui::Checkbox("Parallel submit (deferred contexts)", &parallel);
+        ToolTip("Record contiguous slices of the sorted queue on deferred contexts from the job system and execute the command lists in order");
+        ImGui::SliderInt("Workers", &workers, 1, static_cast<int>(DeferredContextPool::kMaxContexts));
+        if (contexts->hasNativeCommandLists()) {
+            ImGui::Text("Driver command lists: native");
+        }
+        else {
+            ImGui::TextDisabled("Driver command lists: emulated (submitting on the immediate context)");
+        }
+    }
+    else {
+        ImGui::TextDisabled("Deferred contexts unavailable");
+    }
+    ImGui::Separator();
+
+    ImGui::Text("Command lists: %u", stats.commandLists);
+    ImGui::Text("CPU: record %.3f ms, submit %.3f ms", stats.recordMs, stats.submitMs);
+    ToolTip("Record is the parallel part; submit also includes executing the lists and rebinding the frame state");
+    ImGui::Separator();
+
+    const bool benchmark = ImGui::Button("Parallel submit benchmark (20k draws)");
+    ToolTip("Queue walk split over 1-8 threads without the GPU and, with deferred contexts, the scene recorded with 1-8 workers; results go to the log");
+
+    ImGui::End();
+    return benchmark;
+}
+
+bool UserInterface::headlessPanel(const HeadlessBenchmark& last, int& frames) {
+    ImGui::Begin("Headless Backend");
+
+    ImGui::SliderInt("Frames", &frames, 1, 1000);
+    const bool run = ImGui::Button("Run headless frames");
+    ToolTip("Scene update and submit recorded by the null backend instead of the GPU; results go to the log");
+    ImGui::Separator();
+
+    if (last.frames > 0) {
+        const NullBackendStats& stats = last.backend;
+        const double perFrame = 1.0 / last.frames;
+        ImGui::Text("Frames: %u", last.frames);
+        ImGui::Text("CPU per frame: update %.3f ms, render %.3f ms", last.updateMs, last.renderMs);
+        ImGui::Text("Draws per frame: %.1f (%.1f instances)", stats.draws * perFrame, stats.instances * perFrame);
+        ImGui::Text("Binds per frame: %.1f of %.1f commands", stats.binds * perFrame, stats.commands * perFrame);
+        ImGui::Text("Uploads per frame: %.1f (%.1f KB), %.1f maps", stats.uploads * perFrame,
+            stats.uploadBytes * perFrame / 1024.0, stats.maps * perFrame);
+        ImGui::Text("Stream: %.1f KB (%.1f bytes per command), %u resources", stats.streamBytes / 1024.0,
+            stats.commands > 0 ? static_cast<double>(stats.streamBytes) / stats.commands : 0.0, stats.resources);
+        if (ImGui::TreeNode("Per command")) {
+            for (int op = 0; op < COMMAND_OP_COUNT; ++op) {
+                if (stats.counts[op] > 0) {
+                    ImGui::Text("%-24s %8.1f per frame", getCommandName(static_cast<CommandOp>(op)),
+                        stats.counts[op] * perFrame);
+                }
+            }
+            ImGui::TreePop();
+        }
+    }
+    else {
+        ImGui::TextDisabled("No headless run yet");
+    }
+
+    ImGui::End();
+    return run;
+}
+
+CapturePanelAction UserInterface::capturePanel(const NullBackendStats* captured,
+    bool capturing,
+    const ReplayStats& replay,
+    int& frames,
+    int& repeats) {
+    ImGui::Begin("Command Capture");
+    CapturePanelAction action = CAPTURE_NONE;
+
+    ImGui::SliderInt("Frames", &frames, 1, 60);
+    if (capturing) {
+        ImGui::Text("Capturing... %u / %d frames", captured ? captured->frames : 0u, frames);
+    }
+    else if (ImGui::Button("Capture frames")) {
+        action = CAPTURE_START;
+    }
+    ToolTip("Records every call reaching the backend, with buffer contents, and writes it to a capture file");
+    if (captured && !capturing) {
+        ImGui::Text("Captured: %u frames, %u commands, %u draws", captured->frames, captured->commands, captured->draws);
+        ImGui::Text("File: %.1f KB (%.1f KB of contents), %u resources", captured->streamBytes / 1024.0,
+            captured->contentBytes / 1024.0, captured->resources);
+    }
+    ImGui::Separator();
+
+    ImGui::SliderInt("Repeats", &repeats, 1, 100);
+    if (!capturing) {
+        if (captured && ImGui::Button("Replay on GPU")) {
+            action = CAPTURE_REPLAY_DEVICE;
+        }
+        ToolTip("Re-issues the last capture of this session on the device context with its live objects");
+        if (ImGui::Button("Replay file headless")) {
+            action = CAPTURE_REPLAY_HEADLESS;
+        }
+        ToolTip("Loads the capture file and re-issues it on the null backend; results go to the log");
+    }
+
+    if (replay.repeats > 0) {
+        const CommandStreamStats& stream = replay.stream;
+        ImGui::Text("Replayed %u frames: %.3f ms per frame (min %.3f, max %.3f)", replay.frames,
+            replay.getFrameMs(), replay.minFrameMs, replay.maxFrameMs);
+        ImGui::Text("Time in calls: %.3f of %.3f ms", replay.callMs, replay.totalMs);
+        ImGui::Text("Binds per draw: %.2f (%u binds, %u draws per pass)", stream.getBindsPerDraw(),
+            stream.binds, stream.draws);
+        ImGui::Text("Uploaded per pass: %.1f KB updates, %.1f KB mapped", stream.uploadBytes / 1024.0,
+            stream.mapBytes / 1024.0);
+        if (replay.missing > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%u references without an object", replay.missing);
+        }
+        if (!replay.valid) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Stream is truncated or invalid");
+        }
+        if (ImGui::TreeNode("Per call")) {
+            for (int op = 0; op < COMMAND_OP_COUNT; ++op) {
+                const ReplayCallStats& call = replay.calls[op];
+                if (call.count > 0) {
+                    ImGui::Text("%-24s %8u calls %9.3f ms %7.2f us avg %7.2f us max",
+                        getCommandName(static_cast<CommandOp>(op)), call.count, call.totalMs,
+                        call.totalMs * 1000.0 / call.count, call.maxMs * 1000.0);
+                }
+            }
+            ImGui::TreePop();
+        }
+    }
+    else {
+        ImGui::TextDisabled("No replay yet");
+    }
+
+    ImGui::End();
+    return action;
+}
+
+InstancingPanelAction UserInterface::instancingPanel(const InstancingStats& stats,
+    unsigned int drawCalls,
+    double submitMs,
+    bool& instancing,
+    int& spawnCount) {
+    ImGui::Begin("Instancing");
+
+    ImGui::Checkbox("Instancing", &instancing);
+    ToolTip("Group instanced actors that share mesh and material into one DrawIndexedInstanced each");
+    ImGui::Text("Instances: %u in %u batches", stats.instances, stats.batches);
+    ImGui::Text("Queue: %u draw calls, submit %.3f ms", drawCalls, submitMs);
+    ToolTip("Toggle instancing to compare draw calls and CPU submit time of the same scene");
+    ImGui::Text("CPU: build %.3f ms, upload %.3f ms", stats.buildMs, stats.uploadMs);
+    ImGui::Text("Instance buffer: %u instances", stats.capacity);
+    ImGui::Separator();
+
+    InstancingPanelAction action = INSTANCING_NONE;
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvailWidth() * 0.5f);
+    ImGui::InputInt("Copies", &spawnCount, 100, 1000);
+    spawnCount = std::clamp(spawnCount, 1, 100000);
+    if (ImGui::Button("Spawn copies of selected actor")) {
+        action = INSTANCING_SPAWN;
+    }
+    ToolTip("Lightweight actors that share the selected actor's buffers, textures and states, laid out in a grid");
+    if (ImGui::Button("Instancing benchmark (10k instances)")) {
+        action = INSTANCING_BENCHMARK;
+    }
+    ToolTip("Per-actor packets versus instanced batches for 10k synthetic actors without the GPU; results go to the log");
+
+    ImGui::End();
+    return action;
+}
+
+bool UserInterface::constantsPanel(const ConstantUploadStats& stats,
+    const ConstantRingAllocator* ring,
+    unsigned int ringDraws,
+    bool& useRing,
+    bool& skipUnchanged) {
+    ImGui::Begin("Constants");
+
+    if (ring) {
+        ImGui::Checkbox("Constant ring", &useRing);
+        ToolTip("Per-draw constants copied into one dynamic buffer with a single Map and bound by offset (Direct3D 11.1)");
+        ImGui::Text("Ring: %.2f / %.2f MB in flight, %.1f KB this frame", ring->getUsed() / (1024.0 * 1024.0),
+            ring->getCapacity() / (1024.0 * 1024.0), ring->getFrameBytes() / 1024.0);
+        ImGui::Text("Ring draws: %u (%u blocks, %u maps)", ringDraws, stats.ringWrites, stats.ringMaps);
+    }
+    else {
+        ImGui::TextDisabled("Constant ring unavailable (needs Direct3D 11.1)");
+    }
+    ImGui::Checkbox("Skip unchanged uploads", &skipUnchanged);
+    ToolTip("Hash each full constant buffer upload and drop it when it matches the last one sent to that buffer");
+    ImGui::Separator();
+
+    ImGui::Text("UpdateSubresource: %u (%.1f KB)", stats.updates, stats.updateBytes / 1024.0);
+    ImGui::Text("Skipped unchanged: %u (%.1f KB)", stats.skipped, stats.skippedBytes / 1024.0);
+    ImGui::Text("Ring copies: %.1f KB", stats.ringBytes / 1024.0);
+    ImGui::Text("Uploaded per frame: %.1f KB", stats.getUploadedBytes() / 1024.0);
+    ToolTip("Toggle the options above to compare against uploading every buffer every frame");
+    ImGui::Separator();
+
+    const bool benchmark = ImGui::Button("Constant upload benchmark (10k draws)");
+    ToolTip("Bytes per frame before, with unchanged uploads skipped and with the ring, for 10k synthetic draws; results go to the log");
+
+    ImGui::End();
+    return benchmark;
+}
+
+GeometryPanelAction UserInterface::geometryHeapPanel(const GeometryHeapStats* stats, const RenderQueueStats& queue) {
+    GeometryPanelAction action = GEOMETRY_NONE;
+    ImGui::Begin("Geometry Heap");
+
+    if (stats) {
+        ImGui::Text("Meshes: %u in %u pages", stats->meshes, stats->pages);
+        ImGui::Text("Used: %.2f / %.2f MB", stats->usedBytes / (1024.0 * 1024.0), stats->capacityBytes / (1024.0 * 1024.0));
+        ImGui::Text("Free blocks: %u (largest %.2f MB)", stats->freeBlocks, stats->largestFreeBytes / (1024.0 * 1024.0));
+        ImGui::Text("Fragmentation: %.1f%%", stats->fragmentation * 100.0f);
+        ToolTip("Worst page: share of its free space outside its largest free block");
+        if (ImGui::Button("Defragment")) {
+            action = GEOMETRY_DEFRAGMENT;
+        }
+        ToolTip("Copy the live ranges of fragmented pages into compact pages on the GPU");
+        ImGui::Text("Last defragment: %u copies (%.1f KB)", stats->defragMoves, stats->defragBytes / 1024.0);
+    }
+    else {
+        ImGui::TextDisabled("Geometry heap unavailable: meshes use their own buffers");
+    }
+    ImGui::Separator();
+
+    ImGui::Text("Queue binds: %u issued, %u skipped", queue.bindsIssued, queue.bindsSkipped);
+    if (ImGui::Button("Geometry heap benchmark (2k meshes)")) {
+        action = GEOMETRY_BENCHMARK;
+    }
+    ToolTip("Random allocate/free on the range allocator, then bind counts of 2k meshes with their own buffers vs in the heap; results go to the log");
+
+    ImGui::End();
+    return action;
+}
+
+bool UserInterface::objectCachePanel(const ObjectCacheStats& stats, bool& enabled) {
+    static const char* kTypeNames[CACHED_TYPE_COUNT] = {
+        "Sampler", "Blend", "Rasterizer", "Depth stencil", "Vertex shader", "Pixel shader"
+    };
+    ImGui::Begin("Object Cache");
+
+    ImGui::Checkbox("Share identical objects", &enabled);
+    ToolTip("States keyed by their full descriptor and shaders by source, entry point and profile; off = create and compile every request");
+    ImGui::Text("Objects: %u", stats.objects);
+    ImGui::Text("Hits: %u  Misses: %u", stats.getHits(), stats.getMisses());
+    ImGui::Separator();
+    for (unsigned int type = 0; type < CACHED_TYPE_COUNT; ++type) {
+        ImGui::Text("%-14s %6u hits %6u misses", kTypeNames[type], stats.hits[type], stats.misses[type]);
+    }
+    ImGui::Separator();
+
+    const bool benchmark = ImGui::Button("Actor spawn benchmark (1k/10k)");
+    ToolTip("Construct and destroy 1k and 10k actors with the cache, plus a few without it to estimate the uncached cost; results go to the log");
+
+    ImGui::End();
+    return benchmark;
+}
+
+ShaderCachePanelAction UserInterface::shaderCachePanel(const ShaderCacheStats* stats, double timeToFirstFrameMs) {
+    ShaderCachePanelAction action = SHADER_CACHE_NONE;
+    ImGui::Begin("Shader Cache");
+
+    ImGui::Text("Time to first frame: %.1f ms", timeToFirstFrameMs);
+    if (stats) {
+        ImGui::Text("Started %s: %u shaders in the cache (%.1f KB)", stats->warm ? "warm" : "cold",
+            stats->entries, stats->fileBytes / 1024.0);
+        ImGui::Text("Hits: %u in %.2f ms (file read %.2f ms)", stats->hits, stats->lookupMs, stats->loadMs);
+        ImGui::Text("Compiled: %u in %.2f ms", stats->misses, stats->compileMs);
+        if (stats->failures > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Failed: %u", stats->failures);
+        }
+        ImGui::Separator();
+        if (ImGui::Button("Clear cache")) {
+            action = SHADER_CACHE_CLEAR;
+        }
+        ToolTip("Delete the cache file: the next launch compiles every shader (cold start)");
+        ImGui::SameLine();
+        if (ImGui::Button("Cold vs warm benchmark")) {
+            action = SHADER_CACHE_BENCHMARK;
+        }
+        ToolTip("Compile the engine shaders into an empty cache, then load them back from its file; results go to the log");
+    }
+    else {
+        ImGui::TextDisabled("Shader cache unavailable: shaders compile on every launch");
+    }
+
+    ImGui::End();
+    return action;
+}
+
+bool UserInterface::framePipelinePanel(const FrameLatencyStats& serial,
+    const FrameLatencyStats& threaded,
+    bool running,
+    bool& threadedRender,
+    bool& dropStale) {
+    ImGui::Begin("Frame Pipeline");
+
+    ImGui::Checkbox("Render thread", &threadedRender);
+    ToolTip("Update builds frame N+1 while a render thread submits and presents frame N; capture and parallel submit keep the serial path");
+    ImGui::Checkbox("Latest packet wins", &dropStale);
+    ToolTip("Never wait for the render thread: a newer packet replaces one that was not drawn yet");
+    ImGui::Text("Mode: %s", running ? "render thread" : "serial");
+    ImGui::Separator();
+
+    const FrameLatencyStats* modes[2] = { &serial, &threaded };
+    if (ImGui::BeginTable("FrameLatency", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("");
+        ImGui::TableSetupColumn("Serial");
+        ImGui::TableSetupColumn("Render thread");
+        ImGui::TableHeadersRow();
+        const char* rows[] = { "Frame ms", "Max frame ms", "FPS", "Latency ms", "Max latency ms", "Update ms", "Render ms", "Dropped" };
+        for (int row = 0; row < 8; ++row) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(rows[row]);
+            for (const FrameLatencyStats* stats : modes) {
+                ImGui::TableNextColumn();
+                if (stats->frames == 0) {
+                    ImGui::TextDisabled("-");
+                    continue;
+                }
+                switch (row) {
+                case 0: ImGui::Text("%.3f", stats->frameMs); break;
+                case 1: ImGui::Text("%.3f", stats->maxFrameMs); break;
+                case 2: ImGui::Text("%.1f", stats->frameMs > 0.0 ? 1000.0 / stats->frameMs : 0.0); break;
+                case 3: ImGui::Text("%.3f", stats->latencyMs); break;
+                case 4: ImGui::Text("%.3f", stats->maxLatencyMs); break;
+                case 5: ImGui::Text("%.3f", stats->updateMs); break;
+                case 6: ImGui::Text("%.3f", stats->renderMs); break;
+                default: ImGui::Text("%u", stats->dropped); break;
+                }
+            }
+        }
+        ImGui::EndTable();
+    }
+    ToolTip("Averages over the last 120 presented frames of each mode; latency runs from reading input at the start of update() to Present returning");
+
+    const bool log = ImGui::Button("Log comparison");
+    ToolTip("Writes both columns to the log");
+
+    ImGui::End();
+    return log;
+}
+
+bool UserInterface::framePacingPanel(const FramePacingStats& stats,
+    FramePacingSettings& settings,
+    int& simulationHz,
+    const FixedTimestep& timestep,
+    unsigned int frameSteps) {
+    ImGui::Begin("Frame Pacing");
+
+    ImGui::SliderInt("Max FPS", &settings.maxFps, 0, 500, settings.maxFps == 0 ? "Uncapped" : "%d");
+    ToolTip("Sleeps on a high-resolution timer until the frame deadline instead of spinning on the message loop; 0 renders as fast as possible");
+    ImGui::SliderFloat("Spin tail (ms)", &settings.spinMs, 0.0f, 4.0f, "%.2f");
+    ToolTip("Last part of each wait done busy-waiting: more is steadier, less burns less CPU");
+    ImGui::Checkbox("Throttle when unfocused", &settings.throttleUnfocused);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80.0f);
+    ImGui::SliderInt("##UnfocusedFps", &settings.unfocusedFps, 1, 60, "%d FPS");
+    ImGui::Checkbox("Pause when minimized", &settings.pauseMinimized);
+    ToolTip("Minimized, the loop neither simulates nor draws and waits for window messages");
+
+    ImGui::Separator();
+    ImGui::SliderInt("Simulation Hz", &simulationHz, 10, 240);
+    ToolTip("Actors update in fixed steps; drawing interpolates between the last two steps");
+    ImGui::Text("Steps this frame: %u   Alpha: %.2f", frameSteps, timestep.getAlpha());
+    ImGui::Text("Steps: %llu   Dropped: %.3f s", static_cast<unsigned long long>(timestep.getSteps()), timestep.getDroppedTime());
+    ToolTip("Simulation time discarded when a frame needed more than the maximum steps");
+
+    ImGui::Separator();
+    if (stats.frames > 0) {
+        ImGui::Text("Frame: %.3f ms (%.1f FPS)", stats.frameMs, stats.frameMs > 0.0 ? 1000.0 / stats.frameMs : 0.0);
+        ImGui::Text("Min / max: %.3f / %.3f ms", stats.minFrameMs, stats.maxFrameMs);
+        ImGui::Text("Std dev: %.3f ms   Variance: %.4f ms^2", stats.stdDevMs, stats.varianceMs2);
+        ImGui::Text("Busy %.3f ms   Sleep %.3f ms   Spin %.3f ms", stats.busyMs, stats.sleepMs, stats.spinMs);
+        ImGui::Text("Late frames: %u", stats.lateFrames);
+    }
+    else {
+        ImGui::TextDisabled("No frames in the last window");
+    }
+    if (stats.cores > 0) {
+        ImGui::Text("CPU: %.1f%% of %u cores   Main thread: %.1f%%", stats.processCpu, stats.cores, stats.mainThreadCpu);
+        if (stats.idleMs > 0.0) {
+            ImGui::Text("Idle (minimized): %.0f ms", stats.idleMs);
+        }
+    }
+    ToolTip("Measured over the last second; main thread is the share of one core used by update(), render() and the wait");
+
+    const bool log = ImGui::Button("Log pacing");
+    ToolTip("Writes the last window to the log");
+
+    ImGui::End();
+    return log;
+}
+
+ProfilerPanelAction UserInterface::profilerPanel(const ProfilerStats& stats,
+    const std::vector<ProfileZoneStats>& zones,
+    const std::vector<ProfileCounterStats>& counters,
+    const std::vector<ProfileThreadStats>& threads,
+    bool& enabled,
+    int& captureFrames) {
+    ImGui::Begin("Profiler");
+    ProfilerPanelAction action = PROFILER_NONE;
+
+    ImGui::Checkbox("Enabled", &enabled);
+    ToolTip("Disabled, each PROFILE_SCOPE costs one relaxed atomic load");
+    if (stats.frames > 0) {
+        ImGui::Text("%.0f events per frame, collected in %.3f ms", stats.eventsPerFrame, stats.collectMs);
+        if (stats.dropped > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%u events dropped (ring full)", stats.dropped);
+        }
+    }
+
+    ImGui::SliderInt("Trace frames", &captureFrames, 1, 600);
+    if (stats.captureFrames > 0) {
+        ImGui::Text("Tracing: %u frames left", stats.captureFrames);
+    }
+    else if (ImGui::Button("Capture Chrome trace")) {
+        action = PROFILER_CAPTURE;
+    }
+    ToolTip("Writes Captures\\Profile.json; open it in chrome://tracing or ui.perfetto.dev");
+    ImGui::SameLine();
+    if (ImGui::Button("Log zones")) {
+        action = PROFILER_LOG;
+    }
+    ImGui::Separator();
+
+    if (zones.empty()) {
+        ImGui::TextDisabled("No zones yet");
+    }
+    else if (ImGui::BeginTable("ProfilerZones", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+        ImVec2(0.0f, 320.0f))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Self ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("Peak ms");
+        ImGui::TableHeadersRow();
+        unsigned int thread = ~0u;
+        for (const ProfileZoneStats& zone : zones) {
+            if (zone.thread != thread) {
+                thread = zone.thread;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (thread < threads.size()) {
+                    ImGui::TextColored(ImVec4(0.6f, 0.8f, 1.0f, 1.0f), "%s (%u)", threads[thread].name.c_str(), threads[thread].id);
+                }
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Indent(12.0f * (zone.depth + 1));
+            if (zone.calls > 0.0) {
+                ImGui::TextUnformatted(zone.name);
+            }
+            else {
+                ImGui::TextDisabled("%s", zone.name);
+            }
+            ImGui::Unindent(12.0f * (zone.depth + 1));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", zone.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.avgMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.selfMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.maxMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.peakMs);
+        }
+        ImGui::EndTable();
+    }
+    ToolTip("Per-frame averages and worst frame over the last 120 frames; peak is the worst frame since the zone first ran");
+
+    if (!counters.empty() && ImGui::BeginTable("ProfilerCounters", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Counter", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableHeadersRow();
+        for (const ProfileCounterStats& counter : counters) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(counter.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", counter.last);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", counter.average);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", counter.max);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+    return action;
+}
@@ -0,0 +1,348 @@
+﻿/**
+ * @file VertexFormat.cpp
+ * @brief Implementación del layout de vértices y de la codificación snorm16/half e índices de 16 bits.
+ */
+
+#include "VertexFormat.h"
+#include "MeshComponent.h"
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+namespace {
+	/// Paso de cuantización snorm16.
+	const float kSnorm16Max = 32767.0f;
+
+	struct PackedPosition { int16_t x, y, z, w; };
+	struct PackedTexCoord { uint16_t u, v; };
+
+	inline float
+	component(const XMFLOAT3& v, int axis) {
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+}
+
+unsigned int
+VertexLayout::getStride() const {
+	return getTexCoordOffset() +
+		(texCoord == TEXCOORD_HALF2 ? sizeof(PackedTexCoord) : sizeof(XMFLOAT2));
+}
+
+unsigned int
+VertexLayout::getTexCoordOffset() const {
+	return position == POSITION_SNORM16 ? sizeof(PackedPosition) : sizeof(XMFLOAT3);
+}
+
+void
+VertexLayout::getInputElements(std::vector<D3D11_INPUT_ELEMENT_DESC>& elements) const {
+	elements.clear();
+
+	D3D11_INPUT_ELEMENT_DESC pos{};
+	pos.SemanticName = "POSITION";
+	pos.SemanticIndex = 0;
+	pos.Format = position == POSITION_SNORM16 ? DXGI_FORMAT_R16G16B16A16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	pos.InputSlot = 0;
+	pos.AlignedByteOffset = 0;
+	pos.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	pos.InstanceDataStepRate = 0;
+	elements.push_back(pos);
+
+	D3D11_INPUT_ELEMENT_DESC uv{};
+	uv.SemanticName = "TEXCOORD";
+	uv.SemanticIndex = 0;
+	uv.Format = texCoord == TEXCOORD_HALF2 ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
+	uv.InputSlot = 0;
+	uv.AlignedByteOffset = getTexCoordOffset();
+	uv.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	uv.InstanceDataStepRate = 0;
+	elements.push_back(uv);
+}
+
+XMMATRIX
+VertexLayout::getDequantizeMatrix() const {
+	if (position != POSITION_SNORM16) {
+		return XMMatrixIdentity();
+	}
+	return XMMatrixScaling(boundsExtent.x, boundsExtent.y, boundsExtent.z) *
+		XMMatrixTranslation(boundsCenter.x, boundsCenter.y, boundsCenter.z);
+}
+
+uint16_t
+VertexCodec::floatToHalf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	const uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+	if (magnitude >= 0x7F800000u) {
+		// Inf o NaN (el NaN se conserva como NaN silencioso).
+		return static_cast<uint16_t>(sign | (magnitude > 0x7F800000u ? 0x7E00u : 0x7C00u));
+	}
+	if (magnitude >= 0x477FF000u) {
+		// >= 65520 redondea por encima del mayor half finito (65504).
+		return static_cast<uint16_t>(sign | 0x7C00u);
+	}
+	if (magnitude < 0x38800000u) {
+		// Subnormal en half (< 2^-14) o cero.
+		if (magnitude < 0x33000000u) {
+			return static_cast<uint16_t>(sign);
+		}
+		const uint32_t exponent = magnitude >> 23;
+		const uint32_t mantissa = (magnitude & 0x007FFFFFu) | 0x00800000u;
+		const uint32_t shift = 126 - exponent;
+		uint32_t half = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t midpoint = 1u << (shift - 1);
+		if (remainder > midpoint || (remainder == midpoint && (half & 1u))) {
+			++half;
+		}
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	// Normal: se rebasa el exponente (127 -> 15) y se redondea al par más cercano.
+	uint32_t half = (magnitude - 0x38000000u) >> 13;
+	const uint32_t remainder = magnitude & 0x1FFFu;
+	if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+		++half;
+	}
+	return static_cast<uint16_t>(sign | half);
+}
+
+float
+VertexCodec::halfToFloat(uint16_t value) {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1Fu;
+	const uint32_t mantissa = value & 0x3FFu;
+
+	uint32_t bits;
+	if (exponent == 0) {
+		const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 31) {
+		bits = sign | 0x7F800000u | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+int16_t
+VertexCodec::encodeSnorm16(float value) {
+	const float clamped = std::min(1.0f, std::max(-1.0f, value));
+	return static_cast<int16_t>(std::floor(clamped * kSnorm16Max + 0.5f));
+}
+
+float
+VertexCodec::decodeSnorm16(int16_t value) {
+	// -32768 y -32767 representan ambos -1 (regla de D3D10+).
+	return std::max(static_cast<float>(value) / kSnorm16Max, -1.0f);
+}
+
+IndexFormat
+VertexCodec::chooseIndexFormat(size_t vertexCount) {
+	return vertexCount <= 0x10000 ? INDEX_UINT16 : INDEX_UINT32;
+}
+
+unsigned int
+VertexCodec::getIndexSize(IndexFormat format) {
+	return format == INDEX_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+DXGI_FORMAT
+VertexCodec::getDXGIFormat(IndexFormat format) {
+	return format == INDEX_UINT16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+VertexLayout
+VertexCodec::computeCompactLayout(const std::vector<SimpleVertex>& vertices) {
+	VertexLayout layout;
+	layout.position = POSITION_SNORM16;
+	layout.texCoord = TEXCOORD_HALF2;
+	if (vertices.empty()) {
+		return layout;
+	}
+
+	XMFLOAT3 minimum = vertices[0].Pos;
+	XMFLOAT3 maximum = vertices[0].Pos;
+	for (const SimpleVertex& vertex : vertices) {
+		minimum.x = std::min(minimum.x, vertex.Pos.x);
+		minimum.y = std::min(minimum.y, vertex.Pos.y);
+		minimum.z = std::min(minimum.z, vertex.Pos.z);
+		maximum.x = std::max(maximum.x, vertex.Pos.x);
+		maximum.y = std::max(maximum.y, vertex.Pos.y);
+		maximum.z = std::max(maximum.z, vertex.Pos.z);
+	}
+
+	layout.boundsCenter = XMFLOAT3((minimum.x + maximum.x) * 0.5f,
+		(minimum.y + maximum.y) * 0.5f,
+		(minimum.z + maximum.z) * 0.5f);
+	// Un eje plano (p. ej. el suelo) usaría escala 0: se deja en 1 y todo codifica a 0.
+	layout.boundsExtent = XMFLOAT3(
+		maximum.x > minimum.x ? (maximum.x - minimum.x) * 0.5f : 1.0f,
+		maximum.y > minimum.y ? (maximum.y - minimum.y) * 0.5f : 1.0f,
+		maximum.z > minimum.z ? (maximum.z - minimum.z) * 0.5f : 1.0f);
+	return layout;
+}
+
+void
+VertexCodec::encodeVertices(const std::vector<SimpleVertex>& vertices,
+	const VertexLayout& layout,
+	std::vector<unsigned char>& out) {
+	const unsigned int stride = layout.getStride();
+	const unsigned int uvOffset = layout.getTexCoordOffset();
+	out.resize(vertices.size() * stride);
+
+	const XMFLOAT3& c = layout.boundsCenter;
+	const XMFLOAT3 invExtent(1.0f / layout.boundsExtent.x,
+		1.0f / layout.boundsExtent.y,
+		1.0f / layout.boundsExtent.z);
+
+	unsigned char* dst = out.data();
+	for (const SimpleVertex& vertex : vertices) {
+		if (layout.position == POSITION_SNORM16) {
+			PackedPosition p;
+			p.x = encodeSnorm16((vertex.Pos.x - c.x) * invExtent.x);
+			p.y = encodeSnorm16((vertex.Pos.y - c.y) * invExtent.y);
+			p.z = encodeSnorm16((vertex.Pos.z - c.z) * invExtent.z);
+			p.w = static_cast<int16_t>(kSnorm16Max);
+			std::memcpy(dst, &p, sizeof(p));
+		}
+		else {
+			std::memcpy(dst, &vertex.Pos, sizeof(vertex.Pos));
+		}
+
+		if (layout.texCoord == TEXCOORD_HALF2) {
+			PackedTexCoord t = { floatToHalf(vertex.Tex.x), floatToHalf(vertex.Tex.y) };
+			std::memcpy(dst + uvOffset, &t, sizeof(t));
+		}
+		else {
+			std::memcpy(dst + uvOffset, &vertex.Tex, sizeof(vertex.Tex));
+		}
+		dst += stride;
+	}
+}
+
+SimpleVertex
+VertexCodec::decodeVertex(const unsigned char* data, const VertexLayout& layout) {
+	SimpleVertex vertex;
+	if (layout.position == POSITION_SNORM16) {
+		PackedPosition p;
+		std::memcpy(&p, data, sizeof(p));
+		vertex.Pos = XMFLOAT3(
+			layout.boundsCenter.x + decodeSnorm16(p.x) * layout.boundsExtent.x,
+			layout.boundsCenter.y + decodeSnorm16(p.y) * layout.boundsExtent.y,
+			layout.boundsCenter.z + decodeSnorm16(p.z) * layout.boundsExtent.z);
+	}
+	else {
+		std::memcpy(&vertex.Pos, data, sizeof(vertex.Pos));
+	}
+
+	const unsigned char* uv = data + layout.getTexCoordOffset();
+	if (layout.texCoord == TEXCOORD_HALF2) {
+		PackedTexCoord t;
+		std::memcpy(&t, uv, sizeof(t));
+		vertex.Tex = XMFLOAT2(halfToFloat(t.u), halfToFloat(t.v));
+	}
+	else {
+		std::memcpy(&vertex.Tex, uv, sizeof(vertex.Tex));
+	}
+	return vertex;
+}
+
+bool
+VertexCodec::encodeIndices(const std::vector<unsigned int>& indices,
+	IndexFormat format,
+	std::vector<unsigned char>& out) {
+	if (format == INDEX_UINT32) {
+		out.resize(indices.size() * sizeof(uint32_t));
+		if (!indices.empty()) {
+			std::memcpy(out.data(), indices.data(), out.size());
+		}
+		return true;
+	}
+
+	out.resize(indices.size() * sizeof(uint16_t));
+	uint16_t* dst = reinterpret_cast<uint16_t*>(out.data());
+	for (unsigned int index : indices) {
+		if (index > 0xFFFFu) {
+			return false;
+		}
+		*dst++ = static_cast<uint16_t>(index);
+	}
+	return true;
+}
+
+bool
+VertexCodec::verifyRoundTrip(const std::vector<SimpleVertex>& vertices,
+	const VertexLayout& layout,
+	VertexRoundTripError* error) {
+	VertexRoundTripError result;
+
+	// Cotas: medio paso de cuantización más el error de redondeo float de la
+	// reconstrucción (centro + s * semieje), y medio ulp de half en la mayor UV.
+	float largestCoordinate = 0.0f;
+	float largestTexCoord = 0.0f;
+	for (const SimpleVertex& vertex : vertices) {
+		for (int axis = 0; axis < 3; ++axis) {
+			largestCoordinate = std::max(largestCoordinate, std::fabs(component(vertex.Pos, axis)));
+		}
+		largestTexCoord = std::max(largestTexCoord, std::max(std::fabs(vertex.Tex.x), std::fabs(vertex.Tex.y)));
+	}
+	const float floatSlack = largestCoordinate * 4.0f * FLT_EPSILON;
+	if (layout.position == POSITION_SNORM16) {
+		const float extent = std::max(layout.boundsExtent.x, std::max(layout.boundsExtent.y, layout.boundsExtent.z));
+		result.positionBound = 0.5f * extent / kSnorm16Max + floatSlack;
+	}
+	if (layout.texCoord == TEXCOORD_HALF2) {
+		// ulp(half) = 2^(e - 10) para |x| en [2^e, 2^(e+1)); nunca menor que el subnormal 2^-24.
+		result.texCoordBound = largestTexCoord > 65504.0f
+			? 0.0f
+			: 0.5f * std::max(std::ldexp(1.0f, -24),
+				std::ldexp(1.0f, static_cast<int>(std::floor(std::log2(std::max(largestTexCoord, 1e-30f)))) - 10));
+	}
+
+	std::vector<unsigned char> encoded;
+	encodeVertices(vertices, layout, encoded);
+	const unsigned int stride = layout.getStride();
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const SimpleVertex decoded = decodeVertex(&encoded[i * stride], layout);
+		for (int axis = 0; axis < 3; ++axis) {
+			result.position = std::max(result.position,
+				std::fabs(component(decoded.Pos, axis) - component(vertices[i].Pos, axis)));
+		}
+		result.texCoord = std::max(result.texCoord, std::max(
+			std::fabs(decoded.Tex.x - vertices[i].Tex.x),
+			std::fabs(decoded.Tex.y - vertices[i].Tex.y)));
+	}
+
+	if (error) {
+		*error = result;
+	}
+	return result.position <= result.positionBound && result.texCoord <= result.texCoordBound;
+}
+
+bool
+VertexCodec::selectFormats(MeshComponent& mesh, bool compactVertices) {
+	mesh.m_indexFormat = chooseIndexFormat(mesh.m_vertex.size());
+	mesh.m_vertexLayout = VertexLayout();
+	if (!compactVertices || mesh.m_vertex.empty()) {
+		return false;
+	}
+
+	const VertexLayout compact = computeCompactLayout(mesh.m_vertex);
+	VertexRoundTripError error;
+	if (!verifyRoundTrip(mesh.m_vertex, compact, &error)) {
+		ERROR("VertexCodec", "selectFormats", "Compact layout rejected for " << mesh.m_name.c_str()
+			<< " (position error " << error.position << " > " << error.positionBound
+			<< " or uv error " << error.texCoord << " > " << error.texCoordBound << "); keeping float vertices.");
+		return false;
+	}
+
+	mesh.m_vertexLayout = compact;
+	return true;
+}
@@ -0,0 +1,151 @@
+﻿/**
+ * @file AssetCookerTests.cpp
+ * @brief Pruebas del cocinado incremental: primera pasada, assets al día, cambios y base de datos corrupta.
+ */
+
+#include "TestFramework.h"
+#include "TestFiles.h"
+#include "AssetCooker.h"
+#include "Texture.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	/// BMP de 24 bits de 2x2 píxeles; seed cambia los colores.
+	std::string
+	makeBitmap(unsigned char seed) {
+		const unsigned int rowBytes = 8; // 2 píxeles * 3 bytes, alineado a 4.
+		std::string bmp(54 + rowBytes * 2, '\0');
+		auto put32 = [&bmp](size_t offset, uint32_t value) {
+			for (int i = 0; i < 4; ++i) {
+				bmp[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+			}
+		};
+		bmp[0] = 'B';
+		bmp[1] = 'M';
+		put32(2, static_cast<uint32_t>(bmp.size()));
+		put32(10, 54);
+		put32(14, 40);
+		put32(18, 2);
+		put32(22, 2);
+		bmp[26] = 1;
+		bmp[28] = 24;
+		put32(34, rowBytes * 2);
+		for (unsigned int row = 0; row < 2; ++row) {
+			for (unsigned int x = 0; x < 2; ++x) {
+				for (unsigned int c = 0; c < 3; ++c) {
+					bmp[54 + row * rowBytes + x * 3 + c] = static_cast<char>(seed + row * 6 + x * 3 + c);
+				}
+			}
+		}
+		return bmp;
+	}
+
+	/// Cocina sourceDir con una instancia nueva (lee la base de datos como un arranque del cocinador).
+	CookReport
+	cookOnce(const fs::path& sourceDir, const fs::path& outputDir) {
+		AssetCooker cooker;
+		if (FAILED(cooker.init(sourceDir.string(), outputDir.string()))) {
+			return CookReport();
+		}
+		return cooker.cookAll(2);
+	}
+}
+
+TEST_CASE(AssetCooker_CooksOnceThenSkipsUpToDateAssets) {
+	const fs::path dir = MakeTestDirectory("AssetCookerIncremental");
+	const fs::path source = dir / "Source";
+	const fs::path output = dir / "Cooked";
+	fs::create_directories(source / "Sub");
+	WriteTestFile(source / "A.bmp", makeBitmap(10));
+	WriteTestFile(source / "Sub" / "B.bmp", makeBitmap(100));
+	WriteTestFile(source / "Notes.txt", "not an asset");
+
+	CookReport report = cookOnce(source, output);
+	REQUIRE(report.assets.size() == 2);
+	CHECK(report.cooked == 2);
+	CHECK(report.cacheHits == 0);
+	CHECK(report.failed == 0);
+	// El orden del informe es el de las rutas relativas.
+	CHECK(report.assets[0].relativePath == "A.bmp");
+	CHECK(report.assets[1].relativePath == "Sub/B.bmp");
+
+	ImageData cooked;
+	REQUIRE(SUCCEEDED(Texture::readCookedImage(
+		AssetCooker::getCookedPath(output.string(), "Sub/B.bmp", COOKED_TEXTURE), cooked)));
+	CHECK(cooked.width == 2 && cooked.height == 2);
+	REQUIRE(cooked.pixels.size() == 16);
+	// Fila superior (la segunda del BMP), primer píxel: BGR en disco, RGBA en memoria.
+	CHECK(cooked.pixels[0] == 100 + 6 + 2);
+	CHECK(cooked.pixels[2] == 100 + 6);
+	CHECK(cooked.pixels[3] == 255);
+
+	// Sin cambios: todo sale de la caché.
+	report = cookOnce(source, output);
+	CHECK(report.cooked == 0);
+	CHECK(report.cacheHits == 2);
+	CHECK(report.hitRate() == 1.0);
+
+	// Cambiar un fuente, añadir su .import o borrar una salida vuelve a cocinar solo ese asset.
+	WriteTestFile(source / "A.bmp", makeBitmap(20));
+	report = cookOnce(source, output);
+	CHECK(report.cooked == 1 && report.cacheHits == 1);
+	CHECK(!report.assets[0].cacheHit && report.assets[1].cacheHit);
+
+	WriteTestFile(source / "Sub" / "B.bmp.import", "srgb=1\n");
+	report = cookOnce(source, output);
+	CHECK(report.cooked == 1 && report.assets[0].cacheHit && !report.assets[1].cacheHit);
+
+	fs::remove(AssetCooker::getCookedPath(output.string(), "A.bmp", COOKED_TEXTURE));
+	report = cookOnce(source, output);
+	CHECK(report.cooked == 1 && !report.assets[0].cacheHit);
+
+	// Un fuente que no se puede decodificar falla y no entra en la caché.
+	WriteTestFile(source / "Broken.png", "not a png");
+	report = cookOnce(source, output);
+	CHECK(report.failed == 1);
+	report = cookOnce(source, output);
+	CHECK(report.failed == 1);
+	CHECK(report.cacheHits == 2);
+
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
+
+TEST_CASE(AssetCooker_CorruptCacheDatabaseIsACacheMiss) {
+	const fs::path dir = MakeTestDirectory("AssetCookerCorruptCache");
+	const fs::path source = dir / "Source";
+	const fs::path output = dir / "Cooked";
+	fs::create_directories(source);
+	WriteTestFile(source / "A.bmp", makeBitmap(10));
+	WriteTestFile(source / "B.bmp", makeBitmap(50));
+	WriteTestFile(source / "C.bmp", makeBitmap(90));
+	REQUIRE(cookOnce(source, output).cooked == 3);
+
+	// Hashes que no son números, campos que faltan, una línea cortada y bytes sueltos.
+	const fs::path database = output / "cook_cache.db";
+	const std::string valid = ReadTestFile(database);
+	const size_t lineC = valid.find("C.bmp\t");
+	REQUIRE(lineC != std::string::npos);
+	const std::string keptLine = valid.substr(lineC, valid.find('\n', lineC) + 1 - lineC);
+	WriteTestFile(database, "A.bmp\tnot-hex\t12\tCooked/A.bmp.vtex\n"
+		"B.bmp\t\t\t\n"
+		"\xff\xfe\x01garbage\n" +
+		keptLine +
+		"B.bmp\t1234");
+
+	const CookReport report = cookOnce(source, output);
+	REQUIRE(report.assets.size() == 3);
+	CHECK(report.failed == 0);
+	// Solo la línea intacta sigue valiendo; el resto se cocina de nuevo.
+	CHECK(!report.assets[0].cacheHit);
+	CHECK(!report.assets[1].cacheHit);
+	CHECK(report.assets[2].cacheHit);
+	CHECK(report.cooked == 2);
+
+	// Y la base de datos reescrita vuelve a ser válida.
+	CHECK(cookOnce(source, output).cacheHits == 3);
+
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
@@ -0,0 +1,143 @@
+﻿/**
+ * @file AssetStreamerTests.cpp
+ * @brief Pruebas de AssetStreamer con texturas cocinadas: orden por prioridad, presupuesto, cancelación y fallos.
+ */
+
+#include "TestFramework.h"
+#include "TestFiles.h"
+#include "AssetStreamer.h"
+#include <chrono>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+	/// Escribe una textura cocinada de width x 1 píxeles (width * 4 bytes al subirla).
+	std::string
+	writeTexture(const fs::path& dir, const char* name, unsigned int width) {
+		ImageData image;
+		image.width = width;
+		image.height = 1;
+		image.pixels.assign(width * 4, static_cast<unsigned char>(width));
+		const std::string path = (dir / name).string();
+		Texture::writeCookedImage(path, image);
+		return path;
+	}
+
+	/// Espera a que la petición deje de estar en cola o en vuelo (el IO y la decodificación van en otros hilos).
+	bool
+	waitUntilReady(const AssetStreamer& streamer, StreamHandle handle) {
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (std::chrono::steady_clock::now() < deadline) {
+			if (streamer.getState(handle) == STREAM_READY) {
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+}
+
+TEST_CASE(AssetStreamer_DeliversByPriorityWithinFrameBudget) {
+	const fs::path dir = MakeTestDirectory("AssetStreamerPriority");
+	AssetStreamer streamer;
+	REQUIRE(SUCCEEDED(streamer.init(2)));
+
+	std::vector<StreamHandle> delivered;
+	auto record = [&delivered](StreamedAsset& asset) {
+		if (asset.success) {
+			delivered.push_back(asset.handle);
+		}
+	};
+	const StreamHandle prefetch = streamer.request(writeTexture(dir, "A.vtex", 4), STREAM_TEXTURE, STREAM_PREFETCH, record);
+	const StreamHandle visible = streamer.request(writeTexture(dir, "B.vtex", 8), STREAM_TEXTURE, STREAM_VISIBLE, record);
+	const StreamHandle nearby = streamer.request(writeTexture(dir, "C.vtex", 16), STREAM_TEXTURE, STREAM_NEARBY, record);
+	const StreamHandle visible2 = streamer.request(writeTexture(dir, "D.vtex", 32), STREAM_TEXTURE, STREAM_VISIBLE, record);
+	for (StreamHandle handle : { prefetch, visible, nearby, visible2 }) {
+		REQUIRE(waitUntilReady(streamer, handle));
+	}
+	// Subir la prioridad de un asset listo lo adelanta en la entrega.
+	streamer.setPriority(prefetch, STREAM_VISIBLE);
+
+	// Presupuesto de 1 byte: se entrega uno por frame (siempre al menos uno).
+	streamer.update(1, 0.0);
+	REQUIRE(delivered.size() == 1);
+	CHECK(delivered[0] == prefetch);
+	CHECK(streamer.getStats().frameBytes == 16);
+	CHECK(streamer.getStats().ready == 3);
+	CHECK(!streamer.isIdle());
+
+	// Se entrega mientras quede presupuesto: el segundo asset lo supera y el tercero espera.
+	streamer.update(33, 0.0);
+	REQUIRE(delivered.size() == 3);
+	CHECK(delivered[1] == visible);
+	CHECK(delivered[2] == visible2);
+	CHECK(streamer.getStats().frameBytes == 32 + 128);
+
+	streamer.update(0, 0.0);
+	REQUIRE(delivered.size() == 4);
+	CHECK(delivered[3] == nearby);
+
+	// Las peticiones entregadas salen del mapa.
+	for (StreamHandle handle : { prefetch, visible, nearby, visible2 }) {
+		CHECK(streamer.getState(handle) == STREAM_INVALID);
+	}
+	const StreamingStats stats = streamer.getStats();
+	CHECK(stats.resident == 4);
+	CHECK(stats.totalBytes == (4 + 8 + 16 + 32) * 4);
+	CHECK(streamer.isIdle());
+
+	streamer.destroy();
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
+
+TEST_CASE(AssetStreamer_CanceledAndFailedRequestsAreDropped) {
+	const fs::path dir = MakeTestDirectory("AssetStreamerCancel");
+	AssetStreamer streamer;
+	REQUIRE(SUCCEEDED(streamer.init(2)));
+
+	unsigned int callbacks = 0;
+	bool missingFailed = false;
+	const StreamHandle ready = streamer.request(writeTexture(dir, "A.vtex", 4), STREAM_TEXTURE, STREAM_VISIBLE,
+		[&callbacks](StreamedAsset&) { ++callbacks; });
+	const StreamHandle early = streamer.request(writeTexture(dir, "B.vtex", 4), STREAM_TEXTURE, STREAM_PREFETCH,
+		[&callbacks](StreamedAsset&) { ++callbacks; });
+	const StreamHandle missing = streamer.request((dir / "Missing.vtex").string(), STREAM_TEXTURE, STREAM_VISIBLE,
+		[&missingFailed](StreamedAsset& asset) { missingFailed = !asset.success; });
+
+	// Cancelar en cualquier etapa (cola, lectura o decodificación) evita el callback.
+	CHECK(streamer.cancel(early));
+	CHECK(streamer.getState(early) == STREAM_INVALID);
+	CHECK(!streamer.cancel(early));
+
+	// Cancelar un asset ya decodificado lo quita de la lista de subida.
+	REQUIRE(waitUntilReady(streamer, ready));
+	CHECK(streamer.cancel(ready));
+	REQUIRE(waitUntilReady(streamer, missing));
+	streamer.update(0, 0.0);
+	CHECK(callbacks == 0);
+	CHECK(missingFailed);
+	CHECK(streamer.getState(missing) == STREAM_INVALID);
+	CHECK(!streamer.cancel(missing));
+	CHECK(!streamer.cancel(12345));
+
+	// La cancelada en vuelo se descarta cuando su trabajador termina y el streamer queda vacío.
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (!streamer.isIdle() && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK(streamer.isIdle());
+	streamer.update(0, 0.0);
+	CHECK(callbacks == 0);
+	const StreamingStats stats = streamer.getStats();
+	CHECK(stats.canceled == 2);
+	CHECK(stats.failed == 1);
+	CHECK(stats.resident == 0);
+	CHECK(stats.queued == 0);
+
+	streamer.destroy();
+	CHECK(streamer.request((dir / "A.vtex").string(), STREAM_TEXTURE, STREAM_VISIBLE, nullptr) == 0);
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
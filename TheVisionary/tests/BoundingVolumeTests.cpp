@@ -0,0 +1,157 @@
+﻿/**
+ * @file BoundingVolumeTests.cpp
+ * @brief Pruebas de BoundingVolume contra el recorrido directo de los vértices: AABB, esfera, paso a mundo y unión.
+ */
+
+#include "TestFramework.h"
+#include "BoundingVolume.h"
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+namespace {
+	/// Nube alargada y desplazada del origen; un número impar de vértices pasa por el resto de la reducción.
+	std::vector<SimpleVertex>
+	makeCloud(size_t count, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<SimpleVertex> vertices(count);
+		for (SimpleVertex& vertex : vertices) {
+			vertex.Pos = XMFLOAT3(5.0f + 8.0f * unit(rng), -3.0f + 2.0f * unit(rng), 1.0f + 0.5f * unit(rng));
+			vertex.Tex = XMFLOAT2(unit(rng), unit(rng));
+		}
+		return vertices;
+	}
+
+	/// true si el punto está en la caja (con tolerancia absoluta).
+	bool
+	insideBox(const MeshBounds& bounds, const XMFLOAT3& p, float tolerance) {
+		return std::fabs(p.x - bounds.center.x) <= bounds.extents.x + tolerance
+			&& std::fabs(p.y - bounds.center.y) <= bounds.extents.y + tolerance
+			&& std::fabs(p.z - bounds.center.z) <= bounds.extents.z + tolerance;
+	}
+
+	/// true si el punto está en la esfera (con tolerancia absoluta).
+	bool
+	insideSphere(const XMFLOAT4& sphere, const XMFLOAT3& p, float tolerance) {
+		const float dx = p.x - sphere.x, dy = p.y - sphere.y, dz = p.z - sphere.z;
+		return std::sqrt(dx * dx + dy * dy + dz * dz) <= sphere.w + tolerance;
+	}
+
+	MeshBounds
+	makeBounds(const XMFLOAT3& center, const XMFLOAT3& extents, float radius) {
+		MeshBounds bounds;
+		bounds.center = center;
+		bounds.extents = extents;
+		bounds.sphere = XMFLOAT4(center.x, center.y, center.z, radius);
+		return bounds;
+	}
+}
+
+TEST_CASE(BoundingVolume_ComputeMatchesBruteForce) {
+	CHECK(BoundingVolume::compute({}).isEmpty());
+
+	const std::vector<SimpleVertex> vertices = makeCloud(1001, 3);
+	XMFLOAT3 minimum(FLT_MAX, FLT_MAX, FLT_MAX), maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const SimpleVertex& vertex : vertices) {
+		minimum = XMFLOAT3(std::min(minimum.x, vertex.Pos.x), std::min(minimum.y, vertex.Pos.y), std::min(minimum.z, vertex.Pos.z));
+		maximum = XMFLOAT3(std::max(maximum.x, vertex.Pos.x), std::max(maximum.y, vertex.Pos.y), std::max(maximum.z, vertex.Pos.z));
+	}
+
+	// La reducción vectorial da exactamente el mismo min/max (sin redondeo de por medio).
+	XMFLOAT3 low, high;
+	BoundingVolume::computeAABB(vertices, low, high);
+	CHECK(low.x == minimum.x && low.y == minimum.y && low.z == minimum.z);
+	CHECK(high.x == maximum.x && high.y == maximum.y && high.z == maximum.z);
+
+	const MeshBounds bounds = BoundingVolume::compute(vertices);
+	REQUIRE(!bounds.isEmpty());
+	CHECK(NearlyEqual(bounds.center.x, (minimum.x + maximum.x) * 0.5f, 1e-5f));
+	CHECK(NearlyEqual(bounds.extents.y, (maximum.y - minimum.y) * 0.5f, 1e-5f));
+	CHECK(NearlyEqual(bounds.extents.z, (maximum.z - minimum.z) * 0.5f, 1e-5f));
+
+	// La esfera contiene todos los vértices, no es más pequeña que medio eje mayor
+	// y no es más grande que la esfera centrada en la caja.
+	float boxRadius = 0.0f;
+	for (const SimpleVertex& vertex : vertices) {
+		CHECK(insideBox(bounds, vertex.Pos, 1e-5f));
+		CHECK(insideSphere(bounds.sphere, vertex.Pos, 0.0f));
+		const float dx = vertex.Pos.x - bounds.center.x, dy = vertex.Pos.y - bounds.center.y, dz = vertex.Pos.z - bounds.center.z;
+		boxRadius = std::max(boxRadius, std::sqrt(dx * dx + dy * dy + dz * dz));
+	}
+	CHECK(bounds.sphere.w >= bounds.extents.x);
+	CHECK(bounds.sphere.w <= boxRadius * 1.0001f);
+
+	// Ritter por separado también contiene la nube.
+	const XMFLOAT4 ritter = BoundingVolume::computeRitterSphere(vertices, minimum, maximum);
+	for (const SimpleVertex& vertex : vertices) {
+		CHECK(insideSphere(ritter, vertex.Pos, 0.0f));
+	}
+
+	// Un solo vértice: caja y esfera degeneradas, pero no vacías.
+	const MeshBounds single = BoundingVolume::compute(std::vector<SimpleVertex>(vertices.begin(), vertices.begin() + 1));
+	CHECK(!single.isEmpty());
+	CHECK(single.extents.x == 0.0f && single.extents.y == 0.0f && single.extents.z == 0.0f);
+	CHECK(insideSphere(single.sphere, vertices[0].Pos, 1e-5f));
+}
+
+TEST_CASE(BoundingVolume_TransformContainsTransformedVertices) {
+	const std::vector<SimpleVertex> vertices = makeCloud(257, 11);
+	const MeshBounds local = BoundingVolume::compute(vertices);
+
+	// Escala no uniforme, giro sobre dos ejes y traslación.
+	const XMMATRIX world = XMMatrixScaling(2.0f, 0.5f, 3.0f) * XMMatrixRotationRollPitchYaw(0.4f, 1.1f, -0.3f)
+		* XMMatrixTranslation(-7.0f, 4.0f, 12.0f);
+	const MeshBounds worldBounds = BoundingVolume::transform(local, world);
+	REQUIRE(!worldBounds.isEmpty());
+
+	std::vector<SimpleVertex> moved = vertices;
+	for (SimpleVertex& vertex : moved) {
+		XMStoreFloat3(&vertex.Pos, XMVector3TransformCoord(XMLoadFloat3(&vertex.Pos), world));
+		CHECK(insideBox(worldBounds, vertex.Pos, 1e-4f));
+		CHECK(insideSphere(worldBounds.sphere, vertex.Pos, 1e-4f));
+	}
+
+	// La caja transformada es conservadora: envuelve la caja exacta de los vértices movidos.
+	const MeshBounds exact = BoundingVolume::compute(moved);
+	CHECK(worldBounds.extents.x + 1e-4f >= exact.extents.x);
+	CHECK(worldBounds.extents.y + 1e-4f >= exact.extents.y);
+	CHECK(worldBounds.extents.z + 1e-4f >= exact.extents.z);
+
+	// Sólo traslación: caja y esfera se desplazan sin cambiar de tamaño.
+	const MeshBounds shifted = BoundingVolume::transform(local, XMMatrixTranslation(1.0f, 2.0f, 3.0f));
+	CHECK(NearlyEqual(shifted.center.x, local.center.x + 1.0f, 1e-5f));
+	CHECK(NearlyEqual(shifted.sphere.z, local.sphere.z + 3.0f, 1e-5f));
+	CHECK(NearlyEqual(shifted.extents.y, local.extents.y, 1e-5f));
+	CHECK(NearlyEqual(shifted.sphere.w, local.sphere.w, 1e-5f));
+
+	CHECK(BoundingVolume::transform(MeshBounds(), world).isEmpty());
+}
+
+TEST_CASE(BoundingVolume_MergeContainsBothVolumes) {
+	const MeshBounds a = makeBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), 1.8f);
+	const MeshBounds b = makeBounds(XMFLOAT3(10.0f, 2.0f, -1.0f), XMFLOAT3(2.0f, 0.5f, 1.0f), 2.3f);
+
+	const MeshBounds merged = BoundingVolume::merge(a, b);
+	CHECK(NearlyEqual(merged.center.x, 5.5f, 1e-5f));
+	CHECK(NearlyEqual(merged.extents.x, 6.5f, 1e-5f));
+	CHECK(NearlyEqual(merged.center.y, 0.75f, 1e-5f));
+	CHECK(NearlyEqual(merged.extents.y, 1.75f, 1e-5f));
+	CHECK(NearlyEqual(merged.extents.z, 1.5f, 1e-5f));
+
+	// La esfera unida es la mínima: toca el punto más lejano de cada esfera.
+	const float distance = std::sqrt(100.0f + 4.0f + 1.0f);
+	CHECK(NearlyEqual(merged.sphere.w, (distance + a.sphere.w + b.sphere.w) * 0.5f, 1e-4f));
+	for (const MeshBounds* part : { &a, &b }) {
+		const float dx = part->sphere.x - merged.sphere.x, dy = part->sphere.y - merged.sphere.y, dz = part->sphere.z - merged.sphere.z;
+		CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) + part->sphere.w <= merged.sphere.w + 1e-4f);
+	}
+
+	// Una esfera dentro de la otra se queda con la grande; un volumen vacío no cuenta.
+	const MeshBounds inner = makeBounds(XMFLOAT3(0.5f, 0.0f, 0.0f), XMFLOAT3(0.2f, 0.2f, 0.2f), 0.3f);
+	CHECK(BoundingVolume::merge(a, inner).sphere.w == a.sphere.w);
+	CHECK(BoundingVolume::merge(inner, a).sphere.w == a.sphere.w);
+	CHECK(BoundingVolume::merge(MeshBounds(), b).center.x == b.center.x);
+	CHECK(BoundingVolume::merge(a, MeshBounds()).sphere.w == a.sphere.w);
+	CHECK(BoundingVolume::merge(MeshBounds(), MeshBounds()).isEmpty());
+}
@@ -0,0 +1,279 @@
+﻿/**
+ * @file CommandStreamTests.cpp
+ * @brief Pruebas del stream de comandos: codificación, archivo de captura y reproducción sin GPU.
+ */
+
+#include "TestFramework.h"
+#include "TestFiles.h"
+#include "CommandReplay.h"
+#include "NullBackend.h"
+#include <climits>
+
+namespace fs = std::filesystem;
+
+namespace {
+	/// NullBackend que además graba los datos de UpdateSubresource (como una captura).
+	class ContentRecorder : public NullBackend {
+	public:
+		ContentRecorder() { m_recordContents = true; }
+	};
+
+	/// Asas de los frames de prueba.
+	struct StreamObjects {
+		ID3D11Buffer* vertexBuffer = nullptr;
+		ID3D11Buffer* constantBuffer = nullptr;
+		ID3D11Buffer* dynamicBuffer = nullptr;
+		ID3D11PixelShader* pixelShader = nullptr;
+		ID3D11BlendState* blendState = nullptr;
+		ID3D11DepthStencilView* depthStencil = nullptr;
+	};
+
+	StreamObjects
+	makeObjects(NullBackend& backend) {
+		StreamObjects objects;
+		objects.vertexBuffer = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, 4096, 1);
+		objects.constantBuffer = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, 64, 4);
+		objects.dynamicBuffer = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, 256, 4);
+		objects.pixelShader = backend.createResource<ID3D11PixelShader>(RESOURCE_PIXEL_SHADER);
+		objects.blendState = backend.createResource<ID3D11BlendState>(RESOURCE_BLEND_STATE);
+		objects.depthStencil = backend.createResource<ID3D11DepthStencilView>(RESOURCE_DEPTH_STENCIL_VIEW);
+		return objects;
+	}
+
+	ID3D11Resource*
+	asResource(ID3D11Buffer* buffer) {
+		return reinterpret_cast<ID3D11Resource*>(buffer);
+	}
+
+	/// Frames con casi todos los tipos de argumento: floats, cajas, datos, negativos y Map/Unmap.
+	void
+	recordFrames(NullBackend& backend, const StreamObjects& objects, unsigned int frames) {
+		for (unsigned int frame = 0; frame < frames; ++frame) {
+			backend.beginFrame();
+			BackendViewport viewports[2];
+			viewports[0].Width = 1280.0f;
+			viewports[0].Height = 720.0f;
+			viewports[1].TopLeftX = 0.5f;
+			viewports[1].MaxDepth = 0.25f;
+			backend.RSSetViewports(2, viewports);
+			backend.ClearDepthStencilView(objects.depthStencil, 3, 1.0f, 255);
+
+			const unsigned int stride = 32, offset = 64;
+			backend.IASetVertexBuffers(0, 1, &objects.vertexBuffer, &stride, &offset);
+			backend.PSSetShader(objects.pixelShader, nullptr, 0);
+			const float factor[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+			backend.OMSetBlendState(objects.blendState, factor, 0xffffffff);
+
+			float constants[16] = {};
+			constants[0] = static_cast<float>(frame);
+			BackendBox box;
+			box.right = sizeof(constants);
+			box.bottom = 1;
+			box.back = 1;
+			backend.UpdateSubresource(asResource(objects.constantBuffer), 0, &box, constants, 0, 0, sizeof(constants));
+
+			BackendMappedSubresource mapped;
+			if (!isBackendFailure(backend.Map(asResource(objects.dynamicBuffer), 0,
+				frame == 0 ? BACKEND_MAP_WRITE_DISCARD : BACKEND_MAP_WRITE_NO_OVERWRITE, 0, &mapped))) {
+				static_cast<uint8_t*>(mapped.pData)[frame] = static_cast<uint8_t>(frame + 1);
+				backend.Unmap(asResource(objects.dynamicBuffer), 0);
+			}
+
+			backend.DrawIndexed(36, 6, -4);
+			backend.DrawIndexedInstanced(12, 5, 0, 100000, 7);
+		}
+	}
+}
+
+TEST_CASE(CommandStream_WriterAndReaderRoundTripValues) {
+	CommandWriter writer;
+	const uint32_t unsignedValues[] = { 0u, 1u, 127u, 128u, 16383u, 16384u, 0xFFFFFFFFu };
+	const int32_t signedValues[] = { 0, -1, 1, -64, 64, INT_MIN, INT_MAX };
+	for (uint32_t value : unsignedValues) {
+		writer.u32(value);
+	}
+	for (int32_t value : signedValues) {
+		writer.i32(value);
+	}
+	writer.f32(-0.0f);
+	writer.f32(3.5e-7f);
+	// Varint de 1 byte por debajo de 128; zigzag deja los negativos pequeños en 1 byte.
+	CommandWriter small;
+	small.u32(127);
+	small.i32(-64);
+	CHECK(small.size() == 2);
+
+	CommandReader reader(writer.getData().data(), writer.size());
+	for (uint32_t value : unsignedValues) {
+		CHECK(reader.u32() == value);
+	}
+	for (int32_t value : signedValues) {
+		CHECK(reader.i32() == value);
+	}
+	CHECK(reader.f32() == 0.0f);
+	CHECK(reader.f32() == 3.5e-7f);
+	CHECK(reader.atEnd());
+	CHECK(!reader.failed());
+
+	// Leer de más falla en lugar de salirse del bloque.
+	CHECK(reader.u32() == 0);
+	CHECK(reader.failed());
+	const uint8_t unterminated[] = { 0x80, 0x80 };
+	CommandReader cut(unterminated, sizeof(unterminated));
+	cut.u32();
+	CHECK(cut.failed());
+}
+
+TEST_CASE(CommandStream_DecodesRecordedCommandsInOrder) {
+	ContentRecorder backend;
+	const StreamObjects objects = makeObjects(backend);
+	recordFrames(backend, objects, 1);
+	const std::vector<uint8_t>& stream = backend.getStream();
+
+	const CommandOp expected[] = {
+		CMD_FRAME, CMD_RS_SET_VIEWPORTS, CMD_RESOURCE, CMD_CLEAR_DEPTH_STENCIL_VIEW,
+		CMD_RESOURCE, CMD_IA_SET_VERTEX_BUFFERS, CMD_RESOURCE, CMD_PS_SET_SHADER,
+		CMD_RESOURCE, CMD_OM_SET_BLEND_STATE, CMD_RESOURCE, CMD_UPDATE_SUBRESOURCE,
+		CMD_RESOURCE, CMD_MAP, CMD_UNMAP, CMD_DRAW_INDEXED, CMD_DRAW_INDEXED_INSTANCED
+	};
+	std::vector<CommandRecord> records;
+	CommandReader reader(stream.data(), stream.size());
+	CommandRecord record;
+	while (decodeCommand(reader, record)) {
+		records.push_back(record);
+	}
+	CHECK(reader.atEnd() && !reader.failed());
+	REQUIRE(records.size() == sizeof(expected) / sizeof(expected[0]));
+	for (size_t i = 0; i < records.size(); ++i) {
+		CHECK(records[i].op == expected[i]);
+	}
+
+	// Viewports: count y seis floats por viewport.
+	CHECK(records[1].args[0] == 2);
+	CHECK(records[1].getFloat(3) == 1280.0f);
+	CHECK(records[1].getFloat(7) == 0.5f);
+	CHECK(records[1].getFloat(12) == 0.25f);
+	// Recurso: id, tipo, bytes y flags de createResource().
+	CHECK(records[2].args[0] == 1);
+	CHECK(records[2].args[1] == RESOURCE_DEPTH_STENCIL_VIEW);
+	CHECK(records[4].args[1] == RESOURCE_BUFFER && records[4].args[2] == 4096 && records[4].args[3] == 1);
+	// Depth-stencil: id, flags, profundidad y stencil.
+	CHECK(records[3].args[0] == 1 && records[3].args[1] == 3);
+	CHECK(records[3].getFloat(2) == 1.0f && records[3].args[3] == 255);
+	// Vertex buffer: start, count, (id, stride, offset).
+	CHECK(records[5].args[2] == 2 && records[5].args[3] == 32 && records[5].args[4] == 64);
+	CHECK(records[9].getFloat(3) == 0.75f && records[9].args[5] == 0xffffffffu);
+	// UpdateSubresource: caja y los 64 bytes de datos dentro del stream.
+	const CommandRecord& update = records[11];
+	CHECK(update.args[2] == 64);
+	CHECK(update.args[5] == 1 && update.args[9] == 64);
+	CHECK(update.args.back() == 64);
+	REQUIRE(update.blobs.size() == 1);
+	CHECK(update.blobs[0] >= stream.data() && update.blobs[0] + 64 <= stream.data() + stream.size());
+	CHECK(records[13].args[2] == BACKEND_MAP_WRITE_DISCARD);
+	// Draws: el base vertex negativo vuelve como su valor con signo.
+	CHECK(records[15].args[0] == 36 && records[15].args[1] == 6);
+	CHECK(static_cast<int32_t>(records[15].args[2]) == -4);
+	CHECK(records[16].args[1] == 5 && records[16].args[3] == 100000 && records[16].args[4] == 7);
+
+	// Un código desconocido o un comando cortado detienen la lectura.
+	std::vector<uint8_t> unknown = stream;
+	unknown.push_back(COMMAND_OP_COUNT);
+	CHECK(!analyzeCommandStream(unknown).valid);
+	std::vector<uint8_t> cut(stream.begin(), stream.end() - 1);
+	CHECK(!analyzeCommandStream(cut).valid);
+	CHECK(analyzeCommandStream(stream).valid);
+}
+
+TEST_CASE(CommandStream_CaptureFileRoundTripsAndRejectsDamage) {
+	const fs::path dir = MakeTestDirectory("CommandStreamFile");
+	ContentRecorder backend;
+	recordFrames(backend, makeObjects(backend), 3);
+	const CommandStreamStats recorded = analyzeCommandStream(backend.getStream());
+	REQUIRE(recorded.valid);
+
+	CaptureFileHeader header;
+	header.frames = recorded.frames;
+	header.resources = recorded.resources;
+	const std::string path = (dir / "Nested" / "Frames.vcap").string();
+	REQUIRE(writeCaptureFile(path, header, backend.getStream()));
+
+	CaptureFileHeader loaded;
+	std::vector<uint8_t> stream;
+	std::string error;
+	REQUIRE(readCaptureFile(path, loaded, stream, error));
+	CHECK(loaded.version == kCaptureFileVersion);
+	CHECK(loaded.frames == 3);
+	CHECK(loaded.resources == recorded.resources);
+	CHECK(loaded.streamBytes == backend.getStream().size());
+	CHECK(stream == backend.getStream());
+
+	// Cada daño se rechaza con su motivo y sin dar el stream por bueno.
+	const std::string bytes = ReadTestFile(path);
+	const fs::path damaged = dir / "Damaged.vcap";
+	auto rejects = [&](const std::string& contents, const std::string& reason) {
+		WriteTestFile(damaged, contents);
+		error.clear();
+		const bool read = readCaptureFile(damaged.string(), loaded, stream, error);
+		return !read && error.find(reason) != std::string::npos;
+	};
+	CHECK(rejects(bytes.substr(0, bytes.size() - 5), "truncated"));
+	CHECK(rejects(bytes + "extra", "truncated"));
+	CHECK(rejects(bytes.substr(0, 10), "too small"));
+	std::string magic = bytes;
+	magic[0] = 'X';
+	CHECK(rejects(magic, "not a capture"));
+	std::string version = bytes;
+	version[4] = static_cast<char>(kCaptureFileVersion + 1);
+	CHECK(rejects(version, "version"));
+	CHECK(!readCaptureFile((dir / "Missing.vcap").string(), loaded, stream, error));
+
+	// Un stream con bytes cambiados se lee, pero su análisis lo marca como no válido.
+	std::string corrupt = bytes;
+	corrupt[corrupt.size() - 12] = static_cast<char>(0xFF);
+	WriteTestFile(damaged, corrupt);
+	REQUIRE(readCaptureFile(damaged.string(), loaded, stream, error));
+	CHECK(!analyzeCommandStream(stream).valid);
+	CHECK(!replayHeadless(stream, 1).valid);
+
+	std::error_code removeError;
+	fs::remove_all(dir, removeError);
+}
+
+TEST_CASE(CommandReplay_CallCountsMatchRecording) {
+	ContentRecorder backend;
+	recordFrames(backend, makeObjects(backend), 4);
+	const CommandStreamStats recorded = analyzeCommandStream(backend.getStream());
+	REQUIRE(recorded.valid);
+
+	const unsigned int repeats = 3;
+	const ReplayStats replayed = replayHeadless(backend.getStream(), repeats);
+	CHECK(replayed.valid);
+	CHECK(replayed.repeats == repeats);
+	CHECK(replayed.frames == recorded.frames * repeats);
+	CHECK(replayed.missing == 0);
+	for (unsigned int op = CMD_CLEAR_STATE; op < COMMAND_OP_COUNT; ++op) {
+		CHECK(replayed.calls[op].count == recorded.counts[op] * repeats);
+	}
+
+	// Reproducido sobre otro NullBackend, el stream que sale cuenta lo mismo que el original.
+	NullBackend target;
+	const std::vector<StreamResource> resources = listStreamResources(backend.getStream());
+	REQUIRE(resources.size() == recorded.resources);
+	std::vector<void*> handles;
+	for (const StreamResource& resource : resources) {
+		handles.push_back(target.createResource<void>(resource.kind, resource.bytes, resource.flags));
+	}
+	CommandReplayer replayer(target, handles);
+	REQUIRE(replayer.replay(backend.getStream()).valid);
+	const CommandStreamStats again = analyzeCommandStream(target.getStream());
+	REQUIRE(again.valid);
+	CHECK(again.resources == recorded.resources);
+	CHECK(again.draws == recorded.draws);
+	CHECK(again.indices == recorded.indices);
+	CHECK(again.binds == recorded.binds);
+	CHECK(again.uploadBytes == recorded.uploadBytes);
+	for (unsigned int op = CMD_CLEAR_STATE; op < COMMAND_OP_COUNT; ++op) {
+		CHECK(again.counts[op] == recorded.counts[op]);
+	}
+}
@@ -0,0 +1,164 @@
+﻿/**
+ * @file ConstantBufferRingTests.cpp
+ * @brief Pruebas del reparto por frames de ConstantRingAllocator y de los bytes subidos por ConstantBufferRing.
+ */
+
+#include "TestFramework.h"
+#include "ConstantBufferRing.h"
+#include <random>
+
+TEST_CASE(ConstantRingAllocator_AlignsAndFreesAfterFramesInFlight) {
+	const unsigned int kBlock = ConstantRingAllocator::kAlignment;
+	ConstantRingAllocator ring;
+	ring.init(8 * kBlock + 100);
+	CHECK(ring.getCapacity() == 8 * kBlock);
+	CHECK(ConstantRingAllocator::align(1) == kBlock);
+	CHECK(ConstantRingAllocator::align(kBlock) == kBlock);
+
+	// Dos bloques por frame: el anillo se llena en cuatro frames.
+	unsigned int offset = 0;
+	for (unsigned int frame = 0; frame < ConstantRingAllocator::kFramesInFlight; ++frame) {
+		if (frame > 0) {
+			ring.beginFrame();
+		}
+		for (int i = 0; i < 2; ++i) {
+			REQUIRE(ring.allocate(64, offset));
+			CHECK(offset % kBlock == 0);
+			CHECK(offset + kBlock <= ring.getCapacity());
+		}
+	}
+	CHECK(ring.getUsed() == 8 * kBlock);
+	// Lleno: falla sin tocar nada.
+	CHECK(!ring.allocate(64, offset));
+	CHECK(ring.getUsed() == 8 * kBlock);
+
+	// El frame siguiente libera el más antiguo y su espacio vuelve a estar disponible.
+	ring.beginFrame();
+	CHECK(ring.getUsed() == 6 * kBlock);
+	CHECK(ring.allocate(2 * kBlock, offset));
+	CHECK(offset == 0);
+	CHECK(ring.getFrameBytes() == 2 * kBlock);
+}
+
+TEST_CASE(ConstantRingAllocator_ConstantRangesAreAlignedSixteenConstantUnits) {
+	const unsigned int kBlock = ConstantRingAllocator::kAlignment;
+	ConstantRingAllocator ring;
+	ring.init(8 * kBlock);
+
+	// CBChangesEveryFrame (80 bytes) ocupa un bloque entero: 16 constantes.
+	unsigned int offset = 0, first = 0, count = 0;
+	REQUIRE(ring.allocateConstants(sizeof(CBChangesEveryFrame), offset, first, count));
+	CHECK(offset == 0);
+	CHECK(first == 0);
+	CHECK(count == 16);
+	// Un byte más de un bloque son dos bloques; el siguiente empieza en la constante 16.
+	REQUIRE(ring.allocateConstants(kBlock + 1, offset, first, count));
+	CHECK(first == 16);
+	CHECK(count == 32);
+	REQUIRE(ring.allocateConstants(16, offset, first, count));
+	CHECK(first == 48);
+	CHECK(count == 16);
+	CHECK(first * 16 == offset);
+	// Cero bytes o más que el anillo no se asignan ni tocan la ocupación.
+	CHECK(!ring.allocateConstants(0, offset, first, count));
+	CHECK(!ring.allocateConstants(9 * kBlock, offset, first, count));
+	CHECK(ring.getUsed() == 4 * kBlock);
+}
+
+TEST_CASE(ConstantRingAllocator_WrapsAroundAndChargesTheGap) {
+	const unsigned int kBlock = ConstantRingAllocator::kAlignment;
+	ConstantRingAllocator ring;
+	ring.init(8 * kBlock);
+	unsigned int offset = 0, first = 0, count = 0;
+
+	// Frame 0: [0, 3); frame 1: [3, 7). Queda un bloque al final.
+	for (int i = 0; i < 3; ++i) {
+		REQUIRE(ring.allocate(kBlock, offset));
+	}
+	ring.beginFrame();
+	REQUIRE(ring.allocate(4 * kBlock, offset));
+	CHECK(offset == 3 * kBlock);
+
+	// Dos bloques no caben al final ni al principio mientras el frame 0 sigue en vuelo.
+	for (unsigned int frame = 2; frame < ConstantRingAllocator::kFramesInFlight; ++frame) {
+		ring.beginFrame();
+		CHECK(!ring.allocate(2 * kBlock, offset));
+		CHECK(ring.getUsed() == 7 * kBlock);
+	}
+
+	// Al retirarse el frame 0 se da la vuelta y el hueco del final se carga a este frame.
+	ring.beginFrame();
+	CHECK(ring.getUsed() == 4 * kBlock);
+	REQUIRE(ring.allocateConstants(2 * kBlock, offset, first, count));
+	CHECK(offset == 0);
+	CHECK(first == 0);
+	CHECK(count == 32);
+	CHECK(ring.getFrameBytes() == 3 * kBlock);
+	CHECK(ring.getUsed() == 7 * kBlock);
+
+	// Tras dar la vuelta solo queda [2, 3): un bloque cabe, dos no.
+	CHECK(!ring.allocate(2 * kBlock, offset));
+	REQUIRE(ring.allocate(kBlock, offset));
+	CHECK(offset == 2 * kBlock);
+	CHECK(!ring.allocate(1, offset));
+}
+
+TEST_CASE(ConstantRingAllocator_NeverOverlapsFramesInFlight) {
+	const unsigned int kBlock = ConstantRingAllocator::kAlignment;
+	const unsigned int kCapacity = 64 * kBlock;
+	ConstantRingAllocator ring;
+	ring.init(kCapacity);
+
+	// Bloques vivos de cada frame en vuelo, para compararlos con cada asignación nueva.
+	struct Block {
+		unsigned int offset;
+		unsigned int size;
+	};
+	std::vector<std::vector<Block>> inFlight(ConstantRingAllocator::kFramesInFlight);
+	std::mt19937 rng(8);
+	unsigned int allocations = 0, failures = 0, overlaps = 0, misaligned = 0;
+	for (unsigned int frame = 0; frame < 400; ++frame) {
+		if (frame > 0) {
+			ring.beginFrame();
+		}
+		std::vector<Block>& current = inFlight[frame % ConstantRingAllocator::kFramesInFlight];
+		current.clear();
+		const unsigned int draws = rng() % 24;
+		for (unsigned int d = 0; d < draws; ++d) {
+			const unsigned int size = 16 + rng() % (3 * kBlock);
+			unsigned int offset = 0, first = 0, count = 0;
+			if (!ring.allocateConstants(size, offset, first, count)) {
+				++failures;
+				continue;
+			}
+			++allocations;
+			const Block block{ offset, ConstantRingAllocator::align(size) };
+			misaligned += (offset % kBlock != 0 || first * 16 != offset || count * 16 != block.size ||
+				offset + block.size > kCapacity) ? 1 : 0;
+			for (const std::vector<Block>& blocks : inFlight) {
+				for (const Block& other : blocks) {
+					overlaps += (block.offset < other.offset + other.size && other.offset < block.offset + block.size) ? 1 : 0;
+				}
+			}
+			current.push_back(block);
+		}
+		CHECK(ring.getUsed() <= kCapacity);
+	}
+	CHECK(overlaps == 0);
+	CHECK(misaligned == 0);
+	// La carga está por encima de la capacidad a ratos: hay que haber dado la vuelta y rechazado algo.
+	CHECK(allocations > 1000);
+	CHECK(failures > 0);
+}
+
+TEST_CASE(ConstantBufferRing_BenchmarkUploadsLessThanNaive) {
+	const unsigned int drawCounts[] = { 8, 1000, 10000 };
+	for (unsigned int draws : drawCounts) {
+		const ConstantRingBenchmark bench = ConstantBufferRing::benchmark(draws, 60);
+		CHECK(bench.draws == draws);
+		CHECK(bench.frames == 60);
+		CHECK(bench.ringFallbacks == 0);
+		CHECK(bench.trackedBytes < bench.naiveBytes);
+		CHECK(bench.ringBytes < bench.naiveBytes);
+	}
+}
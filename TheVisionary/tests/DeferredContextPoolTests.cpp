@@ -0,0 +1,114 @@
+﻿/**
+ * @file DeferredContextPoolTests.cpp
+ * @brief Pruebas del reparto de la cola ordenada en tramos para los contextos diferidos.
+ */
+
+#include "TestFramework.h"
+#include "DeferredContextPool.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+	/// true si los tramos son contiguos, en orden, no vacíos y cubren [0, count).
+	bool
+	coversInOrder(const std::vector<SubmitChunk>& chunks, unsigned int count) {
+		unsigned int next = 0;
+		for (const SubmitChunk& chunk : chunks) {
+			if (chunk.begin != next || chunk.end <= chunk.begin) {
+				return false;
+			}
+			next = chunk.end;
+		}
+		return next == count;
+	}
+
+	uint64_t
+	chunkCost(const std::vector<unsigned int>& costs, const SubmitChunk& chunk) {
+		uint64_t cost = 0;
+		for (unsigned int i = chunk.begin; i < chunk.end; ++i) {
+			cost += costs[i];
+		}
+		return cost;
+	}
+}
+
+TEST_CASE(DeferredContextPool_PartitionCoversQueueInOrder) {
+	std::vector<SubmitChunk> chunks;
+	DeferredContextPool::partition({}, 4, 256, chunks);
+	CHECK(chunks.empty());
+
+	// Coste uniforme: tramos iguales.
+	std::vector<unsigned int> costs(4096, 1);
+	DeferredContextPool::partition(costs, 4, 256, chunks);
+	REQUIRE(chunks.size() == 4);
+	CHECK(coversInOrder(chunks, 4096));
+	for (const SubmitChunk& chunk : chunks) {
+		CHECK(chunk.end - chunk.begin == 1024);
+	}
+
+	// Un tramo o ninguno pedido: toda la cola en uno.
+	for (unsigned int parts : { 0u, 1u }) {
+		DeferredContextPool::partition(costs, parts, 256, chunks);
+		REQUIRE(chunks.size() == 1);
+		CHECK(chunks[0].begin == 0 && chunks[0].end == 4096);
+	}
+
+	// Pocas entradas: no se abren más tramos de los que llenan minChunk; el último se queda el resto.
+	costs.assign(300, 1);
+	DeferredContextPool::partition(costs, 8, 256, chunks);
+	REQUIRE(chunks.size() == 2);
+	CHECK(chunks[0].begin == 0 && chunks[0].end == 256);
+	CHECK(chunks[1].begin == 256 && chunks[1].end == 300);
+	DeferredContextPool::partition(costs, 8, 0, chunks);
+	CHECK(chunks.size() == 8);
+	CHECK(coversInOrder(chunks, 300));
+
+	// Una entrada muy cara al principio: los primeros tramos se cortan en minChunk.
+	costs.assign(4096, 1);
+	costs[0] = 10000;
+	DeferredContextPool::partition(costs, 4, 256, chunks);
+	REQUIRE(chunks.size() == 4);
+	CHECK(chunks[0].end == 256);
+	CHECK(chunks[1].end == 512);
+	CHECK(chunks[2].end == 768);
+	CHECK(chunks[3].end == 4096);
+}
+
+TEST_CASE(DeferredContextPool_PartitionBalancesRandomCosts) {
+	std::mt19937 rng(8);
+	std::uniform_int_distribution<unsigned int> draws(1, 16);
+	for (unsigned int count : { 1u, 255u, 257u, 2000u, 20000u }) {
+		std::vector<unsigned int> costs(count);
+		uint64_t total = 0;
+		unsigned int maxCost = 0;
+		for (unsigned int& cost : costs) {
+			cost = draws(rng);
+			total += cost;
+			maxCost = std::max(maxCost, cost);
+		}
+		for (unsigned int parts = 1; parts <= DeferredContextPool::kMaxContexts; ++parts) {
+			std::vector<SubmitChunk> chunks;
+			DeferredContextPool::partition(costs, parts, DeferredContextPool::kMinChunkPackets, chunks);
+			CHECK(coversInOrder(chunks, count));
+			const unsigned int expectedParts = std::min(parts,
+				(count + DeferredContextPool::kMinChunkPackets - 1) / DeferredContextPool::kMinChunkPackets);
+			REQUIRE(chunks.size() == std::max(1u, expectedParts));
+
+			uint64_t covered = 0;
+			for (size_t c = 0; c < chunks.size(); ++c) {
+				const unsigned int size = chunks[c].end - chunks[c].begin;
+				const uint64_t cost = chunkCost(costs, chunks[c]);
+				covered += cost;
+				// Todos menos el último llegan a minChunk; ninguno pasa de su fracción más una entrada
+				// salvo que minChunk le obligue.
+				if (c + 1 < chunks.size()) {
+					CHECK(size >= DeferredContextPool::kMinChunkPackets);
+				}
+				if (size > DeferredContextPool::kMinChunkPackets) {
+					CHECK(cost <= (total + chunks.size() - 1) / chunks.size() + maxCost * 2);
+				}
+			}
+			CHECK(covered == total);
+		}
+	}
+}
@@ -0,0 +1,255 @@
+﻿/**
+ * @file DynamicAABBTreeTests.cpp
+ * @brief Pruebas de DynamicAABBTree contra el recorrido lineal de las cajas tras insertar, mover y eliminar.
+ */
+
+#include "TestFramework.h"
+#include "DynamicAABBTree.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+namespace {
+	/// Caja aleatoria de lado [0.2, 3] dentro de un cubo de 100 de lado.
+	AABB
+	randomBox(std::mt19937& rng) {
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> size(0.2f, 3.0f);
+		AABB box;
+		box.minimum = XMFLOAT3(position(rng), position(rng), position(rng));
+		box.maximum = XMFLOAT3(box.minimum.x + size(rng), box.minimum.y + size(rng), box.minimum.z + size(rng));
+		return box;
+	}
+
+	AABB
+	offsetBox(const AABB& box, float dx, float dy, float dz) {
+		AABB moved;
+		moved.minimum = XMFLOAT3(box.minimum.x + dx, box.minimum.y + dy, box.minimum.z + dz);
+		moved.maximum = XMFLOAT3(box.maximum.x + dx, box.maximum.y + dy, box.maximum.z + dz);
+		return moved;
+	}
+
+	/// Objetos vivos: proxy -> caja ajustada.
+	typedef std::map<int, AABB> LiveObjects;
+
+	/**
+	 * @brief Compara caja, esfera y lotes con el recorrido lineal de las cajas ampliadas,
+	 *        y comprueba que cada caja ampliada contiene la ajustada.
+	 * @return Número de consultas que no coinciden.
+	 */
+	unsigned int
+	countMismatches(const DynamicAABBTree& tree, const LiveObjects& live, std::mt19937& rng) {
+		unsigned int mismatches = 0;
+		for (const auto& object : live) {
+			if (!tree.getFatAABB(object.first).contains(object.second)) {
+				++mismatches;
+			}
+		}
+
+		std::vector<AABB> boxes;
+		std::vector<std::vector<unsigned int>> expected;
+		for (unsigned int q = 0; q < 64; ++q) {
+			AABB query = randomBox(rng);
+			query.maximum = XMFLOAT3(query.maximum.x + 8.0f, query.maximum.y + 8.0f, query.maximum.z + 8.0f);
+			std::vector<unsigned int> brute, sphereBrute, found, sphereFound;
+			const XMFLOAT3 center = query.minimum;
+			const float radius = 6.0f;
+			for (const auto& object : live) {
+				const AABB& fat = tree.getFatAABB(object.first);
+				if (fat.overlaps(query)) {
+					brute.push_back(tree.getUserData(object.first));
+				}
+				// Distancia del centro a la caja ampliada.
+				const float dx = std::max(std::max(fat.minimum.x - center.x, 0.0f), center.x - fat.maximum.x);
+				const float dy = std::max(std::max(fat.minimum.y - center.y, 0.0f), center.y - fat.maximum.y);
+				const float dz = std::max(std::max(fat.minimum.z - center.z, 0.0f), center.z - fat.maximum.z);
+				if (dx * dx + dy * dy + dz * dz <= radius * radius) {
+					sphereBrute.push_back(tree.getUserData(object.first));
+				}
+			}
+			tree.queryAABB(query, found);
+			tree.querySphere(center, radius, sphereFound);
+			std::sort(brute.begin(), brute.end());
+			std::sort(sphereBrute.begin(), sphereBrute.end());
+			std::sort(found.begin(), found.end());
+			std::sort(sphereFound.begin(), sphereFound.end());
+			if (found != brute || sphereFound != sphereBrute) {
+				++mismatches;
+			}
+			boxes.push_back(query);
+			expected.push_back(brute);
+		}
+
+		std::vector<std::vector<unsigned int>> batch;
+		tree.queryAABBBatch(boxes, batch, nullptr);
+		for (size_t q = 0; q < boxes.size(); ++q) {
+			std::sort(batch[q].begin(), batch[q].end());
+			if (batch[q] != expected[q]) {
+				++mismatches;
+			}
+		}
+		return mismatches;
+	}
+}
+
+TEST_CASE(DynamicAABBTree_QueriesMatchBruteForceAfterEdits) {
+	std::mt19937 rng(21);
+	DynamicAABBTree tree(0.1f);
+	LiveObjects live;
+	std::vector<unsigned int> results;
+	tree.queryAABB(randomBox(rng), results);
+	CHECK(results.empty());
+	CHECK(tree.getHeight() == 0);
+
+	unsigned int nextUserData = 0;
+	for (unsigned int i = 0; i < 600; ++i) {
+		const AABB box = randomBox(rng);
+		const int proxy = tree.createProxy(box, nextUserData++);
+		REQUIRE(proxy >= 0);
+		live[proxy] = box;
+	}
+	CHECK(tree.getProxyCount() == 600);
+	CHECK(tree.getHeight() < 24);
+	CHECK(countMismatches(tree, live, rng) == 0);
+
+	// Un movimiento dentro del margen no toca el árbol; uno grande reinserta.
+	const int first = live.begin()->first;
+	const AABB fatBefore = tree.getFatAABB(first);
+	CHECK(!tree.moveProxy(first, offsetBox(live[first], 0.05f, 0.0f, 0.0f)));
+	CHECK(tree.getFatAABB(first).minimum.x == fatBefore.minimum.x);
+	live[first] = offsetBox(live[first], 30.05f, -20.0f, 5.0f);
+	CHECK(tree.moveProxy(first, live[first], XMFLOAT3(1.0f, 0.0f, 0.0f)));
+	// El desplazamiento previsto alarga la caja solo en su sentido.
+	CHECK(tree.getFatAABB(first).maximum.x > live[first].maximum.x + 1.0f);
+	CHECK(tree.getFatAABB(first).minimum.x > live[first].minimum.x - 0.2f);
+	CHECK(countMismatches(tree, live, rng) == 0);
+
+	// Pocos movimientos por lotes: se reinsertan uno a uno.
+	DynamicTreeStats stats;
+	std::vector<ProxyUpdate> updates;
+	unsigned int visited = 0;
+	for (auto it = live.begin(); it != live.end(); ++it) {
+		if (visited++ % 20 == 0) {
+			ProxyUpdate update;
+			update.proxy = it->first;
+			update.aabb = offsetBox(it->second, 4.0f, 0.0f, -3.0f);
+			it->second = update.aabb;
+			updates.push_back(update);
+		}
+	}
+	tree.updateProxies(updates, &stats);
+	CHECK(stats.moved == updates.size());
+	CHECK(stats.reinserted == updates.size());
+	CHECK(!stats.refitted);
+	CHECK(countMismatches(tree, live, rng) == 0);
+
+	// Todos a la vez: se reajusta el árbol sin reinsertar y las consultas siguen siendo exactas.
+	updates.clear();
+	std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+	for (auto& object : live) {
+		ProxyUpdate update;
+		update.proxy = object.first;
+		update.displacement = XMFLOAT3(step(rng), step(rng), step(rng));
+		update.aabb = offsetBox(object.second, update.displacement.x, update.displacement.y, update.displacement.z);
+		object.second = update.aabb;
+		updates.push_back(update);
+	}
+	tree.updateProxies(updates, &stats);
+	CHECK(stats.refitted);
+	CHECK(stats.proxies == 600);
+	CHECK(countMismatches(tree, live, rng) == 0);
+
+	// Eliminación de la mitad; los nodos libres se reutilizan en las nuevas inserciones.
+	std::vector<int> removed;
+	visited = 0;
+	for (auto it = live.begin(); it != live.end();) {
+		if (visited++ % 2 == 1) {
+			tree.destroyProxy(it->first);
+			removed.push_back(it->first);
+			it = live.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	CHECK(tree.getProxyCount() == live.size());
+	CHECK(countMismatches(tree, live, rng) == 0);
+
+	unsigned int reused = 0;
+	for (unsigned int i = 0; i < 50; ++i) {
+		const AABB box = randomBox(rng);
+		const int proxy = tree.createProxy(box, nextUserData++);
+		REQUIRE(live.count(proxy) == 0);
+		reused += std::find(removed.begin(), removed.end(), proxy) != removed.end() ? 1 : 0;
+		live[proxy] = box;
+	}
+	CHECK(reused > 0);
+	CHECK(tree.getProxyCount() == live.size());
+	CHECK(countMismatches(tree, live, rng) == 0);
+
+	for (const auto& object : live) {
+		tree.destroyProxy(object.first);
+	}
+	CHECK(tree.getProxyCount() == 0);
+	results.clear();
+	tree.queryAABB(randomBox(rng), results);
+	CHECK(results.empty());
+}
+
+TEST_CASE(DynamicAABBTree_RaycastMatchesBruteForce) {
+	std::mt19937 rng(5);
+	DynamicAABBTree tree(0.0f);
+	std::vector<AABB> boxes;
+	for (unsigned int i = 0; i < 300; ++i) {
+		boxes.push_back(randomBox(rng));
+		tree.createProxy(boxes.back(), i);
+	}
+
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (unsigned int r = 0; r < 100; ++r) {
+		const XMFLOAT3 origin(60.0f * unit(rng), 60.0f * unit(rng), -70.0f);
+		const XMFLOAT3 direction(0.3f * unit(rng), 0.3f * unit(rng), 1.0f);
+		const float maxDistance = 140.0f;
+
+		// Slab test directo contra cada caja.
+		std::vector<unsigned int> brute;
+		for (unsigned int i = 0; i < boxes.size(); ++i) {
+			const float o[3] = { origin.x, origin.y, origin.z };
+			const float d[3] = { direction.x, direction.y, direction.z };
+			const float lo[3] = { boxes[i].minimum.x, boxes[i].minimum.y, boxes[i].minimum.z };
+			const float hi[3] = { boxes[i].maximum.x, boxes[i].maximum.y, boxes[i].maximum.z };
+			float tMin = 0.0f, tMax = maxDistance;
+			for (int axis = 0; axis < 3; ++axis) {
+				const float t0 = (lo[axis] - o[axis]) / d[axis];
+				const float t1 = (hi[axis] - o[axis]) / d[axis];
+				tMin = std::max(tMin, std::min(t0, t1));
+				tMax = std::min(tMax, std::max(t0, t1));
+			}
+			if (tMin <= tMax) {
+				brute.push_back(i);
+			}
+		}
+
+		std::vector<RayHit> hits;
+		tree.raycast(origin, direction, maxDistance, hits);
+		std::vector<unsigned int> found;
+		for (size_t i = 0; i < hits.size(); ++i) {
+			found.push_back(hits[i].userData);
+			if (i > 0) {
+				CHECK(hits[i - 1].distance <= hits[i].distance);
+			}
+		}
+		std::sort(found.begin(), found.end());
+		CHECK(found == brute);
+
+		// Recortar la distancia al primer impacto deja solo el más cercano.
+		if (!hits.empty()) {
+			float nearest = maxDistance;
+			tree.raycast(origin, direction, maxDistance, [&nearest](unsigned int, float distance) {
+				nearest = std::min(nearest, distance);
+				return nearest;
+			});
+			CHECK(NearlyEqual(nearest, hits.front().distance, 1e-4));
+		}
+	}
+}
@@ -0,0 +1,92 @@
+﻿/**
+ * @file FramePacingTests.cpp
+ * @brief Pruebas del reloj de frame, del acumulador de paso fijo y del objetivo de FramePacer.
+ */
+
+#include "TestFramework.h"
+#include "FramePacing.h"
+
+TEST_CASE(FrameClock_ClampsLongAndBackwardFrames) {
+	FrameClock clock;
+	const FrameClock::Clock::time_point start = FrameClock::Clock::now();
+	CHECK(clock.tick(start) == 0.0);
+	CHECK(NearlyEqual(clock.tick(start + std::chrono::milliseconds(16)), 0.016, 1e-9));
+
+	// Un breakpoint de dos segundos cuenta como kMaxDelta; el tiempo sin recortar se conserva aparte.
+	const FrameClock::Clock::time_point stalled = start + std::chrono::milliseconds(2016);
+	CHECK(clock.tick(stalled) == FrameClock::kMaxDelta);
+	CHECK(NearlyEqual(clock.getRawDelta(), 2.0, 1e-9));
+	CHECK(NearlyEqual(clock.getTotal(), 0.016 + FrameClock::kMaxDelta, 1e-9));
+
+	// Un instante anterior al último no resta tiempo.
+	CHECK(clock.tick(stalled - std::chrono::milliseconds(5)) == 0.0);
+	CHECK(NearlyEqual(clock.getTotal(), 0.016 + FrameClock::kMaxDelta, 1e-9));
+}
+
+TEST_CASE(FixedTimestep_AdvanceClampsToMaxSteps) {
+	FixedTimestep timestep;
+	const double step = timestep.getStep();
+	CHECK(NearlyEqual(step, 1.0 / 60.0, 1e-12));
+	CHECK(timestep.getMaxSteps() == 8);
+
+	// Tras reset() hay un paso pendiente aunque el primer frame no tenga delta.
+	CHECK(timestep.advance(0.0) == 1);
+	CHECK(NearlyEqual(timestep.getAlpha(), 0.0, 1e-6));
+
+	// Lo que no llega a un paso queda como fracción para interpolar.
+	CHECK(timestep.advance(2.5 * step) == 2);
+	CHECK(NearlyEqual(timestep.getAlpha(), 0.5, 1e-6));
+	CHECK(timestep.advance(0.25 * step) == 0);
+	CHECK(NearlyEqual(timestep.getAlpha(), 0.75, 1e-6));
+	CHECK(timestep.advance(-1.0) == 0);
+	CHECK(NearlyEqual(timestep.getAlpha(), 0.75, 1e-6));
+
+	// Un frame de un segundo simula maxSteps y descarta el resto sin tocar la fracción.
+	CHECK(timestep.advance(1.0 - 0.25 * step) == 8);
+	CHECK(NearlyEqual(timestep.getDroppedTime(), 52.0 * step, 1e-9));
+	CHECK(NearlyEqual(timestep.getAlpha(), 0.5, 1e-6));
+	CHECK(timestep.getSteps() == 11);
+
+	// El siguiente frame normal ya no arrastra el retraso.
+	CHECK(timestep.advance(step) == 1);
+	CHECK(NearlyEqual(timestep.getAlpha(), 0.5, 1e-6));
+
+	// Al menos un paso por frame y el paso limitado a [1/1000, 1/10].
+	timestep.setMaxSteps(0);
+	CHECK(timestep.getMaxSteps() == 1);
+	CHECK(timestep.advance(10.0 * step) == 1);
+	timestep.setStep(1.0);
+	CHECK(timestep.getStep() == 0.1);
+	timestep.setStep(0.0);
+	CHECK(timestep.getStep() == 0.001);
+
+	timestep.reset();
+	CHECK(timestep.getSteps() == 0);
+	CHECK(timestep.getDroppedTime() == 0.0);
+	CHECK(timestep.advance(0.0) == 1);
+}
+
+TEST_CASE(FramePacer_TargetFollowsFocusAndLimits) {
+	FramePacingSettings settings;
+	CHECK(NearlyEqual(FramePacer::getTargetSeconds(settings, true), 1.0 / 144.0, 1e-12));
+	CHECK(NearlyEqual(FramePacer::getTargetSeconds(settings, false), 1.0 / 15.0, 1e-12));
+
+	// Sin bajar el ritmo, o sin límite propio sin foco, se queda el de con foco.
+	settings.throttleUnfocused = false;
+	CHECK(NearlyEqual(FramePacer::getTargetSeconds(settings, false), 1.0 / 144.0, 1e-12));
+	settings.throttleUnfocused = true;
+	settings.unfocusedFps = 0;
+	CHECK(NearlyEqual(FramePacer::getTargetSeconds(settings, false), 1.0 / 144.0, 1e-12));
+
+	// Sin foco nunca va más rápido que con foco.
+	settings.maxFps = 30;
+	settings.unfocusedFps = 60;
+	CHECK(NearlyEqual(FramePacer::getTargetSeconds(settings, false), 1.0 / 30.0, 1e-12));
+
+	// Sin límite con foco: 0, salvo que sin foco sí lo haya.
+	settings.maxFps = 0;
+	CHECK(FramePacer::getTargetSeconds(settings, true) == 0.0);
+	CHECK(NearlyEqual(FramePacer::getTargetSeconds(settings, false), 1.0 / 60.0, 1e-12));
+	settings.unfocusedFps = 0;
+	CHECK(FramePacer::getTargetSeconds(settings, false) == 0.0);
+}
@@ -0,0 +1,133 @@
+﻿/**
+ * @file FramePipelineTests.cpp
+ * @brief Pruebas del buzón triple: el paquete en dibujo no se toca, gana el más reciente y el cierre no se bloquea.
+ */
+
+#include "TestFramework.h"
+#include "FramePipeline.h"
+#include <future>
+
+namespace {
+	/// Llena el paquete de escritura con su número de frame y lo publica.
+	bool
+	publishFrame(FrameMailbox& mailbox, uint64_t frame) {
+		mailbox.getWriteSlot().frame = frame;
+		return mailbox.publish();
+	}
+
+	/// true si la tarea termina antes del plazo (un bloqueo la deja colgada).
+	template <typename T>
+	bool
+	finishesWithin(std::future<T>& task, unsigned int timeoutMs) {
+		return task.wait_for(std::chrono::milliseconds(timeoutMs)) == std::future_status::ready;
+	}
+}
+
+TEST_CASE(FrameMailbox_ProducerNeverWritesHeldPacket) {
+	FrameMailbox mailbox;
+	CHECK(!publishFrame(mailbox, 1));
+	FramePacket* held = mailbox.acquire();
+	REQUIRE(held != nullptr);
+	CHECK(held->frame == 1);
+
+	// Mientras el render lo tiene, la simulación rota por los otros dos paquetes.
+	for (uint64_t frame = 2; frame < 12; ++frame) {
+		CHECK(&mailbox.getWriteSlot() != held);
+		const bool dropped = publishFrame(mailbox, frame);
+		CHECK(dropped == (frame > 2));
+		CHECK(held->frame == 1);
+	}
+	mailbox.release();
+
+	// Tras soltarlo, el siguiente acquire() da el último publicado y no el retenido.
+	FramePacket* next = mailbox.acquire();
+	REQUIRE(next != nullptr);
+	CHECK(next != held);
+	CHECK(next->frame == 11);
+	CHECK(&mailbox.getWriteSlot() != next);
+	mailbox.release();
+	CHECK(mailbox.waitForSlot(0));
+}
+
+TEST_CASE(FrameMailbox_ConsumerSeesNewestPacketAcrossThreads) {
+	const uint64_t kFrames = 20000;
+	FrameMailbox mailbox;
+	std::atomic<bool> overwritten(false);
+
+	auto consumer = std::async(std::launch::async, [&mailbox, &overwritten]() {
+		uint64_t last = 0;
+		unsigned int taken = 0;
+		bool ordered = true;
+		while (FramePacket* packet = mailbox.acquire()) {
+			const uint64_t frame = packet->frame;
+			ordered = ordered && frame > last;
+			last = frame;
+			++taken;
+			// Si la simulación escribiera aquí, el número cambiaría durante el dibujo.
+			std::this_thread::yield();
+			if (packet->frame != frame) {
+				overwritten = true;
+			}
+			mailbox.release();
+		}
+		return std::make_pair(ordered ? last : 0, taken);
+	});
+
+	unsigned int dropped = 0;
+	for (uint64_t frame = 1; frame <= kFrames; ++frame) {
+		dropped += publishFrame(mailbox, frame) ? 1 : 0;
+	}
+	mailbox.close();
+
+	REQUIRE(finishesWithin(consumer, 5000));
+	const std::pair<uint64_t, unsigned int> seen = consumer.get();
+	CHECK(!overwritten);
+	// Los frames llegan en orden y el último publicado siempre se dibuja.
+	CHECK(seen.first == kFrames);
+	CHECK(seen.second + dropped == kFrames);
+}
+
+TEST_CASE(FrameMailbox_ShutdownDoesNotDeadlock) {
+	// close() despierta a un acquire() que espera sin nada publicado.
+	FrameMailbox mailbox;
+	auto waiting = std::async(std::launch::async, [&mailbox]() { return mailbox.acquire(); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	mailbox.close();
+	REQUIRE(finishesWithin(waiting, 2000));
+	CHECK(waiting.get() == nullptr);
+	CHECK(mailbox.waitForSlot(0));
+
+	// Cerrado, lo publicado aún se entrega una vez y después acquire() ya no espera.
+	publishFrame(mailbox, 7);
+	FramePacket* last = mailbox.acquire();
+	REQUIRE(last != nullptr);
+	CHECK(last->frame == 7);
+	mailbox.release();
+	CHECK(mailbox.acquire() == nullptr);
+
+	// stop() dibuja lo publicado y une el hilo aunque el render sea lento; drain() sin hilo no espera.
+	RenderThread thread;
+	thread.drain();
+	std::atomic<uint64_t> lastDrawn(0);
+	thread.start([&lastDrawn](FramePacket& packet) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		lastDrawn = packet.frame;
+	});
+	REQUIRE(thread.isRunning());
+	for (uint64_t frame = 1; frame <= 50; ++frame) {
+		thread.beginPacket().frame = frame;
+		thread.publish();
+	}
+	auto stopped = std::async(std::launch::async, [&thread]() { thread.stop(); });
+	REQUIRE(finishesWithin(stopped, 5000));
+	CHECK(!thread.isRunning());
+	CHECK(lastDrawn == 50);
+
+	// Se puede volver a arrancar tras stop().
+	thread.start([&lastDrawn](FramePacket& packet) { lastDrawn = packet.frame; });
+	thread.beginPacket().frame = 51;
+	thread.publish();
+	thread.drain();
+	CHECK(lastDrawn == 51);
+	thread.stop();
+}
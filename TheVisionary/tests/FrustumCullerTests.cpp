@@ -0,0 +1,115 @@
+﻿/**
+ * @file FrustumCullerTests.cpp
+ * @brief Pruebas de FrustumCuller: casos dentro/fuera y equivalencia de los caminos SSE, AVX y paralelo.
+ */
+
+#include "TestFramework.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include <random>
+
+namespace {
+	/// Cámara en (0, 0, 0) mirando a +z, 90 grados de campo y planos a 1 y 100.
+	Frustum
+	MakeTestFrustum() {
+		const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+			XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f);
+		return Frustum::fromMatrix(view * projection);
+	}
+
+	MeshBounds
+	MakeBox(float x, float y, float z, float extent) {
+		MeshBounds bounds;
+		bounds.center = XMFLOAT3(x, y, z);
+		bounds.extents = XMFLOAT3(extent, extent, extent);
+		bounds.sphere = XMFLOAT4(x, y, z, extent * 1.7320508f);
+		return bounds;
+	}
+
+	/// Escena aleatoria de cajas alrededor del origen, algunas sin volumen.
+	void
+	FillRandomScene(FrustumCuller& culler, size_t count, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+		std::uniform_real_distribution<float> extent(0.1f, 4.0f);
+		culler.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			culler.setBounds(i, (i % 97 == 0) ? MeshBounds()
+				: MakeBox(position(rng), position(rng), position(rng), extent(rng)));
+		}
+	}
+}
+
+TEST_CASE(FrustumCuller_ClassifiesInsideOutsideAndStraddling) {
+	FrustumCuller culler;
+	culler.setUseAVX(false);
+	culler.resize(7);
+	culler.setBounds(0, MakeBox(0.0f, 0.0f, 10.0f, 1.0f));    // Dentro.
+	culler.setBounds(1, MakeBox(0.0f, 0.0f, -10.0f, 1.0f));   // Detrás de la cámara.
+	culler.setBounds(2, MakeBox(0.0f, 0.0f, 200.0f, 1.0f));   // Más allá del plano lejano.
+	culler.setBounds(3, MakeBox(50.0f, 0.0f, 10.0f, 1.0f));   // A la derecha, fuera.
+	culler.setBounds(4, MakeBox(11.0f, 0.0f, 10.0f, 2.0f));   // Cruza el plano derecho.
+	culler.setBounds(5, MakeBox(0.0f, 0.0f, 100.5f, 1.0f));   // Cruza el plano lejano.
+	culler.setBounds(6, MeshBounds());                        // Sin volumen: siempre visible.
+
+	std::vector<unsigned int> visible;
+	FrustumCullStats stats;
+	culler.cull(MakeTestFrustum(), visible, nullptr, &stats);
+	const std::vector<unsigned int> expected = { 0, 4, 5, 6 };
+	CHECK(visible == expected);
+	CHECK(stats.tested == 7);
+	CHECK(stats.visible == 4);
+	CHECK(stats.getCulled() == 3);
+}
+
+TEST_CASE(FrustumCuller_AVXMatchesSSEOnRandomScenes) {
+	if (!FrustumCuller::isAVXSupported()) {
+		// Sin AVX solo se comprueba que setUseAVX(true) se queda en SSE.
+		FrustumCuller culler;
+		culler.setUseAVX(true);
+		CHECK(!culler.isUsingAVX());
+		return;
+	}
+	// Tamaños que dejan grupos y mitades incompletos al final.
+	const size_t counts[] = { 1, 3, 4, 5, 8, 9, 13, 4099, 10007 };
+	const Frustum frustum = MakeTestFrustum();
+	for (size_t count : counts) {
+		FrustumCuller culler;
+		FillRandomScene(culler, count, static_cast<uint32_t>(count));
+		std::vector<unsigned int> sse, avx;
+		culler.setUseAVX(false);
+		culler.cull(frustum, sse, nullptr);
+		culler.setUseAVX(true);
+		CHECK(culler.isUsingAVX());
+		culler.cull(frustum, avx, nullptr);
+		CHECK(sse == avx);
+	}
+}
+
+TEST_CASE(FrustumCuller_ParallelMatchesSerial) {
+	JobSystem jobs;
+	jobs.init(3);
+	FrustumCuller culler;
+	FillRandomScene(culler, 3 * FrustumCuller::kChunkSize + 123, 7u);
+	const Frustum frustum = MakeTestFrustum();
+
+	std::vector<unsigned int> serial, parallel;
+	FrustumCullStats stats;
+	culler.cull(frustum, serial, nullptr);
+	culler.cull(frustum, parallel, &jobs, &stats);
+	CHECK(serial == parallel);
+	CHECK(stats.chunks == 4);
+	CHECK(!serial.empty());
+	CHECK(serial.size() < 3 * FrustumCuller::kChunkSize);
+}
+
+TEST_CASE(FrustumCuller_BenchmarkPathsMatch) {
+	JobSystem jobs;
+	jobs.init(3);
+	const FrustumCullBenchmark bench = FrustumCuller::benchmark(20000, &jobs);
+	CHECK(bench.count == 20000);
+	CHECK(bench.visible > 0 && bench.visible < bench.count);
+	CHECK(bench.pathsMatch);
+	CHECK(bench.avx == FrustumCuller::isAVXSupported());
+}
@@ -0,0 +1,204 @@
+﻿/**
+ * @file GeometryHeapTests.cpp
+ * @brief Pruebas del asignador TLSF de RangeAllocator y de los binds que ahorra GeometryHeap.
+ */
+
+#include "TestFramework.h"
+#include "GeometryHeap.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+TEST_CASE(RangeAllocator_AllocatesFreesMergesAndCompacts) {
+	RangeAllocator allocator;
+	allocator.init(1000);
+	const unsigned int a = allocator.allocate(100);
+	const unsigned int b = allocator.allocate(200);
+	const unsigned int c = allocator.allocate(300);
+	REQUIRE(a != RangeAllocator::kInvalid && b != RangeAllocator::kInvalid && c != RangeAllocator::kInvalid);
+	CHECK(allocator.getSize(b) == 200);
+	// Sin solapes.
+	CHECK(allocator.getOffset(a) + 100 <= allocator.getOffset(b) || allocator.getOffset(b) + 200 <= allocator.getOffset(a));
+	CHECK(allocator.getOffset(b) + 200 <= allocator.getOffset(c) || allocator.getOffset(c) + 300 <= allocator.getOffset(b));
+	CHECK(allocator.allocate(401) == RangeAllocator::kInvalid);
+	CHECK(allocator.validate());
+
+	// Liberar el del medio deja un hueco; la compactación lo cierra moviendo solo hacia atrás.
+	allocator.free(b);
+	CHECK(allocator.validate());
+	RangeAllocatorStats stats = allocator.getStats();
+	CHECK(stats.used == 400);
+	CHECK(stats.allocations == 2);
+	CHECK(stats.getFragmentation() > 0.0f);
+
+	std::vector<RangeMove> moves;
+	allocator.compact(moves);
+	CHECK(allocator.validate());
+	for (const RangeMove& move : moves) {
+		CHECK(move.destination <= move.source);
+	}
+	stats = allocator.getStats();
+	CHECK(stats.freeBlocks == 1);
+	CHECK(stats.largestFree == 600);
+	CHECK(stats.getFragmentation() == 0.0f);
+	CHECK(allocator.allocate(600) != RangeAllocator::kInvalid);
+}
+
+TEST_CASE(RangeAllocator_CoalescesNeighboursAndReportsOutOfMemory) {
+	RangeAllocator allocator;
+	allocator.init(1000);
+	CHECK(allocator.allocate(0) == RangeAllocator::kInvalid);
+	CHECK(allocator.allocate(1001) == RangeAllocator::kInvalid);
+
+	// Cuatro bloques llenan el buffer en orden de dirección.
+	unsigned int blocks[4];
+	for (unsigned int i = 0; i < 4; ++i) {
+		blocks[i] = allocator.allocate(250);
+		REQUIRE(blocks[i] != RangeAllocator::kInvalid);
+		CHECK(allocator.getOffset(blocks[i]) == 250 * i);
+	}
+	CHECK(allocator.allocate(1) == RangeAllocator::kInvalid);
+	CHECK(allocator.getStats().freeBlocks == 0);
+
+	// Liberar dos vecinos deja un solo hueco (fusión con el siguiente y con el anterior).
+	allocator.free(blocks[1]);
+	allocator.free(blocks[2]);
+	CHECK(allocator.validate());
+	RangeAllocatorStats stats = allocator.getStats();
+	CHECK(stats.freeBlocks == 1);
+	CHECK(stats.largestFree == 500);
+	// Liberar dos veces no cambia nada.
+	allocator.free(blocks[2]);
+	CHECK(allocator.getStats().used == 500);
+
+	// El hueco fusionado sirve entero y en su sitio.
+	const unsigned int middle = allocator.allocate(500);
+	REQUIRE(middle != RangeAllocator::kInvalid);
+	CHECK(allocator.getOffset(middle) == 250);
+
+	// Los extremos y el centro vuelven a ser un solo hueco del tamaño del buffer.
+	allocator.free(blocks[0]);
+	allocator.free(blocks[3]);
+	CHECK(allocator.getStats().freeBlocks == 2);
+	allocator.free(middle);
+	CHECK(allocator.validate());
+	stats = allocator.getStats();
+	CHECK(stats.used == 0);
+	CHECK(stats.allocations == 0);
+	CHECK(stats.freeBlocks == 1);
+	CHECK(stats.largestFree == 1000);
+	const unsigned int whole = allocator.allocate(1000);
+	REQUIRE(whole != RangeAllocator::kInvalid);
+	CHECK(allocator.getOffset(whole) == 0);
+	allocator.free(whole);
+
+	// Espacio libre suficiente pero troceado: no hay hueco para 101 aunque queden 500.
+	std::vector<unsigned int> tens;
+	for (unsigned int i = 0; i < 10; ++i) {
+		tens.push_back(allocator.allocate(100));
+	}
+	for (unsigned int i = 0; i < 10; i += 2) {
+		allocator.free(tens[i]);
+	}
+	stats = allocator.getStats();
+	CHECK(stats.used == 500);
+	CHECK(stats.freeBlocks == 5);
+	CHECK(NearlyEqual(stats.getFragmentation(), 0.8, 1e-6));
+	CHECK(allocator.allocate(101) == RangeAllocator::kInvalid);
+	CHECK(allocator.allocate(100) != RangeAllocator::kInvalid);
+	CHECK(allocator.validate());
+}
+
+TEST_CASE(RangeAllocator_RandomOperationsMatchReferenceAndCompactKeepsContents) {
+	const unsigned int kCapacity = 1u << 16;
+	RangeAllocator allocator;
+	allocator.init(kCapacity);
+
+	// Referencia: bloque -> tamaño; y el "contenido" del buffer, marcado con el bloque dueño.
+	std::map<unsigned int, unsigned int> live;
+	std::vector<unsigned int> memory(kCapacity, RangeAllocator::kInvalid);
+	std::mt19937 rng(13);
+	unsigned int overlaps = 0, failures = 0;
+	for (unsigned int op = 0; op < 20000; ++op) {
+		if (!live.empty() && (rng() % 100 < 45 || op % 997 == 0)) {
+			auto it = live.begin();
+			std::advance(it, rng() % live.size());
+			const unsigned int offset = allocator.getOffset(it->first);
+			std::fill(memory.begin() + offset, memory.begin() + offset + it->second, RangeAllocator::kInvalid);
+			allocator.free(it->first);
+			live.erase(it);
+			continue;
+		}
+		// Tamaños de mallas pequeñas a grandes (sesgado a pequeñas).
+		const unsigned int size = 1 + (rng() % 4 == 0 ? rng() % 4000 : rng() % 200);
+		const unsigned int block = allocator.allocate(size);
+		if (block == RangeAllocator::kInvalid) {
+			++failures;
+			continue;
+		}
+		REQUIRE(live.count(block) == 0);
+		const unsigned int offset = allocator.getOffset(block);
+		REQUIRE(offset + size <= kCapacity);
+		CHECK(allocator.getSize(block) == size);
+		for (unsigned int i = offset; i < offset + size; ++i) {
+			overlaps += memory[i] != RangeAllocator::kInvalid ? 1 : 0;
+			memory[i] = block;
+		}
+		live[block] = size;
+	}
+	CHECK(overlaps == 0);
+	CHECK(failures > 0);
+	CHECK(allocator.validate());
+
+	unsigned int used = 0;
+	for (const auto& entry : live) {
+		used += entry.second;
+	}
+	RangeAllocatorStats stats = allocator.getStats();
+	CHECK(stats.used == used);
+	CHECK(stats.allocations == live.size());
+
+	// Compactar: los movimientos, aplicados en orden, dejan cada bloque con su contenido.
+	std::vector<RangeMove> moves;
+	allocator.compact(moves);
+	CHECK(allocator.validate());
+	CHECK(!moves.empty());
+	for (size_t i = 0; i < moves.size(); ++i) {
+		CHECK(moves[i].destination < moves[i].source);
+		CHECK(i == 0 || moves[i - 1].destination < moves[i].destination);
+		std::copy(memory.begin() + moves[i].source, memory.begin() + moves[i].source + moves[i].size,
+			memory.begin() + moves[i].destination);
+	}
+	std::vector<std::pair<unsigned int, unsigned int>> ranges;
+	for (const auto& entry : live) {
+		const unsigned int offset = allocator.getOffset(entry.first);
+		CHECK(allocator.getSize(entry.first) == entry.second);
+		CHECK(memory[offset] == entry.first);
+		CHECK(memory[offset + entry.second - 1] == entry.first);
+		ranges.push_back({ offset, entry.second });
+	}
+	// Sin huecos entre bloques vivos y el resto del buffer en un solo hueco al final.
+	std::sort(ranges.begin(), ranges.end());
+	unsigned int next = 0;
+	for (const auto& range : ranges) {
+		CHECK(range.first == next);
+		next += range.second;
+	}
+	stats = allocator.getStats();
+	CHECK(stats.freeBlocks == (used < kCapacity ? 1u : 0u));
+	CHECK(stats.largestFree == kCapacity - used);
+	CHECK(allocator.allocate(kCapacity - used) != RangeAllocator::kInvalid);
+}
+
+TEST_CASE(GeometryHeap_BenchmarkCutsBinds) {
+	const GeometryHeapBenchmark small = GeometryHeap::benchmark(10, 1000);
+	CHECK(small.meshes == 10);
+	CHECK(small.heapBinds < small.ownBufferBinds);
+
+	const GeometryHeapBenchmark bench = GeometryHeap::benchmark(2000, 200000);
+	CHECK(bench.operations == 200000);
+	CHECK(bench.compactMoves > 0);
+	// Las mallas caben en muchas menos páginas que buffers propios y la cola ordenada enlaza menos.
+	CHECK(bench.pages > 0 && bench.pages < bench.meshes);
+	CHECK(bench.heapBinds < bench.ownBufferBinds);
+}
@@ -0,0 +1,173 @@
+﻿/**
+ * @file InstanceBatcherTests.cpp
+ * @brief Pruebas del agrupado por malla y del empaquetado de instancias de InstanceBatcher.
+ */
+
+#include "TestFramework.h"
+#include "InstanceBatcher.h"
+
+namespace {
+	/// Objetos ficticios: el batcher solo usa sus direcciones.
+	char g_objects[64];
+
+	template<typename T>
+	T*
+	mockObject(unsigned int id) {
+		return reinterpret_cast<T*>(g_objects + id);
+	}
+
+	/// Paquete de una malla: geometría y textura propias, constantes por actor.
+	DrawPacket
+	makePacket(unsigned int mesh, unsigned int actor) {
+		DrawPacket packet;
+		packet.vertexShader = mockObject<ID3D11VertexShader>(1);
+		packet.pixelShader = mockObject<ID3D11PixelShader>(2);
+		packet.inputLayout = mockObject<ID3D11InputLayout>(3);
+		packet.texture = mockObject<ID3D11ShaderResourceView>(8 + mesh);
+		packet.vertexBuffer = mockObject<ID3D11Buffer>(16 + mesh);
+		packet.indexBuffer = mockObject<ID3D11Buffer>(24 + mesh);
+		packet.indexCount = 36;
+		// Las constantes y los rangos no separan lotes: se descartan.
+		packet.constantBuffer = mockObject<ID3D11Buffer>(32 + actor % 8);
+		packet.constantData = &g_objects[actor % 8];
+		packet.constantSize = 16;
+		return packet;
+	}
+}
+
+TEST_CASE(InstanceBatcher_GroupsByKeyAndPacksInstancesInOrder) {
+	InstanceBatcher batcher;
+	batcher.begin();
+	// Tres mallas en dos pases, intercaladas; la traslación x guarda el actor.
+	const unsigned int kActors = 30;
+	for (unsigned int actor = 0; actor < kActors; ++actor) {
+		const unsigned int mesh = actor % 3;
+		const RenderPass pass = (actor % 2) ? RENDER_PASS_SHADOW : RENDER_PASS_OPAQUE;
+		const XMFLOAT4 color(float(actor), 0.0f, 0.0f, 1.0f);
+		REQUIRE(batcher.add(makePacket(mesh, actor), VertexLayout(), pass, 100.0f - float(actor),
+			XMMatrixTranslation(float(actor), 0.0f, 0.0f), color));
+	}
+	batcher.build();
+
+	const std::vector<InstanceBatch>& batches = batcher.getBatches();
+	const std::vector<InstanceData>& instances = batcher.getInstances();
+	REQUIRE(batches.size() == 6);
+	REQUIRE(instances.size() == kActors);
+	CHECK(batcher.getStats().batches == 6);
+	CHECK(batcher.getStats().instances == kActors);
+
+	unsigned int next = 0;
+	for (const InstanceBatch& batch : batches) {
+		// Rangos contiguos, en el orden en que apareció cada grupo.
+		CHECK(batch.packet.firstInstance == next);
+		CHECK(batch.packet.instanceCount == 5);
+		CHECK(batch.packet.instanceStride == sizeof(InstanceData));
+		CHECK(batch.packet.constantBuffer == nullptr);
+		CHECK(batch.packet.constantData == nullptr);
+		next += batch.packet.instanceCount;
+
+		unsigned int previous = 0;
+		for (unsigned int k = batch.packet.firstInstance; k < next; ++k) {
+			const unsigned int actor = static_cast<unsigned int>(instances[k].world.m[3][0]);
+			// Misma malla y pase que el lote, matriz sin transponer y color de la instancia.
+			CHECK(batch.packet.vertexBuffer == mockObject<ID3D11Buffer>(16 + actor % 3));
+			CHECK(batch.pass == ((actor % 2) ? RENDER_PASS_SHADOW : RENDER_PASS_OPAQUE));
+			CHECK(instances[k].world.m[0][0] == 1.0f);
+			CHECK(instances[k].color.x == float(actor));
+			// Estable: dentro del lote, en orden de add().
+			CHECK(k == batch.packet.firstInstance || actor > previous);
+			previous = actor;
+		}
+		// Opaco: la instancia más cercana (último actor del lote); sombras: la más lejana (primero).
+		const unsigned int first = static_cast<unsigned int>(instances[batch.packet.firstInstance].world.m[3][0]);
+		const unsigned int last = static_cast<unsigned int>(instances[next - 1].world.m[3][0]);
+		CHECK(batch.depth == 100.0f - float(batch.pass == RENDER_PASS_SHADOW ? first : last));
+	}
+
+	// Un lote por grupo en la cola, con el buffer de instancias enlazado.
+	RenderQueue queue;
+	batcher.submit(queue);
+	CHECK(queue.size() == batches.size());
+
+	// begin() vacía el frame.
+	batcher.begin();
+	batcher.build();
+	CHECK(batcher.getBatches().empty());
+	CHECK(batcher.getInstances().empty());
+}
+
+TEST_CASE(InstanceBatcher_UsesInstancedShadersAndFallsBackWithoutLayout) {
+	InstanceBatcher batcher;
+	ID3D11VertexShader* vertexShader = mockObject<ID3D11VertexShader>(40);
+	ID3D11PixelShader* pixelShader = mockObject<ID3D11PixelShader>(41);
+	ID3D11PixelShader* shadowPixelShader = mockObject<ID3D11PixelShader>(42);
+	ID3D11InputLayout* defaultLayout = mockObject<ID3D11InputLayout>(43);
+	ID3D11InputLayout* compactLayout = mockObject<ID3D11InputLayout>(44);
+	batcher.setShaders(vertexShader, pixelShader, shadowPixelShader);
+	batcher.setInputLayout(VertexLayout(), defaultLayout);
+
+	VertexLayout compact;
+	compact.position = POSITION_SNORM16;
+	REQUIRE(compact.isCompact());
+
+	const XMMATRIX world = XMMatrixIdentity();
+	const XMFLOAT4 shadowColor(0.0f, 0.0f, 0.0f, 0.5f);
+	batcher.begin();
+	CHECK(batcher.add(makePacket(0, 0), VertexLayout(), RENDER_PASS_OPAQUE, 1.0f, world, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)));
+	// El PS de sombra del actor (que lee b2) se sustituye por el instanciado.
+	DrawPacket shadow = makePacket(0, 0);
+	shadow.pixelShader = mockObject<ID3D11PixelShader>(5);
+	CHECK(batcher.add(shadow, VertexLayout(), RENDER_PASS_SHADOW, 1.0f, world, shadowColor));
+	// Sin Input Layout instanciado para el formato compacto: el actor se dibuja sin instancing.
+	CHECK(!batcher.add(makePacket(1, 1), compact, RENDER_PASS_OPAQUE, 1.0f, world, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)));
+	batcher.build();
+	REQUIRE(batcher.getBatches().size() == 2);
+	CHECK(batcher.getInstances().size() == 2);
+
+	const InstanceBatch& opaque = batcher.getBatches()[0];
+	CHECK(opaque.pass == RENDER_PASS_OPAQUE);
+	CHECK(opaque.packet.vertexShader == vertexShader);
+	CHECK(opaque.packet.pixelShader == pixelShader);
+	CHECK(opaque.packet.inputLayout == defaultLayout);
+	const InstanceBatch& shadowBatch = batcher.getBatches()[1];
+	CHECK(shadowBatch.pass == RENDER_PASS_SHADOW);
+	CHECK(shadowBatch.packet.vertexShader == vertexShader);
+	CHECK(shadowBatch.packet.pixelShader == shadowPixelShader);
+	CHECK(batcher.getInstances()[1].color.w == shadowColor.w);
+
+	// Con el Input Layout registrado el formato compacto se instancia; al quitarlo vuelve a fallar.
+	batcher.setInputLayout(compact, compactLayout);
+	batcher.begin();
+	CHECK(batcher.add(makePacket(1, 1), compact, RENDER_PASS_OPAQUE, 1.0f, world, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)));
+	batcher.build();
+	REQUIRE(batcher.getBatches().size() == 1);
+	CHECK(batcher.getBatches()[0].packet.inputLayout == compactLayout);
+	batcher.setInputLayout(compact, nullptr);
+	CHECK(!batcher.add(makePacket(1, 1), compact, RENDER_PASS_OPAQUE, 1.0f, world, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)));
+
+	// Sin shaders instanciados (sin init()) se conservan los del paquete.
+	batcher.setShaders(nullptr, nullptr, nullptr);
+	batcher.begin();
+	CHECK(batcher.add(shadow, compact, RENDER_PASS_SHADOW, 1.0f, world, shadowColor));
+	batcher.build();
+	CHECK(batcher.getBatches()[0].packet.pixelShader == shadow.pixelShader);
+}
+
+TEST_CASE(InstanceBatcher_BenchmarkPacksEveryActorOnce) {
+	const unsigned int meshCounts[] = { 1, 4, 16 };
+	for (unsigned int meshes : meshCounts) {
+		const InstancingBenchmark bench = InstanceBatcher::benchmark(10000, meshes);
+		CHECK(bench.instances == 10000);
+		CHECK(bench.meshes == meshes);
+		// Un paquete por actor frente a un draw instanciado por malla.
+		CHECK(bench.actorDrawCalls == bench.instances);
+		CHECK(bench.instancedDrawCalls == meshes);
+		CHECK(bench.instancedDrawCalls < bench.actorDrawCalls);
+	}
+}
+
+TEST_CASE(InstanceBatcher_BenchmarkHandlesMoreMeshesThanActors) {
+	// Con mallas de sobra algunos lotes quedan vacíos y no deben emitir draws.
+	const InstancingBenchmark bench = InstanceBatcher::benchmark(3, 8);
+	CHECK(bench.instancedDrawCalls <= bench.actorDrawCalls);
+}
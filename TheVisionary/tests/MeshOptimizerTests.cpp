@@ -0,0 +1,119 @@
+﻿/**
+ * @file MeshOptimizerTests.cpp
+ * @brief Pruebas del orden para caché de vértices, overdraw y fetch de MeshOptimizer.
+ */
+
+#include "TestFramework.h"
+#include "TestGeometry.h"
+#include "MeshOptimizer.h"
+#include "MeshComponent.h"
+
+TEST_CASE(MeshOptimizer_SimulatorCountsEachVertexOnceInOrder) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(4, vertices, indices);
+
+	// Una tira de 2 triángulos reutiliza los vértices compartidos: 4 transformaciones.
+	const std::vector<unsigned int> quad(indices.begin(), indices.begin() + 6);
+	const VertexCacheStats stats = MeshOptimizer::simulateVertexCache(quad, static_cast<unsigned int>(vertices.size()));
+	CHECK(stats.triangles == 2);
+	CHECK(stats.transformed == 4);
+	CHECK(NearlyEqual(stats.acmr, 2.0));
+
+	// Con caché de un solo vértice casi todo falla.
+	const VertexCacheStats tiny = MeshOptimizer::simulateVertexCache(quad, static_cast<unsigned int>(vertices.size()), 1);
+	CHECK(tiny.transformed > stats.transformed);
+}
+
+TEST_CASE(MeshOptimizer_VertexCacheLowersACMRAndKeepsTriangles) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(64, vertices, indices);
+	ShuffleTriangles(indices, 29);
+	const unsigned int vertexCount = static_cast<unsigned int>(vertices.size());
+	const std::vector<TrianglePositions> original = CanonicalTriangles(vertices, indices);
+	const VertexCacheStats before = MeshOptimizer::simulateVertexCache(indices, vertexCount);
+
+	MeshOptimizer::optimizeVertexCache(indices, vertexCount);
+	const VertexCacheStats after = MeshOptimizer::simulateVertexCache(indices, vertexCount);
+
+	CHECK(CanonicalTriangles(vertices, indices) == original);
+	CHECK(after.acmr < before.acmr);
+	// Una rejilla bien ordenada ronda 0.6-0.7 con 16 entradas; barajada pasa de 1.5.
+	CHECK(after.acmr < 0.9f);
+}
+
+TEST_CASE(MeshOptimizer_OverdrawStaysWithinThreshold) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(64, vertices, indices);
+	ShuffleTriangles(indices, 30);
+	const unsigned int vertexCount = static_cast<unsigned int>(vertices.size());
+	MeshOptimizer::optimizeVertexCache(indices, vertexCount);
+	const std::vector<TrianglePositions> original = CanonicalTriangles(vertices, indices);
+	const VertexCacheStats cached = MeshOptimizer::simulateVertexCache(indices, vertexCount);
+
+	const unsigned int clusters = MeshOptimizer::optimizeOverdraw(vertices, indices, 1.05f);
+	const VertexCacheStats after = MeshOptimizer::simulateVertexCache(indices, vertexCount);
+
+	CHECK(clusters >= 1);
+	CHECK(CanonicalTriangles(vertices, indices) == original);
+	// Reordenar clusters cuesta algún fallo en sus bordes, nunca mucho más que el umbral.
+	CHECK(after.acmr <= cached.acmr * 1.10f);
+}
+
+TEST_CASE(MeshOptimizer_VertexFetchOrdersByFirstUseAndDropsUnused) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(16, vertices, indices);
+	ShuffleTriangles(indices, 31);
+	// Dos vértices que ningún triángulo usa.
+	SimpleVertex unused;
+	unused.Pos = XMFLOAT3(-100.0f, 0.0f, 0.0f);
+	unused.Tex = XMFLOAT2(0.0f, 0.0f);
+	vertices.insert(vertices.begin() + 5, unused);
+	for (unsigned int& index : indices) {
+		index += index >= 5 ? 1 : 0;
+	}
+	vertices.push_back(unused);
+	const std::vector<TrianglePositions> original = CanonicalTriangles(vertices, indices);
+	const size_t vertexCount = vertices.size();
+
+	const unsigned int removed = MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+	CHECK(removed == 2);
+	CHECK(vertices.size() == vertexCount - 2);
+	CHECK(CanonicalTriangles(vertices, indices) == original);
+	// Primer uso: cada índice nuevo es como mucho el mayor visto más uno.
+	unsigned int next = 0;
+	bool firstUse = true;
+	for (unsigned int index : indices) {
+		firstUse = firstUse && index <= next;
+		next = std::max(next, index + 1);
+	}
+	CHECK(firstUse);
+	CHECK(next == vertices.size());
+}
+
+TEST_CASE(MeshOptimizer_OptimizeReportsImprovementAndUpdatesCounts) {
+	MeshComponent mesh;
+	MakeGrid(48, mesh.m_vertex, mesh.m_index);
+	ShuffleTriangles(mesh.m_index, 32);
+	const std::vector<TrianglePositions> original = CanonicalTriangles(mesh.m_vertex, mesh.m_index);
+
+	const MeshOptimizationReport report = MeshOptimizer::optimize(mesh);
+
+	CHECK(report.before.triangles == 48 * 48 * 2);
+	CHECK(report.after.acmr < report.before.acmr);
+	CHECK(report.removedVertices == 0);
+	CHECK(mesh.m_numIndex == static_cast<int>(mesh.m_index.size()));
+	CHECK(mesh.m_numVertex == static_cast<int>(mesh.m_vertex.size()));
+	CHECK(CanonicalTriangles(mesh.m_vertex, mesh.m_index) == original);
+
+	// Determinista: la misma entrada da el mismo orden.
+	MeshComponent again;
+	MakeGrid(48, again.m_vertex, again.m_index);
+	ShuffleTriangles(again.m_index, 32);
+	MeshOptimizer::optimize(again);
+	CHECK(again.m_index == mesh.m_index);
+}
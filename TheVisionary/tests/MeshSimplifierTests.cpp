@@ -0,0 +1,159 @@
+﻿/**
+ * @file MeshSimplifierTests.cpp
+ * @brief Pruebas de MeshSimplifier: planos sin error, cadenas de LOD decrecientes y acotadas, y selección con histéresis.
+ */
+
+#include "TestFramework.h"
+#include "TestGeometry.h"
+#include "MeshSimplifier.h"
+#include "MeshComponent.h"
+#include <cfloat>
+
+namespace {
+	/// Altura de una colina suave sobre la rejilla de 32x32.
+	float
+	hillHeight(float x, float z) {
+		return 3.0f * std::exp(-((x - 16.0f) * (x - 16.0f) + (z - 16.0f) * (z - 16.0f)) / 60.0f);
+	}
+
+	/// Altura de la superficie de un triángulo en (x, z); false si el punto cae fuera de su proyección.
+	bool
+	heightInTriangle(const std::vector<SimpleVertex>& vertices, const unsigned int* triangle, float x, float z, float& y) {
+		const XMFLOAT3& a = vertices[triangle[0]].Pos;
+		const XMFLOAT3& b = vertices[triangle[1]].Pos;
+		const XMFLOAT3& c = vertices[triangle[2]].Pos;
+		const float det = (b.z - c.z) * (a.x - c.x) + (c.x - b.x) * (a.z - c.z);
+		if (std::fabs(det) < 1e-9f) {
+			return false;
+		}
+		const float l1 = ((b.z - c.z) * (x - c.x) + (c.x - b.x) * (z - c.z)) / det;
+		const float l2 = ((c.z - a.z) * (x - c.x) + (a.x - c.x) * (z - c.z)) / det;
+		const float l3 = 1.0f - l1 - l2;
+		if (l1 < -1e-4f || l2 < -1e-4f || l3 < -1e-4f) {
+			return false;
+		}
+		y = l1 * a.y + l2 * b.y + l3 * c.y;
+		return true;
+	}
+
+	/// Mayor distancia vertical de los vértices originales a la superficie de un LOD (infinito si alguno queda fuera).
+	float
+	measureDeviation(const std::vector<SimpleVertex>& vertices, const unsigned int* indices, unsigned int count) {
+		float worst = 0.0f;
+		for (const SimpleVertex& vertex : vertices) {
+			bool covered = false;
+			for (unsigned int i = 0; i < count && !covered; i += 3) {
+				float y;
+				if (heightInTriangle(vertices, indices + i, vertex.Pos.x, vertex.Pos.z, y)) {
+					worst = std::max(worst, std::fabs(y - vertex.Pos.y));
+					covered = true;
+				}
+			}
+			if (!covered) {
+				return FLT_MAX;
+			}
+		}
+		return worst;
+	}
+
+	/// Componente Y de la normal (sin normalizar) de un triángulo.
+	float
+	normalY(const std::vector<SimpleVertex>& vertices, const unsigned int* triangle) {
+		const XMFLOAT3& a = vertices[triangle[0]].Pos;
+		const XMFLOAT3& b = vertices[triangle[1]].Pos;
+		const XMFLOAT3& c = vertices[triangle[2]].Pos;
+		return (b.z - a.z) * (c.x - a.x) - (b.x - a.x) * (c.z - a.z);
+	}
+}
+
+TEST_CASE(MeshSimplifier_FlatGridCollapsesWithoutError) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(32, vertices, indices);
+	const float facing = normalY(vertices, indices.data());
+
+	std::vector<unsigned int> simplified;
+	float error = -1.0f;
+	const size_t count = MeshSimplifier::simplify(vertices, indices, indices.size() / 10, simplified, &error);
+	CHECK(count == simplified.size());
+	CHECK(count % 3 == 0);
+	CHECK(count <= indices.size() / 10);
+	CHECK(error >= 0.0f && error < 1e-4f);
+
+	// Sigue cubriendo el cuadrado entero, sin triángulos invertidos.
+	float area = 0.0f;
+	for (size_t i = 0; i < simplified.size(); i += 3) {
+		const float n = normalY(vertices, &simplified[i]);
+		CHECK(n * facing > 0.0f);
+		area += std::fabs(n) * 0.5f;
+	}
+	CHECK(NearlyEqual(area, 32.0f * 32.0f, 1e-4));
+	CHECK(measureDeviation(vertices, simplified.data(), static_cast<unsigned int>(simplified.size())) < 1e-4f);
+
+	// Un objetivo por encima de lo que hay deja la malla igual.
+	CHECK(MeshSimplifier::simplify(vertices, indices, indices.size(), simplified, &error) == indices.size());
+	CHECK(simplified == indices);
+	CHECK(error == 0.0f);
+}
+
+TEST_CASE(MeshSimplifier_LODChainShrinksWithinErrorBound) {
+	MeshComponent mesh;
+	MakeGrid(32, mesh.m_vertex, mesh.m_index);
+	for (SimpleVertex& vertex : mesh.m_vertex) {
+		vertex.Pos.y = hillHeight(vertex.Pos.x, vertex.Pos.z);
+	}
+	const std::vector<unsigned int> original = mesh.m_index;
+
+	SimplificationStats stats;
+	const std::vector<float> ratios = { 0.5f, 0.25f, 0.125f, 0.0625f };
+	MeshSimplifier::buildLODChain(mesh, ratios, &stats);
+	REQUIRE(mesh.m_lods.size() == ratios.size() + 1);
+	CHECK(mesh.m_numIndex == static_cast<int>(original.size()));
+	CHECK(std::equal(original.begin(), original.end(), mesh.m_index.begin()));
+	CHECK(stats.meshes == 1);
+	CHECK(stats.levels == ratios.size());
+	CHECK(stats.sourceTriangles == original.size() / 3);
+
+	for (size_t i = 1; i < mesh.m_lods.size(); ++i) {
+		const MeshLOD& lod = mesh.m_lods[i];
+		const MeshLOD& finer = mesh.m_lods[i - 1];
+		// Cada nivel tiene menos índices y más error que el anterior, y umbral de pantalla menor.
+		CHECK(lod.indexCount < finer.indexCount);
+		CHECK(lod.indexCount <= static_cast<unsigned int>(original.size() * ratios[i - 1] * 1.1f));
+		CHECK(lod.error >= finer.error);
+		CHECK(lod.screenSize < finer.screenSize);
+		CHECK(lod.indexOffset + lod.indexCount <= mesh.m_index.size());
+
+		// La superficie real no se separa del original más de lo que dice el error medido.
+		const float deviation = measureDeviation(mesh.m_vertex, &mesh.m_index[lod.indexOffset], lod.indexCount);
+		CHECK(deviation <= 2.0f * lod.error + 1e-3f);
+		CHECK(deviation < 0.1f * 3.0f);
+	}
+	// Los LOD comparten los vértices: solo cambian los índices.
+	for (unsigned int index : mesh.m_index) {
+		CHECK(index < mesh.m_vertex.size());
+	}
+}
+
+TEST_CASE(MeshSimplifier_SelectLODUsesHysteresis) {
+	std::vector<MeshLOD> lods(3);
+	lods[0].screenSize = FLT_MAX;
+	lods[1].screenSize = 0.5f;
+	lods[2].screenSize = 0.25f;
+
+	CHECK(MeshSimplifier::selectLOD(lods, 1.0f, 0) == 0);
+	CHECK(MeshSimplifier::selectLOD(lods, 0.1f, 0) == 2);
+	// Justo por debajo del umbral no basta para bajar de detalle...
+	CHECK(MeshSimplifier::selectLOD(lods, 0.48f, 0) == 0);
+	CHECK(MeshSimplifier::selectLOD(lods, 0.40f, 0) == 1);
+	// ...ni justo por encima para subir: el nivel actual se mantiene en la banda.
+	CHECK(MeshSimplifier::selectLOD(lods, 0.52f, 1) == 1);
+	CHECK(MeshSimplifier::selectLOD(lods, 0.60f, 1) == 0);
+	// Un LOD actual fuera de rango se ajusta y una cadena vacía siempre da 0.
+	CHECK(MeshSimplifier::selectLOD(lods, 0.1f, 9) == 2);
+	CHECK(MeshSimplifier::selectLOD(std::vector<MeshLOD>(), 0.1f, 3) == 0);
+
+	const XMFLOAT3 origin(0.0f, 0.0f, 0.0f);
+	CHECK(NearlyEqual(MeshSimplifier::projectedSize(origin, 1.0f, XMFLOAT3(0.0f, 0.0f, -10.0f), 2.0f), 0.2));
+	CHECK(MeshSimplifier::projectedSize(origin, 1.0f, XMFLOAT3(0.0f, 0.5f, 0.0f), 2.0f) == FLT_MAX);
+}
@@ -0,0 +1,165 @@
+﻿/**
+ * @file MeshTriangulatorTests.cpp
+ * @brief Pruebas de MeshTriangulator: quads y n-gonos cóncavos, polígonos con agujero y la pasada por malla.
+ */
+
+#include "TestFramework.h"
+#include "TestGeometry.h"
+#include "MeshTriangulator.h"
+#include "JobSystem.h"
+
+namespace {
+	/// Vértices en el plano XY a partir de pares (x, y).
+	std::vector<SimpleVertex>
+	makePolygonVertices(std::initializer_list<float> coordinates) {
+		std::vector<SimpleVertex> vertices;
+		for (auto it = coordinates.begin(); it != coordinates.end(); it += 2) {
+			SimpleVertex vertex;
+			vertex.Pos = XMFLOAT3(*it, *(it + 1), 0.0f);
+			vertex.Tex = XMFLOAT2(0.0f, 0.0f);
+			vertices.push_back(vertex);
+		}
+		return vertices;
+	}
+
+	/// Doble del área con signo de un triángulo en XY.
+	float
+	signedArea2(const std::vector<SimpleVertex>& vertices, const unsigned int* triangle) {
+		const XMFLOAT3& a = vertices[triangle[0]].Pos;
+		const XMFLOAT3& b = vertices[triangle[1]].Pos;
+		const XMFLOAT3& c = vertices[triangle[2]].Pos;
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	/**
+	 * @brief Triangula un polígono y comprueba que los triángulos lo cubren sin solaparse.
+	 *
+	 * Todos los triángulos giran como el polígono y sus áreas suman la suya: un
+	 * abanico sobre un polígono cóncavo da algún triángulo invertido o de más área.
+	 */
+	bool
+	coversPolygon(const std::vector<SimpleVertex>& vertices,
+		const std::vector<unsigned int>& polygon,
+		float expectedArea2,
+		std::vector<unsigned int>& triangles) {
+		triangles.assign((polygon.size() - 2) * 3, 0);
+		const bool earClipped = MeshTriangulator::triangulatePolygon(vertices, polygon.data(),
+			static_cast<unsigned int>(polygon.size()), triangles.data());
+		float total = 0.0f;
+		for (size_t i = 0; i < triangles.size(); i += 3) {
+			const float area = signedArea2(vertices, &triangles[i]);
+			if (area * expectedArea2 < 0.0f) {
+				return false;
+			}
+			total += area;
+		}
+		return earClipped && NearlyEqual(total, expectedArea2);
+	}
+}
+
+TEST_CASE(MeshTriangulator_ConcaveQuadSplitsThroughReflexVertex) {
+	// Punta de flecha: el vértice 2 es cóncavo, la diagonal 0-2 queda fuera.
+	const std::vector<SimpleVertex> vertices = makePolygonVertices({ 0, 0, 2, 1, 4, 0, 2, 4 });
+	std::vector<unsigned int> triangles;
+	CHECK(coversPolygon(vertices, { 0, 1, 2, 3 }, 2.0f * 6.0f, triangles));
+	// Girado para que el cóncavo sea el 1 y en sentido horario.
+	CHECK(coversPolygon(vertices, { 3, 2, 1, 0 }, -2.0f * 6.0f, triangles));
+	CHECK(coversPolygon(vertices, { 2, 1, 0, 3 }, -2.0f * 6.0f, triangles));
+}
+
+TEST_CASE(MeshTriangulator_ConcaveNgonsAreEarClipped) {
+	// Peine con tres dientes: 10 vértices, varios reflejos seguidos.
+	const std::vector<SimpleVertex> comb = makePolygonVertices({
+		0, 0, 5, 0, 5, 3, 4, 3, 4, 1, 3, 1, 3, 3, 2, 3, 2, 1, 1, 1, 1, 3, 0, 3 });
+	std::vector<unsigned int> polygon(comb.size());
+	for (unsigned int i = 0; i < polygon.size(); ++i) {
+		polygon[i] = i;
+	}
+	// Base 5x1 más tres dientes de 1x2.
+	std::vector<unsigned int> triangles;
+	REQUIRE(coversPolygon(comb, polygon, 2.0f * (5.0f + 3.0f * 2.0f), triangles));
+	CHECK(triangles.size() == (comb.size() - 2) * 3);
+
+	// Estrella de 5 puntas en sentido horario.
+	std::vector<SimpleVertex> star;
+	for (unsigned int i = 0; i < 10; ++i) {
+		const float angle = -static_cast<float>(i) * 3.14159265f / 5.0f;
+		const float radius = (i % 2 == 0) ? 2.0f : 0.8f;
+		SimpleVertex vertex;
+		vertex.Pos = XMFLOAT3(radius * std::cos(angle), radius * std::sin(angle), 0.0f);
+		vertex.Tex = XMFLOAT2(0.0f, 0.0f);
+		star.push_back(vertex);
+	}
+	float starArea2 = 0.0f;
+	for (unsigned int i = 0, j = 9; i < 10; j = i++) {
+		starArea2 += star[j].Pos.x * star[i].Pos.y - star[i].Pos.x * star[j].Pos.y;
+	}
+	std::vector<unsigned int> starPolygon = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	CHECK(starArea2 < 0.0f);
+	CHECK(coversPolygon(star, starPolygon, starArea2, triangles));
+}
+
+TEST_CASE(MeshTriangulator_PolygonWithHoleThroughBridgeEdge) {
+	// Cuadrado 4x4 con un agujero 2x2, unidos por un puente de ida y vuelta (como lo exportan FBX y OBJ).
+	const std::vector<SimpleVertex> vertices = makePolygonVertices({
+		0, 0, 4, 0, 4, 4, 0, 4, 1, 1, 1, 3, 3, 3, 3, 1 });
+	const std::vector<unsigned int> polygon = { 0, 1, 2, 3, 0, 4, 5, 6, 7, 4 };
+	std::vector<unsigned int> triangles;
+	REQUIRE(coversPolygon(vertices, polygon, 2.0f * (16.0f - 4.0f), triangles));
+	CHECK(triangles.size() / 3 == polygon.size() - 2);
+
+	// Ningún triángulo tapa el agujero.
+	for (size_t i = 0; i < triangles.size(); i += 3) {
+		float cx = 0.0f, cy = 0.0f;
+		for (int corner = 0; corner < 3; ++corner) {
+			cx += vertices[triangles[i + corner]].Pos.x / 3.0f;
+			cy += vertices[triangles[i + corner]].Pos.y / 3.0f;
+		}
+		CHECK(!(cx > 1.0f && cx < 3.0f && cy > 1.0f && cy < 3.0f));
+	}
+}
+
+TEST_CASE(MeshTriangulator_TriangulateMeshCountsAndValidates) {
+	const std::vector<SimpleVertex> vertices = makePolygonVertices({
+		0, 0, 4, 0, 4, 4, 0, 4, 2, 1, 1, 1, 1, 3, 3, 3 });
+	// Triángulo, quad, segmento degenerado y pentágono cóncavo.
+	const std::vector<unsigned int> indices = { 0, 1, 2, 0, 1, 2, 3, 5, 6, 0, 1, 2, 4, 3 };
+	const std::vector<unsigned int> sizes = { 3, 4, 2, 5 };
+	std::vector<unsigned int> triangles;
+	TriangulationStats stats;
+	REQUIRE(MeshTriangulator::triangulate(vertices, indices, sizes, triangles, nullptr, &stats));
+	CHECK(triangles.size() == (1 + 2 + 3) * 3);
+	CHECK(stats.polygons == 4);
+	CHECK(stats.triangles == 6);
+	CHECK(stats.quads == 1);
+	CHECK(stats.ngons == 1);
+	CHECK(stats.degenerate == 1);
+	CHECK(stats.fanFallbacks == 0);
+	// El triángulo sale tal cual y cada polígono conserva su rango.
+	CHECK(triangles[0] == 0 && triangles[1] == 1 && triangles[2] == 2);
+
+	// Tamaños que no cuadran o índices fuera de rango se rechazan.
+	CHECK(!MeshTriangulator::triangulate(vertices, indices, { 3, 4 }, triangles));
+	CHECK(!MeshTriangulator::triangulate(vertices, { 0, 1, 99 }, { 3 }, triangles));
+
+	// Muchos polígonos: en paralelo sale lo mismo que en un hilo.
+	std::vector<SimpleVertex> grid;
+	std::vector<unsigned int> gridTriangles;
+	MakeGrid(96, grid, gridTriangles);
+	std::vector<unsigned int> quads;
+	const unsigned int row = 97;
+	for (unsigned int z = 0; z < 96; ++z) {
+		for (unsigned int x = 0; x < 96; ++x) {
+			const unsigned int corner = z * row + x;
+			quads.insert(quads.end(), { corner, corner + row, corner + row + 1, corner + 1 });
+		}
+	}
+	const std::vector<unsigned int> quadSizes(96 * 96, 4);
+	std::vector<unsigned int> serial, parallel;
+	REQUIRE(MeshTriangulator::triangulate(grid, quads, quadSizes, serial));
+	JobSystem jobs;
+	jobs.init(3);
+	REQUIRE(MeshTriangulator::triangulate(grid, quads, quadSizes, parallel, &jobs));
+	CHECK(serial == parallel);
+	CHECK(CanonicalTriangles(grid, serial).size() == 2 * 96 * 96);
+}
@@ -0,0 +1,158 @@
+﻿/**
+ * @file MeshletTests.cpp
+ * @brief Pruebas de MeshletBuilder (límites, reparto y volúmenes) y de MeshletCuller contra el recorrido triángulo a triángulo.
+ */
+
+#include "TestFramework.h"
+#include "TestGeometry.h"
+#include "Meshlet.h"
+#include "MeshComponent.h"
+#include "FrustumCuller.h"
+#include <set>
+
+namespace {
+	/// Rejilla de 48x48 quads con los triángulos barajados, lista para build().
+	void
+	makeShuffledGrid(MeshComponent& mesh) {
+		MakeGrid(48, mesh.m_vertex, mesh.m_index);
+		ShuffleTriangles(mesh.m_index, 7);
+		mesh.m_numIndex = static_cast<int>(mesh.m_index.size());
+	}
+
+	/// Cámara sobre la rejilla mirando hacia su centro (o desde debajo con eyeY negativo).
+	XMMATRIX
+	makeViewProjection(float eyeY, float targetX) {
+		const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(targetX, eyeY, -10.0f, 1.0f),
+			XMVectorSet(targetX, 0.0f, 24.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		return view * XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.5f, 200.0f);
+	}
+
+	/// Triángulos que dibujan unos rangos.
+	unsigned int
+	countTriangles(const std::vector<MeshletDrawRange>& ranges) {
+		unsigned int count = 0;
+		for (const MeshletDrawRange& range : ranges) {
+			count += range.indexCount / 3;
+		}
+		return count;
+	}
+
+	/// true si todos los vértices del meshlet quedan detrás de un mismo plano del frustum.
+	bool
+	outsideOnePlane(const MeshComponent& mesh, const Meshlet& meshlet, const Frustum& frustum) {
+		for (const XMFLOAT4& plane : frustum.planes) {
+			bool allBehind = true;
+			for (unsigned int i = 0; i < meshlet.triangleCount * 3 && allBehind; ++i) {
+				const XMFLOAT3& p = mesh.m_vertex[mesh.m_index[meshlet.indexOffset + i]].Pos;
+				allBehind = plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f;
+			}
+			if (allBehind) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+TEST_CASE(MeshletBuilder_RespectsLimitsAndKeepsTriangles) {
+	MeshComponent mesh;
+	makeShuffledGrid(mesh);
+	const std::vector<TrianglePositions> original = CanonicalTriangles(mesh.m_vertex, mesh.m_index);
+
+	MeshletBuildStats stats;
+	MeshletBuilder::build(mesh, &stats);
+	REQUIRE(!mesh.m_meshlets.empty());
+	CHECK(stats.meshes == 1);
+	CHECK(stats.meshlets == mesh.m_meshlets.size());
+	CHECK(stats.triangles == original.size());
+	// Mismos triángulos, solo en otro orden.
+	CHECK(CanonicalTriangles(mesh.m_vertex, mesh.m_index) == original);
+
+	unsigned int nextOffset = 0;
+	unsigned int vertexSum = 0;
+	for (const Meshlet& meshlet : mesh.m_meshlets) {
+		// Rangos contiguos y consecutivos del index buffer.
+		CHECK(meshlet.indexOffset == nextOffset);
+		nextOffset += meshlet.triangleCount * 3;
+		CHECK(meshlet.triangleCount > 0 && meshlet.triangleCount <= MeshletBuilder::kMaxTriangles);
+
+		std::set<unsigned int> unique(mesh.m_index.begin() + meshlet.indexOffset,
+			mesh.m_index.begin() + meshlet.indexOffset + meshlet.triangleCount * 3);
+		CHECK(meshlet.vertexCount == unique.size());
+		CHECK(meshlet.vertexCount <= MeshletBuilder::kMaxVertices);
+		vertexSum += meshlet.vertexCount;
+
+		// La esfera contiene sus vértices y el cono de una rejilla plana es su normal.
+		for (unsigned int index : unique) {
+			const XMFLOAT3& p = mesh.m_vertex[index].Pos;
+			const float dx = p.x - meshlet.sphere.x, dy = p.y - meshlet.sphere.y, dz = p.z - meshlet.sphere.z;
+			CHECK(std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.sphere.w * 1.0001f);
+		}
+		CHECK(NearlyEqual(meshlet.cone.y, 1.0) && NearlyEqual(meshlet.cone.w, 0.0, 1e-3));
+	}
+	CHECK(nextOffset == mesh.m_index.size());
+	CHECK(stats.vertices == vertexSum);
+	// Agrupar por vecindad reutiliza vértices: de media bastante más de un triángulo por vértice.
+	CHECK(vertexSum < stats.triangles);
+
+	// Una malla que cabe en un meshlet no se divide.
+	MeshComponent small;
+	MakeGrid(7, small.m_vertex, small.m_index);
+	small.m_numIndex = static_cast<int>(small.m_index.size());
+	MeshletBuilder::build(small);
+	CHECK(small.m_meshlets.empty());
+}
+
+TEST_CASE(MeshletCuller_MatchesPerVertexFrustumAndConeTests) {
+	MeshComponent mesh;
+	makeShuffledGrid(mesh);
+	MeshletBuilder::build(mesh);
+	REQUIRE(mesh.m_meshlets.size() > 8);
+	MeshletCuller culler;
+	culler.init(mesh.m_meshlets);
+	REQUIRE(!culler.isEmpty());
+
+	// Desde arriba y mirando a una esquina: parte de la rejilla queda fuera del frustum.
+	const XMMATRIX viewProjection = makeViewProjection(20.0f, -20.0f);
+	const Frustum frustum = Frustum::fromMatrix(viewProjection);
+	std::vector<MeshletDrawRange> ranges;
+	MeshletCullStats stats;
+	culler.cull(viewProjection, XMFLOAT3(-20.0f, 20.0f, -10.0f), true, ranges, stats);
+	CHECK(stats.meshlets == mesh.m_meshlets.size());
+	CHECK(stats.frustumCulled > 0);
+	CHECK(stats.frustumCulled < stats.meshlets);
+	CHECK(stats.backfaceCulled == 0);
+
+	// Cada meshlet descartado está entero fuera, y los dibujados son exactamente el resto.
+	std::vector<bool> drawn(mesh.m_index.size() / 3, false);
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		if (i > 0) {
+			// Los rangos contiguos se fusionan.
+			CHECK(ranges[i - 1].indexOffset + ranges[i - 1].indexCount < ranges[i].indexOffset);
+		}
+		for (unsigned int t = ranges[i].indexOffset / 3; t < (ranges[i].indexOffset + ranges[i].indexCount) / 3; ++t) {
+			drawn[t] = true;
+		}
+	}
+	CHECK(stats.ranges == ranges.size());
+	CHECK(countTriangles(ranges) + stats.culledTriangles == stats.triangles);
+	for (const Meshlet& meshlet : mesh.m_meshlets) {
+		if (!drawn[meshlet.indexOffset / 3]) {
+			CHECK(outsideOnePlane(mesh, meshlet, frustum));
+		}
+	}
+
+	// Desde debajo todos los meshlets dan la espalda; sin el test del cono se dibuja lo mismo que desde arriba.
+	const XMMATRIX below = makeViewProjection(-60.0f, 24.0f);
+	MeshletCullStats fromBelow;
+	culler.cull(below, XMFLOAT3(24.0f, -60.0f, -10.0f), true, ranges, fromBelow);
+	CHECK(ranges.empty());
+	CHECK(fromBelow.culledTriangles == fromBelow.triangles);
+	CHECK(fromBelow.backfaceCulled > 0);
+
+	MeshletCullStats noCone;
+	culler.cull(below, XMFLOAT3(24.0f, -60.0f, -10.0f), false, ranges, noCone);
+	CHECK(noCone.backfaceCulled == 0);
+	CHECK(!ranges.empty());
+	CHECK(countTriangles(ranges) + noCone.culledTriangles == noCone.triangles);
+}
@@ -0,0 +1,163 @@
+﻿/**
+ * @file NullBackendTests.cpp
+ * @brief Frames completos grabados sin dispositivo: cola de dibujo, DeviceContext y NullBackend con sus propias asas.
+ */
+
+#include "TestFramework.h"
+#include "NullBackend.h"
+#include "RenderQueue.h"
+#include "DeviceContext.h"
+
+namespace {
+	/// Asas de una escena pequeña creadas por el backend: nada viene de Device.
+	struct HeadlessScene {
+		ID3D11VertexShader* vertexShader = nullptr;
+		ID3D11PixelShader* pixelShader = nullptr;
+		ID3D11InputLayout* inputLayout = nullptr;
+		ID3D11SamplerState* sampler = nullptr;
+		ID3D11ShaderResourceView* textures[2] = {};
+		ID3D11Buffer* vertexBuffers[2] = {};
+		ID3D11Buffer* indexBuffer = nullptr;
+		ID3D11Buffer* constantBuffer = nullptr;
+	};
+
+	const unsigned int kConstantBytes = 64;
+	const unsigned int kActors = 24;
+	const unsigned int kIndicesPerActor = 36;
+
+	HeadlessScene
+	makeScene(NullBackend& backend) {
+		HeadlessScene scene;
+		scene.vertexShader = backend.createResource<ID3D11VertexShader>(RESOURCE_VERTEX_SHADER);
+		scene.pixelShader = backend.createResource<ID3D11PixelShader>(RESOURCE_PIXEL_SHADER);
+		scene.inputLayout = backend.createResource<ID3D11InputLayout>(RESOURCE_INPUT_LAYOUT);
+		scene.sampler = backend.createResource<ID3D11SamplerState>(RESOURCE_SAMPLER_STATE);
+		for (int i = 0; i < 2; ++i) {
+			scene.textures[i] = backend.createResource<ID3D11ShaderResourceView>(RESOURCE_SHADER_RESOURCE_VIEW);
+			scene.vertexBuffers[i] = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, 4096, D3D11_BIND_VERTEX_BUFFER);
+		}
+		scene.indexBuffer = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, 1024, D3D11_BIND_INDEX_BUFFER);
+		scene.constantBuffer = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, kConstantBytes,
+			D3D11_BIND_CONSTANT_BUFFER);
+		return scene;
+	}
+
+	/// Un frame: cada actor con su malla, su textura y sus constantes.
+	void
+	pushFrame(RenderQueue& queue, const HeadlessScene& scene, unsigned int frame, std::vector<float>& constants) {
+		constants.assign(kActors * kConstantBytes / sizeof(float), 0.0f);
+		queue.begin();
+		for (unsigned int actor = 0; actor < kActors; ++actor) {
+			float* data = &constants[actor * kConstantBytes / sizeof(float)];
+			data[0] = static_cast<float>(frame);
+			data[1] = static_cast<float>(actor);
+
+			DrawPacket packet;
+			packet.vertexShader = scene.vertexShader;
+			packet.pixelShader = scene.pixelShader;
+			packet.inputLayout = scene.inputLayout;
+			packet.sampler = scene.sampler;
+			packet.texture = scene.textures[actor % 2];
+			packet.vertexBuffer = scene.vertexBuffers[actor % 2];
+			packet.vertexStride = 32;
+			packet.indexBuffer = scene.indexBuffer;
+			packet.constantBuffer = scene.constantBuffer;
+			packet.constantData = data;
+			packet.constantSize = kConstantBytes;
+			packet.indexCount = kIndicesPerActor;
+			queue.push(packet, RENDER_PASS_OPAQUE, static_cast<float>(actor));
+		}
+	}
+}
+
+TEST_CASE(NullBackend_RecordsHeadlessFrames) {
+	NullBackend backend;
+	const HeadlessScene scene = makeScene(backend);
+	DeviceContext context;
+	// El seguimiento de subidas retiene los buffers con AddRef: las asas del backend no son objetos COM.
+	context.setSkipUnchangedUploads(false);
+	context.setBackend(&backend);
+
+	const unsigned int kFrames = 8;
+	RenderQueue queue;
+	std::vector<float> constants;
+	unsigned int queueDraws = 0;
+	unsigned int queueUploads = 0;
+	for (unsigned int frame = 0; frame < kFrames; ++frame) {
+		backend.beginFrame();
+		context.beginFrame();
+		pushFrame(queue, scene, frame, constants);
+		queue.sort(nullptr);
+		queue.submit(&context);
+		queueDraws += queue.getStats().drawCalls;
+		queueUploads += queue.getStats().uploads;
+	}
+	context.setBackend(nullptr);
+
+	// Todo lo que la cola emitió llegó al backend: un draw y una subida por actor y frame.
+	const NullBackendStats stats = backend.getStats();
+	CHECK(stats.frames == kFrames);
+	CHECK(queueDraws == kFrames * kActors);
+	CHECK(stats.draws == queueDraws);
+	CHECK(stats.counts[CMD_DRAW_INDEXED] == queueDraws);
+	CHECK(stats.indices == static_cast<uint64_t>(queueDraws) * kIndicesPerActor);
+	CHECK(stats.uploads == queueUploads);
+	CHECK(stats.uploadBytes == static_cast<uint64_t>(queueUploads) * kConstantBytes);
+	// La caché de estado deja menos binds que draws: los actores comparten shaders y buffers.
+	CHECK(stats.binds > 0);
+	CHECK(stats.binds < stats.draws * 2);
+	CHECK(stats.resources == 10);
+
+	// Las asas llegan al stream con lo que se dijo al crearlas.
+	const NullResource* vertexBuffer = backend.findResource(scene.vertexBuffers[1]);
+	REQUIRE(vertexBuffer);
+	CHECK(vertexBuffer->kind == RESOURCE_BUFFER);
+	CHECK(vertexBuffer->bytes == 4096);
+	CHECK(vertexBuffer->flags == D3D11_BIND_VERTEX_BUFFER);
+	CHECK(vertexBuffer->binds > 0);
+	const NullResource* constantBuffer = backend.findResource(scene.constantBuffer);
+	REQUIRE(constantBuffer);
+	CHECK(constantBuffer->updates == queueUploads);
+
+	// El stream se lee sin dispositivo y cuenta lo mismo.
+	const CommandStreamStats streamStats = analyzeCommandStream(backend.getStream());
+	CHECK(streamStats.valid);
+	CHECK(streamStats.frames == kFrames);
+	CHECK(streamStats.draws == stats.draws);
+	CHECK(streamStats.binds == stats.binds);
+	CHECK(streamStats.resources == stats.resources);
+	CHECK(streamStats.uploadBytes == stats.uploadBytes);
+}
+
+TEST_CASE(NullBackend_MapsOwnHandlesAndSurvivesReset) {
+	NullBackend backend;
+	ID3D11Buffer* sized = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER, 256, D3D11_BIND_CONSTANT_BUFFER);
+	ID3D11Buffer* unsized = backend.createResource<ID3D11Buffer>(RESOURCE_BUFFER);
+	CHECK(sized != unsized);
+
+	BackendMappedSubresource mapped;
+	REQUIRE(!isBackendFailure(backend.Map(reinterpret_cast<ID3D11Resource*>(sized), 0,
+		BACKEND_MAP_WRITE_DISCARD, 0, &mapped)));
+	REQUIRE(mapped.pData);
+	CHECK(mapped.RowPitch == 256);
+	static_cast<uint8_t*>(mapped.pData)[255] = 7;
+	backend.Unmap(reinterpret_cast<ID3D11Resource*>(sized), 0);
+	CHECK(backend.getStats().maps == 1);
+
+	// Sin tamaño no hay memoria que devolver.
+	CHECK(isBackendFailure(backend.Map(reinterpret_cast<ID3D11Resource*>(unsized), 0,
+		BACKEND_MAP_WRITE_DISCARD, 0, &mapped)));
+
+	// reset() olvida lo visto, pero las asas siguen describiéndose solas.
+	backend.reset();
+	CHECK(backend.findResource(sized) == nullptr);
+	CHECK(backend.getStats().resources == 0);
+	ID3D11Buffer* const buffers[1] = { sized };
+	backend.VSSetConstantBuffers(0, 1, buffers);
+	const NullResource* entry = backend.findResource(sized);
+	REQUIRE(entry);
+	CHECK(entry->id == 1);
+	CHECK(entry->bytes == 256);
+	CHECK(entry->flags == D3D11_BIND_CONSTANT_BUFFER);
+	CHECK(backend.getStats().binds == 1);
+}
@@ -0,0 +1,152 @@
+﻿/**
+ * @file ObjectCacheTests.cpp
+ * @brief Pruebas de ObjectCache con objetos COM simulados: referencias y creación concurrente de la misma clave.
+ */
+
+#include "TestFramework.h"
+#include "ObjectCache.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+	/// Objeto COM que solo cuenta referencias (no se destruye al llegar a 0).
+	class MockObject : public IUnknown {
+	public:
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** object) override {
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+		ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refs; }
+		ULONG STDMETHODCALLTYPE Release() override { return --m_refs; }
+
+		std::atomic<ULONG> m_refs{ 1 }; ///< Empieza con la referencia de quien lo crea.
+	};
+
+	/// Bytecode simulado.
+	class MockBlob : public ID3DBlob {
+	public:
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** object) override {
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+		ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refs; }
+		ULONG STDMETHODCALLTYPE Release() override { return --m_refs; }
+		LPVOID STDMETHODCALLTYPE GetBufferPointer() override { return m_data; }
+		SIZE_T STDMETHODCALLTYPE GetBufferSize() override { return sizeof(m_data); }
+
+		std::atomic<ULONG> m_refs{ 1 };
+		char m_data[4] = {};
+	};
+}
+
+TEST_CASE(ObjectCache_FindReturnsInsertedObjectWithReference) {
+	ObjectCache cache;
+	MockObject object;
+	const unsigned int key = 42;
+	CHECK(cache.find(CACHED_SAMPLER, &key, sizeof(key)) == nullptr);
+	IUnknown* kept = cache.insert(CACHED_SAMPLER, &key, sizeof(key), &object);
+	CHECK(kept == &object);
+	object.Release();
+	// Caché + llamador.
+	CHECK(object.m_refs == 2);
+
+	IUnknown* found = cache.find(CACHED_SAMPLER, &key, sizeof(key));
+	CHECK(found == &object);
+	CHECK(object.m_refs == 3);
+	// Misma clave con otro tipo: no se comparte.
+	CHECK(cache.find(CACHED_BLEND, &key, sizeof(key)) == nullptr);
+
+	found->Release();
+	kept->Release();
+	cache.clear();
+	CHECK(object.m_refs == 0);
+	const ObjectCacheStats stats = cache.getStats();
+	CHECK(stats.hits[CACHED_SAMPLER] == 1);
+	CHECK(stats.misses[CACHED_SAMPLER] == 1);
+	CHECK(stats.misses[CACHED_BLEND] == 1);
+}
+
+TEST_CASE(ObjectCache_SecondInsertOfSameKeyReturnsExisting) {
+	ObjectCache cache;
+	MockObject first, second;
+	MockBlob firstCode, secondCode;
+	const char key[] = "vs_4_0";
+
+	ID3DBlob* code = nullptr;
+	IUnknown* a = cache.insert(CACHED_VERTEX_SHADER, key, sizeof(key), &first, &firstCode, &code);
+	CHECK(a == &first && code == &firstCode);
+	first.Release();
+	firstCode.Release();
+
+	// Otro hilo compiló lo mismo a la vez: recibe lo guardado y suelta lo suyo.
+	ID3DBlob* sharedCode = nullptr;
+	IUnknown* b = cache.insert(CACHED_VERTEX_SHADER, key, sizeof(key), &second, &secondCode, &sharedCode);
+	CHECK(b == &first);
+	CHECK(sharedCode == &firstCode);
+	second.Release();
+	secondCode.Release();
+	CHECK(second.m_refs == 0);
+	CHECK(secondCode.m_refs == 0);
+	CHECK(cache.getStats().objects == 1);
+
+	a->Release();
+	b->Release();
+	code->Release();
+	sharedCode->Release();
+	cache.clear();
+	CHECK(first.m_refs == 0);
+	CHECK(firstCode.m_refs == 0);
+}
+
+TEST_CASE(ObjectCache_ConcurrentCreatorsShareOneObject) {
+	const unsigned int kThreads = 8;
+	const unsigned int kRounds = 20;
+	for (unsigned int round = 0; round < kRounds; ++round) {
+		ObjectCache cache;
+		MockObject objects[kThreads];
+		IUnknown* results[kThreads] = {};
+		bool created[kThreads] = {};
+		std::atomic<unsigned int> arrived{ 0 }, searched{ 0 };
+		auto barrier = [&](std::atomic<unsigned int>& counter) {
+			++counter;
+			while (counter < kThreads) {
+				std::this_thread::yield();
+			}
+		};
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < kThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				const unsigned int key = round;
+				barrier(arrived);
+				// Lo mismo que Device::Create*State: buscar, crear si falta y guardar. La barrera entre
+				// find() e insert() fuerza el caso malo: todos fallan la búsqueda antes de que nadie guarde.
+				IUnknown* object = cache.find(CACHED_RASTERIZER, &key, sizeof(key));
+				barrier(searched);
+				if (!object) {
+					created[t] = true;
+					object = cache.insert(CACHED_RASTERIZER, &key, sizeof(key), &objects[t]);
+					objects[t].Release();
+				}
+				results[t] = object;
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		for (unsigned int t = 1; t < kThreads; ++t) {
+			REQUIRE(results[t] == results[0]);
+		}
+		REQUIRE(cache.getStats().objects == 1);
+		// El objeto compartido: caché + cada hilo; los duplicados ya se soltaron y los no usados siguen intactos.
+		REQUIRE(created[static_cast<MockObject*>(results[0]) - objects]);
+		for (unsigned int t = 0; t < kThreads; ++t) {
+			const ULONG expected = &objects[t] == results[0] ? kThreads + 1 : (created[t] ? 0 : 1);
+			REQUIRE(objects[t].m_refs == expected);
+		}
+		for (IUnknown* result : results) {
+			result->Release();
+		}
+		cache.clear();
+	}
+}
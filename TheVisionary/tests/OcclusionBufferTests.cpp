@@ -0,0 +1,40 @@
+﻿/**
+ * @file OcclusionBufferTests.cpp
+ * @brief Pruebas de OcclusionBuffer contra la profundidad de referencia versionada en Golden.
+ *
+ * Las rutas son relativas al directorio del proyecto (el de trabajo por
+ * defecto al depurar en Visual Studio).
+ */
+
+#include "TestFramework.h"
+#include "OcclusionBuffer.h"
+#include "JobSystem.h"
+#include <filesystem>
+
+namespace {
+	const char* kGoldenPath = "Golden/OcclusionScene.vdepth";
+	const char* kMissingPath = "Golden/Missing.vdepth";
+}
+
+TEST_CASE(OcclusionBuffer_MatchesGoldenDepth) {
+	JobSystem jobs;
+	jobs.init(3);
+	const OcclusionGoldenResult golden = OcclusionBuffer::checkGolden(kGoldenPath, false, &jobs);
+	REQUIRE(golden.goldenFound);
+	CHECK(golden.sizeMatches);
+	CHECK(golden.mismatched == 0);
+	CHECK(golden.serialMatchesParallel);
+	CHECK(golden.visibilityMatches);
+	CHECK(golden.passed());
+	CHECK(!golden.rewritten);
+}
+
+TEST_CASE(OcclusionBuffer_MissingGoldenFailsWithoutWriting) {
+	std::error_code ec;
+	std::filesystem::remove(kMissingPath, ec);
+	const OcclusionGoldenResult golden = OcclusionBuffer::checkGolden(kMissingPath, false, nullptr);
+	CHECK(!golden.goldenFound);
+	CHECK(!golden.passed());
+	CHECK(!golden.rewritten);
+	CHECK(!std::filesystem::exists(kMissingPath, ec));
+}
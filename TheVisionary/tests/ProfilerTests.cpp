@@ -0,0 +1,509 @@
+﻿/**
+ * @file ProfilerTests.cpp
+ * @brief Pruebas del profiler: zonas anidadas y contadores en dos hilos, anillo lleno y la traza de Chrome.
+ *
+ * El profiler es único en el proceso: cada prueba llama a beginFrame()
+ * exactamente kWindow veces para que publique una ventana entera suya.
+ */
+
+#include "TestFramework.h"
+#include "TestFiles.h"
+#include "Profiler.h"
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+	const unsigned int kFloodZones = 40000; ///< Zonas del hilo que llena su anillo (más de kRingCapacity eventos).
+
+	/**
+	 * @struct JsonValue
+	 * @brief Valor de un documento JSON (lo justo para leer la traza).
+	 */
+	struct JsonValue {
+		enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+		Type type = JSON_NULL;          ///< Tipo del valor.
+		double number = 0.0;            ///< JSON_NUMBER (y 1/0 en JSON_BOOL).
+		std::string text;               ///< JSON_STRING, ya sin escapes.
+		std::vector<std::string> keys;  ///< Claves de JSON_OBJECT, en orden.
+		std::vector<JsonValue> items;   ///< Elementos de JSON_ARRAY o valores de JSON_OBJECT.
+
+		/** Miembro de un objeto (nullptr si no está). */
+		const JsonValue*
+		find(const char* key) const {
+			for (size_t i = 0; i < keys.size(); ++i) {
+				if (keys[i] == key) {
+					return &items[i];
+				}
+			}
+			return nullptr;
+		}
+
+		/** Texto de un miembro (vacío si no está o no es una cadena). */
+		std::string
+		getText(const char* key) const {
+			const JsonValue* value = find(key);
+			return value && value->type == JSON_STRING ? value->text : std::string();
+		}
+
+		/** Número de un miembro (-1 si no está o no es un número). */
+		double
+		getNumber(const char* key) const {
+			const JsonValue* value = find(key);
+			return value && value->type == JSON_NUMBER ? value->number : -1.0;
+		}
+	};
+
+	/**
+	 * @class JsonParser
+	 * @brief Lector estricto de JSON (RFC 8259): rechaza comillas sin escapar, controles y basura al final.
+	 */
+	class JsonParser {
+	public:
+		explicit JsonParser(const std::string& text) : m_text(text) {}
+
+		/** Lee el documento entero. */
+		bool
+		parse(JsonValue& value) {
+			m_pos = 0;
+			if (!parseValue(value, 0)) {
+				return false;
+			}
+			skipSpace();
+			return m_pos == m_text.size();
+		}
+
+	private:
+		void
+		skipSpace() {
+			while (m_pos < m_text.size() &&
+				(m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r' || m_text[m_pos] == '\n')) {
+				++m_pos;
+			}
+		}
+
+		bool
+		accept(char c) {
+			skipSpace();
+			if (m_pos < m_text.size() && m_text[m_pos] == c) {
+				++m_pos;
+				return true;
+			}
+			return false;
+		}
+
+		bool
+		acceptWord(const char* word) {
+			const size_t length = std::strlen(word);
+			if (m_text.compare(m_pos, length, word) != 0) {
+				return false;
+			}
+			m_pos += length;
+			return true;
+		}
+
+		bool
+		isDigit(size_t pos) const {
+			return pos < m_text.size() && m_text[pos] >= '0' && m_text[pos] <= '9';
+		}
+
+		bool
+		parseValue(JsonValue& value, unsigned int depth) {
+			skipSpace();
+			if (m_pos >= m_text.size() || depth > 64) {
+				return false;
+			}
+			const char c = m_text[m_pos];
+			if (c == '{') {
+				value.type = JsonValue::JSON_OBJECT;
+				++m_pos;
+				if (accept('}')) {
+					return true;
+				}
+				do {
+					std::string key;
+					skipSpace();
+					if (!parseString(key) || !accept(':')) {
+						return false;
+					}
+					value.keys.push_back(key);
+					value.items.emplace_back();
+					if (!parseValue(value.items.back(), depth + 1)) {
+						return false;
+					}
+				} while (accept(','));
+				return accept('}');
+			}
+			if (c == '[') {
+				value.type = JsonValue::JSON_ARRAY;
+				++m_pos;
+				if (accept(']')) {
+					return true;
+				}
+				do {
+					value.items.emplace_back();
+					if (!parseValue(value.items.back(), depth + 1)) {
+						return false;
+					}
+				} while (accept(','));
+				return accept(']');
+			}
+			if (c == '"') {
+				value.type = JsonValue::JSON_STRING;
+				return parseString(value.text);
+			}
+			if (acceptWord("true")) {
+				value.type = JsonValue::JSON_BOOL;
+				value.number = 1.0;
+				return true;
+			}
+			if (acceptWord("false")) {
+				value.type = JsonValue::JSON_BOOL;
+				return true;
+			}
+			if (acceptWord("null")) {
+				value.type = JsonValue::JSON_NULL;
+				return true;
+			}
+			value.type = JsonValue::JSON_NUMBER;
+			return parseNumber(value.number);
+		}
+
+		bool
+		parseString(std::string& out) {
+			if (m_pos >= m_text.size() || m_text[m_pos] != '"') {
+				return false;
+			}
+			++m_pos;
+			out.clear();
+			while (m_pos < m_text.size()) {
+				const char c = m_text[m_pos++];
+				if (c == '"') {
+					return true;
+				}
+				if (static_cast<unsigned char>(c) < 0x20) {
+					return false;
+				}
+				if (c != '\\') {
+					out += c;
+					continue;
+				}
+				if (m_pos >= m_text.size()) {
+					return false;
+				}
+				const char escape = m_text[m_pos++];
+				switch (escape) {
+				case '"': case '\\': case '/': out += escape; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u': {
+					if (m_pos + 4 > m_text.size()) {
+						return false;
+					}
+					char* end = nullptr;
+					const std::string hex = m_text.substr(m_pos, 4);
+					const long code = std::strtol(hex.c_str(), &end, 16);
+					if (end != hex.c_str() + 4) {
+						return false;
+					}
+					out += code < 0x80 ? static_cast<char>(code) : '?';
+					m_pos += 4;
+					break;
+				}
+				default:
+					return false;
+				}
+			}
+			return false;
+		}
+
+		bool
+		parseNumber(double& out) {
+			const size_t start = m_pos;
+			if (m_pos < m_text.size() && m_text[m_pos] == '-') {
+				++m_pos;
+			}
+			if (!isDigit(m_pos)) {
+				return false;
+			}
+			while (isDigit(m_pos)) {
+				++m_pos;
+			}
+			if (m_pos < m_text.size() && m_text[m_pos] == '.') {
+				if (!isDigit(++m_pos)) {
+					return false;
+				}
+				while (isDigit(m_pos)) {
+					++m_pos;
+				}
+			}
+			if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+				++m_pos;
+				if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-')) {
+					++m_pos;
+				}
+				if (!isDigit(m_pos)) {
+					return false;
+				}
+				while (isDigit(m_pos)) {
+					++m_pos;
+				}
+			}
+			out = std::strtod(m_text.substr(start, m_pos - start).c_str(), nullptr);
+			return true;
+		}
+
+		const std::string& m_text; ///< Documento.
+		size_t m_pos = 0;          ///< Siguiente carácter.
+	};
+
+	const ProfileZoneStats*
+	findZone(const char* name) {
+		for (const ProfileZoneStats& zone : Profiler::get().getZones()) {
+			if (std::strcmp(zone.name, name) == 0) {
+				return &zone;
+			}
+		}
+		return nullptr;
+	}
+
+	const ProfileCounterStats*
+	findCounter(const char* name) {
+		for (const ProfileCounterStats& counter : Profiler::get().getCounters()) {
+			if (std::strcmp(counter.name, name) == 0) {
+				return &counter;
+			}
+		}
+		return nullptr;
+	}
+
+	/// Llamadas de la ventana (zone.calls es por frame).
+	long
+	windowCalls(const ProfileZoneStats& zone) {
+		return std::lround(zone.calls * Profiler::kWindow);
+	}
+
+	/// Eventos de la traza con ese nombre y fase.
+	std::vector<const JsonValue*>
+	traceEvents(const JsonValue& events, const char* name, const char* phase) {
+		std::vector<const JsonValue*> found;
+		for (const JsonValue& event : events.items) {
+			if (event.getText("name") == name && event.getText("ph") == phase) {
+				found.push_back(&event);
+			}
+		}
+		return found;
+	}
+
+	/**
+	 * @brief Cuenta las zonas hijas que no caen dentro de una zona padre del mismo hilo.
+	 * @note ts y dur van con tres decimales: se admite 1 ns de redondeo.
+	 */
+	unsigned int
+	countUnpaired(const std::vector<const JsonValue*>& children, const std::vector<const JsonValue*>& parents) {
+		unsigned int unpaired = 0;
+		for (const JsonValue* child : children) {
+			const double start = child->getNumber("ts");
+			const double end = start + child->getNumber("dur");
+			bool inside = false;
+			for (const JsonValue* parent : parents) {
+				const double parentStart = parent->getNumber("ts");
+				const double parentEnd = parentStart + parent->getNumber("dur");
+				if (parent->getNumber("tid") == child->getNumber("tid") &&
+					start >= parentStart - 0.002 && end <= parentEnd + 0.002) {
+					inside = true;
+					break;
+				}
+			}
+			unpaired += inside ? 0 : 1;
+		}
+		return unpaired;
+	}
+}
+
+TEST_CASE(Profiler_NestedZonesAndCountersAcrossThreadsExport) {
+	Profiler& profiler = Profiler::get();
+	const fs::path dir = MakeTestDirectory("ProfilerTrace");
+	const std::string path = (dir / "Capture" / "Trace.json").string();
+
+	Profiler::setThreadName("Tests main");
+	REQUIRE(profiler.startCapture(3, path));
+	CHECK(Profiler::isEnabled());
+	CHECK(!profiler.startCapture(3, path));
+
+	// El trabajador deja todo en su anillo antes de la primera recogida y termina.
+	std::thread worker([]() {
+		Profiler::setThreadName("Tests \"worker\"");
+		for (unsigned int i = 0; i < Profiler::kWindow; ++i) {
+			PROFILE_SCOPE("Worker job");
+			{
+				PROFILE_SCOPE("Worker \"step\" \\ a\tb");
+			}
+			PROFILE_COUNTER("Worker items", i);
+		}
+	});
+	worker.join();
+
+	for (unsigned int frame = 0; frame < Profiler::kWindow; ++frame) {
+		{
+			PROFILE_SCOPE("Main frame");
+			for (int i = 0; i < 2; ++i) {
+				PROFILE_SCOPE("Main inner");
+			}
+			PROFILE_COUNTER("Main count", frame);
+		}
+		profiler.beginFrame();
+	}
+	Profiler::setEnabled(false);
+	CHECK(!profiler.isCapturing());
+
+	const ProfilerStats& stats = profiler.getStats();
+	CHECK(stats.frames == Profiler::kWindow);
+	CHECK(stats.dropped == 0);
+	CHECK(stats.captureFrames == 0);
+
+	// Árbol por hilo: la misma zona bajo el mismo padre es un nodo, con sus llamadas por frame.
+	const ProfileZoneStats* mainFrame = findZone("Main frame");
+	const ProfileZoneStats* mainInner = findZone("Main inner");
+	const ProfileZoneStats* workerJob = findZone("Worker job");
+	const ProfileZoneStats* workerStep = findZone("Worker \"step\" \\ a\tb");
+	REQUIRE(mainFrame && mainInner && workerJob && workerStep);
+	CHECK(mainFrame->depth == 0 && mainInner->depth == 1);
+	CHECK(workerJob->depth == 0 && workerStep->depth == 1);
+	CHECK(windowCalls(*mainFrame) == Profiler::kWindow);
+	CHECK(windowCalls(*mainInner) == 2 * Profiler::kWindow);
+	CHECK(windowCalls(*workerJob) == Profiler::kWindow);
+	CHECK(windowCalls(*workerStep) == Profiler::kWindow);
+	CHECK(mainInner->thread == mainFrame->thread);
+	CHECK(workerStep->thread == workerJob->thread);
+	CHECK(workerJob->thread != mainFrame->thread);
+	CHECK(mainInner->avgMs <= mainFrame->avgMs);
+	CHECK(mainFrame->selfMs <= mainFrame->avgMs);
+	CHECK(mainFrame->selfMs >= 0.0);
+
+	for (const char* name : { "Main count", "Worker items" }) {
+		const ProfileCounterStats* counter = findCounter(name);
+		REQUIRE(counter != nullptr);
+		CHECK(counter->samples == Profiler::kWindow);
+		CHECK(counter->last == Profiler::kWindow - 1);
+		CHECK(counter->max == Profiler::kWindow - 1);
+		CHECK(NearlyEqual(counter->average, (Profiler::kWindow - 1) * 0.5, 1e-9));
+	}
+
+	const std::vector<ProfileThreadStats>& threads = profiler.getThreads();
+	REQUIRE(mainFrame->thread < threads.size() && workerJob->thread < threads.size());
+	CHECK(threads[mainFrame->thread].name == "Tests main");
+	CHECK(threads[workerJob->thread].name == "Tests \"worker\"");
+
+	// La traza es JSON válido pese a las comillas, barras y tabuladores de los nombres.
+	const std::string text = ReadTestFile(path);
+	JsonValue trace;
+	REQUIRE(JsonParser(text).parse(trace));
+	REQUIRE(trace.type == JsonValue::JSON_OBJECT);
+	CHECK(trace.getText("displayTimeUnit") == "ms");
+	const JsonValue* events = trace.find("traceEvents");
+	REQUIRE(events && events->type == JsonValue::JSON_ARRAY);
+
+	bool namedWorker = false;
+	for (const JsonValue* meta : traceEvents(*events, "thread_name", "M")) {
+		const JsonValue* args = meta->find("args");
+		namedWorker = namedWorker || (args && args->getText("name") == "Tests \"worker\"");
+	}
+	CHECK(namedWorker);
+
+	// Tres frames grabados: las zonas del hilo principal de esos frames y todo lo del trabajador.
+	const std::vector<const JsonValue*> frames = traceEvents(*events, "Main frame", "X");
+	const std::vector<const JsonValue*> inners = traceEvents(*events, "Main inner", "X");
+	const std::vector<const JsonValue*> jobs = traceEvents(*events, "Worker job", "X");
+	const std::vector<const JsonValue*> steps = traceEvents(*events, "Worker \"step\" \\ a b", "X");
+	CHECK(frames.size() == 3);
+	CHECK(inners.size() == 6);
+	CHECK(jobs.size() == Profiler::kWindow);
+	CHECK(steps.size() == Profiler::kWindow);
+	CHECK(traceEvents(*events, "Main count", "C").size() == 3);
+	CHECK(traceEvents(*events, "Worker items", "C").size() == Profiler::kWindow);
+	unsigned int boundaries = 0;
+	for (const JsonValue& event : events->items) {
+		boundaries += event.getText("ph") == "i" ? 1 : 0;
+	}
+	CHECK(boundaries == 3);
+
+	// Cada cierre se empareja con su apertura: las hijas caen dentro de una zona padre de su hilo.
+	REQUIRE(!jobs.empty());
+	CHECK(jobs.front()->getNumber("tid") != frames.front()->getNumber("tid"));
+	CHECK(countUnpaired(inners, frames) == 0);
+	CHECK(countUnpaired(steps, jobs) == 0);
+	CHECK(countUnpaired(inners, jobs) == inners.size());
+
+	// Un documento cortado o con una comilla sin escapar no se acepta.
+	JsonValue damaged;
+	CHECK(!JsonParser(text.substr(0, text.size() / 2)).parse(damaged));
+	CHECK(!JsonParser("{\"name\":\"Worker \"step\"\"}").parse(damaged));
+
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
+
+TEST_CASE(Profiler_FullRingDropsWholeZonesAndKeepsPairs) {
+	Profiler& profiler = Profiler::get();
+
+	// Desactivado no se registra nada.
+	Profiler::setEnabled(false);
+	{
+		PROFILE_SCOPE("Disabled zone");
+	}
+	Profiler::setEnabled(true);
+
+	// Sin recoger, el anillo del hilo se llena: las zonas que no caben se pierden con sus hijas,
+	// y la zona abierta antes de llenarse se cierra con los huecos reservados.
+	std::thread flood([]() {
+		Profiler::setThreadName("Tests flood");
+		Profiler::beginZone("Flood outer");
+		for (unsigned int i = 0; i < kFloodZones; ++i) {
+			Profiler::beginZone("Flood inner");
+			Profiler::beginZone("Flood nested");
+			Profiler::endZone();
+			Profiler::endZone();
+		}
+		Profiler::endZone();
+	});
+	flood.join();
+
+	// Un cierre sin apertura se ignora y una zona abierta sobre la frontera cuenta al cerrarse.
+	Profiler::endZone();
+	Profiler::beginZone("Main across frames");
+	profiler.beginFrame();
+	Profiler::endZone();
+	for (unsigned int frame = 1; frame < Profiler::kWindow; ++frame) {
+		profiler.beginFrame();
+	}
+	Profiler::setEnabled(false);
+
+	CHECK(findZone("Disabled zone") == nullptr);
+	const ProfileZoneStats* outer = findZone("Flood outer");
+	const ProfileZoneStats* inner = findZone("Flood inner");
+	const ProfileZoneStats* nested = findZone("Flood nested");
+	const ProfileZoneStats* across = findZone("Main across frames");
+	REQUIRE(outer && inner && nested && across);
+	CHECK(windowCalls(*outer) == 1);
+	CHECK(outer->depth == 0 && inner->depth == 1 && nested->depth == 2);
+	CHECK(windowCalls(*inner) > 0);
+	CHECK(windowCalls(*inner) < static_cast<long>(kFloodZones));
+	CHECK(windowCalls(*nested) <= windowCalls(*inner));
+	CHECK(windowCalls(*across) == 1);
+	CHECK(across->depth == 0);
+
+	// Cada apertura perdida se cuenta una vez, en el hilo que la perdió.
+	const long lost = 2 * static_cast<long>(kFloodZones) - windowCalls(*inner) - windowCalls(*nested);
+	CHECK(static_cast<long>(profiler.getStats().dropped) == lost);
+	const std::vector<ProfileThreadStats>& threads = profiler.getThreads();
+	REQUIRE(outer->thread < threads.size());
+	CHECK(threads[outer->thread].name == "Tests flood");
+	CHECK(static_cast<long>(threads[outer->thread].dropped) == lost);
+}
@@ -0,0 +1,160 @@
+﻿/**
+ * @file RenderQueueTests.cpp
+ * @brief Pruebas del orden por clave y del filtrado de binds de RenderQueue sobre su escena sintética.
+ */
+
+#include "TestFramework.h"
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+	/// Objetos ficticios: la cola solo usa sus direcciones.
+	char g_objects[64];
+
+	template<typename T>
+	T*
+	mockObject(unsigned int id) {
+		return reinterpret_cast<T*>(g_objects + id);
+	}
+
+	/**
+	 * @brief Llena la cola con paquetes de estados y profundidades aleatorios.
+	 * @details indexOffset guarda el orden de inserción para comprobar la estabilidad.
+	 */
+	void
+	pushRandomPackets(RenderQueue& queue, unsigned int count, unsigned int seed) {
+		std::mt19937 rng(seed);
+		queue.begin();
+		for (unsigned int i = 0; i < count; ++i) {
+			DrawPacket packet;
+			packet.pixelShader = mockObject<ID3D11PixelShader>(rng() % 4);
+			packet.inputLayout = mockObject<ID3D11InputLayout>(8 + rng() % 2);
+			packet.texture = mockObject<ID3D11ShaderResourceView>(16 + rng() % 8);
+			packet.vertexBuffer = mockObject<ID3D11Buffer>(32 + rng() % 16);
+			packet.indexOffset = i;
+			// Pocas profundidades distintas: hay claves repetidas y la estabilidad importa.
+			const float depth = static_cast<float>(rng() % 64) * 0.5f;
+			queue.push(packet, (rng() % 4 == 0) ? RENDER_PASS_SHADOW : RENDER_PASS_OPAQUE, depth);
+		}
+	}
+
+	/// Claves e índices de inserción del orden actual de la cola.
+	std::vector<std::pair<uint64_t, unsigned int>>
+	currentOrder(const RenderQueue& queue) {
+		std::vector<std::pair<uint64_t, unsigned int>> order;
+		for (size_t i = 0; i < queue.size(); ++i) {
+			order.push_back({ queue.getSortedKey(i), queue.getSortedPacket(i).indexOffset });
+		}
+		return order;
+	}
+}
+
+TEST_CASE(RenderQueue_MakeKeyOrdersFieldsByPriority) {
+	// Cada campo pesa más que todos los de su derecha juntos.
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 0xFFF, 0xFFFF, 0xFFFF, 1000.0f) <
+		RenderQueue::makeKey(RENDER_PASS_SHADOW, 0, 0, 0, 0.0f));
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 0xFFFF, 0xFFFF, 1000.0f) <
+		RenderQueue::makeKey(RENDER_PASS_OPAQUE, 2, 0, 0, 0.0f));
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 0xFFFF, 1000.0f) <
+		RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 6, 0, 0.0f));
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 7, 1000.0f) <
+		RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 8, 0.0f));
+
+	// Opacos de delante hacia atrás; sombras al revés. Profundidades negativas cuentan como 0.
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 7, 2.0f) < RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 7, 3.0f));
+	CHECK(RenderQueue::makeKey(RENDER_PASS_SHADOW, 1, 5, 7, 2.0f) > RenderQueue::makeKey(RENDER_PASS_SHADOW, 1, 5, 7, 3.0f));
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 7, -4.0f) == RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 5, 7, 0.0f));
+	// Los ids se recortan a su campo y no invaden el vecino.
+	CHECK(RenderQueue::makeKey(RENDER_PASS_OPAQUE, 0x1001, 0, 0, 0.0f) == RenderQueue::makeKey(RENDER_PASS_OPAQUE, 1, 0, 0, 0.0f));
+}
+
+TEST_CASE(RenderQueue_RadixSortMatchesStableSort) {
+	JobSystem jobs;
+	jobs.init(3);
+	// Por debajo y por encima de kParallelThreshold: un hilo y reparto por bloques.
+	const unsigned int counts[] = { 1, 777, RenderQueue::kParallelThreshold * 3 };
+	for (unsigned int count : counts) {
+		for (JobSystem* system : { static_cast<JobSystem*>(nullptr), &jobs }) {
+			RenderQueue queue;
+			pushRandomPackets(queue, count, count);
+			REQUIRE(queue.size() == count);
+
+			// Antes de sort() el orden es el de inserción.
+			std::vector<std::pair<uint64_t, unsigned int>> expected = currentOrder(queue);
+			for (unsigned int i = 0; i < count; ++i) {
+				CHECK(expected[i].second == i);
+			}
+			std::stable_sort(expected.begin(), expected.end(),
+				[](const std::pair<uint64_t, unsigned int>& a, const std::pair<uint64_t, unsigned int>& b) {
+					return a.first < b.first;
+				});
+
+			queue.sort(system);
+			CHECK(currentOrder(queue) == expected);
+		}
+	}
+
+	// Claves que solo difieren en el pase: las pasadas con dígitos iguales se omiten sin perder el orden.
+	RenderQueue queue;
+	DrawPacket packet;
+	for (unsigned int i = 0; i < 10; ++i) {
+		packet.indexOffset = i;
+		queue.push(packet, (i % 2) ? RENDER_PASS_OPAQUE : RENDER_PASS_SHADOW, 1.0f);
+	}
+	queue.sort(nullptr);
+	for (unsigned int i = 0; i < 10; ++i) {
+		CHECK(queue.getSortedPacket(i).indexOffset == (i < 5 ? 2 * i + 1 : 2 * (i - 5)));
+	}
+}
+
+TEST_CASE(RenderQueue_BenchmarkCutsBinds) {
+	JobSystem jobs;
+	jobs.init(3);
+	const unsigned int counts[] = { 1, 1000, 20000 };
+	for (unsigned int draws : counts) {
+		const RenderQueueBenchmark bench = RenderQueue::benchmark(draws, &jobs);
+		CHECK(bench.draws == draws);
+		CHECK(bench.threads == 4);
+		CHECK(bench.sortedBinds <= bench.unsortedBinds);
+		CHECK(bench.unsortedBinds <= bench.naiveBinds);
+	}
+
+	// Con muchos draws el orden tiene que ahorrar binds de verdad.
+	const RenderQueueBenchmark large = RenderQueue::benchmark(20000, &jobs);
+	CHECK(large.sortedBinds < large.unsortedBinds);
+	CHECK(large.unsortedBinds < large.naiveBinds);
+}
+
+TEST_CASE(RenderQueue_BenchmarkWithoutJobSystemMatches) {
+	JobSystem jobs;
+	jobs.init(3);
+	const RenderQueueBenchmark serial = RenderQueue::benchmark(5000, nullptr);
+	const RenderQueueBenchmark parallel = RenderQueue::benchmark(5000, &jobs);
+	CHECK(serial.threads == 1);
+	// La escena es determinista: los binds no dependen de los hilos.
+	CHECK(serial.naiveBinds == parallel.naiveBinds);
+	CHECK(serial.unsortedBinds == parallel.unsortedBinds);
+	CHECK(serial.sortedBinds == parallel.sortedBinds);
+}
+
+TEST_CASE(RenderQueue_BenchmarkParallelRebindsPerChunk) {
+	JobSystem jobs;
+	jobs.init(3);
+	const unsigned int counts[] = { 1, 1000, 20000 };
+	for (unsigned int draws : counts) {
+		for (JobSystem* system : { static_cast<JobSystem*>(nullptr), &jobs }) {
+			const ParallelSubmitBenchmark bench = RenderQueue::benchmarkParallel(draws, system);
+			CHECK(bench.draws == draws);
+			CHECK(bench.threads == (system ? 4u : 1u));
+			REQUIRE(bench.binds.size() == DeferredContextPool::kMaxContexts);
+			CHECK(bench.recordMs.size() == bench.binds.size());
+			// Un tramo es el recorrido en un hilo; cada tramo más vuelve a enlazar su estado.
+			CHECK(bench.binds[0] == bench.serialBinds);
+			for (size_t parts = 1; parts < bench.binds.size(); ++parts) {
+				CHECK(bench.binds[parts - 1] <= bench.binds[parts]);
+			}
+		}
+	}
+}
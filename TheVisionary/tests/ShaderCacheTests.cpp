@@ -0,0 +1,181 @@
+﻿/**
+ * @file ShaderCacheTests.cpp
+ * @brief Pruebas de ShaderCache con un compilador falso: aciertos, #include modificados y el archivo en disco.
+ */
+
+#include "TestFramework.h"
+#include "TestFiles.h"
+#include "ShaderCache.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	/// Compilador que devuelve el código con su punto de entrada y cuenta las llamadas.
+	class StubCompiler : public ShaderCompiler {
+	public:
+		bool
+		compile(const ShaderCompileRequest& request, std::vector<char>& bytecode, std::string& errors) override {
+			++m_calls;
+			if (request.entryPoint == "Broken") {
+				errors = "stub: broken entry point";
+				return false;
+			}
+			const std::string code = request.entryPoint + ":" + request.profile + ":" + request.source;
+			bytecode.assign(code.begin(), code.end());
+			return true;
+		}
+
+		std::string
+		getId() const override {
+			return "Stub 1";
+		}
+
+		unsigned int m_calls = 0; ///< Compilaciones pedidas.
+	};
+
+	ShaderCompileRequest
+	makeRequest(const std::string& fileName, const std::string& entryPoint) {
+		ShaderCompileRequest request;
+		request.fileName = fileName;
+		request.entryPoint = entryPoint;
+		request.profile = "vs_4_0";
+		return request;
+	}
+}
+
+TEST_CASE(ShaderCache_CompilesMissesOnceAndServesHits) {
+	auto compiler = std::make_shared<StubCompiler>();
+	ShaderCache cache(compiler);
+	ShaderCompileRequest request = makeRequest("Inline.fx", "VS");
+	request.source = "float4 VS() : SV_POSITION { return 0; }";
+
+	std::vector<char> first, second;
+	std::string errors;
+	REQUIRE(cache.getBytecode(request, first, errors));
+	REQUIRE(cache.getBytecode(request, second, errors));
+	CHECK(first == second);
+	CHECK(compiler->m_calls == 1);
+
+	// Cualquier cosa que cambie el bytecode cambia la clave.
+	ShaderCompileRequest defined = request;
+	defined.defines.push_back({ "SHADOWS", "" });
+	CHECK(ShaderCache::computeKey(defined, compiler->getId()) != ShaderCache::computeKey(request, compiler->getId()));
+	CHECK(ShaderCache::computeKey(request, "Stub 2") != ShaderCache::computeKey(request, compiler->getId()));
+	REQUIRE(cache.getBytecode(defined, second, errors));
+	CHECK(compiler->m_calls == 2);
+
+	// Los fallos no se guardan: se vuelven a compilar y dejan los errores.
+	ShaderCompileRequest broken = request;
+	broken.entryPoint = "Broken";
+	CHECK(!cache.getBytecode(broken, second, errors));
+	CHECK(!cache.getBytecode(broken, second, errors));
+	CHECK(errors == "stub: broken entry point");
+	CHECK(compiler->m_calls == 4);
+
+	const ShaderCacheStats stats = cache.getStats();
+	CHECK(stats.hits == 1);
+	CHECK(stats.misses == 2);
+	CHECK(stats.failures == 2);
+	CHECK(stats.entries == 2);
+}
+
+TEST_CASE(ShaderCache_ChangedIncludeInvalidatesKey) {
+	const fs::path dir = MakeTestDirectory("ShaderCacheIncludes");
+	fs::create_directories(dir / "Common");
+	WriteTestFile(dir / "Main.fx", "#include \"Common/Lighting.hlsl\"\nfloat4 VS() : SV_POSITION { return Light(); }\n");
+	// Lighting.hlsl incluye Math.hlsl: está junto a él, no junto a Main.fx.
+	WriteTestFile(dir / "Common" / "Lighting.hlsl", "  #  include <Math.hlsl>\nfloat4 Light() { return One(); }\n");
+	WriteTestFile(dir / "Common" / "Math.hlsl", "float4 One() { return 1; }\n");
+
+	const std::string root = ShaderCache::directoryOf((dir / "Main.fx").string());
+	CHECK(ShaderCache::resolveInclude("Math.hlsl", ShaderCache::directoryOf((dir / "Common" / "Lighting.hlsl").string()), root)
+		== (dir / "Common" / "Math.hlsl").string());
+	CHECK(ShaderCache::resolveInclude("Math.hlsl", root, root).empty());
+
+	auto compiler = std::make_shared<StubCompiler>();
+	ShaderCache cache(compiler);
+	const ShaderCompileRequest request = makeRequest((dir / "Main.fx").string(), "VS");
+	std::vector<char> bytecode;
+	std::string errors;
+	REQUIRE(cache.getBytecode(request, bytecode, errors));
+	REQUIRE(cache.getBytecode(request, bytecode, errors));
+	CHECK(compiler->m_calls == 1);
+
+	// Editar el #include anidado (sin tocar Main.fx) obliga a recompilar.
+	WriteTestFile(dir / "Common" / "Math.hlsl", "float4 One() { return 2; }\n");
+	REQUIRE(cache.getBytecode(request, bytecode, errors));
+	CHECK(compiler->m_calls == 2);
+	REQUIRE(cache.getBytecode(request, bytecode, errors));
+	CHECK(compiler->m_calls == 2);
+
+	// Un #include que aparece donde antes faltaba también cambia la clave.
+	ShaderCompileRequest withMissing = makeRequest((dir / "Other.fx").string(), "VS");
+	withMissing.source = "#include \"Extra.hlsl\"\n";
+	const uint64_t missingKey = ShaderCache::computeKey(withMissing, compiler->getId());
+	WriteTestFile(dir / "Extra.hlsl", "\n");
+	CHECK(ShaderCache::computeKey(withMissing, compiler->getId()) != missingKey);
+
+	// Un archivo que no existe no llega al compilador.
+	CHECK(!cache.getBytecode(makeRequest((dir / "Missing.fx").string(), "VS"), bytecode, errors));
+	CHECK(compiler->m_calls == 2);
+
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
+
+TEST_CASE(ShaderCache_SaveAndLoadServeWithoutCompiling) {
+	const fs::path dir = MakeTestDirectory("ShaderCacheFile");
+	const std::string path = (dir / "Cooked" / "Shaders.vshc").string();
+	std::vector<ShaderCompileRequest> requests;
+	for (const char* entryPoint : { "VS", "PS", "ShadowVS" }) {
+		requests.push_back(makeRequest("Inline.fx", entryPoint));
+		requests.back().source = std::string("// ") + entryPoint + "\n";
+	}
+
+	std::vector<std::vector<char>> compiled(requests.size());
+	std::string errors;
+	auto coldCompiler = std::make_shared<StubCompiler>();
+	{
+		ShaderCache cold(coldCompiler);
+		CHECK(!cold.load(path));
+		CHECK(!cold.getStats().invalid);
+		for (size_t i = 0; i < requests.size(); ++i) {
+			REQUIRE(cold.getBytecode(requests[i], compiled[i], errors));
+		}
+		REQUIRE(cold.save());
+	}
+	CHECK(coldCompiler->m_calls == requests.size());
+	REQUIRE(fs::exists(path));
+
+	auto warmCompiler = std::make_shared<StubCompiler>();
+	ShaderCache warm(warmCompiler);
+	REQUIRE(warm.load(path));
+	std::vector<char> bytecode;
+	for (size_t i = 0; i < requests.size(); ++i) {
+		REQUIRE(warm.getBytecode(requests[i], bytecode, errors));
+		CHECK(bytecode == compiled[i]);
+	}
+	CHECK(warmCompiler->m_calls == 0);
+	const ShaderCacheStats stats = warm.getStats();
+	CHECK(stats.warm);
+	CHECK(stats.hits == requests.size());
+	CHECK(stats.entries == requests.size());
+
+	// Un archivo cortado se descarta entero y se avisa.
+	WriteTestFile(path, "VSHC");
+	ShaderCache truncated(warmCompiler);
+	CHECK(!truncated.load(path));
+	CHECK(truncated.getStats().invalid);
+	CHECK(truncated.getStats().entries == 0);
+
+	const ShaderCacheBenchmark bench = ShaderCache::benchmark(requests, std::make_shared<StubCompiler>(),
+		(dir / "Bench.vshc").string());
+	CHECK(bench.shaders == requests.size());
+	CHECK(bench.warmHits == bench.shaders);
+	CHECK(bench.identical);
+	CHECK(bench.fileBytes > 0);
+	CHECK(!fs::exists(dir / "Bench.vshc"));
+
+	std::error_code error;
+	fs::remove_all(dir, error);
+}
@@ -0,0 +1,286 @@
+﻿/**
+ * @file StateCacheTests.cpp
+ * @brief Pruebas de StateCache con un contexto simulado: lo que ve el driver con y sin filtrado debe coincidir.
+ *
+ * No incluye Direct3D: los objetos son punteros ficticios a tipos solo
+ * declarados, así que compila en cualquier plataforma.
+ */
+
+#include "TestFramework.h"
+#include "StateCache.h"
+#include <cstring>
+#include <random>
+
+namespace {
+	const unsigned int kMockSlots = 32; ///< Más que kTrackedSlots para cubrir los slots sin seguir.
+
+	/// Objetos ficticios: solo se usan sus direcciones.
+	char g_objects[64];
+
+	template<typename T>
+	T*
+	MockObject(unsigned int id) {
+		return reinterpret_cast<T*>(g_objects + id);
+	}
+
+	struct MockBinding {
+		const void* object = nullptr;
+		unsigned int a = 0;
+		unsigned int b = 0;
+
+		bool operator==(const MockBinding& other) const {
+			return object == other.object && a == other.a && b == other.b;
+		}
+	};
+
+	/// Estado que ve el driver tras las llamadas que le llegan.
+	struct MockContext {
+		const void* vertexShader = nullptr;
+		const void* pixelShader = nullptr;
+		const void* inputLayout = nullptr;
+		unsigned int topology = 0;
+		MockBinding vertexBuffers[kMockSlots];
+		MockBinding indexBuffer;
+		MockBinding vsConstants[kMockSlots];
+		MockBinding psConstants[kMockSlots];
+		const void* shaderResources[kMockSlots] = {};
+		const void* samplers[kMockSlots] = {};
+		const void* rasterizer = nullptr;
+		const void* blend = nullptr;
+		float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		unsigned int sampleMask = 0xFFFFFFFFu;
+		const void* depthStencil = nullptr;
+		unsigned int stencilRef = 0;
+		unsigned int calls = 0;
+
+		bool operator==(const MockContext& o) const {
+			for (unsigned int i = 0; i < kMockSlots; ++i) {
+				if (!(vertexBuffers[i] == o.vertexBuffers[i]) || !(vsConstants[i] == o.vsConstants[i]) ||
+					!(psConstants[i] == o.psConstants[i]) || shaderResources[i] != o.shaderResources[i] ||
+					samplers[i] != o.samplers[i]) {
+					return false;
+				}
+			}
+			return vertexShader == o.vertexShader && pixelShader == o.pixelShader && inputLayout == o.inputLayout &&
+				topology == o.topology && indexBuffer == o.indexBuffer && rasterizer == o.rasterizer &&
+				blend == o.blend && std::memcmp(blendFactor, o.blendFactor, sizeof(blendFactor)) == 0 &&
+				sampleMask == o.sampleMask && depthStencil == o.depthStencil && stencilRef == o.stencilRef;
+		}
+	};
+
+	/// Una llamada del contexto con sus argumentos.
+	struct MockCall {
+		StateCall type = STATE_CALL_VS_SHADER;
+		bool classInstances = false;         ///< Solo shaders: enlazado con instancias de clase.
+		unsigned int startSlot = 0;
+		unsigned int count = 1;
+		unsigned int ids[4] = {};
+		unsigned int first[4] = {};
+		unsigned int num[4] = {};
+		unsigned int value = 0;              ///< Topología, formato, stencil ref o sample mask.
+		unsigned int offset = 0;
+		bool defaultFactor = false;
+		float factor[4] = {};
+	};
+
+	/// Aplica la llamada al estado del driver.
+	void
+	Apply(MockContext& context, const MockCall& call) {
+		++context.calls;
+		switch (call.type) {
+		case STATE_CALL_VS_SHADER: context.vertexShader = g_objects + call.ids[0]; break;
+		case STATE_CALL_PS_SHADER: context.pixelShader = g_objects + call.ids[0]; break;
+		case STATE_CALL_INPUT_LAYOUT: context.inputLayout = g_objects + call.ids[0]; break;
+		case STATE_CALL_TOPOLOGY: context.topology = call.value; break;
+		case STATE_CALL_INDEX_BUFFER:
+			context.indexBuffer.object = g_objects + call.ids[0];
+			context.indexBuffer.a = call.value;
+			context.indexBuffer.b = call.offset;
+			break;
+		case STATE_CALL_RASTERIZER: context.rasterizer = g_objects + call.ids[0]; break;
+		case STATE_CALL_BLEND:
+			context.blend = g_objects + call.ids[0];
+			for (int i = 0; i < 4; ++i) {
+				context.blendFactor[i] = call.defaultFactor ? 1.0f : call.factor[i];
+			}
+			context.sampleMask = call.value;
+			break;
+		case STATE_CALL_DEPTH_STENCIL:
+			context.depthStencil = g_objects + call.ids[0];
+			context.stencilRef = call.value;
+			break;
+		default:
+			for (unsigned int i = 0; i < call.count; ++i) {
+				const unsigned int slot = call.startSlot + i;
+				MockBinding binding;
+				binding.object = g_objects + call.ids[i];
+				binding.a = call.first[i];
+				binding.b = call.num[i];
+				switch (call.type) {
+				case STATE_CALL_VERTEX_BUFFERS: context.vertexBuffers[slot] = binding; break;
+				case STATE_CALL_VS_CONSTANT_BUFFERS: context.vsConstants[slot] = binding; break;
+				case STATE_CALL_PS_CONSTANT_BUFFERS: context.psConstants[slot] = binding; break;
+				case STATE_CALL_PS_SHADER_RESOURCES: context.shaderResources[slot] = binding.object; break;
+				case STATE_CALL_PS_SAMPLERS: context.samplers[slot] = binding.object; break;
+				default: break;
+				}
+			}
+			break;
+		}
+	}
+
+	/// Pasa la llamada por la caché como DeviceContext; true si llega al driver.
+	bool
+	Filter(StateCache& cache, const MockCall& call) {
+		ID3D11Buffer* buffers[4];
+		for (unsigned int i = 0; i < call.count; ++i) {
+			buffers[i] = MockObject<ID3D11Buffer>(call.ids[i]);
+		}
+		switch (call.type) {
+		case STATE_CALL_VS_SHADER:
+			if (call.classInstances) {
+				cache.invalidateVertexShader();
+				return true;
+			}
+			return cache.setVertexShader(MockObject<ID3D11VertexShader>(call.ids[0]));
+		case STATE_CALL_PS_SHADER:
+			if (call.classInstances) {
+				cache.invalidatePixelShader();
+				return true;
+			}
+			return cache.setPixelShader(MockObject<ID3D11PixelShader>(call.ids[0]));
+		case STATE_CALL_INPUT_LAYOUT: return cache.setInputLayout(MockObject<ID3D11InputLayout>(call.ids[0]));
+		case STATE_CALL_TOPOLOGY: return cache.setTopology(call.value);
+		case STATE_CALL_VERTEX_BUFFERS: return cache.setVertexBuffers(call.startSlot, call.count, buffers, call.first, call.num);
+		case STATE_CALL_INDEX_BUFFER: return cache.setIndexBuffer(buffers[0], call.value, call.offset);
+		case STATE_CALL_VS_CONSTANT_BUFFERS: return cache.setVSConstantBuffers(call.startSlot, call.count, buffers, call.first, call.num);
+		case STATE_CALL_PS_CONSTANT_BUFFERS: return cache.setPSConstantBuffers(call.startSlot, call.count, buffers, call.first, call.num);
+		case STATE_CALL_PS_SHADER_RESOURCES: {
+			ID3D11ShaderResourceView* views[4];
+			for (unsigned int i = 0; i < call.count; ++i) {
+				views[i] = MockObject<ID3D11ShaderResourceView>(call.ids[i]);
+			}
+			return cache.setPSShaderResources(call.startSlot, call.count, views);
+		}
+		case STATE_CALL_PS_SAMPLERS: {
+			ID3D11SamplerState* samplers[4];
+			for (unsigned int i = 0; i < call.count; ++i) {
+				samplers[i] = MockObject<ID3D11SamplerState>(call.ids[i]);
+			}
+			return cache.setPSSamplers(call.startSlot, call.count, samplers);
+		}
+		case STATE_CALL_RASTERIZER: return cache.setRasterizerState(MockObject<ID3D11RasterizerState>(call.ids[0]));
+		case STATE_CALL_BLEND:
+			return cache.setBlendState(MockObject<ID3D11BlendState>(call.ids[0]),
+				call.defaultFactor ? nullptr : call.factor, call.value);
+		case STATE_CALL_DEPTH_STENCIL:
+			return cache.setDepthStencilState(MockObject<ID3D11DepthStencilState>(call.ids[0]), call.value);
+		default: return true;
+		}
+	}
+
+	/// Llamada aleatoria con pocos valores distintos para que abunden las repeticiones.
+	MockCall
+	RandomCall(std::mt19937& rng) {
+		auto pick = [&rng](unsigned int n) { return static_cast<unsigned int>(rng() % n); };
+		MockCall call;
+		call.type = static_cast<StateCall>(pick(STATE_CALL_COUNT));
+		call.classInstances = pick(8) == 0;
+		// Casi siempre en los slots seguidos; a veces por encima de kTrackedSlots.
+		call.count = 1 + pick(4);
+		call.startSlot = pick(6) == 0 ? StateCache::kTrackedSlots - 2 + pick(8) : pick(4);
+		for (unsigned int i = 0; i < 4; ++i) {
+			call.ids[i] = 1 + pick(3);
+			call.first[i] = 16 * pick(2);
+			call.num[i] = 16 * pick(2);
+		}
+		call.value = pick(3);
+		call.offset = 4 * pick(2);
+		call.defaultFactor = pick(2) == 0;
+		for (int i = 0; i < 4; ++i) {
+			call.factor[i] = pick(2) ? 1.0f : 0.5f;
+		}
+		return call;
+	}
+}
+
+TEST_CASE(StateCache_FilteredContextMatchesUnfilteredOnRandomBinds) {
+	std::mt19937 rng(1234);
+	StateCache cache;
+	MockContext reference, filtered;
+	unsigned int sent = 0;
+	for (int step = 0; step < 200000; ++step) {
+		const unsigned int event = static_cast<unsigned int>(rng() % 1000);
+		if (event == 0) {
+			cache.beginFrame();
+		}
+		else if (event == 1) {
+			// Alguien toca el contexto nativo (ImGui) y luego invalida, como BaseApp.
+			const MockCall call = RandomCall(rng);
+			Apply(reference, call);
+			Apply(filtered, call);
+			cache.invalidate();
+		}
+		else if (event == 2) {
+			// Cambiar render targets puede desenlazar texturas.
+			MockCall call;
+			call.type = STATE_CALL_PS_SHADER_RESOURCES;
+			call.ids[0] = 0;
+			Apply(reference, call);
+			Apply(filtered, call);
+			cache.invalidateShaderResources();
+		}
+		else {
+			const MockCall call = RandomCall(rng);
+			Apply(reference, call);
+			if (Filter(cache, call)) {
+				Apply(filtered, call);
+				++sent;
+			}
+		}
+		REQUIRE(filtered == reference);
+	}
+	// El filtrado tiene que descartar algo para que la prueba diga algo.
+	CHECK(sent < reference.calls);
+	const StateCacheStats& stats = cache.getCurrentStats();
+	CHECK(stats.getSkipped() > 0);
+}
+
+TEST_CASE(StateCache_ClassInstanceBindForgetsShader) {
+	StateCache cache;
+	ID3D11VertexShader* a = MockObject<ID3D11VertexShader>(1);
+	ID3D11PixelShader* p = MockObject<ID3D11PixelShader>(1);
+	CHECK(cache.setVertexShader(a));
+	CHECK(!cache.setVertexShader(a));
+	CHECK(cache.setPixelShader(p));
+	// Otro shader con instancias de clase: DeviceContext lo envía sin pasar por set*() y olvida el conocido.
+	cache.invalidateVertexShader();
+	cache.invalidatePixelShader();
+	CHECK(cache.setVertexShader(a));
+	CHECK(cache.setPixelShader(p));
+	CHECK(!cache.setPixelShader(p));
+}
+
+TEST_CASE(StateCache_CountsIssuedAndSkippedPerFrame) {
+	StateCache cache;
+	ID3D11Buffer* buffer = MockObject<ID3D11Buffer>(1);
+	const unsigned int first = 0, ringFirst = 16, num = 16;
+	CHECK(cache.setVSConstantBuffers(0, 1, &buffer));
+	CHECK(!cache.setVSConstantBuffers(0, 1, &buffer));
+	// El mismo buffer con otro rango es otro enlace.
+	CHECK(cache.setVSConstantBuffers(0, 1, &buffer, &ringFirst, &num));
+	CHECK(!cache.setVSConstantBuffers(0, 1, &buffer, &ringFirst, &num));
+	CHECK(cache.setVSConstantBuffers(0, 1, &buffer, &first, &num));
+	CHECK(cache.setTopology(4));
+	CHECK(!cache.setTopology(4));
+	CHECK(cache.getCurrentStats().issued[STATE_CALL_VS_CONSTANT_BUFFERS] == 3);
+	CHECK(cache.getCurrentStats().skipped[STATE_CALL_VS_CONSTANT_BUFFERS] == 2);
+	CHECK(cache.getCurrentStats().getIssued() == 4);
+	CHECK(cache.getCurrentStats().getSkipped() == 3);
+
+	// beginFrame cierra los contadores y olvida el estado.
+	cache.beginFrame();
+	CHECK(cache.getFrameStats().getIssued() == 4);
+	CHECK(cache.getCurrentStats().getIssued() == 0);
+	CHECK(cache.setTopology(4));
+}
@@ -0,0 +1,45 @@
+﻿/**
+ * @file TestFiles.h
+ * @brief Directorios temporales y archivos de entrada para las pruebas que tocan el disco.
+ */
+
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+/**
+ * @brief Directorio temporal vacío para una prueba (se borra lo que hubiera de otra ejecución).
+ * @param name Nombre único de la prueba.
+ * @return Ruta del directorio.
+ */
+inline std::filesystem::path
+MakeTestDirectory(const char* name) {
+	const std::filesystem::path dir = std::filesystem::temp_directory_path() / "TheVisionaryTests" / name;
+	std::error_code error;
+	std::filesystem::remove_all(dir, error);
+	std::filesystem::create_directories(dir, error);
+	return dir;
+}
+
+/**
+ * @brief Escribe (o sustituye) un archivo con el contenido dado.
+ * @param path Ruta del archivo.
+ * @param contents Bytes a escribir.
+ */
+inline void
+WriteTestFile(const std::filesystem::path& path, const std::string& contents) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << contents;
+}
+
+/**
+ * @brief Contenido entero de un archivo (vacío si no existe).
+ * @param path Ruta del archivo.
+ */
+inline std::string
+ReadTestFile(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
@@ -0,0 +1,87 @@
+﻿/**
+ * @file TestFramework.h
+ * @brief Registro mínimo de pruebas de TheVisionaryTests: TEST_CASE, CHECK y REQUIRE.
+ *
+ * No incluye nada de Windows ni de Direct3D: las pruebas de lógica pura
+ * (StateCache, ShaderCache) compilan también fuera de Windows.
+ */
+
+#pragma once
+#include <cmath>
+#include <vector>
+
+/**
+ * @struct TestCase
+ * @brief Prueba registrada con TEST_CASE.
+ */
+struct TestCase {
+    const char* name;    ///< Nombre (el de la función).
+    const char* file;    ///< Archivo que la define.
+    void (*run)();       ///< Cuerpo.
+};
+
+/**
+ * @class TestRegistry
+ * @brief Lista de pruebas del ejecutable y fallos de la prueba en curso.
+ */
+class TestRegistry {
+public:
+    /** @brief Registro del proceso. */
+    static TestRegistry& get();
+
+    /** @brief Añade una prueba (desde los constructores estáticos de TEST_CASE). */
+    void add(const char* name, const char* file, void (*run)());
+
+    /**
+     * @brief Anota un fallo de la prueba en curso.
+     * @param file Archivo de la comprobación.
+     * @param line Línea de la comprobación.
+     * @param expression Texto de la comprobación.
+     */
+    void fail(const char* file, int line, const char* expression);
+
+    /**
+     * @brief Ejecuta las pruebas cuyo nombre contiene filter.
+     * @param filter Subcadena del nombre (nullptr = todas).
+     * @return Número de pruebas que fallaron.
+     */
+    int runAll(const char* filter);
+
+    /** @brief Escribe el nombre de cada prueba. */
+    void list() const;
+
+private:
+    std::vector<TestCase> m_tests;   ///< Pruebas registradas.
+    unsigned int m_failures = 0;     ///< Fallos de la prueba en curso.
+};
+
+/**
+ * @struct TestRegistrar
+ * @brief Registra una prueba al construirse (una variable estática por TEST_CASE).
+ */
+struct TestRegistrar {
+    TestRegistrar(const char* name, const char* file, void (*run)()) {
+        TestRegistry::get().add(name, file, run);
+    }
+};
+
+/** @brief Diferencia máxima relativa a la magnitud (1 como mínimo) para comparar floats. */
+inline bool
+NearlyEqual(double a, double b, double tolerance = 1e-5) {
+    return std::fabs(a - b) <= tolerance * std::fmax(1.0, std::fmax(std::fabs(a), std::fabs(b)));
+}
+
+// === Macros ===
+/** Define y registra una prueba. */
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, __FILE__, &name); \
+    static void name()
+
+/** Anota un fallo si expression es falsa y sigue. */
+#define CHECK(expression) \
+    do { if (!(expression)) TestRegistry::get().fail(__FILE__, __LINE__, #expression); } while (0)
+
+/** Anota un fallo si expression es falsa y termina la prueba. */
+#define REQUIRE(expression) \
+    do { if (!(expression)) { TestRegistry::get().fail(__FILE__, __LINE__, #expression); return; } } while (0)
@@ -0,0 +1,87 @@
+﻿/**
+ * @file TestGeometry.h
+ * @brief Mallas sintéticas y comparaciones de triángulos para las pruebas.
+ */
+
+#pragma once
+#include "Prerequisites.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+/**
+ * @brief Rejilla plana de size x size quads (dos triángulos por quad) en XZ, con UV en [0, 1].
+ * @param size Quads por lado.
+ * @param vertices Vértices de salida ((size + 1)^2).
+ * @param indices Triángulos de salida (6 * size^2 índices), fila a fila.
+ */
+inline void
+MakeGrid(unsigned int size, std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& indices) {
+	vertices.clear();
+	indices.clear();
+	const unsigned int row = size + 1;
+	for (unsigned int z = 0; z <= size; ++z) {
+		for (unsigned int x = 0; x <= size; ++x) {
+			SimpleVertex vertex;
+			vertex.Pos = XMFLOAT3(static_cast<float>(x), 0.0f, static_cast<float>(z));
+			vertex.Tex = XMFLOAT2(static_cast<float>(x) / size, static_cast<float>(z) / size);
+			vertices.push_back(vertex);
+		}
+	}
+	for (unsigned int z = 0; z < size; ++z) {
+		for (unsigned int x = 0; x < size; ++x) {
+			const unsigned int corner = z * row + x;
+			const unsigned int quad[6] = { corner, corner + row, corner + 1, corner + 1, corner + row, corner + row + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+/**
+ * @brief Baraja los triángulos (no los índices dentro de cada uno) con una semilla fija.
+ * @param indices Lista de triángulos.
+ * @param seed Semilla.
+ */
+inline void
+ShuffleTriangles(std::vector<unsigned int>& indices, unsigned int seed) {
+	std::vector<std::array<unsigned int, 3>> triangles(indices.size() / 3);
+	for (size_t i = 0; i < triangles.size(); ++i) {
+		triangles[i] = { indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2] };
+	}
+	std::mt19937 random(seed);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+	for (size_t i = 0; i < triangles.size(); ++i) {
+		std::copy(triangles[i].begin(), triangles[i].end(), indices.begin() + i * 3);
+	}
+}
+
+/// Triángulo como posiciones, rotado para empezar por la menor (conserva el sentido de giro).
+using TrianglePositions = std::array<float, 9>;
+
+/**
+ * @brief Triángulos de una malla como posiciones en orden canónico.
+ *
+ * Dos mallas con los mismos triángulos y el mismo sentido de giro dan la
+ * misma lista, aunque cambie el orden de triángulos o de vértices.
+ */
+inline std::vector<TrianglePositions>
+CanonicalTriangles(const std::vector<SimpleVertex>& vertices, const std::vector<unsigned int>& indices) {
+	std::vector<TrianglePositions> triangles;
+	triangles.reserve(indices.size() / 3);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		std::array<std::array<float, 3>, 3> corners;
+		for (int corner = 0; corner < 3; ++corner) {
+			const XMFLOAT3& p = vertices[indices[i + corner]].Pos;
+			corners[corner] = { p.x, p.y, p.z };
+		}
+		const int first = static_cast<int>(std::min_element(corners.begin(), corners.end()) - corners.begin());
+		TrianglePositions triangle;
+		for (int corner = 0; corner < 3; ++corner) {
+			std::copy(corners[(first + corner) % 3].begin(), corners[(first + corner) % 3].end(),
+				triangle.begin() + corner * 3);
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
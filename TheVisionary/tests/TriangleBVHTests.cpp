@@ -0,0 +1,188 @@
+﻿/**
+ * @file TriangleBVHTests.cpp
+ * @brief Pruebas de TriangleBVH contra la intersección triángulo a triángulo, en serie, en paralelo y tras load().
+ */
+
+#include "TestFramework.h"
+#include "TestGeometry.h"
+#include "TriangleBVH.h"
+#include "JobSystem.h"
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+namespace {
+	/// Impacto más cercano por fuerza bruta (Möller-Trumbore, dos caras).
+	bool
+	bruteForceHit(const std::vector<SimpleVertex>& vertices,
+		const std::vector<unsigned int>& indices,
+		const XMFLOAT3& origin,
+		const XMFLOAT3& direction,
+		float maxDistance,
+		BVHHit& hit) {
+		const XMVECTOR o = XMLoadFloat3(&origin);
+		const XMVECTOR d = XMLoadFloat3(&direction);
+		bool found = false;
+		hit.distance = maxDistance;
+		for (size_t t = 0; t < indices.size() / 3; ++t) {
+			const XMVECTOR p0 = XMLoadFloat3(&vertices[indices[t * 3 + 0]].Pos);
+			const XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&vertices[indices[t * 3 + 1]].Pos), p0);
+			const XMVECTOR e2 = XMVectorSubtract(XMLoadFloat3(&vertices[indices[t * 3 + 2]].Pos), p0);
+			const XMVECTOR p = XMVector3Cross(d, e2);
+			const float det = XMVectorGetX(XMVector3Dot(e1, p));
+			if (std::fabs(det) < 1e-12f) {
+				continue;
+			}
+			const XMVECTOR s = XMVectorSubtract(o, p0);
+			const float u = XMVectorGetX(XMVector3Dot(s, p)) / det;
+			const XMVECTOR q = XMVector3Cross(s, e1);
+			const float v = XMVectorGetX(XMVector3Dot(d, q)) / det;
+			const float distance = XMVectorGetX(XMVector3Dot(e2, q)) / det;
+			if (u < 0.0f || v < 0.0f || u + v > 1.0f || distance < 0.0f || distance >= hit.distance) {
+				continue;
+			}
+			hit.distance = distance;
+			hit.triangle = static_cast<unsigned int>(t);
+			hit.u = u;
+			hit.v = v;
+			found = true;
+		}
+		return found;
+	}
+
+	/// Sopa de triángulos pequeños repartidos en un cubo de 40 de lado.
+	void
+	makeSoup(size_t count, std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& indices) {
+		std::mt19937 rng(17);
+		std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> offset(-1.5f, 1.5f);
+		vertices.clear();
+		indices.clear();
+		for (size_t t = 0; t < count; ++t) {
+			const XMFLOAT3 center(position(rng), position(rng), position(rng));
+			for (int corner = 0; corner < 3; ++corner) {
+				SimpleVertex vertex;
+				vertex.Pos = XMFLOAT3(center.x + offset(rng), center.y + offset(rng), center.z + offset(rng));
+				indices.push_back(static_cast<unsigned int>(vertices.size()));
+				vertices.push_back(vertex);
+			}
+		}
+	}
+
+	/**
+	 * @brief Lanza rayos aleatorios hacia la malla y cuenta los que no coinciden con la fuerza bruta.
+	 * @param hits Rayos que impactaron (para comprobar que la prueba no es trivial).
+	 */
+	unsigned int
+	countMismatches(const TriangleBVH& bvh,
+		const std::vector<SimpleVertex>& vertices,
+		const std::vector<unsigned int>& indices,
+		const XMFLOAT3& center,
+		float spread,
+		unsigned int rays,
+		unsigned int& hits) {
+		std::mt19937 rng(99);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		unsigned int mismatches = 0;
+		hits = 0;
+		for (unsigned int r = 0; r < rays; ++r) {
+			const XMFLOAT3 origin(center.x + spread * unit(rng), center.y + spread, center.z + spread * unit(rng));
+			const XMFLOAT3 target(center.x + spread * unit(rng), center.y - spread, center.z + spread * unit(rng));
+			// Dirección sin normalizar: las distancias van en sus unidades.
+			const XMFLOAT3 direction(target.x - origin.x, target.y - origin.y, target.z - origin.z);
+			const float maxDistance = (r % 4 == 0) ? 0.5f : FLT_MAX;
+
+			BVHHit expected, actual;
+			const bool expectedHit = bruteForceHit(vertices, indices, origin, direction, maxDistance, expected);
+			const bool actualHit = bvh.intersect(origin, direction, maxDistance, actual);
+			if (expectedHit != actualHit) {
+				++mismatches;
+				continue;
+			}
+			if (!expectedHit) {
+				continue;
+			}
+			++hits;
+			// En empates (aristas compartidas) puede ganar otro triángulo a la misma distancia.
+			if (!NearlyEqual(actual.distance, expected.distance, 1e-4 * (1.0 + expected.distance))) {
+				++mismatches;
+			}
+			else if (actual.triangle == expected.triangle &&
+				(!NearlyEqual(actual.u, expected.u, 1e-3) || !NearlyEqual(actual.v, expected.v, 1e-3))) {
+				++mismatches;
+			}
+		}
+		return mismatches;
+	}
+}
+
+TEST_CASE(TriangleBVH_IntersectMatchesBruteForce) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	makeSoup(2001, vertices, indices);
+	const size_t triangles = indices.size() / 3;
+
+	TriangleBVH bvh;
+	BVHHit hit;
+	CHECK(!bvh.intersect(XMFLOAT3(0.0f, 30.0f, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f), FLT_MAX, hit));
+
+	BVHBuildStats stats;
+	bvh.build(vertices, indices.data(), triangles, nullptr, &stats);
+	REQUIRE(!bvh.isEmpty());
+	CHECK(stats.triangles == triangles);
+	CHECK(stats.nodes == bvh.getNodes().size());
+
+	// Cada triángulo aparece exactamente una vez en el orden (el resto es relleno).
+	std::vector<unsigned int> seen(triangles, 0);
+	for (unsigned int triangle : bvh.getTriangleOrder()) {
+		if (triangle != TriangleBVH::kInvalidTriangle) {
+			REQUIRE(triangle < triangles);
+			++seen[triangle];
+		}
+	}
+	CHECK(std::count(seen.begin(), seen.end(), 1u) == static_cast<std::ptrdiff_t>(triangles));
+
+	unsigned int hits = 0;
+	CHECK(countMismatches(bvh, vertices, indices, XMFLOAT3(0.0f, 0.0f, 0.0f), 22.0f, 400, hits) == 0);
+	CHECK(hits > 100);
+
+	// Un BVH restaurado de sus propios datos responde igual; datos incoherentes se rechazan.
+	TriangleBVH loaded;
+	REQUIRE(loaded.load(bvh.getNodes(), bvh.getTriangleOrder(), vertices, indices.data(), triangles));
+	CHECK(countMismatches(loaded, vertices, indices, XMFLOAT3(0.0f, 0.0f, 0.0f), 22.0f, 400, hits) == 0);
+
+	std::vector<unsigned int> badOrder = bvh.getTriangleOrder();
+	badOrder.pop_back();
+	CHECK(!loaded.load(bvh.getNodes(), badOrder, vertices, indices.data(), triangles));
+	CHECK(loaded.isEmpty());
+	CHECK(!loaded.load(bvh.getNodes(), bvh.getTriangleOrder(), vertices, indices.data(), triangles / 2));
+	std::vector<BVHNode> cyclic = bvh.getNodes();
+	REQUIRE(!cyclic[0].isLeaf());
+	cyclic[0].leftFirst = 0;
+	CHECK(!loaded.load(cyclic, bvh.getTriangleOrder(), vertices, indices.data(), triangles));
+}
+
+TEST_CASE(TriangleBVH_ParallelBuildMatchesBruteForce) {
+	// Rejilla ondulada por encima de kParallelSubtree triángulos para que se construya por subárboles.
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(96, vertices, indices);
+	for (SimpleVertex& vertex : vertices) {
+		vertex.Pos.y = 2.0f * std::sin(vertex.Pos.x * 0.3f) * std::cos(vertex.Pos.z * 0.2f);
+	}
+	const size_t triangles = indices.size() / 3;
+	REQUIRE(triangles > TriangleBVH::kParallelSubtree);
+
+	JobSystem jobs;
+	jobs.init(3);
+	TriangleBVH serial, parallel;
+	BVHBuildStats parallelStats;
+	serial.build(vertices, indices.data(), triangles, nullptr);
+	parallel.build(vertices, indices.data(), triangles, &jobs, &parallelStats);
+	CHECK(parallelStats.subtrees > 0);
+
+	unsigned int hits = 0;
+	CHECK(countMismatches(serial, vertices, indices, XMFLOAT3(48.0f, 0.0f, 48.0f), 40.0f, 150, hits) == 0);
+	CHECK(hits > 50);
+	CHECK(countMismatches(parallel, vertices, indices, XMFLOAT3(48.0f, 0.0f, 48.0f), 40.0f, 150, hits) == 0);
+}
@@ -0,0 +1,110 @@
+﻿/**
+ * @file VertexCodecTests.cpp
+ * @brief Pruebas de half, snorm16, índices de 16 bits y del round-trip de VertexCodec.
+ */
+
+#include "TestFramework.h"
+#include "TestGeometry.h"
+#include "VertexFormat.h"
+#include "MeshComponent.h"
+#include <cstring>
+#include <limits>
+
+TEST_CASE(VertexCodec_HalfConversionIsExactAndRoundsToEven) {
+	const float exact[] = { 0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, -0.25f, std::ldexp(1.0f, -24), std::ldexp(1.0f, -14) };
+	for (float value : exact) {
+		CHECK(VertexCodec::halfToFloat(VertexCodec::floatToHalf(value)) == value);
+	}
+	// 1 + 2^-11 está a medio camino entre 1 y 1 + 2^-10: gana el par (1).
+	CHECK(VertexCodec::floatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3C00u);
+	// 1 + 3 * 2^-11 está a medio camino entre 1 + 2^-10 y 1 + 2^-9: gana el par (1 + 2^-9).
+	CHECK(VertexCodec::floatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 0x3C02u);
+	CHECK(VertexCodec::floatToHalf(1.0e6f) == 0x7C00u);
+	CHECK(VertexCodec::floatToHalf(-std::numeric_limits<float>::infinity()) == 0xFC00u);
+	CHECK(VertexCodec::floatToHalf(std::ldexp(1.0f, -26)) == 0u);
+	// NaN sigue siendo NaN (por bits: con /fp:fast nan != nan no es fiable).
+	const uint16_t nan = VertexCodec::floatToHalf(std::numeric_limits<float>::quiet_NaN());
+	CHECK((nan & 0x7C00u) == 0x7C00u && (nan & 0x03FFu) != 0);
+}
+
+TEST_CASE(VertexCodec_Snorm16SaturatesAndRoundTrips) {
+	CHECK(VertexCodec::encodeSnorm16(1.0f) == 32767);
+	CHECK(VertexCodec::encodeSnorm16(-1.0f) == -32767);
+	CHECK(VertexCodec::encodeSnorm16(2.0f) == 32767);
+	CHECK(VertexCodec::encodeSnorm16(-5.0f) == -32767);
+	CHECK(VertexCodec::encodeSnorm16(0.0f) == 0);
+	CHECK(VertexCodec::decodeSnorm16(-32768) == -1.0f);
+	for (int i = -100; i <= 100; ++i) {
+		const float value = i / 100.0f;
+		CHECK(std::fabs(VertexCodec::decodeSnorm16(VertexCodec::encodeSnorm16(value)) - value) <= 0.5f / 32767.0f + 1e-7f);
+	}
+}
+
+TEST_CASE(VertexCodec_IndexFormatFitsVertexCount) {
+	CHECK(VertexCodec::chooseIndexFormat(3) == INDEX_UINT16);
+	CHECK(VertexCodec::chooseIndexFormat(0x10000) == INDEX_UINT16);
+	CHECK(VertexCodec::chooseIndexFormat(0x10001) == INDEX_UINT32);
+	CHECK(VertexCodec::getIndexSize(INDEX_UINT16) == 2);
+	CHECK(VertexCodec::getIndexSize(INDEX_UINT32) == 4);
+
+	const std::vector<unsigned int> small = { 0, 1, 0xFFFF };
+	std::vector<unsigned char> bytes;
+	REQUIRE(VertexCodec::encodeIndices(small, INDEX_UINT16, bytes));
+	REQUIRE(bytes.size() == small.size() * sizeof(uint16_t));
+	uint16_t decoded[3];
+	std::memcpy(decoded, bytes.data(), sizeof(decoded));
+	CHECK(decoded[0] == 0 && decoded[1] == 1 && decoded[2] == 0xFFFF);
+
+	const std::vector<unsigned int> large = { 0, 0x10000 };
+	CHECK(!VertexCodec::encodeIndices(large, INDEX_UINT16, bytes));
+	CHECK(VertexCodec::encodeIndices(large, INDEX_UINT32, bytes) && bytes.size() == large.size() * sizeof(uint32_t));
+}
+
+TEST_CASE(VertexCodec_CompactLayoutRoundTripsWithinBounds) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(32, vertices, indices);
+	// Fuera del origen, con escala distinta por eje y UV repetidas.
+	for (SimpleVertex& vertex : vertices) {
+		vertex.Pos = XMFLOAT3(vertex.Pos.x * 3.0f - 40.0f, vertex.Pos.x * 0.1f + 7.0f, vertex.Pos.z * 0.5f + 100.0f);
+		vertex.Tex = XMFLOAT2(vertex.Tex.x * 8.0f, -vertex.Tex.y * 3.0f);
+	}
+
+	const VertexLayout layout = VertexCodec::computeCompactLayout(vertices);
+	CHECK(layout.isCompact());
+	CHECK(layout.getStride() == 12);
+	VertexRoundTripError error;
+	CHECK(VertexCodec::verifyRoundTrip(vertices, layout, &error));
+	CHECK(error.position > 0.0f);
+	CHECK(error.position <= error.positionBound);
+	CHECK(error.texCoord <= error.texCoordBound);
+
+	// El layout float no pierde nada.
+	CHECK(VertexCodec::verifyRoundTrip(vertices, VertexLayout(), &error));
+	CHECK(error.position == 0.0f && error.texCoord == 0.0f);
+	CHECK(VertexLayout().getStride() == sizeof(SimpleVertex));
+}
+
+TEST_CASE(VertexCodec_RoundTripRejectsLayoutThatClips) {
+	std::vector<SimpleVertex> vertices;
+	std::vector<unsigned int> indices;
+	MakeGrid(8, vertices, indices);
+	VertexLayout layout = VertexCodec::computeCompactLayout(vertices);
+	// Una caja más pequeña que la malla satura los extremos.
+	layout.boundsExtent.x *= 0.5f;
+	VertexRoundTripError error;
+	CHECK(!VertexCodec::verifyRoundTrip(vertices, layout, &error));
+	CHECK(error.position > error.positionBound);
+}
+
+TEST_CASE(VertexCodec_SelectFormatsPicksCompactAnd16BitIndices) {
+	MeshComponent mesh;
+	mesh.m_name = "Grid";
+	MakeGrid(16, mesh.m_vertex, mesh.m_index);
+	CHECK(VertexCodec::selectFormats(mesh, true));
+	CHECK(mesh.m_indexFormat == INDEX_UINT16);
+	CHECK(mesh.m_vertexLayout.isCompact());
+
+	CHECK(!VertexCodec::selectFormats(mesh, false));
+	CHECK(!mesh.m_vertexLayout.isCompact());
+}